@@ -458,6 +458,9 @@ endif
 ifeq ($(CONFIG_COMPRESS_RAMSTAGE_LZ4),y)
 CBFS_COMPRESS_FLAG:=LZ4
 endif
+ifeq ($(CONFIG_COMPRESS_RAMSTAGE_ZSTD),y)
+CBFS_COMPRESS_FLAG:=ZSTD
+endif
 
 CBFS_PAYLOAD_COMPRESS_FLAG:=none
 ifeq ($(CONFIG_COMPRESSED_PAYLOAD_LZMA),y)
@@ -466,6 +469,9 @@ endif
 ifeq ($(CONFIG_COMPRESSED_PAYLOAD_LZ4),y)
 CBFS_PAYLOAD_COMPRESS_FLAG:=LZ4
 endif
+ifeq ($(CONFIG_COMPRESSED_PAYLOAD_ZSTD),y)
+CBFS_PAYLOAD_COMPRESS_FLAG:=ZSTD
+endif
 
 CBFS_SECONDARY_PAYLOAD_COMPRESS_FLAG:=none
 ifeq ($(CONFIG_COMPRESS_SECONDARY_PAYLOAD),y)
@@ -474,8 +480,14 @@ endif
 
 CBFS_PRERAM_COMPRESS_FLAG:=none
 ifeq ($(CONFIG_COMPRESS_PRERAM_STAGES),y)
+ifeq ($(CONFIG_COMPRESS_PRERAM_STAGES_LZMA),y)
+CBFS_PRERAM_COMPRESS_FLAG:=LZMA
+else ifeq ($(CONFIG_COMPRESS_PRERAM_STAGES_ZSTD),y)
+CBFS_PRERAM_COMPRESS_FLAG:=ZSTD
+else
 CBFS_PRERAM_COMPRESS_FLAG:=LZ4
 endif
+endif
 
 ifneq ($(CONFIG_LOCALVERSION),"")
 COREBOOT_EXTRA_VERSION := -$(call strip_quotes,$(CONFIG_LOCALVERSION))
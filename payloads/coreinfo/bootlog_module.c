@@ -7,12 +7,22 @@
 #define LINES_SHOWN 19
 #define TAB_WIDTH 2
 
+/*
+ * The console is not copied or expanded for display. Instead, the offset of
+ * the first character of every screen row is looked up once, and only the
+ * rows that are visible get rendered.
+ */
+
 /* Globals that are used for tracking screen state */
-static char *g_buf = NULL;
+static u32 *g_rows = NULL;
 static s32 g_line = 0;
 static s32 g_lines_count = 0;
 static s32 g_max_cursor_line = 0;
 
+/* The log in order: the rest of the ring buffer after a wrap, then its start */
+static const char *g_log[2];
+static u32 g_log_len[2];
+
 /* Copied from libpayload/drivers/cbmem_console.c */
 struct cbmem_console {
 	u32 size;
@@ -23,68 +33,69 @@ struct cbmem_console {
 #define CURSOR_MASK ((1 << 28) - 1)
 #define OVERFLOW (1 << 31)
 
-static u32 char_width(char c, u32 cursor, u32 screen_width)
+static char log_char(u32 offset)
 {
-	if (c == '\n') {
-		return screen_width - (cursor % screen_width);
-	} else if (c == '\t') {
-		return TAB_WIDTH;
-	} else if (isprint(c)) {
-		return 1;
+	if (offset < g_log_len[0]) {
+		return g_log[0][offset];
 	}
 
-	return 0;
+	return g_log[1][offset - g_log_len[0]];
 }
 
-static u32 calculate_chars_count(char *str, u32 str_len, u32 screen_width, u32 screen_height)
+/* Width of a character other than '\n' on screen */
+static u32 char_width(char c)
 {
-	u32 i, count = 0;
-
-	for (i = 0; i < str_len; i++) {
-		count += char_width(str[i], count, screen_width);
-	}
-
-	/* Ensure that 'count' can occupy at least the whole screen */
-	if (count < screen_width * screen_height) {
-		count = screen_width * screen_height;
-	}
-
-	/* Pad to line end */
-	if (count % screen_width != 0) {
-		count += screen_width - (count % screen_width);
+	if (c == '\t') {
+		return TAB_WIDTH;
+	} else if (isprint(c)) {
+		return 1;
 	}
 
-	return count;
+	return 0;
 }
 
 /*
- * This method takes an input buffer and sanitizes it for display, which means:
- *  - '\n' is converted to spaces until end of line
- *  - Tabs are converted to spaces of size TAB_WIDTH
- *  - Only printable characters are preserved
+ * Split the log into screen rows, which end at a '\n' or when they are full.
+ * Store the offset of the first character of each row in 'rows', unless it is
+ * NULL, and return the number of rows.
  */
-static int sanitize_buffer_for_display(char *str, u32 str_len, char *out, u32 out_len, u32 screen_width)
+static u32 index_rows(u32 *rows)
 {
-	u32 cursor = 0;
-	u32 i;
+	const u32 len = g_log_len[0] + g_log_len[1];
+	u32 i, col = 0, count = 0;
 
-	for (i = 0; i < str_len && cursor < out_len; i++) {
-		u32 width = char_width(str[i], cursor, screen_width);
-		if (width == 1) {
-			out[cursor++] = str[i];
-		} else if (width > 1) {
-			while (width-- && cursor < out_len) {
-				out[cursor++] = ' ';
+	if (rows) {
+		rows[0] = 0;
+	}
+	count++;
+
+	for (i = 0; i < len; i++) {
+		char c = log_char(i);
+		u32 width;
+
+		if (c == '\n') {
+			if (i + 1 < len) {
+				if (rows) {
+					rows[count] = i + 1;
+				}
+				count++;
 			}
+			col = 0;
+			continue;
 		}
-	}
 
-	/* Fill the rest of the out buffer with spaces */
-	while (cursor < out_len) {
-		out[cursor++] = ' ';
+		width = char_width(c);
+		if (col + width > SCREEN_X) {
+			if (rows) {
+				rows[count] = i;
+			}
+			count++;
+			col = 0;
+		}
+		col += width;
 	}
 
-	return 0;
+	return count;
 }
 
 static int bootlog_module_init(void)
@@ -109,66 +120,61 @@ static int bootlog_module_init(void)
 		cursor = size - 1;
 	}
 
-	/* Calculate how much characters will be displayed on screen */
-	u32 chars_count = calculate_chars_count(buffer, cursor, SCREEN_X, LINES_SHOWN);
-	u32 overflow_chars_count = 0;
 	if (console->cursor & OVERFLOW) {
-		overflow_chars_count = calculate_chars_count(buffer + cursor,
-			size - cursor, SCREEN_X, LINES_SHOWN);
+		g_log[0] = buffer + cursor;
+		g_log_len[0] = size - cursor;
 	}
+	g_log[1] = buffer;
+	g_log_len[1] = cursor;
 
-	/* Sanity check, chars_count must be padded to full line */
-	if (chars_count % SCREEN_X || overflow_chars_count % SCREEN_X) {
-		return -2;
-	}
-
-	g_lines_count = (chars_count + overflow_chars_count) / SCREEN_X;
-	g_max_cursor_line = MAX(g_lines_count - 1 - LINES_SHOWN, 0);
+	g_lines_count = index_rows(NULL);
+	g_max_cursor_line = MAX(g_lines_count - LINES_SHOWN, 0);
 
-	g_buf = malloc(chars_count);
-	if (!g_buf) {
+	g_rows = malloc(g_lines_count * sizeof(*g_rows));
+	if (!g_rows) {
 		return -3;
 	}
 
-	if (console->cursor & OVERFLOW) {
-		if (sanitize_buffer_for_display(buffer + cursor, size - cursor,
-				g_buf, overflow_chars_count, SCREEN_X) < 0) {
-			goto err_free;
-		}
-	}
-	if (sanitize_buffer_for_display(buffer, cursor,
-					g_buf + overflow_chars_count,
-					chars_count, SCREEN_X) < 0) {
-		goto err_free;
-	}
-
-	/* TODO: Maybe a _cleanup hook where we call free()? */
+	index_rows(g_rows);
 
 	return 0;
+}
+
+static void draw_row(WINDOW *win, int y, s32 row)
+{
+	const u32 end = row + 1 < g_lines_count ? g_rows[row + 1] :
+			g_log_len[0] + g_log_len[1];
+	char line[SCREEN_X];
+	u32 i, width, len = 0;
+
+	for (i = g_rows[row]; i < end; i++) {
+		char c = log_char(i);
+
+		width = char_width(c);
+		if (width == 1) {
+			line[len++] = c;
+		} else {
+			while (width-- && len < SCREEN_X) {
+				line[len++] = ' ';
+			}
+		}
+	}
 
-err_free:
-	free(g_buf);
-	g_buf = NULL;
-	return -4;
+	mvwaddnstr(win, y, 0, line, len);
 }
 
 static int bootlog_module_redraw(WINDOW *win)
 {
 	print_module_title(win, "coreboot Bootlog");
 
-	if (!g_buf) {
+	if (!g_rows) {
 		return -1;
 	}
 
-	int x = 0, y = 0;
-	char *tmp = g_buf + g_line * SCREEN_X;
-
-	for (y = 0; y < LINES_SHOWN; y++) {
-		for (x = 0; x < SCREEN_X; x++) {
-			mvwaddch(win, y + 2, x, *tmp);
-			tmp++;
-		}
+	s32 row;
 
+	for (row = g_line; row < g_lines_count && row < g_line + LINES_SHOWN; row++) {
+		draw_row(win, row - g_line + 2, row);
 	}
 
 	return 0;
@@ -176,31 +182,38 @@ static int bootlog_module_redraw(WINDOW *win)
 
 static int bootlog_module_handle(int key)
 {
-	if (!g_buf) {
+	s32 line = g_line;
+
+	if (!g_rows) {
 		return 0;
 	}
 
 	switch (key) {
 	case KEY_DOWN:
-		g_line++;
+		line++;
 		break;
 	case KEY_UP:
-		g_line--;
+		line--;
 		break;
 	case KEY_NPAGE: /* Page up */
-		g_line -= LINES_SHOWN;
+		line -= LINES_SHOWN;
 		break;
 	case KEY_PPAGE: /* Page down */
-		g_line += LINES_SHOWN;
+		line += LINES_SHOWN;
 		break;
 	}
 
-	if (g_line < 0)
-		g_line = 0;
+	if (line < 0)
+		line = 0;
+
+	if (line > g_max_cursor_line)
+		line = g_max_cursor_line;
 
-	if (g_line > g_max_cursor_line)
-		g_line = g_max_cursor_line;
+	/* Nothing to redraw if the view did not move */
+	if (line == g_line)
+		return 0;
 
+	g_line = line;
 	return 1;
 }
 
@@ -151,55 +151,22 @@ static int pci_module_redraw(WINDOW *win)
 	return 0;
 }
 
-static void ci_pci_scan_bus(int bus)
+static void ci_pci_scan_bus(void)
 {
-	int slot, func;
-	unsigned int val;
-	unsigned char hdr;
+	const struct pci_dev *dev;
 
-	for (slot = 0; slot < 0x20; slot++) {
-		for (func = 0; func < 8; func++) {
-			pcidev_t dev = PCI_DEV(bus, slot, func);
+	/* libpayload already scans the buses on x86, see lib_get_sysinfo(). */
+	if (!lib_sysinfo.pacc.devices)
+		pci_scan_bus(&lib_sysinfo.pacc);
 
-			val = pci_read_config32(dev, REG_VENDOR_ID);
+	for (dev = lib_sysinfo.pacc.devices; dev; dev = dev->next) {
+		/* FIXME: Remove this arbitrary limitation. */
+		if (devices_index >= MAX_PCI_DEVICES)
+			break;
 
-			/* Nobody home. */
-			if (val == 0xffffffff || val == 0x00000000 ||
-			    val == 0x0000ffff || val == 0xffff0000) {
-
-				/* If function 0 is not present, no need
-				 * to test other functions. */
-				if (func == 0)
-					func = 8;
-				continue;
-			}
-
-			/* FIXME: Remove this arbitrary limitation. */
-			if (devices_index >= MAX_PCI_DEVICES)
-				return;
-
-			devices[devices_index].device =
-			    PCI_DEV(bus, slot, func);
-
-			devices[devices_index++].id = val;
-
-			/* If this is a bridge, then follow it. */
-			hdr = pci_read_config8(dev, REG_HEADER_TYPE);
-
-			if ((func == 0) && !(hdr & HEADER_TYPE_MULTIFUNCTION))
-				func = 8;
-
-			hdr &= ~HEADER_TYPE_MULTIFUNCTION;
-			if (hdr == HEADER_TYPE_BRIDGE ||
-			    hdr == HEADER_TYPE_CARDBUS) {
-				unsigned int busses;
-
-				busses = pci_read_config32(dev, REG_PRIMARY_BUS);
-
-				ci_pci_scan_bus((busses >> 8) & 0xff);
-
-			}
-		}
+		devices[devices_index].device = PCI_DEV(dev->bus, dev->dev, dev->func);
+		devices[devices_index++].id = (unsigned int)dev->device_id << 16 |
+					      dev->vendor_id;
 	}
 
 	quicksort(devices, devices_index);
@@ -240,7 +207,7 @@ static int pci_module_handle(int key)
 
 static int pci_module_init(void)
 {
-	ci_pci_scan_bus(0);
+	ci_pci_scan_bus();
 	return 0;
 }
 
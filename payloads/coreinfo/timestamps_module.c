@@ -6,10 +6,21 @@
 #if CONFIG(MODULE_TIMESTAMPS)
 
 #define LINES_SHOWN 19
-#define TAB_WIDTH 2
+
+/*
+ * Rows are formatted from the timestamp table when they become visible, so
+ * nothing but the total time has to be computed up front.
+ *
+ * Row 0 has the number of entries, row 2 the base time and the entries start
+ * at row 3. The total time is in the last row, after an empty one.
+ */
+#define FIRST_ENTRY_ROW 3
+#define FOOTER_ROWS 2
 
 /* Globals that are used for tracking screen state */
-static char *g_buf;
+static const struct timestamp_table *g_timestamps;
+static s32 g_n_entries;
+static uint64_t g_total_time;
 static s32 g_line;
 static s32 g_lines_count;
 static s32 g_max_cursor_line;
@@ -47,86 +58,28 @@ static u64 arch_convert_raw_ts_entry(u64 ts)
 	return ts / tick_freq_mhz;
 }
 
-static u32 char_width(char c, u32 cursor, u32 screen_width)
-{
-	if (c == '\n')
-		return screen_width - (cursor % screen_width);
-	else if (c == '\t')
-		return TAB_WIDTH;
-	else if (isprint(c))
-		return 1;
-
-	return 0;
-}
-
-static u32 calculate_chars_count(char *str, u32 str_len, u32 screen_width,
-		u32 screen_height)
-{
-	u32 i, count = 0;
-
-	for (i = 0; i < str_len; i++)
-		count += char_width(str[i], count, screen_width);
-
-	/* Ensure that 'count' can occupy at least the whole screen */
-	if (count < screen_width * screen_height)
-		count = screen_width * screen_height;
-
-	/* Pad to line end */
-	if (count % screen_width != 0)
-		count += screen_width - (count % screen_width);
-
-	return count;
-}
-
-/*
- * This method takes an input buffer and sanitizes it for display, which means:
- *  - '\n' is converted to spaces until end of line
- *  - Tabs are converted to spaces of size TAB_WIDTH
- *  - Only printable characters are preserved
- */
-static int sanitize_buffer_for_display(char *str, u32 str_len, char *out,
-		u32 out_len, u32 screen_width)
+/* Absolute stamp of entry 'i', or the base time for -1 */
+static uint64_t timestamp_stamp(s32 i)
 {
-	u32 cursor = 0;
-	u32 i;
-
-	for (i = 0; i < str_len && cursor < out_len; i++) {
-		u32 width = char_width(str[i], cursor, screen_width);
+	if (i < 0)
+		return g_timestamps->base_time;
 
-		if (width == 1)
-			out[cursor++] = str[i];
-		else if (width > 1)
-			while (width-- && cursor < out_len)
-				out[cursor++] = ' ';
-	}
-
-	/* Fill the rest of the out buffer with spaces */
-	while (cursor < out_len)
-		out[cursor++] = ' ';
-
-	return 0;
+	return g_timestamps->entries[i].entry_stamp + g_timestamps->base_time;
 }
 
-static uint64_t timestamp_print_entry(char *buffer, size_t size, uint32_t *cur,
-		uint32_t id, uint64_t stamp, uint64_t prev_stamp)
+static void timestamp_print_entry(char *buffer, size_t size, uint32_t id,
+		uint64_t stamp, uint64_t prev_stamp)
 {
 	const char *name;
-	uint64_t step_time;
+	int cur;
 
 	name = timestamp_name(id);
-	step_time = arch_convert_raw_ts_entry(stamp - prev_stamp);
 
-	*cur += snprintf(buffer + *cur, size, "%4d: %-45s", id, name);
-	*cur += snprintf(buffer + *cur, size, "%llu",
+	cur = snprintf(buffer, size, "%4d: %-45s%llu", id, name,
 			arch_convert_raw_ts_entry(stamp));
-	if (prev_stamp) {
-		*cur += snprintf(buffer + *cur, size, " (");
-		*cur += snprintf(buffer + *cur, size, "%llu", step_time);
-		*cur += snprintf(buffer + *cur, size, ")");
-	}
-	*cur += snprintf(buffer + *cur, size, "\n");
-
-	return step_time;
+	if (prev_stamp && cur >= 0 && (size_t)cur < size)
+		snprintf(buffer + cur, size - cur, " (%llu)",
+			arch_convert_raw_ts_entry(stamp - prev_stamp));
 }
 
 static int timestamps_module_init(void)
@@ -142,96 +95,54 @@ static int timestamps_module_init(void)
 	if (timestamps == NULL)
 		return -1;
 
-	/* Extract timestamps information */
-	u64 base_time = timestamps->base_time;
-	u16 max_entries = timestamps->max_entries;
-	u32 n_entries = timestamps->num_entries;
-
 	timestamp_set_tick_freq(timestamps->tick_freq_mhz);
 
-	char *buffer;
-	u32 buff_cur = 0;
-	uint64_t prev_stamp;
-	uint64_t total_time;
-
-	/* Allocate a buffer big enough to contain all of the possible
-	 * entries plus the other information (number entries, total time). */
-	buffer = malloc((max_entries + 4) * SCREEN_X * sizeof(char));
-
-	if (buffer == NULL)
-		return -3;
-
-	/* Write the content */
-	buff_cur += snprintf(buffer, SCREEN_X, "%d entries total:\n\n",
-			n_entries);
-
-	prev_stamp = 0;
-	timestamp_print_entry(buffer, SCREEN_X, &buff_cur, 0, base_time,
-			prev_stamp);
-	prev_stamp = base_time;
-
-	total_time = 0;
-	for (u32 i = 0; i < n_entries; i++) {
-		uint64_t stamp;
-		const struct timestamp_entry *tse = &timestamps->entries[i];
+	g_timestamps = timestamps;
+	g_n_entries = MIN(timestamps->num_entries, timestamps->max_entries);
 
-		stamp = tse->entry_stamp + base_time;
-		total_time += timestamp_print_entry(buffer, SCREEN_X,
-				&buff_cur, tse->entry_id, stamp, prev_stamp);
-		prev_stamp = stamp;
-	}
-
-	buff_cur += snprintf(buffer + buff_cur, SCREEN_X, "\nTotal Time: ");
-	buff_cur += snprintf(buffer + buff_cur, SCREEN_X, "%llu", total_time);
-	buff_cur += snprintf(buffer + buff_cur, SCREEN_X, "\n");
-
-	/* Calculate how many characters will be displayed on screen */
-	u32 chars_count = calculate_chars_count(buffer, buff_cur + 1,
-			SCREEN_X, LINES_SHOWN);
+	/* The total time is the sum of the rounded steps, as they are shown. */
+	g_total_time = 0;
+	for (s32 i = 0; i < g_n_entries; i++)
+		g_total_time += arch_convert_raw_ts_entry(timestamp_stamp(i) -
+				timestamp_stamp(i - 1));
 
-	/* Sanity check, chars_count must be padded to full line */
-	if (chars_count % SCREEN_X != 0) {
-		free(buffer);
-		return -2;
-	}
-
-	g_lines_count = chars_count / SCREEN_X;
-	g_max_cursor_line = MAX(g_lines_count - 1 - LINES_SHOWN, 0);
+	g_lines_count = FIRST_ENTRY_ROW + g_n_entries + FOOTER_ROWS;
+	g_max_cursor_line = MAX(g_lines_count - LINES_SHOWN, 0);
 
-	g_buf = malloc(chars_count);
-	if (!g_buf) {
-		free(buffer);
-		return -3;
-	}
+	return 0;
+}
 
-	if (sanitize_buffer_for_display(buffer, buff_cur + 1, g_buf,
-				chars_count, SCREEN_X) < 0) {
-		free(buffer);
-		free(g_buf);
-		g_buf = NULL;
-		return -4;
+static void timestamps_format_row(char *buffer, size_t size, s32 row)
+{
+	const s32 entry = row - FIRST_ENTRY_ROW;
+
+	buffer[0] = '\0';
+
+	if (row == 0) {
+		snprintf(buffer, size, "%d entries total:", g_n_entries);
+	} else if (row == FIRST_ENTRY_ROW - 1) {
+		timestamp_print_entry(buffer, size, 0, timestamp_stamp(-1), 0);
+	} else if (entry >= 0 && entry < g_n_entries) {
+		timestamp_print_entry(buffer, size,
+				g_timestamps->entries[entry].entry_id,
+				timestamp_stamp(entry), timestamp_stamp(entry - 1));
+	} else if (row == g_lines_count - 1) {
+		snprintf(buffer, size, "Total Time: %llu", g_total_time);
 	}
-
-	free(buffer);
-
-	return 0;
 }
 
 static int timestamps_module_redraw(WINDOW *win)
 {
+	char line[SCREEN_X + 1];
+
 	print_module_title(win, "coreboot Timestamps");
 
-	if (!g_buf)
+	if (!g_timestamps)
 		return -1;
 
-	int x = 0, y = 0;
-	char *tmp = g_buf + g_line * SCREEN_X;
-
-	for (y = 0; y < LINES_SHOWN; y++) {
-		for (x = 0; x < SCREEN_X; x++) {
-			mvwaddch(win, y + 2, x, *tmp);
-			tmp++;
-		}
+	for (s32 row = g_line; row < g_lines_count && row < g_line + LINES_SHOWN; row++) {
+		timestamps_format_row(line, sizeof(line), row);
+		mvwaddstr(win, row - g_line + 2, 0, line);
 	}
 
 	return 0;
@@ -239,30 +150,37 @@ static int timestamps_module_redraw(WINDOW *win)
 
 static int timestamps_module_handle(int key)
 {
-	if (!g_buf)
+	s32 line = g_line;
+
+	if (!g_timestamps)
 		return 0;
 
 	switch (key) {
 	case KEY_DOWN:
-		g_line++;
+		line++;
 		break;
 	case KEY_UP:
-		g_line--;
+		line--;
 		break;
 	case KEY_NPAGE: /* Page up */
-		g_line -= LINES_SHOWN;
+		line -= LINES_SHOWN;
 		break;
 	case KEY_PPAGE: /* Page down */
-		g_line += LINES_SHOWN;
+		line += LINES_SHOWN;
 		break;
 	}
 
-	if (g_line < 0)
-		g_line = 0;
+	if (line < 0)
+		line = 0;
 
-	if (g_line > g_max_cursor_line)
-		g_line = g_max_cursor_line;
+	if (line > g_max_cursor_line)
+		line = g_max_cursor_line;
+
+	/* Nothing to redraw if the view did not move */
+	if (line == g_line)
+		return 0;
 
+	g_line = line;
 	return 1;
 }
 
@@ -38,6 +38,7 @@ libc-y += exception_asm.S exception.c
 libc-y += cache.c cpu.S
 libc-y += selfboot.c
 libc-y += mmu.c
+libc-$(CONFIG_LP_COROUTINES) += coroutine.S
 
 libgdb-y += gdb.c
 
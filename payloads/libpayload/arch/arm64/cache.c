@@ -31,6 +31,7 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <arch/cache.h>
 #include <arch/lib_helpers.h>
@@ -116,6 +117,40 @@ void dcache_invalidate_by_mva(void const *addr, size_t len)
 	dcache_op_va(addr, len, OP_DCIVAC);
 }
 
+#if CONFIG(LP_DMA_CACHED)
+int dma_map_cached(void *buf, size_t len, int from_device)
+{
+	const uintptr_t mask = dcache_line_bytes() - 1;
+
+	/* Same address limit as the DMA heap */
+	if ((uintptr_t)buf + len > ((uint64_t)CONFIG_LP_DMA_LIM_EXCL << 20))
+		return 0;
+
+	if (from_device) {
+		/*
+		 * A line shared with other data could be written back while
+		 * the transfer runs and overwrite what the device wrote.
+		 */
+		if (((uintptr_t)buf | len) & mask)
+			return 0;
+		dcache_invalidate_by_mva(buf, len);
+	} else {
+		dcache_clean_by_mva(buf, len);
+	}
+
+	/* Complete the maintenance before the device is started. */
+	dsb();
+	return 1;
+}
+
+void dma_unmap_cached(void *buf, size_t len, int from_device)
+{
+	/* Drop lines that were fetched speculatively during the transfer. */
+	if (from_device)
+		dcache_invalidate_by_mva(buf, len);
+}
+#endif
+
 void cache_sync_instructions(void)
 {
 	uint32_t sctlr = raw_read_sctlr_el2();
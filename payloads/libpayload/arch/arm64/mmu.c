@@ -555,18 +555,19 @@ static struct mmu_memrange *mmu_alloc_range(struct mmu_ranges *mmu_ranges,
  * Desc: Add a memrange for dma operations. This is special because we want to
  * initialize this memory as non-cacheable. We have a constraint that the DMA
  * buffer should be below 4GiB(32-bit only). So, we lookup a TYPE_NORMAL_MEM
- * from the lowest available addresses and align it to page size i.e. 64KiB.
+ * from the lowest available addresses and align it to the L2 block size, so that
+ * neither the DMA range nor the RAM around it have to be mapped with pages.
  */
 static struct mmu_memrange *mmu_add_dma_range(struct mmu_ranges *mmu_ranges)
 {
 	struct mmu_new_range_prop prop;
 
 	prop.type = TYPE_DMA_MEM;
-	/* DMA_DEFAULT_SIZE is multiple of GRANULE_SIZE */
-	assert((DMA_DEFAULT_SIZE % GRANULE_SIZE) == 0);
+	/* DMA_DEFAULT_SIZE is multiple of L2_XLAT_SIZE */
+	assert((DMA_DEFAULT_SIZE % L2_XLAT_SIZE) == 0);
 	prop.size = DMA_DEFAULT_SIZE;
 	prop.lim_excl = (uint64_t)CONFIG_LP_DMA_LIM_EXCL * MiB;
-	prop.align = GRANULE_SIZE;
+	prop.align = L2_XLAT_SIZE;
 	prop.is_valid_range = NULL;
 	prop.src_type = TYPE_NORMAL_MEM;
 
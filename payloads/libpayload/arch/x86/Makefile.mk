@@ -48,6 +48,11 @@ libc-$(CONFIG_LP_ARCH_X86_32) += exec.S
 libc-$(CONFIG_LP_ARCH_X86_32) += exception_asm.S
 libc-$(CONFIG_LP_ARCH_X86_64) += exception_asm_64.S
 
+ifeq ($(CONFIG_LP_COROUTINES),y)
+libc-$(CONFIG_LP_ARCH_X86_32) += coroutine.S
+libc-$(CONFIG_LP_ARCH_X86_64) += coroutine_64.S
+endif
+
 # Will fall back to default_memXXX() in libc/memory.c if GPL not allowed.
 libc-$(CONFIG_LP_GPL) += string.c
 
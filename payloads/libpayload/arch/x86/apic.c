@@ -37,6 +37,7 @@
 
 #define CPUID_XAPIC_ENABLED_BIT		(1 << 9)
 #define CPUID_XAPIC2_ENABLED_BIT	(1 << 21)
+#define CPUID_TSC_DEADLINE_BIT		(1 << 24)
 
 #define XAPIC_ENABLED_BIT		(1 << 11)
 #define X2APIC_ENABLED_BIT		(1 << 10)
@@ -56,6 +57,7 @@
 #define   APIC_SPURIOUS_VECTOR_MASK	0xFFUL
 #define APIC_SPURIOUS			0x0F0
 #define APIC_LVT_TIMER			0x320
+#define   APIC_LVT_TIMER_TSC_DEADLINE	(2 << 17)
 #define APIC_TIMER_INIT_COUNT		0x380
 #define APIC_TIMER_CUR_COUNT		0x390
 #define APIC_TIMER_DIV_CFG		0x3E0
@@ -64,6 +66,8 @@
 
 #define APIC_LVT_SIZE			0x010
 
+#define IA32_TSC_DEADLINE		0x6E0
+
 #define APIC_TIMER_VECTOR		0x20UL
 #define APIC_SPURIOUS_VECTOR		0xFFUL
 
@@ -72,6 +76,8 @@ static int _apic_initialized;
 // TODO: Build a lookup table to avoid calculating it.
 static uint32_t ticks_per_ms;
 static volatile uint8_t timer_waiting;
+/* The APIC timer fires when the TSC reaches a deadline, no calibration needed. */
+static int tsc_deadline;
 
 enum APIC_CAPABILITY {
 	DISABLED = 0,
@@ -106,12 +112,17 @@ uint8_t apic_id(void)
 
 void apic_start_delay(unsigned int usec)
 {
-	die_if(!ticks_per_ms, "apic_init_timer was not run.");
+	die_if(!ticks_per_ms && !tsc_deadline, "apic_init_timer was not run.");
 	die_if(timer_waiting, "timer already started.");
 	die_if(!interrupts_enabled(), "Interrupts disabled.");
 
+	uint64_t ticks;
+
 	/* The order is important so we don't underflow */
-	uint64_t ticks = usec * ticks_per_ms / USECS_PER_MSEC;
+	if (tsc_deadline)
+		ticks = (uint64_t)usec * timer_hz() / USECS_PER_SEC;
+	else
+		ticks = (uint64_t)usec * ticks_per_ms / USECS_PER_MSEC;
 
 	/* Not enough resolution */
 	if (!ticks)
@@ -123,7 +134,11 @@ void apic_start_delay(unsigned int usec)
 
 	timer_waiting = 1;
 
-	apic_write32(APIC_TIMER_INIT_COUNT, ticks);
+	/* The counter of the one-shot mode is only 32 bits wide, wake up early if needed. */
+	if (tsc_deadline)
+		_wrmsr(IA32_TSC_DEADLINE, timer_raw_value() + ticks);
+	else
+		apic_write32(APIC_TIMER_INIT_COUNT, MIN(ticks, UINT32_MAX));
 	enable_interrupts();
 }
 
@@ -236,10 +251,22 @@ static void apic_set_task_priority(uint8_t priority)
 
 static void apic_init_timer(void)
 {
+	uint32_t eax, ebx, ecx, edx;
+
 	die_if(!apic_bar, "APIC is not initialized");
 
 	apic_write32(APIC_LVT_TIMER, APIC_MASKED_BIT);
 
+	/* The deadline is in TSC ticks, so it only works if those are the timer ticks. */
+	cpuid(1, eax, ebx, ecx, edx);
+	if (CONFIG(LP_TIMER_RDTSC) && (ecx & CPUID_TSC_DEADLINE_BIT)) {
+		tsc_deadline = 1;
+		apic_write32(APIC_LVT_TIMER, APIC_TIMER_VECTOR | APIC_LVT_TIMER_TSC_DEADLINE);
+		/* Order the LVT write before the first write to the deadline MSR. */
+		asm volatile("mfence" ::: "memory");
+		return;
+	}
+
 	/* Divide the clock by 1. */
 	apic_write32(APIC_TIMER_DIV_CFG, 0xB);
 
@@ -42,14 +42,23 @@ void arch_ndelay(uint64_t ns)
 {
 	uint64_t delta = ns * timer_hz() / NSECS_PER_SEC;
 	uint64_t pause_delta = 0;
-	uint64_t apic_us = 0;
 	uint64_t start = timer_raw_value();
 
-	if (ns > APIC_INTERRUPT_LATENCY_NS)
-		apic_us = (ns - APIC_INTERRUPT_LATENCY_NS) / NSECS_PER_USEC;
+	/*
+	 * Sleep in hlt until the end is close. Other interrupts and the limited range of the
+	 * APIC timer can end a sleep early, so go back to sleep until it's time.
+	 */
+	if (CONFIG(LP_ENABLE_APIC) && apic_initialized()) {
+		const uint64_t latency = APIC_INTERRUPT_LATENCY_NS * timer_hz() / NSECS_PER_SEC;
+		uint64_t elapsed, sleep_us;
 
-	if (CONFIG(LP_ENABLE_APIC) && apic_initialized() && apic_us)
-		apic_delay(apic_us);
+		while ((elapsed = timer_raw_value() - start) + latency < delta) {
+			sleep_us = (delta - latency - elapsed) * USECS_PER_SEC / timer_hz();
+			if (!sleep_us)
+				break;
+			apic_delay(MIN(sleep_us, UINT32_MAX));
+		}
+	}
 
 	if (delta > PAUSE_THRESHOLD_TICKS)
 		pause_delta = delta - PAUSE_THRESHOLD_TICKS;
@@ -45,8 +45,12 @@ static int find_on_bus(int bus, unsigned short vid, unsigned short did,
 					REG_VENDOR_ID);
 
 		if (val == 0xffffffff || val == 0x00000000 ||
-		    val == 0x0000ffff || val == 0xffff0000)
+		    val == 0x0000ffff || val == 0xffff0000) {
+			/* Without function 0 there are no other functions. */
+			if (func == 0)
+				devfn |= 7;
 			continue;
+		}
 
 		if (val == ((did << 16) | vid)) {
 			*dev = PCI_DEV(bus, slot, func);
@@ -55,6 +59,8 @@ static int find_on_bus(int bus, unsigned short vid, unsigned short did,
 
 		hdr = pci_read_config8(PCI_DEV(bus, slot, func),
 				       REG_HEADER_TYPE);
+		if (func == 0 && !(hdr & HEADER_TYPE_MULTIFUNCTION))
+			devfn |= 7;
 		hdr &= 0x7F;
 
 		if (hdr == HEADER_TYPE_BRIDGE || hdr == HEADER_TYPE_CARDBUS) {
@@ -77,6 +83,19 @@ static int find_on_bus(int bus, unsigned short vid, unsigned short did,
 
 int pci_find_device(u16 vid, u16 did, pcidev_t * dev)
 {
+	const struct pci_dev *d;
+
+	/* Use the devices lib_get_sysinfo() found instead of scanning again. */
+	if (lib_sysinfo.pacc.devices) {
+		for (d = lib_sysinfo.pacc.devices; d; d = d->next) {
+			if (d->vendor_id == vid && d->device_id == did) {
+				*dev = PCI_DEV(d->bus, d->dev, d->func);
+				return 1;
+			}
+		}
+		return 0;
+	}
+
 	return find_on_bus(0, vid, did, dev);
 }
 
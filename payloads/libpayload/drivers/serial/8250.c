@@ -38,6 +38,16 @@ static struct cb_serial cb_serial;
 static int serial_hardware_is_present = 0;
 static int serial_is_mem_mapped = 0;
 
+/* Bytes the TX FIFO takes once THRE is set, and how many of those are still free. */
+static unsigned int tx_fifo_size = 1;
+static unsigned int tx_fifo_room;
+
+#if CONFIG_LP_SERIAL_TX_BUFFER_SIZE
+/* Output that didn't fit into the TX FIFO yet, drained by serial_poll(). */
+static uint8_t tx_buffer[CONFIG_LP_SERIAL_TX_BUFFER_SIZE];
+static size_t tx_head, tx_count;
+#endif
+
 static uint8_t serial_read_reg(int offset)
 {
 	offset *= cb_serial.regwidth;
@@ -93,6 +103,9 @@ static void serial_hardware_init(int speed, int word_bits,
 	/* Restore the previous value of the divisor.
 	 * And set 8 bits per character */
 	serial_write_reg((reg & ~0x80) | 3, 0x03);
+
+	/* Enable and clear the FIFOs. */
+	serial_write_reg(0x07, 0x02);
 #endif
 }
 #endif
@@ -127,6 +140,12 @@ void serial_init(void)
 #if CONFIG(LP_SERIAL_SET_SPEED)
 	serial_hardware_init(CONFIG_LP_SERIAL_BAUD_RATE, 8, 0, 1);
 #endif
+#if !CONFIG(LP_PL011_SERIAL_CONSOLE)
+	/* The IIR reports enabled FIFOs in bits 7:6, a 16550A has 16 bytes. */
+	if ((serial_read_reg(0x02) & 0xc0) == 0xc0)
+		tx_fifo_size = 16;
+#endif
+	tx_fifo_room = 0;
 	serial_hardware_is_present = 1;
 }
 
@@ -142,22 +161,104 @@ void serial_console_init(void)
 	console_add_output_driver(&consout);
 }
 
-void serial_putchar(unsigned int c)
+/*
+ * Writes a byte if the TX FIFO has room, returns 0 otherwise. THRE only says
+ * that the FIFO is empty, so it is checked once for every tx_fifo_size bytes.
+ */
+static int serial_try_tx(uint8_t c)
 {
-	if (!serial_hardware_is_present)
-		return;
 #if !CONFIG(LP_PL011_SERIAL_CONSOLE)
-	while ((serial_read_reg(0x05) & 0x20) == 0) ;
+	if (!tx_fifo_room) {
+		if ((serial_read_reg(0x05) & 0x20) == 0)
+			return 0;
+		tx_fifo_room = tx_fifo_size;
+	}
+	tx_fifo_room--;
 #endif
 	serial_write_reg(c, 0x00);
+	return 1;
+}
+
+static void serial_tx(uint8_t c)
+{
+	while (!serial_try_tx(c)) ;
+}
+
+#if CONFIG_LP_SERIAL_TX_BUFFER_SIZE
+static void serial_tx_pop(void)
+{
+	const size_t tail = (tx_head + ARRAY_SIZE(tx_buffer) - tx_count) %
+			    ARRAY_SIZE(tx_buffer);
+
+	serial_tx(tx_buffer[tail]);
+	tx_count--;
+}
+
+void serial_poll(void)
+{
+	const size_t tail = (tx_head + ARRAY_SIZE(tx_buffer) - tx_count) %
+			    ARRAY_SIZE(tx_buffer);
+	size_t i;
+
+	if (!serial_hardware_is_present)
+		return;
+
+	for (i = tail; tx_count && serial_try_tx(tx_buffer[i]);
+	     i = (i + 1) % ARRAY_SIZE(tx_buffer))
+		tx_count--;
+}
+
+void serial_flush(void)
+{
+	if (!serial_hardware_is_present)
+		return;
+
+	while (tx_count)
+		serial_tx_pop();
+}
+
+static void serial_queue(uint8_t c)
+{
+	serial_poll();
+	if (!tx_count && serial_try_tx(c))
+		return;
+
+	/* Only wait for the UART when the buffer is full. */
+	if (tx_count == ARRAY_SIZE(tx_buffer))
+		serial_tx_pop();
+	tx_buffer[tx_head] = c;
+	tx_head = (tx_head + 1) % ARRAY_SIZE(tx_buffer);
+	tx_count++;
+}
+#else
+void serial_poll(void)
+{
+}
+
+void serial_flush(void)
+{
+}
+
+static void serial_queue(uint8_t c)
+{
+	serial_tx(c);
+}
+#endif
+
+void serial_putchar(unsigned int c)
+{
+	if (!serial_hardware_is_present)
+		return;
+	serial_queue(c);
 	if (c == '\n')
-		serial_putchar('\r');
+		serial_queue('\r');
 }
 
 int serial_havechar(void)
 {
 	if (!serial_hardware_is_present)
 		return 0;
+	serial_poll();
 	return serial_read_reg(0x05) & 0x01;
 }
 
@@ -154,6 +154,10 @@ static int ahci_dev_init(hba_ctrl_t *const ctrl,
 #if CONFIG(LP_STORAGE_ATA)
 		dev->ata_dev.identify = ahci_identify_device;
 		dev->ata_dev.read_sectors = ahci_ata_read_sectors;
+		if (ctrl->caps & HBA_CAPS_SNCQ) {
+			dev->ata_dev.read_sectors_async = ahci_ata_read_sectors_async;
+			dev->ata_dev.poll_request = ahci_ata_poll_request;
+		}
 		return ata_attach_device(&dev->ata_dev, PORT_TYPE_SATA);
 #endif
 		break;
@@ -96,3 +96,150 @@ ssize_t ahci_ata_read_sectors(ata_dev_t *const ata_dev,
 	else
 		return dev->cmdlist->prd_bytes >> ata_dev->sector_size_shift;
 }
+
+/* One PRD per queued command */
+#define AHCI_NCQ_MAX_SECTORS	(BYTES_PER_PRD >> 9)
+
+static int ahci_ncq_setup(ahci_dev_t *const dev)
+{
+	const unsigned int slots = MIN((unsigned int)HBA_CAPS_DECODE_NCS(dev->ctrl->caps),
+				       dev->ata_dev.ncq_depth);
+
+	/* Slot 0 is used for non-queued commands, tags equal slot numbers. */
+	if (slots < 2)
+		return -1;
+
+	dev->ncq_tables = memalign(128, slots * sizeof(cmdtable_t));
+	if (!dev->ncq_tables) {
+		printf("ahci: Failed to allocate NCQ command tables.\n");
+		return -1;
+	}
+	memset((void *)dev->ncq_tables, '\0', slots * sizeof(cmdtable_t));
+	dev->ncq_slots = slots;
+
+	return 0;
+}
+
+static void ahci_ncq_fail(ahci_dev_t *const dev, const unsigned int slot)
+{
+	struct storage_request *const req = dev->ncq[slot].req;
+
+	req->failed = 1;
+	req->result = MIN(req->result, dev->ncq[slot].off);
+	req->inflight--;
+	dev->ncq[slot].req = NULL;
+}
+
+/** Issue reads of the request on all free slots at once. */
+static void ahci_ncq_submit(ahci_dev_t *const dev,
+			    struct storage_request *const req)
+{
+	unsigned int slot;
+	u32 issue = 0;
+
+	for (slot = 1; slot < dev->ncq_slots &&
+			!req->failed && req->next < req->count; ++slot) {
+		if (dev->ncq[slot].req)
+			continue;
+
+		const size_t off = req->next;
+		size_t count;
+		u8 *const buf = storage_request_take(req, AHCI_NCQ_MAX_SECTORS, &count);
+		if (!buf)
+			break;
+
+		const u64 start = (u64)req->start + off;
+		if (start + count > (1ULL << 48) || ((uintptr_t)buf & 1)) {
+			printf("ahci: Can't queue read of %zu sectors at %p.\n",
+			       count, buf);
+			req->failed = 1;
+			req->result = MIN(req->result, off);
+			break;
+		}
+
+		cmdtable_t *const table = &dev->ncq_tables[slot];
+		memset((void *)table, '\0', sizeof(*table));
+		table->prdt[0].data_base = virt_to_phys(buf);
+		table->prdt[0].flags = PRD_TABLE_BYTES(count << 9);
+
+		table->fis[ 0] = FIS_HOST_TO_DEVICE;
+		table->fis[ 1] = FIS_H2D_CMD;
+		table->fis[ 2] = ATA_READ_FPDMA_QUEUED;
+		table->fis[ 3] = (count >>  0) & 0xff;
+		table->fis[ 4] = (start >>  0) & 0xff;
+		table->fis[ 5] = (start >>  8) & 0xff;
+		table->fis[ 6] = (start >> 16) & 0xff;
+		table->fis[ 7] = FIS_H2D_DEV_LBA;
+		table->fis[ 8] = (start >> 24) & 0xff;
+		table->fis[ 9] = (start >> 32) & 0xff;
+		table->fis[10] = (start >> 40) & 0xff;
+		table->fis[11] = (count >>  8) & 0xff;
+		table->fis[12] = slot << 3;
+
+		memset((void *)&dev->cmdlist[slot], '\0', sizeof(dev->cmdlist[slot]));
+		dev->cmdlist[slot].cmd = CMD_CFL(FIS_H2D_FIS_LEN);
+		dev->cmdlist[slot].prdt_length = 1;
+		dev->cmdlist[slot].cmdtable_base = virt_to_phys(table);
+
+		dev->ncq[slot].req = req;
+		dev->ncq[slot].off = off;
+		req->inflight++;
+		issue |= 1 << slot;
+	}
+
+	if (issue) {
+		dev->port->sata_active = issue;
+		dev->port->cmd_issue = issue;
+	}
+}
+
+/** Retire finished queued commands, they may belong to any request. */
+static void ahci_ncq_reap(ahci_dev_t *const dev)
+{
+	const u32 intr_status = dev->port->intr_status;
+	unsigned int slot;
+
+	if (intr_status & (HBA_PxIS_FATAL | HBA_PxIS_PCS)) {
+		/* The device aborts all queued commands on errors. */
+		printf("ahci: Queued read failed (intr_status == 0x%08x).\n",
+		       intr_status);
+		dev->port->intr_status = intr_status;
+		for (slot = 1; slot < dev->ncq_slots; ++slot) {
+			if (dev->ncq[slot].req)
+				ahci_ncq_fail(dev, slot);
+		}
+		ahci_error_recovery(dev, intr_status);
+		return;
+	}
+
+	const u32 busy = dev->port->sata_active | dev->port->cmd_issue;
+	for (slot = 1; slot < dev->ncq_slots; ++slot) {
+		if (dev->ncq[slot].req && !(busy & (1 << slot))) {
+			dev->ncq[slot].req->inflight--;
+			dev->ncq[slot].req = NULL;
+		}
+	}
+}
+
+int ahci_ata_read_sectors_async(ata_dev_t *const ata_dev,
+				struct storage_request *const req)
+{
+	ahci_dev_t *const dev = (ahci_dev_t *)ata_dev;
+
+	if (!dev->ncq_tables && ahci_ncq_setup(dev))
+		return -1;
+
+	ahci_ncq_submit(dev, req);
+	return 0;
+}
+
+int ahci_ata_poll_request(ata_dev_t *const ata_dev,
+			  struct storage_request *const req)
+{
+	ahci_dev_t *const dev = (ahci_dev_t *)ata_dev;
+
+	ahci_ncq_reap(dev);
+	ahci_ncq_submit(dev, req);
+
+	return !req->inflight && (req->failed || req->next >= req->count);
+}
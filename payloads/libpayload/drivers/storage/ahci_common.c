@@ -158,6 +158,15 @@ ssize_t ahci_cmdslot_exec(ahci_dev_t *const dev)
 	if (!(dev->port->cmd_stat & HBA_PxCMD_CR))
 		return -1;
 
+	/* Non-queued commands have to wait for outstanding NCQ commands. */
+	int ncq_timeout = 50000; /* Time out after 50000 * 100us == 5s. */
+	while (dev->port->sata_active && ncq_timeout--)
+		udelay(100);
+	if (ncq_timeout < 0) {
+		printf("ahci: Timeout waiting for queued commands.\n");
+		return -1;
+	}
+
 	/* Trigger command execution. */
 	dev->port->cmd_issue |= (1 << slotnum);
 
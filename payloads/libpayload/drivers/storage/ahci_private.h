@@ -108,6 +108,7 @@ typedef volatile struct {
 	hba_port_t ports[32];
 } hba_ctrl_t;
 
+#define HBA_CAPS_SNCQ		(1 << 30) /* SNCQ - Supports Native Command Queuing */
 #define HBA_CAPS_SSS		(1 << 27) /* SSS - Supports Staggered Spin-up */
 #define HBA_CAPS_NCS_SHIFT	8	/* NCS - Number of Command Slots */
 #define HBA_CAPS_NCS_MASK	(0x1f << HBA_CAPS_NCS_SHIFT)
@@ -195,6 +196,14 @@ typedef struct {
 	u8 *buf, *user_buf;
 	int write_back;
 	size_t buflen;
+
+	/* NCQ, slot 0 stays reserved for non-queued commands */
+	cmdtable_t *ncq_tables;
+	unsigned int ncq_slots;
+	struct {
+		struct storage_request *req;
+		size_t off;
+	} ncq[32];
 } ahci_dev_t;
 
 /*
@@ -228,4 +237,10 @@ ssize_t ahci_ata_read_sectors(ata_dev_t *const ata_dev,
 		     const lba_t start, size_t count,
 		     u8 *const buf);
 
+int ahci_ata_read_sectors_async(ata_dev_t *const ata_dev,
+		     struct storage_request *const req);
+
+int ahci_ata_poll_request(ata_dev_t *const ata_dev,
+		     struct storage_request *const req);
+
 #endif /* _AHCI_PRIVATE_H */
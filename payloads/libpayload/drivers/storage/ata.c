@@ -142,10 +142,33 @@ static ssize_t ata_write512(storage_dev_t *const dev,
 	return -1;
 }
 
+static int ata_read512_async(storage_dev_t *const _dev,
+			     struct storage_request *const req)
+{
+	ata_dev_t *const dev = (ata_dev_t *)_dev;
+
+	return dev->read_sectors_async(dev, req);
+}
+
+static int ata_poll_request(storage_dev_t *const _dev,
+			    struct storage_request *const req)
+{
+	ata_dev_t *const dev = (ata_dev_t *)_dev;
+
+	return dev->poll_request(dev, req);
+}
+
 void ata_initialize_storage_ops(ata_dev_t *const dev)
 {
 	dev->storage_dev.read_blocks512 = ata_read512;
 	dev->storage_dev.write_blocks512 = ata_write512;
+
+	/* Queued commands take blocks directly, without sector translation. */
+	if (dev->ncq_depth && dev->sector_size == 512 &&
+			dev->read_sectors_async && dev->poll_request) {
+		dev->storage_dev.read_blocks512_async = ata_read512_async;
+		dev->storage_dev.poll_request = ata_poll_request;
+	}
 }
 
 int ata_set_sector_size(ata_dev_t *const dev, u32 sector_size)
@@ -221,6 +244,13 @@ int ata_attach_device(ata_dev_t *const dev, const storage_port_t port_type)
 	dev->read_cmd = ATA_READ_DMA;
 #endif
 
+	/* READ FPDMA QUEUED always takes 48-bit addresses. */
+	if (dev->read_cmd == ATA_READ_DMA_EXT && id[ATA_ID_SATA_CAPS] != 0xffff &&
+			(id[ATA_ID_SATA_CAPS] & (1 << 8))) {
+		dev->ncq_depth = (id[ATA_ID_QUEUE_DEPTH] & 0x1f) + 1;
+		printf("ata: NCQ with queue depth %u.\n", dev->ncq_depth);
+	}
+
 	if (ata_decode_sector_size(dev, id))
 		return -1;
 
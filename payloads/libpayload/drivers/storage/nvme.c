@@ -25,6 +25,21 @@
 #define NVME_SQ_ENTRY_SIZE 64
 #define NVME_CQ_ENTRY_SIZE 16
 
+/* IO queues are bigger, limited by CAP.MQES */
+#define NVME_IO_QUEUE_SIZE 64
+/* Reads that can be in flight at the same time, at most IO queue size - 1 */
+#define NVME_IO_SLOTS 16
+/* Blocks per read command (4MiB), limited by MDTS */
+#define NVME_MAX_XFER_BLOCKS 8192
+
+#define NVME_PRP_ENTRIES (0x1000 / sizeof(uint64_t))
+
+struct nvme_io_slot {
+	struct storage_request *req; // NULL if the slot is free
+	size_t off; // first block of the command within req
+	uint64_t *prp_list;
+};
+
 struct nvme_dev {
 	storage_dev_t storage_dev;
 
@@ -33,11 +48,18 @@ struct nvme_dev {
 	struct {
 		void *base;
 		uint32_t *bell;
-		uint16_t idx; // bool pos 0 or 1
-		uint16_t round; // bool round 0 or 1+0xd
+		uint16_t idx; // current position in the queue
+		uint16_t round; // phase of the last round, completion queues only
+		uint16_t size;
 	} queue[4];
 
-	uint64_t *prp_list;
+	/* Command id of an IO command is the index of its slot */
+	struct nvme_io_slot slot[NVME_IO_SLOTS];
+	unsigned int slots;
+	unsigned int max_blocks;
+	unsigned int prp_pages; // PRP list pages per slot
+
+	uint64_t *prp_list; // backing memory for the PRP lists of all slots
 };
 
 
@@ -70,17 +92,19 @@ static int nvme_cmd(
 
 	void *s_entry = nvme->queue[sq].base + (nvme->queue[sq].idx * NVME_SQ_ENTRY_SIZE);
 	memcpy(s_entry, cmd, NVME_SQ_ENTRY_SIZE);
-	nvme->queue[sq].idx = (nvme->queue[sq].idx + 1) & (NVME_QUEUE_SIZE - 1);
+	if (++nvme->queue[sq].idx == nvme->queue[sq].size)
+		nvme->queue[sq].idx = 0;
 	write32(nvme->queue[sq].bell, nvme->queue[sq].idx);
 
 	struct nvme_c_queue_entry *c_entry = nvme->queue[cq].base +
 		(nvme->queue[cq].idx * NVME_CQ_ENTRY_SIZE);
 	while (((read32(&c_entry->dw[3]) >> 16) & 0x1) == nvme->queue[cq].round)
 		;
-	nvme->queue[cq].idx = (nvme->queue[cq].idx + 1) & (NVME_QUEUE_SIZE - 1);
-	write32(nvme->queue[cq].bell, nvme->queue[cq].idx);
-	if (nvme->queue[cq].idx == 0)
+	if (++nvme->queue[cq].idx == nvme->queue[cq].size) {
+		nvme->queue[cq].idx = 0;
 		nvme->queue[cq].round = (nvme->queue[cq].round + 1) & 1;
+	}
+	write32(nvme->queue[cq].bell, nvme->queue[cq].idx);
 	return c_entry->dw[3] >> 17;
 }
 
@@ -170,67 +194,176 @@ static void nvme_detach_device(struct storage_dev *dev)
 	free(nvme->prp_list);
 }
 
-static int nvme_read(struct nvme_dev *nvme, unsigned char *buffer, uint64_t base, uint16_t count)
+/*
+ * PRP1 points to the start of the buffer, PRP2 to the second page or, if the
+ * transfer spans more than two pages, to a PRP list. The last entry of a full
+ * list page points to the next list page.
+ */
+static void nvme_fill_prps(struct nvme_s_queue_entry *e, uint64_t *list,
+			   unsigned char *buffer, size_t len)
 {
-	if (count == 0 || count > 512)
-		return -1;
+	const unsigned int start_page = (uintptr_t)buffer >> 12;
+	const unsigned int end_page = ((uintptr_t)buffer + len - 1) >> 12;
+	const unsigned int pages = end_page - start_page;
+	uint64_t prp2;
 
-	struct nvme_s_queue_entry e = {
-		.dw[0] = 0x02,
-		.dw[1] = 0x1,
-		.dw[6] = virt_to_phys(buffer),
-		.dw[10] = base,
-		.dw[11] = base >> 32,
-		.dw[12] = count - 1,
-	};
+	e->dw[6] = virt_to_phys(buffer);
+	e->dw[7] = (uint64_t)virt_to_phys(buffer) >> 32;
 
-	const unsigned int start_page = (uintptr_t)buffer >> 12;
-	const unsigned int end_page = ((uintptr_t)buffer + count * 512 - 1) >> 12;
-	if (end_page == start_page) {
+	if (pages == 0) {
 		/* No page crossing, PRP2 is reserved */
-	} else if (end_page == start_page + 1) {
+		return;
+	} else if (pages == 1) {
 		/* Crossing exactly one page boundary, PRP2 is second page */
-		e.dw[8] = virt_to_phys(buffer + 0x1000) & ~0xfff;
+		prp2 = virt_to_phys(buffer + 0x1000) & ~0xfff;
 	} else {
-		/* Use a single page as PRP list, PRP2 points to the list */
-		unsigned int i;
-		for (i = 0; i < end_page - start_page; ++i) {
-			buffer += 0x1000;
-			nvme->prp_list[i] = virt_to_phys(buffer) & ~0xfff;
+		unsigned int page, i = 0;
+
+		prp2 = virt_to_phys(list);
+		for (page = 1; page <= pages; ++page) {
+			if (i == NVME_PRP_ENTRIES - 1 && page < pages) {
+				list[i] = virt_to_phys(list + NVME_PRP_ENTRIES);
+				list += NVME_PRP_ENTRIES;
+				i = 0;
+			}
+			list[i++] = virt_to_phys(buffer + page * 0x1000) & ~0xfff;
 		}
-		e.dw[8] = virt_to_phys(nvme->prp_list);
 	}
 
-	return nvme_cmd(nvme, ios, &e);
+	e->dw[8] = prp2;
+	e->dw[9] = prp2 >> 32;
+}
+
+/* Fill free slots with reads of the request and ring the doorbell once. */
+static void nvme_submit_reads(struct nvme_dev *nvme, struct storage_request *req)
+{
+	unsigned int i, submitted = 0;
+
+	for (i = 0; i < nvme->slots && !req->failed && req->next < req->count; ++i) {
+		struct nvme_io_slot *const slot = &nvme->slot[i];
+		if (slot->req)
+			continue;
+
+		const size_t off = req->next;
+		size_t blocks;
+		unsigned char *const buffer = storage_request_take(req, nvme->max_blocks, &blocks);
+		if (!buffer)
+			break;
+		const uint64_t base = req->start + off;
+
+		struct nvme_s_queue_entry e = {
+			.dw[0] = i << 16 | 0x02,
+			.dw[1] = 0x1,
+			.dw[10] = base,
+			.dw[11] = base >> 32,
+			.dw[12] = blocks - 1,
+		};
+		nvme_fill_prps(&e, slot->prp_list, buffer, blocks * 512);
+
+		void *s_entry = nvme->queue[ios].base + (nvme->queue[ios].idx * NVME_SQ_ENTRY_SIZE);
+		memcpy(s_entry, &e, NVME_SQ_ENTRY_SIZE);
+		if (++nvme->queue[ios].idx == nvme->queue[ios].size)
+			nvme->queue[ios].idx = 0;
+
+		slot->req = req;
+		slot->off = off;
+		req->inflight++;
+		submitted++;
+	}
+
+	if (submitted)
+		write32(nvme->queue[ios].bell, nvme->queue[ios].idx);
+}
+
+/* Retire all IO completions that arrived so far, they may belong to any request. */
+static void nvme_reap_completions(struct nvme_dev *nvme)
+{
+	unsigned int reaped = 0;
+
+	for (;;) {
+		struct nvme_c_queue_entry *c_entry = nvme->queue[ioc].base +
+			(nvme->queue[ioc].idx * NVME_CQ_ENTRY_SIZE);
+		const uint32_t dw3 = read32(&c_entry->dw[3]);
+		if (((dw3 >> 16) & 0x1) == nvme->queue[ioc].round)
+			break;
+
+		if (++nvme->queue[ioc].idx == nvme->queue[ioc].size) {
+			nvme->queue[ioc].idx = 0;
+			nvme->queue[ioc].round = (nvme->queue[ioc].round + 1) & 1;
+		}
+		reaped++;
+
+		const unsigned int cid = dw3 & 0xffff;
+		if (cid >= nvme->slots || !nvme->slot[cid].req) {
+			printf("NVMe ERROR: Completion for unknown command %u.\n", cid);
+			continue;
+		}
+
+		struct nvme_io_slot *const slot = &nvme->slot[cid];
+		struct storage_request *const req = slot->req;
+		if (dw3 >> 17) {
+			printf("NVMe ERROR: Read failed with status 0x%x.\n", dw3 >> 17);
+			req->failed = 1;
+			req->result = MIN(req->result, slot->off);
+		}
+		req->inflight--;
+		slot->req = NULL;
+	}
+
+	if (reaped)
+		write32(nvme->queue[ioc].bell, nvme->queue[ioc].idx);
+}
+
+static int nvme_read_blocks512_async(struct storage_dev *const dev,
+				     struct storage_request *const req)
+{
+	nvme_submit_reads((struct nvme_dev *)dev, req);
+	return 0;
+}
+
+static int nvme_poll_request(struct storage_dev *const dev, struct storage_request *const req)
+{
+	struct nvme_dev *const nvme = (struct nvme_dev *)dev;
+
+	nvme_reap_completions(nvme);
+	nvme_submit_reads(nvme, req);
+
+	return !req->inflight && (req->failed || req->next >= req->count);
 }
 
 static ssize_t nvme_read_blocks512(
 		struct storage_dev *const dev,
 		const lba_t start, const size_t count, unsigned char *const buf)
 {
-	unsigned int off = 0;
-	while (off < count) {
-		const unsigned int blocks = MIN(count - off, 512);
-		if (nvme_read((struct nvme_dev *)dev, buf + (off * 512), start + off, blocks))
-			return off;
-		off += blocks;
-	}
-	return count;
+	const struct storage_sg sg = { .buf = buf, .count = count };
+	struct storage_request req = {
+		.start		= start,
+		.sg		= &sg,
+		.sg_count	= 1,
+	};
+
+	storage_request_init(&req, dev);
+	nvme_read_blocks512_async(dev, &req);
+	while (!nvme_poll_request(dev, &req))
+		;
+	return req.result;
 }
 
 static int create_io_submission_queue(struct nvme_dev *nvme)
 {
-	void *sq_buffer = memalign(0x1000, NVME_SQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	/* Same size as the completion queue, which is created first */
+	const uint16_t size = nvme->queue[ioc].size;
+	void *sq_buffer = memalign(0x1000, NVME_SQ_ENTRY_SIZE * size);
 	if (!sq_buffer) {
 		printf("NVMe ERROR: Failed to allocate memory for io submission queue.\n");
 		return -1;
 	}
-	memset(sq_buffer, 0, NVME_SQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	memset(sq_buffer, 0, NVME_SQ_ENTRY_SIZE * size);
 
 	struct nvme_s_queue_entry e = {
 		.dw[0]  = 0x01,
 		.dw[6]  = virt_to_phys(sq_buffer),
-		.dw[10] = ((NVME_QUEUE_SIZE - 1) << 16) | ios >> 1,
+		.dw[10] = ((size - 1) << 16) | ios >> 1,
 		.dw[11] = (1 << 16) | 1,
 	};
 
@@ -245,22 +378,25 @@ static int create_io_submission_queue(struct nvme_dev *nvme)
 	nvme->queue[ios].base = sq_buffer;
 	nvme->queue[ios].bell = nvme->config + 0x1000 + (ios * (4 << cap_dstrd));
 	nvme->queue[ios].idx = 0;
+	nvme->queue[ios].size = size;
 	return 0;
 }
 
 static int create_io_completion_queue(struct nvme_dev *nvme)
 {
-	void *const cq_buffer = memalign(0x1000, NVME_CQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	/* CAP.MQES is 0's based */
+	const uint16_t size = MIN(NVME_IO_QUEUE_SIZE, (read64(nvme->config) & 0xffff) + 1);
+	void *const cq_buffer = memalign(0x1000, NVME_CQ_ENTRY_SIZE * size);
 	if (!cq_buffer) {
 		printf("NVMe ERROR: Failed to allocate memory for io completion queue.\n");
 		return -1;
 	}
-	memset(cq_buffer, 0, NVME_CQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
+	memset(cq_buffer, 0, NVME_CQ_ENTRY_SIZE * size);
 
 	const struct nvme_s_queue_entry e = {
 		.dw[0]  = 0x05,
 		.dw[6]  = virt_to_phys(cq_buffer),
-		.dw[10] = ((NVME_QUEUE_SIZE - 1) << 16) | ioc >> 1,
+		.dw[10] = ((size - 1) << 16) | ioc >> 1,
 		.dw[11] = 1,
 	};
 
@@ -276,6 +412,7 @@ static int create_io_completion_queue(struct nvme_dev *nvme)
 	nvme->queue[ioc].bell  = nvme->config + 0x1000 + (ioc * (4 << cap_dstrd));
 	nvme->queue[ioc].idx   = 0;
 	nvme->queue[ioc].round = 0;
+	nvme->queue[ioc].size  = size;
 
 	return 0;
 }
@@ -296,6 +433,7 @@ static int create_admin_queues(struct nvme_dev *nvme)
 	nvme->queue[ads].base = sq_buffer;
 	nvme->queue[ads].bell = nvme->config + 0x1000 + (ads * (4 << cap_dstrd));
 	nvme->queue[ads].idx = 0;
+	nvme->queue[ads].size = NVME_QUEUE_SIZE;
 
 	void *cq_buffer = memalign(0x1000, NVME_CQ_ENTRY_SIZE * NVME_QUEUE_SIZE);
 	if (!cq_buffer) {
@@ -310,10 +448,68 @@ static int create_admin_queues(struct nvme_dev *nvme)
 	nvme->queue[adc].bell = nvme->config + 0x1000 + (adc * (4 << cap_dstrd));
 	nvme->queue[adc].idx = 0;
 	nvme->queue[adc].round = 0;
+	nvme->queue[adc].size = NVME_QUEUE_SIZE;
 
 	return 0;
 }
 
+/* Limit the size of read commands to MDTS from the Identify Controller data. */
+static int identify_controller(struct nvme_dev *nvme)
+{
+	uint8_t *const data = memalign(0x1000, 0x1000);
+	if (!data) {
+		printf("NVMe ERROR: Failed to allocate buffer for identify data\n");
+		return -1;
+	}
+
+	const struct nvme_s_queue_entry e = {
+		.dw[0]  = 0x06,
+		.dw[6]  = virt_to_phys(data),
+		.dw[10] = 1,
+	};
+
+	int res = nvme_cmd(nvme, NVME_ADMIN_QUEUE, &e);
+	if (res) {
+		printf("NVMe ERROR: Identify controller returned with %i.\n", res);
+		free(data);
+		return res;
+	}
+
+	/* In units of CAP.MPSMIN, which is 4KiB as we run with CC.MPS = 0 */
+	const uint8_t mdts = data[77];
+	nvme->max_blocks = NVME_MAX_XFER_BLOCKS;
+	if (mdts && mdts < 16)
+		nvme->max_blocks = MIN(nvme->max_blocks, (0x1000U / 512) << mdts);
+
+	free(data);
+	return 0;
+}
+
+static int setup_io_slots(struct nvme_dev *nvme)
+{
+	/* Pages after the first one of the largest, unaligned transfer */
+	const unsigned int entries = nvme->max_blocks * 512 / 0x1000;
+	unsigned int i;
+
+	nvme->slots = MIN(NVME_IO_SLOTS, nvme->queue[ioc].size - 1U);
+	nvme->prp_pages = 1;
+	if (entries > NVME_PRP_ENTRIES)
+		nvme->prp_pages += DIV_ROUND_UP(entries - NVME_PRP_ENTRIES,
+						NVME_PRP_ENTRIES - 1);
+
+	nvme->prp_list = memalign(0x1000, nvme->slots * nvme->prp_pages * 0x1000);
+	if (!nvme->prp_list) {
+		printf("NVMe ERROR: Failed to allocate buffer for PRP lists\n");
+		return -1;
+	}
+
+	for (i = 0; i < nvme->slots; ++i) {
+		nvme->slot[i].req = NULL;
+		nvme->slot[i].prp_list = nvme->prp_list + i * nvme->prp_pages * NVME_PRP_ENTRIES;
+	}
+	return 0;
+}
+
 static void nvme_init(pcidev_t dev)
 {
 	printf("NVMe init (Device %02x:%02x.%02x)\n",
@@ -325,7 +521,7 @@ static void nvme_init(pcidev_t dev)
 		printf("NVMe ERROR: PCIe device does not support the NVMe command set\n");
 		return;
 	}
-	struct nvme_dev *nvme = malloc(sizeof(*nvme));
+	struct nvme_dev *nvme = calloc(1, sizeof(*nvme));
 	if (!nvme) {
 		printf("NVMe ERROR: Failed to allocate buffer for nvme driver struct\n");
 		return;
@@ -334,15 +530,11 @@ static void nvme_init(pcidev_t dev)
 	nvme->storage_dev.poll			= nvme_poll;
 	nvme->storage_dev.read_blocks512	= nvme_read_blocks512;
 	nvme->storage_dev.write_blocks512	= NULL;
+	nvme->storage_dev.read_blocks512_async	= nvme_read_blocks512_async;
+	nvme->storage_dev.poll_request		= nvme_poll_request;
 	nvme->storage_dev.detach_device		= nvme_detach_device;
 	nvme->pci_dev				= dev;
 	nvme->config				= pci_bar0;
-	nvme->prp_list				= memalign(0x1000, 0x1000);
-
-	if (!nvme->prp_list) {
-		printf("NVMe ERROR: Failed to allocate buffer for PRP list\n");
-		goto _free_abort;
-	}
 
 	const uint32_t cc = NVME_CC_EN | NVME_CC_CSS | NVME_CC_MPS | NVME_CC_AMS | NVME_CC_SHN
 			| NVME_CC_IOSQES | NVME_CC_IOCQES;
@@ -380,8 +572,12 @@ static void nvme_init(pcidev_t dev)
 
 	uint16_t command = pci_read_config16(dev, PCI_COMMAND);
 	pci_write_config16(dev, PCI_COMMAND, command | PCI_COMMAND_MASTER);
+	if (identify_controller(nvme))
+		goto _delete_admin_abort;
 	if (create_io_completion_queue(nvme))
 		goto _delete_admin_abort;
+	if (setup_io_slots(nvme))
+		goto _delete_completion_abort;
 	if (create_io_submission_queue(nvme))
 		goto _delete_completion_abort;
 	storage_attach_device((storage_dev_t *)nvme);
@@ -100,6 +100,198 @@ ssize_t storage_read_blocks512(const size_t dev_num,
 		return -1;
 }
 
+/* Asynchronous requests that were not reported finished yet */
+static struct storage_request *pending = NULL;
+
+/**
+ * Sets up the state of a request with filled in arguments
+ *
+ * @req request to set up
+ * @dev device the request is for
+ */
+void storage_request_init(struct storage_request *const req,
+			  storage_dev_t *const dev)
+{
+	size_t i;
+
+	req->dev = dev;
+	req->count = 0;
+	for (i = 0; i < req->sg_count; ++i)
+		req->count += req->sg[i].count;
+	req->result = req->count;
+	req->next = 0;
+	req->seg = 0;
+	req->seg_off = 0;
+	req->inflight = 0;
+	req->failed = 0;
+	req->finished = 0;
+}
+
+/**
+ * Takes the next piece of a request to submit to the device
+ *
+ * Pieces don't cross the boundaries of scatter-gather entries.
+ *
+ * @req request to take from
+ * @max_blocks maximum size of the piece
+ * @blocks where the size of the piece is stored
+ * @return buffer of the piece or NULL if everything was taken already
+ */
+unsigned char *storage_request_take(struct storage_request *const req,
+				    const size_t max_blocks,
+				    size_t *const blocks)
+{
+	while (req->seg < req->sg_count &&
+	       req->seg_off == req->sg[req->seg].count) {
+		++req->seg;
+		req->seg_off = 0;
+	}
+	if (req->seg == req->sg_count)
+		return NULL;
+
+	const struct storage_sg *const sg = &req->sg[req->seg];
+	unsigned char *const buf = sg->buf + req->seg_off * 512;
+
+	*blocks = MIN(sg->count - req->seg_off, max_blocks);
+	req->seg_off += *blocks;
+	req->next += *blocks;
+	return buf;
+}
+
+/* Reads a request synchronously for devices without asynchronous support. */
+static void storage_read_request_sync(struct storage_request *const req)
+{
+	storage_dev_t *const dev = req->dev;
+	unsigned char *buf;
+	size_t blocks;
+
+	while (!req->failed && (buf = storage_request_take(req, req->count, &blocks))) {
+		const size_t off = req->next - blocks;
+		const ssize_t ret = dev->read_blocks512(dev, req->start + off, blocks, buf);
+		if (ret != (ssize_t)blocks) {
+			req->result = off + (ret < 0 ? 0 : ret);
+			req->failed = 1;
+		}
+	}
+	req->finished = 1;
+}
+
+/**
+ * Submits a read request with filled in arguments to storage device dev_num
+ *
+ * Devices without asynchronous support read the data right away, the
+ * completion callback is still only called when polling.
+ *
+ * @dev_num device number counted from 0
+ * @req request to submit
+ * @return 0 if the request was submitted, -1 on error
+ */
+int storage_submit_request(const size_t dev_num,
+			   struct storage_request *const req)
+{
+	if ((dev_num >= dev_count) || !devices[dev_num]->read_blocks512)
+		return -1;
+
+	storage_dev_t *const dev = devices[dev_num];
+
+	storage_request_init(req, dev);
+
+	if (dev->read_blocks512_async && dev->poll_request) {
+		if (dev->read_blocks512_async(dev, req))
+			return -1;
+	} else {
+		storage_read_request_sync(req);
+	}
+
+	req->next_pending = pending;
+	pending = req;
+	return 0;
+}
+
+/**
+ * Starts reading count blocks of 512 bytes from block start of storage device
+ * dev_num into buf without waiting for the data
+ *
+ * @dev_num device number counted from 0
+ * @req request to track the read with
+ * @start number of first block to read from
+ * @count number of blocks to read
+ * @buf buffer where the read data should be written
+ * @return 0 if the read was started, -1 on error
+ */
+int storage_read_blocks512_async(const size_t dev_num,
+				 struct storage_request *const req,
+				 const lba_t start, const size_t count,
+				 unsigned char *const buf)
+{
+	req->single.buf = buf;
+	req->single.count = count;
+	req->start = start;
+	req->sg = &req->single;
+	req->sg_count = 1;
+	req->complete = NULL;
+
+	return storage_submit_request(dev_num, req);
+}
+
+/**
+ * Makes progress on all asynchronous requests and calls the completion
+ * callbacks of those that finished
+ *
+ * @return number of requests that are still in flight
+ */
+int storage_poll_requests(void)
+{
+	struct storage_request **link = &pending;
+	int in_flight = 0;
+
+	while (*link) {
+		struct storage_request *const req = *link;
+
+		if (!req->finished)
+			req->finished = req->dev->poll_request(req->dev, req);
+		if (!req->finished) {
+			link = &req->next_pending;
+			++in_flight;
+			continue;
+		}
+
+		/* Unlink first, the callback may submit new requests. */
+		*link = req->next_pending;
+		req->next_pending = NULL;
+		if (req->complete)
+			req->complete(req);
+	}
+
+	return in_flight;
+}
+
+/**
+ * Makes progress on asynchronous requests
+ *
+ * @req request started by storage_submit_request()
+ * @return 1 if the request is finished, 0 if it is still in flight
+ */
+int storage_poll_request(struct storage_request *const req)
+{
+	storage_poll_requests();
+	return req->finished;
+}
+
+/**
+ * Waits for an asynchronous read to finish
+ *
+ * @req request started by storage_submit_request()
+ * @return number of blocks read from the start of the request before
+ *	   the first error, like storage_read_blocks512()
+ */
+ssize_t storage_wait_request(struct storage_request *const req)
+{
+	while (!storage_poll_request(req))
+		;
+	return req->result;
+}
+
 /**
  * Initializes storage controllers
  *
@@ -41,3 +41,66 @@ uint64_t timer_raw_value(void)
 {
 	return raw_read_cntpct_el0();
 }
+
+/* Event stream bits, the same in CNTKCTL_EL1 and (without VHE) CNTHCTL_EL2. */
+#define CNTCTL_EVNTEN		(1 << 2)
+#define CNTCTL_EVNTI_SHIFT	4
+#define CNTCTL_EVNTI_MASK	(0xf << CNTCTL_EVNTI_SHIFT)
+
+/* Wake up from wfe about this often, so delays don't overshoot by much. */
+#define EVENT_STREAM_PERIOD_US	50
+
+/*
+ * Have the timer generate an event whenever a counter bit toggles, so the delay loop can
+ * wait in wfe instead of spinning. Only EL1 and EL2 have an event stream, returns false
+ * if it can't be used.
+ */
+static bool event_stream_enable(void)
+{
+	static int enabled = -1;
+	uint64_t ticks = timer_hz() * EVENT_STREAM_PERIOD_US / USECS_PER_SEC;
+	uint64_t ctl;
+	unsigned int bit = 0;
+
+	if (enabled >= 0)
+		return enabled;
+
+	/* An event fires every 2^(bit + 1) ticks. */
+	while (bit < 15 && (2ULL << (bit + 1)) <= ticks)
+		bit++;
+
+	switch ((raw_read_currentel() >> 2) & 3) {
+	case 1:
+		ctl = raw_read_cntkctl_el1() & ~CNTCTL_EVNTI_MASK;
+		raw_write_cntkctl_el1(ctl | CNTCTL_EVNTEN | bit << CNTCTL_EVNTI_SHIFT);
+		enabled = 1;
+		break;
+	case 2:
+		ctl = raw_read_cnthctl_el2() & ~CNTCTL_EVNTI_MASK;
+		raw_write_cnthctl_el2(ctl | CNTCTL_EVNTEN | bit << CNTCTL_EVNTI_SHIFT);
+		enabled = 1;
+		break;
+	default:
+		enabled = 0;
+		break;
+	}
+
+	isb();
+	return enabled;
+}
+
+void arch_ndelay(uint64_t ns)
+{
+	uint64_t delta = ns * timer_hz() / NSECS_PER_SEC;
+	uint64_t start = timer_raw_value();
+	/* Leave the last period to the busy loop, a wfe may sleep for all of it. */
+	uint64_t period = timer_hz() * EVENT_STREAM_PERIOD_US / USECS_PER_SEC;
+
+	if (delta > period && event_stream_enable()) {
+		while (timer_raw_value() - start < delta - period)
+			asm volatile("wfe" ::: "memory");
+	}
+
+	while (timer_raw_value() - start < delta)
+		;
+}
@@ -162,6 +162,7 @@ static const generic_hub_ops_t dwc2_rh_ops = {
 	.disable_port		= dwc2_rh_disable_port,
 	.start_port_reset	= NULL,
 	.reset_port		= dwc2_rh_reset_port,
+	.finish_port_reset	= NULL,
 };
 
 void
@@ -356,7 +356,9 @@ static int ehci_bulk(endpoint_t *ep, int size, u8 *src, int finalize)
 			return -1;
 	}
 
-	if (!dma_coherent(src)) {
+	const int cached = !dma_coherent(src) &&
+			   dma_map_cached(src, size, pid == EHCI_IN);
+	if (!dma_coherent(src) && !cached) {
 		end = EHCI_INST(ep->dev->controller)->dma_buffer + size;
 		if (size > DMA_SIZE) {
 			usb_debug("EHCI bulk transfer too large for DMA buffer: %d\n", size);
@@ -413,7 +415,9 @@ static int ehci_bulk(endpoint_t *ep, int size, u8 *src, int finalize)
 			EHCI_INST(ep->dev->controller), qh, head);
 	if (result >= 0) {
 		result = size - result;
-		if (pid == EHCI_IN && end != src + size)
+		if (cached)
+			dma_unmap_cached(src, size, pid == EHCI_IN);
+		else if (pid == EHCI_IN && end != src + size)
 			memcpy(src, end - size, result);
 	}
 
@@ -32,6 +32,46 @@
 #include <usb/usb.h>
 #include "generic_hub.h"
 
+enum {
+	PORT_IDLE = 0,
+	PORT_DEBOUNCE,
+	PORT_RESET,
+	PORT_ENABLE,
+	PORT_RECOVERY,
+};
+
+/* Hubs with ports that are being enumerated, in the order they got busy. */
+static generic_hub_t *busy_hubs;
+
+static void
+generic_hub_set_busy(generic_hub_t *const hub)
+{
+	generic_hub_t **link;
+
+	if (hub->busy)
+		return;
+
+	for (link = &busy_hubs; *link; link = &(*link)->next_busy)
+		;
+	hub->next_busy = NULL;
+	hub->busy = 1;
+	*link = hub;
+}
+
+static void
+generic_hub_clear_busy(generic_hub_t *const hub)
+{
+	generic_hub_t **link;
+
+	for (link = &busy_hubs; *link; link = &(*link)->next_busy) {
+		if (*link == hub) {
+			*link = hub->next_busy;
+			break;
+		}
+	}
+	hub->busy = 0;
+}
+
 void
 generic_hub_destroy(usbdev_t *const dev)
 {
@@ -39,6 +79,8 @@ generic_hub_destroy(usbdev_t *const dev)
 	if (!hub)
 		return;
 
+	generic_hub_clear_busy(hub);
+
 	/* First, detach all devices behind this hub */
 	int port;
 	for (port = 1; port <= hub->num_ports; ++port) {
@@ -55,43 +97,11 @@ generic_hub_destroy(usbdev_t *const dev)
 			hub->ops->disable_port(dev, port);
 	}
 
+	free(hub->port_state);
 	free(hub->ports);
 	free(hub);
 }
 
-static int
-generic_hub_debounce(usbdev_t *const dev, const int port)
-{
-	generic_hub_t *const hub = GEN_HUB(dev);
-
-	const int step_ms	= 1;	/* linux uses 25ms, we're busy anyway */
-	const int at_least_ms	= 100;	/* 100ms as in usb20 spec 9.1.2 */
-	const int timeout_ms	= 1500;	/* linux uses this value */
-
-	int total_ms = 0;
-	int stable_ms = 0;
-	while (stable_ms < at_least_ms && total_ms < timeout_ms) {
-		mdelay(step_ms);
-
-		const int changed = hub->ops->port_status_changed(dev, port);
-		const int connected = hub->ops->port_connected(dev, port);
-		if (changed < 0 || connected < 0)
-			return -1;
-
-		if (!changed && connected) {
-			stable_ms += step_ms;
-		} else {
-			usb_debug("generic_hub: Unstable connection at %d\n",
-				  port);
-			stable_ms = 0;
-		}
-		total_ms += step_ms;
-	}
-	if (total_ms >= timeout_ms)
-		usb_debug("generic_hub: Debouncing timed out at %d\n", port);
-	return 0; /* ignore timeouts, try to always go on */
-}
-
 int
 generic_hub_wait_for_port(usbdev_t *const dev, const int port,
 			  const int wait_for,
@@ -145,53 +155,190 @@ generic_hub_detach_dev(usbdev_t *const dev, const int port)
 	return 0;
 }
 
+static void
+generic_hub_enter(generic_hub_t *const hub, const int port, const int state)
+{
+	generic_hub_port_t *const ps = &hub->port_state[port];
+
+	ps->state = state;
+	ps->start_us = timer_us(0);
+	ps->sample_us = 0;
+}
+
+/* Returns 1 if at least |interval_us| passed since the port was last looked at. */
 static int
-generic_hub_attach_dev(usbdev_t *const dev, const int port)
+generic_hub_sample(generic_hub_port_t *const ps, const u64 now,
+		   const u64 interval_us)
+{
+	if (ps->sample_us && now - ps->sample_us < interval_us)
+		return 0;
+	ps->sample_us = now;
+	return 1;
+}
+
+static void
+generic_hub_port_ready(usbdev_t *const dev, const int port)
 {
 	generic_hub_t *const hub = GEN_HUB(dev);
 
-	if (generic_hub_debounce(dev, port) < 0)
-		return -1;
+	const usb_speed speed = hub->ops->port_speed(dev, port);
+	if (speed < 0) {
+		hub->port_state[port].state = PORT_IDLE;
+		return;
+	}
 
+	usb_debug("generic_hub: Success at port %d\n", port);
 	if (hub->ops->reset_port) {
+		/* Reset recovery time (usb20 spec 7.1.7.5) */
+		generic_hub_enter(hub, port, PORT_RECOVERY);
+		return;
+	}
+
+	hub->port_state[port].state = PORT_IDLE;
+	hub->ports[port] = usb_attach_device(
+			dev->controller, dev->address, port, speed);
+}
+
+static void
+generic_hub_port_reset_done(usbdev_t *const dev, const int port)
+{
+	generic_hub_t *const hub = GEN_HUB(dev);
+
+	if (!hub->ops->port_connected(dev, port)) {
+		usb_debug(
+			"generic_hub: Port %d disconnected after "
+			"reset. Possibly upgraded, rescan required.\n",
+			port);
+		hub->port_state[port].state = PORT_IDLE;
+		return;
+	}
+
+	/* after reset the port will be enabled automatically */
+	generic_hub_enter(hub, port, PORT_ENABLE);
+}
+
+static void
+generic_hub_port_debounced(usbdev_t *const dev, const int port)
+{
+	generic_hub_t *const hub = GEN_HUB(dev);
+
+	if (!hub->ops->reset_port) {
+		generic_hub_port_ready(dev, port);
+	} else if (hub->ops->start_port_reset) {
+		if (hub->ops->start_port_reset(dev, port) < 0)
+			hub->port_state[port].state = PORT_IDLE;
+		else
+			generic_hub_enter(hub, port, PORT_RESET);
+	} else {
+		/* Hubs without start_port_reset can only reset synchronously. */
 		if (hub->ops->reset_port(dev, port) < 0)
-			return -1;
+			hub->port_state[port].state = PORT_IDLE;
+		else
+			generic_hub_port_reset_done(dev, port);
+	}
+}
 
-		if (!hub->ops->port_connected(dev, port)) {
-			usb_debug(
-				"generic_hub: Port %d disconnected after "
-				"reset. Possibly upgraded, rescan required.\n",
-				port);
-			return 0;
+static void
+generic_hub_step_port(usbdev_t *const dev, const int port)
+{
+	generic_hub_t *const hub = GEN_HUB(dev);
+	generic_hub_port_t *const ps = &hub->port_state[port];
+	const u64 now = timer_us(0);
+	int ret;
+
+	switch (ps->state) {
+	case PORT_DEBOUNCE: {
+		const u64 step_us	= 1000;		/* linux uses 25ms, we're busy anyway */
+		const u64 at_least_us	= 100 * 1000;	/* as in usb20 spec 9.1.2 */
+		const u64 timeout_us	= 1500 * 1000;	/* linux uses this value */
+
+		/* start_us is in the future until the port is powered up */
+		if (now < ps->start_us || !generic_hub_sample(ps, now, step_us))
+			break;
+
+		const int changed = hub->ops->port_status_changed(dev, port);
+		const int connected = hub->ops->port_connected(dev, port);
+		if (changed < 0 || connected < 0) {
+			ps->state = PORT_IDLE;
+			break;
 		}
 
-		/* after reset the port will be enabled automatically */
-		const int ret = generic_hub_wait_for_port(
-			/* time out after 1,000 * 10us = 10ms */
-			dev, port, 1, hub->ops->port_enabled, 1000, 10);
-		if (ret < 0)
-			return -1;
-		else if (!ret)
+		if (changed || !connected) {
+			usb_debug("generic_hub: Unstable connection at %d\n",
+				  port);
+			ps->stable_us = now;
+		}
+
+		if (now - ps->stable_us >= at_least_us) {
+			generic_hub_port_debounced(dev, port);
+		} else if (now - ps->start_us >= timeout_us) {
+			usb_debug("generic_hub: Debouncing timed out at %d\n", port);
+			/* ignore timeouts, try to always go on */
+			generic_hub_port_debounced(dev, port);
+		}
+		break;
+	}
+	case PORT_RESET:
+		/* usb20 spec 11.5.1.5: reset should take 10 to 20ms */
+		if (now - ps->start_us < 10 * 1000 ||
+		    !generic_hub_sample(ps, now, 100))
+			break;
+
+		ret = hub->ops->port_in_reset(dev, port);
+		if (ret < 0) {
+			ps->state = PORT_IDLE;
+			break;
+		}
+		if (ret && now - ps->start_us < 150 * 1000)
+			break;
+
+		if (ret)
+			usb_debug("generic_hub: Reset timed out at port %d\n", port);
+		else if (hub->ops->finish_port_reset &&
+			 hub->ops->finish_port_reset(dev, port) < 0) {
+			ps->state = PORT_IDLE;
+			break;
+		}
+		generic_hub_port_reset_done(dev, port);
+		break;
+	case PORT_ENABLE:
+		if (!generic_hub_sample(ps, now, 10))
+			break;
+
+		ret = hub->ops->port_enabled(dev, port);
+		if (ret < 0) {
+			ps->state = PORT_IDLE;
+			break;
+		}
+		if (!ret && now - ps->start_us < 10 * 1000)
+			break;
+
+		if (!ret)
 			usb_debug("generic_hub: Port %d still "
 				  "disabled after 10ms\n", port);
+		generic_hub_port_ready(dev, port);
+		break;
+	case PORT_RECOVERY: {
+		if (now - ps->start_us < 10 * 1000)
+			break;
+
+		ps->state = PORT_IDLE;
+		const usb_speed speed = hub->ops->port_speed(dev, port);
+		if (speed >= 0)
+			hub->ports[port] = usb_attach_device(
+					dev->controller, dev->address, port, speed);
+		break;
 	}
-
-	const usb_speed speed = hub->ops->port_speed(dev, port);
-	if (speed >= 0) {
-		usb_debug("generic_hub: Success at port %d\n", port);
-		if (hub->ops->reset_port)
-			mdelay(10); /* Reset recovery time
-				       (usb20 spec 7.1.7.5) */
-		hub->ports[port] = usb_attach_device(
-				dev->controller, dev->address, port, speed);
+	default:
+		break;
 	}
-	return 0;
 }
 
 int
 generic_hub_scanport(usbdev_t *const dev, const int port)
 {
 	generic_hub_t *const hub = GEN_HUB(dev);
+	generic_hub_port_t *const ps = &hub->port_state[port];
 
 	if (hub->ports[port] >= 0) {
 		usb_debug("generic_hub: Detachment at port %d\n", port);
@@ -204,12 +351,53 @@ generic_hub_scanport(usbdev_t *const dev, const int port)
 	if (hub->ops->port_connected(dev, port)) {
 		usb_debug("generic_hub: Attachment at port %d\n", port);
 
-		return generic_hub_attach_dev(dev, port);
+		generic_hub_enter(hub, port, PORT_DEBOUNCE);
+		ps->start_us = MAX(ps->start_us, hub->power_good_us);
+		ps->stable_us = ps->start_us;
+		generic_hub_set_busy(hub);
+	} else {
+		ps->state = PORT_IDLE;
 	}
 
 	return 0;
 }
 
+void
+generic_hub_run(void)
+{
+	while (busy_hubs) {
+		generic_hub_t **link = &busy_hubs;
+
+		while (*link) {
+			generic_hub_t *const hub = *link;
+			int port, busy = 0;
+
+			for (port = 1; port <= hub->num_ports; ++port) {
+				generic_hub_step_port(hub->dev, port);
+				if (hub->port_state[port].state != PORT_IDLE)
+					busy = 1;
+			}
+
+			if (busy) {
+				link = &hub->next_busy;
+			} else {
+				*link = hub->next_busy;
+				hub->busy = 0;
+			}
+		}
+	}
+}
+
+void
+generic_hub_wait_power_good(usbdev_t *const dev)
+{
+	generic_hub_t *const hub = GEN_HUB(dev);
+	const u64 now = timer_us(0);
+
+	if (now < hub->power_good_us)
+		udelay(hub->power_good_us - now);
+}
+
 static void
 generic_hub_poll(usbdev_t *const dev)
 {
@@ -244,7 +432,7 @@ generic_hub_init(usbdev_t *const dev, const int num_ports,
 
 	dev->destroy = generic_hub_destroy;
 	dev->poll = generic_hub_poll;
-	dev->data = malloc(sizeof(generic_hub_t));
+	dev->data = calloc(1, sizeof(generic_hub_t));
 	if (!dev->data) {
 		usb_debug("generic_hub: ERROR: Out of memory\n");
 		return -1;
@@ -253,9 +441,13 @@ generic_hub_init(usbdev_t *const dev, const int num_ports,
 	generic_hub_t *const hub = GEN_HUB(dev);
 	hub->num_ports = num_ports;
 	hub->ports = malloc(sizeof(*hub->ports) * (num_ports + 1));
+	hub->port_state = calloc(num_ports + 1, sizeof(*hub->port_state));
 	hub->ops = ops;
-	if (!hub->ports) {
+	hub->dev = dev;
+	if (!hub->ports || !hub->port_state) {
 		usb_debug("generic_hub: ERROR: Out of memory\n");
+		free(hub->port_state);
+		free(hub->ports);
 		free(dev->data);
 		dev->data = NULL;
 		return -1;
@@ -267,8 +459,8 @@ generic_hub_init(usbdev_t *const dev, const int num_ports,
 	if (ops->enable_port) {
 		for (port = 1; port <= num_ports; ++port)
 			ops->enable_port(dev, port);
-		/* wait once for all ports */
-		mdelay(20);
+		/* wait once for all ports, debouncing starts after that */
+		hub->power_good_us = timer_us(0) + 20 * 1000;
 	}
 
 	return 0;
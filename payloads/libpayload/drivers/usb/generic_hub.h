@@ -56,8 +56,22 @@ typedef struct generic_hub_ops {
 
 	/* performs a port reset (optional, generic implementations below) */
 	int (*reset_port)(usbdev_t *, int port);
+	/* called once a port started with start_port_reset left reset (optional) */
+	int (*finish_port_reset)(usbdev_t *, int port);
 } generic_hub_ops_t;
 
+/*
+ * Enumeration state of a port. Newly connected ports are debounced, reset
+ * and attached by generic_hub_run(), so all ports of all hubs wait for
+ * their timeouts at the same time.
+ */
+typedef struct generic_hub_port {
+	int state;
+	u64 start_us;	/* when the current state was entered */
+	u64 sample_us;	/* when the port was last looked at */
+	u64 stable_us;	/* when the connection became stable */
+} generic_hub_port_t;
+
 typedef struct generic_hub {
 	int num_ports;
 	/* port numbers are always 1 based,
@@ -67,6 +81,12 @@ typedef struct generic_hub {
 
 	const generic_hub_ops_t *ops;
 
+	generic_hub_port_t *port_state; /* allocated like ports */
+	u64 power_good_us; /* ports are powered up after this time */
+	usbdev_t *dev;
+	struct generic_hub *next_busy; /* list of hubs with ports to enumerate */
+	int busy;
+
 	void *data;
 } generic_hub_t;
 
@@ -76,7 +96,12 @@ int generic_hub_wait_for_port(usbdev_t *const dev, const int port,
 			      int (*const port_op)(usbdev_t *, int),
 			      int timeout_steps, const int step_us);
 int  generic_hub_resetport(usbdev_t *, int port);
+/* detaches the device at a port and starts enumeration if it's connected */
 int  generic_hub_scanport(usbdev_t *, int port);
+/* waits until the ports that were enabled by generic_hub_init() are powered */
+void generic_hub_wait_power_good(usbdev_t *);
+/* runs the enumeration of all started ports until they are done */
+void generic_hub_run(void);
 /* the provided generic_hub_ops struct has to be static */
 int generic_hub_init(usbdev_t *, int num_ports, const generic_hub_ops_t *);
 
@@ -134,6 +134,7 @@ static const generic_hub_ops_t uhci_rh_ops = {
 	.disable_port		= uhci_rh_disable_port,
 	.start_port_reset	= NULL,
 	.reset_port		= uhci_rh_reset_port,
+	.finish_port_reset	= NULL,
 };
 
 void
@@ -31,6 +31,7 @@
 #include <inttypes.h>
 #include <libpayload-config.h>
 #include <usb/usb.h>
+#include "generic_hub.h"
 
 #define DR_DESC gen_bmRequestType(device_to_host, standard_type, dev_recp)
 
@@ -94,6 +95,11 @@ usb_poll(void)
 	hci_t *controller = usb_hcs;
 	while (controller != NULL) {
 		int i;
+		if (controller->poll_devices) {
+			controller->poll_devices(controller);
+			controller = controller->next;
+			continue;
+		}
 		for (i = 0; i < 128; i++) {
 			if (controller->devices[i] != 0) {
 				controller->devices[i]->poll(controller->devices[i]);
@@ -101,6 +107,10 @@ usb_poll(void)
 		}
 		controller = controller->next;
 	}
+
+	/* Enumerate all ports that saw a connection above at the same time. */
+	if (CONFIG(LP_USB_GEN_HUB))
+		generic_hub_run();
 }
 
 usbdev_t *
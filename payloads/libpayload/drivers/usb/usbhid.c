@@ -472,6 +472,7 @@ usb_hid_init(usbdev_t *dev)
 			// only add here, because we only support boot-keyboard HID devices
 			dev->destroy = usb_hid_destroy;
 			dev->poll = usb_hid_poll;
+			dev->poll_on_intr = 1;
 			int i;
 			for (i = 1; i < dev->num_endp; i++) {
 				if (dev->endpoints[i].type != INTERRUPT)
@@ -179,6 +179,7 @@ static const generic_hub_ops_t usb_hub_ops = {
 	.disable_port		= NULL,
 	.start_port_reset	= usb_hub_start_port_reset,
 	.reset_port		= generic_hub_resetport,
+	.finish_port_reset	= NULL,
 };
 
 /* Clear CSC if set and enumerate port if it's connected regardless of change
@@ -323,11 +324,15 @@ usb_hub_init(usbdev_t *const dev)
 		return;
 	}
 
+	/* Connections only show up once the ports are powered. */
+	generic_hub_wait_power_good(dev);
+
 	int port;
 	for (port = 1; port <= num_ports; ++port)
 		usb_hub_port_initialize(dev, port);
 
 	GEN_HUB(dev)->data = intrq;
 	dev->poll = usb_hub_poll;
+	dev->poll_on_intr = 1;
 	dev->destroy = usb_hub_destroy;
 }
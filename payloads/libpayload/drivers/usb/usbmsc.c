@@ -382,6 +382,99 @@ readwrite_chunk(usbdev_t *dev, int start, int n, cbw_direction dir, u8 *buf)
 		!= MSC_COMMAND_OK ? 1 : 0;
 }
 
+/* Read commands that are in flight at the same time in read_chunks_queued(). */
+#define MSC_QUEUE_DEPTH 4
+
+/**
+ * Reads MAX_CHUNK_BYTES size chunks with queued bulk transfers. The CBW, data
+ * and CSW transfers of the next chunks are queued while earlier ones are still
+ * running, so neither the controller nor the device wait for us between the
+ * phases. Bulk-only transport still runs one command after the other, but
+ * a device simply isn't ready for a queued CBW before it sent the last CSW.
+ *
+ * Anything unusual (errors, short reads, odd CSWs) stops the pipeline. The
+ * caller reads the rest the synchronous way, which knows how to deal with it.
+ *
+ * @param dev device to access
+ * @param start first sector to access
+ * @param n number of sectors to access
+ * @param buf DMA coherent buffer to read into
+ * @return number of chunks read, -1 if the device got detached
+ */
+static int
+read_chunks_queued(usbdev_t *dev, int start, int n, u8 *buf)
+{
+	usbmsc_inst_t *const msc = MSC_INST(dev);
+	hci_t *const ctrlr = dev->controller;
+	const int chunk_size = MAX_CHUNK_BYTES / msc->blocksize;
+	const int chunks = (n + chunk_size - 1) / chunk_size;
+	int queued = 0, done = 0;
+
+	struct {
+		cbw_t cbw;
+		csw_t csw;
+	} *const cmds = dma_malloc(MSC_QUEUE_DEPTH * sizeof(*cmds));
+	if (!cmds)
+		return 0;
+
+	while (done < chunks) {
+		while (queued < chunks && queued - done < MSC_QUEUE_DEPTH) {
+			const int blocks = MIN(n - queued * chunk_size, chunk_size);
+			const int bytes = blocks * msc->blocksize;
+			cmdblock_t cb;
+
+			memset(&cb, 0, sizeof(cb));
+			cb.command = 0x28;
+			cb.block = htonl(start + queued * chunk_size);
+			cb.numblocks = htonw(blocks);
+			wrap_cbw(&cmds[queued % MSC_QUEUE_DEPTH].cbw, bytes,
+				 cbw_direction_data_in, (u8 *)&cb, sizeof(cb),
+				 msc->lun);
+
+			if (ctrlr->bulk_queue(msc->bulk_out, sizeof(cbw_t),
+					(u8 *)&cmds[queued % MSC_QUEUE_DEPTH].cbw))
+				break;
+			/* A partially queued command can't be taken back. */
+			if (ctrlr->bulk_queue(msc->bulk_in, bytes,
+					buf + queued * MAX_CHUNK_BYTES) ||
+			    ctrlr->bulk_queue(msc->bulk_in, sizeof(csw_t),
+					(u8 *)&cmds[queued % MSC_QUEUE_DEPTH].csw)) {
+				++queued;
+				goto _abort;
+			}
+			++queued;
+		}
+		if (queued == done)
+			break;
+
+		const int blocks = MIN(n - done * chunk_size, chunk_size);
+		const cbw_t *const cbw = &cmds[done % MSC_QUEUE_DEPTH].cbw;
+		const csw_t *const csw = &cmds[done % MSC_QUEUE_DEPTH].csw;
+		if (ctrlr->bulk_dequeue(msc->bulk_out) != sizeof(cbw_t) ||
+		    ctrlr->bulk_dequeue(msc->bulk_in) !=
+				blocks * msc->blocksize ||
+		    ctrlr->bulk_dequeue(msc->bulk_in) != sizeof(csw_t) ||
+		    csw->dCSWSignature != csw_signature ||
+		    csw->dCSWTag != cbw->dCBWTag ||
+		    csw->bCSWStatus != 0 || csw->dCSWDataResidue != 0)
+			goto _abort;
+		++done;
+	}
+
+	free(cmds);
+	return done;
+
+_abort:
+	usb_debug("MSC: stopping queued reads after %d chunks\n", done);
+	ctrlr->bulk_flush(msc->bulk_out);
+	ctrlr->bulk_flush(msc->bulk_in);
+	free(cmds);
+	/* The device may be in the middle of any of the queued commands. */
+	if (reset_transport(dev) == MSC_COMMAND_DETACHED)
+		return -1;
+	return done;
+}
+
 /**
  * Reads or writes a number of sequential blocks on a USB storage device
  * that is split into MAX_CHUNK_BYTES size requests.
@@ -404,6 +497,16 @@ readwrite_blocks(usbdev_t *dev, int start, int n, cbw_direction dir, u8 *buf)
 	int chunk_size = MAX_CHUNK_BYTES / MSC_INST(dev)->blocksize;
 	int chunk;
 
+	if (dir == cbw_direction_data_in && dev->controller->bulk_queue &&
+	    dma_coherent(buf)) {
+		const int chunks_read = read_chunks_queued(dev, start, n, buf);
+		if (chunks_read < 0)
+			return 1;
+		start += chunks_read * chunk_size;
+		n -= MIN(n, chunks_read * chunk_size);
+		buf += chunks_read * MAX_CHUNK_BYTES;
+	}
+
 	/* Read as many full chunks as needed. */
 	for (chunk = 0; chunk < (n / chunk_size); chunk++) {
 		if (readwrite_chunk(dev, start + (chunk * chunk_size),
@@ -40,11 +40,15 @@ static void xhci_reset(hci_t *controller);
 static void xhci_reinit(hci_t *controller);
 static void xhci_shutdown(hci_t *controller);
 static int xhci_bulk(endpoint_t *ep, int size, u8 *data, int finalize);
+static int xhci_bulk_queue(endpoint_t *ep, int size, u8 *data);
+static int xhci_bulk_dequeue(endpoint_t *ep);
+static void xhci_bulk_flush(endpoint_t *ep);
 static int xhci_control(usbdev_t *dev, direction_t dir, int drlen, void *devreq,
 			 int dalen, u8 *data);
 static void* xhci_create_intr_queue(endpoint_t *ep, int reqsize, int reqcount, int reqtiming);
 static void xhci_destroy_intr_queue(endpoint_t *ep, void *queue);
 static u8* xhci_poll_intr_queue(void *queue);
+static void xhci_poll_devices(hci_t *controller);
 
 /*
  * Some structures must not cross page boundaries. To get this,
@@ -168,6 +172,9 @@ xhci_init(unsigned long physical_bar)
 	controller->init		= xhci_reinit;
 	controller->shutdown		= xhci_shutdown;
 	controller->bulk		= xhci_bulk;
+	controller->bulk_queue		= xhci_bulk_queue;
+	controller->bulk_dequeue	= xhci_bulk_dequeue;
+	controller->bulk_flush		= xhci_bulk_flush;
 	controller->control		= xhci_control;
 	controller->set_address		= xhci_set_address;
 	controller->finish_device_config = xhci_finish_device_config;
@@ -175,6 +182,7 @@ xhci_init(unsigned long physical_bar)
 	controller->create_intr_queue	= xhci_create_intr_queue;
 	controller->destroy_intr_queue	= xhci_destroy_intr_queue;
 	controller->poll_intr_queue	= xhci_poll_intr_queue;
+	controller->poll_devices	= xhci_poll_devices;
 	controller->pcidev		= 0;
 
 	controller->reg_base = (uintptr_t)physical_bar;
@@ -753,7 +761,9 @@ xhci_bulk(endpoint_t *const ep, const int size, u8 *const src,
 		return -1;
 	}
 
-	if (!dma_coherent(src)) {
+	const int cached = !dma_coherent(src) &&
+			   dma_map_cached(src, size, ep->direction == IN);
+	if (!dma_coherent(src) && !cached) {
 		data = xhci->dma_buffer;
 		if (size > DMA_SIZE) {
 			xhci_debug("Bulk transfer too large: %d\n", size);
@@ -793,11 +803,94 @@ xhci_bulk(endpoint_t *const ep, const int size, u8 *const src,
 		return ret;
 	}
 
-	if (ep->direction == IN && data != src)
+	if (cached)
+		dma_unmap_cached(src, size, ep->direction == IN);
+	else if (ep->direction == IN && data != src)
 		memcpy(src, data, ret);
 	return ret;
 }
 
+static int
+xhci_bulk_queue(endpoint_t *const ep, const int size, u8 *const data)
+{
+	xhci_t *const xhci = XHCI_INST(ep->dev->controller);
+	const int slot_id = ep->dev->address;
+	const int ep_id = xhci_ep_id(ep);
+	epctx_t *const epctx = xhci->dev[slot_id].ctx.ep[ep_id];
+	transfer_ring_t *const tr = xhci->dev[slot_id].transfer_rings[ep_id];
+	bulkq_t *const q = &xhci->dev[slot_id].bulk_queues[ep_id];
+
+	/* One TRB per 64KiB boundary crossed plus the Event Data TRB */
+	const size_t off = (size_t)data & 0xffff;
+	const size_t trbs = (size ? ((off + size - 1) >> 16) + 1 : 1) + 1;
+
+	/* Keep one TRB free, so the enqueue pointer never hits the dequeue pointer */
+	if (!dma_coherent(data) || q->count == MAX_QUEUED_TDS ||
+	    q->used + trbs > TRANSFER_RING_SIZE - 2)
+		return -1;
+
+	/* Reset endpoint if it's not running */
+	const unsigned ep_state = EC_GET(STATE, epctx);
+	if (ep_state > 1) {
+		if (q->count || xhci_reset_endpoint(ep->dev, ep))
+			return -1;
+	}
+
+	const unsigned mps = EC_GET(MPS, epctx);
+	const unsigned dir = (ep->direction == OUT) ? TRB_DIR_OUT : TRB_DIR_IN;
+	xhci_enqueue_td(tr, ep_id, mps, size, data, dir);
+	xhci_ring_doorbell(ep);
+
+	q->trbs[(q->first + q->count) % MAX_QUEUED_TDS] = trbs;
+	q->used += trbs;
+	++q->count;
+	return 0;
+}
+
+static int
+xhci_bulk_dequeue(endpoint_t *const ep)
+{
+	xhci_t *const xhci = XHCI_INST(ep->dev->controller);
+	const int slot_id = ep->dev->address;
+	const int ep_id = xhci_ep_id(ep);
+	bulkq_t *const q = &xhci->dev[slot_id].bulk_queues[ep_id];
+
+	if (!q->count)
+		return -1;
+
+	/* TDs on one endpoint complete in order */
+	const int ret = xhci_wait_for_transfer(xhci, slot_id, ep_id);
+	q->used -= q->trbs[q->first];
+	q->first = (q->first + 1) % MAX_QUEUED_TDS;
+	--q->count;
+
+	if (ret < 0)
+		xhci_debug("Queued bulk transfer on ID %d EP %d failed: %d\n",
+			   slot_id, ep_id, ret);
+	return ret;
+}
+
+static void
+xhci_bulk_flush(endpoint_t *const ep)
+{
+	xhci_t *const xhci = XHCI_INST(ep->dev->controller);
+	const int slot_id = ep->dev->address;
+	const int ep_id = xhci_ep_id(ep);
+	epctx_t *const epctx = xhci->dev[slot_id].ctx.ep[ep_id];
+	bulkq_t *const q = &xhci->dev[slot_id].bulk_queues[ep_id];
+
+	if (!q->count)
+		return;
+
+	/* A stopped endpoint gets its transfer ring reset, dropping all TDs */
+	if (EC_GET(STATE, epctx) == 1)
+		xhci_cmd_stop_endpoint(xhci, slot_id, ep_id);
+	xhci_reset_endpoint(ep->dev, ep);
+	xhci_handle_events(xhci);
+
+	memset(q, 0, sizeof(*q));
+}
+
 static trb_t *
 xhci_next_trb(trb_t *cur, int *const pcs)
 {
@@ -987,3 +1080,27 @@ xhci_poll_intr_queue(void *const q)
 
 	return reqdata;
 }
+
+/* Handle pending events once and only poll devices that need it. */
+static void
+xhci_poll_devices(hci_t *const controller)
+{
+	xhci_t *const xhci = XHCI_INST(controller);
+	int i;
+
+	xhci_handle_events(xhci);
+
+	for (i = 0; i < 128; ++i) {
+		usbdev_t *const dev = controller->devices[i];
+		if (!dev)
+			continue;
+		if (dev->poll_on_intr) {
+			const u32 bit = 1U << (i % 32);
+			if (!(xhci->intr_pending[i / 32] & bit))
+				continue;
+			/* Clear first, events handled during poll() set it again */
+			xhci->intr_pending[i / 32] &= ~bit;
+		}
+		dev->poll(dev);
+	}
+}
@@ -329,6 +329,8 @@ xhci_finish_ep_config(const endpoint_t *const ep, inputctx_t *const ic)
 	}
 	xhci->dev[ep->dev->address].transfer_rings[ep_id] = tr;
 	xhci_init_cycle_ring(tr, TRANSFER_RING_SIZE);
+	memset(&xhci->dev[ep->dev->address].bulk_queues[ep_id], 0,
+	       sizeof(bulkq_t));
 
 	*ic->add |= (1 << ep_id);
 	if (SC_GET(CTXENT, ic->dev.slot) < ep_id)
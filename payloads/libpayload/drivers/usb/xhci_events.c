@@ -91,6 +91,8 @@ xhci_handle_transfer_event(xhci_t *const xhci)
 			(intrq = xhci->dev[id].interrupt_queues[ep])) {
 		/* It's a running interrupt endpoint */
 		intrq->ready = phys_to_virt(ev->ptr_low);
+		if (id < 128)
+			xhci->intr_pending[id / 32] |= 1U << (id % 32);
 		if (cc == CC_SUCCESS || cc == CC_SHORT_PACKET) {
 			TRB_SET(TL, intrq->ready,
 				intrq->size - TRB_GET(EVTL, ev));
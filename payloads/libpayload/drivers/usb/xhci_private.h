@@ -306,10 +306,20 @@ typedef struct intrq {
 	endpoint_t *ep;
 } intrq_t;
 
+/* Bulk TDs queued with bulk_queue() that were not dequeued yet */
+#define MAX_QUEUED_TDS 16
+typedef struct bulkq {
+	u8 trbs[MAX_QUEUED_TDS];	/* TRBs used by each TD, oldest first */
+	u8 first;
+	u8 count;
+	u8 used;			/* TRBs used by all queued TDs */
+} bulkq_t;
+
 typedef struct devinfo {
 	devctx_t ctx;
 	transfer_ring_t *transfer_rings[NUM_EPS];
 	intrq_t *interrupt_queues[NUM_EPS];
+	bulkq_t bulk_queues[NUM_EPS];
 } devinfo_t;
 
 typedef struct erst_entry {
@@ -478,6 +488,9 @@ typedef struct xhci {
 	u8 max_slots_en;
 	devinfo_t *dev;	/* array of devinfos by slot_id */
 
+	/* Devices by slot_id that got interrupt transfers since their last poll */
+	u32 intr_pending[128 / 32];
+
 #define DMA_SIZE (64 * 1024)
 	void *dma_buffer;
 } xhci_t;
@@ -66,40 +66,6 @@ static unsigned short *chars;
 /* Shorthand for up-to-date virtual framebuffer address */
 #define FB ((unsigned char *)phys_to_virt(fbinfo.physical_address))
 
-static void corebootfb_scroll_up(void)
-{
-	unsigned char *dst = FB;
-	unsigned char *src = FB + (fbinfo.bytes_per_line * font_height);
-	int y;
-
-	/* Scroll all lines up */
-	for (y = 0; y < fbinfo.y_resolution - font_height; y++) {
-		memcpy(dst, src, fbinfo.x_resolution * (fbinfo.bits_per_pixel >> 3));
-
-		dst += fbinfo.bytes_per_line;
-		src += fbinfo.bytes_per_line;
-	}
-
-	/* Erase last line */
-	dst = FB + (fbinfo.y_resolution - font_height) * fbinfo.bytes_per_line;
-
-	for (; y < fbinfo.y_resolution; y++) {
-		memset(dst, 0, fbinfo.x_resolution * (fbinfo.bits_per_pixel >> 3));
-		dst += fbinfo.bytes_per_line;
-	}
-
-	/* And update the char buffer */
-	dst = (unsigned char *)chars;
-	src = (unsigned char *)(chars + coreboot_video_console.columns);
-	memcpy(dst, src, coreboot_video_console.columns *
-			(coreboot_video_console.rows - 1) * 2);
-	int column;
-	for (column = 0; column < coreboot_video_console.columns; column++)
-		chars[(coreboot_video_console.rows - 1) * coreboot_video_console.columns + column] = (VGA_COLOR_DEFAULT << 8);
-
-	cursor_y--;
-}
-
 static void corebootfb_clear(void)
 {
 	int row, column;
@@ -117,6 +83,73 @@ static void corebootfb_clear(void)
 			chars[row * coreboot_video_console.columns + column] = (VGA_COLOR_DEFAULT << 8);
 }
 
+static u32 corebootfb_color(unsigned char color)
+{
+	if (fbinfo.bits_per_pixel <= 8)
+		return color;
+
+	return ((((vga_colors[color] >> 0) & 0xff) >> (8 - fbinfo.blue_mask_size)) << fbinfo.blue_mask_pos) |
+	       ((((vga_colors[color] >> 8) & 0xff) >> (8 - fbinfo.green_mask_size)) << fbinfo.green_mask_pos) |
+	       ((((vga_colors[color] >> 16) & 0xff) >> (8 - fbinfo.red_mask_size)) << fbinfo.red_mask_pos);
+}
+
+/*
+ * Glyph rows in framebuffer format for the most recently used color pairs:
+ * for each of the 256 possible rows of the 8 pixel wide font, the scaled
+ * pixels ready to be copied to the framebuffer.
+ */
+#define GLYPH_CACHE_COLORS 2
+
+static struct {
+	unsigned int attr;	/* (bg << 4 | fg) + 1, 0 if unused */
+	unsigned int last_use;
+	unsigned char *rows;
+} glyph_cache[GLYPH_CACHE_COLORS];
+static unsigned int glyph_cache_clock;
+
+static const unsigned char *corebootfb_glyph_rows(unsigned char bg, unsigned char fg)
+{
+	const unsigned int attr = (bg << 4 | fg) + 1;
+	const int bytes = fbinfo.bits_per_pixel >> 3;
+	const int span = font_width * bytes;
+	int i, lru = 0, x, b;
+
+	if (fbinfo.bits_per_pixel != 8 && fbinfo.bits_per_pixel != 16 &&
+	    fbinfo.bits_per_pixel != 24 && fbinfo.bits_per_pixel != 32)
+		return NULL;
+
+	for (i = 0; i < GLYPH_CACHE_COLORS; i++) {
+		if (glyph_cache[i].attr == attr) {
+			glyph_cache[i].last_use = ++glyph_cache_clock;
+			return glyph_cache[i].rows;
+		}
+		if (glyph_cache[i].last_use < glyph_cache[lru].last_use)
+			lru = i;
+	}
+
+	if (!glyph_cache[lru].rows) {
+		glyph_cache[lru].rows = malloc(256 * span);
+		if (!glyph_cache[lru].rows)
+			return NULL;
+	}
+
+	const u32 fgval = corebootfb_color(fg);
+	const u32 bgval = corebootfb_color(bg);
+	for (i = 0; i < 256; i++) {
+		unsigned char *const dst = glyph_cache[lru].rows + i * span;
+		/* Same pixel order as the font_glyph_filled() loop below. */
+		for (x = font_width - 1; x >= 0; x--) {
+			const u32 val = (i & (1 << x / font_scale)) ? fgval : bgval;
+			for (b = 0; b < bytes; b++)
+				dst[(font_width - 1 - x) * bytes + b] = val >> (b * 8);
+		}
+	}
+
+	glyph_cache[lru].attr = attr;
+	glyph_cache[lru].last_use = ++glyph_cache_clock;
+	return glyph_cache[lru].rows;
+}
+
 static void corebootfb_putchar(u8 row, u8 col, unsigned int ch)
 {
 	unsigned char *dst;
@@ -129,18 +162,27 @@ static void corebootfb_putchar(u8 row, u8 col, unsigned int ch)
 
 	int x, y;
 
-	if (fbinfo.bits_per_pixel > 8) {
-		bgval = ((((vga_colors[bg] >> 0) & 0xff) >> (8 - fbinfo.blue_mask_size)) << fbinfo.blue_mask_pos) |
-			((((vga_colors[bg] >> 8) & 0xff) >> (8 - fbinfo.green_mask_size)) << fbinfo.green_mask_pos) |
-			((((vga_colors[bg] >> 16) & 0xff) >> (8 - fbinfo.red_mask_size)) << fbinfo.red_mask_pos);
-		fgval = ((((vga_colors[fg] >> 0) & 0xff) >> (8 - fbinfo.blue_mask_size)) << fbinfo.blue_mask_pos) |
-			((((vga_colors[fg] >> 8) & 0xff) >> (8 - fbinfo.green_mask_size)) << fbinfo.green_mask_pos) |
-			((((vga_colors[fg] >> 16) & 0xff) >> (8 - fbinfo.red_mask_size)) << fbinfo.red_mask_pos);
-	}
-
 	dst = FB + ((row * font_height) * fbinfo.bytes_per_line);
 	dst += (col * font_width * (fbinfo.bits_per_pixel >> 3));
 
+	const unsigned char *const rows = corebootfb_glyph_rows(bg, fg);
+	if (rows) {
+		const unsigned char *const glyph = font8x16 + ((ch & 0xFF) * FONT_HEIGHT);
+		const int span = font_width * (fbinfo.bits_per_pixel >> 3);
+
+		for (y = 0; y < font_height; y++) {
+			memcpy(dst + (fbinfo.bits_per_pixel >> 3),
+			       rows + glyph[y / font_scale] * span, span);
+			dst += fbinfo.bytes_per_line;
+		}
+		return;
+	}
+
+	if (fbinfo.bits_per_pixel > 8) {
+		bgval = corebootfb_color(bg);
+		fgval = corebootfb_color(fg);
+	}
+
 	for(y = 0; y < font_height; y++) {
 		for(x = font_width - 1; x >= 0; x--) {
 
@@ -194,6 +236,40 @@ static void corebootfb_update_cursor(void)
 		corebootfb_putchar(cursor_y, cursor_x, paint);
 }
 
+/*
+ * Reading back the framebuffer is very slow, so scroll by repainting the cells
+ * that differ from the ones below them from the char buffer instead.
+ */
+static void corebootfb_scroll_up(void)
+{
+	const int columns = coreboot_video_console.columns;
+	const int rows = coreboot_video_console.rows;
+	int row, column;
+
+	/* Take the cursor off the screen, so every cell shows its char. */
+	if (cursor_en && cursor_y < rows)
+		corebootfb_putchar(cursor_y, cursor_x,
+				   chars[cursor_y * columns + cursor_x]);
+
+	for (row = 0; row < rows; row++) {
+		for (column = 0; column < columns; column++) {
+			unsigned short *const cell = &chars[row * columns + column];
+			const unsigned short next = row < rows - 1 ?
+				cell[columns] : (VGA_COLOR_DEFAULT << 8);
+
+			if (*cell != next) {
+				*cell = next;
+				corebootfb_putchar(row, column, next);
+			}
+		}
+	}
+
+	cursor_y--;
+
+	if (cursor_en)
+		corebootfb_update_cursor();
+}
+
 static void corebootfb_enable_cursor(int state)
 {
 	cursor_en = state;
@@ -43,6 +43,17 @@ static struct rect screen;
 
 static uint8_t *gfx_buffer;
 
+/*
+ * Bytes of each framebuffer line that changed in gfx_buffer since the last
+ * flush. A line is clean if end is 0.
+ */
+struct dirty_span {
+	int start;
+	int end;
+};
+static struct dirty_span *dirty_lines;
+static int dirty_first, dirty_last;	/* range of dirty lines, empty if first > last */
+
 /*
  * Framebuffer is assumed to assign a higher coordinate (larger x, y) to
  * a higher address
@@ -79,6 +90,9 @@ struct color_mapping {
 
 static struct color_mapping color_map;
 
+/* Changes whenever the colors calculate_color() returns change. */
+static uint32_t color_generation;
+
 static inline void set_color_trans(struct color_transformation *trans,
 				   uint8_t bg_color, uint8_t fg_color)
 {
@@ -97,6 +111,7 @@ int set_color_map(const struct rgb_color *background,
 			foreground->green);
 	set_color_trans(&color_map.blue, background->blue, foreground->blue);
 	color_map.enabled = 1;
+	color_generation++;
 
 	return CBGFX_SUCCESS;
 }
@@ -104,6 +119,7 @@ int set_color_map(const struct rgb_color *background,
 void clear_color_map(void)
 {
 	color_map.enabled = 0;
+	color_generation++;
 }
 
 struct blend_value {
@@ -120,6 +136,7 @@ int set_blend(const struct rgb_color *rgb, uint8_t alpha)
 
 	blend.alpha = alpha;
 	blend.rgb = *rgb;
+	color_generation++;
 
 	return CBGFX_SUCCESS;
 }
@@ -130,6 +147,7 @@ void clear_blend(void)
 	blend.rgb.red = 0;
 	blend.rgb.green = 0;
 	blend.rgb.blue = 0;
+	color_generation++;
 }
 
 static void add_vectors(struct vector *out,
@@ -305,6 +323,152 @@ static inline void set_pixel(struct vector *coord, uint32_t color)
 		pixel[i] = (color >> (i * 8));
 }
 
+/*
+ * Record that the screen area from |top_left| to |bottom_right| (exclusive)
+ * will be drawn to, so flush_graphics_buffer() copies it.
+ */
+static void mark_dirty(const struct vector *top_left,
+		       const struct vector *bottom_right)
+{
+	const int bpp = fbinfo->bits_per_pixel;
+	int x0, x1, y0, y1, y;
+
+	if (!gfx_buffer)
+		return;
+
+	switch (fbinfo->orientation) {
+	case CB_FB_ORIENTATION_NORMAL:
+	default:
+		x0 = top_left->x;
+		x1 = bottom_right->x;
+		y0 = top_left->y;
+		y1 = bottom_right->y;
+		break;
+	case CB_FB_ORIENTATION_BOTTOM_UP:
+		x0 = screen.size.width - bottom_right->x;
+		x1 = screen.size.width - top_left->x;
+		y0 = screen.size.height - bottom_right->y;
+		y1 = screen.size.height - top_left->y;
+		break;
+	case CB_FB_ORIENTATION_LEFT_UP:
+		x0 = top_left->y;
+		x1 = bottom_right->y;
+		y0 = screen.size.width - bottom_right->x;
+		y1 = screen.size.width - top_left->x;
+		break;
+	case CB_FB_ORIENTATION_RIGHT_UP:
+		x0 = screen.size.height - bottom_right->y;
+		x1 = screen.size.height - top_left->y;
+		y0 = top_left->x;
+		y1 = bottom_right->x;
+		break;
+	}
+
+	x0 = MAX(x0, 0);
+	y0 = MAX(y0, 0);
+	x1 = MIN(x1, (int)fbinfo->x_resolution);
+	y1 = MIN(y1, (int)fbinfo->y_resolution);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	x0 = x0 * bpp / 8;
+	x1 = x1 * bpp / 8;
+	for (y = y0; y < y1; y++) {
+		struct dirty_span *const span = &dirty_lines[y];
+		if (!span->end) {
+			span->start = x0;
+			span->end = x1;
+		} else {
+			span->start = MIN(span->start, x0);
+			span->end = MAX(span->end, x1);
+		}
+	}
+	dirty_first = MIN(dirty_first, y0);
+	dirty_last = MAX(dirty_last, y1 - 1);
+}
+
+/* Fill |count| 32-bit pixels, storing two of them at a time. */
+static void fill_pixels32(uint32_t *dst, uint32_t color, size_t count)
+{
+	const uint64_t color2 = (uint64_t)color << 32 | color;
+	uint64_t *dst2;
+
+	if (((uintptr_t)dst & 4) && count) {
+		*dst++ = color;
+		count--;
+	}
+	for (dst2 = (uint64_t *)dst; count >= 2; count -= 2)
+		*dst2++ = color2;
+	if (count)
+		*(uint32_t *)dst2 = color;
+}
+
+/*
+ * Return the framebuffer address of the pixels x_begin to x_end - 1 of screen
+ * row |y| if they are stored contiguously as 32-bit pixels, or NULL. The
+ * pixels are stored in reverse order if the screen is upside down.
+ */
+static uint32_t *span_address(int32_t y, int32_t x_begin, int32_t x_end)
+{
+	const int bpl = fbinfo->bytes_per_line;
+
+	if (fbinfo->bits_per_pixel != 32)
+		return NULL;
+
+	switch (fbinfo->orientation) {
+	case CB_FB_ORIENTATION_NORMAL:
+	default:
+		return (uint32_t *)(FB + y * bpl) + x_begin;
+	case CB_FB_ORIENTATION_BOTTOM_UP:
+		return (uint32_t *)(FB + (screen.size.height - 1 - y) * bpl) +
+			screen.size.width - x_end;
+	case CB_FB_ORIENTATION_LEFT_UP:
+	case CB_FB_ORIENTATION_RIGHT_UP:
+		return NULL;
+	}
+}
+
+/* Fill the pixels x_begin to x_end - 1 of screen row |y| with |color|. */
+static void fill_span(int32_t y, int32_t x_begin, int32_t x_end, uint32_t color)
+{
+	struct vector p;
+
+	if (x_begin >= x_end)
+		return;
+
+	uint32_t *const pixel = span_address(y, x_begin, x_end);
+	if (pixel) {
+		fill_pixels32(pixel, color, x_end - x_begin);
+		return;
+	}
+
+	p.y = y;
+	for (p.x = x_begin; p.x < x_end; p.x++)
+		set_pixel(&p, color);
+}
+
+/* Copy |count| pixels in framebuffer format to screen row |y| from x_begin. */
+static void blit_span(int32_t y, int32_t x_begin, const uint32_t *colors,
+		      int32_t count)
+{
+	struct vector p;
+	int32_t i;
+
+	uint32_t *const pixel = span_address(y, x_begin, x_begin + count);
+	if (pixel && fbinfo->orientation == CB_FB_ORIENTATION_BOTTOM_UP) {
+		for (i = 0; i < count; i++)
+			pixel[count - 1 - i] = colors[i];
+		return;
+	} else if (pixel) {
+		memcpy(pixel, colors, count * sizeof(*colors));
+		return;
+	}
+
+	p.y = y;
+	for (i = 0, p.x = x_begin; i < count; i++, p.x++)
+		set_pixel(&p, colors[i]);
+}
+
 /*
  * Initializes the library. Automatically called by APIs. It sets up
  * the canvas and the framebuffer.
@@ -379,9 +543,9 @@ int draw_box(const struct rect *box, const struct rgb_color *rgb)
 		return CBGFX_ERROR_BOUNDARY;
 	}
 
+	mark_dirty(&top_left, &t);
 	for (p.y = top_left.y; p.y < t.y; p.y++)
-		for (p.x = top_left.x; p.x < t.x; p.x++)
-			set_pixel(&p, color);
+		fill_span(p.y, top_left.x, t.x, color);
 
 	return CBGFX_SUCCESS;
 }
@@ -442,24 +606,22 @@ int draw_rounded_box(const struct scale *pos_rel, const struct scale *dim_rel,
 		}
 	}
 
+	mark_dirty(&top_left, &t);
+
 	/* Step 1: Draw edges */
 	int32_t x_begin, x_end;
 	if (has_thickness) {
 		/* top */
 		for (p.y = top_left.y; p.y < top_left.y + d.y; p.y++)
-			for (p.x = top_left.x + r.x; p.x < t.x - r.x; p.x++)
-				set_pixel(&p, color);
+			fill_span(p.y, top_left.x + r.x, t.x - r.x, color);
 		/* bottom */
 		for (p.y = t.y - d.y; p.y < t.y; p.y++)
-			for (p.x = top_left.x + r.x; p.x < t.x - r.x; p.x++)
-				set_pixel(&p, color);
+			fill_span(p.y, top_left.x + r.x, t.x - r.x, color);
 		for (p.y = top_left.y + r.y; p.y < t.y - r.y; p.y++) {
 			/* left */
-			for (p.x = top_left.x; p.x < top_left.x + d.x; p.x++)
-				set_pixel(&p, color);
+			fill_span(p.y, top_left.x, top_left.x + d.x, color);
 			/* right */
-			for (p.x = t.x - d.x; p.x < t.x; p.x++)
-				set_pixel(&p, color);
+			fill_span(p.y, t.x - d.x, t.x, color);
 		}
 	} else {
 		/* Fill the regions except circular sectors */
@@ -471,8 +633,7 @@ int draw_rounded_box(const struct scale *pos_rel, const struct scale *dim_rel,
 				x_begin = top_left.x + r.x;
 				x_end = t.x - r.x;
 			}
-			for (p.x = x_begin; p.x < x_end; p.x++)
-				set_pixel(&p, color);
+			fill_span(p.y, x_begin, x_end, color);
 		}
 	}
 
@@ -591,9 +752,9 @@ int draw_line(const struct scale *pos1, const struct scale *pos2,
 		return CBGFX_ERROR_BOUNDARY;
 	}
 
+	mark_dirty(&top_left, &t);
 	for (p.y = top_left.y; p.y < t.y; p.y++)
-		for (p.x = top_left.x; p.x < t.x; p.x++)
-			set_pixel(&p, color);
+		fill_span(p.y, top_left.x, t.x, color);
 
 	return CBGFX_SUCCESS;
 }
@@ -630,6 +791,8 @@ int clear_screen(const struct rgb_color *rgb)
 		return CBGFX_ERROR_UNKNOWN;
 	}
 
+	mark_dirty(&screen.offset, &screen.size);
+
 	/* Set line buffer pixels, then memcpy to framebuffer */
 	for (x = 0; x < fbinfo->x_resolution; x++)
 		for (i = 0; i < bpp / 8; i++)
@@ -738,6 +901,131 @@ static fpmath_t lanczos_weight(fpmath_t in, int off)
 	return fpdiv(fpmul(tmp, fpsin1(x2a)), x_times_pi);
 }
 
+/*
+ * Resampled bitmaps, ready to be copied to the screen. An entry matches if the
+ * source pixels and palette still have the same contents and the colors were
+ * calculated with the same color map and blend values.
+ */
+#define BITMAP_CACHE_ENTRIES	16
+
+struct cached_bitmap {
+	const uint8_t *pixel_array;
+	uint32_t checksum;
+	struct vector dim_org;
+	struct vector dim;
+	int32_t height;		/* from the header, for the row order */
+	uint8_t invert;
+	uint32_t color_generation;
+	uint32_t last_use;
+	uint32_t *pixels;	/* dim.width * dim.height, top row first */
+};
+
+static struct cached_bitmap bitmap_cache[BITMAP_CACHE_ENTRIES];
+static size_t bitmap_cache_bytes;
+static uint32_t bitmap_cache_clock;
+
+static uint32_t bitmap_checksum(const void *data, size_t size, uint32_t hash)
+{
+	const uint8_t *const bytes = data;
+	size_t i;
+
+	/* FNV-1a */
+	for (i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 16777619;
+	return hash;
+}
+
+static void free_cached_bitmap(struct cached_bitmap *entry)
+{
+	if (!entry->pixels)
+		return;
+
+	bitmap_cache_bytes -= entry->dim.width * entry->dim.height *
+			      sizeof(*entry->pixels);
+	free(entry->pixels);
+	entry->pixels = NULL;
+}
+
+void clear_bitmap_cache(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bitmap_cache); i++)
+		free_cached_bitmap(&bitmap_cache[i]);
+}
+
+static struct cached_bitmap *find_cached_bitmap(const struct cached_bitmap *key)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bitmap_cache); i++) {
+		struct cached_bitmap *const entry = &bitmap_cache[i];
+		if (entry->pixels &&
+		    entry->pixel_array == key->pixel_array &&
+		    entry->checksum == key->checksum &&
+		    entry->dim_org.width == key->dim_org.width &&
+		    entry->dim_org.height == key->dim_org.height &&
+		    entry->dim.width == key->dim.width &&
+		    entry->dim.height == key->dim.height &&
+		    entry->height == key->height &&
+		    entry->invert == key->invert &&
+		    entry->color_generation == key->color_generation) {
+			entry->last_use = ++bitmap_cache_clock;
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* Take ownership of |pixels| if they fit into the cache, evicting old entries. */
+static void add_cached_bitmap(const struct cached_bitmap *key, uint32_t *pixels)
+{
+	const size_t budget = CONFIG_LP_CBGFX_BITMAP_CACHE_KB * KiB;
+	const size_t bytes = key->dim.width * key->dim.height * sizeof(*pixels);
+	struct cached_bitmap *slot, *lru;
+	int i;
+
+	if (bytes > budget) {
+		free(pixels);
+		return;
+	}
+
+	/* Drop the least recently used entries until there is room. */
+	for (;;) {
+		slot = NULL;
+		lru = NULL;
+		for (i = 0; i < ARRAY_SIZE(bitmap_cache); i++) {
+			struct cached_bitmap *const entry = &bitmap_cache[i];
+			if (!entry->pixels) {
+				if (!slot)
+					slot = entry;
+			} else if (!lru || entry->last_use < lru->last_use) {
+				lru = entry;
+			}
+		}
+		if (slot && bitmap_cache_bytes + bytes <= budget)
+			break;
+		free_cached_bitmap(lru);
+	}
+
+	*slot = *key;
+	slot->pixels = pixels;
+	slot->last_use = ++bitmap_cache_clock;
+	bitmap_cache_bytes += bytes;
+}
+
+static void blit_cached_bitmap(const struct vector *top_left,
+			       const struct cached_bitmap *entry)
+{
+	int32_t y;
+
+	for (y = 0; y < entry->dim.height; y++)
+		blit_span(top_left->y + y, top_left->x,
+			  &entry->pixels[y * entry->dim.width],
+			  entry->dim.width);
+}
+
 static int draw_bitmap_v3(const struct vector *top_left,
 			  const struct vector *dim,
 			  const struct vector *dim_org,
@@ -765,6 +1053,12 @@ static int draw_bitmap_v3(const struct vector *top_left,
 		return CBGFX_ERROR_BITMAP_FORMAT;
 	}
 
+	const struct vector bottom_right = {
+		.x = top_left->x + dim->width,
+		.y = top_left->y + dim->height,
+	};
+	mark_dirty(top_left, &bottom_right);
+
 	const int32_t y_stride = ROUNDUP(dim_org->width * bpp / 8, 4);
 	/*
 	 * header->height can be positive or negative.
@@ -783,26 +1077,75 @@ static int draw_bitmap_v3(const struct vector *top_left,
 		dir = -1;
 	}
 
-	/* Don't waste time resampling when the scale is 1:1. */
+	/*
+	 * Don't waste time resampling when the scale is 1:1. Convert the
+	 * palette once and copy whole rows to the framebuffer.
+	 */
 	if (dim_org->width == dim->width && dim_org->height == dim->height) {
+		const size_t palcount = MIN(header->colors_used, 256U);
+		uint32_t colors[256];
+		size_t i;
+
+		for (i = 0; i < palcount; i++) {
+			struct rgb_color rgb;
+			pal_to_rgb(i, pal, palcount, &rgb);
+			colors[i] = calculate_color(&rgb, invert);
+		}
+
+		uint32_t *const row = malloc(dim->width * sizeof(*row));
+		if (!row)
+			return CBGFX_ERROR_UNKNOWN;
+
 		for (oy = 0; oy < dim->height; oy++, p.y += dir) {
-			p.x = top_left->x;
-			for (ox = 0; ox < dim->width; ox++, p.x++) {
-				struct rgb_color rgb;
-				if (pal_to_rgb(pixel_array[oy * y_stride + ox],
-					       pal, header->colors_used, &rgb))
+			const uint8_t *const line = &pixel_array[oy * y_stride];
+			for (ox = 0; ox < dim->width; ox++) {
+				if (line[ox] >= palcount) {
+					LOG("Color index %d exceeds palette boundary\n",
+					    line[ox]);
+					free(row);
 					return CBGFX_ERROR_BITMAP_DATA;
-				set_pixel(&p, calculate_color(&rgb, invert));
+				}
+				row[ox] = colors[line[ox]];
 			}
+			blit_span(p.y, top_left->x, row, dim->width);
 		}
+		free(row);
 		return CBGFX_SUCCESS;
 	}
 
+	struct cached_bitmap key = {
+		.pixel_array = pixel_array,
+		.dim_org = *dim_org,
+		.dim = *dim,
+		.height = header->height,
+		.invert = invert,
+		.color_generation = color_generation,
+	};
+	uint32_t *surface = NULL;
+
+	/* Resample into a surface that is kept for the next draw. */
+	if (CONFIG_LP_CBGFX_BITMAP_CACHE_KB) {
+		key.checksum = bitmap_checksum(pixel_array,
+					       y_stride * dim_org->height,
+					       2166136261);
+		key.checksum = bitmap_checksum(pal,
+					       header->colors_used * sizeof(*pal),
+					       key.checksum);
+		const struct cached_bitmap *entry = find_cached_bitmap(&key);
+		if (entry) {
+			blit_cached_bitmap(top_left, entry);
+			return CBGFX_SUCCESS;
+		}
+		surface = malloc(dim->width * dim->height * sizeof(*surface));
+	}
+
 	/* Precalculate the X-weights for every possible ox so that we only have
 	   to multiply weights together in the end. */
 	fpmath_t (*weight_x)[SSZ] = malloc(sizeof(fpmath_t) * SSZ * dim->width);
-	if (!weight_x)
+	if (!weight_x) {
+		free(surface);
 		return CBGFX_ERROR_UNKNOWN;
+	}
 	for (ox = 0; ox < dim->width; ox++) {
 		for (sx = 0; sx < SSZ; sx++) {
 			fpmath_t ixfp = fpfrac(ox * dim_org->width, dim->width);
@@ -891,6 +1234,8 @@ static int draw_bitmap_v3(const struct vector *top_left,
 			}
 		}
 
+		uint32_t *const out = surface ?
+			&surface[(p.y - top_left->y) * dim->width] : NULL;
 		ix = 0;
 		p.x = top_left->x;
 		for (ox = 0; ox < dim->width; ox++, p.x++) {
@@ -934,8 +1279,12 @@ static int draw_bitmap_v3(const struct vector *top_left,
 
 			/* If all pixels in sample are equal, fast path. */
 			if (equals >= (SSZ * SSZ)) {
-				set_pixel(&p, calculate_color(&sample[0][0],
-							      invert));
+				const uint32_t color =
+					calculate_color(&sample[0][0], invert);
+				if (out)
+					out[ox] = color;
+				else
+					set_pixel(&p, color);
 				continue;
 			}
 
@@ -967,15 +1316,25 @@ static int draw_bitmap_v3(const struct vector *top_left,
 				.blue = MAX(0, MIN(UINT8_MAX, fpround(blue))),
 			};
 
-			set_pixel(&p, calculate_color(&rgb, invert));
+			const uint32_t color = calculate_color(&rgb, invert);
+			if (out)
+				out[ox] = color;
+			else
+				set_pixel(&p, color);
 		}
 	}
 
 	free(weight_x);
+	if (surface) {
+		key.pixels = surface;
+		blit_cached_bitmap(top_left, &key);
+		add_cached_bitmap(&key, surface);
+	}
 	return CBGFX_SUCCESS;
 
 bitmap_error:
 	free(weight_x);
+	free(surface);
 	return CBGFX_ERROR_BITMAP_DATA;
 }
 
@@ -1272,21 +1631,41 @@ int enable_graphics_buffer(void)
 
 	size_t buffer_size = fbinfo->y_resolution * fbinfo->bytes_per_line;
 	gfx_buffer = malloc(buffer_size);
-	if (!gfx_buffer) {
+	dirty_lines = calloc(fbinfo->y_resolution, sizeof(*dirty_lines));
+	if (!gfx_buffer || !dirty_lines) {
 		LOG("%s: Failed to create graphics buffer (%zu bytes).\n",
 		    __func__, buffer_size);
+		disable_graphics_buffer();
 		return CBGFX_ERROR_GRAPHICS_BUFFER;
 	}
+	dirty_first = fbinfo->y_resolution;
+	dirty_last = -1;
 
 	return CBGFX_SUCCESS;
 }
 
 int flush_graphics_buffer(void)
 {
+	int y;
+
 	if (!gfx_buffer)
 		return CBGFX_ERROR_GRAPHICS_BUFFER;
 
-	memcpy(REAL_FB, gfx_buffer, fbinfo->y_resolution * fbinfo->bytes_per_line);
+	const int bpl = fbinfo->bytes_per_line;
+
+	/* Only copy what was drawn since the last flush. */
+	for (y = dirty_first; y <= dirty_last; y++) {
+		struct dirty_span *const span = &dirty_lines[y];
+		if (!span->end)
+			continue;
+		memcpy(REAL_FB + y * bpl + span->start,
+		       gfx_buffer + y * bpl + span->start,
+		       span->end - span->start);
+		span->end = 0;
+	}
+	dirty_first = fbinfo->y_resolution;
+	dirty_last = -1;
+
 	return CBGFX_SUCCESS;
 }
 
@@ -1294,4 +1673,6 @@ void disable_graphics_buffer(void)
 {
 	free(gfx_buffer);
 	gfx_buffer = NULL;
+	free(dirty_lines);
+	dirty_lines = NULL;
 }
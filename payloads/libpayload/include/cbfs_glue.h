@@ -10,6 +10,8 @@
 
 #define CBFS_ENABLE_HASHING CONFIG(LP_CBFS_VERIFICATION)
 #define CBFS_HASH_HWCRYPTO cbfs_hwcrypto_allowed()
+/* libpayload only consumes mcaches built by coreboot, an existing index is always used. */
+#define CBFS_MCACHE_HASH_INDEX 0
 
 #define ERROR(...) printf("CBFS ERROR: " __VA_ARGS__)
 #define LOG(...) printf("CBFS: " __VA_ARGS__)
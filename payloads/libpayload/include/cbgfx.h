@@ -295,3 +295,8 @@ int flush_graphics_buffer(void);
  * Stop using buffered I/O and release allocated memory.
  */
 void disable_graphics_buffer(void);
+
+/**
+ * Release the memory of all images kept by CONFIG_LP_CBGFX_BITMAP_CACHE_KB.
+ */
+void clear_bitmap_cache(void);
@@ -269,6 +269,9 @@ struct cb_pcie {
 	uint32_t tag;
 	uint32_t size;
 	cb_uint64_t ctrl_base;	/* Base address of PCIe controller */
+	/* Not present in tables of older coreboot versions */
+	cb_uint64_t ecam_base;	/* ECAM window of segment 0, 0 if there is none */
+	cb_uint64_t ecam_size;
 };
 
 struct lb_range {
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef _COROUTINE_H_
+#define _COROUTINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Cooperative coroutines, each running on its own stack. A coroutine only gives up the CPU
+ * when it calls coroutine_yield() or one of the helpers below, so nothing needs locking.
+ * Drivers that wait for hardware can use coroutine_await() instead of spinning and let
+ * other work run in the meantime, e.g. decompress or hash data while a disk read is
+ * pending. There is no preemption and everything runs on the one CPU.
+ */
+
+struct coroutine {
+	/* Private, set up by coroutine_start() */
+	struct coroutine *next;
+	uintptr_t sp;
+	uintptr_t stack_top;
+	void *stack;
+	void (*func)(void *arg);
+	void *arg;
+	int state;
+};
+
+/*
+ * Set up co to run func(arg) on a stack of stack_size bytes from the heap. It starts at
+ * the next yield of the caller. Returns 0 on success, -1 if the stack can't be allocated.
+ */
+int coroutine_start(struct coroutine *co, void (*func)(void *arg), void *arg,
+		    size_t stack_size);
+
+/* Let the other coroutines run, returns once it's the caller's turn again. */
+void coroutine_yield(void);
+
+/* Yield until co has returned, then free its stack. */
+void coroutine_join(struct coroutine *co);
+
+/* Returns non-zero if the coroutine has returned. */
+int coroutine_done(const struct coroutine *co);
+
+/*
+ * Yield until poll(arg) returns non-zero. Returns 0 then or -1 if that didn't happen
+ * within timeout_us microseconds. A timeout of 0 waits forever.
+ */
+int coroutine_await(int (*poll)(void *arg), void *arg, uint64_t timeout_us);
+
+/* Like udelay(), but lets the other coroutines run in the meantime. */
+void coroutine_udelay(unsigned int us);
+
+#endif /* _COROUTINE_H_ */
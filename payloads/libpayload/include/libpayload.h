@@ -235,6 +235,15 @@ void serial_console_init(void);
 void serial_putchar(unsigned int c);
 int serial_havechar(void);
 int serial_getchar(void);
+#if CONFIG(LP_8250_SERIAL_CONSOLE)
+/* Move buffered output into the UART as far as it fits, without waiting. */
+void serial_poll(void);
+/* Wait until all buffered output went to the UART, e.g. before booting a kernel. */
+void serial_flush(void);
+#else
+static inline void serial_poll(void) {}
+static inline void serial_flush(void) {}
+#endif
 void serial_clear(void);
 void serial_start_bold(void);
 void serial_end_bold(void);
@@ -29,6 +29,8 @@
 #ifndef _LZMA_H
 #define _LZMA_H
 
+#include <stddef.h>
+
 /* Decompresses the data stream at src to dst. The sizes of the source and
  * destination buffers are in srcn and dstn.
  *
@@ -44,4 +46,42 @@ unsigned long ulzman(const unsigned char *src, unsigned long srcn,
  */
 unsigned long ulzma(const unsigned char *src, unsigned char *dst);
 
+/* Same as ulzman() for input that only becomes valid piece by piece (e.g. while a
+ * background DMA transfer is still loading it). Before reading past what it has seen,
+ * the decoder calls wait(arg, needed), which must block until at least needed bytes from
+ * the start of src are valid and then return the amount of valid bytes.
+ */
+unsigned long ulzman_wait(const unsigned char *src, unsigned long srcn,
+			  unsigned char *dst, unsigned long dstn,
+			  size_t (*wait)(void *arg, size_t needed), void *arg);
+
+/* Scratchpad size the decoder needs for the probability tables of a stream whose
+ * lc and lp properties add up to lclp. cbfstool uses lc=1 and lp=0. */
+#define LZMA_SCRATCHPAD_SIZE_FOR(lclp) ((1846 + (768 << (lclp))) * 2)
+
+/* LZMA decoder with a fixed memory footprint, for input that can't be mapped as
+ * a whole or output that doesn't fit into memory at once:
+ *
+ *   read       - returns the next piece of compressed input in *buf and its size,
+ *                0 at the end. A piece has to stay valid until the next call.
+ *   write      - optional, consumes size decompressed bytes at the start of the
+ *                window before it wraps around and once more at the end. Returns
+ *                0 on success. Without it the window is the destination buffer.
+ *   window     - ring buffer for the output. Matches can only reach back this far.
+ *   scratchpad - probability tables, see LZMA_SCRATCHPAD_SIZE_FOR().
+ *
+ * Returns the decompressed size, or 0 on error
+ */
+struct ulzma_stream {
+	size_t (*read)(void *arg, const void **buf);
+	int (*write)(void *arg, const void *buf, size_t size);
+	void *arg;
+	void *window;
+	size_t window_size;
+	void *scratchpad;
+	size_t scratchpad_size;
+};
+
+size_t ulzman_stream(const struct ulzma_stream *stream);
+
 #endif
@@ -42,6 +42,8 @@
 void *realloc(void *ptr, size_t size);
 void *dma_malloc(size_t size);
 void *dma_memalign(size_t align, size_t size);
+/* Print heap usage and the size-class statistics of small allocations. */
+void print_malloc_stats(void);
 
 #if CONFIG(LP_DEBUG_MALLOC) && !defined(IN_MALLOC_C)
 #include <stdio.h>
@@ -135,6 +137,31 @@ void init_dma_memory(void *start, u32 size);
 int dma_initialized(void);
 void dma_allocator_range(void **start_out, size_t *size_out);
 
+#if CONFIG(LP_DMA_CACHED)
+/*
+ * Streaming DMA to or from a cacheable buffer outside of the DMA heap.
+ * dma_map_cached() does the cache maintenance needed before the transfer and
+ * returns whether the device can use buf directly, otherwise the caller has to
+ * copy through DMA memory. dma_unmap_cached() must follow once it is done.
+ */
+int dma_map_cached(void *buf, size_t len, int from_device);
+void dma_unmap_cached(void *buf, size_t len, int from_device);
+#else
+static inline int dma_map_cached(void *buf, size_t len, int from_device)
+{
+	(void)buf;
+	(void)len;
+	(void)from_device;
+	return 0;
+}
+static inline void dma_unmap_cached(void *buf, size_t len, int from_device)
+{
+	(void)buf;
+	(void)len;
+	(void)from_device;
+}
+#endif
+
 /** @} */
 
 /**
@@ -37,6 +37,7 @@
 enum {
 	ATA_READ_DMA			= 0xc8,
 	ATA_READ_DMA_EXT		= 0x25,
+	ATA_READ_FPDMA_QUEUED		= 0x60,
 	ATA_IDENTIFY_DEVICE		= 0xec,
 	ATA_PACKET			= 0xa0,
 	ATA_IDENTIFY_PACKET_DEVICE	= 0xa1,
@@ -44,6 +45,8 @@ enum {
 
 /* 16-bit-word indices into id structure from ATA_IDENTIFY_DEVICE */
 enum {
+	ATA_ID_QUEUE_DEPTH		=  75,
+	ATA_ID_SATA_CAPS		=  76,
 	ATA_CMDS_AND_FEATURE_SETS	=  82,
 	ATA_ID_SECTOR_SIZE		= 106,
 	ATA_ID_LOGICAL_SECTOR_SIZE	= 117,
@@ -63,6 +66,11 @@ typedef struct ata_dev {
 	size_t sector_size;
 	size_t sector_size_shift;
 
+	/* Optional NCQ support, used for asynchronous reads of 512 byte sectors */
+	unsigned int ncq_depth;
+	int (*read_sectors_async)(struct ata_dev *, struct storage_request *);
+	int (*poll_request)(struct ata_dev *, struct storage_request *);
+
 	void (*detach_device)(struct ata_dev *);
 } ata_dev_t;
 
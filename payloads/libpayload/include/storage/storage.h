@@ -55,6 +55,46 @@ typedef enum {
 
 struct storage_dev;
 
+/* One contiguous piece of the buffer of a request, in blocks of 512 bytes. */
+struct storage_sg {
+	unsigned char *buf;
+	size_t count;
+};
+
+/*
+ * An asynchronous read request. The caller fills in the arguments and
+ * submits it with storage_submit_request(), or lets
+ * storage_read_blocks512_async() do both for a single buffer. The request
+ * and its buffers have to stay around until it is finished.
+ *
+ * `complete` is called from storage_poll_requests() (or one of the other
+ * polling functions) once all data arrived or the request failed. It may
+ * submit new requests.
+ */
+struct storage_request {
+	lba_t start;
+	const struct storage_sg *sg;
+	size_t sg_count;
+	void (*complete)(struct storage_request *);
+	void *priv;		/* for the caller, untouched */
+
+	/* Set up on submission */
+	struct storage_dev *dev;
+	size_t count;		/* sum of all sg counts */
+	size_t result;		/* blocks read from `start` before the first error */
+
+	/* Driver state */
+	size_t next;		/* first block that was not submitted yet */
+	size_t seg, seg_off;	/* position of `next` in sg */
+	unsigned int inflight;	/* commands submitted but not completed */
+	int failed;
+
+	/* storage.c state */
+	struct storage_request *next_pending;
+	int finished;
+	struct storage_sg single;
+};
+
 typedef struct storage_dev {
 	storage_port_t port_type;
 
@@ -62,6 +102,10 @@ typedef struct storage_dev {
 	ssize_t (*read_blocks512)(struct storage_dev *, lba_t start, size_t count, unsigned char *buf);
 	ssize_t (*write_blocks512)(struct storage_dev *, lba_t start, size_t count, const unsigned char *buf);
 
+	/* Optional, storage.c falls back to read_blocks512() without them. */
+	int (*read_blocks512_async)(struct storage_dev *, struct storage_request *);
+	int (*poll_request)(struct storage_dev *, struct storage_request *);
+
 	void (*detach_device)(struct storage_dev *);
 } storage_dev_t;
 
@@ -71,4 +115,16 @@ int storage_attach_device(storage_dev_t *dev);
 storage_poll_t storage_probe(size_t dev_num);
 ssize_t storage_read_blocks512(size_t dev_num, lba_t start, size_t count, unsigned char *buf);
 
+int storage_submit_request(size_t dev_num, struct storage_request *req);
+int storage_read_blocks512_async(size_t dev_num, struct storage_request *req,
+				 lba_t start, size_t count, unsigned char *buf);
+int storage_poll_requests(void);
+int storage_poll_request(struct storage_request *req);
+ssize_t storage_wait_request(struct storage_request *req);
+
+/* For drivers */
+void storage_request_init(struct storage_request *req, storage_dev_t *dev);
+unsigned char *storage_request_take(struct storage_request *req,
+				    size_t max_blocks, size_t *blocks);
+
 #endif
@@ -43,6 +43,9 @@
 /* Maximum of 2 MMAP windows for decoding SPI flash. */
 #define SYSINFO_MAX_MMAP_WINDOWS 2
 
+/* Number of different coreboot table tags that can be indexed. */
+#define SYSINFO_MAX_CB_TAGS 64
+
 #include <coreboot_tables.h>
 
 /*
@@ -85,6 +88,8 @@ struct sysinfo_t {
 	uintptr_t assembler;
 	uintptr_t mem_chip_base;
 	uintptr_t pcie_ctrl_base; /* Base address of PCIe controller */
+	uintptr_t pcie_ecam_base; /* ECAM window of PCI segment 0, 0 if there is none */
+	uint64_t pcie_ecam_size;
 
 	uintptr_t cb_version;
 
@@ -101,6 +106,16 @@ struct sysinfo_t {
 	uintptr_t cb_header;
 	uintptr_t cb_mainboard;
 
+	/*
+	 * The first record of each tag in the coreboot table, sorted by tag. If the table
+	 * has more different tags than fit, num_cb_tags is -1 and lookups walk the table.
+	 */
+	int num_cb_tags;
+	struct {
+		u32 tag;
+		u32 offset;	/* From the start of the table header */
+	} cb_tags[SYSINFO_MAX_CB_TAGS];
+
 	uintptr_t vboot_workbuf;
 
 #if CONFIG(LP_ARCH_X86)
@@ -150,6 +165,7 @@ struct sysinfo_t {
 
 	/* Pointer to FMAP cache in CBMEM */
 	uintptr_t fmap_cache;
+	uint32_t fmap_cache_size;
 
 #if CONFIG(LP_PCI)
 	struct pci_access pacc;
@@ -180,4 +196,10 @@ int cb_parse_arch_specific(struct cb_record *rec, struct sysinfo_t *info);
  */
 int cb_parse_header(void *addr, int len, struct sysinfo_t *info);
 
+/*
+ * Return the first record with the given tag in the coreboot table that was parsed into
+ * lib_sysinfo, or NULL if there is none.
+ */
+struct cb_record *cb_find_record(u32 tag);
+
 #endif
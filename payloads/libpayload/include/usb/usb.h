@@ -227,6 +227,9 @@ struct usbdev {
 	void (*init) (usbdev_t *dev);
 	void (*destroy) (usbdev_t *dev);
 	void (*poll) (usbdev_t *dev);
+	/* poll() only consumes interrupt queues, so controllers with a
+	   poll_devices() hook may skip it while no data arrived. */
+	int poll_on_intr;
 };
 
 typedef enum { OHCI = 0, UHCI = 1, EHCI = 2, XHCI = 3, DWC2 = 4} hc_type;
@@ -255,11 +258,27 @@ struct usbdev_hc {
 	void (*shutdown) (hci_t *controller);
 
 	int (*bulk) (endpoint_t *ep, int size, u8 *data, int finalize);
+	/* bulk_queue():	Optional. Start a bulk transfer without waiting
+				for it. `data` has to be DMA coherent. Returns
+				0 on success and -1 if the transfer can't be
+				queued (right now). */
+	int (*bulk_queue) (endpoint_t *ep, int size, u8 *data);
+	/* bulk_dequeue():	Wait for the oldest transfer queued on `ep`.
+				Returns like bulk(). After an error, call
+				bulk_flush() before queuing again. */
+	int (*bulk_dequeue) (endpoint_t *ep);
+	/* bulk_flush():	Abort all transfers queued on `ep`. */
+	void (*bulk_flush) (endpoint_t *ep);
 	int (*control) (usbdev_t *dev, direction_t pid, int dr_length,
 			void *devreq, int data_length, u8 *data);
 	void* (*create_intr_queue) (endpoint_t *ep, int reqsize, int reqcount, int reqtiming);
 	void (*destroy_intr_queue) (endpoint_t *ep, void *queue);
 	u8* (*poll_intr_queue) (void *queue);
+	/* poll_devices():	Optional. Call poll() of the attached devices
+				that need it. Devices with `poll_on_intr` set
+				are only polled after one of their interrupt
+				queues received something. */
+	void (*poll_devices) (hci_t *controller);
 	void *instance;
 
 	/* set_address():		Tell the USB device its address (xHCI
@@ -38,6 +38,7 @@ libc-$(CONFIG_LP_LIBC) += hexdump.c
 libc-$(CONFIG_LP_LIBC) += coreboot.c
 libc-$(CONFIG_LP_LIBC) += fmap.c
 libc-$(CONFIG_LP_LIBC) += fpmath.c
+libc-$(CONFIG_LP_COROUTINES) += coroutine.c
 
 ifeq ($(CONFIG_LP_VBOOT_LIB),y)
 libc-$(CONFIG_LP_LIBC) += lp_vboot.c
@@ -45,6 +46,7 @@ endif
 
 ifeq ($(CONFIG_LP_LIBC),y)
 libc-srcs += $(coreboottop)/src/commonlib/bsd/elog.c
+libc-srcs += $(coreboottop)/src/commonlib/bsd/fmap_index.c
 libc-srcs += $(coreboottop)/src/commonlib/bsd/gcd.c
 libc-srcs += $(coreboottop)/src/commonlib/bsd/ipchksum.c
 libc-srcs += $(coreboottop)/src/commonlib/bsd/string.c
@@ -252,6 +252,7 @@ static void cb_parse_cbmem_entry(void *ptr, struct sysinfo_t *info)
 		break;
 	case CBMEM_ID_FMAP:
 		info->fmap_cache = cbmem_entry->address;
+		info->fmap_cache_size = cbmem_entry->entry_size;
 		break;
 	case CBMEM_ID_WIFI_CALIBRATION:
 		info->wifi_calibration = cbmem_entry->address;
@@ -278,6 +279,11 @@ static void cb_parse_pcie(void *ptr, struct sysinfo_t *info)
 	const struct cb_pcie *pcie = ptr;
 
 	info->pcie_ctrl_base = pcie->ctrl_base;
+	/* The window must be reachable through a pointer. */
+	if (pcie->size >= sizeof(*pcie) && (uintptr_t)pcie->ecam_base == pcie->ecam_base) {
+		info->pcie_ecam_base = pcie->ecam_base;
+		info->pcie_ecam_size = pcie->ecam_size;
+	}
 }
 
 static void cb_parse_rsdp(void *ptr, struct sysinfo_t *info)
@@ -286,6 +292,38 @@ static void cb_parse_rsdp(void *ptr, struct sysinfo_t *info)
 	info->acpi_rsdp = cb_acpi_rsdp->rsdp_pointer;
 }
 
+/* Adds the record to the tag index, unless an earlier one with the same tag is in there. */
+static void cb_index_record(struct sysinfo_t *info, const struct cb_record *rec, u32 offset)
+{
+	int lo = 0, hi = info->num_cb_tags;
+
+	if (info->num_cb_tags < 0)
+		return;
+
+	while (lo < hi) {
+		const int mid = lo + (hi - lo) / 2;
+
+		if (info->cb_tags[mid].tag < rec->tag)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < info->num_cb_tags && info->cb_tags[lo].tag == rec->tag)
+		return;
+
+	if (info->num_cb_tags == SYSINFO_MAX_CB_TAGS) {
+		info->num_cb_tags = -1;
+		return;
+	}
+
+	memmove(&info->cb_tags[lo + 1], &info->cb_tags[lo],
+		(info->num_cb_tags - lo) * sizeof(info->cb_tags[0]));
+	info->cb_tags[lo].tag = rec->tag;
+	info->cb_tags[lo].offset = offset;
+	info->num_cb_tags++;
+}
+
 int cb_parse_header(void *addr, int len, struct sysinfo_t *info)
 {
 	struct cb_header *header;
@@ -315,6 +353,7 @@ int cb_parse_header(void *addr, int len, struct sysinfo_t *info)
 		return -1;
 
 	info->cb_header = virt_to_phys(header);
+	info->num_cb_tags = 0;
 
 	/* Initialize IDs as undefined in case they don't show up in table. */
 	info->board_id = UNDEFINED_STRAPPING_ID;
@@ -328,6 +367,8 @@ int cb_parse_header(void *addr, int len, struct sysinfo_t *info)
 	for (i = 0; i < header->table_entries; i++) {
 		struct cb_record *rec = (struct cb_record *)ptr;
 
+		cb_index_record(info, rec, ptr - (unsigned char *)header);
+
 		/* We only care about a few tags here (maybe more later). */
 		switch (rec->tag) {
 		case CB_TAG_FORWARD:
@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <coroutine.h>
+#include <libpayload.h>
+
+enum {
+	COROUTINE_NEW,
+	COROUTINE_RUNNING,
+	COROUTINE_DONE,
+};
+
+/*
+ * Implemented for each architecture. coroutine_switch() saves the callee-saved registers
+ * on the current stack, stores the stack pointer in *save_sp and restores the context
+ * saved at sp. coroutine_launch() does the same, but calls entry() on a fresh stack.
+ */
+void coroutine_switch(uintptr_t *save_sp, uintptr_t sp);
+void coroutine_launch(uintptr_t *save_sp, uintptr_t stack_top, void (*entry)(void));
+
+/* The context that called main(). It is always in the circular run queue. */
+static struct coroutine main_coroutine = {
+	.next = &main_coroutine,
+	.state = COROUTINE_RUNNING,
+};
+static struct coroutine *current = &main_coroutine;
+
+static void coroutine_entry(void);
+
+static void resume(struct coroutine *next, uintptr_t *save_sp)
+{
+	current = next;
+	if (next->state == COROUTINE_NEW) {
+		next->state = COROUTINE_RUNNING;
+		coroutine_launch(save_sp, next->stack_top, coroutine_entry);
+	} else {
+		coroutine_switch(save_sp, next->sp);
+	}
+}
+
+static void coroutine_entry(void)
+{
+	struct coroutine *self = current, *prev;
+	uintptr_t unused;
+
+	self->func(self->arg);
+
+	/* Leave the run queue. The stack is freed by coroutine_join(), not on it. */
+	for (prev = self; prev->next != self; prev = prev->next)
+		;
+	prev->next = self->next;
+	self->state = COROUTINE_DONE;
+
+	resume(self->next, &unused);
+	die("Finished coroutine was resumed");
+}
+
+int coroutine_start(struct coroutine *co, void (*func)(void *arg), void *arg,
+		    size_t stack_size)
+{
+	struct coroutine *prev;
+
+	memset(co, 0, sizeof(*co));
+
+	co->stack = malloc(stack_size);
+	if (!co->stack)
+		return -1;
+
+	/* All supported ABIs are fine with a 16 byte aligned stack. */
+	co->stack_top = ALIGN_DOWN((uintptr_t)co->stack + stack_size, 16);
+	co->func = func;
+	co->arg = arg;
+	co->state = COROUTINE_NEW;
+
+	/* Run it after the ones that are already queued. */
+	for (prev = current; prev->next != current; prev = prev->next)
+		;
+	co->next = current;
+	prev->next = co;
+
+	return 0;
+}
+
+void coroutine_yield(void)
+{
+	if (current->next != current)
+		resume(current->next, &current->sp);
+}
+
+int coroutine_done(const struct coroutine *co)
+{
+	return co->state == COROUTINE_DONE;
+}
+
+void coroutine_join(struct coroutine *co)
+{
+	die_if(co == current, "Coroutine can't join itself");
+
+	while (!coroutine_done(co))
+		coroutine_yield();
+
+	free(co->stack);
+	co->stack = NULL;
+}
+
+int coroutine_await(int (*poll)(void *arg), void *arg, uint64_t timeout_us)
+{
+	const uint64_t start = timer_us(0);
+
+	while (!poll(arg)) {
+		if (timeout_us && timer_us(start) >= timeout_us)
+			return -1;
+		coroutine_yield();
+	}
+
+	return 0;
+}
+
+void coroutine_udelay(unsigned int us)
+{
+	const uint64_t start = timer_us(0);
+	uint64_t elapsed;
+
+	/* Without other coroutines this is a plain delay, which may sleep. */
+	while ((elapsed = timer_us(start)) < us) {
+		if (current->next == current) {
+			udelay(us - elapsed);
+			break;
+		}
+		coroutine_yield();
+	}
+}
@@ -28,6 +28,7 @@
 
 #include <libpayload-config.h>
 #include <libpayload.h>
+#include <commonlib/bsd/fmap_index.h>
 #include <commonlib/bsd/fmap_serialized.h>
 #include <coreboot_tables.h>
 #include <cbfs.h>
@@ -41,6 +42,21 @@ static struct fmap *_fmap_cache;
 static enum cb_err fmap_find_area(struct fmap *fmap, const char *name, size_t *offset,
 				  size_t *size)
 {
+	const struct fmap_area *area;
+	enum cb_err err;
+
+	/* coreboot appends a hash index to the CBMEM copy, fall back to a scan without it. */
+	err = fmap_index_find(fmap, lib_sysinfo.fmap_cache_size, name, &area);
+	if (err == CB_SUCCESS) {
+		if (offset)
+			*offset = le32toh(area->offset);
+		if (size)
+			*size = le32toh(area->size);
+		return CB_SUCCESS;
+	}
+	if (err == CB_ERR)
+		return CB_ERR;
+
 	for (size_t i = 0; i < le32toh(fmap->nareas); ++i) {
 		if (strncmp((const char *)fmap->areas[i].name, name, FMAP_STRLEN) != 0)
 			continue;
@@ -42,6 +42,41 @@
 #include <libpayload.h>
 #include <stdint.h>
 
+#define SLAB_CLASSES	5
+#define SLAB_MAX_OBJECT	256
+
+struct slab;
+
+struct slab_class {
+	struct slab *partial;	/* slabs with free and used objects */
+	struct slab *empty;	/* one unused slab kept around */
+	unsigned int slabs;
+	unsigned int used;
+	unsigned long allocs;
+};
+
+/*
+ * Orders of the DMA buddy arena: naturally aligned blocks from 4KiB (order 0)
+ * to 64KiB, split from 64KiB chunks that are taken from the DMA heap.
+ */
+#define BUDDY_MIN_SHIFT	12
+#define BUDDY_ORDERS	5
+#define BUDDY_MAX_SHIFT	(BUDDY_MIN_SHIFT + BUDDY_ORDERS - 1)
+#define BUDDY_UNITS	(1 << (BUDDY_ORDERS - 1))
+
+struct buddy_chunk;
+struct buddy_free;
+
+struct buddy_arena {
+	void *base;			/* type->start, aligned down to a chunk */
+	size_t num_chunks;
+	struct buddy_chunk **chunks;	/* by (addr - base) >> BUDDY_MAX_SHIFT */
+	struct buddy_free *free[BUDDY_ORDERS];
+	unsigned int free_chunks;	/* chunks that are entirely free */
+	unsigned int used_chunks;
+	unsigned long allocs[BUDDY_ORDERS];
+};
+
 struct memory_type {
 	void *start;
 	void *end;
@@ -51,6 +86,8 @@ struct memory_type {
 	size_t minimal_free;
 	const char *name;
 #endif
+	struct slab_class slabs[SLAB_CLASSES];
+	struct buddy_arena buddy;
 };
 
 extern char _heap, _eheap;	/* Defined in the ldscript. */
@@ -82,6 +119,10 @@ typedef u64 hdrtype_t;
 #define IS_FREE(_h) (((_h) & (MAGIC | FLAG_FREE)) == (MAGIC | FLAG_FREE))
 #define HAS_MAGIC(_h) (((_h) & MAGIC) == MAGIC)
 
+/* Objects in slabs have a header with a different magic and their offset in the slab. */
+#define SLAB_TAG	(((hdrtype_t)0x15) << (SIZE_BITS + 1))
+#define IS_SLAB_OBJECT(_h) (((_h) & ~(FLAG_FREE | MAX_SIZE)) == SLAB_TAG)
+
 static int free_aligned(void* addr, struct memory_type *type);
 void print_malloc_map(void);
 
@@ -98,11 +139,20 @@ void init_dma_memory(void *start, u32 size)
 	 */
 	*(hdrtype_t *)start = 0;
 
-	dma = malloc(sizeof(*dma));
+	dma = calloc(1, sizeof(*dma));
 	dma->start = start;
 	dma->end = start + size;
 	dma->align_regions = NULL;
 
+	if (CONFIG(LP_DMA_BUDDY)) {
+		struct buddy_arena *const ba = &dma->buddy;
+		ba->base = (void *)ALIGN_DOWN((uintptr_t)start, 1 << BUDDY_MAX_SHIFT);
+		ba->num_chunks = (ALIGN_UP((uintptr_t)dma->end, 1 << BUDDY_MAX_SHIFT) -
+				  (uintptr_t)ba->base) >> BUDDY_MAX_SHIFT;
+		/* Without the chunk table, aligned requests take the slow path. */
+		ba->chunks = calloc(ba->num_chunks, sizeof(*ba->chunks));
+	}
+
 #if CONFIG(LP_DEBUG_MALLOC)
 	dma->minimal_free = 0;
 	dma->magic_initialized = 0;
@@ -207,6 +257,49 @@ static void use_block(hdrtype_t volatile *ptr, int len)
 	}
 }
 
+/*
+ * Allocate |len| bytes at an address aligned to |align|. The space in front of
+ * the aligned address stays a free block, so nothing is wasted.
+ */
+static void *alloc_exact_aligned(size_t len, size_t align,
+				 struct memory_type *type)
+{
+	/* The blocks in front of the first one that is large enough don't fit. */
+	hdrtype_t volatile *ptr = find_free_block(len, type);
+
+	if (!ptr)
+		return NULL;
+
+	len = ALIGN_UP(len, HDRSIZE);
+	align = MAX(align, HDRSIZE);
+
+	for (; ptr < (hdrtype_t *)type->end;
+	     ptr = (hdrtype_t volatile *)((uintptr_t)ptr + HDRSIZE + (size_t)SIZE(*ptr))) {
+		const hdrtype_t header = *ptr;
+		const uintptr_t data = (uintptr_t)ptr + HDRSIZE;
+		uintptr_t addr = ALIGN_UP(data, align);
+
+		if (!(header & FLAG_FREE))
+			continue;
+
+		/* The gap needs room for a new header and a non-empty free block. */
+		if (addr != data && addr - data < 2 * HDRSIZE)
+			addr += align;
+		if (addr + len > data + SIZE(header))
+			continue;
+
+		if (addr != data) {
+			*ptr = FREE_BLOCK(addr - data - HDRSIZE);
+			ptr = (hdrtype_t volatile *)(addr - HDRSIZE);
+			*ptr = FREE_BLOCK(data + SIZE(header) - addr);
+		}
+		use_block(ptr, len);
+		return (void *)addr;
+	}
+
+	return NULL;
+}
+
 static void *alloc(int len, struct memory_type *type)
 {
 	hdrtype_t volatile *ptr = find_free_block(len, type);
@@ -253,10 +346,334 @@ static void _consolidate(struct memory_type *type)
 	}
 }
 
+/*
+ * Small allocations are served from slabs: blocks of SLAB_SIZE bytes taken
+ * from the heap and split into objects of one size class. Free objects of a
+ * slab are kept on a list, so allocating and freeing them doesn't have to walk
+ * the heap.
+ */
+#define SLAB_SIZE	2048
+#define SLAB_MAGIC	0x51ab51ab
+
+static const unsigned int slab_class_size[SLAB_CLASSES] = { 16, 32, 64, 128, 256 };
+
+struct slab {
+	u32 magic;
+	u16 class;
+	u16 used;
+	struct memory_type *type;
+	struct slab *prev;
+	struct slab *next;
+	void *free_list;	/* free objects, linked through their first word */
+};
+
+#define SLAB_FIRST_OBJECT ALIGN_UP(sizeof(struct slab), HDRSIZE)
+
+static void slab_link(struct slab **list, struct slab *slab)
+{
+	slab->prev = NULL;
+	slab->next = *list;
+	if (*list)
+		(*list)->prev = slab;
+	*list = slab;
+}
+
+static void slab_unlink(struct slab **list, struct slab *slab)
+{
+	if (slab->prev)
+		slab->prev->next = slab->next;
+	else
+		*list = slab->next;
+	if (slab->next)
+		slab->next->prev = slab->prev;
+}
+
+static struct slab *slab_create(unsigned int class, struct memory_type *type)
+{
+	const size_t stride = HDRSIZE + slab_class_size[class];
+	const size_t count = (SLAB_SIZE - SLAB_FIRST_OBJECT) / stride;
+	struct slab *slab = alloc(SLAB_SIZE, type);
+	size_t i;
+
+	if (!slab)
+		return NULL;
+
+	slab->magic = SLAB_MAGIC;
+	slab->class = class;
+	slab->used = 0;
+	slab->type = type;
+	slab->free_list = NULL;
+
+	/* Build the free list back to front, so it hands out low addresses first. */
+	for (i = count; i-- > 0;) {
+		const size_t off = SLAB_FIRST_OBJECT + i * stride;
+		hdrtype_t *const hdr = (void *)slab + off;
+
+		*hdr = SLAB_TAG | FLAG_FREE | off;
+		*(void **)(hdr + 1) = slab->free_list;
+		slab->free_list = hdr + 1;
+	}
+
+	type->slabs[class].slabs++;
+	return slab;
+}
+
+static void *slab_alloc(size_t len, struct memory_type *type)
+{
+	unsigned int class;
+
+	for (class = 0; slab_class_size[class] < len; class++)
+		;
+
+	struct slab_class *const sc = &type->slabs[class];
+	struct slab *slab = sc->partial;
+	if (!slab) {
+		slab = sc->empty;
+		sc->empty = NULL;
+		if (!slab)
+			slab = slab_create(class, type);
+		if (!slab)
+			return NULL;
+		slab_link(&sc->partial, slab);
+	}
+
+	void *const ptr = slab->free_list;
+	hdrtype_t *const hdr = ptr - HDRSIZE;
+	slab->free_list = *(void **)ptr;
+	*hdr &= ~FLAG_FREE;
+	slab->used++;
+	sc->used++;
+	sc->allocs++;
+
+	/* Full slabs are not on any list until an object is freed. */
+	if (!slab->free_list)
+		slab_unlink(&sc->partial, slab);
+
+	return ptr;
+}
+
+/* Returns the slab of |ptr| if it was allocated from one. */
+static struct slab *slab_of(void *ptr, struct memory_type *type)
+{
+	struct slab *slab;
+	hdrtype_t hdr;
+
+	if (!CONFIG(LP_MALLOC_SLABS) || ptr - HDRSIZE < type->start)
+		return NULL;
+
+	hdr = *(hdrtype_t *)(ptr - HDRSIZE);
+	if (!IS_SLAB_OBJECT(hdr) || SIZE(hdr) >= SLAB_SIZE)
+		return NULL;
+
+	slab = ptr - HDRSIZE - SIZE(hdr);
+	if ((void *)slab < type->start || slab->magic != SLAB_MAGIC ||
+	    slab->type != type)
+		return NULL;
+
+	return slab;
+}
+
+static void slab_free(struct slab *slab, void *ptr)
+{
+	struct slab_class *const sc = &slab->type->slabs[slab->class];
+	hdrtype_t *const hdr = ptr - HDRSIZE;
+
+	/* Double free. */
+	if (*hdr & FLAG_FREE)
+		return;
+
+	*hdr |= FLAG_FREE;
+	if (!slab->free_list)
+		slab_link(&sc->partial, slab);
+	*(void **)ptr = slab->free_list;
+	slab->free_list = ptr;
+	slab->used--;
+	sc->used--;
+
+	if (slab->used)
+		return;
+
+	/* Keep one empty slab per class, so we don't thrash the heap. */
+	slab_unlink(&sc->partial, slab);
+	if (!sc->empty) {
+		sc->empty = slab;
+		return;
+	}
+
+	slab->magic = 0;
+	sc->slabs--;
+	free(slab);
+}
+
+static void *type_alloc(size_t len, struct memory_type *type)
+{
+	if (CONFIG(LP_MALLOC_SLABS) && len && len <= SLAB_MAX_OBJECT) {
+		void *const ptr = slab_alloc(len, type);
+		if (ptr)
+			return ptr;
+	}
+
+	return alloc(len, type);
+}
+
+/*
+ * DMA rings and buffers are usually power-of-two sized and aligned. They are
+ * served by a buddy allocator, so they don't each have to search and split the
+ * DMA heap. The state of each 4KiB unit of a chunk is kept outside of DMA
+ * memory; free blocks are linked through their first bytes.
+ */
+#define BUDDY_FREE	0x80
+#define BUDDY_USED	0x40
+#define BUDDY_ORDER(_s)	((_s) & 0x0f)
+
+struct buddy_chunk {
+	void *base;
+	u8 state[BUDDY_UNITS];	/* for the first unit of each block, 0 otherwise */
+};
+
+struct buddy_free {
+	struct buddy_free *next;
+	struct buddy_free *prev;
+};
+
+static struct buddy_chunk *buddy_chunk_of(struct buddy_arena *ba, void *ptr)
+{
+	if (!ba->chunks || ptr < ba->base)
+		return NULL;
+
+	const size_t idx = (ptr - ba->base) >> BUDDY_MAX_SHIFT;
+	if (idx >= ba->num_chunks)
+		return NULL;
+
+	return ba->chunks[idx];
+}
+
+static void buddy_push(struct buddy_arena *ba, unsigned int order, void *ptr)
+{
+	struct buddy_free *const blk = ptr;
+
+	blk->prev = NULL;
+	blk->next = ba->free[order];
+	if (blk->next)
+		blk->next->prev = blk;
+	ba->free[order] = blk;
+}
+
+static void buddy_unlink(struct buddy_arena *ba, unsigned int order,
+			 struct buddy_free *blk)
+{
+	if (blk->prev)
+		blk->prev->next = blk->next;
+	else
+		ba->free[order] = blk->next;
+	if (blk->next)
+		blk->next->prev = blk->prev;
+}
+
+static int buddy_add_chunk(struct memory_type *type)
+{
+	struct buddy_arena *const ba = &type->buddy;
+	struct buddy_chunk *chunk = calloc(1, sizeof(*chunk));
+	void *base;
+
+	if (!chunk)
+		return 0;
+
+	base = alloc_exact_aligned(1 << BUDDY_MAX_SHIFT, 1 << BUDDY_MAX_SHIFT, type);
+	if (!base) {
+		free(chunk);
+		return 0;
+	}
+
+	chunk->base = base;
+	chunk->state[0] = BUDDY_FREE | (BUDDY_ORDERS - 1);
+	ba->chunks[(base - ba->base) >> BUDDY_MAX_SHIFT] = chunk;
+	buddy_push(ba, BUDDY_ORDERS - 1, base);
+	ba->free_chunks++;
+	ba->used_chunks++;
+
+	return 1;
+}
+
+static void *buddy_alloc(unsigned int order, struct memory_type *type)
+{
+	struct buddy_arena *const ba = &type->buddy;
+	unsigned int j;
+
+	for (j = order; j < BUDDY_ORDERS && !ba->free[j]; j++)
+		;
+	if (j == BUDDY_ORDERS) {
+		if (!buddy_add_chunk(type))
+			return NULL;
+		j = BUDDY_ORDERS - 1;
+	}
+
+	struct buddy_free *const blk = ba->free[j];
+	struct buddy_chunk *const chunk = buddy_chunk_of(ba, blk);
+	const unsigned int unit = ((void *)blk - chunk->base) >> BUDDY_MIN_SHIFT;
+
+	buddy_unlink(ba, j, blk);
+	if (j == BUDDY_ORDERS - 1)
+		ba->free_chunks--;
+
+	/* Split off the upper halves until the block has the right size. */
+	while (j > order) {
+		j--;
+		chunk->state[unit + (1 << j)] = BUDDY_FREE | j;
+		buddy_push(ba, j, (void *)blk + ((1 << BUDDY_MIN_SHIFT) << j));
+	}
+
+	chunk->state[unit] = BUDDY_USED | order;
+	ba->allocs[order]++;
+	return blk;
+}
+
+static void buddy_free(struct buddy_chunk *chunk, void *ptr,
+		       struct memory_type *type)
+{
+	struct buddy_arena *const ba = &type->buddy;
+	const size_t off = ptr - chunk->base;
+	unsigned int unit = off >> BUDDY_MIN_SHIFT;
+	unsigned int order;
+
+	/* Not the start of a block, or a double free. */
+	if (off & ((1 << BUDDY_MIN_SHIFT) - 1) || !(chunk->state[unit] & BUDDY_USED))
+		return;
+
+	/* Merge with the buddy as long as it is free and of the same size. */
+	for (order = BUDDY_ORDER(chunk->state[unit]); order < BUDDY_ORDERS - 1; order++) {
+		const unsigned int buddy = unit ^ (1 << order);
+		if (chunk->state[buddy] != (BUDDY_FREE | order))
+			break;
+		buddy_unlink(ba, order, chunk->base + (buddy << BUDDY_MIN_SHIFT));
+		chunk->state[buddy] = 0;
+		chunk->state[unit] = 0;
+		unit &= ~(1 << order);
+	}
+
+	chunk->state[unit] = BUDDY_FREE | order;
+	buddy_push(ba, order, chunk->base + (unit << BUDDY_MIN_SHIFT));
+	if (order < BUDDY_ORDERS - 1)
+		return;
+
+	/* Keep one free chunk around, give the others back to the heap. */
+	if (++ba->free_chunks == 1)
+		return;
+
+	buddy_unlink(ba, order, chunk->base);
+	ba->chunks[(chunk->base - ba->base) >> BUDDY_MAX_SHIFT] = NULL;
+	ba->free_chunks--;
+	ba->used_chunks--;
+	free(chunk->base);
+	free(chunk);
+}
+
 void free(void *ptr)
 {
 	hdrtype_t hdr;
 	struct memory_type *type = heap;
+	struct slab *slab;
+	struct buddy_chunk *chunk;
 
 	/* No action occurs on NULL. */
 	if (ptr == NULL)
@@ -269,6 +686,18 @@ void free(void *ptr)
 			return;
 	}
 
+	slab = slab_of(ptr, type);
+	if (slab) {
+		slab_free(slab, ptr);
+		return;
+	}
+
+	chunk = buddy_chunk_of(&type->buddy, ptr);
+	if (chunk) {
+		buddy_free(chunk, ptr, type);
+		return;
+	}
+
 	if (free_aligned(ptr, type)) return;
 
 	ptr -= HDRSIZE;
@@ -288,18 +717,18 @@ void free(void *ptr)
 
 void *malloc(size_t size)
 {
-	return alloc(size, heap);
+	return type_alloc(size, heap);
 }
 
 void *dma_malloc(size_t size)
 {
-	return alloc(size, dma);
+	return type_alloc(size, dma);
 }
 
 void *calloc(size_t nmemb, size_t size)
 {
 	size_t total = nmemb * size;
-	void *ptr = alloc(total, heap);
+	void *ptr = type_alloc(total, heap);
 
 	if (ptr)
 		memset(ptr, 0, total);
@@ -313,18 +742,32 @@ void *realloc(void *ptr, size_t size)
 	hdrtype_t volatile *block;
 	unsigned int osize;
 	struct memory_type *type = heap;
+	struct slab *slab;
 
 	if (ptr == NULL)
-		return alloc(size, type);
+		return type_alloc(size, type);
+
+	if (ptr < type->start || ptr >= type->end)
+		type = dma;
+
+	slab = slab_of(ptr, type);
+	if (slab) {
+		osize = slab_class_size[slab->class];
+		if (size && size <= osize)
+			return ptr;
+		ret = type_alloc(size, type);
+		if (ret) {
+			memcpy(ret, ptr, MIN(size, osize));
+			slab_free(slab, ptr);
+		}
+		return ret;
+	}
 
 	pptr = ptr - HDRSIZE;
 
 	if (!HAS_MAGIC(*((hdrtype_t *) pptr)))
 		return NULL;
 
-	if (ptr < type->start || ptr >= type->end)
-		type = dma;
-
 	/* Get the original size of the block. */
 	osize = SIZE(*((hdrtype_t *) pptr));
 
@@ -357,8 +800,6 @@ void *realloc(void *ptr, size_t size)
 
 struct align_region_t
 {
-	/* If alignment is 0 then the region represents a large region which
-	 * has no metadata for tracking subelements. */
 	int alignment;
 	/* start in memory, and size in bytes */
 	void* start;
@@ -377,18 +818,11 @@ struct align_region_t
 	struct align_region_t *next;
 };
 
-static inline int region_is_large(const struct align_region_t *r)
-{
-	return r->alignment == 0;
-}
-
 static inline int addr_in_region(const struct align_region_t *r, void *addr)
 {
 	return ((addr >= r->start_data) && (addr < r->start_data + r->size));
 }
 
-/* num_elements == 0 indicates a large aligned region instead of a smaller
- * region comprised of alignment-sized chunks. */
 static struct align_region_t *allocate_region(int alignment, int num_elements,
 					size_t size, struct memory_type *type)
 {
@@ -407,19 +841,12 @@ static struct align_region_t *allocate_region(int alignment, int num_elements,
 
 	memset(r, 0, sizeof(*r));
 
-	if (num_elements != 0) {
-		r->alignment = alignment;
-		r->size = num_elements * alignment;
-		r->free = num_elements;
-		/* Allocate enough memory for alignment requirements and
-		 * metadata for each chunk. */
-		extra_space = num_elements;
-	} else {
-		/* Large aligned allocation. Set alignment = 0. */
-		r->alignment = 0;
-		r->size = size;
-		extra_space = 0;
-	}
+	r->alignment = alignment;
+	r->size = num_elements * alignment;
+	r->free = num_elements;
+	/* Allocate enough memory for alignment requirements and
+	 * metadata for each chunk. */
+	extra_space = num_elements;
 
 	r->start = alloc(r->size + alignment + extra_space, type);
 
@@ -445,12 +872,9 @@ static void try_free_region(struct align_region_t **prev_link)
 {
 	struct align_region_t *r = *prev_link;
 
-	/* All large regions are immediately free-able. Non-large regions
-	 * need to be checked for the fully freed state. */
-	if (!region_is_large(r)) {
-		if (r->free != r->size / r->alignment)
-			return;
-	}
+	/* Regions can only be freed once all elements are free. */
+	if (r->free != r->size / r->alignment)
+		return;
 
 	/* Unlink region from link list. */
 	*prev_link = r->next;
@@ -471,11 +895,6 @@ static int free_aligned(void* addr, struct memory_type *type)
 			continue;
 		}
 
-		if (region_is_large(*prev_link)) {
-			try_free_region(prev_link);
-			return 1;
-		}
-
 		int i = (addr-(*prev_link)->start_data)/(*prev_link)->alignment;
 		u8 *meta = (*prev_link)->start;
 		while (meta[i] == 2)
@@ -506,12 +925,9 @@ static void *alloc_aligned(size_t align, size_t size, struct memory_type *type)
 	}
 	struct align_region_t *reg = type->align_regions;
 
-	if (size >= large_request || align >= large_request) {
-		reg = allocate_region(align, 0, size, type);
-		if (reg == NULL)
-			return NULL;
-		return reg->start_data;
-	}
+	/* Large requests are carved out of the heap as plain blocks. */
+	if (size >= large_request || align >= large_request)
+		return alloc_exact_aligned(size, align, type);
 
 look_further:
 	while (reg != 0)
@@ -572,11 +988,86 @@ void *memalign(size_t align, size_t size)
 	return alloc_aligned(align, size, heap);
 }
 
+static void *buddy_memalign(size_t align, size_t size, struct memory_type *type)
+{
+	int shift;
+
+	if (!CONFIG(LP_DMA_BUDDY) || !type->buddy.chunks)
+		return NULL;
+	if (size < (1 << BUDDY_MIN_SHIFT) && align < (1 << BUDDY_MIN_SHIFT))
+		return NULL;
+	if (size > (1 << BUDDY_MAX_SHIFT) || align > (1 << BUDDY_MAX_SHIFT))
+		return NULL;
+
+	if (!size)
+		return NULL;
+
+	/* Round the size up to a power of two, alignments already are one. */
+	shift = MAX(log2(size - 1) + 1, BUDDY_MIN_SHIFT);
+	if (align)
+		shift = MAX(shift, log2(align));
+
+	return buddy_alloc(shift - BUDDY_MIN_SHIFT, type);
+}
+
 void *dma_memalign(size_t align, size_t size)
 {
+	void *ptr = buddy_memalign(align, size, dma);
+
+	if (ptr)
+		return ptr;
+
 	return alloc_aligned(align, size, dma);
 }
 
+static void print_memory_stats(const char *name, struct memory_type *type)
+{
+	size_t free_memory = 0, largest = 0;
+	unsigned int blocks = 0, class;
+	void *ptr = type->start;
+
+	printf("%s: %zu bytes at %p\n", name,
+	       (size_t)(type->end - type->start), type->start);
+
+	while (ptr < type->end) {
+		const hdrtype_t hdr = *((hdrtype_t *)ptr);
+
+		if (!HAS_MAGIC(hdr))
+			break;
+		if (hdr & FLAG_FREE) {
+			free_memory += SIZE(hdr);
+			largest = MAX(largest, (size_t)SIZE(hdr));
+		}
+		blocks++;
+		ptr += HDRSIZE + SIZE(hdr);
+	}
+	printf("  %u blocks, %zu bytes free, largest free block %zu bytes\n",
+	       blocks, free_memory, largest);
+
+	for (class = 0; class < SLAB_CLASSES; class++) {
+		const struct slab_class *const sc = &type->slabs[class];
+		if (!sc->slabs)
+			continue;
+		printf("  %3u byte objects: %u slabs, %u used, %lu allocations\n",
+		       slab_class_size[class], sc->slabs, sc->used, sc->allocs);
+	}
+
+	if (!type->buddy.used_chunks)
+		return;
+	printf("  buddy arena: %u chunks, %u free\n",
+	       type->buddy.used_chunks, type->buddy.free_chunks);
+	for (class = 0; class < BUDDY_ORDERS; class++)
+		printf("  %3u KiB blocks: %lu allocations\n",
+		       (1 << (BUDDY_MIN_SHIFT + class)) >> 10, type->buddy.allocs[class]);
+}
+
+void print_malloc_stats(void)
+{
+	print_memory_stats("heap", heap);
+	if (dma_initialized())
+		print_memory_stats("dma", dma);
+}
+
 /* This is for debugging purposes. */
 #if CONFIG(LP_DEBUG_MALLOC)
 void print_malloc_map(void)
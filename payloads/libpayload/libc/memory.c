@@ -148,10 +148,24 @@ int memcmp(const void *s1, const void *s2, size_t n)
 void *memchr(const void *s, int c, size_t n)
 {
 	unsigned char *p = (unsigned char *)s;
-	while (n--)
-		if (*p != (unsigned char)c)
-			p++;
-		else
+	const unsigned long ones = (unsigned long)-1 / 0xff;
+	const unsigned long pattern = ones * (unsigned char)c;
+
+	for (; n && !IS_ALIGNED((uintptr_t)p, sizeof(unsigned long)); n--, p++)
+		if (*p == (unsigned char)c)
+			return p;
+
+	/* Skip words that don't contain the character, i.e. where w has no zero byte. */
+	for (; n >= sizeof(unsigned long); n -= sizeof(unsigned long)) {
+		const unsigned long w = *(unsigned long *)p ^ pattern;
+		if ((w - ones) & ~w & (ones * 0x80))
+			break;
+		p += sizeof(unsigned long);
+	}
+
+	for (; n; n--, p++)
+		if (*p == (unsigned char)c)
 			return p;
+
 	return 0;
 }
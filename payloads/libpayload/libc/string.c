@@ -35,6 +35,18 @@
 #include <limits.h>
 #include <errno.h>
 
+/*
+ * Helpers to look at a word's worth of characters at once. Aligned word loads never cross
+ * a page boundary, so reading a few bytes past the end of a string is harmless.
+ */
+typedef unsigned long __attribute__((__may_alias__)) word_t;
+
+#define WORD_ONES	((word_t)-1 / 0xff)
+#define WORD_HIGHS	(WORD_ONES * 0x80)
+/* Non-zero if any byte of w is zero. */
+#define WORD_HAS_ZERO(w)	(((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+#define WORD_ALIGNED(p)	IS_ALIGNED((uintptr_t)(p), sizeof(word_t))
+
 /**
  * Calculate the length of a fixed-size string.
  *
@@ -52,7 +64,15 @@ size_t strnlen(const char *str, size_t maxlen)
 		return 0;
 
 	/* Loop until we find a NUL character, or maxlen is reached. */
-	while ((*str++ != '\0') && (len < maxlen))
+	for (; len < maxlen && !WORD_ALIGNED(str + len); len++)
+		if (str[len] == '\0')
+			return len;
+
+	for (; maxlen - len >= sizeof(word_t); len += sizeof(word_t))
+		if (WORD_HAS_ZERO(*(const word_t *)(str + len)))
+			break;
+
+	while (len < maxlen && str[len] != '\0')
 		len++;
 
 	return len;
@@ -66,17 +86,25 @@ size_t strnlen(const char *str, size_t maxlen)
  */
 size_t strlen(const char *str)
 {
-	size_t len = 0;
+	const char *p = str;
+	const word_t *w;
 
 	/* NULL and empty strings have length 0. */
 	if (!str)
 		return 0;
 
 	/* Loop until we find a NUL character. */
-	while (*str++ != '\0')
-		len++;
+	for (; !WORD_ALIGNED(p); p++)
+		if (*p == '\0')
+			return p - str;
 
-	return len;
+	for (w = (const word_t *)p; !WORD_HAS_ZERO(*w); w++)
+		;
+
+	for (p = (const char *)w; *p != '\0'; p++)
+		;
+
+	return p - str;
 }
 
 /**
@@ -133,9 +161,25 @@ int strncasecmp(const char *s1, const char *s2, size_t maxlen)
  */
 int strcmp(const char *s1, const char *s2)
 {
+	size_t i = 0;
 	int res;
 
-	for (size_t i = 0; 1; i++) {
+	/* Skip equal words if both strings can get aligned. */
+	if (WORD_ALIGNED((uintptr_t)s1 - (uintptr_t)s2)) {
+		for (; !WORD_ALIGNED(s1 + i); i++) {
+			res = s1[i] - s2[i];
+			if (res || (s1[i] == '\0'))
+				return res;
+		}
+
+		for (;; i += sizeof(word_t)) {
+			const word_t w = *(const word_t *)(s1 + i);
+			if (w != *(const word_t *)(s2 + i) || WORD_HAS_ZERO(w))
+				break;
+		}
+	}
+
+	for (; 1; i++) {
 		res = s1[i] - s2[i];
 		if (res || (s1[i] == '\0'))
 			break;
@@ -273,8 +317,21 @@ size_t strlcat(char *d, const char *s, size_t n)
 char *strchr(const char *s, int c)
 {
 	char *p = (char *)s;
+	const word_t *w;
+	const word_t pattern = WORD_ONES * (unsigned char)c;
+
+	for (; !WORD_ALIGNED(p); p++) {
+		if (*p == 0)
+			return NULL;
+		if (*p == c)
+			return p;
+	}
+
+	/* Skip words that have neither the character nor the NUL. */
+	for (w = (const word_t *)p; !WORD_HAS_ZERO(*w) && !WORD_HAS_ZERO(*w ^ pattern); w++)
+		;
 
-	for (; *p != 0; p++) {
+	for (p = (char *)w; *p != 0; p++) {
 		if (*p == c)
 			return p;
 	}
@@ -34,3 +34,44 @@ int sysinfo_have_multiboot(unsigned long *addr)
 	*addr = (unsigned long) lib_sysinfo.mbtable;
 	return (lib_sysinfo.mbtable == 0) ? 0 : 1;
 }
+
+struct cb_record *cb_find_record(u32 tag)
+{
+	struct cb_header *header;
+	unsigned char *ptr;
+	int lo, hi, i;
+
+	if (!lib_sysinfo.cb_header)
+		return NULL;
+
+	header = phys_to_virt(lib_sysinfo.cb_header);
+
+	if (lib_sysinfo.num_cb_tags >= 0) {
+		lo = 0;
+		hi = lib_sysinfo.num_cb_tags;
+		while (lo < hi) {
+			const int mid = lo + (hi - lo) / 2;
+
+			if (lib_sysinfo.cb_tags[mid].tag < tag)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		if (lo < lib_sysinfo.num_cb_tags && lib_sysinfo.cb_tags[lo].tag == tag)
+			return (void *)header + lib_sysinfo.cb_tags[lo].offset;
+
+		return NULL;
+	}
+
+	ptr = (unsigned char *)header + header->header_bytes;
+	for (i = 0; i < header->table_entries; i++) {
+		struct cb_record *rec = (struct cb_record *)ptr;
+
+		if (rec->tag == tag)
+			return rec;
+		ptr += rec->size;
+	}
+
+	return NULL;
+}
@@ -74,8 +74,41 @@ ssize_t _cbfs_boot_lookup(const char *name, bool force_ro, union cbfs_mdata *mda
 	return cbd->dev.offset + data_offset;
 }
 
+/* Returns the memory-mapped window of the boot device that holds the whole range, if any. */
+static const struct flash_mmap_window *cbfs_mmap_window(size_t offset, size_t size)
+{
+	uint32_t i;
+
+	for (i = 0; i < lib_sysinfo.spi_flash.mmap_window_count; i++) {
+		const struct flash_mmap_window *const w = &lib_sysinfo.spi_flash.mmap_table[i];
+		if (offset >= w->flash_base && size <= w->size &&
+		    offset - w->flash_base <= w->size - size)
+			return w;
+	}
+
+	return NULL;
+}
+
+static bool cbfs_is_mmapped(const void *mapping)
+{
+	const unsigned long addr = virt_to_phys(mapping);
+	uint32_t i;
+
+	for (i = 0; i < lib_sysinfo.spi_flash.mmap_window_count; i++) {
+		const struct flash_mmap_window *const w = &lib_sysinfo.spi_flash.mmap_table[i];
+		if (addr >= w->host_base && addr - w->host_base < w->size)
+			return true;
+	}
+
+	return false;
+}
+
 void cbfs_unmap(void *mapping)
 {
+	/* Zero-copy mappings point straight into the boot device. */
+	if (CONFIG(LP_CBFS_MMAP) && cbfs_is_mmapped(mapping))
+		return;
+
 	free(mapping);
 }
 
@@ -151,6 +184,21 @@ out:
 	return out_size;
 }
 
+/* Uncompressed files on memory-mapped boot media are mapped in place instead of copied. */
+static void *do_mmap(const struct flash_mmap_window *w, union cbfs_mdata *mdata,
+		     ssize_t offset, bool skip_verification)
+{
+	const size_t size = be32toh(mdata->h.len);
+	void *mapping = phys_to_virt(w->host_base + (offset - w->flash_base));
+
+	DEBUG("Mapping %zu bytes of '%s' at %p\n", size, mdata->h.filename, mapping);
+
+	if (cbfs_file_hash_mismatch(mapping, size, mdata, skip_verification))
+		return NULL;
+
+	return mapping;
+}
+
 static void *do_load(union cbfs_mdata *mdata, ssize_t offset, void *buf, size_t *size_inout,
 		     bool skip_verification)
 {
@@ -172,6 +220,12 @@ static void *do_load(union cbfs_mdata *mdata, ssize_t offset, void *buf, size_t
 		*size_inout = out_size;
 	}
 
+	if (!buf && CONFIG(LP_CBFS_MMAP) && compression == CBFS_COMPRESS_NONE) {
+		const struct flash_mmap_window *const w = cbfs_mmap_window(offset, out_size);
+		if (w)
+			return do_mmap(w, mdata, offset, skip_verification);
+	}
+
 	if (buf) {
 		if (!size_inout || buf_size < out_size) {
 			ERROR("'%s' buffer too small\n", mdata->h.filename);
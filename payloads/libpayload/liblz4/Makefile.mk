@@ -25,4 +25,4 @@
 ## SUCH DAMAGE.
 ##
 
-liblz4-$(CONFIG_LP_LZ4) += lz4_wrapper.c
+liblz4-srcs += $(coreboottop)/src/commonlib/bsd/lz4_wrapper.c
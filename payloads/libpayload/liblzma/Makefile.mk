@@ -27,3 +27,7 @@
 ##
 
 liblzma-$(CONFIG_LP_LZMA) += lzma.c
+liblzma-srcs += $(coreboottop)/src/lib/lzmadecode.c
+
+# The decoder and its header are shared with coreboot.
+liblzma-c-ccopts += -I$(coreboottop)/src/lib
@@ -7,37 +7,66 @@
  * Parts of this file are based on C/7zip/Compress/LZMA_C/LzmaTest.c from the LZMA
  * SDK 4.42, which is written and distributed to public domain by Igor Pavlov.
  *
+ * The decoder itself is shared with coreboot, see src/lib/lzmadecode.c.
  */
 
+#include <commonlib/bsd/helpers.h>
 #include <lzma.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include "lzmadecode.c"
+#include "lzmadecode.h"
 
-unsigned long ulzman(const unsigned char *src, unsigned long srcn,
-		     unsigned char *dst, unsigned long dstn)
+#define LZMA_HEADER_SIZE (LZMA_PROPERTIES_SIZE + 8)
+
+struct lzma_wait_context {
+	size_t (*wait)(void *arg, size_t needed);
+	void *arg;
+};
+
+/* The decoder counts from the start of the compressed data, the caller from the header. */
+static SizeT lzma_wait_data(void *arg, SizeT needed)
+{
+	struct lzma_wait_context *context = arg;
+	size_t avail = context->wait(context->arg, needed + LZMA_HEADER_SIZE);
+
+	return avail > LZMA_HEADER_SIZE ? avail - LZMA_HEADER_SIZE : 0;
+}
+
+/* The outSize in the header is a 64-bit little-endian integer, only the low half is used. */
+static UInt32 lzma_out_size(const unsigned char *header)
 {
-	unsigned char properties[LZMA_PROPERTIES_SIZE];
-	const int data_offset = LZMA_PROPERTIES_SIZE + 8;
+	const unsigned char *cp = header + LZMA_PROPERTIES_SIZE;
+
+	return cp[3] << 24 | cp[2] << 16 | cp[1] << 8 | cp[0];
+}
+
+static unsigned long _ulzman(const unsigned char *src, unsigned long srcn,
+			     unsigned char *dst, unsigned long dstn,
+			     size_t (*wait)(void *arg, size_t needed), void *arg)
+{
+	struct lzma_wait_context wait_context = { .wait = wait, .arg = arg };
 	UInt32 outSize;
 	SizeT inProcessed;
 	SizeT outProcessed;
 	int res;
-	CLzmaDecoderState state;
+	CLzmaDecoderState state = { 0 };
 	SizeT mallocneeds;
 	unsigned char *scratchpad;
 
-	if (srcn < data_offset) {
+	if (srcn < LZMA_HEADER_SIZE) {
 		printf("lzma: Input too small.\n");
 		return 0;
 	}
+	if (wait && wait(arg, LZMA_HEADER_SIZE) < LZMA_HEADER_SIZE) {
+		printf("lzma: Input header never arrived.\n");
+		return 0;
+	}
 
-	memcpy(properties, src, LZMA_PROPERTIES_SIZE);
-	memcpy(&outSize, src + LZMA_PROPERTIES_SIZE, sizeof(outSize));
+	outSize = lzma_out_size(src);
 	if (outSize > dstn)
 		outSize = dstn;
-	if (LzmaDecodeProperties(&state.Properties, properties,
+	if (LzmaDecodeProperties(&state.Properties, src,
 				 LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK) {
 		printf("lzma: Incorrect stream properties.\n");
 		return 0;
@@ -45,12 +74,14 @@ unsigned long ulzman(const unsigned char *src, unsigned long srcn,
 	mallocneeds = (LzmaGetNumProbs(&state.Properties) * sizeof(CProb));
 	scratchpad = malloc(mallocneeds);
 	if (!scratchpad) {
-		printf("lzma: Cannot allocate %u bytes for scratchpad!\n",
+		printf("lzma: Cannot allocate %zu bytes for scratchpad!\n",
 		       mallocneeds);
 		return 0;
 	}
 	state.Probs = (CProb *)scratchpad;
-	res = LzmaDecode(&state, src + data_offset, srcn - data_offset,
+	state.Wait = wait ? lzma_wait_data : NULL;
+	state.WaitArg = &wait_context;
+	res = LzmaDecode(&state, src + LZMA_HEADER_SIZE, srcn - LZMA_HEADER_SIZE,
 			 &inProcessed, dst, outSize, &outProcessed);
 	free(scratchpad);
 	if (res != 0) {
@@ -60,7 +91,107 @@ unsigned long ulzman(const unsigned char *src, unsigned long srcn,
 	return outProcessed;
 }
 
+unsigned long ulzman(const unsigned char *src, unsigned long srcn,
+		     unsigned char *dst, unsigned long dstn)
+{
+	return _ulzman(src, srcn, dst, dstn, NULL, NULL);
+}
+
 unsigned long ulzma(const unsigned char *src, unsigned char *dst)
 {
 	return ulzman(src, (unsigned long)(-1), dst, (unsigned long)(-1));
 }
+
+unsigned long ulzman_wait(const unsigned char *src, unsigned long srcn,
+			  unsigned char *dst, unsigned long dstn,
+			  size_t (*wait)(void *arg, size_t needed), void *arg)
+{
+	return _ulzman(src, srcn, dst, dstn, wait, arg);
+}
+
+struct lzma_stream_context {
+	const struct ulzma_stream *stream;
+	/* Part of the first input piece that follows the header. */
+	const unsigned char *rest;
+	size_t rest_size;
+};
+
+static SizeT lzma_stream_read(void *arg, const Byte **buf)
+{
+	struct lzma_stream_context *context = arg;
+	const void *piece;
+	size_t size;
+
+	if (context->rest_size) {
+		*buf = context->rest;
+		size = context->rest_size;
+		context->rest_size = 0;
+		return size;
+	}
+
+	size = context->stream->read(context->stream->arg, &piece);
+	*buf = piece;
+	return size;
+}
+
+static int lzma_stream_flush(void *arg, const Byte *buf, SizeT size)
+{
+	struct lzma_stream_context *context = arg;
+
+	return context->stream->write(context->stream->arg, buf, size);
+}
+
+size_t ulzman_stream(const struct ulzma_stream *stream)
+{
+	struct lzma_stream_context context = { .stream = stream };
+	unsigned char header[LZMA_HEADER_SIZE];
+	const void *piece;
+	size_t have = 0;
+	size_t size, n;
+	UInt32 outSize;
+	SizeT outProcessed;
+	CLzmaDecoderState state = { 0 };
+	int res;
+
+	/* The header may be split over several pieces of input. */
+	while (have < sizeof(header)) {
+		size = stream->read(stream->arg, &piece);
+		if (!size) {
+			printf("lzma: Input too small.\n");
+			return 0;
+		}
+		n = MIN(size, sizeof(header) - have);
+		memcpy(header + have, piece, n);
+		have += n;
+		context.rest = (const unsigned char *)piece + n;
+		context.rest_size = size - n;
+	}
+
+	outSize = lzma_out_size(header);
+	if (!stream->write && outSize > stream->window_size)
+		outSize = stream->window_size;
+
+	if (LzmaDecodeProperties(&state.Properties, header,
+				 LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK) {
+		printf("lzma: Incorrect stream properties.\n");
+		return 0;
+	}
+	if (LzmaGetNumProbs(&state.Properties) * sizeof(CProb) > stream->scratchpad_size) {
+		printf("lzma: Decoder scratchpad too small!\n");
+		return 0;
+	}
+
+	state.Probs = (CProb *)stream->scratchpad;
+	state.Read = lzma_stream_read;
+	state.Flush = stream->write ? lzma_stream_flush : NULL;
+	state.StreamArg = &context;
+	state.Window = stream->window;
+	state.WindowSize = stream->window_size;
+
+	res = LzmaDecodeStream(&state, outSize, &outProcessed);
+	if (res != 0) {
+		printf("lzma: Decoding error = %d\n", res);
+		return 0;
+	}
+	return outProcessed;
+}
@@ -167,8 +167,12 @@ static struct pci_dev *pci_scan_single_bus(struct pci_dev *dev, uint8_t bus)
 					REG_VENDOR_ID);
 
 		if (val == 0xffffffff || val == 0x00000000 ||
-		    val == 0x0000ffff || val == 0xffff0000)
+		    val == 0x0000ffff || val == 0xffff0000) {
+			/* Without function 0 there are no other functions. */
+			if (func == 0)
+				devfn |= 7;
 			continue;
+		}
 
 		dev->next = malloc(sizeof(struct pci_dev));
 		dev = dev->next;
@@ -183,6 +187,8 @@ static struct pci_dev *pci_scan_single_bus(struct pci_dev *dev, uint8_t bus)
 
 		hdr = pci_read_config8(PCI_DEV(bus, slot, func),
 				       REG_HEADER_TYPE);
+		if (func == 0 && !(hdr & HEADER_TYPE_MULTIFUNCTION))
+			devfn |= 7;
 		hdr &= 0x7F;
 
 		if (hdr == HEADER_TYPE_BRIDGE || hdr == HEADER_TYPE_CARDBUS) {
@@ -204,7 +210,7 @@ static struct pci_dev *pci_scan_single_bus(struct pci_dev *dev, uint8_t bus)
 
 void pci_scan_bus(struct pci_access* pacc)
 {
-	struct pci_dev rootdev;
+	struct pci_dev rootdev = { .next = NULL };
 	pci_scan_single_bus(&rootdev, 0);
 	pacc->devices = rootdev.next;
 }
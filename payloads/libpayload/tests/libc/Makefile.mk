@@ -1,3 +1,10 @@
 tests-y += fmap_locate_area-test
 
 fmap_locate_area-test-srcs += tests/libc/fmap_locate_area-test.c
+fmap_locate_area-test-srcs += $(coreboottop)/src/commonlib/bsd/fmap_index.c
+
+tests-y += string-test
+
+string-test-srcs += tests/libc/string-test.c
+string-test-srcs += libc/string.c
+string-test-srcs += libc/memory.c
@@ -19,6 +19,7 @@ static int setup_fmap_test(void **state)
 {
 	reset_fmap_cache();
 	lib_sysinfo.fmap_cache = 0;
+	lib_sysinfo.fmap_cache_size = 0;
 	return 0;
 }
 
@@ -98,6 +99,54 @@ static void test_fmap_locate_area_success(void **state)
 	reset_fmap_cache();
 }
 
+static void test_fmap_locate_area_indexed(void **state)
+{
+	size_t offset = 0;
+	size_t size = 0;
+	char name[FMAP_STRLEN];
+	struct fmap mock_fmap = {
+		.signature = FMAP_SIGNATURE,
+		.ver_major = 1,
+		.ver_minor = 1,
+		.size = 0x100000,
+		.nareas = 20,
+	};
+	u8 fmap_buffer[ALIGN_UP(sizeof(struct fmap) + 20 * sizeof(struct fmap_area), 4) +
+		       (20 * 2 + 1) * sizeof(uint32_t) + 8] __aligned(4);
+	struct fmap *fmap = (struct fmap *)fmap_buffer;
+
+	memset(fmap_buffer, 0, sizeof(fmap_buffer));
+	memcpy(fmap, &mock_fmap, sizeof(mock_fmap));
+	for (int i = 0; i < 20; i++) {
+		snprintf((char *)fmap->areas[i].name, FMAP_STRLEN, "AREA_%d", i);
+		fmap->areas[i].offset = i * 0x1000;
+		fmap->areas[i].size = 0x100 + i;
+	}
+	assert_int_equal(sizeof(fmap_buffer) - ALIGN_UP(sizeof(struct fmap) +
+			 20 * sizeof(struct fmap_area), 4), fmap_index_size(fmap));
+	assert_int_equal(CB_SUCCESS, fmap_index_build(fmap, sizeof(fmap_buffer)));
+
+	reset_fmap_cache();
+	lib_sysinfo.fmap_cache = (uintptr_t)fmap_buffer;
+	lib_sysinfo.fmap_cache_size = sizeof(fmap_buffer);
+
+	for (int i = 0; i < 20; i++) {
+		snprintf(name, sizeof(name), "AREA_%d", i);
+		assert_int_equal(0, fmap_locate_area(name, &offset, &size));
+		assert_int_equal(i * 0x1000, offset);
+		assert_int_equal(0x100 + i, size);
+	}
+	assert_int_equal(-1, fmap_locate_area("AREA_20", &offset, &size));
+
+	/* A corrupted index makes lookups fall back to scanning the areas. */
+	fmap_buffer[sizeof(fmap_buffer) - 1] ^= 0xff;
+	assert_int_equal(0, fmap_locate_area("AREA_7", &offset, &size));
+	assert_int_equal(0x7000, offset);
+	assert_int_equal(-1, fmap_locate_area("AREA_20", &offset, &size));
+
+	reset_fmap_cache();
+}
+
 #define FMAP_LOCATE_AREA_TEST(fn) cmocka_unit_test_setup(fn, setup_fmap_test)
 
 int main(void)
@@ -106,6 +155,7 @@ int main(void)
 		FMAP_LOCATE_AREA_TEST(test_fmap_locate_area_no_fmap_available),
 		FMAP_LOCATE_AREA_TEST(test_fmap_locate_area_incorrect_signature),
 		FMAP_LOCATE_AREA_TEST(test_fmap_locate_area_success),
+		FMAP_LOCATE_AREA_TEST(test_fmap_locate_area_indexed),
 	};
 
 	return lp_run_group_tests(tests, NULL, NULL);
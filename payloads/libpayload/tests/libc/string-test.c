@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <libpayload.h>
+#include <string.h>
+#include <tests/test.h>
+
+/* Mocks */
+int errno;
+
+/*
+ * The string functions look at whole words where they can. Compare them against plain
+ * byte loops for every alignment of the strings and every position of the end.
+ */
+
+#define MAX_OFFSET	(2 * sizeof(unsigned long))
+#define MAX_LEN		(4 * sizeof(unsigned long))
+
+static unsigned long buf1_words[(MAX_OFFSET + MAX_LEN + 1) / sizeof(unsigned long) + 2];
+static unsigned long buf2_words[(MAX_OFFSET + MAX_LEN + 1) / sizeof(unsigned long) + 2];
+
+/* Fills buf with len non-NUL characters followed by a NUL. */
+static char *setup_string(unsigned long *words, size_t offset, size_t len, char fill)
+{
+	char *buf = (char *)words;
+	size_t i;
+
+	memset(words, 0x55, sizeof(buf1_words));
+	for (i = 0; i < len; i++)
+		buf[offset + i] = fill + i % 23;
+	buf[offset + len] = '\0';
+
+	return &buf[offset];
+}
+
+static void test_strlen(void **state)
+{
+	size_t offset, len;
+
+	for (offset = 0; offset < MAX_OFFSET; offset++) {
+		for (len = 0; len < MAX_LEN; len++) {
+			const char *s = setup_string(buf1_words, offset, len, 'a');
+
+			assert_int_equal(len, strlen(s));
+			assert_int_equal(len, strnlen(s, MAX_LEN));
+			assert_int_equal(len ? len - 1 : 0, strnlen(s, len ? len - 1 : 0));
+			assert_int_equal(len / 2, strnlen(s, len / 2));
+		}
+	}
+
+	assert_int_equal(0, strlen(NULL));
+	assert_int_equal(0, strnlen(NULL, 10));
+}
+
+static void test_strcmp(void **state)
+{
+	size_t offset1, offset2, len, i;
+
+	for (offset1 = 0; offset1 < MAX_OFFSET; offset1++) {
+		for (offset2 = 0; offset2 < MAX_OFFSET; offset2++) {
+			for (len = 0; len < MAX_LEN; len++) {
+				char *s1 = setup_string(buf1_words, offset1, len, 'a');
+				char *s2 = setup_string(buf2_words, offset2, len, 'a');
+
+				assert_int_equal(0, strcmp(s1, s2));
+
+				for (i = 0; i < len; i++) {
+					s2[i]++;
+					assert_true(strcmp(s1, s2) < 0);
+					assert_true(strcmp(s2, s1) > 0);
+					s2[i]--;
+				}
+
+				/* A prefix is smaller. */
+				if (len) {
+					s2[len - 1] = '\0';
+					assert_true(strcmp(s1, s2) > 0);
+					assert_true(strcmp(s2, s1) < 0);
+				}
+			}
+		}
+	}
+}
+
+static void test_strchr(void **state)
+{
+	size_t offset, len, i;
+
+	for (offset = 0; offset < MAX_OFFSET; offset++) {
+		for (len = 0; len < MAX_LEN; len++) {
+			char *s = setup_string(buf1_words, offset, len, 'a');
+
+			/* Not in the string, but right behind the NUL */
+			s[len + 1] = 'A';
+			assert_null(strchr(s, 'A'));
+			/* Like before, the terminating NUL is never found. */
+			assert_null(strchr(s, '\0'));
+
+			for (i = 0; i < len; i++) {
+				const char c = s[i];
+				s[i] = 'A';
+				assert_ptr_equal(&s[i], strchr(s, 'A'));
+				s[i] = c;
+			}
+		}
+	}
+}
+
+static void test_memchr(void **state)
+{
+	size_t offset, len, i;
+	char *s;
+
+	for (offset = 0; offset < MAX_OFFSET; offset++) {
+		for (len = 0; len < MAX_LEN; len++) {
+			s = setup_string(buf1_words, offset, len, 'a');
+
+			/* Just outside of the area */
+			s[len] = 'A';
+			assert_null(memchr(s, 'A', len));
+			if (offset)
+				s[-1] = 'A';
+			assert_null(memchr(s, 'A', len));
+
+			for (i = 0; i < len; i++) {
+				const char c = s[i];
+				s[i] = 'A';
+				assert_ptr_equal(&s[i], memchr(s, 'A', len));
+				s[i] = c;
+			}
+		}
+	}
+
+	/* Characters are compared as unsigned char. */
+	s = setup_string(buf1_words, 0, MAX_LEN, 'a');
+	s[5] = (char)0xc3;
+	assert_ptr_equal(&s[5], memchr(s, 0xc3, MAX_LEN));
+	assert_ptr_equal(&s[5], memchr(s, 0x1c3, MAX_LEN));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_strlen),
+		cmocka_unit_test(test_strcmp),
+		cmocka_unit_test(test_strchr),
+		cmocka_unit_test(test_memchr),
+	};
+
+	return lp_run_group_tests(tests, NULL, NULL);
+}
@@ -16,7 +16,9 @@
 #include <acpi/acpi.h>
 #include <acpi/acpi_iort.h>
 #include <acpi/acpi_ivrs.h>
+#include <acpi/acpi_ssdt_cache.h>
 #include <acpi/acpigen.h>
+#include <bootmem.h>
 #include <cbfs.h>
 #include <cbmem.h>
 #include <commonlib/helpers.h>
@@ -32,6 +34,10 @@
 #include <types.h>
 #include <version.h>
 
+#if ENV_X86
+#include <cpu/x86/lapic.h>
+#endif
+
 static acpi_rsdp_t *valid_rsdp(acpi_rsdp_t *rsdp);
 
 u8 acpi_checksum(u8 *table, u32 length)
@@ -317,10 +323,18 @@ static void acpi_ssdt_write_cbtable(void)
 static void acpi_create_ssdt_generator(acpi_header_t *ssdt, void *unused)
 {
 	unsigned long current = (unsigned long)ssdt + sizeof(acpi_header_t);
+	const unsigned long body = current;
+	size_t cached_size;
 
 	if (acpi_fill_header(ssdt, "SSDT", SSDT, sizeof(acpi_header_t)) != CB_SUCCESS)
 		return;
 
+	cached_size = acpi_ssdt_cache_load((void *)body);
+	if (cached_size) {
+		ssdt->length = sizeof(acpi_header_t) + cached_size;
+		return;
+	}
+
 	acpigen_set_current((char *)current);
 
 	/* Write object to declare coreboot tables */
@@ -334,6 +348,8 @@ static void acpi_create_ssdt_generator(acpi_header_t *ssdt, void *unused)
 		current = (unsigned long)acpigen_get_current();
 	}
 
+	acpi_ssdt_cache_stash((void *)body, current - body);
+
 	/* (Re)calculate length and checksum. */
 	ssdt->length = current - (unsigned long)ssdt;
 }
@@ -375,6 +391,50 @@ int acpi_create_srat_gia_pci(acpi_srat_gia_t *gia, u32 proximity_domain,
 	return gia->length;
 }
 
+/* Tell bootmem which memory is local to which CPUs, so that it can prefer BSP local memory. */
+static void acpi_srat_register_domains(const acpi_srat_t *srat)
+{
+	uintptr_t current = (uintptr_t)srat + sizeof(acpi_srat_t);
+	const uintptr_t end = (uintptr_t)srat + srat->header.length;
+
+	while (current + 2 <= end) {
+		const u8 type = *(const u8 *)current;
+		const u8 length = *(const u8 *)(current + 1);
+
+		if (!length || current + length > end)
+			break;
+
+		if (type == ACPI_SRAT_STRUCTURE_MEM && length >= sizeof(acpi_srat_mem_t)) {
+			const acpi_srat_mem_t *mem = (const acpi_srat_mem_t *)current;
+			const uint64_t base = (uint64_t)mem->base_address_high << 32 |
+					      mem->base_address_low;
+			const uint64_t size = (uint64_t)mem->length_high << 32 |
+					      mem->length_low;
+
+			if ((mem->flags & ACPI_SRAT_MEMORY_ENABLED) && size)
+				bootmem_add_proximity_domain(base, size, mem->proximity_domain);
+		}
+#if ENV_X86
+		if (type == ACPI_SRAT_STRUCTURE_LAPIC && length >= sizeof(acpi_srat_lapic_t)) {
+			const acpi_srat_lapic_t *lapic = (const acpi_srat_lapic_t *)current;
+
+			if (lapic->apic_id == lapicid())
+				bootmem_set_bsp_proximity_domain(lapic->proximity_domain_7_0 |
+					lapic->proximity_domain_31_8[0] << 8 |
+					lapic->proximity_domain_31_8[1] << 16 |
+					lapic->proximity_domain_31_8[2] << 24);
+		}
+		if (type == ACPI_SRAT_STRUCTURE_X2APIC && length >= sizeof(acpi_srat_x2apic_t)) {
+			const acpi_srat_x2apic_t *x2apic = (const acpi_srat_x2apic_t *)current;
+
+			if (x2apic->x2apic_id == lapicid())
+				bootmem_set_bsp_proximity_domain(x2apic->proximity_domain);
+		}
+#endif
+		current += length;
+	}
+}
+
 /* http://www.microsoft.com/whdc/system/sysinternals/sratdwn.mspx */
 void acpi_create_srat(acpi_srat_t *srat,
 		      unsigned long (*acpi_fill_srat)(unsigned long current))
@@ -394,6 +454,8 @@ void acpi_create_srat(acpi_srat_t *srat,
 	/* (Re)calculate length and checksum. */
 	header->length = current - (unsigned long)srat;
 	header->checksum = acpi_checksum((void *)srat, header->length);
+
+	acpi_srat_register_domains(srat);
 }
 
 int acpi_create_cedt_chbs(acpi_cedt_chbs_t *chbs, u32 uid, u32 cxl_ver, u64 base)
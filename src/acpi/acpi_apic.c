@@ -3,7 +3,6 @@
 #include <acpi/acpi.h>
 #include <arch/ioapic.h>
 #include <arch/smp/mpspec.h>
-#include <commonlib/sort.h>
 #include <cpu/cpu.h>
 #include <device/device.h>
 
@@ -32,7 +31,8 @@ static int acpi_create_madt_lx2apic(acpi_madt_lx2apic_t *lapic, u32 cpu, u32 api
 
 unsigned long acpi_create_madt_one_lapic(unsigned long current, u32 index, u32 lapic_id)
 {
-	if (lapic_id <= ACPI_MADT_MAX_LAPIC_ID)
+	/* The processor UID of a LAPIC entry is only 8 bits wide. */
+	if (lapic_id <= ACPI_MADT_MAX_LAPIC_ID && index <= UINT8_MAX)
 		current += acpi_create_madt_lapic((acpi_madt_lapic_t *)current, index,
 						  lapic_id);
 	else
@@ -42,8 +42,6 @@ unsigned long acpi_create_madt_one_lapic(unsigned long current, u32 index, u32 l
 	return current;
 }
 
-/* Increase if necessary. Currently all x86 CPUs only have 2 SMP threads */
-#define MAX_THREAD_ID 1
 /*
  * From ACPI 6.4 spec:
  * "The advent of multi-threaded processors yielded multiple logical processors
@@ -58,25 +56,55 @@ unsigned long acpi_create_madt_one_lapic(unsigned long current, u32 index, u32 l
  * second logical processors. This approach should be used for all successive
  * logical processors."
  */
-static unsigned long acpi_create_madt_lapics(unsigned long current)
+size_t acpi_get_madt_cpus(const struct device *const **cpus)
 {
-	struct device *cpu;
-	int index, apic_ids[CONFIG_MAX_CPUS] = {0}, num_cpus = 0, sort_start = 0;
-	for (unsigned int thread_id = 0; thread_id <= MAX_THREAD_ID; thread_id++) {
+	/* The CPU devices don't change after enumeration, so one list serves all tables. */
+	static const struct device *madt_cpus[CONFIG_MAX_CPUS];
+	static size_t num_cpus;
+	static bool done;
+	const struct device *cpu;
+	unsigned int thread_id;
+	bool more = true;
+
+	for (thread_id = 0; !done && more; thread_id++) {
+		const size_t start = num_cpus;
+
+		more = false;
 		for (cpu = all_devices; cpu; cpu = cpu->next) {
 			if (!is_enabled_cpu(cpu))
 				continue;
-			if (num_cpus >= ARRAY_SIZE(apic_ids))
-				break;
+			if (cpu->path.apic.thread_id > thread_id)
+				more = true;
 			if (cpu->path.apic.thread_id != thread_id)
 				continue;
-			apic_ids[num_cpus++] = cpu->path.apic.apic_id;
+			if (num_cpus >= ARRAY_SIZE(madt_cpus))
+				break;
+
+			/*
+			 * Insertion sort by APIC ID. The devices of one thread ID are
+			 * usually in order already, which makes this linear.
+			 */
+			size_t i = num_cpus++;
+			for (; i > start && madt_cpus[i - 1]->path.apic.apic_id >
+			       cpu->path.apic.apic_id; i--)
+				madt_cpus[i] = madt_cpus[i - 1];
+			madt_cpus[i] = cpu;
 		}
-		bubblesort(&apic_ids[sort_start], num_cpus - sort_start, NUM_ASCENDING);
-		sort_start = num_cpus;
 	}
-	for (index = 0; index < num_cpus; index++)
-		current = acpi_create_madt_one_lapic(current, index, apic_ids[index]);
+	done = true;
+
+	*cpus = madt_cpus;
+	return num_cpus;
+}
+
+static unsigned long acpi_create_madt_lapics(unsigned long current)
+{
+	const struct device *const *cpus;
+	const size_t num_cpus = acpi_get_madt_cpus(&cpus);
+
+	for (size_t index = 0; index < num_cpus; index++)
+		current = acpi_create_madt_one_lapic(current, index,
+						     cpus[index]->path.apic.apic_id);
 
 	return current;
 }
@@ -15,6 +15,7 @@
 #include <device/device.h>
 #include <device/soundwire.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <types.h>
 
 static char *gencurrent;
@@ -32,6 +33,39 @@ void acpigen_write_len_f(void)
 		acpigen_emit_byte(0);
 }
 
+/*
+ * Emit the PkgLength of an object whose remaining length |len| (everything after
+ * the PkgLength bytes) is already known. Unlike acpigen_write_len_f() this needs no
+ * acpigen_pop_len() and thus no fixup or payload move afterwards.
+ */
+void acpigen_write_len(size_t len)
+{
+	if (len + 1 <= 0x3f) {
+		acpigen_emit_byte(len + 1);
+	} else if (len + 2 <= 0xfff) {
+		len += 2;
+		acpigen_emit_byte(0x1 << 6 | (len & 0xf));
+		acpigen_emit_byte(len >> 4 & 0xff);
+	} else if (len + 3 <= 0xfffff) {
+		len += 3;
+		acpigen_emit_byte(0x2 << 6 | (len & 0xf));
+		acpigen_emit_byte(len >> 4 & 0xff);
+		acpigen_emit_byte(len >> 12 & 0xff);
+	} else {
+		printk(BIOS_ERR, "%s: package length exceeds maximum of 0xfffff.\n", __func__);
+	}
+}
+
+/* Number of bytes acpigen_write_len() emits for |len|. */
+static size_t acpigen_len_size(size_t len)
+{
+	if (len + 1 <= 0x3f)
+		return 1;
+	if (len + 2 <= 0xfff)
+		return 2;
+	return 3;
+}
+
 void acpigen_pop_len(void)
 {
 	size_t len;
@@ -111,16 +145,18 @@ void acpigen_emit_ext_op(uint8_t op)
 
 void acpigen_emit_word(unsigned int data)
 {
-	acpigen_emit_byte(data & 0xff);
-	acpigen_emit_byte((data >> 8) & 0xff);
+	gencurrent[0] = data & 0xff;
+	gencurrent[1] = (data >> 8) & 0xff;
+	gencurrent += 2;
 }
 
 void acpigen_emit_dword(unsigned int data)
 {
-	acpigen_emit_byte(data & 0xff);
-	acpigen_emit_byte((data >> 8) & 0xff);
-	acpigen_emit_byte((data >> 16) & 0xff);
-	acpigen_emit_byte((data >> 24) & 0xff);
+	gencurrent[0] = data & 0xff;
+	gencurrent[1] = (data >> 8) & 0xff;
+	gencurrent[2] = (data >> 16) & 0xff;
+	gencurrent[3] = (data >> 24) & 0xff;
+	gencurrent += 4;
 }
 
 char *acpigen_write_package(int nr_el)
@@ -236,9 +272,36 @@ void acpigen_write_name_unicode(const char *name, const char *string)
 
 void acpigen_emit_stream(const char *data, int size)
 {
-	int i;
-	for (i = 0; i < size; i++)
-		acpigen_emit_byte(data[i]);
+	if (size <= 0)
+		return;
+	memcpy(gencurrent, data, size);
+	gencurrent += size;
+}
+
+bool acpigen_template_replay(const struct acpigen_template *tmpl)
+{
+	if (!tmpl->data)
+		return false;
+
+	acpigen_emit_stream(tmpl->data, tmpl->len);
+	return true;
+}
+
+void acpigen_template_begin(struct acpigen_template *tmpl)
+{
+	tmpl->start = gencurrent;
+}
+
+void acpigen_template_end(struct acpigen_template *tmpl)
+{
+	/*
+	 * Keep a copy, since closing an enclosing scope with acpigen_pop_len()
+	 * may still move the bytes in the output buffer.
+	 */
+	tmpl->len = gencurrent - tmpl->start;
+	tmpl->data = malloc(tmpl->len);
+	if (tmpl->data)
+		memcpy(tmpl->data, tmpl->start, tmpl->len);
 }
 
 void acpigen_emit_string(const char *string)
@@ -273,14 +336,13 @@ void acpigen_write_coreboot_hid(enum coreboot_acpi_ids id)
 static void acpigen_emit_simple_namestring(const char *name)
 {
 	int i;
-	char ud[] = "____";
+	char seg[4] = "____";
 	for (i = 0; i < 4; i++) {
-		if ((name[i] == '\0') || (name[i] == '.')) {
-			acpigen_emit_stream(ud, 4 - i);
+		if ((name[i] == '\0') || (name[i] == '.'))
 			break;
-		}
-		acpigen_emit_byte(name[i]);
+		seg[i] = name[i];
 	}
+	acpigen_emit_stream(seg, sizeof(seg));
 }
 
 static void acpigen_emit_double_namestring(const char *name, int dotpos)
@@ -1016,17 +1078,21 @@ void acpigen_write_PRW(u32 wake, u32 level)
 	acpigen_pop_len();
 }
 
+/* NumElements followed by six DWORD constants */
+#define PSS_PACKAGE_LEN		(1 + 6 * 5)
+
 void acpigen_write_PSS_package(u32 coreFreq, u32 power, u32 transLat, u32 busmLat, u32 control,
 			       u32 status)
 {
-	acpigen_write_package(6);
+	acpigen_emit_byte(PACKAGE_OP);
+	acpigen_write_len(PSS_PACKAGE_LEN);
+	acpigen_emit_byte(6);
 	acpigen_write_dword(coreFreq);
 	acpigen_write_dword(power);
 	acpigen_write_dword(transLat);
 	acpigen_write_dword(busmLat);
 	acpigen_write_dword(control);
 	acpigen_write_dword(status);
-	acpigen_pop_len();
 
 	printk(BIOS_DEBUG, "PSS: %uMHz power %u control 0x%x status 0x%x\n", coreFreq, power,
 	       control, status);
@@ -1034,10 +1100,14 @@ void acpigen_write_PSS_package(u32 coreFreq, u32 power, u32 transLat, u32 busmLa
 
 void acpigen_write_pss_object(const struct acpi_sw_pstate *pstate_values, size_t nentries)
 {
+	const size_t entry_len = 1 + acpigen_len_size(PSS_PACKAGE_LEN) + PSS_PACKAGE_LEN;
 	size_t pstate;
 
 	acpigen_write_name("_PSS");
-	acpigen_write_package(nentries);
+	/* All entries have the same size, so the package length is known up front. */
+	acpigen_emit_byte(PACKAGE_OP);
+	acpigen_write_len(1 + nentries * entry_len);
+	acpigen_emit_byte(nentries);
 	for (pstate = 0; pstate < nentries; pstate++) {
 		acpigen_write_PSS_package(
 			pstate_values->core_freq, pstate_values->power,
@@ -1045,8 +1115,6 @@ void acpigen_write_pss_object(const struct acpi_sw_pstate *pstate_values, size_t
 			pstate_values->control_value, pstate_values->status_value);
 		pstate_values++;
 	}
-
-	acpigen_pop_len();
 }
 
 void acpigen_write_PSD_package(u32 domain, u32 numprocs, PSD_coord coordtype)
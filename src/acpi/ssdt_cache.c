@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <acpi/acpi_ssdt_cache.h>
+#include <bootstate.h>
+#include <cbmem.h>
+#include <console/console.h>
+#include <device/device.h>
+#include <fmap.h>
+#include <fw_config.h>
+#include <hw_fingerprint.h>
+#include <region_file.h>
+#include <string.h>
+#include <types.h>
+#include <version.h>
+#include <xxhash.h>
+
+#define SSDT_CACHE_SIGNATURE	(('S'<<0)|('S'<<8)|('D'<<16)|('C'<<24))
+
+struct ssdt_cache_metadata {
+	uint32_t signature;
+	uint32_t data_size;
+	uint64_t key;
+	uint64_t data_hash;
+} __packed;
+
+static uint64_t cache_key;
+static bool cache_key_valid;
+static const void *pending_body;
+static size_t pending_size;
+
+static void hash_u64(struct xxh64_state *state, uint64_t value)
+{
+	xxh64_update(state, &value, sizeof(value));
+}
+
+static void hash_str(struct xxh64_state *state, const char *str)
+{
+	xxh64_update(state, str, strlen(str) + 1);
+}
+
+/*
+ * Everything the acpi_fill_ssdt() callbacks are allowed to depend on when
+ * the cache is enabled goes into the key.
+ */
+static uint64_t ssdt_cache_compute_key(void)
+{
+	const struct cbmem_entry *cbtable;
+	const struct resource *res;
+	struct xxh64_state state;
+	struct device *dev;
+
+	xxh64_reset(&state, 0);
+
+	hash_str(&state, coreboot_version);
+	hash_str(&state, coreboot_build);
+
+	if (CONFIG(FW_CONFIG))
+		hash_u64(&state, fw_config_get());
+
+	if (CONFIG(HW_FINGERPRINT))
+		hash_u64(&state, hw_fingerprint());
+
+	cbtable = cbmem_entry_find(CBMEM_ID_CBTABLE);
+	if (cbtable) {
+		hash_u64(&state, (uintptr_t)cbmem_entry_start(cbtable));
+		hash_u64(&state, cbmem_entry_size(cbtable));
+	}
+
+	for (dev = all_devices; dev; dev = dev->next) {
+		hash_str(&state, dev_path(dev));
+		hash_u64(&state, dev->enabled);
+		hash_u64(&state, dev->vendor);
+		hash_u64(&state, dev->device);
+		hash_u64(&state, dev->subsystem_vendor);
+		hash_u64(&state, dev->subsystem_device);
+
+		for (res = dev->resource_list; res; res = res->next) {
+			hash_u64(&state, res->index);
+			hash_u64(&state, res->flags);
+			hash_u64(&state, res->base);
+			hash_u64(&state, res->size);
+		}
+	}
+
+	return xxh64_digest(&state);
+}
+
+size_t acpi_ssdt_cache_load(void *body)
+{
+	struct region_device rdev, data;
+	struct ssdt_cache_metadata md;
+	struct region_file file;
+
+	cache_key = ssdt_cache_compute_key();
+	cache_key_valid = true;
+
+	if (fmap_locate_area_as_rdev(CONFIG_ACPI_SSDT_CACHE_FMAP_NAME, &rdev) < 0) {
+		printk(BIOS_ERR, "ACPI: SSDT cache region '%s' not found\n",
+		       CONFIG_ACPI_SSDT_CACHE_FMAP_NAME);
+		return 0;
+	}
+
+	if (region_file_init(&file, &rdev) < 0 || region_file_data(&file, &data) < 0)
+		return 0;
+
+	if (rdev_readat(&data, &md, 0, sizeof(md)) != sizeof(md) ||
+	    md.signature != SSDT_CACHE_SIGNATURE)
+		return 0;
+
+	if (md.key != cache_key) {
+		printk(BIOS_INFO, "ACPI: SSDT cache is stale\n");
+		return 0;
+	}
+
+	if (sizeof(md) + md.data_size > region_device_sz(&data) ||
+	    rdev_readat(&data, body, sizeof(md), md.data_size) != md.data_size)
+		return 0;
+
+	if (xxh64(body, md.data_size, 0) != md.data_hash) {
+		printk(BIOS_ERR, "ACPI: SSDT cache data hash mismatch\n");
+		return 0;
+	}
+
+	printk(BIOS_DEBUG, "ACPI: Using cached SSDT (%u bytes)\n", md.data_size);
+
+	return md.data_size;
+}
+
+void acpi_ssdt_cache_stash(const void *body, size_t size)
+{
+	pending_body = body;
+	pending_size = size;
+}
+
+/*
+ * The generated SSDT stays in CBMEM until the OS takes over, so the flash
+ * update can wait until all tables are written.
+ */
+static void ssdt_cache_update(void *unused)
+{
+	struct update_region_file_entry entries[2];
+	struct ssdt_cache_metadata md;
+	struct region_device rdev;
+	struct region_file file;
+
+	if (!pending_body || !cache_key_valid)
+		return;
+
+	md = (struct ssdt_cache_metadata) {
+		.signature = SSDT_CACHE_SIGNATURE,
+		.data_size = pending_size,
+		.key = cache_key,
+		.data_hash = xxh64(pending_body, pending_size, 0),
+	};
+
+	if (fmap_locate_area_as_rdev_rw(CONFIG_ACPI_SSDT_CACHE_FMAP_NAME, &rdev) < 0 ||
+	    region_file_init(&file, &rdev) < 0) {
+		printk(BIOS_ERR, "ACPI: SSDT cache region unusable\n");
+		return;
+	}
+
+	entries[0] = (struct update_region_file_entry) { sizeof(md), &md };
+	entries[1] = (struct update_region_file_entry) { pending_size, pending_body };
+
+	if (region_file_update_data_arr(&file, entries, ARRAY_SIZE(entries)) < 0)
+		printk(BIOS_ERR, "ACPI: Failed to update SSDT cache\n");
+	else
+		printk(BIOS_DEBUG, "ACPI: Updated SSDT cache (%zu bytes)\n", pending_size);
+
+	pending_body = NULL;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_EXIT, ssdt_cache_update, NULL);
@@ -15,6 +15,12 @@
  * value on stage transition, so we still need to check it for UNUSED_DESC. */
 static uint64_t *next_free_table = (void *)_ttb;
 
+/* Nesting depth of mmu_config_begin(), TLB maintenance is deferred while > 0. */
+static int batch_depth;
+
+/* Number of adjacent entries that can share a TLB entry with the contiguous hint. */
+#define CONTIG_ENTRIES	16
+
 static void print_tag(int level, uint64_t tag)
 {
 	printk(level, tag & MA_MEM_NC ? "non-cacheable | " :
@@ -53,6 +59,21 @@ static uint64_t get_block_attr(unsigned long tag)
 	return attr;
 }
 
+/* Func : clear_contiguous
+ * Desc : Drop the contiguous hint from the group of entries containing entry.
+ * The hint is only valid while all entries of a group agree, so it has to go
+ * before any single one of them is changed.
+ */
+static void clear_contiguous(uint64_t *entry)
+{
+	uint64_t *group = (uint64_t *)ALIGN_DOWN((uintptr_t)entry,
+						 CONTIG_ENTRIES * sizeof(*entry));
+	int i;
+
+	for (i = 0; i < CONTIG_ENTRIES; i++)
+		group[i] &= ~BLOCK_CONTIGUOUS;
+}
+
 /* Func : setup_new_table
  * Desc : Get next free table from TTB and set it up to match old parent entry.
  */
@@ -75,6 +96,7 @@ static uint64_t *setup_new_table(uint64_t desc, size_t xlat_size)
 		/* Can reuse old parent entry, but may need to adjust type. */
 		if (xlat_size == L3_XLAT_SIZE)
 			desc |= PAGE_DESC;
+		desc &= ~BLOCK_CONTIGUOUS;
 
 		int i = 0;
 		for (; i < GRANULE_SIZE/sizeof(*next_free_table); i++) {
@@ -96,6 +118,7 @@ static uint64_t *get_next_level_table(uint64_t *ptr, size_t xlat_size)
 
 	if ((desc & DESC_MASK) != TABLE_DESC) {
 		uint64_t *new_table = setup_new_table(desc, xlat_size);
+		clear_contiguous(ptr);
 		desc = ((uint64_t)new_table) | TABLE_DESC;
 		*ptr = desc;
 	}
@@ -131,6 +154,7 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 			 * or equal to size addressed by each L1 entry, we can
 			 * directly store a block desc */
 			desc = base_addr | BLOCK_DESC | attr;
+			clear_contiguous(&table[l1_index]);
 			table[l1_index] = desc;
 			/* L2 lookup is not required */
 			return L1_XLAT_SIZE;
@@ -146,6 +170,7 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 		 * or equal to size addressed by each L2 entry, we can
 		 * directly store a block desc */
 		desc = base_addr | BLOCK_DESC | attr;
+		clear_contiguous(&table[l2_index]);
 		table[l2_index] = desc;
 		/* L3 lookup is not required */
 		return L2_XLAT_SIZE;
@@ -156,6 +181,7 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 
 	/* L3 table lookup */
 	desc = base_addr | PAGE_DESC | attr;
+	clear_contiguous(&table[l3_index]);
 	table[l3_index] = desc;
 	return L3_XLAT_SIZE;
 }
@@ -201,6 +227,105 @@ static void assert_correct_ttb_mapping(void *addr)
 	       == BLOCK_INDEX_MEM_NORMAL && !(pte & BLOCK_NS));
 }
 
+/* Func : uniform_desc
+ * Desc : If all entries of table map one naturally aligned range with the same
+ * attributes, return the block descriptor for the parent entry that replaces
+ * the table. Otherwise return INVALID_DESC.
+ */
+static uint64_t uniform_desc(const uint64_t *table, uint64_t xlat_size,
+			     uint64_t type)
+{
+	const uint64_t first = table[0] & ~BLOCK_CONTIGUOUS;
+	int i;
+
+	if ((first & DESC_MASK) != type ||
+	    !IS_ALIGNED(first & XLAT_ADDR_MASK, xlat_size << BITS_RESOLVED_PER_LVL))
+		return INVALID_DESC;
+
+	for (i = 1; i < GRANULE_SIZE/sizeof(*table); i++) {
+		if ((table[i] & ~BLOCK_CONTIGUOUS) != first + i * xlat_size)
+			return INVALID_DESC;
+	}
+
+	return (first & ~DESC_MASK) | BLOCK_DESC;
+}
+
+/* Func : set_contiguous
+ * Desc : Set the contiguous hint on every aligned group of entries that maps
+ * one contiguous range with the same attributes, clear it everywhere else.
+ */
+static void set_contiguous(uint64_t *table, uint64_t xlat_size, uint64_t type)
+{
+	int i, j;
+
+	for (i = 0; i < GRANULE_SIZE/sizeof(*table); i += CONTIG_ENTRIES) {
+		const uint64_t first = table[i] & ~BLOCK_CONTIGUOUS;
+		bool contiguous = (first & DESC_MASK) == type &&
+			IS_ALIGNED(first & XLAT_ADDR_MASK, xlat_size * CONTIG_ENTRIES);
+
+		for (j = 1; contiguous && j < CONTIG_ENTRIES; j++)
+			contiguous = (table[i + j] & ~BLOCK_CONTIGUOUS) ==
+				     first + j * xlat_size;
+
+		for (j = 0; j < CONTIG_ENTRIES; j++) {
+			if (contiguous)
+				table[i + j] |= BLOCK_CONTIGUOUS;
+			else
+				table[i + j] &= ~BLOCK_CONTIGUOUS;
+		}
+	}
+}
+
+/* Func : optimize_table
+ * Desc : Recursively replace next level tables that turned out to be uniform
+ * with blocks and set the contiguous hints. xlat_size is the size mapped by
+ * each entry of table. Returns the number of tables that were replaced. Those
+ * are not reused, since entries may still be cached until the TLB is flushed.
+ */
+static int optimize_table(uint64_t *table, uint64_t xlat_size)
+{
+	const uint64_t next_size = xlat_size >> BITS_RESOLVED_PER_LVL;
+	int merged = 0;
+	int i;
+
+	for (i = 0; i < GRANULE_SIZE/sizeof(*table); i++) {
+		uint64_t *next, desc;
+
+		if (xlat_size == L3_XLAT_SIZE || (table[i] & DESC_MASK) != TABLE_DESC)
+			continue;
+
+		next = (uint64_t *)(table[i] & XLAT_ADDR_MASK);
+		merged += optimize_table(next, next_size);
+
+		/* L0 entries can't hold blocks. */
+		if (xlat_size == L0_XLAT_SIZE)
+			continue;
+
+		desc = uniform_desc(next, next_size,
+				    next_size == L3_XLAT_SIZE ? PAGE_DESC : BLOCK_DESC);
+		if (desc != INVALID_DESC) {
+			table[i] = desc;
+			merged++;
+		}
+	}
+
+	if (xlat_size == L2_XLAT_SIZE)
+		set_contiguous(table, xlat_size, BLOCK_DESC);
+	else if (xlat_size == L3_XLAT_SIZE)
+		set_contiguous(table, xlat_size, PAGE_DESC);
+
+	return merged;
+}
+
+static void mmu_sync(void)
+{
+	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
+	dsb();
+	tlbiall();
+	dsb();
+	isb();
+}
+
 /* Func : mmu_config_range
  * Desc : This function repeatedly calls init_xlat_table with the base
  * address. Based on size returned from init_xlat_table, base_addr is updated
@@ -222,11 +347,28 @@ void mmu_config_range(void *start, size_t size, uint64_t tag)
 		temp_size -= init_xlat_table(base_addr + (size - temp_size),
 					     temp_size, tag);
 
-	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
-	dsb();
-	tlbiall();
-	dsb();
-	isb();
+	if (!batch_depth)
+		mmu_sync();
+}
+
+void mmu_config_begin(void)
+{
+	batch_depth++;
+}
+
+void mmu_config_end(void)
+{
+	int merged;
+
+	assert(batch_depth > 0);
+	if (--batch_depth)
+		return;
+
+	merged = optimize_table((uint64_t *)_ttb, L0_XLAT_SIZE);
+	if (merged)
+		printk(BIOS_DEBUG, "Merged %d page tables into blocks\n", merged);
+
+	mmu_sync();
 }
 
 /* Func : mmu_init
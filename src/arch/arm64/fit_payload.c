@@ -205,8 +205,13 @@ bool fit_payload_arch(struct prog *payload, struct fit_config_node *config,
 	printk(BIOS_DEBUG, "FIT: Placing FDT and INITRD %s\n",
 	       place_anywhere ? "anywhere" : "on top of kernel");
 
-	/* Place INITRD */
-	if (config->ramdisk) {
+	/* Older kernels need the INITRD above them, wherever it was loaded. */
+	if (initrd->offset && !place_anywhere &&
+	    initrd->offset < kernel->offset + kernel->size)
+		initrd->offset = 0;
+
+	/* Place INITRD, unless it can stay where it is */
+	if (config->ramdisk && !initrd->offset) {
 		if (place_anywhere)
 			initrd->offset = 0;
 		else
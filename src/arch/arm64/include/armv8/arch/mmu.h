@@ -40,6 +40,7 @@
 
 #define BLOCK_ACCESS               (1 << 10)
 
+#define BLOCK_CONTIGUOUS           (1UL << 52)
 #define BLOCK_XN                   (1UL << 54)
 
 #define BLOCK_SH_SHIFT                 (8)
@@ -148,6 +149,14 @@ void mmu_save_context(struct mmu_context *mmu_context);
 void mmu_restore_context(const struct mmu_context *mmu_context);
 /* Change a memory type for a range of bytes at runtime. */
 void mmu_config_range(void *start, size_t size, uint64_t tag);
+/*
+ * Batch several mmu_config_range() calls. Between mmu_config_begin() and
+ * mmu_config_end() no TLB maintenance is done. mmu_config_end() merges
+ * uniform tables back into blocks, sets the contiguous hint where possible
+ * and then does one TLB invalidation for the whole batch. Batches may nest.
+ */
+void mmu_config_begin(void);
+void mmu_config_end(void);
 /* Enable the MMU (need previous mmu_init() and configured ranges!). */
 void mmu_enable(void);
 /* Disable the MMU (which also disables dcache but not icache). */
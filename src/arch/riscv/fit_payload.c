@@ -94,8 +94,8 @@ bool fit_payload_arch(struct prog *payload, struct fit_config_node *config,
 
 	/* Place FDT and INITRD after kernel. */
 
-	/* Place INITRD */
-	if (config->ramdisk) {
+	/* Place INITRD, unless it can stay where it is */
+	if (config->ramdisk && !initrd->offset) {
 		initrd->offset = kernel->offset + kernel->size;
 
 		if (!bootmem_walk(fit_place_mem, initrd))
@@ -23,4 +23,10 @@ void setup_pmp(u64 base, u64 size, u8 flags);
 /* write the last PMP record, i.e. the "default" case. */
 void close_pmp(void);
 
+/*
+ * write the PMP records set up so far to the current hart, e.g. from
+ * smp_run_on_harts after the working hart did the setup once.
+ */
+void pmp_apply(void);
+
 #endif /* __RISCV_PMP_H__ */
@@ -10,6 +10,14 @@
  */
 void smp_pause(int working_hartid);
 
+/*
+ * Runs fn(arg) on every hart, including the calling one, and returns once
+ * all of them are done. Can only be called by the working hart between
+ * smp_pause and smp_resume. The harts run fn concurrently, so it must
+ * only touch state that is per hart or protected by a lock.
+ */
+void smp_run_on_harts(void (*fn)(void *), void *arg);
+
 /*
  * This function is used to wake up the harts that are halted by the
  * smp_pause function. And this function will not return, all hart will
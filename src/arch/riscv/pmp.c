@@ -3,6 +3,7 @@
 #include <arch/encoding.h>
 #include <stdint.h>
 #include <arch/pmp.h>
+#include <arch/smp/spinlock.h>
 #include <console/console.h>
 #include <commonlib/helpers.h>
 
@@ -28,6 +29,16 @@ struct pmpcfg {
 /* This variable is used to record which entries have been used. */
 static uintptr_t pmp_entry_used_mask;
 
+/*
+ * The values setup_pmp has written, by entry. All harts share them, so
+ * harts setting up the same ranges end up with the same layout, and
+ * pmp_apply can copy it to a hart that did not set it up itself.
+ */
+#define PMP_MAX_ENTRIES	16
+static uintptr_t pmp_cfg_record[PMP_MAX_ENTRIES];
+static uintptr_t pmp_addr_record[PMP_MAX_ENTRIES];
+static spinlock_t pmp_lock;
+
 /* The architectural spec says that up to 16 PMP entries are
  * available.
  * "Up to 16 PMP entries are supported. If any PMP  entries are
@@ -287,7 +298,7 @@ static int generate_pmp(struct pmpcfg *p, u64 base, u64 size, u8 flags)
 static int find_empty_pmp_entry(int is_range)
 {
 	int free_entries = 0;
-	for (int i = 0; i < pmp_entries_num(); i++) {
+	for (int i = 0; i < MIN(pmp_entries_num(), PMP_MAX_ENTRIES); i++) {
 		if (pmp_entry_used_mask & (1 << i))
 			free_entries = 0;
 		else
@@ -314,6 +325,24 @@ static void mask_pmp_entry_used(int idx)
 	pmp_entry_used_mask |= 1 << idx;
 }
 
+/*
+ * find the entry another hart already set up with the same record
+ * returns -1 if there is none
+ */
+static int find_recorded_pmp_entry(const struct pmpcfg *p, int is_range)
+{
+	for (int i = is_range; i < PMP_MAX_ENTRIES; i++) {
+		if (!(pmp_entry_used_mask & (1 << i)))
+			continue;
+		if (pmp_cfg_record[i] != p->cfg || pmp_addr_record[i] != p->address)
+			continue;
+		if (is_range && pmp_addr_record[i - 1] != p->previous_address)
+			continue;
+		return i;
+	}
+	return -1;
+}
+
 /* reset PMP setting */
 void reset_pmp(void)
 {
@@ -347,7 +376,23 @@ void setup_pmp(u64 base, u64 size, u8 flags)
 
 	is_range = ((p.cfg & PMP_A) == PMP_TOR);
 
-	n = find_empty_pmp_entry(is_range);
+	spinlock_lock(&pmp_lock);
+
+	n = find_recorded_pmp_entry(&p, is_range);
+	if (n < 0) {
+		n = find_empty_pmp_entry(is_range);
+
+		pmp_cfg_record[n] = p.cfg;
+		pmp_addr_record[n] = p.address;
+		if (is_range)
+			pmp_addr_record[n - 1] = p.previous_address;
+
+		mask_pmp_entry_used(n);
+		if (is_range)
+			mask_pmp_entry_used(n - 1);
+	}
+
+	spinlock_unlock(&pmp_lock);
 
 	/*
 	 * NOTE! you MUST write the cfg register first, or on (e.g.)
@@ -359,10 +404,18 @@ void setup_pmp(u64 base, u64 size, u8 flags)
 	write_pmpaddr(n, p.address);
 	if (is_range)
 		write_pmpaddr(n - 1, p.previous_address);
+}
 
-	mask_pmp_entry_used(n);
-	if (is_range)
-		mask_pmp_entry_used(n - 1);
+/* write all PMP records to the current hart */
+void pmp_apply(void)
+{
+	for (int i = 0; i < PMP_MAX_ENTRIES; i++) {
+		if (!(pmp_entry_used_mask & (1 << i)))
+			continue;
+		/* cfg first, see setup_pmp */
+		write_pmpcfg(i, pmp_cfg_record[i]);
+		write_pmpaddr(i, pmp_addr_record[i]);
+	}
 }
 
 /*
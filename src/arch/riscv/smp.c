@@ -7,6 +7,24 @@
 #include <console/console.h>
 #include <mcall.h>
 
+/* The job smp_run_on_harts() hands to the parked harts, there is only one at a time. */
+static struct {
+	void (*fn)(void *arg);
+	void *arg;
+	atomic_t pending;
+} hart_job;
+
+static void run_hart_job(void)
+{
+	mb();
+	if (hart_job.fn == NULL)
+		return;
+
+	hart_job.fn(hart_job.arg);
+	mb();
+	atomic_add(&hart_job.pending, -1);
+}
+
 void smp_pause(int working_hartid)
 {
 #define SYNCA (OTHER_HLS(working_hartid)->entry.sync_a)
@@ -23,14 +41,25 @@ void smp_pause(int working_hartid)
 		clear_csr(mstatus, MSTATUS_MIE);
 		write_csr(mie, MIP_MSIP);
 
+		/* smp_resume() sets this, every other wakeup is a job */
+		HLS()->entry.fn = NULL;
+
 		/* count how many cores enter the halt */
 		atomic_add(&SYNCB, 1);
 
-		do {
-			barrier();
-			__asm__ volatile ("wfi");
-		} while ((read_csr(mip) & MIP_MSIP) == 0);
-		set_msip(hartid, 0);
+		for (;;) {
+			do {
+				barrier();
+				__asm__ volatile ("wfi");
+			} while ((read_csr(mip) & MIP_MSIP) == 0);
+			set_msip(hartid, 0);
+			mb();
+
+			if (HLS()->entry.fn != NULL)
+				break;
+
+			run_hart_job();
+		}
 		HLS()->entry.fn(HLS()->entry.arg);
 	} else {
 		/* Initialize the counter and
@@ -51,6 +80,32 @@ void smp_pause(int working_hartid)
 #undef SYNCB
 }
 
+void smp_run_on_harts(void (*fn)(void *), void *arg)
+{
+	int hartid = read_csr(mhartid);
+
+	if (fn == NULL)
+		die("must pass a non-null function pointer\n");
+
+	hart_job.fn = fn;
+	hart_job.arg = arg;
+	atomic_set(&hart_job.pending, CONFIG_MAX_CPUS - 1);
+	mb();
+
+	for (int i = 0; i < CONFIG_MAX_CPUS; i++)
+		if (i != hartid)
+			set_msip(i, 1);
+
+	fn(arg);
+
+	do {
+		barrier();
+	} while (atomic_read(&hart_job.pending) != 0);
+
+	hart_job.fn = NULL;
+	mb();
+}
+
 void smp_resume(void (*fn)(void *), void *arg)
 {
 	int hartid = read_csr(mhartid);
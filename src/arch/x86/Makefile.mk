@@ -80,6 +80,8 @@ bootblock-$(CONFIG_IDT_IN_EVERY_STAGE) += exception.c
 bootblock-$(CONFIG_IDT_IN_EVERY_STAGE) += idt.S
 bootblock-y += memcpy.c
 bootblock-y += memset.c
+bootblock-$(CONFIG_X86_SHA_NI) += sha256_ni.S
+bootblock-$(CONFIG_X86_SHA_NI) += sha_ni.c
 bootblock-$(CONFIG_ARCH_BOOTBLOCK_X86_32) += memmove_32.c
 bootblock-$(CONFIG_ARCH_BOOTBLOCK_X86_64) += memmove_64.S
 bootblock-$(CONFIG_COLLECT_TIMESTAMPS_TSC) += timestamp.c
@@ -132,6 +134,8 @@ verstage-$(CONFIG_HAVE_CF9_RESET) += cf9_reset.c
 verstage-y += cpu_common.c
 verstage-y += memset.c
 verstage-y += memcpy.c
+verstage-$(CONFIG_X86_SHA_NI) += sha256_ni.S
+verstage-$(CONFIG_X86_SHA_NI) += sha_ni.c
 verstage-$(CONFIG_ARCH_VERSTAGE_X86_32) += memmove_32.c
 verstage-$(CONFIG_ARCH_VERSTAGE_X86_64) += memmove_64.S
 verstage-$(CONFIG_X86_TOP4G_BOOTMEDIA_MAP) += mmap_boot.c
@@ -174,6 +178,8 @@ romstage-y += memcpy.c
 romstage-$(CONFIG_ARCH_ROMSTAGE_X86_32) += memmove_32.c
 romstage-$(CONFIG_ARCH_ROMSTAGE_X86_64) += memmove_64.S
 romstage-y += memset.c
+romstage-$(CONFIG_X86_SHA_NI) += sha256_ni.S
+romstage-$(CONFIG_X86_SHA_NI) += sha_ni.c
 romstage-$(CONFIG_X86_TOP4G_BOOTMEDIA_MAP) += mmap_boot.c
 romstage-$(CONFIG_DEBUG_NULL_DEREF_BREAKPOINTS_IN_ALL_STAGES) += null_breakpoint.c
 romstage-y += postcar_loader.c
@@ -220,6 +226,8 @@ postcar-y += memcpy.c
 postcar-$(CONFIG_ARCH_POSTCAR_X86_32) += memmove_32.c
 postcar-$(CONFIG_ARCH_POSTCAR_X86_64) += memmove_64.S
 postcar-y += memset.c
+postcar-$(CONFIG_X86_SHA_NI) += sha256_ni.S
+postcar-$(CONFIG_X86_SHA_NI) += sha_ni.c
 postcar-$(CONFIG_X86_TOP4G_BOOTMEDIA_MAP) += mmap_boot.c
 postcar-$(CONFIG_DEBUG_NULL_DEREF_BREAKPOINTS_IN_ALL_STAGES) += null_breakpoint.c
 postcar-y += postcar.c
@@ -265,6 +273,10 @@ ramstage-y += memcpy.c
 ramstage-$(CONFIG_ARCH_RAMSTAGE_X86_32) += memmove_32.c
 ramstage-$(CONFIG_ARCH_RAMSTAGE_X86_64) += memmove_64.S
 ramstage-y += memset.c
+ramstage-$(CONFIG_X86_NT_MEMCPY) += memcpy_nt.S
+ramstage-$(CONFIG_X86_NT_MEMCPY) += nt_mem.c
+ramstage-$(CONFIG_X86_SHA_NI) += sha256_ni.S
+ramstage-$(CONFIG_X86_SHA_NI) += sha_ni.c
 ramstage-$(CONFIG_X86_TOP4G_BOOTMEDIA_MAP) += mmap_boot.c
 ramstage-$(CONFIG_GENERATE_MP_TABLE) += mpspec.c
 ramstage-$(CONFIG_DEBUG_NULL_DEREF_BREAKPOINTS) += null_breakpoint.c
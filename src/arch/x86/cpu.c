@@ -8,6 +8,7 @@
 #include <string.h>
 #include <cpu/x86/gdt.h>
 #include <cpu/x86/mp.h>
+#include <cpu/x86/mp_timestamp.h>
 #include <cpu/x86/lapic.h>
 #include <cpu/x86/tsc.h>
 #include <device/device.h>
@@ -232,6 +233,7 @@ void cpu_initialize(void)
 	if (cpu->initialized)
 		return;
 
+	mp_timestamp_add_now(TS_CPU_INIT_START);
 	post_log_path(cpu);
 
 	/* Find what type of CPU we are dealing with */
@@ -264,6 +266,7 @@ void cpu_initialize(void)
 		cpu->ops->init(cpu);
 	}
 	post_log_clear();
+	mp_timestamp_add_now(TS_CPU_INIT_END);
 
 	printk(BIOS_INFO, "CPU #%zd initialized\n", info->index);
 }
@@ -9,6 +9,7 @@
 #include <console/streams.h>
 #include <cpu/x86/cr.h>
 #include <cpu/x86/lapic.h>
+#include <cpu/x86/profiler.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -378,6 +379,13 @@ void x86_exception(struct eregs *info);
 
 void x86_exception(struct eregs *info)
 {
+#if CONFIG(RAMSTAGE_PROFILER) && ENV_RAMSTAGE
+	if (info->vector == PROFILER_VECTOR) {
+		profiler_sample(info);
+		return;
+	}
+#endif
+
 #if CONFIG(GDB_STUB)
 	/* TODO implement 64bit mode */
 	int signo;
@@ -597,7 +605,25 @@ static const uintptr_t intr_entries[] = {
 	(uintptr_t)vec16, (uintptr_t)vec17, (uintptr_t)vec18, (uintptr_t)vec19,
 };
 
-static struct intr_gate idt[ARRAY_SIZE(intr_entries)] __aligned(8);
+#if CONFIG(RAMSTAGE_PROFILER) && ENV_RAMSTAGE
+extern u8 vec_profiler[];
+#define IDT_ENTRIES (PROFILER_VECTOR + 1)
+#else
+#define IDT_ENTRIES ARRAY_SIZE(intr_entries)
+#endif
+
+static struct intr_gate idt[IDT_ENTRIES] __aligned(8);
+
+static void set_intr_gate(struct intr_gate *gate, uintptr_t entry, uint16_t segment)
+{
+	gate->offset_0 = entry;
+	gate->segsel = segment;
+	gate->flags = IGATE_FLAGS;
+	gate->offset_1 = entry >> 16;
+#if ENV_X86_64
+	gate->offset_2 = entry >> 32;
+#endif
+}
 
 static inline uint16_t get_cs(void)
 {
@@ -652,15 +678,13 @@ asmlinkage void exception_init(void)
 	segment = get_cs();
 
 	/* Initialize IDT. */
-	for (i = 0; i < ARRAY_SIZE(idt); i++) {
-		idt[i].offset_0 = intr_entries[i];
-		idt[i].segsel = segment;
-		idt[i].flags = IGATE_FLAGS;
-		idt[i].offset_1 = intr_entries[i] >> 16;
-#if ENV_X86_64
-		idt[i].offset_2 = intr_entries[i] >> 32;
+	for (i = 0; i < ARRAY_SIZE(intr_entries); i++)
+		set_intr_gate(&idt[i], intr_entries[i], segment);
+
+#if CONFIG(RAMSTAGE_PROFILER) && ENV_RAMSTAGE
+	/* Vectors between the exceptions and the profiler stay not-present. */
+	set_intr_gate(&idt[PROFILER_VECTOR], (uintptr_t)vec_profiler, segment);
 #endif
-	}
 
 	load_idt(idt, sizeof(idt));
 
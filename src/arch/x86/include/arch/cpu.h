@@ -49,6 +49,7 @@ static inline unsigned int cpuid_get_max_func(void)
 
 #define CPUID_FEATURE_PAE (1 << 6)
 #define CPUID_FEATURE_PSE36 (1 << 17)
+#define CPUID_FEATURE_SSE2 (1 << 26)
 #define CPUID_FEATURE_HTT (1 << 28)
 
 /* Structured Extended Feature Flags */
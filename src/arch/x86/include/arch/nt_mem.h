@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef ARCH_NT_MEM_H
+#define ARCH_NT_MEM_H
+
+#include <arch/cpu.h>
+#include <stdint.h>
+#include <types.h>
+
+/*
+ * SSE2 non-temporal copy and fill of |blocks| 64-byte blocks. |dst| has to be
+ * 16-byte aligned. The stores bypass the caches, which pays off when the
+ * buffer is much larger than the caches (payloads, framebuffers) and is not
+ * going to be read back right away. Both end with an sfence.
+ */
+asmlinkage void memcpy_nt_blocks(void *dst, const void *src, size_t blocks);
+asmlinkage void memset_nt_blocks(void *dst, uint32_t pattern, size_t blocks);
+
+#define NT_MEM_BLOCK_SIZE	64
+#define NT_MEM_ALIGN		16
+
+/*
+ * Returns true if memcpy()/memset() of |n| bytes should take the
+ * non-temporal path. CPUID and CR4.OSFXSR are only checked once.
+ */
+bool nt_mem_use(size_t n);
+
+#endif /* ARCH_NT_MEM_H */
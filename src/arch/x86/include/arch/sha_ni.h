@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef ARCH_SHA_NI_H
+#define ARCH_SHA_NI_H
+
+#include <arch/cpu.h>
+#include <stdint.h>
+#include <types.h>
+
+#define SHA256_NI_BLOCK_SIZE	64
+
+/*
+ * Runs the SHA-256 compression function over |blocks| 64-byte blocks of
+ * |data| using the SHA extensions. |state| holds the eight working words
+ * a..h in host order and is updated in place. No alignment requirements.
+ */
+asmlinkage void sha256_ni_blocks(uint32_t state[8], const void *data, size_t blocks);
+
+/*
+ * Returns true if the CPU has the SHA extensions and SSE state is enabled.
+ * CPUID and CR4.OSFXSR are only checked once. When this returns false the
+ * vb2ex_hwcrypto_digest_*() hooks report SHA-256 as unsupported and vboot
+ * falls back to its software implementation.
+ */
+bool sha_ni_supported(void);
+
+#endif /* ARCH_SHA_NI_H */
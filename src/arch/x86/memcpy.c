@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <arch/nt_mem.h>
 #include <string.h>
 #include <stdbool.h>
 #include <asan.h>
@@ -14,6 +15,21 @@ void *memcpy(void *dest, const void *src, size_t n)
 	check_memory_region((unsigned long)dest, n, true, _RET_IP_);
 #endif
 
+#if ENV_RAMSTAGE && CONFIG(X86_NT_MEMCPY)
+	if (nt_mem_use(n)) {
+		size_t head = -(uintptr_t)dest % NT_MEM_ALIGN;
+		size_t blocks = (n - head) / NT_MEM_BLOCK_SIZE;
+		size_t body = blocks * NT_MEM_BLOCK_SIZE;
+
+		/* Head and tail are small enough to take the rep path below. */
+		memcpy(dest, src, head);
+		memcpy_nt_blocks((uint8_t *)dest + head, (const uint8_t *)src + head, blocks);
+		memcpy((uint8_t *)dest + head + body, (const uint8_t *)src + head + body,
+		       n - head - body);
+		return dest;
+	}
+#endif
+
 #if ENV_X86_64
 	asm volatile(
 		"rep ; movsq\n\t"
@@ -2,6 +2,7 @@
 
 /* From glibc-2.14, sysdeps/i386/memset.c */
 
+#include <arch/nt_mem.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -19,6 +20,20 @@ void *memset(void *dstpp, int c, size_t len)
 	check_memory_region((unsigned long)dstpp, len, true, _RET_IP_);
 #endif
 
+#if ENV_RAMSTAGE && CONFIG(X86_NT_MEMCPY)
+	if (nt_mem_use(len)) {
+		size_t head = -dstp % NT_MEM_ALIGN;
+		size_t blocks = (len - head) / NT_MEM_BLOCK_SIZE;
+		size_t body = blocks * NT_MEM_BLOCK_SIZE;
+
+		/* Head and tail are small enough to take the rep path below. */
+		memset(dstpp, c, head);
+		memset_nt_blocks((void *)(dstp + head), (unsigned char)c * 0x01010101U, blocks);
+		memset((void *)(dstp + head + body), c, len - head - body);
+		return dstpp;
+	}
+#endif
+
 	/* This explicit register allocation improves code very much indeed. */
 	register op_t x asm("ax");
 
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <arch/nt_mem.h>
+#include <bootstate.h>
+#include <cbmem.h>
+#include <console/console.h>
+#include <cpu/x86/cr.h>
+#include <string.h>
+#include <timer.h>
+#include <types.h>
+
+static enum { NT_MEM_UNKNOWN, NT_MEM_OFF, NT_MEM_ON } nt_mem_state;
+
+static bool nt_mem_supported(void)
+{
+	/* SSE state has to be enabled already, it is not our job to turn it on. */
+	if (!(read_cr4() & CR4_OSFXSR) || !cpu_have_cpuid() || cpuid_get_max_func() < 1)
+		return false;
+
+	return cpuid_edx(1) & CPUID_FEATURE_SSE2;
+}
+
+bool nt_mem_use(size_t n)
+{
+	/* Leave at least one full block so head and tail can't recurse. */
+	if (n < CONFIG_X86_NT_MEM_THRESHOLD || n < 2 * NT_MEM_BLOCK_SIZE)
+		return false;
+
+	if (nt_mem_state == NT_MEM_UNKNOWN)
+		nt_mem_state = nt_mem_supported() ? NT_MEM_ON : NT_MEM_OFF;
+
+	return nt_mem_state == NT_MEM_ON;
+}
+
+#if CONFIG(DEBUG_NT_MEM_BENCHMARK)
+
+#define BENCH_MAX_SIZE	(16 * MiB)
+#define BENCH_MIN_BYTES	(64 * MiB)
+
+static uint64_t bench_mbps(size_t size, int64_t usecs)
+{
+	/* One byte per microsecond is one MB/s. */
+	return usecs ? (uint64_t)size / usecs : 0;
+}
+
+static void nt_mem_benchmark(void *unused)
+{
+	const struct cbmem_entry *entry;
+	struct stopwatch sw;
+	uint8_t *src, *dst;
+	size_t size, iter, iters;
+	int64_t rep_copy, nt_copy, rep_set, nt_set;
+
+	if (nt_mem_state == NT_MEM_UNKNOWN)
+		nt_mem_state = nt_mem_supported() ? NT_MEM_ON : NT_MEM_OFF;
+	if (nt_mem_state != NT_MEM_ON) {
+		printk(BIOS_INFO, "memcpy benchmark: SSE2 not available\n");
+		return;
+	}
+
+	/* Borrow a CBMEM region for the buffers, it is removed again below. */
+	entry = cbmem_entry_add(CBMEM_ID_MEM_BENCH, 2 * BENCH_MAX_SIZE + NT_MEM_ALIGN);
+	if (!entry) {
+		printk(BIOS_ERR, "memcpy benchmark: no buffer\n");
+		return;
+	}
+	src = (uint8_t *)ALIGN_UP((uintptr_t)cbmem_entry_start(entry), NT_MEM_ALIGN);
+	dst = src + BENCH_MAX_SIZE;
+	memset(src, 0x5a, BENCH_MAX_SIZE);
+
+	printk(BIOS_INFO, "memcpy benchmark (MB/s):\n");
+	printk(BIOS_INFO, "%10s %10s %10s %10s %10s\n", "size", "rep copy", "nt copy",
+	       "rep set", "nt set");
+
+	for (size = 4 * KiB; size <= BENCH_MAX_SIZE; size *= 4) {
+		iters = MAX(BENCH_MIN_BYTES / size, 1);
+
+		/* Force the rep path regardless of the threshold. */
+		nt_mem_state = NT_MEM_OFF;
+
+		stopwatch_init(&sw);
+		for (iter = 0; iter < iters; iter++)
+			memcpy(dst, src, size);
+		rep_copy = stopwatch_duration_usecs(&sw);
+
+		stopwatch_init(&sw);
+		for (iter = 0; iter < iters; iter++)
+			memset(dst, 0, size);
+		rep_set = stopwatch_duration_usecs(&sw);
+
+		nt_mem_state = NT_MEM_ON;
+
+		stopwatch_init(&sw);
+		for (iter = 0; iter < iters; iter++)
+			memcpy_nt_blocks(dst, src, size / NT_MEM_BLOCK_SIZE);
+		nt_copy = stopwatch_duration_usecs(&sw);
+
+		stopwatch_init(&sw);
+		for (iter = 0; iter < iters; iter++)
+			memset_nt_blocks(dst, 0, size / NT_MEM_BLOCK_SIZE);
+		nt_set = stopwatch_duration_usecs(&sw);
+
+		printk(BIOS_INFO, "%10zu %10llu %10llu %10llu %10llu\n", size,
+		       bench_mbps(size * iters, rep_copy), bench_mbps(size * iters, nt_copy),
+		       bench_mbps(size * iters, rep_set), bench_mbps(size * iters, nt_set));
+	}
+
+	cbmem_entry_remove(entry);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_EXIT, nt_mem_benchmark, NULL);
+
+#endif
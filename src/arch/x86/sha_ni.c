@@ -0,0 +1,176 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <arch/cpuid.h>
+#include <arch/sha_ni.h>
+#include <bootstate.h>
+#include <console/console.h>
+#include <cpu/x86/cr.h>
+#include <endian.h>
+#include <string.h>
+#include <types.h>
+#include <vb2_api.h>
+
+#define CPUID_FEATURE_SSSE3	(1 << 9)	/* leaf 1, ECX */
+#define CPUID_FEATURE_SSE4_1	(1 << 19)	/* leaf 1, ECX */
+#define CPUID_FEATURE_SHA	(1 << 29)	/* leaf 7, EBX */
+
+static enum { SHA_NI_UNKNOWN, SHA_NI_OFF, SHA_NI_ON } sha_ni_state;
+
+/* vboot only ever has one hardware digest in flight. */
+static struct {
+	uint32_t h[8];
+	uint8_t block[SHA256_NI_BLOCK_SIZE];
+	size_t fill;
+	uint64_t total;
+} sha_ctx;
+
+static const uint32_t sha256_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static bool sha_ni_detect(void)
+{
+	/* SSE state has to be enabled already, it is not our job to turn it on. */
+	if (!(read_cr4() & CR4_OSFXSR) || !cpu_have_cpuid() ||
+	    cpuid_get_max_func() < CPUID_STRUCT_EXTENDED_FEATURE_FLAGS)
+		return false;
+
+	/* The block function also uses pshufb/palignr and pblendw. */
+	if ((cpuid_ecx(1) & (CPUID_FEATURE_SSSE3 | CPUID_FEATURE_SSE4_1)) !=
+	    (CPUID_FEATURE_SSSE3 | CPUID_FEATURE_SSE4_1))
+		return false;
+
+	return cpuid_ext(CPUID_STRUCT_EXTENDED_FEATURE_FLAGS, 0).ebx & CPUID_FEATURE_SHA;
+}
+
+bool sha_ni_supported(void)
+{
+	if (sha_ni_state == SHA_NI_UNKNOWN) {
+		sha_ni_state = sha_ni_detect() ? SHA_NI_ON : SHA_NI_OFF;
+		printk(BIOS_DEBUG, "SHA extensions %savailable\n",
+		       sha_ni_state == SHA_NI_ON ? "" : "not ");
+	}
+
+	return sha_ni_state == SHA_NI_ON;
+}
+
+vb2_error_t vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg, uint32_t data_size)
+{
+	if (hash_alg != VB2_HASH_SHA256 || !sha_ni_supported())
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+
+	memcpy(sha_ctx.h, sha256_iv, sizeof(sha_ctx.h));
+	sha_ctx.fill = 0;
+	sha_ctx.total = 0;
+
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2ex_hwcrypto_digest_extend(const uint8_t *buf, uint32_t size)
+{
+	size_t n;
+
+	sha_ctx.total += size;
+
+	if (sha_ctx.fill) {
+		n = MIN(size, SHA256_NI_BLOCK_SIZE - sha_ctx.fill);
+		memcpy(sha_ctx.block + sha_ctx.fill, buf, n);
+		sha_ctx.fill += n;
+		buf += n;
+		size -= n;
+		if (sha_ctx.fill < SHA256_NI_BLOCK_SIZE)
+			return VB2_SUCCESS;
+		sha256_ni_blocks(sha_ctx.h, sha_ctx.block, 1);
+		sha_ctx.fill = 0;
+	}
+
+	/* Hash whole blocks straight from the caller's buffer. */
+	n = size / SHA256_NI_BLOCK_SIZE;
+	if (n) {
+		sha256_ni_blocks(sha_ctx.h, buf, n);
+		buf += n * SHA256_NI_BLOCK_SIZE;
+		size -= n * SHA256_NI_BLOCK_SIZE;
+	}
+
+	memcpy(sha_ctx.block, buf, size);
+	sha_ctx.fill = size;
+
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2ex_hwcrypto_digest_finalize(uint8_t *digest, uint32_t digest_size)
+{
+	const uint64_t bits = htobe64(sha_ctx.total * 8);
+	uint32_t word;
+	int i;
+
+	if (digest_size != VB2_SHA256_DIGEST_SIZE)
+		return VB2_ERROR_SHA_FINALIZE_DIGEST_SIZE;
+
+	sha_ctx.block[sha_ctx.fill++] = 0x80;
+	if (sha_ctx.fill > SHA256_NI_BLOCK_SIZE - sizeof(bits)) {
+		memset(sha_ctx.block + sha_ctx.fill, 0, SHA256_NI_BLOCK_SIZE - sha_ctx.fill);
+		sha256_ni_blocks(sha_ctx.h, sha_ctx.block, 1);
+		sha_ctx.fill = 0;
+	}
+	memset(sha_ctx.block + sha_ctx.fill, 0,
+	       SHA256_NI_BLOCK_SIZE - sizeof(bits) - sha_ctx.fill);
+	memcpy(sha_ctx.block + SHA256_NI_BLOCK_SIZE - sizeof(bits), &bits, sizeof(bits));
+	sha256_ni_blocks(sha_ctx.h, sha_ctx.block, 1);
+
+	for (i = 0; i < ARRAY_SIZE(sha_ctx.h); i++) {
+		word = cpu_to_be32(sha_ctx.h[i]);
+		memcpy(digest + i * sizeof(word), &word, sizeof(word));
+	}
+
+	return VB2_SUCCESS;
+}
+
+#if ENV_RAMSTAGE && CONFIG(DEBUG_HASH_BENCHMARK)
+
+#include <cpu/x86/tsc.h>
+#include <symbols.h>
+
+#define BENCH_ITERS	4
+
+static void hash_benchmark(void *unused)
+{
+	static const struct {
+		enum vb2_hash_algorithm algo;
+		const char *name;
+	} algos[] = {
+		{ VB2_HASH_SHA1, "SHA-1" },
+		{ VB2_HASH_SHA256, "SHA-256" },
+		{ VB2_HASH_SHA512, "SHA-512" },
+	};
+	/* Hash our own program image, there is no need for a scratch buffer. */
+	const size_t size = REGION_SIZE(program);
+	struct vb2_hash hash;
+	uint64_t start, cycles, per100;
+	int i, hw, iter;
+
+	printk(BIOS_INFO, "Hash benchmark over %zu bytes (bytes/cycle):\n", size);
+
+	for (i = 0; i < ARRAY_SIZE(algos); i++) {
+		for (hw = 0; hw <= 1; hw++) {
+			/* The hardware path only differs where a hook accepts the algorithm. */
+			if (hw && (algos[i].algo != VB2_HASH_SHA256 || !sha_ni_supported()))
+				continue;
+
+			start = rdtscll();
+			for (iter = 0; iter < BENCH_ITERS; iter++)
+				vb2_hash_calculate(hw, _program, size, algos[i].algo, &hash);
+			cycles = rdtscll() - start;
+
+			per100 = cycles ? (uint64_t)size * BENCH_ITERS * 100 / cycles : 0;
+			printk(BIOS_INFO, "%10s %-8s %3llu.%02llu\n", algos[i].name,
+			       hw ? "SHA-NI" : "software", per100 / 100, per100 % 100);
+		}
+	}
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_EXIT, hash_benchmark, NULL);
+
+#endif
@@ -8,10 +8,81 @@
 #include <arch/smp/mpspec.h>
 #include <acpi/acpi.h>
 #include <commonlib/helpers.h>
+#include <cpu/x86/mp_jobs.h>
 #include <string.h>
 #include <cbmem.h>
 #include <smbios.h>
 
+#define MAX_SMBIOS_SIZE (32 * KiB)
+
+/*
+ * The ACPI and SMBIOS tables are written to CBMEM by jobs. With PARALLEL_TABLES both jobs
+ * are started up front, so another CPU can pick one of them up. Otherwise each is started
+ * right before it is needed, and it runs on the BSP.
+ */
+struct table_job {
+	struct mp_job job;
+	bool started;
+	unsigned long start;
+	unsigned long end;
+	size_t size;
+};
+
+static struct table_job acpi_job, smbios_job;
+
+static void acpi_job_run(void *arg)
+{
+	struct table_job *t = arg;
+
+	t->end = write_acpi_tables(t->start);
+}
+
+static void smbios_job_run(void *arg)
+{
+	struct table_job *t = arg;
+
+	/*
+	 * Clear the entire region to ensure the unused space doesn't
+	 * contain garbage from a previous boot, like stale table
+	 * signatures that could be found by the OS.
+	 */
+	memset((void *)t->start, 0, t->size);
+
+	t->end = smbios_write_tables(t->start);
+}
+
+static void table_job_start(struct table_job *t, u32 id, size_t size, void (*run)(void *arg))
+{
+	if (t->started)
+		return;
+
+	t->started = true;
+	t->size = size;
+	t->start = (unsigned long)cbmem_add(id, size);
+	if (t->start)
+		mp_job_submit(&t->job, run, t);
+}
+
+static void acpi_job_start(void)
+{
+	table_job_start(&acpi_job, CBMEM_ID_ACPI, CONFIG_MAX_ACPI_TABLE_SIZE_KB * KiB,
+			acpi_job_run);
+}
+
+static void smbios_job_start(void)
+{
+	table_job_start(&smbios_job, CBMEM_ID_SMBIOS, MAX_SMBIOS_SIZE, smbios_job_run);
+}
+
+/* Returns the start of the tables in CBMEM, or 0 if there's no room for them. */
+static unsigned long table_job_join(struct table_job *t)
+{
+	if (t->start)
+		mp_job_join(&t->job);
+
+	return t->start;
+}
+
 static unsigned long write_pirq_table(unsigned long rom_table_end)
 {
 	unsigned long high_table_pointer;
@@ -92,14 +163,14 @@ static unsigned long write_acpi_table(unsigned long rom_table_end)
 	 * coreboot table. This leaves us with 47KB for all of ACPI. Let's see
 	 * how far we get.
 	 */
-	high_table_pointer = (unsigned long)cbmem_add(CBMEM_ID_ACPI,
-		max_acpi_size);
+	acpi_job_start();
+	high_table_pointer = table_job_join(&acpi_job);
 	if (high_table_pointer) {
 		unsigned long acpi_start = high_table_pointer;
 		unsigned long new_high_table_pointer;
 
 		rom_table_end = ALIGN_UP(rom_table_end, 16);
-		new_high_table_pointer = write_acpi_tables(high_table_pointer);
+		new_high_table_pointer = acpi_job.end;
 		if (new_high_table_pointer > (high_table_pointer
 			+ max_acpi_size)) {
 			printk(BIOS_CRIT, "ACPI tables overflowed and corrupted CBMEM!\n");
@@ -144,22 +215,12 @@ static unsigned long write_smbios_table(unsigned long rom_table_end)
 {
 	unsigned long high_table_pointer;
 
-#define MAX_SMBIOS_SIZE (32 * KiB)
-
-	high_table_pointer = (unsigned long)cbmem_add(CBMEM_ID_SMBIOS,
-		MAX_SMBIOS_SIZE);
+	smbios_job_start();
+	high_table_pointer = table_job_join(&smbios_job);
 	if (high_table_pointer) {
 		unsigned long new_high_table_pointer;
 
-		/*
-		 * Clear the entire region to ensure the unused space doesn't
-		 * contain garbage from a previous boot, like stale table
-		 * signatures that could be found by the OS.
-		 */
-		memset((void *)high_table_pointer, 0, MAX_SMBIOS_SIZE);
-
-		new_high_table_pointer =
-			smbios_write_tables(high_table_pointer);
+		new_high_table_pointer = smbios_job.end;
 		rom_table_end = ALIGN_UP(rom_table_end, 16);
 		memcpy((void *)rom_table_end, (void *)high_table_pointer,
 			sizeof(struct smbios_entry));
@@ -194,6 +255,13 @@ void arch_write_tables(uintptr_t coreboot_table)
 	size_t sz;
 	unsigned long rom_table_end = 0xf0000;
 
+	if (CONFIG(PARALLEL_TABLES)) {
+		if (mp_jobs_begin() != CB_SUCCESS)
+			printk(BIOS_WARNING, "Writing tables on the BSP only\n");
+		acpi_job_start();
+		smbios_job_start();
+	}
+
 	/* This table must be between 0x0f0000 and 0x100000 */
 	if (CONFIG(GENERATE_PIRQ_TABLE))
 		rom_table_end = write_pirq_table(rom_table_end);
@@ -208,6 +276,10 @@ void arch_write_tables(uintptr_t coreboot_table)
 	if (CONFIG(GENERATE_SMBIOS_TABLES))
 		rom_table_end = write_smbios_table(rom_table_end);
 
+	/* Both jobs are joined by now. */
+	if (CONFIG(PARALLEL_TABLES))
+		mp_jobs_end();
+
 	sz = write_coreboot_forwarding_table(forwarding_table, coreboot_table);
 
 	forwarding_table += sz;
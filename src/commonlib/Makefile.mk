@@ -49,6 +49,13 @@ postcar-y += bsd/cbfs_mcache.c
 ramstage-y += bsd/cbfs_mcache.c
 smm-y += bsd/cbfs_mcache.c
 
+bootblock-y += bsd/fmap_index.c
+verstage-y += bsd/fmap_index.c
+romstage-y += bsd/fmap_index.c
+postcar-y += bsd/fmap_index.c
+ramstage-y += bsd/fmap_index.c
+smm-y += bsd/fmap_index.c
+
 decompressor-y += bsd/lz4_wrapper.c
 bootblock-y += bsd/lz4_wrapper.c
 verstage-y += bsd/lz4_wrapper.c
@@ -56,6 +63,19 @@ romstage-y += bsd/lz4_wrapper.c
 ramstage-y += bsd/lz4_wrapper.c
 postcar-y += bsd/lz4_wrapper.c
 
+romstage-$(CONFIG_CONSOLE_CBMEM_ARCHIVE) += bsd/lz4_compress.c
+postcar-$(CONFIG_CONSOLE_CBMEM_ARCHIVE) += bsd/lz4_compress.c
+ramstage-$(CONFIG_CONSOLE_CBMEM_ARCHIVE) += bsd/lz4_compress.c
+romstage-$(CONFIG_STAGE_CACHE_LZ4) += bsd/lz4_compress.c
+postcar-$(CONFIG_STAGE_CACHE_LZ4) += bsd/lz4_compress.c
+ramstage-$(CONFIG_STAGE_CACHE_LZ4) += bsd/lz4_compress.c
+
+bootblock-y += bsd/zstd_decompress.c
+verstage-y += bsd/zstd_decompress.c
+romstage-y += bsd/zstd_decompress.c
+ramstage-y += bsd/zstd_decompress.c
+postcar-y += bsd/zstd_decompress.c
+
 all-y += list.c
 
 ramstage-y += sort.c
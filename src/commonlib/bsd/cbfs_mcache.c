@@ -21,11 +21,21 @@
  * metadata (entry->file.h.offset). The next mcache_entry begins at the next
  * CBFS_MCACHE_ALIGNMENT boundary after that. The cache is terminated by a special 4-byte
  * mcache_entry that consists only of a magic number (MCACHE_MAGIC_END or MCACHE_MAGIC_FULL).
+ *
+ * If CBFS_MCACHE_HASH_INDEX is enabled and there is enough space left, cbfs_mcache_build() also
+ * places an open-addressing hash table over the file names at the very end of the mcache area.
+ * It consists of an array of 32-bit slots followed by a struct mcache_index trailer that ends
+ * exactly at mcache + mcache_size. Each non-zero slot holds (entry offset in the mcache /
+ * CBFS_MCACHE_ALIGNMENT) + 1. Lookups probe the table first if the trailer magic is present
+ * and fall back to walking the entries otherwise. cbfs_mcache_copy() preserves this layout when
+ * moving an mcache into a buffer of cbfs_mcache_real_size() bytes. Readers that don't know
+ * about the index simply never look past the terminating magic.
  */
 
 #define MCACHE_MAGIC_FILE	0x454c4946	/* 'FILE' */
 #define MCACHE_MAGIC_FULL	0x4c4c5546	/* 'FULL' */
 #define MCACHE_MAGIC_END	0x444e4524	/* '$END' */
+#define MCACHE_MAGIC_INDEX	0x58444948	/* 'HIDX' */
 
 union mcache_entry {
 	union cbfs_mdata file;
@@ -35,6 +45,90 @@ union mcache_entry {
 	};
 };
 
+struct mcache_index {
+	uint32_t end_magic;	/* copy of the terminating magic (END or FULL) */
+	uint32_t slots;		/* number of uint32_t slots directly preceding this struct */
+	uint32_t magic;		/* MCACHE_MAGIC_INDEX */
+};
+
+/* Simple 32-bit FNV-1a, good enough to spread CBFS file names across the index. */
+static uint32_t mcache_name_hash(const char *name, size_t len)
+{
+	uint32_t hash = 0x811c9dc5;
+
+	while (len--) {
+		hash ^= (uint8_t)*name++;
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+static const struct mcache_index *mcache_find_index(const void *mcache, size_t mcache_size)
+{
+	const struct mcache_index *index;
+
+	if (mcache_size < sizeof(*index))
+		return NULL;
+
+	index = mcache + mcache_size - sizeof(*index);
+	if (index->magic != MCACHE_MAGIC_INDEX ||
+	    index->slots == 0 ||
+	    index->slots > (mcache_size - sizeof(*index)) / sizeof(uint32_t))
+		return NULL;
+
+	return index;
+}
+
+static size_t mcache_index_size(const struct mcache_index *index)
+{
+	return index->slots * sizeof(uint32_t) + sizeof(*index);
+}
+
+static void build_index(void *mcache, size_t size, const void *used_end, int count,
+			uint32_t end_magic)
+{
+	struct mcache_index *index = mcache + size - sizeof(*index);
+	const uint32_t nslots = count * 2 + 1;
+	const size_t index_size = nslots * sizeof(uint32_t) + sizeof(*index);
+	uint32_t *slots;
+	const void *current;
+
+	/* Invalidate stale trailers from earlier builds of this buffer. */
+	if ((void *)index >= used_end)
+		index->magic = 0;
+
+	if (!CBFS_MCACHE_HASH_INDEX || count == 0)
+		return;
+
+	if ((size_t)(mcache + size - used_end) < index_size) {
+		DEBUG("No space for mcache index (need %#zx bytes)\n", index_size);
+		return;
+	}
+
+	slots = (void *)index - nslots * sizeof(uint32_t);
+	memset(slots, 0, nslots * sizeof(uint32_t));
+
+	/* used_end includes the terminating magic, which is not indexed. */
+	for (current = mcache; current + sizeof(uint32_t) < used_end;) {
+		const union mcache_entry *entry = current;
+		const uint32_t data_offset = be32toh(entry->file.h.offset);
+		const size_t name_len = strnlen(entry->file.h.filename,
+				data_offset - offsetof(union cbfs_mdata, h.filename));
+		uint32_t i = mcache_name_hash(entry->file.h.filename, name_len) % nslots;
+
+		while (slots[i])
+			i = (i + 1) % nslots;
+		slots[i] = (current - mcache) / CBFS_MCACHE_ALIGNMENT + 1;
+
+		current += ALIGN_UP(data_offset, CBFS_MCACHE_ALIGNMENT);
+	}
+
+	index->end_magic = end_magic;
+	index->slots = nslots;
+	index->magic = MCACHE_MAGIC_INDEX;
+}
+
 struct cbfs_mcache_build_args {
 	void *mcache;
 	void *end;
@@ -66,10 +160,10 @@ static enum cb_err build_walker(cbfs_dev_t dev, size_t offset, const union cbfs_
 enum cb_err cbfs_mcache_build(cbfs_dev_t dev, void *mcache, size_t size,
 			      struct vb2_hash *metadata_hash)
 {
+	size = ALIGN_DOWN(size, CBFS_MCACHE_ALIGNMENT);
 	struct cbfs_mcache_build_args args = {
 		.mcache = mcache,
-		.end = mcache + ALIGN_DOWN(size, CBFS_MCACHE_ALIGNMENT)
-		       - sizeof(uint32_t), /* leave space for terminating magic */
+		.end = mcache + size - sizeof(uint32_t), /* leave space for terminating magic */
 		.count = 0,
 	};
 
@@ -84,6 +178,8 @@ enum cb_err cbfs_mcache_build(cbfs_dev_t dev, void *mcache, size_t size,
 		entry->magic = MCACHE_MAGIC_FULL;
 	}
 
+	build_index(mcache, size, args.mcache + sizeof(entry->magic), args.count, entry->magic);
+
 	LOG("mcache @%p built for %d files, used %#zx of %#zx bytes\n", mcache,
 	    args.count, args.mcache + sizeof(entry->magic) - mcache, size);
 	return ret;
@@ -95,6 +191,36 @@ enum cb_err cbfs_mcache_lookup(const void *mcache, size_t mcache_size, const cha
 	const size_t namesize = strlen(name) + 1; /* Count trailing \0 so we can memcmp() it. */
 	const void *end = mcache + mcache_size;
 	const void *current = mcache;
+	const struct mcache_index *index = mcache_find_index(mcache, mcache_size);
+
+	if (index) {
+		const uint32_t *slots = (const void *)index - index->slots * sizeof(uint32_t);
+		uint32_t i = mcache_name_hash(name, namesize - 1) % index->slots;
+		uint32_t probes;
+
+		for (probes = 0; probes < index->slots && slots[i]; probes++) {
+			const union mcache_entry *entry = mcache +
+				(slots[i] - 1) * CBFS_MCACHE_ALIGNMENT;
+			if ((const void *)entry + sizeof(*entry) > (const void *)slots ||
+			    entry->magic != MCACHE_MAGIC_FILE)
+				break;	/* corrupted index, use the walk below */
+
+			const uint32_t data_offset = be32toh(entry->file.h.offset);
+			if (namesize <= data_offset - offsetof(union cbfs_mdata, h.filename) &&
+			    memcmp(name, entry->file.h.filename, namesize) == 0) {
+				LOG("Found '%s' @%#x size %#x in mcache @%p\n", name,
+				    entry->offset, be32toh(entry->file.h.len), entry);
+				*data_offset_out = entry->offset + data_offset;
+				memcpy(mdata_out, &entry->file, data_offset);
+				return CB_SUCCESS;
+			}
+			i = (i + 1) % index->slots;
+		}
+
+		if (probes < index->slots && !slots[i])
+			return index->end_magic == MCACHE_MAGIC_FULL ?
+				CB_CBFS_CACHE_FULL : CB_CBFS_NOT_FOUND;
+	}
 
 	while (current + sizeof(uint32_t) <= end) {
 		const union mcache_entry *entry = current;
@@ -123,7 +249,7 @@ enum cb_err cbfs_mcache_lookup(const void *mcache, size_t mcache_size, const cha
 	return CB_ERR;
 }
 
-size_t cbfs_mcache_real_size(const void *mcache, size_t mcache_size)
+static size_t mcache_entries_size(const void *mcache, size_t mcache_size)
 {
 	const void *end = mcache + mcache_size;
 	const void *current = mcache;
@@ -142,3 +268,25 @@ size_t cbfs_mcache_real_size(const void *mcache, size_t mcache_size)
 
 	return current - mcache;
 }
+
+size_t cbfs_mcache_real_size(const void *mcache, size_t mcache_size)
+{
+	const struct mcache_index *index = mcache_find_index(mcache, mcache_size);
+	size_t size = mcache_entries_size(mcache, mcache_size);
+
+	if (index)
+		size += mcache_index_size(index);
+
+	return size;
+}
+
+void cbfs_mcache_copy(void *dst, const void *mcache, size_t mcache_size)
+{
+	const struct mcache_index *index = mcache_find_index(mcache, mcache_size);
+	size_t size = mcache_entries_size(mcache, mcache_size);
+
+	memcpy(dst, mcache, size);
+	if (index)
+		memcpy(dst + size, mcache + mcache_size - mcache_index_size(index),
+		       mcache_index_size(index));
+}
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: BSD-3-Clause OR GPL-2.0-or-later */
+
+#include <commonlib/bsd/fmap_index.h>
+#include <commonlib/bsd/helpers.h>
+#include <endian.h>
+#include <string.h>
+
+/*
+ * The index is an open-addressing hash table of 32-bit slots followed by a struct fmap_index
+ * trailer that ends exactly at the end of the buffer. Each non-zero slot holds the number of an
+ * area + 1. The table always has more slots than areas, so every probe sequence ends at an
+ * empty slot. The index is in host byte order, it's only meant to be read on the same machine.
+ */
+
+#define FMAP_INDEX_MAGIC	0x58444946	/* 'FIDX' */
+
+struct fmap_index {
+	uint32_t slots;
+	uint32_t magic;
+};
+
+static uint32_t fmap_name_hash(const char *name)
+{
+	uint32_t hash = 0x811c9dc5;
+	size_t len = strnlen(name, FMAP_STRLEN);
+
+	while (len--) {
+		hash ^= (uint8_t)*name++;
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+static size_t fmap_data_size(const struct fmap *fmap)
+{
+	return ALIGN_UP(sizeof(*fmap) + le16toh(fmap->nareas) * sizeof(fmap->areas[0]),
+			sizeof(uint32_t));
+}
+
+static uint32_t fmap_index_slots(const struct fmap *fmap)
+{
+	return le16toh(fmap->nareas) * 2 + 1;
+}
+
+size_t fmap_index_size(const struct fmap *fmap)
+{
+	return fmap_index_slots(fmap) * sizeof(uint32_t) + sizeof(struct fmap_index);
+}
+
+enum cb_err fmap_index_build(struct fmap *fmap, size_t size)
+{
+	const uint32_t nslots = fmap_index_slots(fmap);
+	struct fmap_index *index;
+	uint32_t *slots;
+	uint16_t i;
+
+	if (size < fmap_data_size(fmap) + fmap_index_size(fmap) ||
+	    !IS_ALIGNED((uintptr_t)fmap + size, sizeof(uint32_t)))
+		return CB_ERR_ARG;
+
+	index = (void *)((uint8_t *)fmap + size - sizeof(*index));
+	slots = (uint32_t *)index - nslots;
+	memset(slots, 0, nslots * sizeof(*slots));
+
+	for (i = 0; i < le16toh(fmap->nareas); i++) {
+		uint32_t s = fmap_name_hash((const char *)fmap->areas[i].name) % nslots;
+
+		while (slots[s])
+			s = (s + 1) % nslots;
+		slots[s] = i + 1;
+	}
+
+	index->slots = nslots;
+	index->magic = FMAP_INDEX_MAGIC;
+
+	return CB_SUCCESS;
+}
+
+enum cb_err fmap_index_find(const struct fmap *fmap, size_t size, const char *name,
+			    const struct fmap_area **area)
+{
+	const struct fmap_index *index;
+	const uint32_t *slots;
+	uint32_t s, probes;
+
+	if (size < sizeof(*fmap) || size < fmap_data_size(fmap) + fmap_index_size(fmap) ||
+	    !IS_ALIGNED((uintptr_t)fmap + size, sizeof(uint32_t)))
+		return CB_ERR_ARG;
+
+	index = (const void *)((const uint8_t *)fmap + size - sizeof(*index));
+	if (index->magic != FMAP_INDEX_MAGIC || index->slots != fmap_index_slots(fmap))
+		return CB_ERR_ARG;
+
+	slots = (const uint32_t *)index - index->slots;
+	s = fmap_name_hash(name) % index->slots;
+	for (probes = 0; probes < index->slots && slots[s]; probes++) {
+		const struct fmap_area *a;
+
+		if (slots[s] > le16toh(fmap->nareas))
+			return CB_ERR_ARG;
+		a = &fmap->areas[slots[s] - 1];
+		if (!strncmp((const char *)a->name, name, FMAP_STRLEN)) {
+			*area = a;
+			return CB_SUCCESS;
+		}
+		s = (s + 1) % index->slots;
+	}
+
+	return CB_ERR;
+}
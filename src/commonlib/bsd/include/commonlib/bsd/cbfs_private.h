@@ -121,4 +121,8 @@ enum cb_err cbfs_mcache_lookup(const void *mcache, size_t mcache_size, const cha
 /* Returns the amount of bytes actually used by the CBFS metadata cache in |mcache|. */
 size_t cbfs_mcache_real_size(const void *mcache, size_t mcache_size);
 
+/* Copy the CBFS metadata cache in |mcache| (including its lookup index, if any) to |dst|, which
+ * must be cbfs_mcache_real_size() bytes large. The copy is a valid mcache of exactly that size. */
+void cbfs_mcache_copy(void *dst, const void *mcache, size_t mcache_size);
+
 #endif	/* _COMMONLIB_BSD_CBFS_PRIVATE_H_ */
@@ -10,19 +10,27 @@
 #define CBMEM_ID_ACPI_HEST	0x48455354
 #define CBMEM_ID_ACPI_UCSI	0x55435349
 #define CBMEM_ID_AFTER_CAR	0xc4787a93
+#define CBMEM_ID_AP_CONSOLE	0x4f435041
+#define CBMEM_ID_AP_TIMESTAMPS	0x53545041
 #define CBMEM_ID_AGESA_RUNTIME	0x41474553
 #define CBMEM_ID_AGESA_MTRR	0xf08b4b9d
 #define CBMEM_ID_AMDMCT_MEMINFO 0x494D454E
 #define CBMEM_ID_CAR_GLOBALS	0xcac4e6a3
 #define CBMEM_ID_CBTABLE	0x43425442
 #define CBMEM_ID_CBTABLE_FWD	0x43425443
+#define CBMEM_ID_CBFS_TRACE	0x43465452
+#define CBMEM_ID_CBFS_MAP_CACHE	0x43464d43
+#define CBMEM_ID_CBFS_MAPx	0x43460000
 #define CBMEM_ID_CB_EARLY_DRAM	0x4544524D
 #define CBMEM_ID_CONSOLE	0x434f4e53
+#define CBMEM_ID_CONSOLE_ARCHIVE	0x434f4e41
 #define CBMEM_ID_CPU_CRASHLOG	0x4350555f
 #define CBMEM_ID_COVERAGE	0x47434f56
 #define CBMEM_ID_CSE_UPDATE	0x43534555
+#define CBMEM_ID_DEV_TIMING	0x4456544d
 #define CBMEM_ID_EHCI_DEBUG	0xe4c1deb9
 #define CBMEM_ID_ELOG		0x454c4f47
+#define CBMEM_ID_ELOG_HANDOFF	0x454c4748
 #define CBMEM_ID_FREESPACE	0x46524545
 #define CBMEM_ID_FSP_RESERVED_MEMORY 0x46535052
 #define CBMEM_ID_FSP_RUNTIME	0x52505346
@@ -30,11 +38,15 @@
 #define CBMEM_ID_MRC_VERSION	0x5f43524d
 #define CBMEM_ID_GDT		0x4c474454
 #define CBMEM_ID_HOB_POINTER	0x484f4221
+#define CBMEM_ID_HW_FINGERPRINT	0x50465748
 #define CBMEM_ID_IGD_OPREGION	0x4f444749
 #define CBMEM_ID_IMD_ROOT	0xff4017ff
 #define CBMEM_ID_IMD_SMALL	0x53a11439
 #define CBMEM_ID_MDATA_HASH	0x6873484D
+#define CBMEM_ID_MEM_BENCH	0x48434e42
+#define CBMEM_ID_MEM_USAGE	0x4d555347
 #define CBMEM_ID_MEMINFO	0x494D454D
+#define CBMEM_ID_MEMTEST	0x5453544d
 #define CBMEM_ID_MMA_DATA	0x4D4D4144
 #define CBMEM_ID_MMC_STATUS	0x4d4d4353
 #define CBMEM_ID_MPTABLE	0x534d5054
@@ -46,6 +58,7 @@
 #define CBMEM_ID_NONE		0x00000000
 #define CBMEM_ID_PIRQ		0x49525154
 #define CBMEM_ID_POWER_STATE	0x50535454
+#define CBMEM_ID_PROFILE	0x464f5250
 #define CBMEM_ID_RAM_OOPS	0x05430095
 #define CBMEM_ID_RAMSTAGE	0x9a357a9e
 #define CBMEM_ID_RAMSTAGE_CACHE	0x9a3ca54e
@@ -65,6 +78,7 @@
 #define CBMEM_ID_TPM_CB_LOG	0x54435041 /* TPM log in coreboot-specific format */
 #define CBMEM_ID_TCPA_TCG_LOG	0x54445041 /* TPM log per TPM 1.2 specification */
 #define CBMEM_ID_TIMESTAMP	0x54494d45
+#define CBMEM_ID_TIMESTAMPx	0x54535800 /* Tables that continue a full one */
 #define CBMEM_ID_TPM2_TCG_LOG	0x54504d32 /* TPM log per TPM 2.0 specification */
 #define CBMEM_ID_TPM_PPI	0x54505049
 #define CBMEM_ID_VBOOT_HANDOFF	0x780074f0  /* deprecated */
@@ -83,6 +97,7 @@
 #define CBMEM_ID_CBFS_RW_MCACHE	0x574d5346
 #define CBMEM_ID_FSP_LOGO	0x4c4f474f
 #define CBMEM_ID_SMM_COMBUFFER	0x53534d32
+#define CBMEM_ID_SMM_LATENCY	0x4c4d4d53
 #define CBMEM_ID_TYPE_C_INFO	0x54595045
 #define CBMEM_ID_MEM_CHIP_INFO	0x5048434D
 #define CBMEM_ID_AMD_STB	0x5f425453
@@ -101,16 +116,23 @@
 	{ CBMEM_ID_AGESA_RUNTIME,	"AGESA RSVD " }, \
 	{ CBMEM_ID_AGESA_MTRR,		"AGESA MTRR " }, \
 	{ CBMEM_ID_AFTER_CAR,		"AFTER CAR  " }, \
+	{ CBMEM_ID_AP_CONSOLE,		"AP CONSOLE " }, \
+	{ CBMEM_ID_AP_TIMESTAMPS,	"AP TIMESTMP" }, \
 	{ CBMEM_ID_AMDMCT_MEMINFO,	"AMDMEM INFO" }, \
 	{ CBMEM_ID_CAR_GLOBALS,		"CAR GLOBALS" }, \
 	{ CBMEM_ID_CBTABLE,		"COREBOOT   " }, \
 	{ CBMEM_ID_CBTABLE_FWD,		"COREBOOTFWD" }, \
+	{ CBMEM_ID_CBFS_TRACE,		"CBFS TRACE " }, \
+	{ CBMEM_ID_CBFS_MAP_CACHE,	"CBFS MAPS  " }, \
 	{ CBMEM_ID_CB_EARLY_DRAM,	"EARLY DRAM USAGE" }, \
 	{ CBMEM_ID_CONSOLE,		"CONSOLE    " }, \
+	{ CBMEM_ID_CONSOLE_ARCHIVE,	"CONSOLE ARC" }, \
 	{ CBMEM_ID_COVERAGE,		"COVERAGE   " }, \
+	{ CBMEM_ID_DEV_TIMING,		"DEV TIMING " }, \
 	{ CBMEM_ID_CPU_CRASHLOG,	"CPU CRASHLOG (deprecated)"}, \
 	{ CBMEM_ID_EHCI_DEBUG,		"USBDEBUG   " }, \
 	{ CBMEM_ID_ELOG,		"ELOG       " }, \
+	{ CBMEM_ID_ELOG_HANDOFF,	"ELOG HANDOFF" }, \
 	{ CBMEM_ID_FREESPACE,		"FREE SPACE " }, \
 	{ CBMEM_ID_FSP_RESERVED_MEMORY, "FSP MEMORY " }, \
 	{ CBMEM_ID_FSP_RUNTIME,		"FSP RUNTIME" }, \
@@ -118,11 +140,15 @@
 	{ CBMEM_ID_MRC_VERSION,		"MRC VERSION" }, \
 	{ CBMEM_ID_GDT,			"GDT        " }, \
 	{ CBMEM_ID_HOB_POINTER,		"HOB        " }, \
+	{ CBMEM_ID_HW_FINGERPRINT,	"HW FINGERPR" }, \
 	{ CBMEM_ID_IGD_OPREGION,	"IGD OPREGION" }, \
 	{ CBMEM_ID_IMD_ROOT,		"IMD ROOT   " }, \
 	{ CBMEM_ID_IMD_SMALL,		"IMD SMALL  " }, \
 	{ CBMEM_ID_MDATA_HASH,		"METADATA HASH" }, \
+	{ CBMEM_ID_MEM_BENCH,		"MEM BENCH  " }, \
+	{ CBMEM_ID_MEM_USAGE,		"MEM USAGE  " }, \
 	{ CBMEM_ID_MEMINFO,		"MEM INFO   " }, \
+	{ CBMEM_ID_MEMTEST,		"MEM TEST   " }, \
 	{ CBMEM_ID_MMA_DATA,		"MMA DATA   " }, \
 	{ CBMEM_ID_MMC_STATUS,		"MMC STATUS " }, \
 	{ CBMEM_ID_MPTABLE,		"SMP TABLE  " }, \
@@ -132,6 +158,7 @@
 	{ CBMEM_ID_MTC,			"MTC        " }, \
 	{ CBMEM_ID_PIRQ,		"IRQ TABLE  " }, \
 	{ CBMEM_ID_POWER_STATE,		"POWER STATE" }, \
+	{ CBMEM_ID_PROFILE,		"PROFILE    " }, \
 	{ CBMEM_ID_RAM_OOPS,		"RAMOOPS    " }, \
 	{ CBMEM_ID_RAMSTAGE_CACHE,	"RAMSTAGE $ " }, \
 	{ CBMEM_ID_RAMSTAGE,		"RAMSTAGE   " }, \
@@ -166,6 +193,7 @@
 	{ CBMEM_ID_CBFS_RW_MCACHE,	"RW MCACHE  "}, \
 	{ CBMEM_ID_FSP_LOGO,		"FSP LOGO   "}, \
 	{ CBMEM_ID_SMM_COMBUFFER,	"SMM COMBUFFER"}, \
+	{ CBMEM_ID_SMM_LATENCY,		"SMM LATENCY"}, \
 	{ CBMEM_ID_TYPE_C_INFO,		"TYPE_C INFO"},\
 	{ CBMEM_ID_MEM_CHIP_INFO,	"MEM CHIP INFO"},\
 	{ CBMEM_ID_AMD_STB,		"AMD STB"},\
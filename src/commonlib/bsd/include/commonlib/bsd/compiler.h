@@ -54,6 +54,14 @@
 #define __section(section) __attribute__((__section__(section)))
 #endif
 
+/*
+ * Uninitialized storage that the loader doesn't need to clear, e.g. stacks. Stages with a
+ * .noinit output section keep it out of the cleared BSS, others treat it as normal BSS.
+ */
+#ifndef __noinit
+#define __noinit __section(".bss.noinit")
+#endif
+
 #ifndef __always_inline
 #define __always_inline inline __attribute__((__always_inline__))
 #endif
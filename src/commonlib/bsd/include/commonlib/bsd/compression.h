@@ -15,7 +15,29 @@
  */
 size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn);
 
+/* Same as ulz4fn() for input that is still being loaded (e.g. by a background DMA
+ * transfer). Before touching any input past what it has already seen, the decompressor
+ * calls wait(arg, needed), which must block until at least needed bytes from the start of
+ * src are valid and then return the amount of valid bytes. Returning less than needed
+ * aborts decompression (the function then returns 0). Not suitable for in-place use. */
+size_t ulz4fn_wait(const void *src, size_t srcn, void *dst, size_t dstn,
+		   size_t (*wait)(void *arg, size_t needed), void *arg);
+
 /* Same as ulz4fn() but does not perform any bounds checks. */
 size_t ulz4f(const void *src, void *dst);
 
+/* Decompresses a Zstandard image (one or more frames as described in RFC 8878) from src
+ * to dst, ensuring that it doesn't read more than srcn bytes and doesn't write more than
+ * dstn. Frames that need a dictionary are rejected, content checksums are not verified.
+ * Cannot decompress in-place, and the part of dst behind the output is used as scratch
+ * space. Returns amount of decompressed bytes, or 0 on error.
+ */
+size_t uzstdn(const void *src, size_t srcn, void *dst, size_t dstn);
+
+/* Compresses srcn bytes from src into an LZ4 block (no frame header) at dst, which must not
+ * get larger than dstn. srcn must be below 64KB, the block can't depend on other blocks.
+ * Returns the size of the block, or 0 if it doesn't fit.
+ */
+size_t lz4_compress_block(const void *src, size_t srcn, void *dst, size_t dstn);
+
 #endif	/* _COMMONLIB_COMPRESSION_H_ */
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: BSD-3-Clause OR GPL-2.0-or-later */
+
+#ifndef _COMMONLIB_BSD_FMAP_INDEX_H_
+#define _COMMONLIB_BSD_FMAP_INDEX_H_
+
+#include <commonlib/bsd/cb_err.h>
+#include <commonlib/bsd/fmap_serialized.h>
+#include <stddef.h>
+
+/*
+ * A copy of the FMAP in memory (like the one in CBMEM_ID_FMAP) can carry a hash index over the
+ * area names at the very end of its buffer. Readers that don't know about the index only look
+ * at the FMAP itself, which stays unmodified at the start of the buffer.
+ */
+
+/* Number of bytes the index for |fmap| needs after the end of the FMAP data. */
+size_t fmap_index_size(const struct fmap *fmap);
+
+/*
+ * Build the index at the end of the FMAP copy at |fmap|. |size| is the size of the whole
+ * buffer, which must be at least the FMAP data plus padding plus fmap_index_size().
+ */
+enum cb_err fmap_index_build(struct fmap *fmap, size_t size);
+
+/*
+ * Look an area up through the index of the |size| bytes long FMAP copy at |fmap|. Returns
+ * CB_SUCCESS and stores the area in |area| if found, CB_ERR if the FMAP doesn't contain it and
+ * CB_ERR_ARG if there is no valid index (in which case the caller should scan the areas).
+ */
+enum cb_err fmap_index_find(const struct fmap *fmap, size_t size, const char *name,
+			    const struct fmap_area **area);
+
+#endif /* _COMMONLIB_BSD_FMAP_INDEX_H_ */
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: BSD-3-Clause OR GPL-2.0-only */
+
+#include <commonlib/bsd/compression.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * A small greedy LZ4 block compressor. It finds matches with a hash table of
+ * recent positions, which is enough for text and costs little stack. The
+ * output follows the block format rules, so any LZ4 decompressor takes it.
+ */
+
+#define HASH_BITS	9
+#define MIN_MATCH	4
+#define LAST_LITERALS	5	/* The last bytes are always literals... */
+#define MF_LIMIT	12	/* ...and the last match starts before these. */
+#define MAX_OFFSET	0xffff
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static unsigned int hash(uint32_t seq)
+{
+	return (seq * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *out, size_t len)
+{
+	for (; len >= 255; len -= 255)
+		*out++ = 255;
+	*out++ = len;
+	return out;
+}
+
+/* Worst case size of a sequence with lit literals and a match of len. */
+static size_t sequence_size(size_t lit, size_t len)
+{
+	return 1 + lit / 255 + 1 + lit + 2 + len / 255 + 1;
+}
+
+size_t lz4_compress_block(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	uint16_t table[1 << HASH_BITS];
+	const uint8_t *const base = src;
+	const uint8_t *const end = base + srcn;
+	const uint8_t *ip = base, *anchor = base;
+	uint8_t *out = dst;
+	uint8_t *const oend = out + dstn;
+	size_t lit, len;
+
+	/* Positions are 16 bits. */
+	if (srcn > MAX_OFFSET)
+		return 0;
+
+	memset(table, 0, sizeof(table));
+
+	while (srcn > MF_LIMIT && ip < end - MF_LIMIT) {
+		const uint32_t seq = read32(ip);
+		const unsigned int h = hash(seq);
+		const uint8_t *ref = base + table[h];
+		const uint8_t *m, *r;
+		uint8_t *token;
+
+		table[h] = ip - base;
+		if (ref >= ip || read32(ref) != seq) {
+			ip++;
+			continue;
+		}
+
+		m = ip + MIN_MATCH;
+		r = ref + MIN_MATCH;
+		while (m < end - LAST_LITERALS && *m == *r)
+			m++, r++;
+
+		lit = ip - anchor;
+		len = m - ip - MIN_MATCH;
+		if (sequence_size(lit, len) > (size_t)(oend - out))
+			return 0;
+
+		token = out++;
+		*token = (lit >= 15 ? 15 : lit) << 4;
+		if (lit >= 15)
+			out = put_length(out, lit - 15);
+		memcpy(out, anchor, lit);
+		out += lit;
+
+		*out++ = (ip - ref) & 0xff;
+		*out++ = (ip - ref) >> 8;
+
+		*token |= len >= 15 ? 15 : len;
+		if (len >= 15)
+			out = put_length(out, len - 15);
+
+		ip = anchor = m;
+	}
+
+	lit = end - anchor;
+	if (1 + lit / 255 + 1 + lit > (size_t)(oend - out))
+		return 0;
+	*out = (lit >= 15 ? 15 : lit) << 4;
+	out++;
+	if (lit >= 15)
+		out = put_length(out, lit - 15);
+	memcpy(out, anchor, lit);
+	out += lit;
+
+	return out - (uint8_t *)dst;
+}
@@ -62,6 +62,27 @@ static void LZ4_copy8(void *dst, const void *src)
 #endif
 }
 
+/*
+ * x86 and arm64 handle unaligned 8-byte accesses well, which is what the wide copies in
+ * the fast decoding loop of lz4.c.inc are built from. Elsewhere only the careful loop is
+ * used. Can be overridden from the command line, e.g. for benchmarks.
+ */
+#ifndef LZ4_FAST_DEC_LOOP
+#if defined(__i386__) || defined(__x86_64__) || defined(__aarch64__)
+#define LZ4_FAST_DEC_LOOP 1
+#else
+#define LZ4_FAST_DEC_LOOP 0
+#endif
+#endif
+
+#if LZ4_FAST_DEC_LOOP
+static void LZ4_copy16(void *dst, const void *src)
+{
+	LZ4_copy8(dst, src);
+	LZ4_copy8(dst + 8, src + 8);
+}
+#endif
+
 typedef  uint8_t BYTE;
 typedef uint16_t U16;
 typedef uint32_t U32;
@@ -72,7 +93,8 @@ typedef uint64_t U64;
 #define likely(expr) __builtin_expect((expr) != 0, 1)
 #define unlikely(expr) __builtin_expect((expr) != 0, 0)
 
-/* Unaltered (just removed unrelated code) from github.com/Cyan4973/lz4/dev. */
+/* From github.com/Cyan4973/lz4/dev, with unrelated code removed and the fast decoding
+   loop of later versions added. */
 #include "lz4.c.inc"	/* #include for inlining, do not link! */
 
 #define LZ4F_MAGICNUMBER 0x184D2204
@@ -107,11 +129,28 @@ struct lz4_block_header {
 	/* + uint32_t block_checksum iff has_block_checksum is set */
 } __packed;
 
-size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
+/*
+ * Makes sure that the first |needed| bytes of input are valid. Without a wait callback the
+ * whole input is available from the start, and this folds away completely.
+ */
+static __always_inline int lz4_input_ready(size_t needed, size_t *avail,
+					   size_t (*wait)(void *arg, size_t needed), void *arg)
+{
+	if (needed <= *avail)
+		return 1;
+	if (!wait)
+		return 0;
+	*avail = wait(arg, needed);
+	return needed <= *avail;
+}
+
+static __always_inline size_t _ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn,
+				      size_t (*wait)(void *arg, size_t needed), void *arg)
 {
 	const void *in = src;
 	void *out = dst;
 	size_t out_size = 0;
+	size_t avail = wait ? 0 : srcn;
 	int has_block_checksum;
 
 	{ /* With in-place decompression the header may become invalid later. */
@@ -119,6 +158,9 @@ size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
 
 		if (srcn < sizeof(*h) + sizeof(uint64_t) + sizeof(uint8_t))
 			return 0;	/* input overrun */
+		if (!lz4_input_ready(sizeof(*h) + sizeof(uint64_t) + sizeof(uint8_t),
+				     &avail, wait, arg))
+			return 0;	/* input never arrived */
 
 		/* We assume there's always only a single, standard frame. */
 		if (LZ4_readLE32(&h->magic) != LZ4F_MAGICNUMBER
@@ -139,6 +181,9 @@ size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
 	while (1) {
 		if ((size_t)(in - src) + sizeof(struct lz4_block_header) > srcn)
 			break;          /* input overrun */
+		if (!lz4_input_ready((size_t)(in - src) + sizeof(struct lz4_block_header),
+				     &avail, wait, arg))
+			break;		/* input never arrived */
 
 		struct lz4_block_header b = {
 			.raw = LZ4_readLE32((const uint32_t *)in)
@@ -147,6 +192,8 @@ size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
 
 		if ((size_t)(in - src) + (b.raw & BH_SIZE) > srcn)
 			break;			/* input overrun */
+		if (!lz4_input_ready((size_t)(in - src) + (b.raw & BH_SIZE), &avail, wait, arg))
+			break;			/* input never arrived */
 
 		if (!(b.raw & BH_SIZE)) {
 			out_size = out - dst;
@@ -178,6 +225,17 @@ size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
 	return out_size;
 }
 
+size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	return _ulz4fn(src, srcn, dst, dstn, NULL, NULL);
+}
+
+size_t ulz4fn_wait(const void *src, size_t srcn, void *dst, size_t dstn,
+		   size_t (*wait)(void *arg, size_t needed), void *arg)
+{
+	return _ulz4fn(src, srcn, dst, dstn, wait, arg);
+}
+
 size_t ulz4f(const void *src, void *dst)
 {
 	/* LZ4 uses signed size parameters, so can't just use ((u32)-1) here. */
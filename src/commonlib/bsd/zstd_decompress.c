@@ -0,0 +1,1077 @@
+/* SPDX-License-Identifier: BSD-3-Clause OR GPL-2.0-only */
+
+/*
+ * Zstandard decoder following RFC 8878, for decompressing whole frames to a flat output
+ * buffer. Dictionaries are not supported and content checksums are skipped (CBFS files
+ * carry their own hashes). Literals are decoded into the unused end of the output buffer,
+ * so there is no need for a separate 128KiB literals buffer.
+ */
+
+#include <commonlib/bsd/compression.h>
+#include <commonlib/bsd/helpers.h>
+#include <commonlib/bsd/sysincludes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Pre-RAM stages use a variant that looks Huffman codes up rank by rank instead of in a
+ * 2^11 entry table, and packs FSE table entries into 16 bits. That brings the decoder
+ * state down from about 9.5KiB to 3KiB at the cost of slower literal decoding.
+ */
+#ifndef ZSTD_SMALL
+#if defined(ENV_ROMSTAGE_OR_BEFORE) && ENV_ROMSTAGE_OR_BEFORE
+#define ZSTD_SMALL 1
+#else
+#define ZSTD_SMALL 0
+#endif
+#endif
+
+#define ZSTD_MAGIC		0xfd2fb528
+#define ZSTD_SKIPPABLE_MAGIC	0x184d2a50	/* low four bits are don't care */
+#define ZSTD_BLOCK_SIZE_MAX	(128 * KiB)
+
+#define ZSTD_LL_CODES		36
+#define ZSTD_ML_CODES		53
+#define ZSTD_OF_CODES		32
+#define ZSTD_LL_MAX_LOG		9
+#define ZSTD_ML_MAX_LOG		9
+#define ZSTD_OF_MAX_LOG		8
+
+#define ZSTD_HUF_MAX_LOG	11
+#define ZSTD_HUF_MAX_SYMBOLS	256
+#define ZSTD_WEIGHT_CODES	(ZSTD_HUF_MAX_LOG + 1)
+#define ZSTD_WEIGHT_MAX_LOG	6
+
+enum {
+	ZSTD_BLOCK_RAW = 0,
+	ZSTD_BLOCK_RLE = 1,
+	ZSTD_BLOCK_COMPRESSED = 2,
+};
+
+enum {
+	ZSTD_LIT_RAW = 0,
+	ZSTD_LIT_RLE = 1,
+	ZSTD_LIT_COMPRESSED = 2,
+	ZSTD_LIT_TREELESS = 3,
+};
+
+enum {
+	ZSTD_MODE_PREDEFINED = 0,
+	ZSTD_MODE_RLE = 1,
+	ZSTD_MODE_FSE = 2,
+	ZSTD_MODE_REPEAT = 3,
+};
+
+static const uint32_t ll_base[ZSTD_LL_CODES] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+	8192, 16384, 32768, 65536,
+};
+
+static const uint8_t ll_bits[ZSTD_LL_CODES] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16,
+};
+
+static const uint32_t ml_base[ZSTD_ML_CODES] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+	4099, 8195, 16387, 32771, 65539,
+};
+
+static const uint8_t ml_bits[ZSTD_ML_CODES] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16,
+};
+
+/* Predefined distributions (RFC 8878 3.1.1.3.2.2) */
+static const int16_t ll_default[ZSTD_LL_CODES] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1,
+};
+#define ZSTD_LL_DEFAULT_LOG	6
+
+static const int16_t ml_default[ZSTD_ML_CODES] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1,
+};
+#define ZSTD_ML_DEFAULT_LOG	6
+
+static const int16_t of_default[29] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1,
+};
+#define ZSTD_OF_DEFAULT_LOG	5
+
+#if ZSTD_SMALL
+/* Low 6 bits hold the symbol, the rest the state counter the entry was assigned. */
+typedef uint16_t zstd_fse_entry;
+#define FSE_SYMBOL_BITS	6
+#else
+typedef struct {
+	uint8_t symbol;
+	uint8_t bits;
+	uint16_t base;
+} zstd_fse_entry;
+
+struct zstd_huf_entry {
+	uint8_t symbol;
+	uint8_t bits;
+};
+#endif
+
+struct zstd_fse_table {
+	zstd_fse_entry *entries;
+	uint8_t log;
+	bool valid;
+};
+
+/* Stays valid across the blocks of a frame for the repeat and treeless modes. */
+static struct {
+	zstd_fse_entry ll[1 << ZSTD_LL_MAX_LOG];
+	zstd_fse_entry ml[1 << ZSTD_ML_MAX_LOG];
+	zstd_fse_entry of[1 << ZSTD_OF_MAX_LOG];
+	zstd_fse_entry weights[1 << ZSTD_WEIGHT_MAX_LOG];
+	struct zstd_fse_table ll_table, ml_table, of_table;
+#if ZSTD_SMALL
+	/* Symbols sorted by weight, and per weight the first code and symbol index. */
+	uint8_t huf_symbols[ZSTD_HUF_MAX_SYMBOLS];
+	uint16_t huf_code[ZSTD_WEIGHT_CODES + 1];
+	uint16_t huf_index[ZSTD_WEIGHT_CODES + 1];
+#else
+	struct zstd_huf_entry huf[1 << ZSTD_HUF_MAX_LOG];
+#endif
+	uint8_t huf_log;
+	bool huf_valid;
+	uint32_t rep[3];
+} zstd;
+
+static inline unsigned int highbit32(uint32_t x)
+{
+	return 31 - __builtin_clz(x);
+}
+
+static inline uint16_t read_le16(const uint8_t *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static inline uint32_t read_le24(const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | (uint32_t)p[2] << 16;
+}
+
+static inline uint32_t read_le32(const uint8_t *p)
+{
+	return read_le24(p) | (uint32_t)p[3] << 24;
+}
+
+static inline uint64_t read_le64(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return le64toh(v);
+}
+
+/*
+ * FSE and Huffman coded data is read backwards, starting at the highest bit of the last
+ * byte below the end marker. |consumed| counts bits used up from the top of |container|.
+ */
+struct zstd_bits {
+	const uint8_t *start;
+	const uint8_t *ptr;
+	uint64_t container;
+	unsigned int consumed;
+};
+
+static int bits_init(struct zstd_bits *b, const uint8_t *src, size_t size)
+{
+	size_t i;
+
+	if (!size || !src[size - 1])
+		return -1;
+
+	b->start = src;
+	if (size >= sizeof(b->container)) {
+		b->ptr = src + size - sizeof(b->container);
+		b->container = read_le64(b->ptr);
+		b->consumed = 0;
+	} else {
+		b->ptr = src;
+		b->container = 0;
+		for (i = 0; i < size; i++)
+			b->container |= (uint64_t)src[i] << (i * 8);
+		b->consumed = (sizeof(b->container) - size) * 8;
+	}
+	b->consumed += 8 - highbit32(src[size - 1]);
+
+	return 0;
+}
+
+/* Bits past the start of the stream read as zeroes until |consumed| exceeds 64. */
+static inline uint64_t bits_peek(const struct zstd_bits *b, unsigned int n)
+{
+	return (b->container << (b->consumed & 63)) >> 1 >> (63 - n);
+}
+
+static inline uint64_t bits_read(struct zstd_bits *b, unsigned int n)
+{
+	uint64_t v = bits_peek(b, n);
+
+	b->consumed += n;
+	return v;
+}
+
+/* Refills the container so at least 56 bits can be read. Returns false on overrun. */
+static inline bool bits_reload(struct zstd_bits *b)
+{
+	size_t n;
+
+	if (b->consumed > 64)
+		return false;
+
+	n = MIN((size_t)(b->consumed / 8), (size_t)(b->ptr - b->start));
+	if (n) {
+		b->ptr -= n;
+		b->consumed -= n * 8;
+		b->container = read_le64(b->ptr);
+	}
+
+	return true;
+}
+
+static inline bool bits_done(const struct zstd_bits *b)
+{
+	return b->ptr == b->start && b->consumed == 64;
+}
+
+/* FSE table descriptions are read forwards, bit 0 of the first byte first. */
+static unsigned int fwd_bits(const uint8_t *src, size_t size, size_t pos, unsigned int n)
+{
+	uint32_t v = 0;
+	size_t i;
+
+	for (i = 0; i < 3 && pos / 8 + i < size; i++)
+		v |= (uint32_t)src[pos / 8 + i] << (i * 8);
+
+	return (v >> (pos % 8)) & ((1 << n) - 1);
+}
+
+/* Returns the size of the table description in bytes, or -1 if it is invalid. */
+static int fse_read_ncount(int16_t *norm, unsigned int *nsyms, unsigned int *log,
+			   unsigned int max_log, unsigned int max_syms, const uint8_t *src,
+			   size_t size)
+{
+	unsigned int s = 0, nbits, rep, i;
+	int remaining, threshold, max, count;
+	size_t pos = 4;
+
+	*log = fwd_bits(src, size, 0, 4) + 5;
+	if (*log > max_log)
+		return -1;
+
+	remaining = (1 << *log) + 1;
+	threshold = 1 << *log;
+	nbits = *log + 1;
+
+	while (remaining > 1) {
+		if (s >= max_syms)
+			return -1;
+
+		max = 2 * threshold - 1 - remaining;
+		count = fwd_bits(src, size, pos, nbits);
+		if ((count & (threshold - 1)) < max) {
+			count &= threshold - 1;
+			pos += nbits - 1;
+		} else {
+			if (count >= threshold)
+				count -= max;
+			pos += nbits;
+		}
+
+		/* A value of 0 stands for the "less than 1" probability -1. */
+		count--;
+		remaining -= count < 0 ? -count : count;
+		norm[s++] = count;
+
+		/* Zero probabilities are followed by 2-bit repeat counts, 3 means more. */
+		if (!count) {
+			do {
+				rep = fwd_bits(src, size, pos, 2);
+				pos += 2;
+				if (s + rep > max_syms)
+					return -1;
+				for (i = 0; i < rep; i++)
+					norm[s++] = 0;
+			} while (rep == 3);
+		}
+
+		if (remaining <= 1)
+			break;
+		while (remaining < threshold) {
+			nbits--;
+			threshold >>= 1;
+		}
+	}
+
+	if (remaining != 1 || DIV_ROUND_UP(pos, 8) > size)
+		return -1;
+
+	*nsyms = s;
+	return DIV_ROUND_UP(pos, 8);
+}
+
+static inline unsigned int fse_entry_symbol(zstd_fse_entry e)
+{
+#if ZSTD_SMALL
+	return e & ((1 << FSE_SYMBOL_BITS) - 1);
+#else
+	return e.symbol;
+#endif
+}
+
+static inline void fse_entry_set_symbol(zstd_fse_entry *e, unsigned int symbol)
+{
+#if ZSTD_SMALL
+	*e = symbol;
+#else
+	e->symbol = symbol;
+#endif
+}
+
+static int fse_build(struct zstd_fse_table *t, const int16_t *norm, unsigned int nsyms,
+		     unsigned int log)
+{
+	const unsigned int size = 1 << log;
+	const unsigned int step = (size >> 1) + (size >> 3) + 3;
+	unsigned int high = size - 1, pos = 0, s, u, n;
+	uint16_t next[ZSTD_ML_CODES];
+	int i;
+
+	t->valid = false;
+
+	/* "Less than 1" probability symbols go to the end of the table. */
+	for (s = 0; s < nsyms; s++) {
+		if (norm[s] == -1) {
+			fse_entry_set_symbol(&t->entries[high--], s);
+			next[s] = 1;
+		} else {
+			next[s] = norm[s];
+		}
+	}
+
+	for (s = 0; s < nsyms; s++) {
+		for (i = 0; i < norm[s]; i++) {
+			fse_entry_set_symbol(&t->entries[pos], s);
+			do {
+				pos = (pos + step) & (size - 1);
+			} while (pos > high);
+		}
+	}
+	if (pos)
+		return -1;
+
+	for (u = 0; u < size; u++) {
+		s = fse_entry_symbol(t->entries[u]);
+		n = next[s]++;
+#if ZSTD_SMALL
+		t->entries[u] = n << FSE_SYMBOL_BITS | s;
+#else
+		t->entries[u].bits = log - highbit32(n);
+		t->entries[u].base = (n << t->entries[u].bits) - size;
+#endif
+	}
+
+	t->log = log;
+	t->valid = true;
+	return 0;
+}
+
+struct zstd_fse_state {
+	const zstd_fse_entry *entries;
+	unsigned int log;
+	unsigned int state;
+};
+
+static inline void fse_init(struct zstd_fse_state *f, const struct zstd_fse_table *t,
+			    struct zstd_bits *b)
+{
+	f->entries = t->entries;
+	f->log = t->log;
+	f->state = bits_read(b, t->log);
+}
+
+static inline unsigned int fse_symbol(const struct zstd_fse_state *f)
+{
+	return fse_entry_symbol(f->entries[f->state]);
+}
+
+static inline void fse_update(struct zstd_fse_state *f, struct zstd_bits *b)
+{
+	const zstd_fse_entry e = f->entries[f->state];
+#if ZSTD_SMALL
+	const unsigned int n = e >> FSE_SYMBOL_BITS;
+	const unsigned int bits = f->log - highbit32(n);
+
+	f->state = (n << bits) - (1 << f->log) + bits_read(b, bits);
+#else
+	f->state = e.base + bits_read(b, e.bits);
+#endif
+}
+
+/* Decodes the Huffman weights and builds the decoding table. Returns bytes used or -1. */
+static int huf_read_tree(const uint8_t *src, size_t size)
+{
+	struct zstd_fse_table t = { .entries = zstd.weights };
+	uint8_t weights[ZSTD_HUF_MAX_SYMBOLS];
+	int16_t norm[ZSTD_WEIGHT_CODES];
+	unsigned int rank[ZSTD_WEIGHT_CODES + 1] = { 0 };
+	struct zstd_fse_state s1, s2;
+	struct zstd_bits b;
+	unsigned int header, nw = 0, nsyms, log, w, i;
+	uint32_t sum = 0, left;
+	int n;
+
+	if (!size)
+		return -1;
+	header = src[0];
+
+	if (header >= 128) {
+		/* Weights are stored directly, four bits each. */
+		nw = header - 127;
+		if (1 + DIV_ROUND_UP(nw, 2) > size)
+			return -1;
+		size = DIV_ROUND_UP(nw, 2);
+		for (i = 0; i < nw; i++)
+			weights[i] = (src[1 + i / 2] >> (i & 1 ? 0 : 4)) & 0xf;
+	} else {
+		if (1 + (size_t)header > size)
+			return -1;
+		size = header;
+		n = fse_read_ncount(norm, &nsyms, &log, ZSTD_WEIGHT_MAX_LOG,
+				    ZSTD_WEIGHT_CODES, src + 1, size);
+		if (n < 0 || fse_build(&t, norm, nsyms, log) ||
+		    bits_init(&b, src + 1 + n, size - n))
+			return -1;
+
+		/* Two interleaved states share one bit stream. */
+		fse_init(&s1, &t, &b);
+		fse_init(&s2, &t, &b);
+		for (;;) {
+			if (nw >= ZSTD_HUF_MAX_SYMBOLS - 1)
+				return -1;
+			weights[nw++] = fse_symbol(&s1);
+			fse_update(&s1, &b);
+			if (!bits_reload(&b)) {
+				weights[nw++] = fse_symbol(&s2);
+				break;
+			}
+
+			if (nw >= ZSTD_HUF_MAX_SYMBOLS - 1)
+				return -1;
+			weights[nw++] = fse_symbol(&s2);
+			fse_update(&s2, &b);
+			if (!bits_reload(&b)) {
+				weights[nw++] = fse_symbol(&s1);
+				break;
+			}
+		}
+	}
+
+	if (nw >= ZSTD_HUF_MAX_SYMBOLS)
+		return -1;
+	for (i = 0; i < nw; i++) {
+		if (weights[i] > ZSTD_HUF_MAX_LOG)
+			return -1;
+		if (weights[i])
+			sum += 1 << (weights[i] - 1);
+	}
+	if (!sum)
+		return -1;
+
+	/* The weight of the last symbol is implied by filling up to a power of 2. */
+	log = highbit32(sum) + 1;
+	left = (1 << log) - sum;
+	if (log > ZSTD_HUF_MAX_LOG || (left & (left - 1)))
+		return -1;
+	weights[nw++] = highbit32(left) + 1;
+
+	for (i = 0; i < nw; i++)
+		rank[weights[i]]++;
+
+	/* Codes are handed out from the lowest weight (longest code) up. */
+#if ZSTD_SMALL
+	zstd.huf_code[1] = 0;
+	zstd.huf_index[1] = 0;
+	for (w = 1; w <= log; w++) {
+		zstd.huf_code[w + 1] = zstd.huf_code[w] + (rank[w] << (w - 1));
+		zstd.huf_index[w + 1] = zstd.huf_index[w] + rank[w];
+	}
+	for (w = 1; w <= log; w++)
+		rank[w] = zstd.huf_index[w];
+	for (i = 0; i < nw; i++)
+		if (weights[i])
+			zstd.huf_symbols[rank[weights[i]]++] = i;
+#else
+	{
+		unsigned int code = 0, next, j;
+
+		for (w = 1; w <= log; w++) {
+			next = code + (rank[w] << (w - 1));
+			rank[w] = code;
+			code = next;
+		}
+		for (i = 0; i < nw; i++) {
+			w = weights[i];
+			if (!w)
+				continue;
+			for (j = 0; j < 1u << (w - 1); j++) {
+				zstd.huf[rank[w] + j].symbol = i;
+				zstd.huf[rank[w] + j].bits = log + 1 - w;
+			}
+			rank[w] += 1 << (w - 1);
+		}
+	}
+#endif
+
+	zstd.huf_log = log;
+	zstd.huf_valid = true;
+
+	return 1 + size;
+}
+
+/*
+ * Huffman coded and RLE literals of a block are decoded up front, into the end of the
+ * output window the block can take up. The sequences move them down to their final place
+ * and never catch up with literals that are still to be used.
+ */
+struct zstd_literals {
+	unsigned int type;
+	size_t size;
+	const uint8_t *ptr;
+	const uint8_t *end;
+	uint8_t rle;
+	/* Huffman coded literals come in one or four streams. */
+	const uint8_t *stream[4];
+	size_t stream_size[4];
+	unsigned int streams;
+};
+
+static inline unsigned int huf_decode(struct zstd_bits *b, unsigned int log)
+{
+#if ZSTD_SMALL
+	const unsigned int code = bits_peek(b, log);
+	unsigned int w;
+
+	for (w = 1; w < log && code >= zstd.huf_code[w + 1]; w++)
+		;
+	b->consumed += log + 1 - w;
+	return zstd.huf_symbols[zstd.huf_index[w] + ((code - zstd.huf_code[w]) >> (w - 1))];
+#else
+	const struct zstd_huf_entry e = zstd.huf[bits_peek(b, log)];
+
+	b->consumed += e.bits;
+	return e.symbol;
+#endif
+}
+
+/* After a reload there are enough bits for four codes of up to 11 bits. */
+static inline void huf_decode4(struct zstd_bits *b, uint8_t *op, unsigned int log)
+{
+	bits_reload(b);
+	op[0] = huf_decode(b, log);
+	op[1] = huf_decode(b, log);
+	op[2] = huf_decode(b, log);
+	op[3] = huf_decode(b, log);
+}
+
+static int lit_decode_huf(const struct zstd_literals *l, uint8_t *dst)
+{
+	const unsigned int log = zstd.huf_log;
+	const size_t per_stream = l->streams == 1 ? l->size : DIV_ROUND_UP(l->size, 4);
+	struct zstd_bits b[4];
+	uint8_t *op[4], *oend[4];
+	unsigned int i;
+	size_t n;
+
+	for (i = 0; i < l->streams; i++) {
+		if (bits_init(&b[i], l->stream[i], l->stream_size[i]))
+			return -1;
+		op[i] = dst + i * per_stream;
+		oend[i] = i == l->streams - 1 ? dst + l->size : op[i] + per_stream;
+	}
+
+	/* The streams are independent, decoding them side by side keeps the CPU busy. */
+	if (l->streams == 4) {
+		for (n = (oend[3] - op[3]) / 4; n; n--) {
+			huf_decode4(&b[0], op[0], log);
+			huf_decode4(&b[1], op[1], log);
+			huf_decode4(&b[2], op[2], log);
+			huf_decode4(&b[3], op[3], log);
+			for (i = 0; i < 4; i++)
+				op[i] += 4;
+		}
+	}
+
+	for (i = 0; i < l->streams; i++) {
+		for (n = (oend[i] - op[i]) / 4; n; n--, op[i] += 4)
+			huf_decode4(&b[i], op[i], log);
+		while (op[i] < oend[i]) {
+			bits_reload(&b[i]);
+			*op[i]++ = huf_decode(&b[i], log);
+		}
+		/* Every stream must be used up exactly. */
+		if (!bits_done(&b[i]))
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Makes the literals available at l->ptr, decoding them to |dst| if necessary. */
+static int lit_decode(struct zstd_literals *l, uint8_t *dst)
+{
+	switch (l->type) {
+	case ZSTD_LIT_RAW:
+		break;
+	case ZSTD_LIT_RLE:
+		memset(dst, l->rle, l->size);
+		l->ptr = dst;
+		break;
+	default:
+		if (lit_decode_huf(l, dst))
+			return -1;
+		l->ptr = dst;
+	}
+
+	l->end = l->ptr + l->size;
+	return 0;
+}
+
+/* Parses the literals section header. Returns the size of the whole section or -1. */
+static int lit_parse(struct zstd_literals *l, const uint8_t *src, size_t size)
+{
+	const unsigned int format = (src[0] >> 2) & 3;
+	unsigned int hdr, bits, i;
+	size_t comp, total, per_stream;
+	uint64_t v = 0;
+	int n;
+
+	l->type = src[0] & 3;
+
+	if (l->type == ZSTD_LIT_RAW || l->type == ZSTD_LIT_RLE) {
+		hdr = format == 1 ? 2 : format == 3 ? 3 : 1;
+		if (hdr > size)
+			return -1;
+		if (hdr == 1)
+			l->size = src[0] >> 3;
+		else if (hdr == 2)
+			l->size = (src[0] >> 4) | src[1] << 4;
+		else
+			l->size = (src[0] >> 4) | src[1] << 4 | src[2] << 12;
+		if (l->size > ZSTD_BLOCK_SIZE_MAX)
+			return -1;
+
+		if (l->type == ZSTD_LIT_RLE) {
+			if (hdr + 1 > size)
+				return -1;
+			l->rle = src[hdr];
+			return hdr + 1;
+		}
+
+		if (hdr + l->size > size)
+			return -1;
+		l->ptr = src + hdr;
+		return hdr + l->size;
+	}
+
+	/* Huffman coded, sizes in 10, 10, 14 or 18 bits each. */
+	hdr = format < 2 ? 3 : format + 2;
+	bits = format < 2 ? 10 : format * 4 + 6;
+	if (hdr > size)
+		return -1;
+	for (i = 0; i < hdr; i++)
+		v |= (uint64_t)src[i] << (i * 8);
+	l->size = (v >> 4) & ((1 << bits) - 1);
+	comp = (v >> (4 + bits)) & ((1 << bits) - 1);
+	if (l->size > ZSTD_BLOCK_SIZE_MAX || hdr + comp > size)
+		return -1;
+	total = hdr + comp;
+	src += hdr;
+
+	if (l->type == ZSTD_LIT_COMPRESSED) {
+		n = huf_read_tree(src, comp);
+		if (n < 0)
+			return -1;
+		src += n;
+		comp -= n;
+	} else if (!zstd.huf_valid) {
+		return -1;
+	}
+
+	if (format == 0) {
+		l->streams = 1;
+		l->stream[0] = src;
+		l->stream_size[0] = comp;
+		return total;
+	}
+
+	/* A jump table gives the sizes of the first three streams. */
+	if (comp < 6)
+		return -1;
+	l->streams = 4;
+	per_stream = DIV_ROUND_UP(l->size, 4);
+	if (3 * per_stream > l->size)
+		return -1;
+	src += 6;
+	comp -= 6;
+	for (i = 0; i < 3; i++)
+		l->stream_size[i] = read_le16(src - 6 + i * 2);
+	if (l->stream_size[0] + l->stream_size[1] + l->stream_size[2] > comp)
+		return -1;
+	l->stream_size[3] = comp - l->stream_size[0] - l->stream_size[1] - l->stream_size[2];
+	for (i = 0; i < 4; i++) {
+		l->stream[i] = src;
+		src += l->stream_size[i];
+	}
+
+	return total;
+}
+
+/* Sets up the table for one of the sequence codes. Returns bytes used or -1. */
+static int seq_table(struct zstd_fse_table *t, unsigned int mode, const int16_t *def,
+		     unsigned int def_log, unsigned int def_syms, unsigned int max_log,
+		     unsigned int max_syms, const uint8_t *src, size_t size)
+{
+	int16_t norm[ZSTD_ML_CODES];
+	unsigned int nsyms, log;
+	int n;
+
+	switch (mode) {
+	case ZSTD_MODE_PREDEFINED:
+		return fse_build(t, def, def_syms, def_log);
+	case ZSTD_MODE_RLE:
+		if (!size || src[0] >= max_syms)
+			return -1;
+		norm[src[0]] = 1;
+		memset(norm, 0, src[0] * sizeof(norm[0]));
+		return fse_build(t, norm, src[0] + 1, 0) ? -1 : 1;
+	case ZSTD_MODE_FSE:
+		n = fse_read_ncount(norm, &nsyms, &log, max_log, max_syms, src, size);
+		if (n < 0 || fse_build(t, norm, nsyms, log))
+			return -1;
+		return n;
+	default:
+		return t->valid ? 0 : -1;
+	}
+}
+
+static inline void lit_copy(struct zstd_literals *l, uint8_t *op, size_t n, uint8_t *oend)
+{
+	/* Short runs take one 16 byte copy unless that would overlap the literals. */
+	if (n <= 16 && l->end - l->ptr >= 16 && oend - op >= 16 &&
+	    (l->type == ZSTD_LIT_RAW || l->ptr - op >= 16))
+		memcpy(op, l->ptr, 16);
+	else
+		memmove(op, l->ptr, n);
+	l->ptr += n;
+}
+
+/* |limit| is where the copy may overshoot to, before output or literals still in use. */
+static inline void match_copy(uint8_t *op, size_t offset, size_t len, const uint8_t *limit)
+{
+	const uint8_t *match = op - offset;
+	uint8_t *const end = op + len;
+
+	if (offset == 1) {
+		memset(op, *match, len);
+		return;
+	}
+
+	if (offset >= 16 && limit - op >= (ptrdiff_t)len + 16) {
+		do {
+			memcpy(op, match, 16);
+			op += 16;
+			match += 16;
+		} while (op < end);
+		return;
+	}
+
+	if (offset >= 8) {
+		for (; len >= 8; len -= 8, op += 8, match += 8)
+			memcpy(op, match, 8);
+	}
+	while (len--)
+		*op++ = *match++;
+}
+
+static int seq_execute(const uint8_t *src, size_t size, struct zstd_literals *lit,
+		       uint8_t *ostart, uint8_t **opp, uint8_t *oend)
+{
+	const uint8_t *ip = src, *const iend = src + size;
+	struct zstd_fse_state ll, of, ml;
+	struct zstd_bits b;
+	uint8_t *op = *opp;
+	const uint8_t *limit;
+	unsigned int nseq, modes, llc, ofc, mlc, idx;
+	uint32_t offval, litlen, matchlen, offset;
+	size_t window;
+	int n;
+
+	/* Put the literals at the very end of what the block can regenerate. */
+	window = MIN((size_t)(oend - op), (size_t)ZSTD_BLOCK_SIZE_MAX);
+	if (lit->size > window || lit_decode(lit, op + window - lit->size))
+		return -1;
+
+	if (ip == iend)
+		return -1;
+	nseq = *ip++;
+	if (nseq >= 128) {
+		if (nseq == 255) {
+			if (iend - ip < 2)
+				return -1;
+			nseq = read_le16(ip) + 0x7f00;
+			ip += 2;
+		} else {
+			if (ip == iend)
+				return -1;
+			nseq = ((nseq - 128) << 8) + *ip++;
+		}
+	}
+
+	if (nseq) {
+		if (ip == iend)
+			return -1;
+		modes = *ip++;
+		if (modes & 3)
+			return -1;
+
+		n = seq_table(&zstd.ll_table, modes >> 6, ll_default, ZSTD_LL_DEFAULT_LOG,
+			      ARRAY_SIZE(ll_default), ZSTD_LL_MAX_LOG, ZSTD_LL_CODES, ip,
+			      iend - ip);
+		if (n < 0)
+			return -1;
+		ip += n;
+		n = seq_table(&zstd.of_table, (modes >> 4) & 3, of_default,
+			      ZSTD_OF_DEFAULT_LOG, ARRAY_SIZE(of_default), ZSTD_OF_MAX_LOG,
+			      ZSTD_OF_CODES, ip, iend - ip);
+		if (n < 0)
+			return -1;
+		ip += n;
+		n = seq_table(&zstd.ml_table, (modes >> 2) & 3, ml_default,
+			      ZSTD_ML_DEFAULT_LOG, ARRAY_SIZE(ml_default), ZSTD_ML_MAX_LOG,
+			      ZSTD_ML_CODES, ip, iend - ip);
+		if (n < 0)
+			return -1;
+		ip += n;
+
+		if (bits_init(&b, ip, iend - ip))
+			return -1;
+		fse_init(&ll, &zstd.ll_table, &b);
+		fse_init(&of, &zstd.of_table, &b);
+		fse_init(&ml, &zstd.ml_table, &b);
+		bits_reload(&b);
+
+		while (nseq--) {
+			ofc = fse_symbol(&of);
+			llc = fse_symbol(&ll);
+			mlc = fse_symbol(&ml);
+
+			offval = (1u << ofc) + bits_read(&b, ofc);
+			bits_reload(&b);
+			matchlen = ml_base[mlc] + bits_read(&b, ml_bits[mlc]);
+			litlen = ll_base[llc] + bits_read(&b, ll_bits[llc]);
+			bits_reload(&b);
+
+			if (offval > 3) {
+				offset = offval - 3;
+				zstd.rep[2] = zstd.rep[1];
+				zstd.rep[1] = zstd.rep[0];
+				zstd.rep[0] = offset;
+			} else {
+				/* Repeat offsets are shifted by one without literals. */
+				idx = offval - 1 + !litlen;
+				if (idx == 0) {
+					offset = zstd.rep[0];
+				} else {
+					offset = idx == 3 ? zstd.rep[0] - 1 : zstd.rep[idx];
+					if (idx != 1)
+						zstd.rep[2] = zstd.rep[1];
+					zstd.rep[1] = zstd.rep[0];
+					zstd.rep[0] = offset;
+				}
+			}
+
+			if (nseq) {
+				fse_update(&ll, &b);
+				fse_update(&ml, &b);
+				fse_update(&of, &b);
+				bits_reload(&b);
+			}
+
+			if (litlen > (size_t)(lit->end - lit->ptr) || litlen > (size_t)(oend - op))
+				return -1;
+			lit_copy(lit, op, litlen, oend);
+			op += litlen;
+
+			if (matchlen > (size_t)(oend - op) || !offset ||
+			    offset > (size_t)(op - ostart))
+				return -1;
+			limit = lit->type == ZSTD_LIT_RAW ? oend : lit->ptr;
+			match_copy(op, offset, matchlen, limit);
+			op += matchlen;
+		}
+
+		if (!bits_done(&b))
+			return -1;
+	} else if (ip != iend) {
+		return -1;
+	}
+
+	/* Whatever is left over follows the last sequence. */
+	n = lit->end - lit->ptr;
+	if (n > oend - op)
+		return -1;
+	lit_copy(lit, op, n, oend);
+	*opp = op + n;
+
+	return 0;
+}
+
+static int decompress_block(const uint8_t *src, size_t size, uint8_t *ostart, uint8_t **opp,
+			    uint8_t *oend)
+{
+	struct zstd_literals lit;
+	int n;
+
+	if (!size)
+		return -1;
+	n = lit_parse(&lit, src, size);
+	if (n < 0)
+		return -1;
+
+	return seq_execute(src + n, size - n, &lit, ostart, opp, oend);
+}
+
+static int decompress_frame(const uint8_t **ipp, const uint8_t *iend, uint8_t **opp,
+			    uint8_t *oend)
+{
+	static const uint8_t did_size[4] = { 0, 1, 2, 4 };
+	static const uint8_t fcs_size[4] = { 0, 2, 4, 8 };
+	const uint8_t *ip = *ipp;
+	uint8_t *const ostart = *opp, *op = ostart;
+	unsigned int fhd, did_n, fcs_n, i;
+	uint32_t magic, bh, bsize;
+	uint64_t did = 0, fcs = 0;
+	bool single, last;
+
+	if (iend - ip < 4)
+		return -1;
+	magic = read_le32(ip);
+	ip += 4;
+
+	if ((magic & ~0xf) == ZSTD_SKIPPABLE_MAGIC) {
+		if (iend - ip < 4 || read_le32(ip) > (size_t)(iend - ip - 4))
+			return -1;
+		*ipp = ip + 4 + read_le32(ip);
+		return 0;
+	}
+	if (magic != ZSTD_MAGIC || ip == iend)
+		return -1;
+
+	/* Frame header: descriptor, window size, dictionary ID and content size. */
+	fhd = *ip++;
+	single = fhd & 0x20;
+	did_n = did_size[fhd & 3];
+	fcs_n = (fhd >> 6) || !single ? fcs_size[fhd >> 6] : 1;
+	if (fhd & 0x08 || (size_t)(iend - ip) < !single + did_n + fcs_n)
+		return -1;
+	if (!single)
+		ip++;
+	for (i = 0; i < did_n; i++)
+		did |= (uint64_t)*ip++ << (i * 8);
+	for (i = 0; i < fcs_n; i++)
+		fcs |= (uint64_t)*ip++ << (i * 8);
+	if (fcs_n == 2)
+		fcs += 256;
+	if (did || (fcs_n && fcs > (size_t)(oend - op)))
+		return -1;
+
+	zstd.rep[0] = 1;
+	zstd.rep[1] = 4;
+	zstd.rep[2] = 8;
+	zstd.huf_valid = false;
+	zstd.ll_table = (struct zstd_fse_table){ .entries = zstd.ll };
+	zstd.ml_table = (struct zstd_fse_table){ .entries = zstd.ml };
+	zstd.of_table = (struct zstd_fse_table){ .entries = zstd.of };
+
+	do {
+		if (iend - ip < 3)
+			return -1;
+		bh = read_le24(ip);
+		ip += 3;
+		last = bh & 1;
+		bsize = bh >> 3;
+		if (bsize > ZSTD_BLOCK_SIZE_MAX)
+			return -1;
+
+		switch ((bh >> 1) & 3) {
+		case ZSTD_BLOCK_RAW:
+			if (bsize > (size_t)(iend - ip) || bsize > (size_t)(oend - op))
+				return -1;
+			memcpy(op, ip, bsize);
+			ip += bsize;
+			op += bsize;
+			break;
+		case ZSTD_BLOCK_RLE:
+			if (ip == iend || bsize > (size_t)(oend - op))
+				return -1;
+			memset(op, *ip++, bsize);
+			op += bsize;
+			break;
+		case ZSTD_BLOCK_COMPRESSED:
+			if (bsize > (size_t)(iend - ip) ||
+			    decompress_block(ip, bsize, ostart, &op, oend))
+				return -1;
+			ip += bsize;
+			break;
+		default:
+			return -1;
+		}
+	} while (!last);
+
+	/* The content checksum only guards against corruption, which CBFS hashes do. */
+	if (fhd & 0x04) {
+		if (iend - ip < 4)
+			return -1;
+		ip += 4;
+	}
+
+	if (fcs_n && (uint64_t)(op - ostart) != fcs)
+		return -1;
+
+	*ipp = ip;
+	*opp = op;
+	return 0;
+}
+
+size_t uzstdn(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	const uint8_t *ip = src, *const iend = ip + srcn;
+	uint8_t *op = dst;
+
+	while (ip < iend)
+		if (decompress_frame(&ip, iend, &op, (uint8_t *)dst + dstn))
+			return 0;
+
+	return op - (uint8_t *)dst;
+}
@@ -35,8 +35,24 @@
 #define LP_ALLOC_NODE_SCRATCH_COUNT 2000
 #define LP_ALLOC_PROP_SCRATCH_COUNT 10000
 
+/*
+ * fdt_unflatten() counts the nodes and properties of the blob first and allocates all of
+ * them in one go. Only nodes and properties added to the tree later are allocated one by
+ * one.
+ */
+static struct {
+	struct device_tree_node *nodes;
+	size_t num_nodes;
+	struct device_tree_property *props;
+	size_t num_props;
+} arena;
+
 static struct device_tree_node *alloc_node(void)
 {
+	if (arena.num_nodes) {
+		arena.num_nodes--;
+		return arena.nodes++;
+	}
 #ifndef __COREBOOT__
 	static struct device_tree_node scratch[LP_ALLOC_NODE_SCRATCH_COUNT];
 	static int counter = 0;
@@ -49,6 +65,10 @@ static struct device_tree_node *alloc_node(void)
 
 static struct device_tree_property *alloc_prop(void)
 {
+	if (arena.num_props) {
+		arena.num_props--;
+		return arena.props++;
+	}
 #ifndef __COREBOOT__
 	static struct device_tree_property scratch[LP_ALLOC_PROP_SCRATCH_COUNT];
 	static int counter = 0;
@@ -59,6 +79,149 @@ static struct device_tree_property *alloc_prop(void)
 	return xzalloc(sizeof(struct device_tree_property));
 }
 
+/*
+ * Hash indices for looking up nodes by parent and name and by root and phandle, shared by
+ * all trees. Nodes are never moved to another parent and dt_delete_node() empties the
+ * indices, so an entry stays correct as long as its node still has the name or phandle it
+ * was added with, which is checked on every hit. Nodes can be missing from the indices
+ * though, e.g. when they were copied from an overlay, so lookups fall back to walking the
+ * tree and add what they find.
+ */
+struct dt_index_entry {
+	const struct device_tree_node *key;	/* Parent, or root for phandles */
+	struct device_tree_node *node;
+	uint32_t hash;
+};
+
+struct dt_index {
+	struct dt_index_entry *entries;
+	size_t size;				/* Power of 2, or 0 */
+	size_t used;
+};
+
+static struct dt_index dt_name_index;
+static struct dt_index dt_phandle_index;
+
+static uint32_t dt_index_hash(const struct device_tree_node *key, const char *name,
+			      uint32_t phandle)
+{
+	uint32_t hash = 2166136261u ^ (uint32_t)(uintptr_t)key ^ phandle;
+
+	/* FNV-1a */
+	while (name && *name)
+		hash = (hash ^ (uint8_t)*name++) * 16777619u;
+
+	return (hash ^ (hash >> 15)) * 0x2c1b3c6d;
+}
+
+static void dt_index_insert(struct dt_index *idx, const struct dt_index_entry *e)
+{
+	size_t i = e->hash & (idx->size - 1);
+
+	while (idx->entries[i].node)
+		i = (i + 1) & (idx->size - 1);
+
+	idx->entries[i] = *e;
+	idx->used++;
+}
+
+/* Makes sure that another n entries fit at a load of at most 3/4. */
+static bool dt_index_reserve(struct dt_index *idx, size_t n)
+{
+	struct dt_index_entry *old = idx->entries;
+	size_t old_size = idx->size;
+	size_t size = MAX(old_size, 64);
+	size_t i;
+
+	while ((idx->used + n) * 4 > size * 3)
+		size *= 2;
+
+	if (size == old_size)
+		return true;
+
+	idx->entries = calloc(size, sizeof(*idx->entries));
+	if (!idx->entries) {
+		idx->entries = old;
+		return false;
+	}
+
+	idx->size = size;
+	idx->used = 0;
+	for (i = 0; i < old_size; i++) {
+		if (old[i].node)
+			dt_index_insert(idx, &old[i]);
+	}
+	free(old);
+
+	return true;
+}
+
+static void dt_index_clear(struct dt_index *idx)
+{
+	if (idx->size)
+		memset(idx->entries, 0, idx->size * sizeof(*idx->entries));
+	idx->used = 0;
+}
+
+static void dt_index_add(struct dt_index *idx, const struct device_tree_node *key,
+			 struct device_tree_node *node, uint32_t hash)
+{
+	const struct dt_index_entry e = { .key = key, .node = node, .hash = hash };
+
+	if (dt_index_reserve(idx, 1))
+		dt_index_insert(idx, &e);
+}
+
+static void dt_index_add_child(struct device_tree_node *parent, struct device_tree_node *node)
+{
+	dt_index_add(&dt_name_index, parent, node, dt_index_hash(parent, node->name, 0));
+}
+
+static void dt_index_add_phandle(struct device_tree_node *root, struct device_tree_node *node)
+{
+	dt_index_add(&dt_phandle_index, root, node, dt_index_hash(root, NULL, node->phandle));
+}
+
+static struct device_tree_node *dt_index_find_child(const struct device_tree_node *parent,
+						    const char *name)
+{
+	const uint32_t hash = dt_index_hash(parent, name, 0);
+	const struct dt_index *idx = &dt_name_index;
+	size_t i;
+
+	if (!idx->size)
+		return NULL;
+
+	for (i = hash & (idx->size - 1); idx->entries[i].node; i = (i + 1) & (idx->size - 1)) {
+		const struct dt_index_entry *e = &idx->entries[i];
+
+		if (e->hash == hash && e->key == parent && !strcmp(e->node->name, name))
+			return e->node;
+	}
+
+	return NULL;
+}
+
+static struct device_tree_node *dt_index_find_phandle(const struct device_tree_node *root,
+						      uint32_t phandle)
+{
+	const uint32_t hash = dt_index_hash(root, NULL, phandle);
+	const struct dt_index *idx = &dt_phandle_index;
+	size_t i;
+
+	if (!idx->size)
+		return NULL;
+
+	for (i = hash & (idx->size - 1); idx->entries[i].node; i = (i + 1) & (idx->size - 1)) {
+		const struct dt_index_entry *e = &idx->entries[i];
+
+		if (e->hash == hash && e->key == root && e->node->phandle == phandle)
+			return e->node;
+	}
+
+	return NULL;
+}
+
 /*
  * Functions for picking apart flattened trees.
  */
@@ -636,6 +799,250 @@ uint64_t fdt_get_memory_top(const void *blob)
 	return top;
 }
 
+/*
+ * Functions for editing flattened trees in place.
+ */
+
+bool fdt_is_editable(const void *blob, size_t buf_size)
+{
+	const struct fdt_header *header = (const struct fdt_header *)blob;
+
+	if (!fdt_is_valid(blob) || be32toh(header->version) < FDT_SUPPORTED_VERSION)
+		return false;
+
+	uint32_t total_size = be32toh(header->totalsize);
+	uint32_t reserve_offset = be32toh(header->reserve_map_offset);
+	uint32_t struct_offset = be32toh(header->structure_offset);
+	uint32_t struct_size = be32toh(header->structure_size);
+	uint32_t strings_offset = be32toh(header->strings_offset);
+	uint32_t strings_size = be32toh(header->strings_size);
+
+	/* Edits only move what comes behind them, so the blocks need to be in dtc order. */
+	return reserve_offset >= sizeof(*header) && reserve_offset < struct_offset &&
+	       struct_offset + struct_size <= strings_offset &&
+	       strings_offset + strings_size <= total_size && total_size <= buf_size;
+}
+
+/*
+ * Open up (delta > 0) or close (delta < 0) a gap at offset by moving everything behind it.
+ * The caller accounts for the change in the size of the block it edits.
+ */
+static int fdt_resize_at(void *blob, size_t buf_size, uint32_t offset, int32_t delta)
+{
+	struct fdt_header *header = (struct fdt_header *)blob;
+	uint32_t total_size = be32toh(header->totalsize);
+	uint32_t block_offset;
+
+	if (total_size + delta > buf_size)
+		return -1;
+
+	memmove((uint8_t *)blob + offset + delta, (uint8_t *)blob + offset,
+		total_size - offset);
+	header->totalsize = htobe32(total_size + delta);
+
+	block_offset = be32toh(header->structure_offset);
+	if (block_offset > offset)
+		header->structure_offset = htobe32(block_offset + delta);
+	block_offset = be32toh(header->strings_offset);
+	if (block_offset > offset)
+		header->strings_offset = htobe32(block_offset + delta);
+
+	return 0;
+}
+
+static void fdt_add_struct_size(void *blob, int32_t delta)
+{
+	struct fdt_header *header = (struct fdt_header *)blob;
+
+	header->structure_size = htobe32(be32toh(header->structure_size) + delta);
+}
+
+/* Returns the offset of str in the strings block, or -1 if it isn't there. */
+static int32_t fdt_find_string(const void *blob, const char *str)
+{
+	const struct fdt_header *header = (const struct fdt_header *)blob;
+	const char *strings = (const char *)blob + be32toh(header->strings_offset);
+	uint32_t strings_size = be32toh(header->strings_size);
+	size_t len = strlen(str) + 1;
+	uint32_t i;
+
+	/* Names may share the tail of a longer one, so look for any match ending in a NUL. */
+	for (i = 0; i + len <= strings_size; i++) {
+		if (strings[i] == str[0] && !memcmp(strings + i, str, len))
+			return i;
+	}
+
+	return -1;
+}
+
+static int32_t fdt_add_string(void *blob, size_t buf_size, const char *str)
+{
+	struct fdt_header *header = (struct fdt_header *)blob;
+	uint32_t strings_offset = be32toh(header->strings_offset);
+	uint32_t strings_size = be32toh(header->strings_size);
+	size_t len = strlen(str) + 1;
+
+	if (fdt_resize_at(blob, buf_size, strings_offset + strings_size, len))
+		return -1;
+
+	memcpy((uint8_t *)blob + strings_offset + strings_size, str, len);
+	header->strings_size = htobe32(strings_size + len);
+
+	return strings_size;
+}
+
+int fdt_set_prop(void *blob, size_t buf_size, uint32_t node_offset, const char *name,
+		 const void *data, uint32_t size)
+{
+	const uint32_t padded_size = ALIGN_UP(size, sizeof(uint32_t));
+	struct fdt_property prop;
+	uint32_t offset;
+	int32_t name_offset;
+	uint32_t *ptr;
+	int prop_size;
+
+	int name_size = fdt_next_node_name(blob, node_offset, NULL);
+	if (!name_size)
+		return -1;
+	offset = node_offset + name_size;
+
+	while ((prop_size = fdt_next_property(blob, offset, &prop))) {
+		if (!strcmp(prop.name, name))
+			break;
+		offset += prop_size;
+	}
+
+	if (prop_size) {
+		int32_t delta = padded_size - ALIGN_UP(prop.size, sizeof(uint32_t));
+
+		if (fdt_resize_at(blob, buf_size, offset + prop_size, delta))
+			return -1;
+		fdt_add_struct_size(blob, delta);
+		ptr = (uint32_t *)((uint8_t *)blob + offset);
+		ptr[1] = htobe32(size);
+	} else {
+		const uint32_t prop_bytes = 3 * sizeof(uint32_t) + padded_size;
+
+		/* Check for room up front so that a failed call doesn't leave a stray name. */
+		name_offset = fdt_find_string(blob, name);
+		if (be32toh(((struct fdt_header *)blob)->totalsize) + prop_bytes +
+		    (name_offset < 0 ? strlen(name) + 1 : 0) > buf_size)
+			return -1;
+		if (name_offset < 0)
+			name_offset = fdt_add_string(blob, buf_size, name);
+
+		fdt_resize_at(blob, buf_size, offset, prop_bytes);
+		fdt_add_struct_size(blob, prop_bytes);
+		ptr = (uint32_t *)((uint8_t *)blob + offset);
+		ptr[0] = htobe32(FDT_TOKEN_PROPERTY);
+		ptr[1] = htobe32(size);
+		ptr[2] = htobe32(name_offset);
+	}
+
+	memcpy(&ptr[3], data, size);
+	memset((uint8_t *)&ptr[3] + size, 0, padded_size - size);
+
+	return 0;
+}
+
+uint32_t fdt_add_node(void *blob, size_t buf_size, uint32_t parent_offset, const char *name)
+{
+	const uint32_t name_size = ALIGN_UP(strlen(name) + 1, sizeof(uint32_t));
+	const uint32_t node_size = 2 * sizeof(uint32_t) + name_size;
+	uint32_t *ptr;
+
+	int parent_size = fdt_skip_node(blob, parent_offset);
+	if (!parent_size)
+		return 0;
+
+	/* New nodes go last, in front of the parent's end token. */
+	uint32_t offset = parent_offset + parent_size - sizeof(uint32_t);
+	if (fdt_resize_at(blob, buf_size, offset, node_size))
+		return 0;
+	fdt_add_struct_size(blob, node_size);
+
+	ptr = (uint32_t *)((uint8_t *)blob + offset);
+	ptr[0] = htobe32(FDT_TOKEN_BEGIN_NODE);
+	memset(&ptr[1], 0, name_size);
+	strcpy((char *)&ptr[1], name);
+	ptr[1 + name_size / sizeof(uint32_t)] = htobe32(FDT_TOKEN_END_NODE);
+
+	return offset;
+}
+
+uint32_t fdt_add_node_by_path(void *blob, size_t buf_size, const char *path,
+			      uint32_t *addrcp, uint32_t *sizecp)
+{
+	const struct fdt_header *header = (const struct fdt_header *)blob;
+	uint32_t node_offset = be32toh(header->structure_offset);
+	char path_copy[FDT_PATH_MAX_LEN];
+	char *cur = path_copy;
+	const char *name;
+
+	if (path[0] != '/' || strlen(path) >= FDT_PATH_MAX_LEN)
+		return 0;
+	strcpy(path_copy, path);
+
+	while ((name = strtok_r(NULL, "/", &cur))) {
+		uint32_t offset = node_offset + fdt_next_node_name(blob, node_offset, NULL);
+		const char *child_name;
+		int size;
+
+		offset = fdt_read_cell_props(blob, offset, addrcp, sizecp);
+		while ((size = fdt_next_node_name(blob, offset, &child_name))) {
+			if (!strcmp(name, child_name))
+				break;
+			offset += fdt_skip_node(blob, offset);
+		}
+
+		/* Adding a child doesn't move its parent, so node_offset stays valid. */
+		if (!size)
+			offset = fdt_add_node(blob, buf_size, node_offset, name);
+		if (!offset)
+			return 0;
+		node_offset = offset;
+	}
+
+	return node_offset;
+}
+
+void fdt_delete_node(void *blob, uint32_t node_offset)
+{
+	const struct fdt_header *header = (const struct fdt_header *)blob;
+	int size = fdt_skip_node(blob, node_offset);
+
+	if (!size)
+		return;
+
+	fdt_resize_at(blob, be32toh(header->totalsize), node_offset + size, -size);
+	fdt_add_struct_size(blob, -size);
+}
+
+int fdt_add_reserve_map_entry(void *blob, size_t buf_size, uint64_t start, uint64_t size)
+{
+	const struct fdt_header *header = (const struct fdt_header *)blob;
+	uint32_t offset = be32toh(header->reserve_map_offset);
+	uint32_t struct_offset = be32toh(header->structure_offset);
+	uint64_t *ptr;
+
+	/* Find the terminating entry and put the new one in front of it. */
+	while (offset + 2 * sizeof(uint64_t) <= struct_offset &&
+	       (be64dec((uint8_t *)blob + offset) ||
+		be64dec((uint8_t *)blob + offset + sizeof(uint64_t))))
+		offset += 2 * sizeof(uint64_t);
+	if (offset + 2 * sizeof(uint64_t) > struct_offset)
+		return -1;
+
+	if (fdt_resize_at(blob, buf_size, offset, 2 * sizeof(uint64_t)))
+		return -1;
+
+	ptr = (uint64_t *)((uint8_t *)blob + offset);
+	ptr[0] = htobe64(start);
+	ptr[1] = htobe64(size);
+
+	return 0;
+}
+
 /*
  * Functions to turn a flattened tree into an unflattened one.
  */
@@ -674,6 +1081,7 @@ static int fdt_unflatten_node(const void *blob, uint32_t start_offset,
 			node->phandle = be32dec(prop->prop.data);
 			if (node->phandle > tree->max_phandle)
 				tree->max_phandle = node->phandle;
+			dt_index_add_phandle(tree->root, node);
 		}
 
 		list_insert_after(&prop->list_node, last);
@@ -687,6 +1095,7 @@ static int fdt_unflatten_node(const void *blob, uint32_t start_offset,
 	while ((size = fdt_unflatten_node(blob, offset, tree, &child))) {
 		list_insert_after(&child->list_node, last);
 		last = &child->list_node;
+		dt_index_add_child(node, child);
 
 		offset += size;
 	}
@@ -712,6 +1121,36 @@ static int fdt_unflatten_map_entry(const void *blob, uint32_t offset,
 	return sizeof(uint64_t) * 2;
 }
 
+/* Counts the nodes and properties in the structure block for the arena. */
+static void fdt_count_entries(const void *blob, uint32_t offset, size_t *nodes, size_t *props)
+{
+	const struct fdt_header *header = (const struct fdt_header *)blob;
+	const uint32_t end = be32toh(header->totalsize);
+	const uint8_t *ptr = blob;
+
+	*nodes = 0;
+	*props = 0;
+
+	while (offset + sizeof(uint32_t) <= end) {
+		switch (be32dec(ptr + offset)) {
+		case FDT_TOKEN_BEGIN_NODE:
+			(*nodes)++;
+			offset += fdt_next_node_name(blob, offset, NULL);
+			break;
+		case FDT_TOKEN_PROPERTY:
+			(*props)++;
+			offset += fdt_next_property(blob, offset, NULL);
+			break;
+		case FDT_TOKEN_END_NODE:
+		case FDT_TOKEN_NOP:
+			offset += sizeof(uint32_t);
+			break;
+		default:
+			return;
+		}
+	}
+}
+
 bool fdt_is_valid(const void *blob)
 {
 	const struct fdt_header *header = (const struct fdt_header *)blob;
@@ -766,8 +1205,27 @@ struct device_tree *fdt_unflatten(const void *blob)
 		offset += size;
 	}
 
+	size_t num_nodes, num_props;
+	fdt_count_entries(blob, struct_offset, &num_nodes, &num_props);
+	if (num_nodes) {
+		arena.nodes = xzalloc(num_nodes * sizeof(*arena.nodes));
+		arena.num_nodes = num_nodes;
+	}
+	if (num_props) {
+		arena.props = xzalloc(num_props * sizeof(*arena.props));
+		arena.num_props = num_props;
+	}
+
+	/* Failing to size the indices up front only makes building them slower. */
+	dt_index_reserve(&dt_name_index, num_nodes);
+	dt_index_reserve(&dt_phandle_index, num_nodes);
+
 	fdt_unflatten_node(blob, struct_offset, tree, &tree->root);
 
+	/* The arena is sized exactly, but don't hand out what a broken blob left over. */
+	arena.num_nodes = 0;
+	arena.num_props = 0;
+
 	return tree;
 }
 
@@ -1026,10 +1484,14 @@ struct device_tree_node *dt_find_node(struct device_tree_node *parent,
 		return parent;
 
 	/* Find the next node in the path, if it exists. */
-	list_for_each(node, parent->children, list_node) {
-		if (!strcmp(node->name, *path)) {
-			found = node;
-			break;
+	found = dt_index_find_child(parent, *path);
+	if (!found) {
+		list_for_each(node, parent->children, list_node) {
+			if (!strcmp(node->name, *path)) {
+				found = node;
+				dt_index_add_child(parent, found);
+				break;
+			}
 		}
 	}
 
@@ -1044,6 +1506,7 @@ struct device_tree_node *dt_find_node(struct device_tree_node *parent,
 			return NULL;
 
 		list_insert_after(&found->list_node, &parent->children);
+		dt_index_add_child(parent, found);
 	}
 
 	return dt_find_node(found, path + 1, addrcp, sizecp, create);
@@ -1163,19 +1626,16 @@ struct device_tree_node *dt_find_node_by_alias(struct device_tree *tree,
 	return dt_find_node_by_path(tree, alias_path, NULL, NULL, 0);
 }
 
-struct device_tree_node *dt_find_node_by_phandle(struct device_tree_node *root,
-						 uint32_t phandle)
+static struct device_tree_node *dt_walk_phandle(struct device_tree_node *root,
+						uint32_t phandle)
 {
-	if (!root)
-		return NULL;
-
 	if (root->phandle == phandle)
 		return root;
 
 	struct device_tree_node *node;
 	struct device_tree_node *result;
 	list_for_each(node, root->children, list_node) {
-		result = dt_find_node_by_phandle(node, phandle);
+		result = dt_walk_phandle(node, phandle);
 		if (result)
 			return result;
 	}
@@ -1183,6 +1643,29 @@ struct device_tree_node *dt_find_node_by_phandle(struct device_tree_node *root,
 	return NULL;
 }
 
+struct device_tree_node *dt_find_node_by_phandle(struct device_tree_node *root,
+						 uint32_t phandle)
+{
+	struct device_tree_node *node;
+
+	if (!root)
+		return NULL;
+
+	/* Nodes without a phandle have 0 there, so the walk finds the root for 0. */
+	if (!phandle)
+		return dt_walk_phandle(root, phandle);
+
+	node = dt_index_find_phandle(root, phandle);
+	if (node)
+		return node;
+
+	node = dt_walk_phandle(root, phandle);
+	if (node)
+		dt_index_add_phandle(root, node);
+
+	return node;
+}
+
 /*
  * Check if given node is compatible.
  *
@@ -1345,6 +1828,22 @@ void dt_delete_prop(struct device_tree_node *node, const char *name)
 	}
 }
 
+/*
+ * Delete a node and everything below it from the tree. This has to be used instead of
+ * removing the node from its parent's list directly, so it doesn't stay in the lookup
+ * indices.
+ *
+ * @param node		The device tree node to delete.
+ */
+void dt_delete_node(struct device_tree_node *node)
+{
+	list_remove(&node->list_node);
+
+	/* Finding every entry below the node isn't worth it, deleting nodes is rare. */
+	dt_index_clear(&dt_name_index);
+	dt_index_clear(&dt_phandle_index);
+}
+
 /*
  * Add an arbitrary property to a node, or update it if it already exists.
  *
@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_CBFS_TRACE_SERIALIZED_H
+#define COMMONLIB_CBFS_TRACE_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+#define CBFS_TRACE_STAGE_LEN	16
+#define CBFS_TRACE_NAME_LEN	64
+
+/* One access to a CBFS file, as recorded during boot and listed in the prefetch hints. */
+struct cbfs_access_record {
+	char stage[CBFS_TRACE_STAGE_LEN];	/* ENV_STRING of the accessing stage */
+	char name[CBFS_TRACE_NAME_LEN];
+	uint32_t size;				/* Size of the file data in CBFS */
+} __packed;
+
+/* Contents of CBMEM_ID_CBFS_TRACE, in native byte order. */
+struct cbfs_access_trace {
+	uint32_t max_entries;
+	uint32_t num_entries;
+	uint32_t dropped;
+	struct cbfs_access_record records[];
+} __packed;
+
+#define CBFS_PREFETCH_HINTS_NAME	"prefetch_hints"
+#define CBFS_PREFETCH_HINTS_MAGIC	0x48465043	/* "CPFH" */
+
+/*
+ * Contents of the prefetch hints CBFS file, written by cbfstool from a trace. The numbers
+ * are little-endian, each stage lists the files it needs in the order it accesses them.
+ */
+struct cbfs_prefetch_hints {
+	uint32_t magic;
+	uint32_t num_records;
+	struct cbfs_access_record records[];
+} __packed;
+
+#endif
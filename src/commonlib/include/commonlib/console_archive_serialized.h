@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_CONSOLE_ARCHIVE_SERIALIZED_H
+#define COMMONLIB_CONSOLE_ARCHIVE_SERIALIZED_H
+
+#include <stdint.h>
+
+#define CONSOLE_ARCHIVE_MAGIC	0x41435a4c	/* 'LZCA' */
+
+/*
+ * Contents of CBMEM_ID_CONSOLE_ARCHIVE, in native byte order. Before a page of
+ * the CBMEM console is overwritten, it gets compressed into a ring of segments
+ * here, oldest first from head. The newest segment is always the page of the
+ * console that starts at or before its cursor, which is still in the console
+ * as well. Once there is no room, the oldest segments are dropped.
+ */
+struct console_archive {
+	uint32_t magic;
+	uint32_t size;			/* of data */
+	uint32_t page_size;		/* Largest text_size of a segment */
+	uint32_t head;			/* Offset of the oldest segment */
+	uint32_t tail;			/* Offset behind the newest segment */
+	uint32_t segments;
+	uint32_t dropped;		/* Text bytes in dropped segments */
+	uint8_t data[];
+} __packed;
+
+#define CONSOLE_ARCHIVE_STORED	0x8000
+
+/*
+ * The header of a segment, followed by block_size bytes and padding up to
+ * 4 bytes. The block is the text in LZ4 block format, or the text itself
+ * with CONSOLE_ARCHIVE_STORED. A text_size of 0 means the next segment is
+ * at the start of data, just like a segment header that doesn't fit.
+ */
+struct console_archive_segment {
+	uint16_t text_size;
+	uint16_t block_size;
+} __packed;
+
+#endif
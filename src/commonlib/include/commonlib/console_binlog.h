@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#ifndef COMMONLIB_CONSOLE_BINLOG_H
+#define COMMONLIB_CONSOLE_BINLOG_H
+
+/*
+ * With CONSOLE_CBMEM_BINARY_LOG, messages that only go to the CBMEM console
+ * are stored as records instead of text. A record is
+ *
+ *   BINLOG_MARKER, log level, stage, format offset (4 bytes),
+ *   argument size (2 bytes), arguments
+ *
+ * with all fields little endian. The format offset is relative to the start
+ * of the .text section of the stage, which includes its read-only data.
+ *
+ * The arguments follow the conversions in the format string in order. Each
+ * number, including '*' widths and precisions, is LEB128 coded as the 64-bit
+ * value vtxprintf() would print. Each string is stored with its length as a
+ * number first, then the characters vtxprintf() would print.
+ *
+ * The build writes the .text sections of all stages to console_strings.bin,
+ * each one after a BINLOG_STRTAB_HEADER line with the stage and its size.
+ */
+
+#define BINLOG_MARKER			0x1e
+#define BINLOG_RECORD_HEADER_SIZE	9
+#define BINLOG_STRTAB_HEADER		"CBSTRTAB %u %u\n"
+
+#define BINLOG_STAGE_BOOTBLOCK		1
+#define BINLOG_STAGE_VERSTAGE		2
+#define BINLOG_STAGE_ROMSTAGE		3
+#define BINLOG_STAGE_POSTCAR		4
+#define BINLOG_STAGE_RAMSTAGE		5
+#define BINLOG_STAGE_MAX		BINLOG_STAGE_RAMSTAGE
+
+#endif /* COMMONLIB_CONSOLE_BINLOG_H */
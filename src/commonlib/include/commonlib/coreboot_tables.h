@@ -153,6 +153,8 @@ struct lb_pcie {
 	uint32_t tag;
 	uint32_t size;
 	lb_uint64_t ctrl_base;		/* Base address of PCIe controller */
+	lb_uint64_t ecam_base;		/* ECAM window of segment 0, 0 if there is none */
+	lb_uint64_t ecam_size;
 };
 _Static_assert(_Alignof(struct lb_pcie) == 4,
 	       "lb_uint64_t alignment doesn't work as expected for struct lb_pcie!");
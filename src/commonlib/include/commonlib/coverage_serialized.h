@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_COVERAGE_SERIALIZED_H
+#define COMMONLIB_COVERAGE_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+/*
+ * Compact dump of the gcov counters in CBMEM_ID_COVERAGE. It holds what the .gcda files
+ * need, but without their tags, lengths and summaries, and it leaves out counter arrays
+ * that are all zero. util/cbmem turns it back into one .gcda file per object file.
+ *
+ * Everything is made of 32-bit words. 64-bit counters are stored low word first.
+ */
+
+#define COVERAGE_MAGIC		0x56434243	/* "CBCV" */
+#define COVERAGE_VERSION	1
+
+/* Set in the number of counters if they are all zero and therefore not stored. */
+#define COVERAGE_CTR_ZERO	(1U << 31)
+
+struct coverage_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;			/* Bytes used, including this header */
+	uint32_t num_objects;
+	/* Followed by num_objects objects */
+} __packed;
+
+struct coverage_object {
+	uint32_t size;			/* Bytes used, including this header */
+	uint32_t gcov_version;		/* GCOV_VERSION the object was compiled for */
+	uint32_t stamp;
+	uint32_t n_functions;
+	uint32_t ctr_mask;		/* Bit n is set if counter type n is in use */
+	uint32_t filename_size;		/* Including the NUL, padded to a multiple of 4 */
+	/* Followed by the .gcda file name and n_functions functions */
+} __packed;
+
+/*
+ * A function whose code is in another object, e.g. an inline function that the linker
+ * picked from elsewhere, consists of a zero present word only. Otherwise each counter
+ * type in ctr_mask follows in turn: one word with the number of counters, which may
+ * carry COVERAGE_CTR_ZERO, and then the counters unless it does.
+ */
+struct coverage_function {
+	uint32_t present;
+	uint32_t ident;
+	uint32_t lineno_checksum;
+	uint32_t cfg_checksum;
+} __packed;
+
+#endif
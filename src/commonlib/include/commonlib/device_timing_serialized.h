@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_DEVICE_TIMING_SERIALIZED_H
+#define COMMONLIB_DEVICE_TIMING_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+#define DEV_TIMING_PATH_LEN	40
+
+enum dev_timing_op {
+	DEV_TIMING_SCAN_BUS,
+	DEV_TIMING_READ_RESOURCES,
+	DEV_TIMING_SET_RESOURCES,
+	DEV_TIMING_ENABLE_RESOURCES,
+	DEV_TIMING_INIT,
+	DEV_TIMING_FINAL,
+	DEV_TIMING_RESUME,
+	DEV_TIMING_OP_COUNT,
+};
+
+/* One call of a device_operations method. */
+struct dev_timing_record {
+	char path[DEV_TIMING_PATH_LEN];		/* dev_path() of the device */
+	uint8_t op;				/* enum dev_timing_op */
+	uint8_t reserved[3];
+	uint32_t usecs;
+} __packed;
+
+/* Contents of CBMEM_ID_DEV_TIMING, in native byte order. */
+struct dev_timing_table {
+	uint32_t max_entries;
+	uint32_t num_entries;
+	uint32_t dropped;
+	struct dev_timing_record records[];
+} __packed;
+
+#endif
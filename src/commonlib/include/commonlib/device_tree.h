@@ -133,6 +133,30 @@ size_t fdt_read_memory_regions(const void *blob, struct device_tree_region regio
  /* Find top of memory from a flat device-tree. */
 uint64_t fdt_get_memory_top(const void *blob);
 
+/*
+ * Edit a flattened tree in place. The blob sits in a buffer of buf_size bytes which
+ * totalsize may grow into. Every edit moves what comes behind it, so offsets that were
+ * looked up before an edit are only valid afterwards if they lie in front of it (e.g. the
+ * parents of an added node).
+ */
+/* Checks that blob is valid and laid out in a way the functions below can edit. */
+bool fdt_is_editable(const void *blob, size_t buf_size);
+/* Add or replace a property of a node. Returns 0 on success, -1 if it doesn't fit. */
+int fdt_set_prop(void *blob, size_t buf_size, uint32_t node_offset, const char *name,
+		 const void *data, uint32_t size);
+/* Add an empty node as the last child of a node. Returns its offset or 0 on error. */
+uint32_t fdt_add_node(void *blob, size_t buf_size, uint32_t parent_offset, const char *name);
+/*
+ * Like fdt_find_node_by_path(), but creates missing nodes and leaves addrcp/sizecp alone
+ * unless the path sets them. Returns 0 on error.
+ */
+uint32_t fdt_add_node_by_path(void *blob, size_t buf_size, const char *path,
+			      uint32_t *addrcp, uint32_t *sizecp);
+/* Delete a node with all its properties and children. */
+void fdt_delete_node(void *blob, uint32_t node_offset);
+/* Add an entry to the memory reservation map. Returns 0 on success, -1 on error. */
+int fdt_add_reserve_map_entry(void *blob, size_t buf_size, uint64_t start, uint64_t size);
+
 /* Read a flattened device tree into a hierarchical structure which refers to
    the contents of the flattened tree in place. Modifying the flat tree
    invalidates the unflattened one. */
@@ -177,6 +201,8 @@ struct device_tree_node *dt_find_prop_value(struct device_tree_node *parent, con
 void dt_write_int(u8 *dest, u64 src, size_t length);
 /* Delete a property */
 void dt_delete_prop(struct device_tree_node *node, const char *name);
+/* Delete a node and its subtree */
+void dt_delete_node(struct device_tree_node *node);
 /* Add different kinds of properties to a node, or update existing ones. */
 void dt_add_bin_prop(struct device_tree_node *node, const char *name,
 		     void *data, size_t size);
@@ -17,9 +17,20 @@
  * were chosen to optimize for the CBFS cache case which may need two buffers
  * to map a single compressed file, and will free them in reverse order.)
  *
+ * A pool created with MEM_POOL_INIT_FREE_LIST() instead keeps track of up to
+ * 'max_blocks' live allocations in a caller provided array, so allocations can
+ * be freed in any order. Freed space is reused by the next allocations that fit
+ * into it (smallest fitting gap first), neighboring free space merges on its
+ * own. Allocating fails once all blocks are in use.
+ *
  * You must ensure the backing buffer is 'alignment' aligned.
  */
 
+struct mem_pool_block {
+	size_t offset;
+	size_t size;
+};
+
 struct mem_pool {
 	uint8_t *buf;
 	size_t size;
@@ -27,6 +38,11 @@ struct mem_pool {
 	uint8_t *last_alloc;
 	uint8_t *second_to_last_alloc;
 	size_t free_offset;
+	size_t peak_offset;
+	/* Live allocations sorted by offset, NULL for a LIFO pool. */
+	struct mem_pool_block *blocks;
+	size_t max_blocks;
+	size_t num_blocks;
 };
 
 #define MEM_POOL_INIT(buf_, size_, alignment_)	\
@@ -37,6 +53,16 @@ struct mem_pool {
 		.last_alloc = NULL,		\
 		.second_to_last_alloc = NULL,	\
 		.free_offset = 0,		\
+		.peak_offset = 0,		\
+	}
+
+#define MEM_POOL_INIT_FREE_LIST(buf_, size_, alignment_, blocks_, max_blocks_)	\
+	{								\
+		.buf = (buf_),						\
+		.size = (size_),					\
+		.alignment = (alignment_),				\
+		.blocks = (blocks_),					\
+		.max_blocks = (max_blocks_),				\
 	}
 
 static inline void mem_pool_reset(struct mem_pool *mp)
@@ -44,9 +70,10 @@ static inline void mem_pool_reset(struct mem_pool *mp)
 	mp->last_alloc = NULL;
 	mp->second_to_last_alloc = NULL;
 	mp->free_offset = 0;
+	mp->num_blocks = 0;
 }
 
-/* Initialize a memory pool. */
+/* Initialize a memory pool. A free-list pool keeps its block array. */
 static inline void mem_pool_init(struct mem_pool *mp, void *buf, size_t sz,
 					 size_t alignment)
 {
@@ -56,9 +83,16 @@ static inline void mem_pool_init(struct mem_pool *mp, void *buf, size_t sz,
 	mp->buf = buf;
 	mp->size = sz;
 	mp->alignment = alignment;
+	mp->peak_offset = 0;
 	mem_pool_reset(mp);
 }
 
+/* Highest number of bytes that were allocated from the pool at the same time. */
+static inline size_t mem_pool_peak(const struct mem_pool *mp)
+{
+	return mp->peak_offset;
+}
+
 /* Allocate requested size from the memory pool. NULL returned on error. */
 void *mem_pool_alloc(struct mem_pool *mp, size_t sz);
 
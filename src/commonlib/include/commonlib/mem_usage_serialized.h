@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_MEM_USAGE_SERIALIZED_H
+#define COMMONLIB_MEM_USAGE_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+#define MEM_USAGE_STAGE_LEN	16
+#define MEM_USAGE_MAX_STAGES	8
+
+/* Sizes and high-water marks in bytes of one stage. A size of 0 means not measured. */
+struct mem_usage_record {
+	char stage[MEM_USAGE_STAGE_LEN];	/* ENV_STRING of the stage */
+	uint32_t heap_size;
+	uint32_t heap_peak;
+	uint32_t cbfs_cache_size;
+	uint32_t cbfs_cache_peak;
+	uint32_t stack_size;
+	uint32_t stack_peak;
+	uint32_t thread_stack_size;		/* Per thread */
+	uint32_t thread_stack_peak;		/* Of the thread that used the most */
+	uint32_t car_size;
+	uint32_t car_used;			/* Statically allocated CAR */
+} __packed;
+
+/* Contents of CBMEM_ID_MEM_USAGE, in native byte order. */
+struct mem_usage_table {
+	uint32_t num_entries;
+	struct mem_usage_record records[MEM_USAGE_MAX_STAGES];
+} __packed;
+
+#endif
@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef COMMONLIB_PROFILE_SERIALIZED_H
+#define COMMONLIB_PROFILE_SERIALIZED_H
+
+#include <commonlib/bsd/helpers.h>
+#include <stdint.h>
+
+/* Maximum number of return addresses recorded per sample, including the sampled PC. */
+#define PROFILE_MAX_DEPTH 8
+
+struct profile_sample {
+	uint32_t depth;
+	uint32_t weight; /* Number of sampling periods this sample stands for */
+	uint64_t pc[PROFILE_MAX_DEPTH]; /* Innermost frame first */
+} __packed;
+
+struct profile_table {
+	/* Runtime address of the _program symbol, to relocate samples against the ELF. */
+	uint64_t text_base;
+	uint32_t sample_hz;
+	uint32_t max_entries;
+	uint32_t num_entries;
+	uint32_t dropped;
+	struct profile_sample samples[]; /* Variable number of samples */
+} __packed;
+
+#endif
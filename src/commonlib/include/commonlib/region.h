@@ -284,6 +284,48 @@ void xlate_region_device_rw_init(struct xlate_region_device *xdev,
 void xlate_window_init(struct xlate_window *window, const struct region_device *access_dev,
 			      size_t sub_region_offset, size_t sub_region_size);
 
+/*
+ * A cache region device sits in front of a slow, non-memory-mapped region device (e.g. SPI
+ * flash behind a command based controller) and keeps recently read blocks of it in a caller
+ * provided buffer. Reads smaller than a block are served from the cache, with the least
+ * recently used block being replaced on a miss. When a miss hits the block right after the
+ * previously accessed one, up to |readahead| following blocks are fetched with the same
+ * backing read. Reads of at least one block go straight to the backing device, since there is
+ * no command overhead left to save. Writes and erases are passed through and drop any cached
+ * block they overlap.
+ *
+ * mmap() is provided through the mmap helper if a mem_pool is given, otherwise it fails.
+ */
+struct cache_rdev_block {
+	size_t offset;
+	size_t size;		/* 0 if the block holds no data. */
+	uint32_t last_use;
+};
+
+struct cache_region_device {
+	const struct region_device *backing;
+	struct cache_rdev_block *blocks;
+	uint8_t *buf;		/* nr_blocks * block_size bytes */
+	size_t nr_blocks;
+	size_t block_size;
+	size_t readahead;
+	size_t last_block;
+	uint32_t use_count;
+	struct mmap_helper_region_device mdev;
+};
+
+/*
+ * Initialize a cache region device covering all of |backing|. |blocks| must have |nr_blocks|
+ * entries and |buf| must hold |nr_blocks| * |block_size| bytes. |pool| may be NULL.
+ */
+const struct region_device *cache_region_device_init(struct cache_region_device *cdev,
+			const struct region_device *backing, struct cache_rdev_block *blocks,
+			void *buf, size_t nr_blocks, size_t block_size, size_t readahead,
+			struct mem_pool *pool);
+
+/* Drop all cached data, e.g. after the backing device was written behind the cache's back. */
+void cache_region_device_invalidate(struct cache_region_device *cdev);
+
 /* This type can be used for incoherent access where the read and write
  * operations are backed by separate drivers. An example is x86 systems
  * with memory mapped media for reading but use a spi flash driver for
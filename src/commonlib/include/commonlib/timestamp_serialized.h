@@ -19,6 +19,23 @@ struct timestamp_table {
 	struct timestamp_entry entries[]; /* Variable number of entries */
 } __packed;
 
+/*
+ * A full table in CBMEM can continue in another one. Its last entry then has this ID, and
+ * the physical address of the next table as stamp. All tables of a chain share base_time.
+ */
+#define TIMESTAMP_TABLE_CONTINUED	0xffffffff
+
+/*
+ * Timestamps that were recorded per CPU carry the CPU index plus one in the upper half of
+ * entry_id. The lower half is the timestamp_id.
+ */
+#define TIMESTAMP_CPU_SHIFT		16
+#define TIMESTAMP_ID_MASK		((1 << TIMESTAMP_CPU_SHIFT) - 1)
+#define TIMESTAMP_CPU_ID(id, cpu)	((id) | ((cpu) + 1) << TIMESTAMP_CPU_SHIFT)
+#define TIMESTAMP_ID(entry_id)		((entry_id) & TIMESTAMP_ID_MASK)
+/* Returns the CPU index plus one, or 0 for timestamps that weren't recorded per CPU. */
+#define TIMESTAMP_CPU(entry_id)		((entry_id) >> TIMESTAMP_CPU_SHIFT)
+
 enum timestamp_id {
 	TS_ROMSTAGE_START = 1,
 	TS_INITRAM_START = 2,
@@ -37,10 +54,13 @@ enum timestamp_id {
 	TS_ULZMA_END = 16,
 	TS_ULZ4F_START = 17,
 	TS_ULZ4F_END = 18,
+	TS_UZSTD_START = 19,
+	TS_UZSTD_END = 20,
 	TS_DEVICE_ENUMERATE = 30,
 	TS_DEVICE_CONFIGURE = 40,
 	TS_DEVICE_ENABLE = 50,
 	TS_DEVICE_INITIALIZE = 60,
+	TS_DEVICE_RESUME = 61,
 	TS_OPROM_INITIALIZE = 65,
 	TS_OPROM_COPY_END = 66,
 	TS_OPROM_END = 67,
@@ -59,6 +79,25 @@ enum timestamp_id {
 	TS_READ_UCODE_END = 113,
 	TS_ELOG_INIT_START = 114,
 	TS_ELOG_INIT_END = 115,
+	TS_BOOT_TASK_START = 116,
+	TS_BOOT_TASK_END = 117,
+	TS_DRAM_CLEAR_START = 118,
+	TS_DRAM_CLEAR_END = 119,
+	TS_DRAM_CLEAR_SOCKET0_END = 120,
+	TS_DRAM_CLEAR_SOCKET1_END = 121,
+	TS_DRAM_CLEAR_SOCKET2_END = 122,
+	TS_DRAM_CLEAR_SOCKET3_END = 123,
+	TS_DRAM_CLEAR_SOCKET4_END = 124,
+	TS_DRAM_CLEAR_SOCKET5_END = 125,
+	TS_DRAM_CLEAR_SOCKET6_END = 126,
+	TS_DRAM_CLEAR_SOCKET7_END = 127,
+	TS_MP_INIT_START = 128,
+	TS_MP_INIT_END = 129,
+	TS_AP_CHECKIN = 130,
+	TS_CPU_INIT_START = 131,
+	TS_CPU_INIT_END = 132,
+	TS_MICROCODE_UPDATE_START = 133,
+	TS_MICROCODE_UPDATE_END = 134,
 
 	/* 500+ reserved for vendorcode extensions (500-600: google/chromeos) */
 	TS_COPYVER_START = 501,
@@ -86,6 +125,8 @@ enum timestamp_id {
 	TS_TPM_ENABLE_UPDATE_END = 554,
 	TS_ESOL_START = 555,
 	TS_ESOL_END = 556,
+	TS_BOOTSPLASH_START = 557,
+	TS_BOOTSPLASH_END = 558,
 
 	/* 900-940 reserved for vendorcode extensions (900-940: AMD) */
 	TS_AGESA_INIT_RESET_START = 900,
@@ -142,6 +183,10 @@ enum timestamp_id {
 	TS_FSP_MULTI_PHASE_SI_INIT_END = 963,
 	TS_FSP_MULTI_PHASE_MEM_INIT_START = 964,
 	TS_FSP_MULTI_PHASE_MEM_INIT_END = 965,
+	TS_FSP_MULTI_PHASE_SI_INIT_CB_START = 966,
+	TS_FSP_MULTI_PHASE_SI_INIT_PHASE_START = 967,
+	TS_FSP_MULTI_PHASE_MEM_INIT_CB_START = 968,
+	TS_FSP_MULTI_PHASE_MEM_INIT_PHASE_START = 969,
 	TS_FSP_MEMORY_INIT_LOAD = 970,
 	TS_FSP_SILICON_INIT_LOAD = 971,
 
@@ -217,10 +262,13 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_ULZMA_END, 0, "finished LZMA decompress (ignore for x86)"),
 	TS_NAME_DEF(TS_ULZ4F_START, TS_ULZ4F_END, "starting LZ4 decompress (ignore for x86)"),
 	TS_NAME_DEF(TS_ULZ4F_END, 0, "finished LZ4 decompress (ignore for x86)"),
+	TS_NAME_DEF(TS_UZSTD_START, TS_UZSTD_END, "starting Zstandard decompress (ignore for x86)"),
+	TS_NAME_DEF(TS_UZSTD_END, 0, "finished Zstandard decompress (ignore for x86)"),
 	TS_NAME_DEF(TS_DEVICE_ENUMERATE, TS_DEVICE_CONFIGURE, "device enumeration"),
 	TS_NAME_DEF(TS_DEVICE_CONFIGURE, TS_DEVICE_ENABLE,  "device configuration"),
 	TS_NAME_DEF(TS_DEVICE_ENABLE, TS_DEVICE_INITIALIZE, "device enable"),
 	TS_NAME_DEF(TS_DEVICE_INITIALIZE, TS_DEVICE_DONE, "device initialization"),
+	TS_NAME_DEF(TS_DEVICE_RESUME, TS_DEVICE_DONE, "device resume"),
 	TS_NAME_DEF(TS_OPROM_INITIALIZE, TS_OPROM_END, "Option ROM initialization"),
 	TS_NAME_DEF(TS_OPROM_COPY_END, 0, "Option ROM copy done"),
 	TS_NAME_DEF(TS_OPROM_END, 0, "Option ROM run done"),
@@ -239,6 +287,26 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_READ_UCODE_END, 0, "finished reading uCode"),
 	TS_NAME_DEF(TS_ELOG_INIT_START, TS_ELOG_INIT_END, "started elog init"),
 	TS_NAME_DEF(TS_ELOG_INIT_END, 0, "finished elog init"),
+	TS_NAME_DEF(TS_BOOT_TASK_START, TS_BOOT_TASK_END, "started boot task"),
+	TS_NAME_DEF(TS_BOOT_TASK_END, 0, "finished boot task"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_START, TS_DRAM_CLEAR_END, "started clearing DRAM"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_END, 0, "finished clearing DRAM"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_SOCKET0_END, 0, "finished clearing DRAM on socket 0"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_SOCKET1_END, 0, "finished clearing DRAM on socket 1"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_SOCKET2_END, 0, "finished clearing DRAM on socket 2"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_SOCKET3_END, 0, "finished clearing DRAM on socket 3"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_SOCKET4_END, 0, "finished clearing DRAM on socket 4"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_SOCKET5_END, 0, "finished clearing DRAM on socket 5"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_SOCKET6_END, 0, "finished clearing DRAM on socket 6"),
+	TS_NAME_DEF(TS_DRAM_CLEAR_SOCKET7_END, 0, "finished clearing DRAM on socket 7"),
+	TS_NAME_DEF(TS_MP_INIT_START, TS_MP_INIT_END, "starting MP init"),
+	TS_NAME_DEF(TS_MP_INIT_END, 0, "finished MP init"),
+	TS_NAME_DEF(TS_AP_CHECKIN, 0, "AP checked in"),
+	TS_NAME_DEF(TS_CPU_INIT_START, TS_CPU_INIT_END, "starting CPU init"),
+	TS_NAME_DEF(TS_CPU_INIT_END, 0, "finished CPU init"),
+	TS_NAME_DEF(TS_MICROCODE_UPDATE_START, TS_MICROCODE_UPDATE_END,
+		    "starting microcode update"),
+	TS_NAME_DEF(TS_MICROCODE_UPDATE_END, 0, "finished microcode update"),
 
 	/* Google related timestamps */
 	TS_NAME_DEF(TS_COPYVER_START, TS_COPYVER_START, "starting to load verstage"),
@@ -270,6 +338,8 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_TPM_ENABLE_UPDATE_END, 0, "finished TPM enable update"),
 	TS_NAME_DEF(TS_ESOL_START, 0, "started early sign-off life (eSOL) notification"),
 	TS_NAME_DEF(TS_ESOL_END, 0, "finished early sign-off life (eSOL) notification"),
+	TS_NAME_DEF(TS_BOOTSPLASH_START, TS_BOOTSPLASH_END, "started decoding bootsplash"),
+	TS_NAME_DEF(TS_BOOTSPLASH_END, 0, "finished decoding bootsplash"),
 
 	/* AMD related timestamps */
 	TS_NAME_DEF(TS_AGESA_INIT_RESET_START, TS_AGESA_INIT_RESET_END, "calling AmdInitReset"),
@@ -329,6 +399,14 @@ static const struct timestamp_id_to_name {
 	TS_NAME_DEF(TS_FSP_MULTI_PHASE_MEM_INIT_START, TS_FSP_MULTI_PHASE_MEM_INIT_END,
 		    "calling FspMultiPhaseMemInit"),
 	TS_NAME_DEF(TS_FSP_MULTI_PHASE_MEM_INIT_END, 0, "returning from FspMultiPhaseMemInit"),
+	TS_NAME_DEF(TS_FSP_MULTI_PHASE_SI_INIT_CB_START, TS_FSP_MULTI_PHASE_SI_INIT_PHASE_START,
+		    "calling FspMultiPhaseSiInit phase callback"),
+	TS_NAME_DEF(TS_FSP_MULTI_PHASE_SI_INIT_PHASE_START, 0,
+		    "executing FspMultiPhaseSiInit phase"),
+	TS_NAME_DEF(TS_FSP_MULTI_PHASE_MEM_INIT_CB_START, TS_FSP_MULTI_PHASE_MEM_INIT_PHASE_START,
+		    "calling FspMultiPhaseMemInit phase callback"),
+	TS_NAME_DEF(TS_FSP_MULTI_PHASE_MEM_INIT_PHASE_START, 0,
+		    "executing FspMultiPhaseMemInit phase"),
 	TS_NAME_DEF(TS_FSP_ENUMERATE_START, TS_FSP_ENUMERATE_END,
 		    "calling FspNotify(AfterPciEnumeration)"),
 	TS_NAME_DEF(TS_FSP_ENUMERATE_END, 0, "returning from FspNotify(AfterPciEnumeration)"),
@@ -2,6 +2,69 @@
 
 #include <commonlib/helpers.h>
 #include <commonlib/mem_pool.h>
+#include <string.h>
+
+static void *free_list_alloc(struct mem_pool *mp, size_t sz)
+{
+	size_t i, prev_end = 0, best = mp->num_blocks, best_offset = 0;
+	size_t best_gap = SIZE_MAX;
+
+	if (mp->num_blocks >= mp->max_blocks)
+		return NULL;
+
+	/* Blocks need distinct offsets to be found again in free_list_free(). */
+	if (sz == 0)
+		sz = mp->alignment;
+
+	/* Find the smallest gap between (or after) the live blocks that fits. */
+	for (i = 0; i <= mp->num_blocks; i++) {
+		const size_t end = i < mp->num_blocks ? mp->blocks[i].offset : mp->size;
+		const size_t gap = end - prev_end;
+
+		if (gap >= sz && gap < best_gap) {
+			best = i;
+			best_offset = prev_end;
+			best_gap = gap;
+		}
+		if (i < mp->num_blocks)
+			prev_end = mp->blocks[i].offset + mp->blocks[i].size;
+	}
+
+	if (best_gap == SIZE_MAX)
+		return NULL;
+
+	memmove(&mp->blocks[best + 1], &mp->blocks[best],
+		(mp->num_blocks - best) * sizeof(mp->blocks[0]));
+	mp->blocks[best].offset = best_offset;
+	mp->blocks[best].size = sz;
+	mp->num_blocks++;
+
+	mp->free_offset = MAX(mp->free_offset, best_offset + sz);
+
+	return &mp->buf[best_offset];
+}
+
+static void free_list_free(struct mem_pool *mp, void *p)
+{
+	const uint8_t *u = p;
+	size_t i;
+
+	if (u < mp->buf || u >= mp->buf + mp->size)
+		return;
+
+	for (i = 0; i < mp->num_blocks; i++) {
+		if (&mp->buf[mp->blocks[i].offset] != u)
+			continue;
+
+		mp->num_blocks--;
+		memmove(&mp->blocks[i], &mp->blocks[i + 1],
+			(mp->num_blocks - i) * sizeof(mp->blocks[0]));
+		break;
+	}
+
+	mp->free_offset = mp->num_blocks ? mp->blocks[mp->num_blocks - 1].offset +
+					   mp->blocks[mp->num_blocks - 1].size : 0;
+}
 
 void *mem_pool_alloc(struct mem_pool *mp, size_t sz)
 {
@@ -13,6 +76,12 @@ void *mem_pool_alloc(struct mem_pool *mp, size_t sz)
 	/* We assume that mp->buf started mp->alignment aligned */
 	sz = ALIGN_UP(sz, mp->alignment);
 
+	if (mp->blocks) {
+		p = free_list_alloc(mp, sz);
+		mp->peak_offset = MAX(mp->peak_offset, mp->free_offset);
+		return p;
+	}
+
 	/* Determine if any space available. */
 	if ((mp->size - mp->free_offset) < sz)
 		return NULL;
@@ -20,6 +89,7 @@ void *mem_pool_alloc(struct mem_pool *mp, size_t sz)
 	p = &mp->buf[mp->free_offset];
 
 	mp->free_offset += sz;
+	mp->peak_offset = MAX(mp->peak_offset, mp->free_offset);
 	mp->second_to_last_alloc = mp->last_alloc;
 	mp->last_alloc = p;
 
@@ -28,6 +98,11 @@ void *mem_pool_alloc(struct mem_pool *mp, size_t sz)
 
 void mem_pool_free(struct mem_pool *mp, void *p)
 {
+	if (mp->blocks) {
+		free_list_free(mp, p);
+		return;
+	}
+
 	/* Determine if p was the most recent allocation. */
 	if (p == NULL || mp->last_alloc != p)
 		return;
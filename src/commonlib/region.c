@@ -536,3 +536,208 @@ const struct region_device *incoherent_rdev_init(struct incoherent_rdev *irdev,
 
 	return &irdev->rdev;
 }
+
+static struct cache_region_device *cache_rdev(const struct region_device *rd)
+{
+	return container_of((void *)rd, struct cache_region_device, mdev.rdev);
+}
+
+static uint8_t *cache_block_data(struct cache_region_device *cdev,
+				 const struct cache_rdev_block *blk)
+{
+	return &cdev->buf[(blk - cdev->blocks) * cdev->block_size];
+}
+
+static void cache_invalidate_range(struct cache_region_device *cdev, size_t offset,
+				   size_t size)
+{
+	struct cache_rdev_block *blk;
+
+	for (blk = cdev->blocks; blk < &cdev->blocks[cdev->nr_blocks]; blk++) {
+		if (blk->size && blk->offset < offset + size &&
+		    offset < blk->offset + blk->size) {
+			blk->size = 0;
+			blk->last_use = 0;
+		}
+	}
+}
+
+void cache_region_device_invalidate(struct cache_region_device *cdev)
+{
+	memset(cdev->blocks, 0, cdev->nr_blocks * sizeof(cdev->blocks[0]));
+	cdev->last_block = SIZE_MAX;
+}
+
+static struct cache_rdev_block *cache_lookup(struct cache_region_device *cdev, size_t base)
+{
+	struct cache_rdev_block *blk;
+
+	for (blk = cdev->blocks; blk < &cdev->blocks[cdev->nr_blocks]; blk++) {
+		if (blk->size && blk->offset == base)
+			return blk;
+	}
+
+	return NULL;
+}
+
+/* Pick the run of |count| slots whose most recent use is the oldest. */
+static struct cache_rdev_block *cache_pick_victims(struct cache_region_device *cdev,
+						   size_t count)
+{
+	struct cache_rdev_block *best = cdev->blocks;
+	uint32_t best_use = UINT32_MAX;
+	size_t i, j;
+
+	for (i = 0; i + count <= cdev->nr_blocks; i++) {
+		uint32_t run_use = 0;
+
+		for (j = i; j < i + count; j++)
+			run_use = MAX(run_use, cdev->blocks[j].last_use);
+
+		if (run_use < best_use) {
+			best_use = run_use;
+			best = &cdev->blocks[i];
+		}
+	}
+
+	return best;
+}
+
+static struct cache_rdev_block *cache_fill(struct cache_region_device *cdev, size_t base)
+{
+	const size_t bs = cdev->block_size;
+	const size_t end = region_device_sz(cdev->backing);
+	struct cache_rdev_block *blk;
+	size_t count = 1;
+	size_t read_size;
+	size_t i;
+
+	if (base >= end)
+		return NULL;
+
+	if (base == cdev->last_block + bs)
+		count += cdev->readahead;
+	count = MIN(count, DIV_ROUND_UP(end - base, bs));
+	read_size = MIN(count * bs, end - base);
+
+	/* Don't keep stale duplicates of blocks that are about to be read again. */
+	cache_invalidate_range(cdev, base, read_size);
+
+	blk = cache_pick_victims(cdev, count);
+	for (i = 0; i < count; i++)
+		blk[i].size = 0;
+
+	if (rdev_readat(cdev->backing, cache_block_data(cdev, blk), base,
+			read_size) != read_size)
+		return NULL;
+
+	for (i = 0; i < count; i++) {
+		blk[i].offset = base + i * bs;
+		blk[i].size = MIN(bs, read_size - i * bs);
+		blk[i].last_use = cdev->use_count;
+	}
+
+	return blk;
+}
+
+static ssize_t cache_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	struct cache_region_device *cdev = cache_rdev(rd);
+	const size_t bs = cdev->block_size;
+	uint8_t *dst = b;
+	size_t left = size;
+
+	if (size >= bs) {
+		cdev->last_block = ALIGN_DOWN(offset + size - 1, bs);
+		return rdev_readat(cdev->backing, b, offset, size);
+	}
+
+	while (left) {
+		const size_t base = ALIGN_DOWN(offset, bs);
+		struct cache_rdev_block *blk;
+		size_t len;
+
+		blk = cache_lookup(cdev, base);
+		if (!blk)
+			blk = cache_fill(cdev, base);
+		if (!blk || offset - base >= blk->size)
+			return -1;
+
+		blk->last_use = ++cdev->use_count;
+		cdev->last_block = base;
+
+		len = MIN(left, blk->size - (offset - base));
+		memcpy(dst, cache_block_data(cdev, blk) + (offset - base), len);
+		dst += len;
+		offset += len;
+		left -= len;
+	}
+
+	return size;
+}
+
+static ssize_t cache_writeat(const struct region_device *rd, const void *b, size_t offset,
+			     size_t size)
+{
+	struct cache_region_device *cdev = cache_rdev(rd);
+
+	cache_invalidate_range(cdev, offset, size);
+
+	return rdev_writeat(cdev->backing, b, offset, size);
+}
+
+static ssize_t cache_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	struct cache_region_device *cdev = cache_rdev(rd);
+
+	cache_invalidate_range(cdev, offset, size);
+
+	return rdev_eraseat(cdev->backing, offset, size);
+}
+
+static void *cache_mmap(const struct region_device *rd, size_t offset, size_t size)
+{
+	if (!cache_rdev(rd)->mdev.pool)
+		return NULL;
+
+	return mmap_helper_rdev_mmap(rd, offset, size);
+}
+
+static int cache_munmap(const struct region_device *rd, void *mapping)
+{
+	if (!cache_rdev(rd)->mdev.pool)
+		return -1;
+
+	return mmap_helper_rdev_munmap(rd, mapping);
+}
+
+static const struct region_device_ops cache_rdev_ops = {
+	.mmap = cache_mmap,
+	.munmap = cache_munmap,
+	.readat = cache_readat,
+	.writeat = cache_writeat,
+	.eraseat = cache_eraseat,
+};
+
+const struct region_device *cache_region_device_init(struct cache_region_device *cdev,
+			const struct region_device *backing, struct cache_rdev_block *blocks,
+			void *buf, size_t nr_blocks, size_t block_size, size_t readahead,
+			struct mem_pool *pool)
+{
+	if (!nr_blocks || !block_size || !IS_POWER_OF_2(block_size))
+		return NULL;
+
+	memset(cdev, 0, sizeof(*cdev));
+	cdev->backing = backing;
+	cdev->blocks = blocks;
+	cdev->buf = buf;
+	cdev->nr_blocks = nr_blocks;
+	cdev->block_size = block_size;
+	cdev->readahead = MIN(readahead, nr_blocks - 1);
+	cdev->mdev.pool = pool;
+	region_device_init(&cdev->mdev.rdev, &cache_rdev_ops, 0, region_device_sz(backing));
+	cache_region_device_invalidate(cdev);
+
+	return &cdev->mdev.rdev;
+}
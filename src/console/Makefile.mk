@@ -4,6 +4,14 @@ ramstage-y += vtxprintf.c printk.c vsprintf.c
 ramstage-y += init.c console.c
 ramstage-y += post.c
 ramstage-y += die.c
+ramstage-$(CONFIG_CONSOLE_AP_RINGS) += ap_console.c
+ramstage-$(CONFIG_CONSOLE_SERIAL_DEFERRED) += uart_deferred.c
+
+bootblock-$(CONFIG_CONSOLE_SERIAL_TX_RING) += uart_ring.c
+verstage-$(CONFIG_CONSOLE_SERIAL_TX_RING) += uart_ring.c
+romstage-$(CONFIG_CONSOLE_SERIAL_TX_RING) += uart_ring.c
+postcar-$(CONFIG_CONSOLE_SERIAL_TX_RING) += uart_ring.c
+ramstage-$(CONFIG_CONSOLE_SERIAL_TX_RING) += uart_ring.c
 ifeq ($(CONFIG_HWBASE_DEBUG_CB),y)
 ramstage-$(CONFIG_RAMSTAGE_LIBHWBASE) += hw-debug_sink.ads
 ramstage-$(CONFIG_RAMSTAGE_LIBHWBASE) += hw-debug_sink.adb
@@ -42,3 +50,31 @@ bootblock-y += post.c
 bootblock-y += die.c
 
 decompressor-y += die.c
+
+ifeq ($(CONFIG_CONSOLE_CBMEM_BINARY_LOG),y)
+bootblock-$(CONFIG_BOOTBLOCK_CONSOLE) += binlog.c
+verstage-y += binlog.c
+romstage-$(CONFIG_SEPARATE_ROMSTAGE) += binlog.c
+postcar-$(CONFIG_POSTCAR_CONSOLE) += binlog.c
+ramstage-y += binlog.c
+
+# $1: stage, $2: BINLOG_STAGE_* value
+define binlog_add_strings
+	if [ -f $(objcbfs)/$(1).debug ]; then \
+		$(OBJCOPY_$(1)) -O binary -j .text $(objcbfs)/$(1).debug $(obj)/$(1).strings && \
+		printf "CBSTRTAB %u %u\n" $(2) $$(wc -c < $(obj)/$(1).strings) \
+			>> $(obj)/console_strings.bin && \
+		cat $(obj)/$(1).strings >> $(obj)/console_strings.bin; \
+	fi
+endef
+
+# util/cbmem needs this to decode the binary records, see commonlib/console_binlog.h.
+build_complete::
+	@printf "    BINLOG     console_strings.bin\n"
+	rm -f $(obj)/console_strings.bin
+	$(call binlog_add_strings,bootblock,1)
+	$(call binlog_add_strings,verstage,2)
+	$(call binlog_add_strings,romstage,3)
+	$(call binlog_add_strings,postcar,4)
+	$(call binlog_add_strings,ramstage,5)
+endif
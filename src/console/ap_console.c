@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <bootstate.h>
+#include <cbmem.h>
+#include <console/ap_console.h>
+#include <console/console.h>
+#include <cpu/x86/mp.h>
+#include <smp/node.h>
+#include <string.h>
+#include <timestamp.h>
+#include <types.h>
+
+#define AP_CONSOLE_LINE_MAX	160
+
+struct ap_console_record {
+	uint64_t time;
+	uint16_t len;
+	uint8_t level;
+	uint8_t reserved[5];
+};
+
+/*
+ * Single producer (the AP owning the ring), single consumer (the BSP). |head|
+ * is only written by the AP and |tail| only by the BSP. Both are free running
+ * and the data between them is published/released by updating the index
+ * after the payload has been copied.
+ */
+struct ap_console_ring {
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	uint32_t dropped;
+	/* Only used by the BSP. */
+	uint32_t dropped_reported;
+	uint32_t line_open;
+	uint8_t data[CONFIG_CONSOLE_AP_RING_SIZE];
+};
+
+static struct ap_console_ring *rings;
+static int num_rings;
+
+void ap_console_init(int num_cpus)
+{
+	const size_t size = num_cpus * sizeof(*rings);
+
+	if (num_cpus <= 1 || rings)
+		return;
+
+	rings = cbmem_add(CBMEM_ID_AP_CONSOLE, size);
+	if (!rings) {
+		printk(BIOS_ERR, "AP console: Cannot allocate %zu bytes in CBMEM\n", size);
+		return;
+	}
+	memset(rings, 0, size);
+	num_rings = num_cpus;
+}
+
+static void ring_write(struct ap_console_ring *ring, uint32_t pos, const void *src, size_t len)
+{
+	const size_t off = pos % sizeof(ring->data);
+	const size_t first = MIN(len, sizeof(ring->data) - off);
+
+	memcpy(&ring->data[off], src, first);
+	memcpy(&ring->data[0], (const uint8_t *)src + first, len - first);
+}
+
+static void ring_read(const struct ap_console_ring *ring, uint32_t pos, void *dst, size_t len)
+{
+	const size_t off = pos % sizeof(ring->data);
+	const size_t first = MIN(len, sizeof(ring->data) - off);
+
+	memcpy(dst, &ring->data[off], first);
+	memcpy((uint8_t *)dst + first, &ring->data[0], len - first);
+}
+
+/*
+ * %gs only points to the per-CPU data once set_cpu_info() ran on this CPU. Before
+ * that it holds the null selector, and APs have to take the regular path.
+ */
+static struct ap_console_ring *current_ring(void)
+{
+	uint16_t gs;
+	size_t index;
+
+	if (!rings)
+		return NULL;
+
+	asm volatile ("mov %%gs, %0" : "=r" (gs));
+	if (!gs)
+		return NULL;
+
+	index = cpu_index();
+	if (index == 0 || index >= num_rings)
+		return NULL;
+
+	return &rings[index];
+}
+
+int ap_console_vprintk(int msg_level, const char *fmt, va_list args)
+{
+	struct ap_console_ring *ring = current_ring();
+	struct ap_console_record rec = { 0 };
+	char line[AP_CONSOLE_LINE_MAX];
+	uint32_t head, used;
+	int len;
+
+	if (!ring)
+		return -1;
+
+	len = vsnprintf(line, sizeof(line), fmt, args);
+	if (len <= 0)
+		return len;
+
+	rec.time = timestamp_get();
+	rec.len = MIN(len, sizeof(line) - 1);
+	rec.level = msg_level;
+
+	head = ring->head;
+	used = head - ring->tail;
+	if (used + sizeof(rec) + rec.len > sizeof(ring->data)) {
+		ring->dropped++;
+		return len;
+	}
+
+	ring_write(ring, head, &rec, sizeof(rec));
+	ring_write(ring, head + sizeof(rec), line, rec.len);
+	/* Publish the record only after its contents are in place. */
+	mfence();
+	ring->head = head + sizeof(rec) + rec.len;
+
+	return len;
+}
+
+void ap_console_flush(void)
+{
+	struct ap_console_record rec, oldest = { 0 };
+	struct ap_console_ring *ring;
+	char line[AP_CONSOLE_LINE_MAX];
+	int i, cpu;
+
+	if (!rings || !boot_cpu())
+		return;
+
+	while (1) {
+		/* Pick the oldest pending record across all rings. */
+		cpu = -1;
+		for (i = 1; i < num_rings; i++) {
+			ring = &rings[i];
+			if (ring->tail == ring->head)
+				continue;
+			mfence();
+			ring_read(ring, ring->tail, &rec, sizeof(rec));
+			if (cpu < 0 || rec.time < oldest.time) {
+				oldest = rec;
+				cpu = i;
+			}
+		}
+
+		if (cpu < 0)
+			break;
+
+		ring = &rings[cpu];
+		ring_read(ring, ring->tail + sizeof(oldest), line, oldest.len);
+		mfence();
+		ring->tail += sizeof(oldest) + oldest.len;
+
+		if (ring->line_open)
+			printk(oldest.level, "%.*s", oldest.len, line);
+		else
+			printk(oldest.level, "AP%d: %.*s", cpu, oldest.len, line);
+		ring->line_open = line[oldest.len - 1] != '\n';
+	}
+
+	for (i = 1; i < num_rings; i++) {
+		const uint32_t dropped = rings[i].dropped;
+
+		if (dropped == rings[i].dropped_reported)
+			continue;
+		printk(BIOS_WARNING, "AP%d: %u console messages dropped\n", i,
+		       dropped - rings[i].dropped_reported);
+		rings[i].dropped_reported = dropped;
+	}
+}
+
+static void ap_console_flush_bs(void *unused)
+{
+	ap_console_flush();
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_INIT, BS_ON_EXIT, ap_console_flush_bs, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, ap_console_flush_bs, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, ap_console_flush_bs, NULL);
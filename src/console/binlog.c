@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/console_binlog.h>
+#include <console/cbmem_console.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <string.h>
+#include <types.h>
+
+/* Both from program.ld, the stage's code and read-only data. */
+extern const char _text[], _etext[];
+
+/* Messages that don't fit are printed as text. */
+#define BINLOG_ARGS_SIZE	192
+
+struct binlog_args {
+	u8 data[BINLOG_ARGS_SIZE];
+	size_t size;
+};
+
+static bool put_byte(struct binlog_args *a, u8 byte)
+{
+	if (a->size >= sizeof(a->data))
+		return false;
+	a->data[a->size++] = byte;
+	return true;
+}
+
+static bool put_num(struct binlog_args *a, unsigned long long num)
+{
+	do {
+		u8 byte = num & 0x7f;
+
+		num >>= 7;
+		if (num)
+			byte |= 0x80;
+		if (!put_byte(a, byte))
+			return false;
+	} while (num);
+
+	return true;
+}
+
+static bool put_str(struct binlog_args *a, const char *s, size_t len)
+{
+	if (!put_num(a, len) || len > sizeof(a->data) - a->size)
+		return false;
+	memcpy(&a->data[a->size], s, len);
+	a->size += len;
+	return true;
+}
+
+/* Takes the arguments exactly like vtxprintf(), returns false for what it can't store. */
+static bool put_args(struct binlog_args *a, const char *fmt, va_list args)
+{
+	unsigned long long num;
+	int precision, qualifier;
+	bool sign;
+	const char *s;
+
+	for (; *fmt; ++fmt) {
+		if (*fmt != '%')
+			continue;
+
+		++fmt;
+		while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0')
+			++fmt;
+
+		if (isdigit(*fmt)) {
+			skip_atoi((char **)&fmt);
+		} else if (*fmt == '*') {
+			++fmt;
+			if (!put_num(a, va_arg(args, int)))
+				return false;
+		}
+
+		precision = -1;
+		if (*fmt == '.') {
+			++fmt;
+			if (isdigit(*fmt)) {
+				precision = skip_atoi((char **)&fmt);
+			} else if (*fmt == '*') {
+				++fmt;
+				precision = va_arg(args, int);
+				if (!put_num(a, precision))
+					return false;
+			}
+			if (precision < 0)
+				precision = 0;
+		}
+
+		qualifier = -1;
+		if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L' || *fmt == 'z' || *fmt == 'j') {
+			qualifier = *fmt;
+			++fmt;
+			if (*fmt == 'l') {
+				qualifier = 'L';
+				++fmt;
+			}
+			if (*fmt == 'h') {
+				qualifier = 'H';
+				++fmt;
+			}
+		}
+
+		sign = false;
+		switch (*fmt) {
+		case 'c':
+			if (!put_num(a, (unsigned char)va_arg(args, int)))
+				return false;
+			continue;
+		case 's':
+			s = va_arg(args, char *);
+			if (!s)
+				s = "<NULL>";
+			if (!put_str(a, s, strnlen(s, (size_t)precision)))
+				return false;
+			continue;
+		case 'p':
+			if (!put_num(a, (unsigned long)va_arg(args, void *)))
+				return false;
+			continue;
+		case 'n':
+			return false;
+		case 'd':
+		case 'i':
+			sign = true;
+			break;
+		case 'o':
+		case 'x':
+		case 'X':
+		case 'u':
+			break;
+		case '\0':
+			return true;
+		default:
+			continue;
+		}
+
+		if (qualifier == 'L') {
+			num = va_arg(args, unsigned long long);
+		} else if (qualifier == 'l') {
+			num = va_arg(args, unsigned long);
+		} else if (qualifier == 'z') {
+			num = va_arg(args, size_t);
+		} else if (qualifier == 'j') {
+			num = va_arg(args, uintmax_t);
+		} else if (qualifier == 'h') {
+			num = (unsigned short)va_arg(args, int);
+			if (sign)
+				num = (short)num;
+		} else if (qualifier == 'H') {
+			num = (unsigned char)va_arg(args, int);
+			if (sign)
+				num = (signed char)num;
+		} else if (sign) {
+			num = va_arg(args, int);
+		} else {
+			num = va_arg(args, unsigned int);
+		}
+		if (!put_num(a, num))
+			return false;
+	}
+
+	return true;
+}
+
+static u8 binlog_stage(void)
+{
+	if (ENV_BOOTBLOCK)
+		return BINLOG_STAGE_BOOTBLOCK;
+	if (ENV_SEPARATE_VERSTAGE)
+		return BINLOG_STAGE_VERSTAGE;
+	if (ENV_SEPARATE_ROMSTAGE)
+		return BINLOG_STAGE_ROMSTAGE;
+	if (ENV_POSTCAR)
+		return BINLOG_STAGE_POSTCAR;
+	if (ENV_RAMSTAGE)
+		return BINLOG_STAGE_RAMSTAGE;
+	return 0;
+}
+
+int cbmemc_binlog_vprintk(int msg_level, const char *fmt, va_list args)
+{
+	struct binlog_args a = { .size = 0 };
+	const size_t len = strlen(fmt);
+	u8 header[BINLOG_RECORD_HEADER_SIZE];
+	u32 offset;
+	size_t i;
+
+	/* Only whole lines, so every record starts a line when it is decoded. */
+	if (!binlog_stage() || fmt < _text || fmt + len >= _etext || !len || fmt[len - 1] != '\n')
+		return -1;
+
+	if (!put_args(&a, fmt, args))
+		return -1;
+
+	offset = fmt - _text;
+	header[0] = BINLOG_MARKER;
+	header[1] = msg_level;
+	header[2] = binlog_stage();
+	header[3] = offset;
+	header[4] = offset >> 8;
+	header[5] = offset >> 16;
+	header[6] = offset >> 24;
+	header[7] = a.size;
+	header[8] = a.size >> 8;
+
+	for (i = 0; i < sizeof(header); i++)
+		__cbmemc_tx_byte(header[i]);
+	for (i = 0; i < a.size; i++)
+		__cbmemc_tx_byte(a.data[i]);
+
+	return sizeof(header) + a.size;
+}
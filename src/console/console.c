@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <console/cbmem_console.h>
+#include <console/console.h>
+#include <console/espi.h>
 #include <console/flash.h>
 #include <console/i2c_smbus.h>
 #include <console/ne2k.h>
@@ -12,6 +14,7 @@
 #include <console/system76_ec.h>
 #include <console/uart.h>
 #include <console/usb.h>
+#include <console/xhci_dbc.h>
 #include <types.h>
 
 /* Note: when adding a new console, make sure you update the definition of
@@ -25,9 +28,11 @@ void console_hw_init(void)
 	__uart_init();
 	__ne2k_init();
 	__usbdebug_init();
+	__xhci_dbc_init();
 	__spiconsole_init();
 	__flashconsole_init();
 	__system76_ec_init();
+	__espi_console_init();
 	__i2c_smbus_console_init();
 	__simnow_console_init();
 }
@@ -38,6 +43,7 @@ void console_interactive_tx_byte(unsigned char byte, void *data_unused)
 		/* Some consoles want newline conversion to keep terminals happy. */
 		__uart_tx_byte('\r');
 		__usb_tx_byte('\r');
+		__xhci_dbc_tx_byte('\r');
 		__i2c_smbus_console_tx_byte('\r');
 	}
 
@@ -46,8 +52,10 @@ void console_interactive_tx_byte(unsigned char byte, void *data_unused)
 	__uart_tx_byte(byte);
 	__ne2k_tx_byte(byte);
 	__usb_tx_byte(byte);
+	__xhci_dbc_tx_byte(byte);
 	__spiconsole_tx_byte(byte);
 	__system76_ec_tx_byte(byte);
+	__espi_console_tx_byte(byte);
 	__i2c_smbus_console_tx_byte(byte);
 	__simnow_console_tx_byte(byte);
 }
@@ -69,8 +77,17 @@ void console_tx_flush(void)
 	__uart_tx_flush();
 	__ne2k_tx_flush();
 	__usb_tx_flush();
+	__xhci_dbc_tx_flush();
 	__flashconsole_tx_flush();
 	__system76_ec_tx_flush();
+	__espi_console_tx_flush();
+}
+
+void console_sync(void)
+{
+	__uart_sync();
+	__xhci_dbc_sync();
+	__flashconsole_sync();
 }
 
 void console_write_line(uint8_t *buffer, size_t number_of_bytes)
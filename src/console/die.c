@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <console/console.h>
+#include <console/uart.h>
 #include <halt.h>
 #include <stdarg.h>
 
@@ -23,6 +24,10 @@ void __noreturn die(const char *fmt, ...)
 	vprintk(BIOS_EMERG, fmt, args);
 	va_end(args);
 
+	/* Don't leave anything in the CBMEM console that the UART hasn't seen yet. */
+	uart_console_drain_all();
+	console_sync();
+
 	die_notify();
 	halt();
 }
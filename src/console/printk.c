@@ -4,6 +4,7 @@
  * blatantly copied from linux/kernel/printk.c
  */
 
+#include <console/ap_console.h>
 #include <console/cbmem_console.h>
 #include <console/console.h>
 #include <console/streams.h>
@@ -107,10 +108,11 @@ static void line_end(union log_state state)
 		wrap_interactive_printf(BIOS_LOG_ESCAPE_RESET);
 }
 
+static bool line_started;
+
 static void wrap_putchar(unsigned char byte, void *data)
 {
 	union log_state state = { .as_ptr = data };
-	static bool line_started = false;
 
 	if (byte == '\n') {
 		line_end(state);
@@ -138,11 +140,27 @@ int vprintk(int msg_level, const char *fmt, va_list args)
 	if (state.speed < CONSOLE_LOG_FAST)
 		return 0;
 
+	if (__AP_CONSOLE_ENABLE__ && !boot_cpu()) {
+		i = ap_console_vprintk(msg_level, fmt, args);
+		if (i >= 0)
+			return i;
+	}
+
 	spin_lock(&console_lock);
 
 	console_time_run();
 
-	i = vtxprintf(wrap_putchar, fmt, args, state.as_ptr);
+	i = -1;
+	if (CONFIG(CONSOLE_CBMEM_BINARY_LOG) && LOG_FAST(state) && !line_started) {
+		va_list copy;
+
+		va_copy(copy, args);
+		i = cbmemc_binlog_vprintk(msg_level, fmt, copy);
+		va_end(copy);
+	}
+
+	if (i < 0)
+		i = vtxprintf(wrap_putchar, fmt, args, state.as_ptr);
 	if (LOG_FAST(state))
 		console_tx_flush();
 
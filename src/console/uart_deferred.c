@@ -0,0 +1,153 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <console/cbmem_console.h>
+#include <console/console.h>
+#include <console/uart.h>
+#include <stdio.h>
+#include <thread.h>
+#include <timer.h>
+#include <types.h>
+
+/* One 16550 FIFO worth of data per wakeup of the drain thread. */
+#define DRAIN_CHUNK	16
+
+static bool stopped;
+static bool stopping;
+static bool thread_started;
+static struct thread_handle drain_thread;
+
+/* Whether the line currently being drained is at the UART log level. */
+static bool line_visible = true;
+
+bool uart_console_deferred(void)
+{
+	return !stopped && cbmemc_drain_enabled();
+}
+
+static void drain_tx(unsigned char byte)
+{
+	const unsigned int idx = get_uart_for_console();
+
+	if (byte == '\n')
+		uart_tx_byte(idx, '\r');
+	uart_tx_byte(idx, byte);
+}
+
+static void drain_tx_string(const char *str)
+{
+	while (*str)
+		drain_tx(*str++);
+}
+
+/* Turn the CBMEM console format back into what printk() would have sent. */
+static void drain_byte(unsigned char byte)
+{
+	char prefix[16];
+	int level;
+
+	if (BIOS_LOG_IS_MARKER(byte)) {
+		level = BIOS_LOG_MARKER_TO_LEVEL(byte);
+		line_visible = console_log_level(level) == CONSOLE_LOG_ALL;
+		if (!line_visible)
+			return;
+
+		if (CONFIG(CONSOLE_USE_ANSI_ESCAPES)) {
+			snprintf(prefix, sizeof(prefix), BIOS_LOG_ESCAPE_PATTERN,
+				 bios_log_escape[level]);
+			drain_tx_string(prefix);
+		}
+		if (CONFIG(CONSOLE_USE_LOGLEVEL_PREFIX)) {
+			snprintf(prefix, sizeof(prefix), BIOS_LOG_PREFIX_PATTERN,
+				 bios_log_prefix[level]);
+			drain_tx_string(prefix);
+		}
+		return;
+	}
+
+	if (!line_visible)
+		return;
+
+	if (byte == '\n' && CONFIG(CONSOLE_USE_ANSI_ESCAPES))
+		drain_tx_string(BIOS_LOG_ESCAPE_RESET);
+	drain_tx(byte);
+}
+
+static size_t drain(size_t max)
+{
+	u8 buf[DRAIN_CHUNK];
+	char msg[48];
+	size_t i, len, total = 0;
+	u32 lost;
+
+	while (total < max) {
+		len = cbmemc_drain(buf, MIN(sizeof(buf), max - total), &lost);
+		if (!len)
+			break;
+
+		if (lost) {
+			snprintf(msg, sizeof(msg), "\n*** %u console bytes lost ***\n", lost);
+			drain_tx_string(msg);
+		}
+
+		for (i = 0; i < len; i++)
+			drain_byte(buf[i]);
+		total += len;
+	}
+
+	return total;
+}
+
+void uart_console_drain_all(void)
+{
+	if (!uart_console_deferred())
+		return;
+
+	drain(SIZE_MAX);
+	uart_tx_flush(get_uart_for_console());
+}
+
+static enum cb_err drain_thread_main(void *unused)
+{
+	/* Time it takes to shift out one chunk, at 10 bits per byte. */
+	const unsigned int chunk_usecs = DIV_ROUND_UP(DRAIN_CHUNK * 10 * USECS_PER_SEC,
+						      get_uart_baudrate());
+
+	while (!stopping) {
+		drain(DRAIN_CHUNK);
+		thread_yield_microseconds(chunk_usecs);
+	}
+
+	return CB_SUCCESS;
+}
+
+static void drain_start(void *unused)
+{
+	if (!uart_console_deferred())
+		return;
+
+	if (thread_run(&drain_thread, drain_thread_main, NULL) < 0) {
+		printk(BIOS_WARNING, "Cannot start UART drain thread, using direct output\n");
+		uart_console_drain_all();
+		stopped = true;
+		return;
+	}
+	thread_started = true;
+}
+
+static void drain_stop(void *unused)
+{
+	if (thread_started) {
+		stopping = true;
+		thread_join(&drain_thread);
+		thread_started = false;
+	}
+
+	/* Write out the rest and go back to direct output for the handoff. */
+	uart_console_drain_all();
+	stopped = true;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, drain_start, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, drain_stop, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, drain_stop, NULL);
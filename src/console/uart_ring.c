@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/uart.h>
+#include <types.h>
+
+/*
+ * Serial output that didn't fit into the UART's TX FIFO yet. It goes out while later
+ * output is written and whenever printk() finishes a message, so printk() only has to
+ * wait for the UART when the ring is full.
+ */
+#define TX_RING_SIZE	1024
+
+static u8 ring[TX_RING_SIZE];
+static size_t head, count;
+
+static size_t ring_tail(void)
+{
+	return (head + TX_RING_SIZE - count) % TX_RING_SIZE;
+}
+
+void uart_ring_poll(void)
+{
+	const unsigned int idx = get_uart_for_console();
+	size_t tail = ring_tail();
+
+	while (count && uart_try_tx_byte(idx, ring[tail])) {
+		tail = (tail + 1) % TX_RING_SIZE;
+		count--;
+	}
+}
+
+void uart_ring_tx_byte(unsigned char data)
+{
+	const unsigned int idx = get_uart_for_console();
+
+	uart_ring_poll();
+	if (!count && uart_try_tx_byte(idx, data))
+		return;
+
+	if (count == TX_RING_SIZE) {
+		uart_tx_byte(idx, ring[ring_tail()]);
+		count--;
+	}
+
+	ring[head] = data;
+	head = (head + 1) % TX_RING_SIZE;
+	count++;
+}
+
+void uart_ring_sync(void)
+{
+	const unsigned int idx = get_uart_for_console();
+
+	while (count) {
+		uart_tx_byte(idx, ring[ring_tail()]);
+		count--;
+	}
+	uart_tx_flush(idx);
+}
@@ -7,11 +7,46 @@
 #include <cpu/cpu.h>
 #include <cpu/intel/microcode.h>
 #include <cpu/x86/msr.h>
+#include <cpu/x86/mp_timestamp.h>
 #include <smp/spinlock.h>
 #include <stdio.h>
 #include <types.h>
 
-DECLARE_SPIN_LOCK(microcode_lock)
+DECLARE_SPIN_LOCK(microcode_find_lock)
+
+/* Number of different processor signatures and platform IDs a system can be made of */
+#define MICROCODE_CACHE_ENTRIES	4
+
+/*
+ * The threads of a core share its microcode and must not update it at the same
+ * time. Different cores can update in parallel, so each core takes one of these
+ * locks. Cores that end up on the same lock update one after the other.
+ */
+#define MICROCODE_CORE_LOCKS	64
+
+#if ENV_SUPPORTS_SMP
+static spinlock_t microcode_locks[MICROCODE_CORE_LOCKS] = {
+	[0 ... MICROCODE_CORE_LOCKS - 1] = SPIN_LOCK_UNLOCKED
+};
+
+static spinlock_t *microcode_core_lock(void)
+{
+	struct cpuid_result res;
+	unsigned int thread_bits;
+
+	/* Without leaf 0xb there's no telling threads apart, update one CPU at a time. */
+	if (cpuid_get_max_func() < 0xb)
+		return &microcode_locks[0];
+
+	/* Sub-leaf 0 is the SMT level, edx holds the x2APIC ID. */
+	res = cpuid_ext(0xb, 0);
+	if (((res.ecx >> 8) & 0xff) != 1)
+		return &microcode_locks[0];
+	thread_bits = res.eax & 0x1f;
+
+	return &microcode_locks[(res.edx >> thread_bits) % MICROCODE_CORE_LOCKS];
+}
+#endif
 
 struct microcode {
 	u32 hdrver;	/* Header Version */
@@ -161,29 +196,33 @@ static struct ext_sig_table *ucode_get_ext_sig_table(const struct microcode *uco
 	return ext_tbl;
 }
 
-static const void *find_cbfs_microcode(void)
+/* Get the processor signature and platform ID the patch of this CPU has to match. */
+static void get_microcode_sig_pf(u32 *sig, u32 *pf)
 {
-	const struct microcode *ucode_updates;
-	struct ext_sig_table *ext_tbl;
-	size_t microcode_len;
 	u32 eax;
-	u32 pf, rev, sig, update_size;
 	msr_t msr;
 	struct cpuinfo_x86 c;
 
-	rev = read_microcode_rev();
 	eax = cpuid_eax(1);
 	get_fms(&c, eax);
-	sig = eax;
+	*sig = eax;
 
-	pf = 0;
+	*pf = 0;
 	if ((c.x86_model >= 5) || (c.x86 > 6)) {
 		msr = rdmsr(IA32_PLATFORM_ID);
-		pf = 1 << ((msr.hi >> 18) & 7);
+		*pf = 1 << ((msr.hi >> 18) & 7);
 	}
+}
+
+static const void *find_cbfs_microcode(u32 sig, u32 pf)
+{
+	const struct microcode *ucode_updates;
+	struct ext_sig_table *ext_tbl;
+	size_t microcode_len;
+	u32 update_size;
 
 	printk(BIOS_DEBUG, "microcode: sig=0x%x pf=0x%x revision=0x%x\n",
-			sig, pf, rev);
+			sig, pf, read_microcode_rev());
 
 	if (CONFIG(CPU_INTEL_MICROCODE_CBFS_SPLIT_BINS)) {
 		char cbfs_filename[25];
@@ -238,8 +277,15 @@ static const void *find_cbfs_microcode(void)
 
 const void *intel_microcode_find(void)
 {
-	static bool microcode_checked;
-	static const void *ucode_update;
+	static struct {
+		u32 sig;
+		u32 pf;
+		const void *patch;
+	} cache[MICROCODE_CACHE_ENTRIES];
+	static size_t cache_entries;
+	const void *ucode_update = NULL;
+	u32 sig, pf;
+	size_t i;
 
 	if (ENV_CACHE_AS_RAM) {
 		printk(BIOS_ERR, "Microcode Error: Early microcode patching is not supported due"
@@ -247,16 +293,33 @@ const void *intel_microcode_find(void)
 		return NULL;
 	}
 
-	if (microcode_checked)
-		return ucode_update;
+	get_microcode_sig_pf(&sig, &pf);
 
 	/*
-	 * Since this function caches the found microcode (NULL or a valid
-	 * microcode pointer), it is expected to be run from BSP before starting
-	 * any other APs. This sequence is not multithread safe otherwise.
+	 * The BSP usually looks its patch up before the APs start, and CPUs of the
+	 * same kind find it (NULL or a valid microcode pointer) in the cache. Only
+	 * CPUs of another kind walk the microcode file again.
 	 */
-	ucode_update = find_cbfs_microcode();
-	microcode_checked = true;
+	spin_lock(&microcode_find_lock);
+
+	for (i = 0; i < cache_entries; i++) {
+		if (cache[i].sig == sig && cache[i].pf == pf) {
+			ucode_update = cache[i].patch;
+			break;
+		}
+	}
+
+	if (i == cache_entries) {
+		ucode_update = find_cbfs_microcode(sig, pf);
+		if (cache_entries < ARRAY_SIZE(cache)) {
+			cache[cache_entries].sig = sig;
+			cache[cache_entries].pf = pf;
+			cache[cache_entries].patch = ucode_update;
+			cache_entries++;
+		}
+	}
+
+	spin_unlock(&microcode_find_lock);
 
 	return ucode_update;
 }
@@ -265,11 +328,13 @@ void intel_update_microcode_from_cbfs(void)
 {
 	const void *patch = intel_microcode_find();
 
-	spin_lock(&microcode_lock);
+	spin_lock(microcode_core_lock());
+	mp_timestamp_add_now(TS_MICROCODE_UPDATE_START);
 
 	intel_microcode_load_unlocked(patch);
 
-	spin_unlock(&microcode_lock);
+	mp_timestamp_add_now(TS_MICROCODE_UPDATE_END);
+	spin_unlock(microcode_core_lock());
 }
 
 void intel_reload_microcode(void)
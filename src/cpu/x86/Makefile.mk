@@ -25,6 +25,9 @@ endif
 
 $(call src-to-obj,ramstage,$(dir)/mp_init.c): $(obj)/ramstage/cpu/x86/smm_start32_offset.h
 ramstage-$(CONFIG_PARALLEL_MP) += mp_init.c
+ramstage-$(CONFIG_MP_JOBS) += mp_jobs.c
+ramstage-$(CONFIG_MP_MEMTEST) += mp_memtest.c
+ramstage-$(CONFIG_MP_TIMESTAMPS) += mp_timestamp.c
 
 ramstage-y += backup_default_smm.c
 ramstage-y += smi_trigger.c
@@ -1,6 +1,11 @@
 ## SPDX-License-Identifier: GPL-2.0-only
 
 ramstage-$(CONFIG_AP_IN_SIPI_WAIT) += lapic_cpu_stop.c
+ramstage-$(CONFIG_RAMSTAGE_PROFILER) += profiler.c
+
+ifeq ($(CONFIG_RAMSTAGE_PROFILER),y)
+ramstage-generic-ccopts += -fno-omit-frame-pointer
+endif
 
 bootblock-$(CONFIG_UDELAY_LAPIC) += apic_timer.c
 romstage-$(CONFIG_UDELAY_LAPIC) += apic_timer.c
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <cbmem.h>
+#include <commonlib/profile_serialized.h>
+#include <console/console.h>
+#include <cpu/x86/lapic.h>
+#include <cpu/x86/profiler.h>
+#include <delay.h>
+#include <string.h>
+#include <symbols.h>
+#include <timer.h>
+#include <types.h>
+
+static struct profile_table *table;
+static int suspend_depth;
+static struct profile_sample suspended_sample;
+static struct stopwatch suspended_time;
+
+static inline void profiler_irq_enable(void)
+{
+	asm volatile ("sti" ::: "memory");
+}
+
+static inline void profiler_irq_disable(void)
+{
+	asm volatile ("cli" ::: "memory");
+}
+
+/*
+ * Follow the frame pointer chain (ramstage is built with -fno-omit-frame-pointer when the
+ * profiler is enabled). Only frames that lie above |sp| within one stack size are trusted,
+ * so a clobbered frame pointer in assembly code or a blob can't send us off into MMIO.
+ */
+static void walk_frames(struct profile_sample *sample, uintptr_t frame, uintptr_t sp)
+{
+	while (sample->depth < PROFILE_MAX_DEPTH) {
+		const uintptr_t *fp = (const uintptr_t *)frame;
+
+		if (frame <= sp || frame - sp > CONFIG_STACK_SIZE ||
+		    !IS_ALIGNED(frame, sizeof(uintptr_t)) || !fp[1])
+			break;
+
+		sample->pc[sample->depth++] = fp[1];
+		sp = frame;
+		frame = fp[0];
+	}
+}
+
+static struct profile_sample *next_sample(void)
+{
+	if (table->num_entries >= table->max_entries) {
+		table->dropped++;
+		return NULL;
+	}
+
+	return &table->samples[table->num_entries++];
+}
+
+void profiler_sample(struct eregs *info)
+{
+	struct profile_sample *sample = table ? next_sample() : NULL;
+
+	if (sample) {
+		sample->depth = 1;
+		sample->weight = 1;
+#if ENV_X86_64
+		sample->pc[0] = info->rip;
+		walk_frames(sample, info->rbp, info->rsp);
+#else
+		sample->pc[0] = info->eip;
+		walk_frames(sample, info->ebp, info->esp);
+#endif
+	}
+
+	lapic_write(LAPIC_EOI, 0);
+}
+
+void profiler_suspend(void)
+{
+	uintptr_t sp;
+
+	if (!table || suspend_depth++)
+		return;
+
+	profiler_irq_disable();
+
+#if ENV_X86_64
+	asm volatile ("mov %%rsp, %0" : "=r" (sp));
+#else
+	asm volatile ("mov %%esp, %0" : "=r" (sp));
+#endif
+	memset(&suspended_sample, 0, sizeof(suspended_sample));
+	walk_frames(&suspended_sample, (uintptr_t)__builtin_frame_address(0), sp);
+	stopwatch_init(&suspended_time);
+}
+
+void profiler_resume(void)
+{
+	struct profile_sample *sample;
+	int64_t usecs;
+
+	if (!table || --suspend_depth)
+		return;
+
+	usecs = stopwatch_duration_usecs(&suspended_time);
+	suspended_sample.weight = usecs * table->sample_hz / USECS_PER_SEC;
+	if (suspended_sample.depth && suspended_sample.weight) {
+		sample = next_sample();
+		if (sample)
+			memcpy(sample, &suspended_sample, sizeof(*sample));
+	}
+
+	profiler_irq_enable();
+}
+
+static void profiler_start(void *unused)
+{
+	const size_t size = sizeof(*table) +
+		CONFIG_RAMSTAGE_PROFILER_SAMPLES * sizeof(table->samples[0]);
+	uint32_t start, ticks_per_msec;
+
+	table = cbmem_add(CBMEM_ID_PROFILE, size);
+	if (!table) {
+		printk(BIOS_ERR, "Profiler: Cannot allocate %zu bytes in CBMEM\n", size);
+		return;
+	}
+	memset(table, 0, sizeof(*table));
+	table->text_base = (uintptr_t)_program;
+	table->sample_hz = CONFIG_RAMSTAGE_PROFILER_HZ;
+	table->max_entries = CONFIG_RAMSTAGE_PROFILER_SAMPLES;
+
+	enable_lapic();
+	lapic_update32(LAPIC_SPIV, ~LAPIC_VECTOR_MASK, LAPIC_SPIV_ENABLE | PROFILER_VECTOR);
+
+	/* Calibrate the LAPIC timer against udelay(), which doesn't use it on these boards. */
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_TDCR, LAPIC_TDR_DIV_1);
+	lapic_write(LAPIC_TMICT, 0xffffffff);
+	start = lapic_read(LAPIC_TMCCT);
+	udelay(USECS_PER_MSEC);
+	ticks_per_msec = start - lapic_read(LAPIC_TMCCT);
+
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_TIMER_PERIODIC | PROFILER_VECTOR);
+	lapic_write(LAPIC_TMICT, (uint64_t)ticks_per_msec * MSECS_PER_SEC /
+		    CONFIG_RAMSTAGE_PROFILER_HZ);
+	profiler_irq_enable();
+
+	printk(BIOS_INFO, "Profiler: Sampling at %u Hz (%u LAPIC ticks/ms), %u samples max\n",
+	       table->sample_hz, ticks_per_msec, table->max_entries);
+}
+
+static void profiler_stop(void *unused)
+{
+	if (!table)
+		return;
+
+	profiler_irq_disable();
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_TMICT, 0);
+
+	printk(BIOS_INFO, "Profiler: Recorded %u samples, dropped %u\n",
+	       table->num_entries, table->dropped);
+	table = NULL;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, profiler_start, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, profiler_stop, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, profiler_stop, NULL);
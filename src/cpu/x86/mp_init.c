@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <console/ap_console.h>
 #include <console/console.h>
 #include <string.h>
 #include <rmodule.h>
@@ -15,6 +16,7 @@
 #include <cpu/x86/smm.h>
 #include <cpu/x86/topology.h>
 #include <cpu/x86/mp.h>
+#include <cpu/x86/mp_timestamp.h>
 #include <delay.h>
 #include <device/device.h>
 #include <smp/atomic.h>
@@ -42,25 +44,34 @@ static char processor_name[49];
  * along with the BSP to coordinate sequencing. Each flight record either
  * provides a barrier for each AP before calling the callback or the APs
  * are allowed to perform the callback without waiting. Regardless, each
- * record has the cpus_entered field incremented for each record. When
- * the BSP observes that the cpus_entered matches the number of APs
- * the bsp_call is called with bsp_arg and upon returning releases the
- * barrier allowing the APs to make further progress.
+ * AP increments the cpus_entered field of its package group for each
+ * record. When the BSP observes that the sum of the cpus_entered fields
+ * matches the number of APs the bsp_call is called with bsp_arg and upon
+ * returning releases the barriers allowing the APs to make further progress.
+ *
+ * The groups keep the APs of different packages from contending on a
+ * single cache line, each AP only touches the line of its own package.
  *
  * Note that ap_call() and bsp_call() can be NULL. In the NULL case the
  * callback will just not be called.
  */
+#define MP_BARRIER_GROUPS	8
+
+struct mp_barrier_group {
+	atomic_t cpus_entered;
+	atomic_t barrier;
+} __aligned(CACHELINE_SIZE);
+
 struct mp_flight_record {
 	atomic_t barrier;
-	atomic_t cpus_entered;
 	void (*ap_call)(void);
 	void (*bsp_call)(void);
+	struct mp_barrier_group groups[MP_BARRIER_GROUPS];
 } __aligned(CACHELINE_SIZE);
 
 #define _MP_FLIGHT_RECORD(barrier_, ap_func_, bsp_func_) \
 	{							\
 		.barrier = ATOMIC_INIT(barrier_),		\
-		.cpus_entered = ATOMIC_INIT(0),			\
 		.ap_call = ap_func_,				\
 		.bsp_call = bsp_func_,				\
 	}
@@ -156,15 +167,58 @@ static enum cb_err wait_for_aps(atomic_t *val, int target, int total_delay,
 	return CB_SUCCESS;
 }
 
+/* Prepare the package groups of the flight plan records before the APs are started. */
+static void init_barrier_groups(struct mp_params *mp_params)
+{
+	int i, j;
+
+	for (i = 0; i < mp_params->num_records; i++) {
+		struct mp_flight_record *rec = &mp_params->flight_plan[i];
+
+		for (j = 0; j < MP_BARRIER_GROUPS; j++) {
+			atomic_set(&rec->groups[j].cpus_entered, 0);
+			atomic_set(&rec->groups[j].barrier, atomic_read(&rec->barrier));
+		}
+	}
+}
+
+static enum cb_err wait_for_record(struct mp_flight_record *rec, int target,
+				   int total_delay, int delay_step)
+{
+	int delayed = 0;
+
+	while (1) {
+		int entered = 0, j;
+
+		for (j = 0; j < MP_BARRIER_GROUPS; j++)
+			entered += atomic_read(&rec->groups[j].cpus_entered);
+		if (entered == target)
+			break;
+
+		udelay(delay_step);
+		delayed += delay_step;
+		if (delayed >= total_delay) {
+			/* Not all APs ready before timeout */
+			return CB_ERR;
+		}
+	}
+
+	/* APs ready before timeout */
+	printk(BIOS_SPEW, "APs are ready after %dus\n", delayed);
+	return CB_SUCCESS;
+}
+
 static void ap_do_flight_plan(void)
 {
+	const struct device *cpu = cpu_info()->cpu;
+	const unsigned int group = cpu->path.apic.package_id % MP_BARRIER_GROUPS;
 	int i;
 
 	for (i = 0; i < mp_info.num_records; i++) {
 		struct mp_flight_record *rec = &mp_info.records[i];
 
-		atomic_inc(&rec->cpus_entered);
-		barrier_wait(&rec->barrier);
+		atomic_inc(&rec->groups[group].cpus_entered);
+		barrier_wait(&rec->groups[group].barrier);
 
 		if (rec->ap_call != NULL)
 			rec->ap_call();
@@ -182,6 +236,9 @@ static struct bus *g_cpu_bus;
  * been loaded. */
 static asmlinkage void ap_init(unsigned int index)
 {
+	/* Microcode was loaded on the way here, and that's part of the check-in time. */
+	const uint64_t checkin = timestamp_get();
+
 	/* Ensure the local APIC is enabled */
 	enable_lapic();
 	setup_lapic_interrupts();
@@ -198,6 +255,7 @@ static asmlinkage void ap_init(unsigned int index)
 	}
 
 	set_cpu_info(index, dev);
+	mp_timestamp_add(TS_AP_CHECKIN, checkin);
 
 	/* Fix up APIC id with reality. */
 	dev->path.apic.apic_id = lapicid();
@@ -220,7 +278,7 @@ static asmlinkage void ap_init(unsigned int index)
 	park_this_cpu(NULL);
 }
 
-static __aligned(16) uint8_t ap_stack[CONFIG_AP_STACK_SIZE * CONFIG_MAX_CPUS];
+static __aligned(16) __noinit uint8_t ap_stack[CONFIG_AP_STACK_SIZE * CONFIG_MAX_CPUS];
 
 static void setup_default_sipi_vector_params(struct sipi_params *sp)
 {
@@ -505,7 +563,7 @@ static enum cb_err start_aps(struct bus *cpu_bus, int ap_count, atomic_t *num_ap
 
 static enum cb_err bsp_do_flight_plan(struct mp_params *mp_params)
 {
-	int i;
+	int i, j;
 	enum cb_err ret = CB_SUCCESS;
 	/*
 	 * Set time out for flight plan to a huge minimum value (>=1 second).
@@ -526,8 +584,7 @@ static enum cb_err bsp_do_flight_plan(struct mp_params *mp_params)
 		/* Wait for APs if the record is not released. */
 		if (atomic_read(&rec->barrier) == 0) {
 			/* Wait for the APs to check in. */
-			if (wait_for_aps(&rec->cpus_entered, num_aps,
-					 timeout_us, step_us) != CB_SUCCESS) {
+			if (wait_for_record(rec, num_aps, timeout_us, step_us) != CB_SUCCESS) {
 				printk(BIOS_ERR, "MP record %d timeout.\n", i);
 				ret = CB_ERR;
 			}
@@ -536,11 +593,18 @@ static enum cb_err bsp_do_flight_plan(struct mp_params *mp_params)
 		if (rec->bsp_call != NULL)
 			rec->bsp_call();
 
+		for (j = 0; j < MP_BARRIER_GROUPS; j++)
+			release_barrier(&rec->groups[j].barrier);
 		release_barrier(&rec->barrier);
 	}
 
 	printk(BIOS_INFO, "%s done after %lld msecs.\n", __func__,
 	       stopwatch_duration_msecs(&sw));
+
+	/* APs are idle now, print what they logged during the flight plan. */
+	ap_console_flush();
+	mp_timestamp_flush();
+
 	return ret;
 }
 
@@ -625,9 +689,13 @@ static enum cb_err mp_init(struct bus *cpu_bus, struct mp_params *p)
 		return CB_ERR;
 	}
 
+	ap_console_init(p->num_cpus);
+	mp_timestamp_init(p->num_cpus);
+
 	/* Copy needed parameters so that APs have a reference to the plan. */
 	mp_info.num_records = p->num_records;
 	mp_info.records = p->flight_plan;
+	init_barrier_groups(p);
 
 	/* Load the SIPI vector. */
 	ap_count = load_sipi_vector(p);
@@ -930,9 +998,14 @@ static enum cb_err run_ap_work(struct mp_callback *val, long expire_us, bool wai
 		 * if wait_ap_finish is true, need to make sure all CPUs finish task and return
 		 * else just need to make sure all CPUs take task
 		 */
-		if (cpus_accepted == global_num_aps)
-			if (!wait_ap_finish || (cpus_finish == global_num_aps))
+		if (cpus_accepted == global_num_aps) {
+			if (!wait_ap_finish)
+				return CB_SUCCESS;
+			if (cpus_finish == global_num_aps) {
+				ap_console_flush();
 				return CB_SUCCESS;
+			}
+		}
 
 	} while (expire_us <= 0 || !stopwatch_expired(&sw));
 
@@ -1156,7 +1229,9 @@ static enum cb_err do_mp_init_with_smm(struct bus *cpu_bus, const struct mp_ops
 	if (!CONFIG(X86_SMM_SKIP_RELOCATION_HANDLER))
 		default_smm_area = backup_default_smm_area();
 
+	timestamp_add_now(TS_MP_INIT_START);
 	ret = mp_init(cpu_bus, &mp_params);
+	timestamp_add_now(TS_MP_INIT_END);
 
 	if (!CONFIG(X86_SMM_SKIP_RELOCATION_HANDLER))
 		restore_default_smm_area(default_smm_area);
@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <console/console.h>
+#include <cpu/x86/mp.h>
+#include <cpu/x86/mp_jobs.h>
+#include <smp/atomic.h>
+#include <smp/spinlock.h>
+#include <timer.h>
+#include <types.h>
+
+#define MP_JOBS_DEQUE_SIZE	64
+
+/*
+ * The owner pushes and pops at the bottom, thieves take the oldest job from the top. The
+ * deques are small and only touched for a few instructions per job, so a lock each is good
+ * enough.
+ */
+struct mp_job_deque {
+	spinlock_t lock;
+	unsigned int top;
+	unsigned int bottom;
+	struct mp_job *jobs[MP_JOBS_DEQUE_SIZE];
+} __aligned(CACHELINE_SIZE);
+
+static struct mp_job_deque deques[CONFIG_MAX_CPUS] = {
+	[0 ... CONFIG_MAX_CPUS - 1] = { .lock = SPIN_LOCK_UNLOCKED },
+};
+
+/* Jobs that were submitted but are not done yet. */
+static atomic_t pending = ATOMIC_INIT(0);
+
+/* Workers run as long as the session they were started for isn't stopped. */
+static volatile unsigned int session;
+static volatile unsigned int stopped_session;
+
+static struct mp_job *pop_job(struct mp_job_deque *d)
+{
+	struct mp_job *job = NULL;
+
+	spin_lock(&d->lock);
+	if (d->bottom != d->top)
+		job = d->jobs[--d->bottom % MP_JOBS_DEQUE_SIZE];
+	spin_unlock(&d->lock);
+
+	return job;
+}
+
+static struct mp_job *steal_job(struct mp_job_deque *d)
+{
+	struct mp_job *job = NULL;
+
+	/* Unlocked peek, most deques are empty most of the time. */
+	if (d->bottom == d->top)
+		return NULL;
+
+	spin_lock(&d->lock);
+	if (d->bottom != d->top)
+		job = d->jobs[d->top++ % MP_JOBS_DEQUE_SIZE];
+	spin_unlock(&d->lock);
+
+	return job;
+}
+
+static void run_job(struct mp_job *job)
+{
+	job->func(job->arg);
+	mfence();
+	/* Last access to the job, the submitter may release it as soon as it sees this. */
+	atomic_set(&job->done, 1);
+	atomic_dec(&pending);
+}
+
+/* Runs one job from our own deque or from someone else's. Returns false if there was none. */
+static bool run_one_job(unsigned long self)
+{
+	struct mp_job *job = NULL;
+	unsigned long i;
+
+	if (self < ARRAY_SIZE(deques))
+		job = pop_job(&deques[self]);
+
+	for (i = 1; !job && i <= ARRAY_SIZE(deques); i++)
+		job = steal_job(&deques[(self + i) % ARRAY_SIZE(deques)]);
+
+	if (!job)
+		return false;
+
+	run_job(job);
+	return true;
+}
+
+static void mp_job_worker(void *arg)
+{
+	const unsigned int mine = (uintptr_t)arg;
+	const unsigned long self = cpu_index();
+
+	while (stopped_session != mine) {
+		if (!run_one_job(self))
+			cpu_relax();
+	}
+}
+
+enum cb_err mp_jobs_begin(void)
+{
+	session++;
+
+	/* If the APs don't start, the submitting and joining CPUs do all the work. */
+	if (mp_run_on_aps(mp_job_worker, (void *)(uintptr_t)session, MP_RUN_ON_ALL_CPUS,
+			  100 * USECS_PER_MSEC) != CB_SUCCESS) {
+		printk(BIOS_WARNING, "MP jobs: APs did not start, running jobs on the BSP\n");
+		return CB_ERR;
+	}
+
+	return CB_SUCCESS;
+}
+
+void mp_jobs_end(void)
+{
+	const unsigned long self = cpu_index();
+
+	while (atomic_read(&pending)) {
+		if (!run_one_job(self))
+			cpu_relax();
+	}
+
+	stopped_session = session;
+	mfence();
+}
+
+void mp_job_submit(struct mp_job *job, void (*func)(void *arg), void *arg)
+{
+	const unsigned long self = cpu_index();
+	struct mp_job_deque *d;
+
+	job->func = func;
+	job->arg = arg;
+	atomic_set(&job->done, 0);
+
+	if (self >= ARRAY_SIZE(deques)) {
+		job->func(job->arg);
+		atomic_set(&job->done, 1);
+		return;
+	}
+
+	d = &deques[self];
+	atomic_inc(&pending);
+
+	spin_lock(&d->lock);
+	if (d->bottom - d->top < MP_JOBS_DEQUE_SIZE) {
+		d->jobs[d->bottom++ % MP_JOBS_DEQUE_SIZE] = job;
+		job = NULL;
+	}
+	spin_unlock(&d->lock);
+
+	/* The deque is full, don't wait for room and just run it. */
+	if (job)
+		run_job(job);
+}
+
+void mp_job_join(struct mp_job *job)
+{
+	const unsigned long self = cpu_index();
+
+	while (!atomic_read(&job->done)) {
+		if (!run_one_job(self))
+			cpu_relax();
+	}
+	mfence();
+}
@@ -0,0 +1,241 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootmem.h>
+#include <bootstate.h>
+#include <cbmem.h>
+#include <commonlib/bsd/helpers.h>
+#include <console/console.h>
+#include <cpu/x86/mp_jobs.h>
+#include <device/device.h>
+#include <memrange.h>
+#include <smp/spinlock.h>
+#include <string.h>
+#include <timer.h>
+#include <types.h>
+
+/*
+ * Destructive test of all memory that is left as RAM for the OS, run right before the
+ * payload is loaded. The memory is cut into slices that the MP job system spreads over
+ * all CPUs. Each slice is written with non-temporal stores, so the data goes to DRAM
+ * instead of staying in the caches, and read back twice: once with an address based
+ * pattern and once with its inverse.
+ *
+ * coreboot has no generic view of the NUMA topology, so slices are handed to whichever
+ * CPU is idle. On NUMA systems with a node-local memory map the CPUs still mostly
+ * stream from their own memory, since neighbouring slices usually end up on the same
+ * CPU's deque.
+ */
+
+#define MEMTEST_MAX_RANGES	32
+#define MEMTEST_MAX_SLICES	256
+#define MEMTEST_MIN_SLICE	(16 * MiB)
+/* Stay out of the legacy areas below 1 MiB that payloads and option ROMs use. */
+#define MEMTEST_START		(1 * MiB)
+
+#if !ENV_X86_64
+/* Leave room for the end of the last slice to fit into a pointer. */
+#define MEMTEST_END		(4ULL * GiB - 2 * MiB)
+#elif CONFIG(NEED_SMALL_2MB_PAGE_TABLES)
+#define MEMTEST_END		(4ULL * GiB)
+#else
+/* What the static page tables identity map */
+#define MEMTEST_END		(CONFIG_X86_64_PGTBL_1G_PML4_ENTRIES * 512ULL * GiB)
+#endif
+
+#define MEMTEST_PATTERN		((uintptr_t)0x5aa5c33c5aa5c33cULL)
+#define MEMTEST_PRINT_ERRORS	16
+
+struct memtest_range {
+	uint64_t base;
+	uint64_t size;
+	uint64_t errors;
+	/* Address of the first bad word, if there are errors */
+	uint64_t first_error;
+} __packed;
+
+/* CBMEM_ID_MEMTEST */
+struct memtest_results {
+	uint32_t num_ranges;
+	uint32_t num_cpus;
+	uint64_t duration_us;
+	/* Bytes written and read back per second, over all CPUs */
+	uint64_t bytes_per_sec;
+	struct memtest_range ranges[MEMTEST_MAX_RANGES];
+} __packed;
+
+struct memtest_slice {
+	struct mp_job job;
+	uintptr_t base;
+	uintptr_t size;
+	size_t range;
+	uint64_t errors;
+	uintptr_t first_error;
+};
+
+static struct memtest_results *results;
+static struct memtest_slice slices[MEMTEST_MAX_SLICES + MEMTEST_MAX_RANGES];
+static int errors_printed;
+DECLARE_SPIN_LOCK(memtest_print_lock)
+
+static void write_slice(const struct memtest_slice *s, uintptr_t invert)
+{
+	uintptr_t *p = (uintptr_t *)s->base;
+	uintptr_t *const end = (uintptr_t *)(s->base + s->size);
+
+	for (; p < end; p++)
+		asm volatile ("movnti %1, %0" : "=m" (*p) : "r" ((uintptr_t)p ^ invert));
+
+	asm volatile ("sfence" ::: "memory");
+}
+
+static void verify_slice(struct memtest_slice *s, uintptr_t invert)
+{
+	const volatile uintptr_t *p = (const uintptr_t *)s->base;
+	const volatile uintptr_t *const end = (const uintptr_t *)(s->base + s->size);
+
+	for (; p < end; p++) {
+		const uintptr_t expected = (uintptr_t)p ^ invert;
+		const uintptr_t got = *p;
+
+		if (got == expected)
+			continue;
+
+		if (!s->errors++)
+			s->first_error = (uintptr_t)p;
+		spin_lock(&memtest_print_lock);
+		if (errors_printed++ < MEMTEST_PRINT_ERRORS)
+			printk(BIOS_ERR, "memtest: %p: got 0x%lx, expected 0x%lx\n", p,
+			       (unsigned long)got, (unsigned long)expected);
+		spin_unlock(&memtest_print_lock);
+	}
+}
+
+static void test_slice(void *arg)
+{
+	struct memtest_slice *s = arg;
+
+	write_slice(s, MEMTEST_PATTERN);
+	verify_slice(s, MEMTEST_PATTERN);
+	write_slice(s, ~MEMTEST_PATTERN);
+	verify_slice(s, ~MEMTEST_PATTERN);
+}
+
+static bool add_range(const struct range_entry *r, void *arg)
+{
+	uint64_t base = MAX(range_entry_base(r), MEMTEST_START);
+	uint64_t end = MIN(range_entry_end(r), MEMTEST_END);
+
+	if (range_entry_tag(r) != BM_MEM_RAM)
+		return true;
+
+	base = ALIGN_UP(base, 64);
+	end = ALIGN_DOWN(end, 64);
+	if (base >= end)
+		return true;
+
+	if (results->num_ranges == MEMTEST_MAX_RANGES) {
+		printk(BIOS_WARNING, "memtest: Not testing [0x%llx-0x%llx)\n", base, end);
+		return true;
+	}
+
+	results->ranges[results->num_ranges].base = base;
+	results->ranges[results->num_ranges].size = end - base;
+	results->num_ranges++;
+
+	return true;
+}
+
+static size_t cut_slices(void)
+{
+	uint64_t total = 0;
+	uintptr_t slice_size;
+	size_t i, n = 0;
+
+	for (i = 0; i < results->num_ranges; i++)
+		total += results->ranges[i].size;
+
+	slice_size = MAX(ALIGN_UP(DIV_ROUND_UP(total, MEMTEST_MAX_SLICES), 2 * MiB),
+			 MEMTEST_MIN_SLICE);
+
+	for (i = 0; i < results->num_ranges; i++) {
+		const struct memtest_range *range = &results->ranges[i];
+		uint64_t offset;
+
+		for (offset = 0; offset < range->size; offset += slice_size) {
+			slices[n].base = range->base + offset;
+			slices[n].size = MIN(slice_size, range->size - offset);
+			slices[n].range = i;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+static void reserve_results(void *unused)
+{
+	/* Allocated before the memory map is written, so the test can't hit it. */
+	results = cbmem_add(CBMEM_ID_MEMTEST, sizeof(*results));
+	if (!results)
+		printk(BIOS_ERR, "memtest: Could not allocate results, not testing\n");
+}
+
+static void run_memtest(void *unused)
+{
+	struct stopwatch sw;
+	uint64_t total = 0, errors = 0;
+	size_t i, num_slices;
+
+	if (!results)
+		return;
+
+	memset(results, 0, sizeof(*results));
+	bootmem_walk(add_range, NULL);
+	num_slices = cut_slices();
+	results->num_cpus = dev_count_cpu();
+
+	printk(BIOS_INFO, "memtest: Testing %u ranges in %zu slices on %u CPUs\n",
+	       results->num_ranges, num_slices, results->num_cpus);
+
+	stopwatch_init(&sw);
+
+	if (mp_jobs_begin() != CB_SUCCESS)
+		printk(BIOS_WARNING, "memtest: Running on the BSP only\n");
+	for (i = 0; i < num_slices; i++)
+		mp_job_submit(&slices[i].job, test_slice, &slices[i]);
+	for (i = 0; i < num_slices; i++)
+		mp_job_join(&slices[i].job);
+	mp_jobs_end();
+
+	results->duration_us = MAX(stopwatch_duration_usecs(&sw), 1);
+
+	/* Slices of a range are in address order, so the first error seen is the lowest. */
+	for (i = 0; i < num_slices; i++) {
+		struct memtest_range *range = &results->ranges[slices[i].range];
+
+		if (slices[i].errors && !range->errors)
+			range->first_error = slices[i].first_error;
+		range->errors += slices[i].errors;
+	}
+
+	for (i = 0; i < results->num_ranges; i++) {
+		const struct memtest_range *range = &results->ranges[i];
+
+		printk(range->errors ? BIOS_ERR : BIOS_INFO,
+		       "memtest: [0x%llx-0x%llx): %llu errors\n", range->base,
+		       range->base + range->size, range->errors);
+		total += range->size;
+		errors += range->errors;
+	}
+
+	/* Each byte is written and read twice. */
+	results->bytes_per_sec = total * 4 * USECS_PER_SEC / results->duration_us;
+
+	printk(errors ? BIOS_ERR : BIOS_INFO,
+	       "memtest: %llu MiB tested in %llu ms, %llu MiB/s, %llu errors\n",
+	       total / MiB, results->duration_us / USECS_PER_MSEC,
+	       results->bytes_per_sec / MiB, errors);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY, reserve_results, NULL);
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_EXIT, run_memtest, NULL);
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <bootstate.h>
+#include <cbmem.h>
+#include <console/console.h>
+#include <cpu/x86/mp.h>
+#include <cpu/x86/mp_timestamp.h>
+#include <smp/node.h>
+#include <string.h>
+#include <timestamp.h>
+#include <types.h>
+
+#define MP_TIMESTAMPS_PER_CPU	8
+
+/*
+ * Single producer (the CPU owning the buffer), single consumer (the BSP). |head|
+ * is only written by the owner and |tail| only by the BSP. Both are free running
+ * and an entry is published by updating |head| after it has been written.
+ */
+struct mp_timestamp_ring {
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	uint32_t dropped;
+	/* Only used by the BSP. */
+	uint32_t dropped_reported;
+	struct timestamp_entry entries[MP_TIMESTAMPS_PER_CPU];
+};
+
+static struct mp_timestamp_ring *rings;
+static int num_rings;
+
+void mp_timestamp_init(int num_cpus)
+{
+	const size_t size = num_cpus * sizeof(*rings);
+
+	if (num_cpus <= 1 || rings)
+		return;
+
+	rings = cbmem_add(CBMEM_ID_AP_TIMESTAMPS, size);
+	if (!rings) {
+		printk(BIOS_ERR, "MP timestamps: Cannot allocate %zu bytes in CBMEM\n", size);
+		return;
+	}
+	memset(rings, 0, size);
+	num_rings = num_cpus;
+}
+
+void mp_timestamp_add(enum timestamp_id id, uint64_t ts_time)
+{
+	struct mp_timestamp_ring *ring;
+	struct timestamp_entry *tse;
+	const size_t index = cpu_index();
+	uint32_t head;
+
+	if (!rings || index >= num_rings)
+		return;
+
+	ring = &rings[index];
+	head = ring->head;
+	if (head - ring->tail == MP_TIMESTAMPS_PER_CPU) {
+		ring->dropped++;
+		return;
+	}
+
+	tse = &ring->entries[head % MP_TIMESTAMPS_PER_CPU];
+	tse->entry_id = id;
+	tse->entry_stamp = ts_time;
+	/* Publish the entry only after it is in place. */
+	mfence();
+	ring->head = head + 1;
+}
+
+void mp_timestamp_flush(void)
+{
+	struct mp_timestamp_ring *ring;
+	struct timestamp_entry tse;
+	int i;
+
+	if (!rings || !boot_cpu())
+		return;
+
+	for (i = 0; i < num_rings; i++) {
+		ring = &rings[i];
+
+		while (ring->tail != ring->head) {
+			mfence();
+			tse = ring->entries[ring->tail % MP_TIMESTAMPS_PER_CPU];
+			mfence();
+			ring->tail++;
+			timestamp_add(TIMESTAMP_CPU_ID(tse.entry_id, i), tse.entry_stamp);
+		}
+
+		if (ring->dropped != ring->dropped_reported) {
+			printk(BIOS_WARNING, "CPU%d: %u timestamps dropped\n", i,
+			       ring->dropped - ring->dropped_reported);
+			ring->dropped_reported = ring->dropped;
+		}
+	}
+}
+
+static void mp_timestamp_flush_bs(void *unused)
+{
+	mp_timestamp_flush();
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_INIT, BS_ON_EXIT, mp_timestamp_flush_bs, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, mp_timestamp_flush_bs, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, mp_timestamp_flush_bs, NULL);
@@ -9,6 +9,7 @@
  */
 
 #include <assert.h>
+#include <boot/coreboot_tables.h>
 #include <bootstate.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
@@ -22,6 +23,7 @@
 #include <device/pci_ids.h>
 #include <memrange.h>
 #include <string.h>
+#include <timer.h>
 #include <types.h>
 
 #if CONFIG(X86_AMD_FIXED_MTRRS)
@@ -286,18 +288,20 @@ static void calc_fixed_mtrrs(void)
 	fixed_mtrr_types_initialized = 1;
 }
 
-static void commit_fixed_mtrrs(void)
+/* Fixed MTRR MSR values derived from fixed_mtrr_types. Can be reused by APs. */
+static msr_t fixed_msrs[NUM_FIXED_MTRRS];
+static unsigned long fixed_msr_index[NUM_FIXED_MTRRS];
+static int fixed_msrs_initialized;
+
+static void prepare_fixed_mtrrs(void)
 {
 	int i;
 	int j;
 	int msr_num;
 	int type_index;
-	const unsigned int lapic_id = lapicid();
-	/* 8 ranges per msr. */
-	msr_t fixed_msrs[NUM_FIXED_MTRRS];
-	unsigned long msr_index[NUM_FIXED_MTRRS];
 
-	fixed_mtrrs_expose_amd_rwdram();
+	if (fixed_msrs_initialized)
+		return;
 
 	memset(&fixed_msrs, 0, sizeof(fixed_msrs));
 
@@ -310,7 +314,7 @@ static void commit_fixed_mtrrs(void)
 		desc = &fixed_mtrr_desc[i];
 		num_ranges = (desc->end - desc->begin) / desc->step;
 		for (j = 0; j < num_ranges; j += RANGES_PER_FIXED_MTRR) {
-			msr_index[msr_num] = desc->msr_index_base +
+			fixed_msr_index[msr_num] = desc->msr_index_base +
 				(j / RANGES_PER_FIXED_MTRR);
 			fixed_msrs[msr_num].lo |=
 				fixed_mtrr_types[type_index++] << 0;
@@ -336,12 +340,21 @@ static void commit_fixed_mtrrs(void)
 	ASSERT(msr_num == NUM_FIXED_MTRRS)
 
 	for (i = 0; i < ARRAY_SIZE(fixed_msrs); i++)
-		printk(BIOS_DEBUG, "apic_id 0x%x: MTRR: Fixed MSR 0x%lx 0x%08x%08x\n",
-		       lapic_id, msr_index[i], fixed_msrs[i].hi, fixed_msrs[i].lo);
+		printk(BIOS_DEBUG, "MTRR: Fixed MSR 0x%lx 0x%08x%08x\n",
+		       fixed_msr_index[i], fixed_msrs[i].hi, fixed_msrs[i].lo);
+
+	fixed_msrs_initialized = 1;
+}
+
+static void commit_fixed_mtrrs(void)
+{
+	int i;
+
+	fixed_mtrrs_expose_amd_rwdram();
 
 	disable_cache();
 	for (i = 0; i < ARRAY_SIZE(fixed_msrs); i++)
-		wrmsr(msr_index[i], fixed_msrs[i]);
+		wrmsr(fixed_msr_index[i], fixed_msrs[i]);
 	enable_cache();
 	fixed_mtrrs_hide_amd_rwdram();
 }
@@ -349,6 +362,7 @@ static void commit_fixed_mtrrs(void)
 static void x86_setup_fixed_mtrrs_no_enable(void)
 {
 	calc_fixed_mtrrs();
+	prepare_fixed_mtrrs();
 	commit_fixed_mtrrs();
 }
 
@@ -373,6 +387,11 @@ struct var_mtrr_solution {
 
 /* Global storage for variable MTRR solution. */
 static struct var_mtrr_solution mtrr_global_solution;
+static bool mtrr_global_solution_valid;
+
+/* Mutes the solver's output while it is being benchmarked. */
+static bool mtrr_calc_quiet;
+#define MTRR_CALC_LEVEL(level) (mtrr_calc_quiet ? BIOS_NEVER : (level))
 
 struct var_mtrr_state {
 	struct memranges *addr_space;
@@ -406,7 +425,7 @@ static void prep_var_mtrr(struct var_mtrr_state *var_state,
 	resource_t mask;
 
 	if (var_state->mtrr_index >= total_mtrrs) {
-		printk(BIOS_ERR, "Not enough MTRRs available! MTRR index is %d with %d MTRRs in total.\n",
+		printk(MTRR_CALC_LEVEL(BIOS_ERR), "Not enough MTRRs available! MTRR index is %d with %d MTRRs in total.\n",
 		       var_state->mtrr_index, total_mtrrs);
 		return;
 	}
@@ -417,7 +436,7 @@ static void prep_var_mtrr(struct var_mtrr_state *var_state,
 	 * space properly.
 	 */
 	if (var_state->mtrr_index >= total_mtrrs - get_os_reserved_mtrrs())
-		printk(BIOS_WARNING, "Taking a reserved OS MTRR.\n");
+		printk(MTRR_CALC_LEVEL(BIOS_WARNING), "Taking a reserved OS MTRR.\n");
 
 	rbase = base;
 	rsize = size;
@@ -429,7 +448,7 @@ static void prep_var_mtrr(struct var_mtrr_state *var_state,
 	mask = (1ULL << var_state->address_bits) - 1;
 	rsize = rsize & mask;
 
-	printk(BIOS_DEBUG, "MTRR: %d base 0x%016llx mask 0x%016llx type %d\n",
+	printk(MTRR_CALC_LEVEL(BIOS_DEBUG), "MTRR: %d base 0x%016llx mask 0x%016llx type %d\n",
 	       var_state->mtrr_index, rbase, rsize, mtrr_type);
 
 	regs = &var_state->regs[var_state->mtrr_index];
@@ -713,7 +732,7 @@ static int calc_var_mtrrs(struct memranges *addr_space,
 
 	const int bios_mtrrs = total_mtrrs - get_os_reserved_mtrrs();
 	if (wb_deftype_count > bios_mtrrs && uc_deftype_count > bios_mtrrs) {
-		printk(BIOS_DEBUG, "MTRR: Removing WRCOMB type. "
+		printk(MTRR_CALC_LEVEL(BIOS_DEBUG), "MTRR: Removing WRCOMB type. "
 		       "WB/UC MTRR counts: %d/%d > %d.\n",
 		       wb_deftype_count, uc_deftype_count, bios_mtrrs);
 		memranges_update_tag(addr_space, MTRR_TYPE_WRCOMB,
@@ -722,14 +741,14 @@ static int calc_var_mtrrs(struct memranges *addr_space,
 				 &wb_deftype_count, &uc_deftype_count);
 	}
 
-	printk(BIOS_DEBUG, "MTRR: default type WB/UC MTRR counts: %d/%d.\n",
+	printk(MTRR_CALC_LEVEL(BIOS_DEBUG), "MTRR: default type WB/UC MTRR counts: %d/%d.\n",
 	       wb_deftype_count, uc_deftype_count);
 
 	if (wb_deftype_count < uc_deftype_count) {
-		printk(BIOS_DEBUG, "MTRR: WB selected as default type.\n");
+		printk(MTRR_CALC_LEVEL(BIOS_DEBUG), "MTRR: WB selected as default type.\n");
 		return MTRR_TYPE_WRBACK;
 	}
-	printk(BIOS_DEBUG, "MTRR: UC selected as default type.\n");
+	printk(MTRR_CALC_LEVEL(BIOS_DEBUG), "MTRR: UC selected as default type.\n");
 	return MTRR_TYPE_UNCACHEABLE;
 }
 
@@ -786,17 +805,16 @@ static int commit_var_mtrrs(const struct var_mtrr_solution *sol)
 
 void x86_setup_var_mtrrs(unsigned int address_bits, unsigned int above4gb)
 {
-	static struct var_mtrr_solution *sol = NULL;
+	struct var_mtrr_solution *sol = &mtrr_global_solution;
 	struct memranges *addr_space;
 
-	addr_space = get_physical_address_space();
-
-	if (sol == NULL) {
-		sol = &mtrr_global_solution;
+	if (!mtrr_global_solution_valid) {
+		addr_space = get_physical_address_space();
 		sol->mtrr_default_type =
 			calc_var_mtrrs(addr_space, !!above4gb, address_bits);
 		prepare_var_mtrrs(addr_space, sol->mtrr_default_type,
 				  !!above4gb, address_bits, sol);
+		mtrr_global_solution_valid = true;
 	}
 
 	commit_var_mtrrs(sol);
@@ -836,6 +854,17 @@ void x86_setup_mtrrs_with_detect_no_above_4gb(void)
 	_x86_setup_mtrrs(0);
 }
 
+void x86_commit_mtrrs(void)
+{
+	/* Nothing to broadcast if the BSP hasn't set up its MTRRs yet. */
+	if (!fixed_msrs_initialized || !mtrr_global_solution_valid)
+		return;
+
+	commit_fixed_mtrrs();
+	enable_fixed_mtrr();
+	commit_var_mtrrs(&mtrr_global_solution);
+}
+
 void x86_mtrr_check(void)
 {
 	/* Only Pentium Pro and later have MTRR */
@@ -945,3 +974,102 @@ static void remove_temp_solution(void *unused)
 
 BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, remove_temp_solution, NULL);
 BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, remove_temp_solution, NULL);
+
+static void framebuffer_use_wrcomb(void *unused)
+{
+	const struct range_entry *r;
+	struct lb_framebuffer fb;
+	uint64_t base, size;
+
+	if (!CONFIG(FRAMEBUFFER_TEMP_WRCOMB) || fill_lb_framebuffer(&fb))
+		return;
+
+	base = ALIGN_DOWN(fb.physical_address, 4 * KiB);
+	size = ALIGN_UP(fb.physical_address + (uint64_t)fb.bytes_per_line * fb.y_resolution,
+			4 * KiB) - base;
+
+	/* Nothing to do if the global solution kept the framebuffer BAR write-combining. */
+	memranges_each_entry(r, get_physical_address_space()) {
+		if (range_entry_base(r) <= base && range_entry_end(r) >= base + size &&
+		    range_entry_tag(r) == MTRR_TYPE_WRCOMB)
+			return;
+	}
+
+	printk(BIOS_DEBUG, "MTRR: Mapping framebuffer at 0x%llx write-combining\n", base);
+	mtrr_use_temp_range(base, size, MTRR_TYPE_WRCOMB);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_INIT, BS_ON_EXIT, framebuffer_use_wrcomb, NULL);
+
+#define MTRR_BENCH_HOLES	8
+#define MTRR_BENCH_HOLE_SIZE	(1ULL * GiB)
+
+/*
+ * Build a large memory map: the real map below 4GiB, DRAM from 4GiB up to |top| and
+ * MTRR_BENCH_HOLES uncacheable MMIO windows spread over it, like on multi-socket servers.
+ */
+static void mtrr_benchmark_map(struct memranges *map, uint64_t top)
+{
+	const uint64_t low_top = 4ULL * GiB;
+	const uint64_t stride = (top - low_top) / MTRR_BENCH_HOLES;
+	struct range_entry *r;
+	int i;
+
+	memranges_init_empty(map, NULL, 0);
+	memranges_each_entry(r, get_physical_address_space()) {
+		if (range_entry_base(r) >= low_top)
+			break;
+		memranges_insert(map, range_entry_base(r),
+				 MIN(range_entry_end(r), low_top) - range_entry_base(r),
+				 range_entry_tag(r));
+	}
+
+	memranges_insert(map, low_top, top - low_top, MTRR_TYPE_WRBACK);
+	for (i = 0; i < MTRR_BENCH_HOLES; i++)
+		memranges_insert(map, low_top + i * stride + stride / 2, MTRR_BENCH_HOLE_SIZE,
+				 MTRR_TYPE_UNCACHEABLE);
+}
+
+/*
+ * Compare what it costs every CPU to derive the variable MTRRs itself against committing a
+ * solution the BSP computed once, for 1-4 TiB memory maps.
+ */
+static void mtrr_benchmark(void *unused)
+{
+	const int address_bits = MAX(cpu_phys_address_size(), 46);
+	struct var_mtrr_solution sol;
+	struct memranges map;
+	struct stopwatch sw;
+	int wb_count, uc_count;
+	int64_t solve_usecs;
+	unsigned int tib;
+
+	if (!CONFIG(DEBUG_MTRR_BENCHMARK) || !mtrr_global_solution_valid)
+		return;
+
+	stopwatch_init(&sw);
+	commit_var_mtrrs(&mtrr_global_solution);
+	printk(BIOS_DEBUG, "MTRR bench: committing the cached solution takes %lld us\n",
+	       stopwatch_duration_usecs(&sw));
+
+	for (tib = 1; tib <= 4; tib++) {
+		mtrr_benchmark_map(&map, (uint64_t)tib << 40);
+
+		mtrr_calc_quiet = true;
+		memset(&sol, 0, sizeof(sol));
+		stopwatch_init(&sw);
+		sol.mtrr_default_type = calc_var_mtrrs(&map, 1, address_bits);
+		prepare_var_mtrrs(&map, sol.mtrr_default_type, 1, address_bits, &sol);
+		solve_usecs = stopwatch_duration_usecs(&sw);
+		__calc_var_mtrrs(&map, 1, address_bits, &wb_count, &uc_count);
+		mtrr_calc_quiet = false;
+
+		printk(BIOS_DEBUG, "MTRR bench: %u TiB, %d holes: solving takes %lld us, "
+		       "needs %d MTRRs\n", tib, MTRR_BENCH_HOLES, solve_usecs,
+		       MIN(wb_count, uc_count));
+
+		memranges_teardown(&map);
+	}
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY, mtrr_benchmark, NULL);
@@ -41,6 +41,7 @@ ifeq ($(CONFIG_PARALLEL_MP),y)
 smmstub-y += smm_stub.S
 
 smm-y += smm_module_handler.c
+smm-$(CONFIG_SMM_LATENCY_HISTOGRAM) += latency_histogram.c
 
 ramstage-srcs += $(obj)/cpu/x86/smm/smmstub.manual
 
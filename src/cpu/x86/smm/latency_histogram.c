@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cpu/x86/smm.h>
+#include <string.h>
+#include <types.h>
+
+static struct smm_latency_histogram histogram = {
+	.sources = SMM_HISTOGRAM_SOURCES,
+	.buckets = SMM_HISTOGRAM_BUCKETS,
+	.shift = SMM_HISTOGRAM_SHIFT,
+};
+
+void smm_latency_histogram_add(unsigned int source, u64 ticks)
+{
+	u64 scaled = ticks >> SMM_HISTOGRAM_SHIFT;
+	unsigned int bucket = 0;
+
+	if (source >= SMM_HISTOGRAM_SOURCES)
+		return;
+
+	while (scaled > 1 && bucket < SMM_HISTOGRAM_BUCKETS - 1) {
+		scaled >>= 1;
+		bucket++;
+	}
+
+	/* Saturate instead of wrapping, a wrapped counter looks like a quiet system. */
+	if (histogram.count[source][bucket] != UINT32_MAX)
+		histogram.count[source][bucket]++;
+}
+
+int smm_latency_histogram_read(void *buf, size_t size)
+{
+	if (!buf || size < sizeof(histogram) || smm_points_to_smram(buf, size))
+		return -1;
+
+	memcpy(buf, &histogram, sizeof(histogram));
+	return 0;
+}
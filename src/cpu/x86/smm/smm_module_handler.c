@@ -7,6 +7,7 @@
 #include <console/console.h>
 #include <cpu/cpu.h>
 #include <cpu/x86/smm.h>
+#include <cpu/x86/tsc.h>
 #include <rmodule.h>
 #include <types.h>
 #include <security/intel/stm/SmmStm.h>
@@ -130,8 +131,30 @@ bool smm_region_overlaps_handler(const struct region *r)
 	return region_overlap(&r_smm, r) || region_overlap(&r_aseg, r);
 }
 
+#if CONFIG(SMM_LATENCY_LOG)
+static void smm_latency_record(int cpu, u64 entry_tsc)
+{
+	struct smm_latency_log *log = (void *)smm_runtime.latency_log;
+	struct smm_latency_entry *e;
+
+	if (!log)
+		return;
+
+	/* The log lives in OS memory, don't trust its header for the index. */
+	e = &log->entries[log->count % CONFIG_SMM_LATENCY_LOG_ENTRIES];
+	e->entry_tsc = entry_tsc;
+	e->cpu = cpu;
+	e->exit_tsc = rdtscll();
+	log->count++;
+}
+#else
+static void smm_latency_record(int cpu, u64 entry_tsc) {}
+#endif
+
 asmlinkage void smm_handler_start(void *arg)
 {
+	const u64 entry_tsc = CONFIG(SMM_LATENCY_LOG) || CONFIG(SMM_LATENCY_HISTOGRAM) ?
+		rdtscll() : 0;
 	const struct smm_module_params *p;
 	int cpu;
 	uintptr_t actual_canary;
@@ -197,6 +220,10 @@ asmlinkage void smm_handler_start(void *arg)
 
 	smm_soc_exit();
 
+	smm_latency_record(cpu, entry_tsc);
+	if (CONFIG(SMM_LATENCY_HISTOGRAM))
+		smm_latency_histogram_add(SMM_HISTOGRAM_TOTAL, rdtscll() - entry_tsc);
+
 	smi_release_lock();
 
 	/* De-assert SMI# signal to allow another SMI */
@@ -11,7 +11,6 @@
 #include <device/mmio.h>
 #include <rmodule.h>
 #include <smmstore.h>
-#include <stdio.h>
 #include <string.h>
 #include <types.h>
 
@@ -36,6 +35,13 @@ extern unsigned char _binary_smmstub_start[];
 /* Per CPU minimum stack size. */
 #define SMM_MINIMUM_STACK_SIZE 32
 
+/*
+ * Spacing between the smbase of neighbouring CPUs in a code segment is rounded up to a
+ * cache line, so that CPUs entering SMM at the same time don't share lines of their stub
+ * code or save state.
+ */
+#define SMM_CPU_ALIGN 64
+
 struct cpu_smm_info {
 	uint8_t active;
 	uintptr_t smbase;
@@ -101,7 +107,8 @@ static int smm_create_map(const uintptr_t smbase, const unsigned int num_cpus,
 	 * Make sure that the first stub does not overlap with the last save state of a segment.
 	 */
 	const size_t stub_size = rmodule_memory_size(&smm_stub);
-	const size_t needed_ss_size = MAX(params->cpu_save_state_size, stub_size);
+	const size_t needed_ss_size = ALIGN_UP(MAX(params->cpu_save_state_size, stub_size),
+					       SMM_CPU_ALIGN);
 	const size_t cpus_per_segment =
 		(SMM_CODE_SEGMENT_SIZE - SMM_ENTRY_OFFSET - stub_size) / needed_ss_size;
 
@@ -168,16 +175,12 @@ static void smm_place_entry_code(const unsigned int num_cpus)
 
 	/* start at 1, the first CPU stub code is already there */
 	size = region_sz(&cpus[0].stub_code);
-	for (i = 1; i < num_cpus; i++) {
-		printk(BIOS_DEBUG,
-		       "SMM Module: placing smm entry code at %zx,  cpu # 0x%x\n",
-		       region_offset(&cpus[i].stub_code), i);
+	for (i = 1; i < num_cpus; i++)
 		memcpy((void *)region_offset(&cpus[i].stub_code),
 		       (void *)region_offset(&cpus[0].stub_code), size);
-		printk(BIOS_SPEW, "%s: copying from %zx to %zx 0x%zx bytes\n",
-		       __func__, region_offset(&cpus[0].stub_code),
-		       region_offset(&cpus[i].stub_code), size);
-	}
+
+	printk(BIOS_DEBUG, "SMM Module: placed 0x%zx bytes of entry code for %u CPUs\n",
+	       size, num_cpus);
 }
 
 static uintptr_t stack_top;
@@ -352,6 +355,17 @@ static void setup_smihandler_params(struct smm_runtime *mod_params,
 	if (CONFIG(SMM_PCI_RESOURCE_STORE))
 		smm_pci_resource_store_init(mod_params);
 
+#if CONFIG(SMM_LATENCY_LOG)
+	const size_t log_size = sizeof(struct smm_latency_log) +
+		CONFIG_SMM_LATENCY_LOG_ENTRIES * sizeof(struct smm_latency_entry);
+	struct smm_latency_log *log = cbmem_add(CBMEM_ID_SMM_LATENCY, log_size);
+	if (log) {
+		memset(log, 0, log_size);
+		log->num_entries = CONFIG_SMM_LATENCY_LOG_ENTRIES;
+	}
+	mod_params->latency_log = (uintptr_t)log;
+#endif
+
 	if (CONFIG(SMMSTORE_V2)) {
 		struct smmstore_params_info info;
 		if (smmstore_get_info(&info) < 0) {
@@ -375,8 +389,8 @@ static void print_region(const char *name, const struct region region)
 	       region_end(&region));
 }
 
-/* STM + Handler + (Stub + Save state) * CONFIG_MAX_CPUS + stacks + page tables*/
-#define SMM_REGIONS_ARRAY_SIZE (1  + 1 + CONFIG_MAX_CPUS * 2 + 1 + 1)
+/* STM + Handler + CPU entry code and save states + stacks + page tables*/
+#define SMM_REGIONS_ARRAY_SIZE (1  + 1 + 1 + 1 + 1)
 
 static int append_and_check_region(const struct region smram,
 				   const struct region region,
@@ -471,12 +485,7 @@ static uintptr_t install_page_table(const uintptr_t handler_base)
 int smm_load_module(const uintptr_t smram_base, const size_t smram_size,
 		    struct smm_loader_params *params)
 {
-	/*
-	 * Place in .bss to reduce stack usage.
-	 * TODO: once CPU_INFO_V2 is used everywhere, use smaller stack for APs and move
-	 * this back to the BSP stack.
-	 */
-	static struct region region_list[SMM_REGIONS_ARRAY_SIZE] = {};
+	struct region region_list[SMM_REGIONS_ARRAY_SIZE] = {};
 
 	struct rmodule smi_handler;
 	if (rmodule_parse(&_binary_smm_start, &smi_handler))
@@ -529,22 +538,29 @@ int smm_load_module(const uintptr_t smram_base, const size_t smram_size,
 		printk(BIOS_ERR, "%s: Error creating CPU map\n", __func__);
 		return -1;
 	}
-	for (unsigned int i = 0; i < params->num_concurrent_save_states; i++) {
-		printk(BIOS_DEBUG, "\nCPU %u\n", i);
-		char string[13];
-		snprintf(string, sizeof(string), "  ss%d", i);
-		if (append_and_check_region(smram, cpus[i].ss, region_list, string))
-			return -1;
-		snprintf(string, sizeof(string), "  stub%d", i);
-		if (append_and_check_region(smram, cpus[i].stub_code, region_list, string))
-			return -1;
-	}
+
+	/*
+	 * smm_create_map() already keeps the stubs and save states of the CPUs apart, so
+	 * only the area spanning all of them has to be checked against the other regions.
+	 * This keeps the check and the log output independent of the number of CPUs.
+	 */
+	const unsigned int last_cpu = params->num_concurrent_save_states - 1;
+	struct region cpu_area = {
+		.offset = region_offset(&cpus[last_cpu].stub_code),
+		.size = stub_segment_base + SMM_CODE_SEGMENT_SIZE
+			- region_offset(&cpus[last_cpu].stub_code),
+	};
+	if (append_and_check_region(smram, cpu_area, region_list, "CPU AREA"))
+		return -1;
+	for (unsigned int i = 0; i <= last_cpu; i++)
+		printk(BIOS_SPEW, "  CPU %-4u ss [0x%zx-0x%zx] stub [0x%zx-0x%zx]\n", i,
+		       region_offset(&cpus[i].ss), region_end(&cpus[i].ss),
+		       region_offset(&cpus[i].stub_code), region_end(&cpus[i].stub_code));
 
 	struct region stacks = {
 		.offset = smram_base,
 		.size = params->num_concurrent_save_states * CONFIG_SMM_MODULE_STACK_SIZE
 	};
-	printk(BIOS_DEBUG, "\n");
 	if (append_and_check_region(smram, stacks, region_list, "stacks"))
 		return -1;
 
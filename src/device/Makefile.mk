@@ -29,6 +29,8 @@ postcar-y += pci_early.c
 ramstage-y += pci_class.c
 ramstage-y += pci_device.c
 ramstage-y += pci_rom.c
+ramstage-$(CONFIG_VGA_ROM_POST_CACHE) += pci_rom_cache.c
+ramstage-$(CONFIG_PCI_SCAN_CACHE) += pci_scan_cache.c
 
 bootblock-y += pci_ops.c
 verstage-y += pci_ops.c
@@ -4,14 +4,18 @@
  * Originally based on the Linux kernel (arch/i386/kernel/pci-pc.c).
  */
 
+#include <cbmem.h>
+#include <commonlib/device_timing_serialized.h>
 #include <console/console.h>
 #include <device/device.h>
 #include <device/pci_def.h>
 #include <device/pci_ids.h>
+#include <device/pciexp.h>
 #include <post.h>
 #include <stdlib.h>
 #include <string.h>
 #include <smp/spinlock.h>
+#include <thread.h>
 #include <timer.h>
 
 /** Pointer to the last device */
@@ -26,6 +30,56 @@ void devfn_disable(const struct bus *bus, unsigned int devfn)
 		dev->enabled = 0;
 }
 
+#if CONFIG(DEVICE_OP_TIMING)
+static struct dev_timing_table *dev_timings;
+
+static void dev_timing_record(const struct device *dev, enum dev_timing_op op, int64_t usecs)
+{
+	struct dev_timing_record *rec;
+	const size_t max = CONFIG_DEVICE_OP_TIMING_ENTRIES;
+
+	if (!dev_timings) {
+		dev_timings = cbmem_add(CBMEM_ID_DEV_TIMING,
+					sizeof(*dev_timings) + max * sizeof(*rec));
+		if (!dev_timings)
+			return;
+		/* The table survives S3 resume, every boot starts a new one. */
+		dev_timings->max_entries = max;
+		dev_timings->num_entries = 0;
+		dev_timings->dropped = 0;
+	}
+
+	if (dev_timings->num_entries >= dev_timings->max_entries) {
+		dev_timings->dropped++;
+		return;
+	}
+
+	rec = &dev_timings->records[dev_timings->num_entries++];
+	memset(rec, 0, sizeof(*rec));
+	strncpy(rec->path, dev_path(dev), sizeof(rec->path) - 1);
+	rec->op = op;
+	rec->usecs = MIN(usecs, (int64_t)UINT32_MAX);
+}
+#else
+static void dev_timing_record(const struct device *dev, enum dev_timing_op op, int64_t usecs) {}
+#endif
+
+/* Call |func| on |dev| and record how long it took with DEVICE_OP_TIMING. */
+static void dev_timed_op(struct device *dev, enum dev_timing_op op,
+			 void (*func)(struct device *dev))
+{
+	struct stopwatch sw;
+
+	if (!CONFIG(DEVICE_OP_TIMING)) {
+		func(dev);
+		return;
+	}
+
+	stopwatch_init(&sw);
+	func(dev);
+	dev_timing_record(dev, op, stopwatch_duration_usecs(&sw));
+}
+
 /**
  * Initialize all chips of statically known devices.
  *
@@ -68,13 +122,32 @@ void dev_finalize_chips(void)
 	}
 }
 
-DECLARE_SPIN_LOCK(dev_lock)
+/*
+ * Independent buses may be scanned at the same time on threads or APs. The children of
+ * a bus are protected by one of a few locks picked by the address of the bus, so only
+ * scans of buses that happen to share a lock serialize. Appending to the global device
+ * list takes dev_list_lock, which is always taken last and only held for the append.
+ */
+#define BUS_LOCKS 16
+
+#if ENV_SUPPORTS_SMP
+static spinlock_t bus_locks[BUS_LOCKS] = {
+	[0 ... BUS_LOCKS - 1] = SPIN_LOCK_UNLOCKED,
+};
+
+static spinlock_t *bus_children_lock(const struct bus *bus)
+{
+	return &bus_locks[((uintptr_t)bus / sizeof(*bus)) % BUS_LOCKS];
+}
+#endif
+
+DECLARE_SPIN_LOCK(dev_list_lock)
 
 /**
  * Allocate a new device structure.
  *
  * Allocate a new device structure and attach it to the device tree as a
- * child of the parent bus.
+ * child of the parent bus. The caller holds the lock of the parent bus.
  *
  * @param parent Parent bus the newly created device should be attached to.
  * @param path Path to the device to be created.
@@ -110,8 +183,10 @@ static struct device *__alloc_dev(struct bus *parent, struct device_path *path)
 	/* Append a new device to the global device list.
 	 * The list is used to find devices once everything is set up.
 	 */
+	spin_lock(&dev_list_lock);
 	last_dev->next = dev;
 	last_dev = dev;
+	spin_unlock(&dev_list_lock);
 
 	return dev;
 }
@@ -119,9 +194,9 @@ static struct device *__alloc_dev(struct bus *parent, struct device_path *path)
 struct device *alloc_dev(struct bus *parent, struct device_path *path)
 {
 	struct device *dev;
-	spin_lock(&dev_lock);
+	spin_lock(bus_children_lock(parent));
 	dev = __alloc_dev(parent, path);
-	spin_unlock(&dev_lock);
+	spin_unlock(bus_children_lock(parent));
 	return dev;
 }
 
@@ -170,11 +245,11 @@ struct bus *alloc_bus(struct device *parent)
 struct device *alloc_find_dev(struct bus *parent, struct device_path *path)
 {
 	struct device *child;
-	spin_lock(&dev_lock);
+	spin_lock(bus_children_lock(parent));
 	child = find_dev_path(parent, path);
 	if (!child)
 		child = __alloc_dev(parent, path);
-	spin_unlock(&dev_lock);
+	spin_unlock(bus_children_lock(parent));
 	return child;
 }
 
@@ -202,7 +277,7 @@ static void read_resources(struct bus *bus)
 			continue;
 		}
 		post_log_path(curdev);
-		curdev->ops->read_resources(curdev);
+		dev_timed_op(curdev, DEV_TIMING_READ_RESOURCES, curdev->ops->read_resources);
 
 		/* Read in the resources behind the current device's links. */
 		if (curdev->downstream)
@@ -312,7 +387,7 @@ void assign_resources(struct bus *bus)
 			continue;
 		}
 		post_log_path(curdev);
-		curdev->ops->set_resources(curdev);
+		dev_timed_op(curdev, DEV_TIMING_SET_RESOURCES, curdev->ops->set_resources);
 	}
 	post_log_clear();
 	printk(BIOS_SPEW, "%s %s, segment group %d bus %d done\n",
@@ -338,7 +413,7 @@ static void enable_resources(struct bus *link)
 	for (dev = link->children; dev; dev = dev->sibling) {
 		if (dev->enabled && dev->ops && dev->ops->enable_resources) {
 			post_log_path(dev);
-			dev->ops->enable_resources(dev);
+			dev_timed_op(dev, DEV_TIMING_ENABLE_RESOURCES, dev->ops->enable_resources);
 		}
 	}
 
@@ -392,7 +467,7 @@ static void scan_bus(struct device *busdev)
 	do_scan_bus = 1;
 	while (do_scan_bus) {
 		struct bus *link = busdev->downstream;
-		busdev->ops->scan_bus(busdev);
+		dev_timed_op(busdev, DEV_TIMING_SCAN_BUS, busdev->ops->scan_bus);
 		do_scan_bus = 0;
 		if (!link || !link->reset_needed)
 			continue;
@@ -459,7 +534,11 @@ void dev_enumerate(void)
 		printk(BIOS_ERR, "dev_root missing scan_bus operation");
 		return;
 	}
+	if (CONFIG(PCIEXP_PLUGIN_SUPPORT))
+		pciexp_defer_tuning();
 	scan_bus(root);
+	if (CONFIG(PCIEXP_PLUGIN_SUPPORT))
+		pciexp_finish_tuning();
 	post_log_clear();
 	printk(BIOS_INFO, "done\n");
 }
@@ -553,7 +632,7 @@ static void init_dev(struct device *dev)
 
 		stopwatch_init(&sw);
 		dev->initialized = 1;
-		dev->ops->init(dev);
+		dev_timed_op(dev, DEV_TIMING_INIT, dev->ops->init);
 
 		init_time = stopwatch_duration_msecs(&sw);
 		printk(BIOS_DEBUG, "%s init finished in %ld msecs\n", dev_path(dev),
@@ -561,6 +640,65 @@ static void init_dev(struct device *dev)
 	}
 }
 
+static void init_link(struct bus *link);
+
+static bool init_is_concurrent(const struct device *dev)
+{
+	return CONFIG(PARALLEL_DEVICE_INIT) && dev->enabled && dev->ops &&
+	       dev->ops->init_concurrent;
+}
+
+static void init_subtree(struct device *dev)
+{
+	init_dev(dev);
+	if (dev->downstream)
+		init_link(dev->downstream);
+}
+
+#if CONFIG(PARALLEL_DEVICE_INIT)
+static struct init_thread {
+	struct thread_handle handle;
+	struct device *dev;
+} init_threads[CONFIG_NUM_THREADS];
+static size_t init_thread_count;
+
+static enum cb_err init_subtree_thread(void *arg)
+{
+	struct init_thread *t = arg;
+
+	init_subtree(t->dev);
+	return CB_SUCCESS;
+}
+
+static void start_init_subtree(struct device *dev)
+{
+	struct init_thread *t;
+
+	if (init_thread_count < ARRAY_SIZE(init_threads)) {
+		t = &init_threads[init_thread_count];
+		t->dev = dev;
+		if (thread_run(&t->handle, init_subtree_thread, t) == 0) {
+			init_thread_count++;
+			return;
+		}
+	}
+
+	/* No thread available, do it right now. */
+	init_subtree(dev);
+}
+
+static void join_init_threads(void)
+{
+	/* Threads may start new threads while we wait, so re-check the count. */
+	for (size_t i = 0; i < init_thread_count; i++)
+		thread_join(&init_threads[i].handle);
+	init_thread_count = 0;
+}
+#else
+static void start_init_subtree(struct device *dev) {}
+static void join_init_threads(void) {}
+#endif
+
 static void init_link(struct bus *link)
 {
 	struct device *dev;
@@ -568,11 +706,14 @@ static void init_link(struct bus *link)
 	for (dev = link->children; dev; dev = dev->sibling) {
 		post_code(POSTCODE_BS_DEV_INIT);
 		post_log_path(dev);
-		init_dev(dev);
+		if (init_is_concurrent(dev))
+			start_init_subtree(dev);
+		else
+			init_dev(dev);
 	}
 
 	for (dev = link->children; dev; dev = dev->sibling)
-		if (dev->downstream)
+		if (dev->downstream && !init_is_concurrent(dev))
 			init_link(dev->downstream);
 }
 
@@ -592,12 +733,52 @@ void dev_initialize(void)
 	/* Now initialize everything. */
 	if (dev_root.downstream)
 		init_link(dev_root.downstream);
+	join_init_threads();
 	post_log_clear();
 
 	printk(BIOS_INFO, "Devices initialized\n");
 	show_all_devs(BIOS_SPEW, "After init.");
 }
 
+static void resume_link(struct bus *link)
+{
+	struct device *dev;
+
+	for (dev = link->children; dev; dev = dev->sibling) {
+		if (!dev->enabled || !dev->ops || !dev->ops->resume)
+			continue;
+		post_code(POSTCODE_BS_DEV_INIT);
+		post_log_path(dev);
+		printk(BIOS_DEBUG, "%s resume\n", dev_path(dev));
+		dev_timed_op(dev, DEV_TIMING_RESUME, dev->ops->resume);
+	}
+
+	for (dev = link->children; dev; dev = dev->sibling)
+		if (dev->enabled && dev->downstream)
+			resume_link(dev->downstream);
+}
+
+/**
+ * Resume the devices in the global device tree on a minimal S3 resume.
+ *
+ * Instead of assigning resources and initializing all devices, only the
+ * resume() methods are called, parents before their children. Everything
+ * else was set up on the boot before the suspend and is restored by the OS.
+ */
+void dev_resume(void)
+{
+	printk(BIOS_INFO, "Resuming devices...\n");
+
+	if (dev_root.ops && dev_root.ops->resume)
+		dev_timed_op(&dev_root, DEV_TIMING_RESUME, dev_root.ops->resume);
+
+	if (dev_root.downstream)
+		resume_link(dev_root.downstream);
+	post_log_clear();
+
+	printk(BIOS_INFO, "Devices resumed\n");
+}
+
 /**
  * Finalize a specific device.
  *
@@ -614,7 +795,7 @@ static void final_dev(struct device *dev)
 
 	if (dev->ops && dev->ops->final) {
 		printk(BIOS_DEBUG, "%s final\n", dev_path(dev));
-		dev->ops->final(dev);
+		dev_timed_op(dev, DEV_TIMING_FINAL, dev->ops->final);
 	}
 }
 
@@ -258,6 +258,19 @@ DEVTREE_CONST struct bus *pci_root_bus(void)
 
 DEVTREE_CONST struct device *pcidev_path_on_root(pci_devfn_t devfn)
 {
+#if !DEVTREE_EARLY
+	/*
+	 * Devices from the devicetree don't need the walk over the bus. Some
+	 * chipsets move root ports to other functions at runtime, so the table
+	 * entry only counts while its path is unchanged.
+	 */
+	if (devfn < pci_root_devfn_table_size) {
+		DEVTREE_CONST struct device *dev = pci_root_devfn_table[devfn];
+
+		if (dev && dev->path.pci.devfn == devfn && dev->upstream == pci_root_bus())
+			return dev;
+	}
+#endif
 	return pcidev_path_behind(pci_root_bus(), devfn);
 }
 
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <bootstate.h>
 #include <commonlib/bsd/helpers.h>
 #include <console/console.h>
 #include <device/device.h>
@@ -9,6 +10,120 @@
 #include <string.h>
 #include <types.h>
 
+/*
+ * Once all devices are initialized, their IDs, classes and APIC IDs stay the
+ * same, so the lookups below can use hash chains instead of walking all
+ * devices. The chains are kept in the order of all_devices and rebuilt when
+ * devices were added since.
+ */
+#define DEV_INDEX_BITS		6
+#define DEV_INDEX_BUCKETS	(1 << DEV_INDEX_BITS)
+
+struct dev_index_node {
+	struct device *dev;
+	struct dev_index_node *next;
+};
+
+struct dev_index {
+	struct dev_index_node *head[DEV_INDEX_BUCKETS];
+	struct dev_index_node *tail[DEV_INDEX_BUCKETS];
+};
+
+static struct dev_index index_by_id, index_by_class, index_by_lapic;
+static struct dev_index_node *index_nodes;
+static const struct device *index_last_dev;
+static bool index_allowed;
+
+static unsigned int dev_index_hash(u32 key)
+{
+	return (key * 0x9e3779b1) >> (32 - DEV_INDEX_BITS);
+}
+
+static u32 dev_id_key(u16 vendor, u16 device)
+{
+	return (u32)vendor << 16 | device;
+}
+
+static void dev_index_add(struct dev_index *index, struct dev_index_node *node,
+			  struct device *dev, u32 key)
+{
+	const unsigned int bucket = dev_index_hash(key);
+
+	node->dev = dev;
+	node->next = NULL;
+	if (index->tail[bucket])
+		index->tail[bucket]->next = node;
+	else
+		index->head[bucket] = node;
+	index->tail[bucket] = node;
+}
+
+static bool dev_index_update(void)
+{
+	extern struct device *last_dev;
+	struct dev_index_node *node;
+	struct device *dev;
+	size_t count = 0;
+
+	if (!index_allowed)
+		return false;
+
+	if (index_nodes && index_last_dev == last_dev)
+		return true;
+
+	for (dev = all_devices; dev; dev = dev->next)
+		count++;
+
+	free(index_nodes);
+	index_nodes = malloc(3 * count * sizeof(*index_nodes));
+	if (!index_nodes)
+		return false;
+
+	memset(&index_by_id, 0, sizeof(index_by_id));
+	memset(&index_by_class, 0, sizeof(index_by_class));
+	memset(&index_by_lapic, 0, sizeof(index_by_lapic));
+
+	node = index_nodes;
+	for (dev = all_devices; dev; dev = dev->next) {
+		dev_index_add(&index_by_id, node++, dev, dev_id_key(dev->vendor, dev->device));
+		dev_index_add(&index_by_class, node++, dev, dev->class >> 8);
+		if (dev->path.type == DEVICE_PATH_APIC)
+			dev_index_add(&index_by_lapic, node++, dev, dev->path.apic.apic_id);
+	}
+
+	index_last_dev = last_dev;
+	return true;
+}
+
+/*
+ * Return the first node of the chain for key that comes after from, or NULL
+ * if from is not on the chain and the caller has to walk all devices.
+ */
+static struct dev_index_node *dev_index_start(const struct dev_index *index, u32 key,
+					      const struct device *from, bool *found)
+{
+	struct dev_index_node *node = index->head[dev_index_hash(key)];
+
+	*found = true;
+	if (!from)
+		return node;
+
+	for (; node; node = node->next) {
+		if (node->dev == from)
+			return node->next;
+	}
+
+	*found = false;
+	return NULL;
+}
+
+static void dev_index_allow(void *unused)
+{
+	index_allowed = true;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_INIT, BS_ON_EXIT, dev_index_allow, NULL);
+
 /**
  * Given a Local APIC ID, find the device structure.
  *
@@ -17,8 +132,19 @@
  */
 struct device *dev_find_lapic(unsigned int apic_id)
 {
+	struct dev_index_node *node;
 	struct device *dev;
 	struct device *result = NULL;
+	bool found;
+
+	if (dev_index_update()) {
+		node = dev_index_start(&index_by_lapic, apic_id, NULL, &found);
+		for (; node; node = node->next) {
+			if (node->dev->path.apic.apic_id == apic_id)
+				return node->dev;
+		}
+		return NULL;
+	}
 
 	for (dev = all_devices; dev; dev = dev->next) {
 		if (dev->path.type == DEVICE_PATH_APIC &&
@@ -42,6 +168,19 @@ struct device *dev_find_lapic(unsigned int apic_id)
  */
 struct device *dev_find_device(u16 vendor, u16 device, struct device *from)
 {
+	struct dev_index_node *node;
+	bool found;
+
+	if (dev_index_update()) {
+		node = dev_index_start(&index_by_id, dev_id_key(vendor, device), from, &found);
+		for (; node; node = node->next) {
+			if (node->dev->vendor == vendor && node->dev->device == device)
+				return node->dev;
+		}
+		if (found)
+			return NULL;
+	}
+
 	if (!from)
 		from = all_devices;
 	else
@@ -64,6 +203,19 @@ struct device *dev_find_device(u16 vendor, u16 device, struct device *from)
  */
 struct device *dev_find_class(unsigned int class, struct device *from)
 {
+	struct dev_index_node *node;
+	bool found;
+
+	if (dev_index_update()) {
+		node = dev_index_start(&index_by_class, class >> 8, from, &found);
+		for (; node; node = node->next) {
+			if ((node->dev->class & 0xffffff00) == class)
+				return node->dev;
+		}
+		if (found)
+			return NULL;
+	}
+
 	if (!from)
 		from = all_devices;
 	else
@@ -16,6 +16,42 @@ bool i2c_dev_detect(struct device *dev, unsigned int addr)
 	return dev->ops->ops_i2c_bus->transfer(dev, &seg, 1) == 0;
 }
 
+unsigned int i2c_dev_bus_caps(struct device *const dev)
+{
+	struct device *const busdev = i2c_busdev(dev);
+	const struct smbus_bus_operations *smbus_ops;
+	unsigned int caps = 0;
+
+	if (!busdev)
+		return 0;
+
+	if (busdev->ops->ops_i2c_bus)
+		return I2C_BUS_CAP_TRANSFER;
+
+	smbus_ops = busdev->ops->ops_smbus_bus;
+	if (smbus_ops->block_read && smbus_ops->block_write)
+		caps |= I2C_BUS_CAP_SMBUS_BLOCK;
+	if (smbus_ops->i2c_block_read)
+		caps |= I2C_BUS_CAP_I2C_BLOCK_READ;
+
+	return caps;
+}
+
+int i2c_dev_transfer(struct device *const dev, const struct i2c_msg *const msgs,
+		     const size_t count)
+{
+	struct device *const busdev = i2c_busdev(dev);
+	if (!busdev)
+		return -1;
+
+	if (!busdev->ops->ops_i2c_bus) {
+		printk(BIOS_ERR, "%s Missing ops_i2c_bus->transfer", dev_path(busdev));
+		return -1;
+	}
+
+	return busdev->ops->ops_i2c_bus->transfer(busdev, msgs, count);
+}
+
 struct bus *i2c_link(const struct device *const dev)
 {
 	if (!dev || !dev->upstream)
@@ -188,6 +224,36 @@ int i2c_dev_read_at16(struct device *const dev, uint8_t *const buf, const size_t
 	}
 }
 
+/* Largest transfer the SMBus controllers do in one block transaction */
+#define SMBUS_BLOCK_LEN	32
+
+static int smbus_dev_read_at(struct device *const dev, const struct smbus_bus_operations *ops,
+			     uint8_t *const buf, const size_t len, const uint8_t off)
+{
+	size_t done = 0;
+	int ret;
+
+	/* Use block transactions as long as the controller manages them. */
+	while (ops->i2c_block_read && done < len) {
+		const u8 chunk = MIN(len - done, SMBUS_BLOCK_LEN);
+
+		if (ops->i2c_block_read(dev, off + done, chunk, buf + done) != chunk)
+			break;
+		done += chunk;
+	}
+
+	for (; done < len; done++) {
+		if (!ops->read_byte)
+			return -1;
+		ret = ops->read_byte(dev, off + done);
+		if (ret < 0)
+			return ret;
+		buf[done] = ret;
+	}
+
+	return len;
+}
+
 int i2c_dev_read_at(struct device *const dev, uint8_t *const buf, const size_t len,
 		      uint8_t off)
 {
@@ -217,6 +283,9 @@ int i2c_dev_read_at(struct device *const dev, uint8_t *const buf, const size_t l
 			return ret;
 		else
 			return len;
+	} else if (busdev->ops->ops_smbus_bus->i2c_block_read ||
+		   busdev->ops->ops_smbus_bus->read_byte) {
+		return smbus_dev_read_at(dev, busdev->ops->ops_smbus_bus, buf, len, off);
 	} else {
 		printk(BIOS_ERR, "%s Missing ops_i2c_bus->transfer", dev_path(busdev));
 		return -1;
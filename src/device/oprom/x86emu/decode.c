@@ -38,9 +38,142 @@
 ****************************************************************************/
 
 #include "x86emui.h"
+#include <string.h>
+#include <timer.h>
 
 /*----------------------------- Implementation ----------------------------*/
 
+/*
+ * Instruction fetch cache. Every instruction byte used to go through
+ * (*sys_rdb), which for YABEL means walking the BAR translation table. The
+ * cache keeps lines of code bytes keyed by their linear address, so hot loops
+ * only pay that once. All emulated writes invalidate the lines they touch and
+ * the whole cache is flushed whenever code outside the emulator ran.
+ */
+#define FETCH_LINE_SHIFT        6
+#define FETCH_LINE_SIZE         (1 << FETCH_LINE_SHIFT)
+#define FETCH_LINES             128
+#define FETCH_LINE_INVALID      0xffffffff
+
+static struct {
+    u32 tag;
+    u8  bytes[FETCH_LINE_SIZE];
+} fetch_cache[FETCH_LINES];
+
+static struct {
+    u32 opcodes[256];
+    u64 instructions;
+    u64 fetch_hits;
+    u64 fetch_misses;
+    struct stopwatch sw;
+    int depth;
+} profile;
+
+void x86emu_fetch_flush(void)
+{
+    int i;
+
+    if (!CONFIG(X86EMU_FETCH_CACHE))
+        return;
+
+    for (i = 0; i < FETCH_LINES; i++)
+        fetch_cache[i].tag = FETCH_LINE_INVALID;
+}
+
+void x86emu_fetch_invalidate(u32 addr, int size)
+{
+    u32 line = addr >> FETCH_LINE_SHIFT;
+    const u32 last = (addr + size - 1) >> FETCH_LINE_SHIFT;
+
+    if (!CONFIG(X86EMU_FETCH_CACHE))
+        return;
+
+    for (; line <= last; line++) {
+        if (fetch_cache[line % FETCH_LINES].tag == line)
+            fetch_cache[line % FETCH_LINES].tag = FETCH_LINE_INVALID;
+    }
+}
+
+static u8 fetch_code_byte(u32 addr)
+{
+    const u32 line = addr >> FETCH_LINE_SHIFT;
+    const u32 base = line << FETCH_LINE_SHIFT;
+    int i;
+
+    if (!CONFIG(X86EMU_FETCH_CACHE))
+        return (*sys_rdb)(addr);
+
+    if (fetch_cache[line % FETCH_LINES].tag == line) {
+        if (CONFIG(X86EMU_PROFILE))
+            profile.fetch_hits++;
+        return fetch_cache[line % FETCH_LINES].bytes[addr & (FETCH_LINE_SIZE - 1)];
+    }
+
+    if (CONFIG(X86EMU_PROFILE))
+        profile.fetch_misses++;
+
+    /* Only cache plain emulator memory, never legacy VGA or remapped BARs. */
+    if (base + FETCH_LINE_SIZE > M.mem_size || (base >= 0xa0000 && base < 0xc0000))
+        return (*sys_rdb)(addr);
+
+    for (i = 0; i < FETCH_LINE_SIZE; i++)
+        fetch_cache[line % FETCH_LINES].bytes[i] = (*sys_rdb)(base + i);
+    fetch_cache[line % FETCH_LINES].tag = line;
+
+    return fetch_cache[line % FETCH_LINES].bytes[addr & (FETCH_LINE_SIZE - 1)];
+}
+
+/****************************************************************************
+RETURNS:
+The next byte of the instruction stream at CS:IP
+
+REMARKS:
+Reads the byte through the fetch cache and moves the instruction pointer to
+the next value.
+****************************************************************************/
+u8 x86emu_fetch_opcode(void)
+{
+    return fetch_code_byte(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+}
+
+static void profile_begin(void)
+{
+    if (profile.depth++)
+        return;
+
+    memset(profile.opcodes, 0, sizeof(profile.opcodes));
+    profile.instructions = 0;
+    profile.fetch_hits = 0;
+    profile.fetch_misses = 0;
+    stopwatch_init(&profile.sw);
+}
+
+static void profile_end(void)
+{
+    u32 counts[256];
+    int i, j, top;
+
+    if (--profile.depth)
+        return;
+
+    printk(BIOS_DEBUG, "x86emu: %llu instructions in %lld us, fetch cache %llu hits, %llu misses\n",
+           profile.instructions, stopwatch_duration_usecs(&profile.sw),
+           profile.fetch_hits, profile.fetch_misses);
+
+    memcpy(counts, profile.opcodes, sizeof(counts));
+    for (i = 0; i < 10; i++) {
+        top = 0;
+        for (j = 1; j < 256; j++) {
+            if (counts[j] > counts[top])
+                top = j;
+        }
+        if (!counts[top])
+            break;
+        printk(BIOS_DEBUG, "x86emu:   opcode %02x: %u\n", top, counts[top]);
+        counts[top] = 0;
+    }
+}
+
 /****************************************************************************
 REMARKS:
 Handles any pending asynchronous interrupts.
@@ -53,6 +186,7 @@ static void x86emu_intr_handle(void)
         intno = M.x86.intno;
         if (_X86EMU_intrTab[intno]) {
             (*_X86EMU_intrTab[intno])(intno);
+            x86emu_fetch_flush();
         } else {
             push_word((u16)M.x86.R_FLG);
             CLEAR_FLAG(F_IF);
@@ -96,6 +230,11 @@ void X86EMU_exec(void)
     M.x86.intr = 0;
     DB(x86emu_end_instr();)
 
+    /* The memory may have been changed from outside of the emulator. */
+    x86emu_fetch_flush();
+    if (CONFIG(X86EMU_PROFILE))
+        profile_begin();
+
     for (;;) {
 DB(     if (CHECK_IP_FETCH())
             x86emu_check_ip_access();)
@@ -112,6 +251,8 @@ DB(             if (M.x86.R_SP != 0) {
                     if (M.x86.debug)
                         printf("Service completed successfully\n");
                     })
+                if (CONFIG(X86EMU_PROFILE))
+                    profile_end();
                 return;
             }
             if (((M.x86.intr & INTR_SYNCH) && (M.x86.intno == 0 || M.x86.intno == 2)) ||
@@ -119,7 +260,11 @@ DB(             if (M.x86.R_SP != 0) {
                 x86emu_intr_handle();
             }
         }
-        op1 = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+        op1 = x86emu_fetch_opcode();
+        if (CONFIG(X86EMU_PROFILE)) {
+            profile.instructions++;
+            profile.opcodes[op1]++;
+        }
         (*x86emu_optab[op1])(op1);
         //if (M.x86.debug & DEBUG_EXIT) {
         //    M.x86.debug &= ~DEBUG_EXIT;
@@ -158,7 +303,7 @@ void fetch_decode_modrm(
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = x86emu_fetch_opcode();
     INC_DECODED_INST_LEN(1);
     *mod  = (fetched >> 6) & 0x03;
     *regh = (fetched >> 3) & 0x07;
@@ -181,7 +326,7 @@ u8 fetch_byte_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = x86emu_fetch_opcode();
     INC_DECODED_INST_LEN(1);
     return fetched;
 }
@@ -202,8 +347,13 @@ u16 fetch_word_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdw)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
-    M.x86.R_IP += 2;
+    if (CONFIG(X86EMU_FETCH_CACHE)) {
+        fetched = x86emu_fetch_opcode();
+        fetched |= x86emu_fetch_opcode() << 8;
+    } else {
+        fetched = (*sys_rdw)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
+        M.x86.R_IP += 2;
+    }
     INC_DECODED_INST_LEN(2);
     return fetched;
 }
@@ -224,8 +374,15 @@ u32 fetch_long_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdl)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
-    M.x86.R_IP += 4;
+    if (CONFIG(X86EMU_FETCH_CACHE)) {
+        fetched = x86emu_fetch_opcode();
+        fetched |= x86emu_fetch_opcode() << 8;
+        fetched |= x86emu_fetch_opcode() << 16;
+        fetched |= (u32)x86emu_fetch_opcode() << 24;
+    } else {
+        fetched = (*sys_rdl)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
+        M.x86.R_IP += 4;
+    }
     INC_DECODED_INST_LEN(4);
     return fetched;
 }
@@ -432,6 +589,7 @@ void store_data_byte(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access((u16)get_data_segment(), offset);
 #endif
+    x86emu_fetch_invalidate((get_data_segment() << 4) + offset, 1);
     (*sys_wrb)((get_data_segment() << 4) + offset, val);
 }
 
@@ -454,6 +612,7 @@ void store_data_word(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access((u16)get_data_segment(), offset);
 #endif
+    x86emu_fetch_invalidate((get_data_segment() << 4) + offset, 2);
     (*sys_wrw)((get_data_segment() << 4) + offset, val);
 }
 
@@ -476,6 +635,7 @@ void store_data_long(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access((u16)get_data_segment(), offset);
 #endif
+    x86emu_fetch_invalidate((get_data_segment() << 4) + offset, 4);
     (*sys_wrl)((get_data_segment() << 4) + offset, val);
 }
 
@@ -499,6 +659,7 @@ void store_data_byte_abs(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access(segment, offset);
 #endif
+    x86emu_fetch_invalidate(((u32)segment << 4) + offset, 1);
     (*sys_wrb)(((u32)segment << 4) + offset, val);
 }
 
@@ -522,6 +683,7 @@ void store_data_word_abs(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access(segment, offset);
 #endif
+    x86emu_fetch_invalidate(((u32)segment << 4) + offset, 2);
     (*sys_wrw)(((u32)segment << 4) + offset, val);
 }
 
@@ -545,6 +707,7 @@ void store_data_long_abs(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access(segment, offset);
 #endif
+    x86emu_fetch_invalidate(((u32)segment << 4) + offset, 4);
     (*sys_wrl)(((u32)segment << 4) + offset, val);
 }
 
@@ -56,6 +56,9 @@ extern "C" {            			/* Use "C" linkage when in C++ mode */
 #endif
 
 void 	x86emu_intr_raise (u8 type);
+void    x86emu_fetch_flush (void);
+void    x86emu_fetch_invalidate (u32 addr, int size);
+u8      x86emu_fetch_opcode (void);
 void    fetch_decode_modrm (int *mod,int *regh,int *regl);
 u8      fetch_byte_imm (void);
 u16     fetch_word_imm (void);
@@ -19,6 +19,7 @@
 #include <device/device.h>
 #include <device/pci.h>
 #include <device/pci_ids.h>
+#include <device/pci_scan_cache.h>
 #include <device/pcix.h>
 #include <device/pciexp.h>
 #include <lib.h>
@@ -914,6 +915,14 @@ void pci_dev_init(struct device *dev)
 	if (rom == NULL)
 		return;
 
+	/* Without pre-OS display, the tables the ROM set up last time are as good. */
+	if (CONFIG(VGA_ROM_POST_CACHE) && !display_init_required() &&
+	    pci_rom_post_cache_restore(dev, rom) == CB_SUCCESS) {
+		printk(BIOS_DEBUG, "VGA Option ROM image restored from cache\n");
+		timestamp_add_now(TS_OPROM_COPY_END);
+		return;
+	}
+
 	ram = pci_rom_load(dev, rom);
 	if (ram == NULL)
 		return;
@@ -927,6 +936,9 @@ void pci_dev_init(struct device *dev)
 
 	run_bios(dev, (unsigned long)ram);
 
+	if (CONFIG(VGA_ROM_POST_CACHE))
+		pci_rom_post_cache_save(dev, rom);
+
 	gfx_set_init_done(1);
 	printk(BIOS_DEBUG, "VGA Option ROM was run\n");
 	timestamp_add_now(TS_OPROM_END);
@@ -1280,6 +1292,8 @@ struct device *pci_probe_dev(struct device *dev, struct bus *bus,
 	dev->vendor = id & 0xffff;
 	dev->device = (id >> 16) & 0xffff;
 	dev->hdr_type = hdr_type;
+	/* A different device may have shown up since the capabilities were read. */
+	dev->ext_caps = NULL;
 
 	/* Class code, the upper 3 bytes of PCI_CLASS_REVISION. */
 	dev->class = class >> 8;
@@ -1428,9 +1442,12 @@ static bool pci_bus_only_one_child(struct bus *bus)
 void pci_scan_bus(struct bus *bus, unsigned int min_devfn,
 			  unsigned int max_devfn)
 {
+	uint32_t present[PCI_SCAN_CACHE_MAP_WORDS] = { 0 };
+	uint32_t cached[PCI_SCAN_CACHE_MAP_WORDS];
 	unsigned int devfn;
 	struct device *dev, **prev;
 	int once = 0;
+	bool use_cache;
 
 	printk(BIOS_DEBUG, "PCI: %s for segment group %02x bus %02x\n", __func__,
 	       bus->segment_group, bus->secondary);
@@ -1448,11 +1465,17 @@ void pci_scan_bus(struct bus *bus, unsigned int min_devfn,
 	if (pci_bus_only_one_child(bus))
 		max_devfn = MIN(max_devfn, 0x07);
 
+	use_cache = pci_scan_cache_lookup(bus, cached);
+
 	/*
 	 * Probe all devices/functions on this bus with some optimization for
 	 * non-existence and single function devices.
 	 */
 	for (devfn = min_devfn; devfn <= max_devfn; devfn++) {
+		/* Functions that weren't there last time can't have appeared. */
+		if (use_cache && !(cached[devfn / 32] & BIT(devfn % 32)))
+			continue;
+
 		if (CONFIG(MINIMAL_PCI_SCANNING)) {
 			dev = pcidev_path_behind(bus, devfn);
 			if (!dev || !dev->mandatory)
@@ -1465,6 +1488,7 @@ void pci_scan_bus(struct bus *bus, unsigned int min_devfn,
 		/* Devices marked 'hidden' do not get probed */
 		if (dev && dev->hidden) {
 			pci_scan_hidden_device(dev);
+			present[devfn / 32] |= BIT(devfn % 32);
 
 			/* Skip pci_probe_dev, go to next devfn */
 			continue;
@@ -1472,6 +1496,8 @@ void pci_scan_bus(struct bus *bus, unsigned int min_devfn,
 
 		/* See if a device is present and setup the device structure. */
 		dev = pci_probe_dev(dev, bus, devfn);
+		if (dev)
+			present[devfn / 32] |= BIT(devfn % 32);
 
 		/*
 		 * If this is not a multi function device, or the device is
@@ -1521,6 +1547,8 @@ void pci_scan_bus(struct bus *bus, unsigned int min_devfn,
 	if (once)
 		printk(BIOS_WARNING, "PCI: Check your devicetree.cb.\n");
 
+	pci_scan_cache_record(bus, present);
+
 	/*
 	 * For all children that implement scan_bus() (i.e. bridges)
 	 * scan the bus behind that child.
@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <commonlib/endian.h>
+#include <commonlib/region.h>
+#include <console/console.h>
+#include <device/device.h>
+#include <device/pci_rom.h>
+#include <fmap.h>
+#include <security/vboot/misc.h>
+#include <security/vboot/vbios_cache_hash_tpm.h>
+#include <string.h>
+#include <types.h>
+#include <vb2_api.h>
+
+/*
+ * The VGA image a ROM leaves behind in the legacy segment after it was run is
+ * kept in the RW_VBIOS_CACHE FMAP region, so boots that don't need pre-OS
+ * display can provide the same tables without running the ROM again. The
+ * header ties the image to the exact ROM that produced it, the image itself
+ * is verified against the hash in the TPM.
+ */
+#define VBIOS_POST_CACHE_FMAP_NAME	"RW_VBIOS_CACHE"
+#define VBIOS_POST_CACHE_SIGNATURE	0x43504256	/* 'VBPC' */
+#define VBIOS_POST_CACHE_MAX_SIZE	(128 * KiB)
+
+struct vbios_post_cache_header {
+	uint32_t signature;
+	uint16_t vendor;
+	uint16_t device;
+	uint32_t image_size;
+	uint8_t rom_hash[VB2_SHA256_DIGEST_SIZE];
+} __packed;
+
+static struct vbios_post_cache_header pending;
+
+static enum cb_err fill_header(const struct device *dev, const struct rom_header *rom,
+			       size_t image_size, struct vbios_post_cache_header *hdr)
+{
+	struct vb2_hash hash;
+
+	if (vb2_hash_calculate(vboot_hwcrypto_allowed(), rom, rom->size * 512,
+			       VB2_HASH_SHA256, &hash))
+		return CB_ERR;
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->signature = VBIOS_POST_CACHE_SIGNATURE;
+	hdr->vendor = dev->vendor;
+	hdr->device = dev->device;
+	hdr->image_size = image_size;
+	memcpy(hdr->rom_hash, hash.sha256, sizeof(hdr->rom_hash));
+
+	return CB_SUCCESS;
+}
+
+enum cb_err pci_rom_post_cache_restore(const struct device *dev, const struct rom_header *rom)
+{
+	extern struct device *vga_pri; /* Primary VGA device (device.c). */
+	struct vbios_post_cache_header hdr, expected;
+	struct region_device rdev;
+	void *const image = (void *)PCI_VGA_RAM_IMAGE_START;
+
+	if (dev != vga_pri)
+		return CB_ERR;
+
+	if (fmap_locate_area_as_rdev(VBIOS_POST_CACHE_FMAP_NAME, &rdev))
+		return CB_ERR;
+
+	if (rdev_readat(&rdev, &hdr, 0, sizeof(hdr)) != sizeof(hdr))
+		return CB_ERR;
+
+	if (hdr.signature != VBIOS_POST_CACHE_SIGNATURE || !hdr.image_size ||
+	    hdr.image_size > VBIOS_POST_CACHE_MAX_SIZE ||
+	    sizeof(hdr) + hdr.image_size > region_device_sz(&rdev))
+		return CB_ERR;
+
+	if (fill_header(dev, rom, hdr.image_size, &expected) != CB_SUCCESS ||
+	    memcmp(&hdr, &expected, sizeof(hdr))) {
+		printk(BIOS_DEBUG, "VBIOS cache was made by a different Option ROM\n");
+		return CB_ERR;
+	}
+
+	if (rdev_readat(&rdev, image, sizeof(hdr), hdr.image_size) != hdr.image_size)
+		return CB_ERR;
+
+	/* The caller loads the ROM again on failure, which overwrites the bad image. */
+	if (vbios_cache_verify_hash(image, hdr.image_size) != CB_SUCCESS) {
+		printk(BIOS_WARNING, "VBIOS cache does not match the TPM hash\n");
+		return CB_ERR;
+	}
+
+	return CB_SUCCESS;
+}
+
+void pci_rom_post_cache_save(const struct device *dev, const struct rom_header *rom)
+{
+	const struct rom_header *image = (void *)PCI_VGA_RAM_IMAGE_START;
+	const size_t image_size = image->size * 512;
+
+	if (read_le16(&image->signature) != PCI_ROM_HDR || !image_size ||
+	    image_size > VBIOS_POST_CACHE_MAX_SIZE)
+		return;
+
+	/* Flash is written later, once the image is final. */
+	if (fill_header(dev, rom, image_size, &pending) != CB_SUCCESS)
+		pending.signature = 0;
+}
+
+static bool cache_is_current(const struct region_device *rdev, const uint8_t *image)
+{
+	struct vbios_post_cache_header hdr;
+	uint8_t buf[512];
+	size_t off;
+
+	if (rdev_readat(rdev, &hdr, 0, sizeof(hdr)) != sizeof(hdr) ||
+	    memcmp(&hdr, &pending, sizeof(hdr)))
+		return false;
+
+	for (off = 0; off < pending.image_size; off += sizeof(buf)) {
+		const size_t len = MIN(sizeof(buf), pending.image_size - off);
+
+		if (rdev_readat(rdev, buf, sizeof(hdr) + off, len) != len ||
+		    memcmp(buf, image + off, len))
+			return false;
+	}
+
+	return vbios_cache_verify_hash(image, pending.image_size) == CB_SUCCESS;
+}
+
+static void write_vbios_post_cache(void *unused)
+{
+	const uint8_t *image = (void *)PCI_VGA_RAM_IMAGE_START;
+	struct region_device rdev;
+	size_t erase_size;
+
+	if (pending.signature != VBIOS_POST_CACHE_SIGNATURE)
+		return;
+
+	if (fmap_locate_area_as_rdev_rw(VBIOS_POST_CACHE_FMAP_NAME, &rdev)) {
+		printk(BIOS_ERR, "%s: No %s FMAP section.\n", __func__,
+		       VBIOS_POST_CACHE_FMAP_NAME);
+		return;
+	}
+
+	if (sizeof(pending) + pending.image_size > region_device_sz(&rdev)) {
+		printk(BIOS_ERR, "%s: VGA image does not fit into %s.\n", __func__,
+		       VBIOS_POST_CACHE_FMAP_NAME);
+		return;
+	}
+
+	if (cache_is_current(&rdev, image)) {
+		printk(BIOS_SPEW, "VBIOS cache is up to date\n");
+		return;
+	}
+
+	erase_size = MIN(ALIGN_UP(sizeof(pending) + pending.image_size, 4 * KiB),
+			 region_device_sz(&rdev));
+	if (rdev_eraseat(&rdev, 0, erase_size) != erase_size ||
+	    rdev_writeat(&rdev, image, sizeof(pending), pending.image_size) !=
+			pending.image_size ||
+	    rdev_writeat(&rdev, &pending, 0, sizeof(pending)) != sizeof(pending)) {
+		printk(BIOS_ERR, "Failed to write VBIOS cache to flash\n");
+		return;
+	}
+
+	vbios_cache_update_hash(image, pending.image_size);
+
+	printk(BIOS_DEBUG, "VBIOS cache updated\n");
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME_CHECK, BS_ON_ENTRY, write_vbios_post_cache, NULL);
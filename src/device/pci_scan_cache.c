@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <acpi/acpi.h>
+#include <bootstate.h>
+#include <console/console.h>
+#include <device/pci_scan_cache.h>
+#include <fmap.h>
+#include <hw_fingerprint.h>
+#include <region_file.h>
+#include <string.h>
+#include <types.h>
+#include <version.h>
+#include <xxhash.h>
+
+#define PCI_SCAN_CACHE_SIGNATURE	(('P'<<0)|('C'<<8)|('I'<<16)|('S'<<24))
+#define PCI_SCAN_CACHE_MAX_BUSES	256
+
+struct pci_scan_cache_bus {
+	uint16_t segment_group;
+	uint16_t secondary;
+	uint32_t map[PCI_SCAN_CACHE_MAP_WORDS];
+} __packed;
+
+struct pci_scan_cache_metadata {
+	uint32_t signature;
+	uint32_t num_buses;
+	/* Hash of the build and the hardware, so a firmware update or a new part starts over. */
+	uint32_t build_hash;
+	uint32_t data_hash;
+} __packed;
+
+struct pci_scan_cache_table {
+	struct pci_scan_cache_metadata md;
+	struct pci_scan_cache_bus buses[PCI_SCAN_CACHE_MAX_BUSES];
+};
+
+static struct pci_scan_cache_table cached, current;
+
+enum cache_state {
+	CACHE_UNREAD,
+	CACHE_VALID,
+	CACHE_INVALID,
+};
+
+static enum cache_state cached_state;
+
+__weak bool pci_scan_cache_allowed(void)
+{
+	return acpi_is_wakeup_s3();
+}
+
+static uint32_t build_hash(void)
+{
+	const uint64_t fingerprint = hw_fingerprint();
+
+	return xxh32(coreboot_build, strlen(coreboot_build),
+		     (uint32_t)(fingerprint ^ fingerprint >> 32));
+}
+
+static size_t table_size(uint32_t num_buses)
+{
+	return sizeof(struct pci_scan_cache_metadata) +
+	       num_buses * sizeof(struct pci_scan_cache_bus);
+}
+
+static bool read_cache(void)
+{
+	struct region_device rdev, data;
+	struct region_file file;
+	struct pci_scan_cache_metadata *md = &cached.md;
+
+	if (fmap_locate_area_as_rdev(CONFIG_PCI_SCAN_CACHE_FMAP_NAME, &rdev) < 0) {
+		printk(BIOS_ERR, "PCI: Scan cache region '%s' not found\n",
+		       CONFIG_PCI_SCAN_CACHE_FMAP_NAME);
+		return false;
+	}
+
+	if (region_file_init(&file, &rdev) < 0 || region_file_data(&file, &data) < 0)
+		return false;
+
+	if (rdev_readat(&data, md, 0, sizeof(*md)) != sizeof(*md) ||
+	    md->signature != PCI_SCAN_CACHE_SIGNATURE ||
+	    md->num_buses > PCI_SCAN_CACHE_MAX_BUSES ||
+	    md->build_hash != build_hash())
+		return false;
+
+	if (table_size(md->num_buses) > region_device_sz(&data) ||
+	    rdev_readat(&data, cached.buses, sizeof(*md), table_size(md->num_buses) - sizeof(*md))
+	    < 0)
+		return false;
+
+	if (xxh32(cached.buses, md->num_buses * sizeof(cached.buses[0]), 0) != md->data_hash)
+		return false;
+
+	printk(BIOS_INFO, "PCI: Using scan cache for %u buses\n", md->num_buses);
+
+	return true;
+}
+
+bool pci_scan_cache_lookup(const struct bus *bus, uint32_t map[PCI_SCAN_CACHE_MAP_WORDS])
+{
+	uint32_t i;
+
+	if (cached_state == CACHE_UNREAD)
+		cached_state = pci_scan_cache_allowed() && read_cache() ?
+			CACHE_VALID : CACHE_INVALID;
+
+	if (cached_state != CACHE_VALID)
+		return false;
+
+	for (i = 0; i < cached.md.num_buses; i++) {
+		if (cached.buses[i].segment_group != bus->segment_group ||
+		    cached.buses[i].secondary != bus->secondary)
+			continue;
+		memcpy(map, cached.buses[i].map, sizeof(cached.buses[i].map));
+		return true;
+	}
+
+	return false;
+}
+
+void pci_scan_cache_record(const struct bus *bus, const uint32_t map[PCI_SCAN_CACHE_MAP_WORDS])
+{
+	struct pci_scan_cache_bus *entry;
+
+	if (current.md.num_buses >= PCI_SCAN_CACHE_MAX_BUSES)
+		return;
+
+	entry = &current.buses[current.md.num_buses++];
+	entry->segment_group = bus->segment_group;
+	entry->secondary = bus->secondary;
+	memcpy(entry->map, map, sizeof(entry->map));
+}
+
+static void pci_scan_cache_update(void *unused)
+{
+	struct region_device rdev;
+	struct region_file file;
+	const size_t size = table_size(current.md.num_buses);
+
+	if (!current.md.num_buses)
+		return;
+
+	current.md.signature = PCI_SCAN_CACHE_SIGNATURE;
+	current.md.build_hash = build_hash();
+	current.md.data_hash = xxh32(current.buses,
+				     current.md.num_buses * sizeof(current.buses[0]), 0);
+
+	if (cached_state == CACHE_VALID && !memcmp(&cached, &current, size))
+		return;
+
+	if (fmap_locate_area_as_rdev_rw(CONFIG_PCI_SCAN_CACHE_FMAP_NAME, &rdev) < 0 ||
+	    region_file_init(&file, &rdev) < 0) {
+		printk(BIOS_ERR, "PCI: Scan cache region unusable\n");
+		return;
+	}
+
+	if (region_file_update_data(&file, &current, size) < 0)
+		printk(BIOS_ERR, "PCI: Failed to update scan cache\n");
+	else
+		printk(BIOS_DEBUG, "PCI: Updated scan cache for %u buses\n",
+		       current.md.num_buses);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_ENUMERATE, BS_ON_EXIT, pci_scan_cache_update, NULL);
@@ -8,6 +8,7 @@
 #include <device/pci_ids.h>
 #include <device/pci_ops.h>
 #include <device/pciexp.h>
+#include <stdlib.h>
 
 static unsigned int ext_cap_id(unsigned int cap)
 {
@@ -19,6 +20,68 @@ static unsigned int ext_cap_next_offset(unsigned int cap)
 	return cap >> 20 & 0xffc;
 }
 
+/*
+ * The extended capabilities of a device in the order they are linked in config space.
+ * Devices with more of them, or with a loop in the list, are walked on every search.
+ */
+#define PCIEXP_MAX_EXT_CAPS	64
+
+struct pciexp_ext_caps {
+	unsigned int count;
+	struct {
+		uint16_t id;
+		uint16_t offset;
+	} caps[];
+};
+
+static const struct pciexp_ext_caps *pciexp_get_ext_caps(const struct device *dev)
+{
+	/* Devices are only const to their users, ramstage has them in RAM. */
+	struct device *const cached = (struct device *)dev;
+	struct pciexp_ext_caps *ext_caps;
+	uint16_t ids[PCIEXP_MAX_EXT_CAPS];
+	uint16_t offsets[PCIEXP_MAX_EXT_CAPS];
+	unsigned int offset = PCIE_EXT_CAP_OFFSET;
+	unsigned int count = 0;
+	unsigned int i;
+
+	if (dev->ext_caps)
+		return dev->ext_caps;
+
+	while (offset >= PCIE_EXT_CAP_OFFSET) {
+		const unsigned int this_cap = pci_read_config32(dev, offset);
+
+		if (this_cap == 0xffffffff) {
+			/* Don't remember anything about a device that doesn't respond (yet). */
+			if (pci_read_config16(dev, PCI_VENDOR_ID) == 0xffff)
+				return NULL;
+			break;
+		}
+
+		if (count == PCIEXP_MAX_EXT_CAPS)
+			return NULL;
+
+		ids[count] = ext_cap_id(this_cap);
+		offsets[count] = offset;
+		count++;
+
+		offset = ext_cap_next_offset(this_cap);
+	}
+
+	ext_caps = malloc(sizeof(*ext_caps) + count * sizeof(ext_caps->caps[0]));
+	if (!ext_caps)
+		return NULL;
+
+	ext_caps->count = count;
+	for (i = 0; i < count; i++) {
+		ext_caps->caps[i].id = ids[i];
+		ext_caps->caps[i].offset = offsets[i];
+	}
+	cached->ext_caps = ext_caps;
+
+	return ext_caps;
+}
+
 static unsigned int find_ext_cap_offset(const struct device *dev, unsigned int cap_id,
 					unsigned int offset)
 {
@@ -53,7 +116,25 @@ static unsigned int find_ext_cap_offset(const struct device *dev, unsigned int c
 unsigned int pciexp_find_extended_cap(const struct device *dev, unsigned int cap,
 				      unsigned int offset)
 {
+	const struct pciexp_ext_caps *ext_caps = pciexp_get_ext_caps(dev);
 	unsigned int next_cap_offset;
+	unsigned int i = 0;
+
+	if (ext_caps && offset) {
+		while (i < ext_caps->count && ext_caps->caps[i].offset != offset)
+			i++;
+		/* Not the offset of a capability, follow whatever is there. */
+		if (i++ == ext_caps->count)
+			ext_caps = NULL;
+	}
+
+	if (ext_caps) {
+		for (; i < ext_caps->count; i++) {
+			if (ext_caps->caps[i].id == cap)
+				return ext_caps->caps[i].offset;
+		}
+		return 0;
+	}
 
 	if (offset)
 		next_cap_offset = ext_cap_next_offset(pci_read_config32(dev, offset));
@@ -177,9 +258,23 @@ static bool pcie_is_endpoint(struct device *dev)
  * Re-train a PCIe link
  */
 #define PCIE_TRAIN_RETRY 10000
-static int pciexp_retrain_link(struct device *dev, unsigned int cap)
+static int pciexp_wait_link_trained(struct device *dev, unsigned int cap)
 {
 	unsigned int try;
+
+	for (try = PCIE_TRAIN_RETRY; try > 0; try--) {
+		if (!(pci_read_config16(dev, cap + PCI_EXP_LNKSTA) & PCI_EXP_LNKSTA_LT))
+			return 0;
+		udelay(100);
+	}
+
+	printk(BIOS_ERR, "%s: Link Retrain timeout\n", dev_path(dev));
+	return -1;
+}
+
+/* Start retraining a link without waiting for it to complete. */
+static int pciexp_start_link_retrain(struct device *dev, unsigned int cap)
+{
 	u16 lnk;
 
 	/*
@@ -189,32 +284,15 @@ static int pciexp_retrain_link(struct device *dev, unsigned int cap)
 	 * This is meant to avoid a race condition when using the
 	 * Retrain Link mechanism.
 	 */
-	for (try = PCIE_TRAIN_RETRY; try > 0; try--) {
-		lnk = pci_read_config16(dev, cap + PCI_EXP_LNKSTA);
-		if (!(lnk & PCI_EXP_LNKSTA_LT))
-			break;
-		udelay(100);
-	}
-	if (try == 0) {
-		printk(BIOS_ERR, "%s: Link Retrain timeout\n", dev_path(dev));
+	if (pciexp_wait_link_trained(dev, cap))
 		return -1;
-	}
 
 	/* Start link retraining */
 	lnk = pci_read_config16(dev, cap + PCI_EXP_LNKCTL);
 	lnk |= PCI_EXP_LNKCTL_RL;
 	pci_write_config16(dev, cap + PCI_EXP_LNKCTL, lnk);
 
-	/* Wait for training to complete */
-	for (try = PCIE_TRAIN_RETRY; try > 0; try--) {
-		lnk = pci_read_config16(dev, cap + PCI_EXP_LNKSTA);
-		if (!(lnk & PCI_EXP_LNKSTA_LT))
-			return 0;
-		udelay(100);
-	}
-
-	printk(BIOS_ERR, "%s: Link Retrain timeout\n", dev_path(dev));
-	return -1;
+	return 0;
 }
 
 static bool pciexp_is_ccc_active(struct device *root, unsigned int root_cap,
@@ -234,16 +312,16 @@ static bool pciexp_is_ccc_active(struct device *root, unsigned int root_cap,
 /*
  * Check the Slot Clock Configuration for root port and endpoint
  * and enable Common Clock Configuration if possible.  If CCC is
- * enabled the link must be retrained.
+ * enabled the link must be retrained, which is only started here.
  */
-static void pciexp_enable_common_clock(struct device *root, unsigned int root_cap,
+static bool pciexp_enable_common_clock(struct device *root, unsigned int root_cap,
 				       struct device *endp, unsigned int endp_cap)
 {
 	u16 root_scc, endp_scc, lnkctl;
 
 	/* No need to enable common clock if it is already active. */
 	if (pciexp_is_ccc_active(root, root_cap, endp, endp_cap))
-		return;
+		return false;
 
 	/* Get Slot Clock Configuration for root port */
 	root_scc = pci_read_config16(root, root_cap + PCI_EXP_LNKSTA);
@@ -268,8 +346,10 @@ static void pciexp_enable_common_clock(struct device *root, unsigned int root_ca
 		pci_write_config16(root, root_cap + PCI_EXP_LNKCTL, lnkctl);
 
 		/* Retrain link if CCC was enabled */
-		pciexp_retrain_link(root, root_cap);
+		return !pciexp_start_link_retrain(root, root_cap);
 	}
+
+	return false;
 }
 
 static void pciexp_enable_clock_power_pm(struct device *endp, unsigned int endp_cap)
@@ -685,22 +765,43 @@ static void clear_lane_error_status(struct device *dev)
 	pci_write_config32(dev, pos + PCI_EXP_SEC_LANE_ERR_STATUS, reg32);
 }
 
-static void pciexp_tune_dev(struct device *dev)
+/*
+ * The part of tuning a device that may need its link to be retrained. Returns true if
+ * retraining was started.
+ */
+static bool pciexp_tune_dev_link(struct device *dev)
 {
 	struct device *root = dev->upstream->dev;
 	unsigned int root_cap, cap;
 
 	cap = pci_find_capability(dev, PCI_CAP_ID_PCIE);
 	if (!cap)
-		return;
+		return false;
 
 	root_cap = pci_find_capability(root, PCI_CAP_ID_PCIE);
 	if (!root_cap)
-		return;
+		return false;
 
 	/* Check for and enable Common Clock */
 	if (CONFIG(PCIEXP_COMMON_CLOCK))
-		pciexp_enable_common_clock(root, root_cap, dev, cap);
+		return pciexp_enable_common_clock(root, root_cap, dev, cap);
+
+	return false;
+}
+
+/* The rest of the tuning, which needs the link to be up again. */
+static void pciexp_tune_dev(struct device *dev)
+{
+	struct device *root = dev->upstream->dev;
+	unsigned int root_cap, cap;
+
+	cap = pci_find_capability(dev, PCI_CAP_ID_PCIE);
+	if (!cap)
+		return;
+
+	root_cap = pci_find_capability(root, PCI_CAP_ID_PCIE);
+	if (!root_cap)
+		return;
 
 	/* Check if per port CLK req is supported by endpoint*/
 	if (CONFIG(PCIEXP_CLK_PM))
@@ -744,31 +845,41 @@ static void pciexp_sync_max_payload_size(struct bus *bus, unsigned int max_paylo
 	}
 }
 
-void pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
-			     unsigned int max_devfn)
+static bool pciexp_is_scanned_child(const struct device *child, unsigned int min_devfn,
+				    unsigned int max_devfn)
 {
-	struct device *child;
-	unsigned int max_payload;
+	return child->path.type == DEVICE_PATH_PCI && child->path.pci.devfn >= min_devfn &&
+	       child->path.pci.devfn <= max_devfn;
+}
 
-	pciexp_enable_ltr(bus->dev);
+/*
+ * Wait for the links between a bus and the root, which tuning this bus or the ones
+ * upstream of it may have started to retrain. This returns right away for links that
+ * aren't in training.
+ */
+static void pciexp_wait_upstream_links(struct bus *bus)
+{
+	struct device *dev;
+	unsigned int cap;
 
-	/*
-	 * Set the Max Payload Size to the maximum supported capability for this bridge.
-	 * This value will be used in pciexp_tune_dev to limit the Max Payload size if needed.
-	 */
-	max_payload = pciexp_dev_get_max_payload_size_cap(bus->dev);
-	pciexp_dev_set_max_payload_size(bus->dev, max_payload);
+	for (dev = bus->dev; dev->path.type == DEVICE_PATH_PCI; dev = dev->upstream->dev) {
+		cap = pci_find_capability(dev, PCI_CAP_ID_PCIE);
+		if (cap)
+			pciexp_wait_link_trained(dev, cap);
+	}
+}
 
-	pci_scan_bus(bus, min_devfn, max_devfn);
+static void pciexp_finish_scan_bus(struct bus *bus, unsigned int min_devfn,
+				   unsigned int max_devfn)
+{
+	struct device *child;
+	unsigned int max_payload;
+
+	pciexp_wait_upstream_links(bus);
 
 	for (child = bus->children; child; child = child->sibling) {
-		if (child->path.type != DEVICE_PATH_PCI)
-			continue;
-		if ((child->path.pci.devfn < min_devfn) ||
-		    (child->path.pci.devfn > max_devfn)) {
-			continue;
-		}
-		pciexp_tune_dev(child);
+		if (pciexp_is_scanned_child(child, min_devfn, max_devfn))
+			pciexp_tune_dev(child);
 	}
 
 	/*
@@ -789,6 +900,95 @@ void pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
 	}
 }
 
+/*
+ * Buses whose tuning waits for links that are retraining. They are finished in the order
+ * they were scanned, so a bus is always done before the ones upstream of it.
+ */
+struct pciexp_deferred_bus {
+	struct bus *bus;
+	unsigned int min_devfn;
+	unsigned int max_devfn;
+	struct pciexp_deferred_bus *next;
+};
+
+static bool defer_tuning;
+static struct pciexp_deferred_bus *deferred_head;
+static struct pciexp_deferred_bus **deferred_tail = &deferred_head;
+
+static bool pciexp_defer_scan_bus(struct bus *bus, unsigned int min_devfn,
+				  unsigned int max_devfn)
+{
+	struct pciexp_deferred_bus *d;
+
+	if (!defer_tuning)
+		return false;
+
+	d = malloc(sizeof(*d));
+	if (!d)
+		return false;
+
+	d->bus = bus;
+	d->min_devfn = min_devfn;
+	d->max_devfn = max_devfn;
+	d->next = NULL;
+	*deferred_tail = d;
+	deferred_tail = &d->next;
+
+	return true;
+}
+
+void pciexp_defer_tuning(void)
+{
+	defer_tuning = true;
+}
+
+void pciexp_finish_tuning(void)
+{
+	struct pciexp_deferred_bus *d;
+
+	defer_tuning = false;
+
+	while ((d = deferred_head)) {
+		deferred_head = d->next;
+		pciexp_finish_scan_bus(d->bus, d->min_devfn, d->max_devfn);
+		free(d);
+	}
+	deferred_tail = &deferred_head;
+}
+
+void pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
+			     unsigned int max_devfn)
+{
+	bool retraining = false;
+	struct device *child;
+	unsigned int max_payload;
+
+	pciexp_enable_ltr(bus->dev);
+
+	/*
+	 * Set the Max Payload Size to the maximum supported capability for this bridge.
+	 * This value will be used in pciexp_tune_dev to limit the Max Payload size if needed.
+	 */
+	max_payload = pciexp_dev_get_max_payload_size_cap(bus->dev);
+	pciexp_dev_set_max_payload_size(bus->dev, max_payload);
+
+	pci_scan_bus(bus, min_devfn, max_devfn);
+
+	/* Links train in parallel, so start retraining all of them before waiting for any. */
+	for (child = bus->children; child; child = child->sibling) {
+		if (!pciexp_is_scanned_child(child, min_devfn, max_devfn))
+			continue;
+		/* The functions of a device share its link, which has to be up to reach them. */
+		if (retraining)
+			pciexp_wait_link_trained(bus->dev,
+						 pci_find_capability(bus->dev, PCI_CAP_ID_PCIE));
+		retraining = pciexp_tune_dev_link(child);
+	}
+
+	if (!pciexp_defer_scan_bus(bus, min_devfn, max_devfn))
+		pciexp_finish_scan_bus(bus, min_devfn, max_devfn);
+}
+
 void pciexp_scan_bridge(struct device *dev)
 {
 	do_pci_scan_bridge(dev, pciexp_scan_bus);
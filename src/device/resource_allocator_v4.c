@@ -7,6 +7,22 @@
 #include <post.h>
 #include <types.h>
 
+#if CONFIG(RESOURCE_ALLOCATOR_PARALLEL_DOMAINS)
+#include <arch/cpu.h>
+#include <cpu/x86/mp.h>
+#include <smp/atomic.h>
+#include <smp/spinlock.h>
+#include <stdlib.h>
+#include <timer.h>
+#endif
+
+/*
+ * Set while domains are allocated in parallel. The per-resource output is
+ * skipped then, since dev_path() isn't reentrant and interleaved lines from
+ * several CPUs wouldn't be readable anyway. A summary is printed afterwards.
+ */
+static bool allocator_quiet;
+
 static const char *resource2str(const struct resource *res)
 {
 	if (res->flags & IORESOURCE_IO)
@@ -21,6 +37,9 @@ static const char *resource2str(const struct resource *res)
 static void print_domain_res(const struct device *dev,
 			     const struct resource *res, const char *suffix)
 {
+	if (allocator_quiet)
+		return;
+
 	printk(BIOS_DEBUG, "%s %s: base: %llx size: %llx align: %u gran: %u limit: %llx%s\n",
 	       dev_path(dev), resource2str(res), res->base, res->size,
 	       res->align, res->gran, res->limit, suffix);
@@ -31,12 +50,18 @@ static void print_domain_res(const struct device *dev,
 static void print_bridge_res(const struct device *dev, const struct resource *res,
 			     int depth, const char *suffix)
 {
+	if (allocator_quiet)
+		return;
+
 	res_printk(depth, "%s %s: size: %llx align: %u gran: %u limit: %llx%s\n", dev_path(dev),
 		   resource2str(res), res->size, res->align, res->gran, res->limit, suffix);
 }
 
 static void print_child_res(const struct device *dev, const struct resource *res, int depth)
 {
+	if (allocator_quiet)
+		return;
+
 	res_printk(depth + 1, "%s %02lx *  [0x%llx - 0x%llx] %s\n", dev_path(dev),
 		   res->index, res->base, res->base + res->size - 1, resource2str(res));
 }
@@ -44,6 +69,9 @@ static void print_child_res(const struct device *dev, const struct resource *res
 static void print_fixed_res(const struct device *dev,
 			    const struct resource *res, const char *prefix)
 {
+	if (allocator_quiet)
+		return;
+
 	printk(BIOS_DEBUG, " %s: %s %02lx base %08llx limit %08llx %s (fixed)\n",
 	       prefix, dev_path(dev), res->index, res->base, res->base + res->size - 1,
 	       resource2str(res));
@@ -51,18 +79,27 @@ static void print_fixed_res(const struct device *dev,
 
 static void print_assigned_res(const struct device *dev, const struct resource *res)
 {
+	if (allocator_quiet)
+		return;
+
 	printk(BIOS_DEBUG, "  %s %02lx *  [0x%llx - 0x%llx] limit: %llx %s\n",
 	       dev_path(dev), res->index, res->base, res->limit, res->limit, resource2str(res));
 }
 
 static void print_failed_res(const struct device *dev, const struct resource *res)
 {
+	if (allocator_quiet)
+		return;
+
 	printk(BIOS_DEBUG, "  %s %02lx *  size: 0x%llx limit: %llx %s\n",
 	       dev_path(dev), res->index, res->size, res->limit, resource2str(res));
 }
 
 static void print_resource_ranges(const struct device *dev, const struct memranges *ranges)
 {
+	if (allocator_quiet)
+		return;
+
 	const struct range_entry *r;
 
 	printk(BIOS_INFO, " %s: Resource ranges:\n", dev_path(dev));
@@ -316,14 +353,15 @@ static void avoid_fixed_resources(struct memranges *ranges, const struct device
  */
 static void setup_resource_ranges(const struct device *const domain,
 				  const unsigned long type,
-				  struct memranges *const ranges)
+				  struct memranges *const ranges,
+				  struct range_entry *const pool, const size_t pool_size)
 {
 	/* Align mem resources to 2^12 (4KiB pages) at a minimum, so they
 	   can be memory-mapped individually (e.g. for virtualization guests). */
 	const unsigned char alignment = type == IORESOURCE_MEM ? 12 : 0;
 	const unsigned long type_mask = IORESOURCE_TYPE_MASK | IORESOURCE_FIXED;
 
-	memranges_init_empty_with_alignment(ranges, NULL, 0, alignment);
+	memranges_init_empty_with_alignment(ranges, pool, pool_size, alignment);
 
 	for (struct resource *res = domain->resource_list; res != NULL; res = res->next) {
 		if ((res->flags & type_mask) != type)
@@ -384,7 +422,8 @@ static void assign_resource(struct resource *const res, const resource_t base,
  * domain's resource window.
  */
 static void allocate_toplevel_resources(const struct device *const domain,
-					const unsigned long type)
+					const unsigned long type,
+					struct range_entry *const pool, const size_t pool_size)
 {
 	const unsigned long type_mask = IORESOURCE_TYPE_MASK;
 	struct resource *res = NULL;
@@ -395,7 +434,7 @@ static void allocate_toplevel_resources(const struct device *const domain,
 	if (!dev_has_children(domain))
 		return;
 
-	setup_resource_ranges(domain, type, &ranges);
+	setup_resource_ranges(domain, type, &ranges, pool, pool_size);
 
 	while ((dev = largest_resource(domain->downstream, &res, type_mask, type))) {
 		if (!res->size)
@@ -403,7 +442,8 @@ static void allocate_toplevel_resources(const struct device *const domain,
 
 		if (!memranges_steal(&ranges, effective_limit(res), res->size, res->align,
 				     type, &base, CONFIG(RESOURCE_ALLOCATION_TOP_DOWN))) {
-			printk(BIOS_ERR, "Resource didn't fit!!!\n");
+			if (!allocator_quiet)
+				printk(BIOS_ERR, "Resource didn't fit!!!\n");
 			print_failed_res(dev, res);
 			continue;
 		}
@@ -478,10 +518,11 @@ static void allocate_bridge_resources(const struct device *bridge)
  * it walks down each downstream bridge to finish resource assignment
  * of its children resources within its own window.
  */
-static void allocate_domain_resources(const struct device *domain)
+static void allocate_domain_resources(const struct device *domain,
+				      struct range_entry *pool, size_t pool_size)
 {
 	/* Resource type I/O */
-	allocate_toplevel_resources(domain, IORESOURCE_IO);
+	allocate_toplevel_resources(domain, IORESOURCE_IO, pool, pool_size);
 
 	/*
 	 * Resource type Mem:
@@ -490,7 +531,7 @@ static void allocate_domain_resources(const struct device *domain)
 	 * together when finding the best fit based on the biggest resource
 	 * requirement.
 	 */
-	allocate_toplevel_resources(domain, IORESOURCE_MEM);
+	allocate_toplevel_resources(domain, IORESOURCE_MEM, pool, pool_size);
 
 	struct device *child;
 	for (child = domain->downstream->children; child; child = child->sibling) {
@@ -502,6 +543,169 @@ static void allocate_domain_resources(const struct device *domain)
 	}
 }
 
+#if CONFIG(RESOURCE_ALLOCATOR_PARALLEL_DOMAINS)
+struct domain_job {
+	const struct device *domain;
+	struct range_entry *pool;
+	size_t pool_size;
+};
+
+/*
+ * Static, so that an AP accepting the work late can't access a stale stack
+ * frame after the BSP already finished all jobs.
+ */
+static struct {
+	struct domain_job *jobs;
+	int count;
+	int next;
+	atomic_t done;
+} domain_queue;
+
+DECLARE_SPIN_LOCK(domain_queue_lock)
+
+/*
+ * Every resource of the sub-tree can add at most one range entry, by either
+ * being a window, punching a hole or splitting a range when it's allocated.
+ * Providing that many entries up front keeps the workers off the heap.
+ */
+static size_t count_resources(const struct device *dev)
+{
+	const struct resource *res;
+	const struct device *child;
+	size_t count = 0;
+
+	for (res = dev->resource_list; res; res = res->next)
+		count++;
+
+	if (dev->downstream)
+		for (child = dev->downstream->children; child; child = child->sibling)
+			count += count_resources(child);
+
+	return count;
+}
+
+/* Runs on the BSP and all APs: keep taking domains until there are none left. */
+static void domain_worker(void *unused)
+{
+	while (1) {
+		struct domain_job *job = NULL;
+
+		spin_lock(&domain_queue_lock);
+		if (domain_queue.next < domain_queue.count)
+			job = &domain_queue.jobs[domain_queue.next++];
+		spin_unlock(&domain_queue_lock);
+
+		if (!job)
+			return;
+
+		compute_domain_resources(job->domain);
+		allocate_domain_resources(job->domain, job->pool, job->pool_size);
+		atomic_inc(&domain_queue.done);
+	}
+}
+
+static void print_allocation_summary(const struct device *dev)
+{
+	const struct resource *res;
+	const struct device *child;
+
+	for (res = dev->resource_list; res; res = res->next) {
+		if (!res->size || (res->flags & IORESOURCE_FIXED))
+			continue;
+		if (res->flags & IORESOURCE_ASSIGNED) {
+			print_assigned_res(dev, res);
+		} else if (res->limit) {
+			printk(BIOS_ERR, "Resource didn't fit!!!\n");
+			print_failed_res(dev, res);
+		}
+	}
+
+	if (dev->downstream)
+		for (child = dev->downstream->children; child; child = child->sibling)
+			print_allocation_summary(child);
+}
+
+/* The heap can only release the most recent allocation, so free in reverse order. */
+static void free_domain_queue(int count)
+{
+	while (count--)
+		free(domain_queue.jobs[count].pool);
+	free(domain_queue.jobs);
+	domain_queue.jobs = NULL;
+}
+
+/*
+ * Domains don't share any windows, and each domain is still handled by the
+ * same serial code on a single CPU, so the result is identical to the serial
+ * path. Returns false if the domains have to be allocated serially instead.
+ */
+static bool allocate_domains_parallel(const struct device *root)
+{
+	const struct device *child;
+	struct domain_job *job;
+	int count = 0, i;
+
+	for (child = root->downstream->children; child; child = child->sibling)
+		if (child->path.type == DEVICE_PATH_DOMAIN)
+			count++;
+
+	if (count < 2)
+		return false;
+
+	domain_queue.jobs = calloc(count, sizeof(*domain_queue.jobs));
+	if (!domain_queue.jobs)
+		return false;
+
+	i = 0;
+	for (child = root->downstream->children; child; child = child->sibling) {
+		if (child->path.type != DEVICE_PATH_DOMAIN)
+			continue;
+		job = &domain_queue.jobs[i];
+		job->domain = child;
+		job->pool_size = count_resources(child) + 2;
+		job->pool = malloc(job->pool_size * sizeof(*job->pool));
+		if (!job->pool) {
+			free_domain_queue(i);
+			return false;
+		}
+		i++;
+	}
+
+	printk(BIOS_INFO, "=== Resource allocator: %d domains in parallel ===\n", count);
+
+	domain_queue.count = count;
+	domain_queue.next = 0;
+	atomic_set(&domain_queue.done, 0);
+	allocator_quiet = true;
+
+	/* If the APs don't pick up the work the BSP just does all of it by itself. */
+	mp_run_on_all_aps(domain_worker, NULL, 100 * USECS_PER_MSEC, true);
+	domain_worker(NULL);
+
+	while (atomic_read(&domain_queue.done) < domain_queue.count)
+		cpu_relax();
+
+	allocator_quiet = false;
+
+	for (i = 0; i < count; i++) {
+		job = &domain_queue.jobs[i];
+		printk(BIOS_INFO,
+		       "=== Resource allocator: %s - resource allocation complete ===\n",
+		       dev_path(job->domain));
+		print_allocation_summary(job->domain);
+	}
+
+	free_domain_queue(count);
+
+	return true;
+}
+#else
+static bool allocate_domains_parallel(const struct device *root)
+{
+	return false;
+}
+#endif
+
 /*
  * This function forms the guts of the resource allocator. It walks
  * through the entire device tree for each domain two times.
@@ -553,6 +757,9 @@ void allocate_resources(const struct device *root)
 	if ((root == NULL) || (root->downstream == NULL))
 		return;
 
+	if (allocate_domains_parallel(root))
+		return;
+
 	for (child = root->downstream->children; child; child = child->sibling) {
 		if (child->path.type != DEVICE_PATH_DOMAIN)
 			continue;
@@ -567,7 +774,7 @@ void allocate_resources(const struct device *root)
 		/* Pass 2 - Allocate resources as per gathered requirements. */
 		printk(BIOS_INFO, "=== Resource allocator: %s - Pass 2 (allocating resources) ===\n",
 		       dev_path(child));
-		allocate_domain_resources(child);
+		allocate_domain_resources(child, NULL, 0);
 
 		printk(BIOS_INFO, "=== Resource allocator: %s - resource allocation complete ===\n",
 		       dev_path(child));
@@ -11,6 +11,7 @@
 #include <elog.h>
 #include <fmap.h>
 #include <lib.h>
+#include <nv_write_queue.h>
 #include <post.h>
 #include <rtc.h>
 #include <smbios.h>
@@ -51,6 +52,9 @@ struct elog_state {
 	struct region_device mirror_dev;
 
 	enum elog_init_state elog_initialized;
+
+	/* CBMEM copy of the mirror that later stages pick up, if any. */
+	struct elog_handoff *handoff;
 };
 
 static struct elog_state elog_state;
@@ -58,6 +62,17 @@ static struct elog_state elog_state;
 #define ELOG_SIZE (4 * KiB)
 static uint8_t elog_mirror_buf[ELOG_SIZE];
 
+/*
+ * The mirror and its tail as left behind by the stage that created CBMEM.
+ * A later stage that finds a valid handoff uses it in place of reading and
+ * scanning the flash again. A size of 0 marks the handoff invalid.
+ */
+struct elog_handoff {
+	uint32_t size;
+	uint32_t last_write;
+	uint8_t mirror[ELOG_SIZE];
+};
+
 static inline struct region_device *mirror_dev_get(void)
 {
 	return &elog_state.mirror_dev;
@@ -691,6 +706,103 @@ static int elog_sync_to_nv(void)
 	return 0;
 }
 
+/*
+ * Record the current tail in the handoff. Called after every update of the
+ * mirror while it lives in CBMEM.
+ */
+static void elog_handoff_update(void)
+{
+	struct elog_handoff *handoff = elog_state.handoff;
+
+	if (!handoff)
+		return;
+
+	if (elog_state.elog_initialized == ELOG_INITIALIZED) {
+		handoff->size = region_device_sz(&elog_state.nv_dev);
+		handoff->last_write = elog_state.mirror_last_write;
+	} else {
+		handoff->size = 0;
+	}
+}
+
+/*
+ * Use the mirror handed off by an earlier stage. Returns false if there is
+ * none, in which case the flash has to be scanned.
+ */
+static bool elog_handoff_restore(size_t elog_size)
+{
+	struct elog_handoff *handoff;
+
+	if (!CONFIG(ELOG_HANDOFF) || !ENV_HAS_CBMEM || ENV_CREATES_CBMEM)
+		return false;
+
+	handoff = cbmem_find(CBMEM_ID_ELOG_HANDOFF);
+	if (!handoff)
+		return false;
+
+	if (handoff->size != elog_size || handoff->last_write < elog_events_start() ||
+	    handoff->last_write > elog_size) {
+		printk(BIOS_WARNING, "ELOG: Ignoring invalid handoff\n");
+		return false;
+	}
+
+	rdev_chain_mem_rw(&elog_state.mirror_dev, handoff->mirror, elog_size);
+	elog_state.mirror_last_write = handoff->last_write;
+	elog_state.nv_last_write = handoff->last_write;
+	elog_state.handoff = handoff;
+
+	elog_debug("ELOG: using handoff, last write 0x%x\n", handoff->last_write);
+
+	return true;
+}
+
+/*
+ * Move the mirror into CBMEM once it comes up, so the following stages
+ * don't have to read and scan the flash again.
+ */
+static void elog_handoff_publish(int is_recovery)
+{
+	const struct cbmem_entry *entry;
+	struct elog_handoff *handoff;
+	size_t elog_size;
+
+	if (!CONFIG(ELOG_HANDOFF))
+		return;
+
+	if (elog_init() < 0) {
+		/* Don't leave a stale handoff from before S3 suspend around. */
+		entry = cbmem_entry_find(CBMEM_ID_ELOG_HANDOFF);
+		if (entry)
+			cbmem_entry_remove(entry);
+		return;
+	}
+
+	handoff = cbmem_add(CBMEM_ID_ELOG_HANDOFF, sizeof(*handoff));
+	if (!handoff)
+		return;
+
+	elog_size = region_device_sz(&elog_state.nv_dev);
+	if (rdev_readat(mirror_dev_get(), handoff->mirror, 0, elog_size) != elog_size) {
+		handoff->size = 0;
+		return;
+	}
+
+	rdev_chain_mem_rw(&elog_state.mirror_dev, handoff->mirror, elog_size);
+	elog_state.handoff = handoff;
+	elog_handoff_update();
+}
+CBMEM_CREATION_HOOK(elog_handoff_publish);
+
+static void elog_deferred_sync(void *unused)
+{
+	elog_sync_to_nv();
+}
+
+static struct nv_write elog_nv_update = {
+	.name = "ELOG",
+	.commit = elog_deferred_sync,
+};
+
 /*
  * Do not log boot count events in S3 resume or SMM.
  */
@@ -760,19 +872,24 @@ int elog_init(void)
 		return -1;
 
 	elog_size = region_device_sz(&elog_state.nv_dev);
-	mirror_buffer = elog_mirror_buf;
-	rdev_chain_mem_rw(&elog_state.mirror_dev, mirror_buffer, elog_size);
 
-	/*
-	 * Mark as initialized to allow elog_init() to be called and deemed
-	 * successful in the prepare/shrink path which adds events.
-	 */
-	elog_state.elog_initialized = ELOG_INITIALIZED;
-
-	/* Load the log from flash and prepare the flash if necessary. */
-	if (elog_scan_flash() < 0 && elog_prepare_empty() < 0) {
-		printk(BIOS_ERR, "ELOG: Unable to prepare flash\n");
-		return -1;
+	if (elog_handoff_restore(elog_size)) {
+		elog_state.elog_initialized = ELOG_INITIALIZED;
+	} else {
+		mirror_buffer = elog_mirror_buf;
+		rdev_chain_mem_rw(&elog_state.mirror_dev, mirror_buffer, elog_size);
+
+		/*
+		 * Mark as initialized to allow elog_init() to be called and deemed
+		 * successful in the prepare/shrink path which adds events.
+		 */
+		elog_state.elog_initialized = ELOG_INITIALIZED;
+
+		/* Load the log from flash and prepare the flash if necessary. */
+		if (elog_scan_flash() < 0 && elog_prepare_empty() < 0) {
+			printk(BIOS_ERR, "ELOG: Unable to prepare flash\n");
+			return -1;
+		}
 	}
 
 	printk(BIOS_INFO, "ELOG: area is %zu bytes, full threshold %d,"
@@ -788,10 +905,7 @@ int elog_init(void)
 	return 0;
 }
 
-/*
- * Add an event to the log
- */
-int elog_add_event_raw(u8 event_type, void *data, u8 data_size)
+static int elog_add_event_to_mirror(u8 event_type, void *data, u8 data_size)
 {
 	struct event_header *event;
 	struct rtc_time time = { 0 };
@@ -852,10 +966,26 @@ int elog_add_event_raw(u8 event_type, void *data, u8 data_size)
 	if (elog_shrink() < 0)
 		return -1;
 
+	/* The mirror keeps the event until a deferred sync commits it. */
+	if (nv_write_defer(&elog_nv_update))
+		return 0;
+
 	/* Ensure the updates hit the non-volatile storage. */
 	return elog_sync_to_nv();
 }
 
+/*
+ * Add an event to the log
+ */
+int elog_add_event_raw(u8 event_type, void *data, u8 data_size)
+{
+	int ret = elog_add_event_to_mirror(event_type, data, data_size);
+
+	elog_handoff_update();
+
+	return ret;
+}
+
 int elog_add_event(u8 event_type)
 {
 	return elog_add_event_raw(event_type, NULL, 0);
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <console/console.h>
+#include <cpu/x86/smm.h>
 #include <elog.h>
 #include <stdint.h>
 
@@ -13,6 +14,7 @@
 #define GSMI_CMD_LOG_S0IX_SUSPEND	0x0a
 #define GSMI_CMD_LOG_S0IX_RESUME	0x0b
 #define GSMI_CMD_HANDSHAKE_TYPE		0xc1
+#define GSMI_CMD_GET_SMI_HISTOGRAM	0xd0
 
 #define GSMI_HANDSHAKE_NONE		0x7f
 #define GSMI_LOG_ENTRY_TYPE_KERNEL	0xDEAD
@@ -33,6 +35,11 @@ struct gsmi_clear_eventlog_param {
 	u32 data_type;
 } __packed;
 
+struct gsmi_get_histogram_param {
+	u32 data_ptr;
+	u32 data_len;
+} __packed;
+
 void __weak elog_gsmi_cb_platform_log_wake_source(void)
 {
 	/* Default weak implementation, does nothing. */
@@ -49,6 +56,7 @@ u32 gsmi_exec(u8 command, u32 *param)
 	struct gsmi_set_eventlog_param *sel;
 	struct gsmi_set_eventlog_type1 *type1;
 	struct gsmi_clear_eventlog_param *cel;
+	struct gsmi_get_histogram_param *ghp;
 	u32 ret = GSMI_RET_UNSUPPORTED;
 
 	switch (command) {
@@ -115,6 +123,24 @@ u32 gsmi_exec(u8 command, u32 *param)
 		}
 		break;
 
+	case GSMI_CMD_GET_SMI_HISTOGRAM:
+		if (!CONFIG(SMM_LATENCY_HISTOGRAM))
+			break;
+
+		ghp = (struct gsmi_get_histogram_param *)(uintptr_t)(*param);
+		if (!ghp || smm_points_to_smram(ghp, sizeof(*ghp))) {
+			ret = GSMI_RET_INVALID_PARAMETER;
+			break;
+		}
+
+		if (smm_latency_histogram_read((void *)(uintptr_t)ghp->data_ptr,
+					       ghp->data_len) < 0) {
+			ret = GSMI_RET_INVALID_PARAMETER;
+			break;
+		}
+		ret = GSMI_RET_SUCCESS;
+		break;
+
 	default:
 		printk(BIOS_DEBUG, "GSMI Unknown: 0x%02x\n", command);
 		break;
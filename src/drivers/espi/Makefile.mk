@@ -0,0 +1,7 @@
+## SPDX-License-Identifier: GPL-2.0-only
+
+bootblock-$(CONFIG_CONSOLE_ESPI) += console.c
+verstage-$(CONFIG_CONSOLE_ESPI) += console.c
+romstage-$(CONFIG_CONSOLE_ESPI) += console.c
+postcar-$(CONFIG_CONSOLE_ESPI) += console.c
+ramstage-$(CONFIG_CONSOLE_ESPI) += console.c
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/helpers.h>
+#include <console/espi.h>
+#include <device/mmio.h>
+#include <string.h>
+#include <types.h>
+
+#if CONFIG(SOC_AMD_COMMON_BLOCK_USE_ESPI)
+#include <amdblocks/espi.h>
+#endif
+
+/*
+ * Console in a memory window that the eSPI peripheral channel decodes to the EC or
+ * BMC. Output is collected in a small buffer and goes out as 32-bit memory writes,
+ * each of them a single eSPI transaction, instead of one slow transaction per byte.
+ * Nothing ever waits for the other side: when the ring is full, output is dropped.
+ */
+
+#define ESPI_CONSOLE_BUF_SIZE	64
+
+#define WINDOW_BASE		((uintptr_t)CONFIG_CONSOLE_ESPI_MMIO_BASE)
+#define RING_SIZE		ALIGN_DOWN(CONFIG_CONSOLE_ESPI_MMIO_SIZE - \
+					   sizeof(struct espi_console_header), 4)
+
+_Static_assert(CONFIG_CONSOLE_ESPI_MMIO_SIZE > sizeof(struct espi_console_header),
+	       "eSPI console window too small");
+
+static struct {
+	bool ready;
+	uint32_t head;
+	size_t fill;
+	union {
+		uint8_t bytes[ESPI_CONSOLE_BUF_SIZE];
+		uint32_t dwords[ESPI_CONSOLE_BUF_SIZE / 4];
+	} buf;
+} espic;
+
+static struct espi_console_header *const hdr = (void *)WINDOW_BASE;
+static uint32_t *const ring = (void *)(WINDOW_BASE + sizeof(struct espi_console_header));
+
+void espi_console_init(void)
+{
+	if (!WINDOW_BASE)
+		return;
+
+#if CONFIG(SOC_AMD_COMMON_BLOCK_USE_ESPI)
+	if (espi_open_mmio_window(WINDOW_BASE, CONFIG_CONSOLE_ESPI_MMIO_SIZE) != CB_SUCCESS)
+		return;
+#endif
+
+	/* An earlier stage may have set up the ring already, continue where it left. */
+	espic.head = read32(&hdr->head);
+	if (read32(&hdr->signature) != ESPI_CONSOLE_SIGNATURE ||
+	    read32(&hdr->size) != RING_SIZE || espic.head >= RING_SIZE || espic.head % 4) {
+		write32(&hdr->size, RING_SIZE);
+		write32(&hdr->head, 0);
+		write32(&hdr->tail, 0);
+		write32(&hdr->signature, ESPI_CONSOLE_SIGNATURE);
+		espic.head = 0;
+	}
+
+	/* Reads return all ones when nothing answers on the other end. */
+	if (read32(&hdr->signature) != ESPI_CONSOLE_SIGNATURE)
+		return;
+
+	espic.fill = 0;
+	espic.ready = true;
+}
+
+void espi_console_tx_flush(void)
+{
+	const size_t len = ALIGN_UP(espic.fill, 4);
+	uint32_t tail, used;
+	size_t i;
+
+	if (!espic.ready || !len)
+		return;
+
+	memset(&espic.buf.bytes[espic.fill], 0, len - espic.fill);
+	espic.fill = 0;
+
+	tail = read32(&hdr->tail);
+	if (tail >= RING_SIZE)
+		return;
+
+	/* Keep a gap, so that head == tail always means the ring is empty. */
+	used = (espic.head + RING_SIZE - tail) % RING_SIZE;
+	if (len >= RING_SIZE - used)
+		return;
+
+	for (i = 0; i < len / 4; i++) {
+		write32(&ring[espic.head / 4], espic.buf.dwords[i]);
+		espic.head = (espic.head + 4) % RING_SIZE;
+	}
+
+	/* The ring content has to be there before the EC sees the new head. */
+	write32(&hdr->head, espic.head);
+}
+
+void espi_console_tx_byte(unsigned char data)
+{
+	if (!espic.ready)
+		return;
+
+	espic.buf.bytes[espic.fill++] = data;
+	if (espic.fill == ESPI_CONSOLE_BUF_SIZE)
+		espi_console_tx_flush();
+}
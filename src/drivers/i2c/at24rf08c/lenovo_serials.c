@@ -4,6 +4,7 @@
 #include <types.h>
 #include <string.h>
 #include <device/device.h>
+#include <device/i2c_bus.h>
 #include <device/smbus.h>
 #include <smbios.h>
 #include <console/console.h>
@@ -38,18 +39,41 @@ static int at24rf08c_read_byte(struct device *dev, u8 addr)
 	return t;
 }
 
+/* Try a block read first, fall back to the retrying byte reads if that fails. */
+static int at24rf08c_read_block(struct device *dev, u8 start, u8 len, u8 *buf)
+{
+	int i;
+
+	if (i2c_dev_read_at(dev, buf, len, start) == len)
+		return 0;
+
+	for (i = 0; i < len; i++) {
+		int t = at24rf08c_read_byte(dev, start + i);
+		if (t < 0)
+			return t;
+		buf[i] = t;
+	}
+
+	return 0;
+}
+
 static void at24rf08c_read_string_dev(struct device *dev, u8 start,
 				      u8 len, char *result)
 {
 	int i;
+
+	if (at24rf08c_read_block(dev, start, len, (u8 *)result) < 0) {
+		memcpy(result, ERROR_STRING, sizeof(ERROR_STRING));
+		return;
+	}
+
 	for (i = 0; i < len; i++) {
-		int t = at24rf08c_read_byte(dev, start + i);
+		const u8 t = result[i];
 
 		if (t < 0x20 || t > 0x7f) {
 			memcpy(result, ERROR_STRING, sizeof(ERROR_STRING));
 			return;
 		}
-		result[i] = t;
 	}
 	result[len] = '\0';
 }
@@ -106,6 +130,7 @@ const char *smbios_mainboard_product_name(void)
 void smbios_system_set_uuid(u8 *uuid)
 {
 	static char result[16];
+	u8 raw[16];
 	unsigned int i;
 	static int already_read;
 	struct device *dev;
@@ -129,22 +154,9 @@ void smbios_system_set_uuid(u8 *uuid)
 		return;
 	}
 
-	for (i = 0; i < 16; i++) {
-		int t;
-		int j;
-		/* After a register write AT24RF08C (which we issued in init function) sometimes stops responding.
-		   Retry several times in case of failure.
-		*/
-		for (j = 0; j < 100; j++) {
-			t = smbus_read_byte(dev, 0x12 + i);
-			if (t >= 0)
-				break;
-		}
-		if (t < 0) {
-			memset(result, 0, sizeof(result));
-			break;
-		}
-		result[remap[i]] = t;
+	if (at24rf08c_read_block(dev, 0x12, sizeof(raw), raw) == 0) {
+		for (i = 0; i < 16; i++)
+			result[remap[i]] = raw[i];
 	}
 
 	already_read = 1;
@@ -33,6 +33,7 @@
 #define CR50_TIMEOUT_INIT_MS	30000	/* Very long timeout for TPM init */
 #define CR50_TIMEOUT_LONG_MS	2000	/* Long timeout while waiting for TPM */
 #define CR50_TIMEOUT_SHORT_MS	2	/* Short timeout during transactions */
+#define CR50_POLL_MIN_US	50	/* First delay while polling the status */
 #define CR50_DID_VID		0x00281ae0L
 #define TI50_DT_DID_VID		0x504a6666L
 #define TI50_OT_DID_VID		0x50666666L
@@ -254,6 +255,7 @@ static tpm_result_t cr50_i2c_wait_burststs(uint8_t mask, size_t *burst, int *sta
 	uint8_t buf[4];
 	struct stopwatch sw;
 	tpm_result_t rc = TPM_SUCCESS;
+	unsigned int delay_us = CR50_POLL_MIN_US;
 
 	stopwatch_init_msecs_expire(&sw, CR50_TIMEOUT_LONG_MS);
 
@@ -272,7 +274,9 @@ static tpm_result_t cr50_i2c_wait_burststs(uint8_t mask, size_t *burst, int *sta
 		    *burst > 0 && *burst <= CR50_MAX_BUFSIZE)
 			return TPM_SUCCESS;
 
-		mdelay(CR50_TIMEOUT_SHORT_MS);
+		/* The data is usually there on the next poll, don't sleep the full 2ms. */
+		udelay(delay_us);
+		delay_us = MIN(delay_us * 2, CR50_TIMEOUT_SHORT_MS * USECS_PER_MSEC);
 	}
 	printk(BIOS_ERR, "%s: Timeout reading burst and status with error %#x\n", __func__, rc);
 	if (rc)
@@ -75,7 +75,11 @@ ifeq ($(CONFIG_FSP_M_XIP),y)
 $(FSP_M_CBFS)-options := --xip $(TXTIBB)
 $(FSP_M_CBFS_2)-options := --xip $(TXTIBB)
 endif
-ifeq ($(CONFIG_FSP_COMPRESS_FSP_M_LZMA),y)
+ifeq ($(CONFIG_FSP_M_PRE_RELOCATED),y)
+# Relocated to CONFIG_FSP_M_ADDR by cbfstool and stored uncompressed, so romstage only copies it
+$(FSP_M_CBFS)-options := -b $(CONFIG_FSP_M_ADDR)
+$(FSP_M_CBFS_2)-options := -b $(CONFIG_FSP_M_ADDR)
+else ifeq ($(CONFIG_FSP_COMPRESS_FSP_M_LZMA),y)
 $(FSP_M_CBFS)-compression := LZMA
 $(FSP_M_CBFS_2)-compression := LZMA
 else ifeq ($(CONFIG_FSP_COMPRESS_FSP_M_LZ4),y)
@@ -85,6 +89,9 @@ endif
 ifneq ($(CONFIG_FSP_ALIGNMENT_FSP_M),)
 $(FSP_M_CBFS)-align := $(CONFIG_FSP_ALIGNMENT_FSP_M)
 $(FSP_M_CBFS_2)-align := $(CONFIG_FSP_ALIGNMENT_FSP_M)
+else ifeq ($(CONFIG_FSP_M_PRE_RELOCATED),y)
+$(FSP_M_CBFS)-align := 64
+$(FSP_M_CBFS_2)-align := 64
 endif
 
 cbfs-files-$(CONFIG_ADD_FSP_BINARIES) += $(FSP_S_CBFS)
@@ -52,6 +52,13 @@ void platform_fsp_memory_multi_phase_init_cb(uint32_t phase_index);
 void platform_fsp_silicon_multi_phase_init_cb(uint32_t phase_index);
 /* Check if MultiPhase Si Init is enabled */
 bool fsp_is_multi_phase_init_enabled(void);
+/*
+ * Run |func| on the APs while FSP executes the current FspMultiPhaseSiInit phase. Meant
+ * to be called from platform_fsp_silicon_multi_phase_init_cb() for work that FSP doesn't
+ * depend on in this phase. All of it is done before the next phase callback is called.
+ * Runs |func| on the BSP if the APs can't be used while FSP is running.
+ */
+void fsp_multi_phase_run_on_aps(void (*func)(void *arg), void *arg);
 /*
  * The following functions are used when FSP_PLATFORM_MEMORY_SETTINGS_VERSION
  * is employed allowing the mainboard and SoC to supply their own version
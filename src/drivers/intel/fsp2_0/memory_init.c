@@ -317,8 +317,10 @@ static void fspm_multi_phase_init(const struct fsp_header *hdr)
 		 * Give SoC/mainboard a chance to perform any operation before
 		 * Multi Phase Execution
 		 */
+		timestamp_add_now(TS_FSP_MULTI_PHASE_MEM_INIT_CB_START);
 		platform_fsp_memory_multi_phase_init_cb(i);
 
+		timestamp_add_now(TS_FSP_MULTI_PHASE_MEM_INIT_PHASE_START);
 		multi_phase_params.multi_phase_action = EXECUTE_PHASE;
 		multi_phase_params.phase_index = i;
 		multi_phase_params.multi_phase_param_ptr = NULL;
@@ -3,6 +3,7 @@
 #include <arch/null_breakpoint.h>
 #include <bootstate.h>
 #include <console/console.h>
+#include <cpu/x86/profiler.h>
 #include <cpu/x86/mtrr.h>
 #include <fsp/util.h>
 #include <mode_switch.h>
@@ -78,10 +79,12 @@ static void fsp_notify(enum fsp_notify_phase phase)
 
 	/* FSP disables the interrupt handler so remove debug exceptions temporarily  */
 	null_breakpoint_disable();
+	profiler_suspend();
 	if (ENV_X86_64 && CONFIG(PLATFORM_USES_FSP2_X86_32))
 		ret = protected_mode_call_1arg(fspnotify, (uintptr_t)&notify_params);
 	else
 		ret = fspnotify(&notify_params);
+	profiler_resume();
 	null_breakpoint_init();
 
 	timestamp_add_now(data->timestamp_after);
@@ -8,6 +8,8 @@
 #include <commonlib/fsp.h>
 #include <stdlib.h>
 #include <console/console.h>
+#include <cpu/x86/mp_jobs.h>
+#include <cpu/x86/profiler.h>
 #include <fsp/api.h>
 #include <fsp/util.h>
 #include <mrc_cache.h>
@@ -16,6 +18,7 @@
 #include <soc/intel/common/vbt.h>
 #include <stage_cache.h>
 #include <string.h>
+#include <thread.h>
 #include <timestamp.h>
 #include <types.h>
 #include <mode_switch.h>
@@ -75,6 +78,47 @@ bool fsp_is_multi_phase_init_enabled(void)
 			 (fsps_hdr.fsp_multi_phase_si_init_entry_offset != 0);
 }
 
+#define MULTI_PHASE_MAX_AP_JOBS	16
+
+static struct mp_job multi_phase_jobs[MULTI_PHASE_MAX_AP_JOBS];
+static size_t num_multi_phase_jobs;
+static bool multi_phase_jobs_running;
+
+void fsp_multi_phase_run_on_aps(void (*func)(void *arg), void *arg)
+{
+	/*
+	 * The job system keeps the APs busy, so it can't be used if FSP does its own MP init
+	 * or calls back into coreboot's MP services while it runs.
+	 */
+	if (!CONFIG(MP_JOBS) || CONFIG(USE_INTEL_FSP_MP_INIT) || CONFIG(MP_SERVICES_PPI) ||
+	    num_multi_phase_jobs == ARRAY_SIZE(multi_phase_jobs)) {
+		func(arg);
+		return;
+	}
+
+	if (!multi_phase_jobs_running) {
+		if (mp_jobs_begin() != CB_SUCCESS) {
+			func(arg);
+			return;
+		}
+		multi_phase_jobs_running = true;
+	}
+
+	mp_job_submit(&multi_phase_jobs[num_multi_phase_jobs++], func, arg);
+}
+
+static void multi_phase_join_aps(void)
+{
+	for (size_t i = 0; i < num_multi_phase_jobs; i++)
+		mp_job_join(&multi_phase_jobs[i]);
+	num_multi_phase_jobs = 0;
+
+	if (multi_phase_jobs_running) {
+		mp_jobs_end();
+		multi_phase_jobs_running = false;
+	}
+}
+
 static void fsp_fill_common_arch_params(FSPS_UPD *supd)
 {
 #if (CONFIG(FSPS_HAS_ARCH_UPD) && !CONFIG(PLATFORM_USES_FSP2_4))
@@ -132,10 +176,12 @@ static void do_silicon_init(struct fsp_header *hdr)
 
 	/* FSP disables the interrupt handler so remove debug exceptions temporarily  */
 	null_breakpoint_disable();
+	profiler_suspend();
 	if (ENV_X86_64 && CONFIG(PLATFORM_USES_FSP2_X86_32))
 		status = protected_mode_call_1arg(silicon_init, (uintptr_t)upd);
 	else
 		status = silicon_init(upd);
+	profiler_resume();
 	null_breakpoint_init();
 
 	fsp_printk(status, BIOS_INFO, "FSPS");
@@ -171,7 +217,9 @@ static void do_silicon_init(struct fsp_header *hdr)
 	multi_phase_params.multi_phase_action = GET_NUMBER_OF_PHASES;
 	multi_phase_params.phase_index = 0;
 	multi_phase_params.multi_phase_param_ptr = &multi_phase_get_number;
+	profiler_suspend();
 	status = multi_phase_si_init(&multi_phase_params);
+	profiler_resume();
 	fsps_return_value_handler(FSP_MULTI_PHASE_SI_INIT_GET_NUMBER_OF_PHASES_API, status);
 
 	/* Execute Multi Phase Execution */
@@ -181,12 +229,17 @@ static void do_silicon_init(struct fsp_header *hdr)
 		 * Give SoC/mainboard a chance to perform any operation before
 		 * Multi Phase Execution
 		 */
+		timestamp_add_now(TS_FSP_MULTI_PHASE_SI_INIT_CB_START);
 		platform_fsp_silicon_multi_phase_init_cb(i);
 
+		timestamp_add_now(TS_FSP_MULTI_PHASE_SI_INIT_PHASE_START);
 		multi_phase_params.multi_phase_action = EXECUTE_PHASE;
 		multi_phase_params.phase_index = i;
 		multi_phase_params.multi_phase_param_ptr = NULL;
+		profiler_suspend();
 		status = multi_phase_si_init(&multi_phase_params);
+		profiler_resume();
+		multi_phase_join_aps();
 		if (CONFIG(FSP_MULTIPHASE_SI_INIT_RETURN_BROKEN))
 			status = fsp_get_pch_reset_status();
 		fsps_return_value_handler(FSP_MULTI_PHASE_SI_INIT_EXECUTE_PHASE_API, status);
@@ -204,7 +257,7 @@ static void *fsps_allocator(void *arg_unused, size_t size, const union cbfs_mdat
 	return cbmem_add(CBMEM_ID_REFCODE, size);
 }
 
-void fsps_load(void)
+static void do_fsps_load(void)
 {
 	const char *fsps_cbfs = soc_select_fsp_s_cbfs();
 	struct fsp_load_descriptor fspld = {
@@ -236,16 +289,59 @@ void fsps_load(void)
 	load_done = 1;
 }
 
+static struct thread_handle fsps_load_handle;
+static bool fsps_load_started;
+
+static enum cb_err fsps_load_thread_entry(void *arg_unused)
+{
+	do_fsps_load();
+	return CB_SUCCESS;
+}
+
+void fsps_load(void)
+{
+	if (fsps_load_started) {
+		if (thread_join(&fsps_load_handle) != CB_SUCCESS)
+			die("FSP-S failed to load\n");
+		fsps_load_started = false;
+	}
+
+	do_fsps_load();
+}
+
 void preload_fsps(void)
 {
+	static bool done;
+	const char *fsps_cbfs = soc_select_fsp_s_cbfs();
+
+	if (done)
+		return;
+	done = true;
+
+	if (CONFIG(FSPS_LOAD_IN_BACKGROUND)) {
+		printk(BIOS_DEBUG, "Loading %s in the background\n", fsps_cbfs);
+		if (!thread_run(&fsps_load_handle, fsps_load_thread_entry, NULL)) {
+			fsps_load_started = true;
+			return;
+		}
+		printk(BIOS_ERR, "Failed to start the FSP-S load thread\n");
+	}
+
 	if (!CONFIG(CBFS_PRELOAD))
 		return;
 
-	const char *fsps_cbfs = soc_select_fsp_s_cbfs();
 	printk(BIOS_DEBUG, "Preloading %s\n", fsps_cbfs);
 	cbfs_preload(fsps_cbfs);
 }
 
+static void start_fsps_background_load(void *unused)
+{
+	if (CONFIG(FSPS_LOAD_IN_BACKGROUND))
+		preload_fsps();
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, start_fsps_background_load, NULL);
+
 void fsp_silicon_init(void)
 {
 	fsps_load();
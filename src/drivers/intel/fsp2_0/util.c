@@ -132,6 +132,18 @@ static inline bool fspm_xip(void)
 	return false;
 }
 
+/* Returns true if the FSP component at |fsp| was already relocated for that address. */
+static bool fsp_is_relocated_for(void *fsp, size_t size)
+{
+	struct fsp_header hdr;
+
+	if (size < FSP_HDR_OFFSET + fsp_hdr_get_expected_min_length() ||
+	    fsp_identify(&hdr, fsp + FSP_HDR_OFFSET) != CB_SUCCESS)
+		return false;
+
+	return hdr.image_base == (uintptr_t)fsp;
+}
+
 /* Load the FSP component described by fsp_load_descriptor from cbfs. The FSP
  * header object will be validated and filled in on successful load. */
 enum cb_err fsp_load_component(struct fsp_load_descriptor *fspld, struct fsp_header *hdr)
@@ -144,8 +156,9 @@ enum cb_err fsp_load_component(struct fsp_load_descriptor *fspld, struct fsp_hea
 	if (!dest)
 		return CB_ERR;
 
-	/* Don't allow FSP-M relocation when XIP. */
-	if (!fspm_xip() && fsp_component_relocate((uintptr_t)dest, dest, output_size) < 0) {
+	/* Don't allow FSP-M relocation when XIP. Skip it if cbfstool relocated it already. */
+	if (!fspm_xip() && !fsp_is_relocated_for(dest, output_size) &&
+	    fsp_component_relocate((uintptr_t)dest, dest, output_size) < 0) {
 		printk(BIOS_ERR, "Unable to relocate FSP component!\n");
 		return CB_ERR;
 	}
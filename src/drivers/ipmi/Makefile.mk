@@ -5,6 +5,7 @@ ramstage-$(CONFIG_IPMI_KCS) += ipmi_kcs.c
 ramstage-$(CONFIG_IPMI_KCS) += ipmi_kcs_ops.c
 ramstage-$(CONFIG_IPMI_KCS) += ipmi_ops.c
 ramstage-$(CONFIG_IPMI_KCS) += ipmi_fru.c
+ramstage-$(CONFIG_IPMI_FRU_FLASH_CACHE) += ipmi_fru_cache.c
 ramstage-$(CONFIG_DRIVERS_IPMI_SUPERMICRO_OEM) += supermicro_oem.c
 romstage-$(CONFIG_IPMI_KCS_ROMSTAGE) += ipmi_if.c
 romstage-$(CONFIG_IPMI_KCS_ROMSTAGE) += ipmi_ops_premem.c
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <commonlib/helpers.h>
 #include <console/console.h>
 #include <string.h>
 #include <delay.h>
@@ -14,15 +15,105 @@
 #define NUM_DATA_BYTES(t) (t & 0x3f) /* Encoded in type/length byte */
 #define FRU_END_OF_FIELDS 0xc1 /* type/length byte encoded to indicate no more info fields */
 
-static enum cb_err ipmi_read_fru(const int port, struct ipmi_read_fru_data_req *req,
-			uint8_t *fru_data)
+/*
+ * FRU data read during this boot, in chunks of CONFIG_IPMI_FRU_SINGLE_RW_SZ bytes at
+ * multiples of that size. Each area starts with its length, which is read before the
+ * area itself, so reading whole chunks answers most requests without another command.
+ */
+#define FRU_CACHE_CHUNKS 32
+
+static struct fru_cache_chunk {
+	int port;
+	uint8_t id;
+	uint8_t count;		/* Bytes returned by the BMC, 0 if unused */
+	uint16_t offset;
+	uint8_t data[CONFIG_IPMI_FRU_SINGLE_RW_SZ];
+} fru_cache[FRU_CACHE_CHUNKS];
+static size_t fru_cache_next;
+
+/* Send one Read FRU Data command. Returns the number of bytes read or -1 on error. */
+static int ipmi_read_fru_cmd(const int port, const struct ipmi_read_fru_data_req *req,
+			     uint8_t *fru_data, int loglevel)
 {
 	int ret;
-	uint8_t total_size;
-	uint16_t offset = 0;
 	struct ipmi_read_fru_data_rsp rsp;
 	int retry_count = 0;
 
+	while (retry_count <= MAX_FRU_BUSY_RETRY) {
+		ret = ipmi_message(port, IPMI_NETFN_STORAGE, 0x0,
+				IPMI_READ_FRU_DATA, (const unsigned char *)req,
+				sizeof(*req), (unsigned char *)&rsp, sizeof(rsp));
+		if (rsp.resp.completion_code == 0x81) {
+			/* Device is busy */
+			if (retry_count == MAX_FRU_BUSY_RETRY) {
+				printk(BIOS_ERR, "IPMI: %s command failed, "
+					"device busy timeout\n", __func__);
+				return -1;
+			}
+			printk(BIOS_ERR, "IPMI: FRU device is busy, "
+				"retry count:%d\n", retry_count);
+			retry_count++;
+			mdelay(READ_FRU_DATA_RETRY_INTERVAL_MS);
+		} else if (ret < sizeof(struct ipmi_rsp) || rsp.resp.completion_code) {
+			printk(loglevel, "IPMI: %s command failed (ret=%d resp=0x%x)\n",
+				__func__, ret, rsp.resp.completion_code);
+			return -1;
+		}
+		break;
+	}
+
+	if (!rsp.count || rsp.count > req->count) {
+		printk(loglevel, "IPMI: %s returned %d of %d bytes\n", __func__, rsp.count,
+		       req->count);
+		return -1;
+	}
+
+	memcpy(fru_data, rsp.data, rsp.count);
+	return rsp.count;
+}
+
+static const struct fru_cache_chunk *fru_cache_get(const int port, const uint8_t id,
+						   const uint16_t offset)
+{
+	struct ipmi_read_fru_data_req req;
+	struct fru_cache_chunk *c;
+	size_t i;
+	int count;
+
+	for (i = 0; i < ARRAY_SIZE(fru_cache); i++) {
+		c = &fru_cache[i];
+		if (c->count && c->port == port && c->id == id && c->offset == offset)
+			return c;
+	}
+
+	c = &fru_cache[fru_cache_next++ % ARRAY_SIZE(fru_cache)];
+	c->count = 0;
+
+	req.fru_device_id = id;
+	req.fru_offset = offset;
+	req.count = sizeof(c->data);
+	/* Chunks may reach past the end of the FRU, so failing here is no error yet. */
+	count = ipmi_read_fru_cmd(port, &req, c->data, BIOS_DEBUG);
+	if (count < 0)
+		return NULL;
+
+	c->port = port;
+	c->id = id;
+	c->offset = offset;
+	c->count = count;
+
+	return c;
+}
+
+static enum cb_err ipmi_read_fru(const int port, struct ipmi_read_fru_data_req *req,
+			uint8_t *fru_data)
+{
+	const struct fru_cache_chunk *c;
+	const size_t chunk = CONFIG_IPMI_FRU_SINGLE_RW_SZ;
+	uint16_t offset, skip;
+	size_t total_size, done, len;
+	int count;
+
 	if (req == NULL || fru_data == NULL) {
 		printk(BIOS_ERR, "%s failed, null pointer parameter\n",
 			 __func__);
@@ -30,39 +121,27 @@ static enum cb_err ipmi_read_fru(const int port, struct ipmi_read_fru_data_req *
 	}
 
 	total_size = req->count;
-	do {
-		if (req->count > CONFIG_IPMI_FRU_SINGLE_RW_SZ)
-			req->count = CONFIG_IPMI_FRU_SINGLE_RW_SZ;
-
-		while (retry_count <= MAX_FRU_BUSY_RETRY) {
-			ret = ipmi_message(port, IPMI_NETFN_STORAGE, 0x0,
-					IPMI_READ_FRU_DATA, (const unsigned char *)req,
-					sizeof(*req), (unsigned char *)&rsp, sizeof(rsp));
-			if (rsp.resp.completion_code == 0x81) {
-				/* Device is busy */
-				if (retry_count == MAX_FRU_BUSY_RETRY) {
-					printk(BIOS_ERR, "IPMI: %s command failed, "
-						"device busy timeout\n", __func__);
-					return CB_ERR;
-				}
-				printk(BIOS_ERR, "IPMI: FRU device is busy, "
-					"retry count:%d\n", retry_count);
-				retry_count++;
-				mdelay(READ_FRU_DATA_RETRY_INTERVAL_MS);
-			} else if (ret < sizeof(struct ipmi_rsp) || rsp.resp.completion_code) {
-				printk(BIOS_ERR, "IPMI: %s command failed (ret=%d resp=0x%x)\n",
-					__func__, ret, rsp.resp.completion_code);
-				return CB_ERR;
-			}
-			break;
+	offset = req->fru_offset;
+	for (done = 0; done < total_size; done += len, offset += len) {
+		skip = offset % chunk;
+		c = fru_cache_get(port, req->fru_device_id, offset - skip);
+		if (c && c->count > skip) {
+			len = MIN(c->count - skip, total_size - done);
+			memcpy(fru_data + done, c->data + skip, len);
+			continue;
 		}
-		retry_count = 0;
-		memcpy(fru_data + offset, rsp.data, rsp.count);
-		offset += rsp.count;
-		total_size -= rsp.count;
-		req->fru_offset += rsp.count;
-		req->count = total_size;
-	} while (total_size > 0);
+
+		/* The BMC didn't return the whole chunk, read only what was asked for. */
+		req->fru_offset = offset;
+		req->count = MIN(total_size - done, chunk);
+		count = ipmi_read_fru_cmd(port, req, fru_data + done, BIOS_ERR);
+		if (count < 0)
+			return CB_ERR;
+		len = count;
+	}
+
+	req->fru_offset = offset;
+	req->count = 0;
 
 	return CB_SUCCESS;
 }
@@ -76,6 +155,66 @@ static uint8_t checksum(uint8_t *data, int offset)
 	return -c;
 }
 
+/*
+ * Take an area from the copy of an earlier boot if the BMC still has the same start and
+ * end, which hold its length and checksum. Those take at most two Read FRU Data commands.
+ */
+static enum cb_err read_fru_area_cached(const int port,
+			const struct ipmi_read_fru_data_req *area, uint8_t *fru_data)
+{
+	const size_t chunk = CONFIG_IPMI_FRU_SINGLE_RW_SZ;
+	const uint16_t end = area->fru_offset + area->count;
+	struct ipmi_read_fru_data_req req;
+	const uint8_t *cached;
+	uint16_t head, tail;
+
+	cached = ipmi_fru_cache_find(port, area->fru_device_id, area->fru_offset,
+				     area->count);
+	if (!cached)
+		return CB_ERR;
+
+	head = MIN(chunk - area->fru_offset % chunk, area->count);
+	tail = end % chunk ? end % chunk : chunk;
+	tail = MIN(tail, area->count - head);
+
+	req.fru_device_id = area->fru_device_id;
+	req.fru_offset = area->fru_offset;
+	req.count = head;
+	if (ipmi_read_fru(port, &req, fru_data) != CB_SUCCESS ||
+	    memcmp(fru_data, cached, head))
+		return CB_ERR;
+
+	req.fru_offset = end - tail;
+	req.count = tail;
+	if (tail && (ipmi_read_fru(port, &req, fru_data + area->count - tail) != CB_SUCCESS ||
+		     memcmp(fru_data + area->count - tail, cached + area->count - tail, tail)))
+		return CB_ERR;
+
+	memcpy(fru_data, cached, area->count);
+	return CB_SUCCESS;
+}
+
+static enum cb_err ipmi_read_fru_area(const int port, struct ipmi_read_fru_data_req *req,
+			uint8_t *fru_data)
+{
+	const struct ipmi_read_fru_data_req area = *req;
+
+	if (!CONFIG(IPMI_FRU_FLASH_CACHE))
+		return ipmi_read_fru(port, req, fru_data);
+
+	if (read_fru_area_cached(port, &area, fru_data) == CB_SUCCESS)
+		return CB_SUCCESS;
+
+	if (ipmi_read_fru(port, req, fru_data) != CB_SUCCESS)
+		return CB_ERR;
+
+	if (!checksum(fru_data, area.count))
+		ipmi_fru_cache_store(port, area.fru_device_id, area.fru_offset, area.count,
+				     fru_data);
+
+	return CB_SUCCESS;
+}
+
 static uint8_t data2str(const uint8_t *frudata, char *stringdata, uint8_t length)
 {
 	uint8_t type;
@@ -153,7 +292,7 @@ static enum cb_err read_fru_chassis_info_area(const int port, const uint8_t id,
 	/* Read Chassis Info Area data. */
 	req.fru_offset = offset;
 	req.count = length;
-	if (ipmi_read_fru(port, &req, data_ptr) != CB_SUCCESS) {
+	if (ipmi_read_fru_area(port, &req, data_ptr) != CB_SUCCESS) {
 		printk(BIOS_ERR, "%s failed to read fru\n", __func__);
 		ret = CB_ERR;
 		goto out;
@@ -244,7 +383,7 @@ static enum cb_err read_fru_board_info_area(const int port, const uint8_t id,
 	/* Read Board Info Area data. */
 	req.fru_offset = offset;
 	req.count = length;
-	if (ipmi_read_fru(port, &req, data_ptr) != CB_SUCCESS) {
+	if (ipmi_read_fru_area(port, &req, data_ptr) != CB_SUCCESS) {
 		printk(BIOS_ERR, "%s failed to read fru\n", __func__);
 		ret = CB_ERR;
 		goto out;
@@ -343,7 +482,7 @@ static enum cb_err read_fru_product_info_area(const int port, const uint8_t id,
 	/* Read Product Info Area data. */
 	req.fru_offset = offset;
 	req.count = length;
-	if (ipmi_read_fru(port, &req, data_ptr) != CB_SUCCESS) {
+	if (ipmi_read_fru_area(port, &req, data_ptr) != CB_SUCCESS) {
 		printk(BIOS_ERR, "%s failed to read fru\n", __func__);
 		ret = CB_ERR;
 		goto out;
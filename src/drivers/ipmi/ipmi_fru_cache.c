@@ -0,0 +1,180 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <commonlib/region.h>
+#include <console/console.h>
+#include <fmap.h>
+#include <stdlib.h>
+#include <string.h>
+#include <types.h>
+
+#include "ipmi_ops.h"
+
+/*
+ * FRU areas read in earlier boots are kept in the RW_IPMI_FRU_CACHE FMAP region. The
+ * region holds a header, followed by the areas, each behind a struct fru_cache_entry.
+ * Whether a copy is still current is up to the caller.
+ */
+#define FRU_CACHE_FMAP_NAME	"RW_IPMI_FRU_CACHE"
+#define FRU_CACHE_SIGNATURE	0x55524649	/* 'IFRU' */
+#define FRU_CACHE_MAX_SIZE	(4 * KiB)
+
+struct fru_cache_header {
+	uint32_t signature;
+	uint32_t size;		/* Of the entries behind the header */
+} __packed;
+
+struct fru_cache_entry {
+	uint16_t port;
+	uint8_t id;
+	uint8_t reserved;
+	uint16_t offset;
+	uint16_t length;
+	uint8_t data[];
+} __packed;
+
+static struct fru_cache_header *cache;
+static bool cache_dirty;
+
+static struct fru_cache_header *get_cache(void)
+{
+	struct region_device rdev;
+
+	if (cache)
+		return cache;
+
+	cache = malloc(FRU_CACHE_MAX_SIZE);
+	if (!cache)
+		return NULL;
+
+	if (fmap_locate_area_as_rdev(FRU_CACHE_FMAP_NAME, &rdev) ||
+	    rdev_readat(&rdev, cache, 0, sizeof(*cache)) != sizeof(*cache) ||
+	    cache->signature != FRU_CACHE_SIGNATURE ||
+	    cache->size > FRU_CACHE_MAX_SIZE - sizeof(*cache) ||
+	    rdev_readat(&rdev, cache + 1, sizeof(*cache), cache->size) != cache->size) {
+		cache->signature = FRU_CACHE_SIGNATURE;
+		cache->size = 0;
+	}
+
+	return cache;
+}
+
+/* Returns the next entry behind e, or NULL if e is the last one or broken. */
+static struct fru_cache_entry *next_entry(struct fru_cache_header *hdr,
+					  struct fru_cache_entry *e)
+{
+	uint8_t *const start = (uint8_t *)(hdr + 1);
+	uint8_t *const end = start + hdr->size;
+	uint8_t *p = e ? e->data + e->length : start;
+
+	if (p + sizeof(*e) > end)
+		return NULL;
+	e = (struct fru_cache_entry *)p;
+	if (e->data + e->length > end)
+		return NULL;
+
+	return e;
+}
+
+static struct fru_cache_entry *find_entry(struct fru_cache_header *hdr, const int port,
+					  const uint8_t id, const uint16_t offset)
+{
+	struct fru_cache_entry *e = NULL;
+
+	while ((e = next_entry(hdr, e)))
+		if (e->port == port && e->id == id && e->offset == offset)
+			return e;
+
+	return NULL;
+}
+
+const uint8_t *ipmi_fru_cache_find(const int port, const uint8_t id, const uint16_t offset,
+				   const uint16_t length)
+{
+	struct fru_cache_header *hdr = get_cache();
+	struct fru_cache_entry *e;
+
+	if (!hdr)
+		return NULL;
+
+	e = find_entry(hdr, port, id, offset);
+	if (!e || e->length != length)
+		return NULL;
+
+	return e->data;
+}
+
+void ipmi_fru_cache_store(const int port, const uint8_t id, const uint16_t offset,
+			  const uint16_t length, const uint8_t *data)
+{
+	struct fru_cache_header *hdr = get_cache();
+	struct fru_cache_entry *e;
+	uint8_t *start;
+	size_t size;
+
+	if (!hdr)
+		return;
+
+	start = (uint8_t *)(hdr + 1);
+	e = find_entry(hdr, port, id, offset);
+	if (e) {
+		if (e->length == length && !memcmp(e->data, data, length))
+			return;
+		size = sizeof(*e) + e->length;
+		memmove(e, (uint8_t *)e + size, start + hdr->size - ((uint8_t *)e + size));
+		hdr->size -= size;
+	}
+
+	if (sizeof(*hdr) + hdr->size + sizeof(*e) + length > FRU_CACHE_MAX_SIZE) {
+		printk(BIOS_DEBUG, "IPMI: FRU area at 0x%x does not fit into the cache\n",
+		       offset);
+		/* An old copy was dropped, which has to reach flash as well. */
+		if (e)
+			cache_dirty = true;
+		return;
+	}
+
+	e = (struct fru_cache_entry *)(start + hdr->size);
+	e->port = port;
+	e->id = id;
+	e->reserved = 0;
+	e->offset = offset;
+	e->length = length;
+	memcpy(e->data, data, length);
+	hdr->size += sizeof(*e) + length;
+	cache_dirty = true;
+}
+
+static void write_fru_cache(void *unused)
+{
+	struct region_device rdev;
+	size_t size, erase_size;
+
+	if (!cache_dirty)
+		return;
+
+	if (fmap_locate_area_as_rdev_rw(FRU_CACHE_FMAP_NAME, &rdev)) {
+		printk(BIOS_ERR, "%s: No %s FMAP section.\n", __func__, FRU_CACHE_FMAP_NAME);
+		return;
+	}
+
+	size = sizeof(*cache) + cache->size;
+	if (size > region_device_sz(&rdev)) {
+		printk(BIOS_ERR, "%s: FRU data does not fit into %s.\n", __func__,
+		       FRU_CACHE_FMAP_NAME);
+		return;
+	}
+
+	erase_size = MIN(ALIGN_UP(size, 4 * KiB), region_device_sz(&rdev));
+	if (rdev_eraseat(&rdev, 0, erase_size) != erase_size ||
+	    rdev_writeat(&rdev, cache, 0, size) != size) {
+		printk(BIOS_ERR, "Failed to write IPMI FRU cache to flash\n");
+		return;
+	}
+
+	cache_dirty = false;
+	printk(BIOS_DEBUG, "IPMI FRU cache updated\n");
+}
+
+/* The FRU is read while devices are enabled, write the cache before flash is locked. */
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME_CHECK, BS_ON_ENTRY, write_fru_cache, NULL);
@@ -175,6 +175,15 @@ void read_fru_areas(const int port, uint8_t id, uint16_t offset,
 void read_fru_one_area(const int port, uint8_t id, uint16_t offset,
 		struct fru_info_str *fru_info_str, enum fru_area fru_area);
 
+/*
+ * Copies of FRU areas from earlier boots, with CONFIG(IPMI_FRU_FLASH_CACHE). find returns
+ * the area with the given offset and length, or NULL if there is none.
+ */
+const uint8_t *ipmi_fru_cache_find(const int port, uint8_t id, uint16_t offset,
+				   uint16_t length);
+void ipmi_fru_cache_store(const int port, uint8_t id, uint16_t offset, uint16_t length,
+			  const uint8_t *data);
+
 /* Add a SEL record entry, returns CB_SUCCESS on success and CB_ERR
  * if an error occurred */
 enum cb_err ipmi_add_sel(const int port, struct sel_event_record *sel);
@@ -4,10 +4,12 @@
 #include <boot_device.h>
 #include <bootstate.h>
 #include <bootmode.h>
+#include <cbfs.h>
 #include <console/console.h>
 #include <cbmem.h>
 #include <elog.h>
 #include <fmap.h>
+#include <nv_write_queue.h>
 #include <region_file.h>
 #include <security/vboot/antirollback.h>
 #include <security/vboot/mrc_cache_hash_tpm.h>
@@ -35,6 +37,29 @@ struct mrc_metadata {
 	uint32_t version;
 } __packed;
 
+/*
+ * A delta update only stores the byte ranges that differ from an older full
+ * update, the base. data_size and data_hash in the metadata describe the
+ * patched data, header_hash covers the whole struct. The header is followed
+ * by delta_size bytes of mrc_delta_record headers, each followed by size
+ * bytes of replacement data.
+ */
+#define MRC_DELTA_SIGNATURE      (('M'<<0)|('R'<<8)|('C'<<16)|('p'<<24))
+
+struct mrc_delta_metadata {
+	struct mrc_metadata md;
+	uint32_t base_hash;
+	uint32_t delta_size;
+} __packed;
+
+struct mrc_delta_record {
+	uint32_t offset;
+	uint32_t size;
+} __packed;
+
+/* Bounds the stack usage of a delta update, more changes are written in full. */
+#define MRC_DELTA_MAX_RECORDS	16
+
 enum result {
 	UPDATE_FAILURE		= -1,
 	UPDATE_SUCCESS		= 0,
@@ -170,6 +195,7 @@ static const struct cache_region *lookup_region(struct region *r, int type)
 
 static int mrc_header_valid(struct region_device *rdev, struct mrc_metadata *md)
 {
+	struct mrc_delta_metadata dmd;
 	uint32_t hash;
 	uint32_t hash_result;
 	size_t size;
@@ -187,16 +213,23 @@ static int mrc_header_valid(struct region_device *rdev, struct mrc_metadata *md)
 		return -1;
 	}
 
-	if (md->signature != MRC_DATA_SIGNATURE) {
+	hash = md->header_hash;
+
+	/* Compute hash over header with 0 as the value. */
+	if (md->signature == MRC_DATA_SIGNATURE) {
+		md->header_hash = 0;
+		hash_result = xxh32(md, sizeof(*md), 0);
+		size = sizeof(*md) + md->data_size;
+	} else if (md->signature == MRC_DELTA_SIGNATURE &&
+		   rdev_readat(rdev, &dmd, 0, sizeof(dmd)) == sizeof(dmd)) {
+		dmd.md.header_hash = 0;
+		hash_result = xxh32(&dmd, sizeof(dmd), 0);
+		size = sizeof(dmd) + dmd.delta_size;
+	} else {
 		printk(BIOS_ERR, "MRC: invalid header signature\n");
 		return -1;
 	}
 
-	/* Compute hash over header with 0 as the value. */
-	hash = md->header_hash;
-	md->header_hash = 0;
-	hash_result = xxh32(md, sizeof(*md), 0);
-
 	if (hash != hash_result) {
 		printk(BIOS_ERR, "MRC: header hash mismatch: %x vs %x\n",
 			hash, hash_result);
@@ -208,7 +241,6 @@ static int mrc_header_valid(struct region_device *rdev, struct mrc_metadata *md)
 
 	/* Re-size the region device according to the metadata as a region_file
 	 * does block allocation. */
-	size = sizeof(*md) + md->data_size;
 	if (rdev_chain(rdev, rdev, 0, size) < 0) {
 		printk(BIOS_ERR, "MRC: size exceeds rdev size: %zx vs %zx\n",
 			size, region_device_sz(rdev));
@@ -252,8 +284,7 @@ static int mrc_cache_get_latest_slot_info(const char *name,
 				const struct region_device *backing_rdev,
 				struct mrc_metadata *md,
 				struct region_file *cache_file,
-				struct region_device *rdev,
-				bool fail_bad_data)
+				struct region_device *rdev)
 {
 	/* Init and obtain a handle to the file data. */
 	if (region_file_init(cache_file, backing_rdev) < 0) {
@@ -268,19 +299,108 @@ static int mrc_cache_get_latest_slot_info(const char *name,
 	/* No data to return. */
 	if (region_file_data(cache_file, rdev) < 0) {
 		printk(BIOS_NOTICE, "MRC: no data in '%s'\n", name);
-		return fail_bad_data ? -1 : 0;
+		return 0;
 	}
 
 	/* Validate header and resize region to reflect actual usage on the
 	 * saved medium (including metadata and data). */
-	if (mrc_header_valid(rdev, md) < 0)
-		return fail_bad_data ? -1 : 0;
+	mrc_header_valid(rdev, md);
 
 	return 0;
 }
 
-static int mrc_cache_find_current(int type, uint32_t version,
+/*
+ * Finds the newest full update at or older than |age|, optionally one with the given data
+ * hash, and points rdev at its data. Stops at an intentional invalidation, nothing older
+ * than that may be used.
+ */
+static int mrc_find_full_update(const struct region_file *cache_file, size_t age,
+				const uint32_t *data_hash, struct mrc_metadata *md,
+				struct region_device *rdev)
+{
+	for (; region_file_data_history(cache_file, age, rdev) == 0; age++) {
+		if (mrc_header_valid(rdev, md) < 0) {
+			if (md->signature == mrc_invalid_sig)
+				return -1;
+			continue;
+		}
+
+		if (md->signature != MRC_DATA_SIGNATURE)
+			continue;
+
+		if (data_hash && md->data_hash != *data_hash)
+			continue;
+
+		return rdev_chain(rdev, rdev, sizeof(*md), md->data_size);
+	}
+
+	return -1;
+}
+
+/*
+ * Splits the delta update in rdev, found at |age|, into its records and points rdev at the
+ * data of the base update it applies to.
+ */
+static int mrc_delta_locate(const struct region_file *cache_file, size_t age,
+			    const struct mrc_metadata *md, struct region_device *rdev,
+			    struct region_device *delta)
+{
+	struct mrc_delta_metadata dmd;
+	struct mrc_metadata base_md;
+
+	if (rdev_readat(rdev, &dmd, 0, sizeof(dmd)) != sizeof(dmd))
+		return -1;
+
+	if (rdev_chain(delta, rdev, sizeof(dmd), dmd.delta_size) < 0)
+		return -1;
+
+	if (mrc_find_full_update(cache_file, age + 1, &dmd.base_hash, &base_md, rdev) < 0 ||
+	    base_md.version != md->version || base_md.data_size != md->data_size) {
+		printk(BIOS_ERR, "MRC: base of delta update %zu not found\n", age);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Patches the records of a delta update into a copy of the base data. */
+static int mrc_delta_apply(const struct region_device *delta, void *data, size_t data_size)
+{
+	struct mrc_delta_record rec;
+	const size_t size = region_device_sz(delta);
+	size_t offset = 0;
+
+	while (offset < size) {
+		if (rdev_readat(delta, &rec, offset, sizeof(rec)) != sizeof(rec))
+			return -1;
+		offset += sizeof(rec);
+
+		if (rec.offset > data_size || rec.size > data_size - rec.offset) {
+			printk(BIOS_ERR, "MRC: delta record out of bounds\n");
+			return -1;
+		}
+
+		if (rdev_readat(delta, (uint8_t *)data + rec.offset, offset,
+				rec.size) != rec.size)
+			return -1;
+		offset += rec.size;
+	}
+
+	return 0;
+}
+
+/*
+ * Finds the newest update at or older than *age that has a valid header and the requested
+ * version, and points rdev at its data. *age is left at the update that was found, so a
+ * caller that rejects its data can continue with the next older one. Older updates are
+ * only looked at if the newer ones are damaged or were written by a different MRC version,
+ * and never past an intentional invalidation. For a delta update rdev points at the data
+ * of its base and delta at the records that have to be applied on top, otherwise delta is
+ * empty.
+ */
+static int mrc_cache_find_current(int type, uint32_t version, size_t *age,
 				  struct region_device *rdev,
+				  struct region_device *delta,
 				  struct mrc_metadata *md)
 {
 	const struct cache_region *cr;
@@ -289,7 +409,6 @@ static int mrc_cache_find_current(int type, uint32_t version,
 	struct region_file cache_file;
 	size_t data_size;
 	const size_t md_size = sizeof(*md);
-	const bool fail_bad_data = true;
 
 	/*
 	 * In recovery mode, force retraining if the memory retrain
@@ -307,73 +426,146 @@ static int mrc_cache_find_current(int type, uint32_t version,
 	if (boot_device_ro_subregion(&region, &read_rdev) < 0)
 		return -1;
 
-	if (mrc_cache_get_latest_slot_info(cr->name,
-					   &read_rdev,
-					   md,
-					   &cache_file,
-					   rdev,
-					   fail_bad_data) < 0)
+	if (region_file_init(&cache_file, &read_rdev) < 0) {
+		printk(BIOS_ERR, "MRC: region file invalid in '%s'\n", cr->name);
 		return -1;
+	}
 
-	if (version != md->version) {
-		printk(BIOS_INFO, "MRC: version mismatch: %x vs %x\n",
-			md->version, version);
-		return -1;
+	memset(md, 0, sizeof(*md));
+
+	for (; *age <= CONFIG_MRC_CACHE_FALLBACK_UPDATES; (*age)++) {
+		if (region_file_data_history(&cache_file, *age, rdev) < 0) {
+			if (*age == 0)
+				printk(BIOS_NOTICE, "MRC: no data in '%s'\n", cr->name);
+			return -1;
+		}
+
+		/* Validate header and resize region to reflect actual usage on the
+		 * saved medium (including metadata and data). */
+		if (mrc_header_valid(rdev, md) < 0) {
+			if (md->signature == mrc_invalid_sig)
+				return -1;
+			continue;
+		}
+
+		if (version != md->version) {
+			printk(BIOS_INFO, "MRC: version mismatch: %x vs %x\n",
+				md->version, version);
+			continue;
+		}
+
+		if (*age)
+			printk(BIOS_NOTICE, "MRC: falling back to update %zu in '%s'\n",
+			       *age, cr->name);
+
+		if (md->signature == MRC_DELTA_SIGNATURE) {
+			if (mrc_delta_locate(&cache_file, *age, md, rdev, delta) < 0)
+				continue;
+			return 0;
+		}
+
+		rdev_chain(delta, rdev, 0, 0);
+
+		/* Re-size rdev to only contain the data. i.e. remove metadata. */
+		data_size = md->data_size;
+		return rdev_chain(rdev, rdev, md_size, data_size);
 	}
 
-	/* Re-size rdev to only contain the data. i.e. remove metadata. */
-	data_size = md->data_size;
-	return rdev_chain(rdev, rdev, md_size, data_size);
+	return -1;
 }
 
 ssize_t mrc_cache_load_current(int type, uint32_t version, void *buffer,
 			      size_t buffer_size)
 {
 	struct region_device rdev;
+	struct region_device delta;
 	struct mrc_metadata md;
 	ssize_t data_size;
+	size_t age;
 
-	if (mrc_cache_find_current(type, version, &rdev, &md) < 0)
-		return -1;
+	for (age = 0; mrc_cache_find_current(type, version, &age, &rdev, &delta, &md) == 0;
+	     age++) {
+		data_size = region_device_sz(&rdev);
+		if (buffer_size < data_size)
+			continue;
 
-	data_size = region_device_sz(&rdev);
-	if (buffer_size < data_size)
-		return -1;
+		if (rdev_readat(&rdev, buffer, 0, data_size) != data_size)
+			continue;
 
-	if (rdev_readat(&rdev, buffer, 0, data_size) != data_size)
-		return -1;
+		if (mrc_delta_apply(&delta, buffer, data_size) < 0)
+			continue;
 
-	if (mrc_data_valid(type, &md, buffer, data_size) < 0)
-		return -1;
+		if (mrc_data_valid(type, &md, buffer, data_size) == 0)
+			return data_size;
+	}
+
+	return -1;
+}
+
+/*
+ * A delta update can't be mapped directly. The patched copy is made in the CBFS cache,
+ * which is also where rdev_mmap() places data from boot media that isn't memory-mapped.
+ */
+static void *mrc_delta_map(const struct region_device *base,
+			   const struct region_device *delta)
+{
+	const size_t size = region_device_sz(base);
+	void *data = mem_pool_alloc(&cbfs_cache, size);
 
-	return data_size;
+	if (data == NULL) {
+		printk(BIOS_INFO, "MRC: no room in CBFS cache to apply delta update.\n");
+		return NULL;
+	}
+
+	if (rdev_readat(base, data, 0, size) != size ||
+	    mrc_delta_apply(delta, data, size) < 0) {
+		mem_pool_free(&cbfs_cache, data);
+		return NULL;
+	}
+
+	return data;
 }
 
 void *mrc_cache_current_mmap_leak(int type, uint32_t version,
 				  size_t *data_size)
 {
 	struct region_device rdev;
+	struct region_device delta;
 	void *data;
 	size_t region_device_size;
 	struct mrc_metadata md;
+	size_t age;
+
+	for (age = 0; mrc_cache_find_current(type, version, &age, &rdev, &delta, &md) == 0;
+	     age++) {
+		region_device_size = region_device_sz(&rdev);
+
+		if (region_device_sz(&delta)) {
+			/* Older updates may still be usable without a copy. */
+			data = mrc_delta_map(&rdev, &delta);
+			if (data == NULL)
+				continue;
+		} else {
+			data = rdev_mmap_full(&rdev);
+			if (data == NULL) {
+				printk(BIOS_INFO, "MRC: mmap failure.\n");
+				return NULL;
+			}
+		}
 
-	if (mrc_cache_find_current(type, version, &rdev, &md) < 0)
-		return NULL;
-
-	region_device_size = region_device_sz(&rdev);
-	if (data_size)
-		*data_size = region_device_size;
-	data = rdev_mmap_full(&rdev);
+		if (mrc_data_valid(type, &md, data, region_device_size) == 0) {
+			if (data_size)
+				*data_size = region_device_size;
+			return data;
+		}
 
-	if (data == NULL) {
-		printk(BIOS_INFO, "MRC: mmap failure.\n");
-		return NULL;
+		if (region_device_sz(&delta))
+			mem_pool_free(&cbfs_cache, data);
+		else
+			rdev_munmap(&rdev, data);
 	}
 
-	if (mrc_data_valid(type, &md, data, region_device_size) < 0)
-		return NULL;
-
-	return data;
+	return NULL;
 }
 
 static bool mrc_cache_needs_update(const struct region_device *rdev,
@@ -383,6 +575,16 @@ static bool mrc_cache_needs_update(const struct region_device *rdev,
 	void *mapping;
 	size_t old_data_size = region_device_sz(rdev) - sizeof(struct mrc_metadata);
 	bool need_update = false;
+	struct region_device header;
+	struct mrc_metadata md;
+
+	/* A delta update is current if it patches to the same data. */
+	if (rdev_readat(rdev, &md, 0, sizeof(md)) == sizeof(md) &&
+	    md.signature == MRC_DELTA_SIGNATURE && rdev_chain_full(&header, rdev) == 0 &&
+	    mrc_header_valid(&header, &md) == 0)
+		return md.data_size != new_md->data_size ||
+		       md.data_hash != new_md->data_hash ||
+		       md.version != new_md->version;
 
 	if (new_data_size != old_data_size)
 		return true;
@@ -428,6 +630,110 @@ static void log_event_cache_update(uint8_t slot, enum result res)
 		printk(BIOS_ERR, "Failed to log mem cache update event.\n");
 }
 
+/*
+ * Collects the ranges where |new| differs from |old|. Short stretches of equal bytes are
+ * merged into the surrounding range since a record header costs more. Returns the number
+ * of records, or -1 if more than |max| would be needed.
+ */
+static int mrc_delta_encode(const uint8_t *old, const uint8_t *new, size_t size,
+			    struct mrc_delta_record *recs, int max)
+{
+	size_t i = 0, j, end;
+	int n = 0;
+
+	while (i < size) {
+		if (old[i] == new[i]) {
+			i++;
+			continue;
+		}
+
+		end = i + 1;
+		for (j = end; j < size && j - end <= sizeof(*recs); j++)
+			if (old[j] != new[j])
+				end = j + 1;
+
+		if (n == max)
+			return -1;
+
+		recs[n].offset = i;
+		recs[n].size = end - i;
+		n++;
+		i = end;
+	}
+
+	return n;
+}
+
+/*
+ * Appends the changes against the latest full update instead of the whole data. Returns
+ * 0 on success, < 0 if the update failed and > 0 if a full update has to be written:
+ * there is no usable base, too much changed, or the region would have to be emptied,
+ * which would drop the base. The full update then also becomes the new base.
+ */
+static int mrc_cache_update_delta(struct region_file *cache_file,
+				  const struct mrc_metadata *new_md,
+				  const void *new_data, size_t new_data_size)
+{
+	struct mrc_delta_record recs[MRC_DELTA_MAX_RECORDS];
+	struct update_region_file_entry entries[1 + 2 * MRC_DELTA_MAX_RECORDS];
+	struct mrc_delta_metadata dmd;
+	struct region_device base;
+	const uint8_t *old_data;
+	size_t delta_size = 0;
+	int n, i;
+
+	if (mrc_find_full_update(cache_file, 0, NULL, &dmd.md, &base) < 0 ||
+	    dmd.md.version != new_md->version || dmd.md.data_size != new_data_size)
+		return 1;
+
+	old_data = rdev_mmap_full(&base);
+	if (old_data == NULL)
+		return 1;
+
+	/* Don't build on a base that wouldn't load. */
+	if (xxh32(old_data, new_data_size, 0) != dmd.md.data_hash) {
+		rdev_munmap(&base, (void *)old_data);
+		return 1;
+	}
+
+	n = mrc_delta_encode(old_data, new_data, new_data_size, recs, ARRAY_SIZE(recs));
+	rdev_munmap(&base, (void *)old_data);
+	if (n < 0)
+		return 1;
+
+	for (i = 0; i < n; i++) {
+		entries[1 + 2 * i] = (struct update_region_file_entry){
+			.size = sizeof(recs[i]),
+			.data = &recs[i],
+		};
+		entries[2 + 2 * i] = (struct update_region_file_entry){
+			.size = recs[i].size,
+			.data = (const uint8_t *)new_data + recs[i].offset,
+		};
+		delta_size += sizeof(recs[i]) + recs[i].size;
+	}
+
+	if (delta_size > new_data_size / 4 ||
+	    !region_file_update_fits(cache_file, sizeof(dmd) + delta_size))
+		return 1;
+
+	dmd.base_hash = dmd.md.data_hash;
+	dmd.md = *new_md;
+	dmd.md.signature = MRC_DELTA_SIGNATURE;
+	dmd.md.header_hash = 0;
+	dmd.delta_size = delta_size;
+	dmd.md.header_hash = xxh32(&dmd, sizeof(dmd), 0);
+
+	entries[0] = (struct update_region_file_entry){
+		.size = sizeof(dmd),
+		.data = &dmd,
+	};
+
+	printk(BIOS_DEBUG, "MRC: writing %zu byte delta in %d records.\n", delta_size, n);
+
+	return region_file_update_data_arr(cache_file, entries, 1 + 2 * n);
+}
+
 /* During ramstage this code purposefully uses incoherent transactions between
  * read and write. The read assumes a memory-mapped boot device that can be used
  * to quickly locate and compare the up-to-date data. However, when an update
@@ -446,8 +752,8 @@ static void update_mrc_cache_by_type(int type,
 	struct incoherent_rdev backing_irdev;
 	const struct region_device *backing_rdev;
 	struct region_device latest_rdev;
-	const bool fail_bad_data = false;
 	uint32_t hash_idx;
+	int ret = 1;
 
 	cr = lookup_region(&region, type);
 
@@ -477,8 +783,7 @@ static void update_mrc_cache_by_type(int type,
 					   backing_rdev,
 					   &md,
 					   &cache_file,
-					   &latest_rdev,
-					   fail_bad_data) < 0)
+					   &latest_rdev) < 0)
 
 		return;
 
@@ -490,6 +795,9 @@ static void update_mrc_cache_by_type(int type,
 
 	printk(BIOS_DEBUG, "MRC: cache data '%s' needs update.\n", cr->name);
 
+	if (CONFIG(MRC_CACHE_DELTA_UPDATES))
+		ret = mrc_cache_update_delta(&cache_file, new_md, new_data, new_data_size);
+
 	struct update_region_file_entry entries[] = {
 		[0] = {
 			.size = sizeof(*new_md),
@@ -500,7 +808,10 @@ static void update_mrc_cache_by_type(int type,
 			.data = new_data,
 		},
 	};
-	if (region_file_update_data_arr(&cache_file, entries, ARRAY_SIZE(entries)) < 0) {
+	if (ret > 0)
+		ret = region_file_update_data_arr(&cache_file, entries, ARRAY_SIZE(entries));
+
+	if (ret < 0) {
 		printk(BIOS_ERR, "MRC: failed to update '%s'.\n", cr->name);
 		log_event_cache_update(cr->elog_slot, UPDATE_FAILURE);
 	} else {
@@ -676,7 +987,7 @@ static void update_mrc_cache_from_cbmem(int type)
 					sizeof(struct mrc_metadata));
 }
 
-static void finalize_mrc_cache(void *unused)
+static void write_mrc_cache(void *unused)
 {
 	if (CONFIG(MRC_STASH_TO_CBMEM)) {
 		update_mrc_cache_from_cbmem(MRC_TRAINING_DATA);
@@ -690,6 +1001,17 @@ static void finalize_mrc_cache(void *unused)
 	protect_mrc_region();
 }
 
+static struct nv_write mrc_cache_nv_update = {
+	.name = "MRC cache",
+	.commit = write_mrc_cache,
+};
+
+static void finalize_mrc_cache(void *unused)
+{
+	if (!nv_write_defer(&mrc_cache_nv_update))
+		write_mrc_cache(NULL);
+}
+
 int mrc_cache_stash_data(int type, uint32_t version, const void *data,
 			 size_t size)
 {
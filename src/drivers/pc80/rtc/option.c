@@ -50,6 +50,27 @@ static enum cb_err get_cmos_value(unsigned long bit, unsigned long length,
 	return CB_SUCCESS;
 }
 
+/*
+ * Verifying the checksum reads the whole checked range through the index/data ports,
+ * which took longer than anything else in an option lookup. The result is kept for
+ * the rest of the stage and only updated when this file writes the range. In SMM the
+ * OS may have written CMOS since the last SMI, so it is checked every time there.
+ */
+static enum {
+	LB_CKS_UNKNOWN,
+	LB_CKS_VALID,
+	LB_CKS_INVALID,
+} lb_cks_state;
+
+int cmos_lb_cks_valid(void)
+{
+	if (ENV_SMM || lb_cks_state == LB_CKS_UNKNOWN)
+		lb_cks_state = cmos_checksum_valid(LB_CKS_RANGE_START, LB_CKS_RANGE_END,
+						   LB_CKS_LOC) ? LB_CKS_VALID : LB_CKS_INVALID;
+
+	return lb_cks_state == LB_CKS_VALID;
+}
+
 static struct cmos_option_table *get_cmos_layout(void)
 {
 	static struct cmos_option_table *ct = NULL;
@@ -105,7 +126,7 @@ static enum cb_err cmos_get_uint_option(unsigned int *dest, const char *name)
 		return CB_ERR_ARG;
 	}
 
-	if (!cmos_checksum_valid(LB_CKS_RANGE_START, LB_CKS_RANGE_END, LB_CKS_LOC))
+	if (!cmos_lb_cks_valid())
 		return CB_CMOS_CHECKSUM_INVALID;
 
 	if (get_cmos_value(ce->bit, ce->length, dest) != CB_SUCCESS)
@@ -157,6 +178,7 @@ static enum cb_err set_cmos_value(unsigned long bit, unsigned long length,
 	if (chksum_update_needed) {
 		cmos_set_checksum(LB_CKS_RANGE_START, LB_CKS_RANGE_END,
 				  LB_CKS_LOC);
+		lb_cks_state = LB_CKS_VALID;
 	}
 	return CB_SUCCESS;
 }
@@ -192,11 +214,6 @@ enum cb_err set_uint_option(const char *name, unsigned int value)
 	return cmos_set_uint_option(name, &value);
 }
 
-int cmos_lb_cks_valid(void)
-{
-	return cmos_checksum_valid(LB_CKS_RANGE_START, LB_CKS_RANGE_END, LB_CKS_LOC);
-}
-
 void sanitize_cmos(void)
 {
 	const unsigned char *cmos_default;
@@ -220,5 +237,6 @@ void sanitize_cmos(void)
 		cmos_write_inner(cmos_default[LB_CKS_LOC], LB_CKS_LOC);
 		cmos_write_inner(cmos_default[LB_CKS_LOC + 1], LB_CKS_LOC + 1);
 		cmos_restore_rtc(control_state);
+		lb_cks_state = LB_CKS_UNKNOWN;
 	}
 }
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <console/console.h>
+#include <commonlib/helpers.h>
 #include <commonlib/region.h>
 #include <cpu/x86/smm.h>
 #include <smmstore.h>
@@ -60,6 +61,26 @@ static uint32_t smmstorev1_exec(uint8_t command, void *param)
 		break;
 	}
 
+	case SMMSTORE_CMD_LOOKUP: {
+		printk(BIOS_DEBUG, "Looking up key in SMM store\n");
+		struct smmstore_params_lookup *params = param;
+		uint32_t valsize;
+
+		if (range_check(params, sizeof(*params)) != 0)
+			break;
+		if (range_check(params->key, params->keysize) != 0)
+			break;
+		if (range_check(params->val, params->valsize) != 0)
+			break;
+
+		valsize = MIN(params->valsize, UINT32_MAX);
+		if (smmstore_lookup_data(params->key, params->keysize,
+					 params->val, &valsize) == 0)
+			ret = SMMSTORE_RET_SUCCESS;
+		params->valsize = valsize;
+		break;
+	}
+
 	case SMMSTORE_CMD_CLEAR: {
 		if (smmstore_clear_region() == 0)
 			ret = SMMSTORE_RET_SUCCESS;
@@ -126,6 +147,20 @@ static uint32_t smmstorev2_exec(uint8_t command, void *param)
 			ret = SMMSTORE_RET_SUCCESS;
 		break;
 	}
+	case SMMSTORE_CMD_RAW_BATCH: {
+		printk(BIOS_DEBUG, "Raw batch on SMM store, param = %p\n", param);
+		struct smmstore_params_raw_batch *params = param;
+		uint32_t completed;
+
+		if (range_check(params, sizeof(*params)) != 0)
+			break;
+
+		if (smmstore_rawbatch_region(params->list_offset, params->num_ops,
+					     &completed) == 0)
+			ret = SMMSTORE_RET_SUCCESS;
+		params->completed = completed;
+		break;
+	}
 	default:
 		printk(BIOS_DEBUG,
 			"Unknown SMM store v2 command: 0x%02x\n", command);
@@ -8,7 +8,9 @@
 #include <fmap.h>
 #include <fmap_config.h>
 #include <smmstore.h>
+#include <string.h>
 #include <types.h>
+#include <xxhash.h>
 
 #define SMMSTORE_REGION "SMMSTORE"
 
@@ -20,7 +22,7 @@ _Static_assert(SMM_BLOCK_SIZE <= FMAP_SECTION_SMMSTORE_SIZE,
 	       "SMMSTORE FMAP region must be at least 64K");
 
 /*
- * The region format is still not finalized, but so far it looks like this:
+ * Version 1 keeps a log of key/value entries:
  *   (
  *    uint32le_t key_sz
  *    uint32le_t value_sz
@@ -33,12 +35,22 @@ _Static_assert(SMM_BLOCK_SIZE <= FMAP_SECTION_SMMSTORE_SIZE,
  *
  * active needs to be set to 0x00 for the entry to be valid. This satisfies
  * the constraint that entries are either complete or will be ignored, as long
- * as flash is written sequentially and into a fully erased block.
+ * as flash is written sequentially and into a fully erased block. The latest
+ * valid entry for a key wins.
  *
- * Future additions to the format will split the region in half with an active
- * block marker to allow safe compaction (ie. write the new data in the unused
- * region, mark it active after the write completed). Otherwise a well-timed
- * crash/reboot could clear out all variables.
+ * The region is split in half and the log lives in one of the halves, behind
+ * a header:
+ *   uint32le_t magic = SMMSTORE_V1_MAGIC
+ *   uint32le_t generation
+ *
+ * The half with a valid header and the newer generation is active. When the
+ * active log is full, the latest entry of each key is copied into the other
+ * half after erasing it, and its header is written last. A crash during the
+ * compaction leaves the old half active.
+ *
+ * Stores written before the split have no header and use the whole region
+ * as the log. They are converted by their first compaction, which is only
+ * possible if the log still ends in the first half.
  */
 
 static enum cb_err lookup_store_region(struct region *region)
@@ -112,120 +124,441 @@ int smmstore_lookup_region(struct region_device *rstore)
 	*rstore = rdev;
 	return ret;
 }
+#define SMMSTORE_V1_MAGIC	0x534d5331	/* "SMS1" */
+#define SMMSTORE_V1_END		0xffffffff
+#define SMMSTORE_V1_INDEX_SLOTS	256
+
+struct smmstore_v1_header {
+	uint32_t magic;
+	uint32_t generation;
+} __packed;
+
 /*
- * Read entire store into user provided buffer
- *
- * returns 0 on success, -1 on failure
- * writes up to `*bufsize` bytes into `buf` and updates `*bufsize`
+ * Where the active log is and an index of its keys. This lives in SMRAM and
+ * is rebuilt with a single scan of the log when it's first needed, after a
+ * compaction or when the flash changed underneath. Each used index slot holds
+ * the offset of the latest entry of one key plus one. If more keys are stored
+ * than there are slots, lookups fall back to scanning the log.
  */
-int smmstore_read_region(void *buf, ssize_t *bufsize)
+static struct {
+	bool valid;
+	bool legacy;
+	size_t log_offset;
+	size_t log_size;
+	uint32_t generation;
+	size_t end;
+	bool index_full;
+	uint32_t index[SMMSTORE_V1_INDEX_SLOTS];
+} v1;
+
+static size_t v1_entry_size(uint32_t k_sz, uint32_t v_sz)
 {
-	struct region_device store;
+	return ALIGN_UP(2 * sizeof(uint32_t) + k_sz + v_sz + 1, sizeof(uint32_t));
+}
 
-	if (bufsize == NULL)
+/* Returns 1 for an entry, 0 for the end marker and -1 on error. */
+static int v1_read_entry(const struct region_device *log, size_t offset,
+			 uint32_t *k_sz, uint32_t *v_sz, bool *active)
+{
+	const size_t data_sz = region_device_sz(log);
+	uint8_t flag;
+
+	if (rdev_readat(log, k_sz, offset, sizeof(*k_sz)) < 0) {
+		printk(BIOS_WARNING, "failed reading key size\n");
 		return -1;
+	}
 
-	if (lookup_store(&store) < 0) {
-		printk(BIOS_WARNING, "reading region failed\n");
+	if (*k_sz == SMMSTORE_V1_END)
+		return 0;
+
+	/* something is fishy here:
+	 * Avoid wrapping (since data_size < MAX_UINT32_T / 2) while
+	 * other problems are covered by the bounds check below.
+	 */
+	if (*k_sz > data_sz) {
+		printk(BIOS_WARNING, "key size out of bounds\n");
 		return -1;
 	}
 
-	ssize_t tx = MIN(*bufsize, region_device_sz(&store));
-	*bufsize = rdev_readat(&store, buf, 0, tx);
+	if (rdev_readat(log, v_sz, offset + sizeof(*k_sz), sizeof(*v_sz)) < 0) {
+		printk(BIOS_WARNING, "failed reading value size\n");
+		return -1;
+	}
 
-	if (*bufsize < 0)
+	if (*v_sz > data_sz || offset + v1_entry_size(*k_sz, *v_sz) > data_sz) {
+		printk(BIOS_WARNING, "value size out of bounds\n");
 		return -1;
+	}
 
-	return 0;
+	if (rdev_readat(log, &flag, offset + 2 * sizeof(uint32_t) + *k_sz + *v_sz,
+			sizeof(flag)) < 0)
+		return -1;
+
+	*active = flag == 0;
+
+	return 1;
 }
 
-static enum cb_err scan_end(struct region_device *store)
+/*
+ * Compares the key of the entry at |offset| with |key_sz| bytes of |key|, or
+ * with the key of the entry at |other| if |key| is NULL.
+ */
+static bool v1_key_equal(const struct region_device *log, size_t offset,
+			 const void *key, size_t other, uint32_t key_sz)
 {
-	/* scan for end */
-	ssize_t end = 0;
-	uint32_t k_sz, v_sz;
-	const ssize_t data_sz = region_device_sz(store);
-	while (end < data_sz) {
-		/* make odd corner cases identifiable, eg. invalid v_sz */
-		k_sz = 0;
+	uint8_t a[32], b[32];
+	uint32_t k_sz;
+	size_t done, n;
+
+	if (rdev_readat(log, &k_sz, offset, sizeof(k_sz)) < 0 || k_sz != key_sz)
+		return false;
+
+	offset += 2 * sizeof(uint32_t);
+	other += 2 * sizeof(uint32_t);
+
+	for (done = 0; done < key_sz; done += n) {
+		n = MIN(key_sz - done, sizeof(a));
+		if (rdev_readat(log, a, offset + done, n) < 0)
+			return false;
+		if (key == NULL && rdev_readat(log, b, other + done, n) < 0)
+			return false;
+		if (memcmp(a, key ? (const uint8_t *)key + done : b, n))
+			return false;
+	}
 
-		if (rdev_readat(store, &k_sz, end, sizeof(k_sz)) < 0) {
-			printk(BIOS_WARNING, "failed reading key size\n");
-			return CB_ERR;
-		}
+	return true;
+}
+
+static uint32_t v1_key_hash(const struct region_device *log, size_t offset,
+			    const void *key, uint32_t key_sz)
+{
+	struct xxh32_state state;
+	uint8_t buf[32];
+	size_t done, n;
+
+	if (key)
+		return xxh32(key, key_sz, 0);
 
-		/* found the end */
-		if (k_sz == 0xffffffff)
+	xxh32_reset(&state, 0);
+	for (done = 0; done < key_sz; done += n) {
+		n = MIN(key_sz - done, sizeof(buf));
+		if (rdev_readat(log, buf, offset + 2 * sizeof(uint32_t) + done, n) < 0)
 			break;
+		xxh32_update(&state, buf, n);
+	}
 
-		/* something is fishy here:
-		 * Avoid wrapping (since data_size < MAX_UINT32_T / 2) while
-		 * other problems are covered by the loop condition
-		 */
-		if (k_sz > data_sz) {
-			printk(BIOS_WARNING, "key size out of bounds\n");
-			return CB_ERR;
-		}
+	return xxh32_digest(&state);
+}
 
-		if (rdev_readat(store, &v_sz, end + sizeof(k_sz), sizeof(v_sz)) < 0) {
-			printk(BIOS_WARNING, "failed reading value size\n");
-			return CB_ERR;
-		}
+/*
+ * Returns the index slot of the key in |key|, or of the key of the entry at
+ * |offset| if |key| is NULL. That is either the slot of the key or the free
+ * slot it would go into. Returns -1 if the key isn't indexed and there is no
+ * room left.
+ */
+static int v1_index_slot(const struct region_device *log, size_t offset,
+			 const void *key, uint32_t key_sz)
+{
+	uint32_t slot = v1_key_hash(log, offset, key, key_sz) % SMMSTORE_V1_INDEX_SLOTS;
+	int i;
+
+	for (i = 0; i < SMMSTORE_V1_INDEX_SLOTS; i++) {
+		if (!v1.index[slot] ||
+		    v1_key_equal(log, v1.index[slot] - 1, key, offset, key_sz))
+			return slot;
+		slot = (slot + 1) % SMMSTORE_V1_INDEX_SLOTS;
+	}
+
+	return -1;
+}
+
+static void v1_index_add(const struct region_device *log, size_t offset, uint32_t k_sz)
+{
+	int slot;
+
+	if (v1.index_full)
+		return;
+
+	slot = v1_index_slot(log, offset, NULL, k_sz);
+	if (slot < 0) {
+		printk(BIOS_INFO, "smm store: more than %d keys, index disabled\n",
+		       SMMSTORE_V1_INDEX_SLOTS);
+		v1.index_full = true;
+		return;
+	}
+
+	v1.index[slot] = offset + 1;
+}
+
+/*
+ * Returns the offset of the latest valid entry for the key in |key|, or for
+ * the key of the entry at |offset| if |key| is NULL. Returns -1 if none.
+ */
+static ssize_t v1_find(const struct region_device *log, const void *key, size_t offset,
+		       uint32_t key_sz)
+{
+	uint32_t k_sz, v_sz;
+	bool active;
+	ssize_t found = -1;
+	size_t pos;
+	int slot;
+
+	if (!v1.index_full) {
+		slot = v1_index_slot(log, offset, key, key_sz);
+		return slot >= 0 && v1.index[slot] ? v1.index[slot] - 1 : -1;
+	}
+
+	for (pos = 0; v1_read_entry(log, pos, &k_sz, &v_sz, &active) > 0;
+	     pos += v1_entry_size(k_sz, v_sz)) {
+		if (active && v1_key_equal(log, pos, key, offset, key_sz))
+			found = pos;
+	}
+
+	return found;
+}
+
+static enum cb_err v1_read_header(const struct region_device *store, size_t offset,
+				  struct smmstore_v1_header *hdr)
+{
+	if (rdev_readat(store, hdr, offset, sizeof(*hdr)) != sizeof(*hdr))
+		return CB_ERR;
+
+	return hdr->magic == SMMSTORE_V1_MAGIC ? CB_SUCCESS : CB_ERR;
+}
 
-		if (v_sz > data_sz) {
-			printk(BIOS_WARNING, "value size out of bounds\n");
+/* Finds the active log and builds the index. */
+static enum cb_err v1_scan(struct region_device *store)
+{
+	const size_t half = region_device_sz(store) / 2;
+	struct smmstore_v1_header a = { 0 }, b = { 0 };
+	struct region_device log;
+	uint32_t k_sz, v_sz;
+	bool active;
+	bool a_ok = v1_read_header(store, 0, &a) == CB_SUCCESS;
+	bool b_ok = v1_read_header(store, half, &b) == CB_SUCCESS;
+	int ret;
+
+	memset(&v1, 0, sizeof(v1));
+
+	if (b_ok && (!a_ok || (int32_t)(b.generation - a.generation) > 0)) {
+		v1.log_offset = half;
+		v1.generation = b.generation;
+	} else if (a_ok) {
+		v1.generation = a.generation;
+	} else if (a.magic == SMMSTORE_V1_END) {
+		/* Erased, start a fresh log in the first half. */
+		a.magic = SMMSTORE_V1_MAGIC;
+		a.generation = 0;
+		if (rdev_writeat(store, &a, 0, sizeof(a)) != sizeof(a)) {
+			printk(BIOS_WARNING, "smm store: failed writing header\n");
 			return CB_ERR;
 		}
+	} else {
+		v1.legacy = true;
+	}
 
-		end += sizeof(k_sz) + sizeof(v_sz) + k_sz + v_sz + 1;
-		end = ALIGN_UP(end, sizeof(uint32_t));
+	if (v1.legacy) {
+		v1.log_size = region_device_sz(store);
+	} else {
+		v1.log_offset += sizeof(a);
+		v1.log_size = half - sizeof(a);
 	}
 
-	printk(BIOS_DEBUG, "used smm store size might be 0x%zx bytes\n", end);
+	if (rdev_chain(&log, store, v1.log_offset, v1.log_size))
+		return CB_ERR;
 
-	if (k_sz != 0xffffffff) {
-		printk(BIOS_WARNING,
-			"EOF of data marker looks invalid: 0x%x\n", k_sz);
+	while ((ret = v1_read_entry(&log, v1.end, &k_sz, &v_sz, &active)) > 0) {
+		if (active)
+			v1_index_add(&log, v1.end, k_sz);
+		v1.end += v1_entry_size(k_sz, v_sz);
+	}
+
+	printk(BIOS_DEBUG, "used smm store size might be 0x%zx bytes\n", v1.end);
+
+	if (ret < 0) {
+		printk(BIOS_WARNING, "EOF of data marker looks invalid\n");
+		return CB_ERR;
+	}
+
+	v1.valid = true;
+
+	return CB_SUCCESS;
+}
+
+/* Returns the active log, rescanning the store if needed. */
+static enum cb_err v1_open(struct region_device *log)
+{
+	struct region_device store;
+	uint32_t marker;
+
+	if (lookup_store(&store) < 0) {
+		printk(BIOS_WARNING, "reading region failed\n");
+		return CB_ERR;
+	}
+
+	/* Cope with flash changing underneath, as a rescan would. */
+	if (v1.valid && (rdev_chain(log, &store, v1.log_offset, v1.log_size) ||
+			 rdev_readat(log, &marker, v1.end, sizeof(marker)) != sizeof(marker) ||
+			 marker != SMMSTORE_V1_END))
+		v1.valid = false;
+
+	if (!v1.valid && v1_scan(&store) != CB_SUCCESS)
+		return CB_ERR;
+
+	return rdev_chain(log, &store, v1.log_offset, v1.log_size) ? CB_ERR : CB_SUCCESS;
+}
+
+/*
+ * Legacy logs are moved to the second half before they grow past the first
+ * one. Those that already did can only be appended to until the store is full.
+ */
+static size_t v1_log_limit(void)
+{
+	const size_t half = v1.log_size / 2;
+
+	if (v1.legacy && v1.end + sizeof(struct smmstore_v1_header) <= half)
+		return half - sizeof(struct smmstore_v1_header);
+
+	return v1.log_size;
+}
+
+/* Copies the latest entry of each key into the inactive half. */
+static enum cb_err v1_compact(const struct region_device *log)
+{
+	struct region_device store, target;
+	struct smmstore_v1_header hdr = {
+		.magic = SMMSTORE_V1_MAGIC,
+		.generation = v1.generation + 1,
+	};
+	uint8_t buf[64];
+	uint32_t k_sz, v_sz;
+	bool active;
+	size_t half, pos, out = 0, done, n, size;
+
+	if (lookup_store(&store) < 0)
+		return CB_ERR;
+
+	half = region_device_sz(&store) / 2;
+
+	if (v1.legacy && v1.end + sizeof(hdr) > half) {
+		printk(BIOS_WARNING, "smm store: legacy log too large to compact\n");
 		return CB_ERR;
 	}
 
-	if (rdev_chain(store, store, end, data_sz - end))
+	/* Legacy logs start at 0 and are moved to the second half. */
+	if (rdev_chain(&target, &store, v1.legacy || v1.log_offset < half ? half : 0, half))
 		return CB_ERR;
 
+	printk(BIOS_INFO, "smm store: compacting 0x%zx bytes\n", v1.end);
+
+	if (rdev_eraseat(&target, 0, half) != half) {
+		printk(BIOS_WARNING, "smm store: erasing spare half failed\n");
+		return CB_ERR;
+	}
+
+	for (pos = 0; v1_read_entry(log, pos, &k_sz, &v_sz, &active) > 0; pos += size) {
+		size = v1_entry_size(k_sz, v_sz);
+
+		if (!active || v1_find(log, NULL, pos, k_sz) != (ssize_t)pos)
+			continue;
+
+		/* Everything up to and including the active byte. */
+		size = 2 * sizeof(uint32_t) + k_sz + v_sz + 1;
+		for (done = 0; done < size; done += n) {
+			n = MIN(size - done, sizeof(buf));
+			if (rdev_readat(log, buf, pos + done, n) != n ||
+			    rdev_writeat(&target, buf, sizeof(hdr) + out + done, n) != n) {
+				printk(BIOS_WARNING, "smm store: copying entry failed\n");
+				return CB_ERR;
+			}
+		}
+		size = v1_entry_size(k_sz, v_sz);
+		out += size;
+	}
+
+	/* Only now the new half takes over. */
+	if (rdev_writeat(&target, &hdr, 0, sizeof(hdr)) != sizeof(hdr)) {
+		printk(BIOS_WARNING, "smm store: failed writing header\n");
+		return CB_ERR;
+	}
+
+	v1.valid = false;
+
+	printk(BIOS_INFO, "smm store: 0x%zx bytes left after compaction\n", out);
+
 	return CB_SUCCESS;
 }
+
 /*
- * Append data to region
+ * Read the active log into user provided buffer
  *
- * Returns 0 on success, -1 on failure
+ * returns 0 on success, -1 on failure
+ * writes up to `*bufsize` bytes into `buf` and updates `*bufsize`
  */
-int smmstore_append_data(void *key, uint32_t key_sz, void *value,
-			 uint32_t value_sz)
+int smmstore_read_region(void *buf, ssize_t *bufsize)
 {
-	struct region_device store;
+	struct region_device log;
 
-	if (lookup_store(&store) < 0) {
-		printk(BIOS_WARNING, "reading region failed\n");
+	if (bufsize == NULL)
+		return -1;
+
+	if (v1_open(&log) != CB_SUCCESS)
+		return -1;
+
+	ssize_t tx = MIN(*bufsize, region_device_sz(&log));
+	*bufsize = rdev_readat(&log, buf, 0, tx);
+
+	if (*bufsize < 0)
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Read the latest value of a key into user provided buffer
+ *
+ * Returns 0 on success, -1 on failure or if the key isn't in the store
+ * `*value_sz` is the buffer size and is updated to the size of the value,
+ * also when the buffer is too small
+ */
+int smmstore_lookup_data(void *key, uint32_t key_sz, void *value, uint32_t *value_sz)
+{
+	struct region_device log;
+	uint32_t k_sz, v_sz;
+	bool active;
+	ssize_t pos;
+
+	if (v1_open(&log) != CB_SUCCESS)
+		return -1;
+
+	pos = v1_find(&log, key, 0, key_sz);
+	if (pos < 0 || v1_read_entry(&log, pos, &k_sz, &v_sz, &active) <= 0 || !active)
+		return -1;
+
+	if (*value_sz < v_sz) {
+		*value_sz = v_sz;
 		return -1;
 	}
 
-	ssize_t offset = 0;
-	ssize_t size;
-	uint8_t nul = 0;
-	if (scan_end(&store) != CB_SUCCESS)
+	*value_sz = v_sz;
+	if (rdev_readat(&log, value, pos + 2 * sizeof(uint32_t) + k_sz, v_sz) != v_sz)
 		return -1;
 
-	printk(BIOS_DEBUG, "used size looks legit\n");
+	return 0;
+}
+
+static int v1_write_entry(const struct region_device *log, void *key, uint32_t key_sz,
+			  void *value, uint32_t value_sz)
+{
+	ssize_t offset = 0;
+	struct region_device store;
+	uint8_t nul = 0;
 
 	printk(BIOS_DEBUG, "open (%zx, %zx) for writing\n",
-		region_device_offset(&store), region_device_sz(&store));
+		region_device_offset(log) + v1.end, region_device_sz(log) - v1.end);
 
-	size = sizeof(key_sz) + sizeof(value_sz) + key_sz + value_sz
-		+ sizeof(nul);
-	if (rdev_chain(&store, &store, 0, size)) {
-		printk(BIOS_WARNING, "not enough space for new data\n");
+	if (rdev_chain(&store, log, v1.end, v1_entry_size(key_sz, value_sz)))
 		return -1;
-	}
 
 	if (rdev_writeat(&store, &key_sz, offset, sizeof(key_sz))
 	    != sizeof(key_sz)) {
@@ -257,6 +590,45 @@ int smmstore_append_data(void *key, uint32_t key_sz, void *value,
 	return 0;
 }
 
+/*
+ * Append data to region, compacting the log if it is full
+ *
+ * Returns 0 on success, -1 on failure
+ */
+int smmstore_append_data(void *key, uint32_t key_sz, void *value,
+			 uint32_t value_sz)
+{
+	struct region_device log;
+	const size_t size = v1_entry_size(key_sz, value_sz);
+
+	if (v1_open(&log) != CB_SUCCESS)
+		return -1;
+
+	printk(BIOS_DEBUG, "used size looks legit\n");
+
+	/* Leave room for the end marker. */
+	if (v1.end + size + sizeof(uint32_t) > v1_log_limit() &&
+	    v1_compact(&log) == CB_SUCCESS && v1_open(&log) != CB_SUCCESS)
+		return -1;
+
+	if (v1.end + size + sizeof(uint32_t) > v1_log_limit()) {
+		printk(BIOS_WARNING, "not enough space for new data\n");
+		return -1;
+	}
+
+	/* Mark the index stale until the entry is complete. */
+	v1.valid = false;
+
+	if (v1_write_entry(&log, key, key_sz, value, value_sz) < 0)
+		return -1;
+
+	v1_index_add(&log, v1.end, key_sz);
+	v1.end += size;
+	v1.valid = true;
+
+	return 0;
+}
+
 /*
  * Clear region
  *
@@ -266,6 +638,8 @@ int smmstore_clear_region(void)
 {
 	struct region_device store;
 
+	v1.valid = false;
+
 	if (lookup_store(&store) < 0) {
 		printk(BIOS_WARNING, "smm store: reading region failed\n");
 		return -1;
@@ -375,18 +749,7 @@ static void *mmap_com_buf(struct region_device *com_buf, uint32_t offset, uint32
 	return ptr;
 }
 
-/**
- * Reads the specified block of the SMMSTORE and places it in the communication
- * buffer.
- * @param block_id The id of the block to operate on
- * @param offset Offset within the block.
- *               Must be smaller than the block size.
- * @param bufsize Size of chunk to read within the block.
- *                Must be smaller than the block size.
-
- * @return Returns -1 on error, 0 on success.
- */
-int smmstore_rawread_region(uint32_t block_id, uint32_t offset, uint32_t bufsize)
+static int rawread(uint32_t block_id, uint32_t offset, uint32_t bufsize, uint32_t bufoffset)
 {
 	struct region_device store;
 	struct region_device com_buf;
@@ -394,7 +757,7 @@ int smmstore_rawread_region(uint32_t block_id, uint32_t offset, uint32_t bufsize
 	if (lookup_block_in_store(&store, block_id) < 0)
 		return -1;
 
-	void *ptr = mmap_com_buf(&com_buf, offset, bufsize);
+	void *ptr = mmap_com_buf(&com_buf, bufoffset, bufsize);
 	if (!ptr)
 		return -1;
 
@@ -409,18 +772,7 @@ int smmstore_rawread_region(uint32_t block_id, uint32_t offset, uint32_t bufsize
 	return 0;
 }
 
-/**
- * Writes the specified block of the SMMSTORE by reading it from the communication
- * buffer.
- * @param block_id The id of the block to operate on
- * @param offset Offset within the block.
- *               Must be smaller than the block size.
- * @param bufsize Size of chunk to read within the block.
- *                Must be smaller than the block size.
-
- * @return Returns -1 on error, 0 on success.
- */
-int smmstore_rawwrite_region(uint32_t block_id, uint32_t offset, uint32_t bufsize)
+static int rawwrite(uint32_t block_id, uint32_t offset, uint32_t bufsize, uint32_t bufoffset)
 {
 	struct region_device store;
 	struct region_device com_buf;
@@ -433,7 +785,7 @@ int smmstore_rawwrite_region(uint32_t block_id, uint32_t offset, uint32_t bufsiz
 		return -1;
 	}
 
-	void *ptr = mmap_com_buf(&com_buf, offset, bufsize);
+	void *ptr = mmap_com_buf(&com_buf, bufoffset, bufsize);
 	if (!ptr)
 		return -1;
 
@@ -448,6 +800,38 @@ int smmstore_rawwrite_region(uint32_t block_id, uint32_t offset, uint32_t bufsiz
 	return 0;
 }
 
+/**
+ * Reads the specified block of the SMMSTORE and places it in the communication
+ * buffer.
+ * @param block_id The id of the block to operate on
+ * @param offset Offset within the block.
+ *               Must be smaller than the block size.
+ * @param bufsize Size of chunk to read within the block.
+ *                Must be smaller than the block size.
+
+ * @return Returns -1 on error, 0 on success.
+ */
+int smmstore_rawread_region(uint32_t block_id, uint32_t offset, uint32_t bufsize)
+{
+	return rawread(block_id, offset, bufsize, offset);
+}
+
+/**
+ * Writes the specified block of the SMMSTORE by reading it from the communication
+ * buffer.
+ * @param block_id The id of the block to operate on
+ * @param offset Offset within the block.
+ *               Must be smaller than the block size.
+ * @param bufsize Size of chunk to read within the block.
+ *                Must be smaller than the block size.
+
+ * @return Returns -1 on error, 0 on success.
+ */
+int smmstore_rawwrite_region(uint32_t block_id, uint32_t offset, uint32_t bufsize)
+{
+	return rawwrite(block_id, offset, bufsize, offset);
+}
+
 /**
  * Erases the specified block of the SMMSTORE. The communication buffer remains untouched.
  *
@@ -470,3 +854,61 @@ int smmstore_rawclear_region(uint32_t block_id)
 
 	return 0;
 }
+
+/**
+ * Runs a list of raw operations from the communication buffer in order, stopping
+ * at the first one that fails.
+ * @param list_offset Offset of the list of smmstore_raw_batch_op within the
+ *                    communication buffer.
+ * @param num_ops Number of operations in the list.
+ * @param completed Returns the number of operations that succeeded.
+ *
+ * @return Returns -1 on error, 0 on success.
+ */
+int smmstore_rawbatch_region(uint32_t list_offset, uint32_t num_ops, uint32_t *completed)
+{
+	struct region_device com_buf;
+	struct smmstore_raw_batch_op op;
+	int ret;
+
+	*completed = 0;
+
+	if (smmstore_rdev_chain(&com_buf) < 0) {
+		printk(BIOS_ERR, "smm store: lookup of com buffer failed\n");
+		return -1;
+	}
+
+	if (num_ops > (region_device_sz(&com_buf) - MIN(list_offset,
+			region_device_sz(&com_buf))) / sizeof(op)) {
+		printk(BIOS_ERR, "smm store: batch list out of range\n");
+		return -1;
+	}
+
+	for (; *completed < num_ops; (*completed)++) {
+		/* Work on a copy, the buffer is outside of SMRAM and can change. */
+		if (rdev_readat(&com_buf, &op, list_offset + *completed * sizeof(op),
+				sizeof(op)) != sizeof(op))
+			return -1;
+
+		switch (op.command) {
+		case SMMSTORE_CMD_RAW_READ:
+			ret = rawread(op.block_id, op.offset, op.bufsize, op.bufoffset);
+			break;
+		case SMMSTORE_CMD_RAW_WRITE:
+			ret = rawwrite(op.block_id, op.offset, op.bufsize, op.bufoffset);
+			break;
+		case SMMSTORE_CMD_RAW_CLEAR:
+			ret = smmstore_rawclear_region(op.block_id);
+			break;
+		default:
+			printk(BIOS_ERR, "smm store: unknown batch command 0x%x\n", op.command);
+			ret = -1;
+			break;
+		}
+
+		if (ret < 0)
+			return -1;
+	}
+
+	return 0;
+}
@@ -44,6 +44,14 @@ static const struct region_device_ops spi_ops = {
 static const struct region_device spi_rw =
 	REGION_DEV_INIT(&spi_ops, 0, CONFIG_ROM_SIZE);
 
+#if CONFIG(BOOT_DEVICE_SPI_FLASH_CACHE)
+static struct cache_region_device cache_dev;
+static struct cache_rdev_block cache_blocks[CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_BLOCKS];
+static uint8_t cache_buf[CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_BLOCKS *
+			 CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_BLOCK_SIZE];
+#endif
+static const struct region_device *spi_rw_rdev = &spi_rw;
+
 static void boot_device_rw_init(void)
 {
 	const int bus = CONFIG_BOOT_DEVICE_SPI_FLASH_BUS;
@@ -55,8 +63,19 @@ static void boot_device_rw_init(void)
 	/* Ensure any necessary setup is performed by the drivers. */
 	spi_init();
 
-	if (!spi_flash_probe(bus, cs, &sfg))
-		sfg_init_done = true;
+	if (spi_flash_probe(bus, cs, &sfg))
+		return;
+
+#if CONFIG(BOOT_DEVICE_SPI_FLASH_CACHE)
+	const struct region_device *cached = cache_region_device_init(&cache_dev,
+			&spi_rw, cache_blocks, cache_buf, ARRAY_SIZE(cache_blocks),
+			CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_BLOCK_SIZE,
+			CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_READAHEAD, NULL);
+	if (cached)
+		spi_rw_rdev = cached;
+#endif
+
+	sfg_init_done = true;
 }
 
 const struct region_device *boot_device_rw(void)
@@ -67,7 +86,7 @@ const struct region_device *boot_device_rw(void)
 	if (sfg_init_done != true)
 		return NULL;
 
-	return &spi_rw;
+	return spi_rw_rdev;
 }
 
 const struct spi_flash *boot_device_spi_flash(void)
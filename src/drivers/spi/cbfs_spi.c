@@ -79,6 +79,14 @@ static const struct region_device_ops spi_ops = {
 static struct mmap_helper_region_device mdev =
 	MMAP_HELPER_DEV_INIT(&spi_ops, 0, CONFIG_ROM_SIZE, &cbfs_cache);
 
+#if CONFIG(BOOT_DEVICE_SPI_FLASH_CACHE)
+static struct cache_region_device cache_dev;
+static struct cache_rdev_block cache_blocks[CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_BLOCKS];
+static uint8_t cache_buf[CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_BLOCKS *
+			 CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_BLOCK_SIZE];
+#endif
+static const struct region_device *spi_rdev = &mdev.rdev;
+
 void boot_device_init(void)
 {
 	int bus = CONFIG_BOOT_DEVICE_SPI_FLASH_BUS;
@@ -90,6 +98,15 @@ void boot_device_init(void)
 	if (spi_flash_probe(bus, cs, &spi_flash_info))
 		return;
 
+#if CONFIG(BOOT_DEVICE_SPI_FLASH_CACHE)
+	const struct region_device *cached = cache_region_device_init(&cache_dev,
+			&mdev.rdev, cache_blocks, cache_buf, ARRAY_SIZE(cache_blocks),
+			CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_BLOCK_SIZE,
+			CONFIG_BOOT_DEVICE_SPI_FLASH_CACHE_READAHEAD, &cbfs_cache);
+	if (cached)
+		spi_rdev = cached;
+#endif
+
 	spi_flash_init_done = true;
 }
 
@@ -99,7 +116,7 @@ const struct region_device *boot_device_ro(void)
 	if (spi_flash_init_done != true)
 		return NULL;
 
-	return &mdev.rdev;
+	return spi_rdev;
 }
 
 /* The read-only and read-write implementations are symmetric. */
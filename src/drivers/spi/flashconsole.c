@@ -7,7 +7,8 @@
 #include <console/flash.h>
 #include <types.h>
 
-#define LINE_BUFFER_SIZE 128
+#define FLASH_PAGE_SIZE 256
+#define LINE_BUFFER_SIZE (CONFIG(CONSOLE_SPI_FLASH_PAGE_WRITES) ? FLASH_PAGE_SIZE : 128)
 #define READ_BUFFER_SIZE 0x100
 
 static const struct region_device *rdev_ptr;
@@ -67,6 +68,8 @@ void flashconsole_init(void)
 	rdev_ptr = &rdev;
 }
 
+static void flashconsole_write(void);
+
 void flashconsole_tx_byte(unsigned char c)
 {
 	if (!rdev_ptr)
@@ -77,13 +80,29 @@ void flashconsole_tx_byte(unsigned char c)
 	if (line_offset < LINE_BUFFER_SIZE)
 		line_buffer[line_offset++] = c;
 
-	if (line_offset >= LINE_BUFFER_SIZE ||
-	    offset + line_offset >= region_size || c == '\n') {
-		flashconsole_tx_flush();
+	if (offset + line_offset >= region_size) {
+		flashconsole_write();
+	} else if (CONFIG(CONSOLE_SPI_FLASH_PAGE_WRITES)) {
+		/* The buffer starts at offset, program it once its page is full. */
+		if (IS_ALIGNED(offset + line_offset, FLASH_PAGE_SIZE))
+			flashconsole_write();
+	} else if (line_offset >= LINE_BUFFER_SIZE || c == '\n') {
+		flashconsole_write();
 	}
 }
 
 void flashconsole_tx_flush(void)
+{
+	if (!CONFIG(CONSOLE_SPI_FLASH_PAGE_WRITES))
+		flashconsole_write();
+}
+
+void flashconsole_sync(void)
+{
+	flashconsole_write();
+}
+
+static void flashconsole_write(void)
 {
 	size_t len = line_offset;
 	size_t region_size;
@@ -95,7 +114,7 @@ void flashconsole_tx_flush(void)
 	if (busy)
 		return;
 
-	if (!rdev_ptr)
+	if (!rdev_ptr || !len)
 		return;
 
 	busy = 1;
@@ -21,6 +21,7 @@
 #define CMD_MX25XX_RES		0xab	/* Release from DP, and Read Signature */
 
 #define MACRONIX_SR_WIP		(1 << 0)	/* Write-in-Progress */
+#define MACRONIX_SR_QE		(1 << 6)	/* Quad Enable */
 
 static const struct spi_flash_part_id flash_table[] = {
 	{
@@ -84,42 +85,56 @@ static const struct spi_flash_part_id flash_table[] = {
 		.id[0] = 0x2534,
 		.nr_sectors_shift = 8,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U1635E/MX25U1635F */
 		.id[0] = 0x2535,
 		.nr_sectors_shift = 9,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U3235E/MX25U3235F */
 		.id[0] = 0x2536,
 		.nr_sectors_shift = 10,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U6435E/MX25U6435F */
 		.id[0] = 0x2537,
 		.nr_sectors_shift = 11,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U12835F */
 		.id[0] = 0x2538,
 		.nr_sectors_shift = 12,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U25635F */
 		.id[0] = 0x2539,
 		.nr_sectors_shift = 13,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25U51235F */
 		.id[0] = 0x253a,
 		.nr_sectors_shift = 14,
 		.fast_read_dual_io_support = 1,
+		.fast_read_quad_output_support = 1,
+		.fast_read_quad_io_support = 1,
 	},
 	{
 		/* MX25L12855E */
@@ -145,6 +160,18 @@ static const struct spi_flash_part_id flash_table[] = {
 	},
 };
 
+static int macronix_quad_enabled(const struct spi_flash *flash)
+{
+	u8 status;
+	int ret;
+
+	ret = spi_flash_cmd(&flash->spi, CMD_MX25XX_RDSR, &status, sizeof(status));
+	if (ret)
+		return ret;
+
+	return !!(status & MACRONIX_SR_QE);
+}
+
 const struct spi_flash_vendor_info spi_flash_macronix_vi = {
 	.id = VENDOR_ID_MACRONIX,
 	.page_size_shift = 8,
@@ -153,4 +180,5 @@ const struct spi_flash_vendor_info spi_flash_macronix_vi = {
 	.ids = flash_table,
 	.nr_part_ids = ARRAY_SIZE(flash_table),
 	.desc = &spi_flash_pp_0x20_sector_desc,
+	.quad_enabled = macronix_quad_enabled,
 };
@@ -0,0 +1,314 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Serial Flash Discoverable Parameters (JESD216), used to drive parts that none
+ * of the vendor tables list.
+ */
+
+#include <commonlib/bsd/helpers.h>
+#include <console/console.h>
+#include <endian.h>
+#include <spi-generic.h>
+#include <spi_flash.h>
+#include <string.h>
+#include <types.h>
+
+#include "spi_flash_internal.h"
+
+#define CMD_READ_SFDP			0x5a
+#define SFDP_SIGNATURE			0x50444653 /* "SFDP" */
+
+/* Basic Flash Parameter Table */
+#define BFPT_ID_LSB			0x00
+#define BFPT_ID_MSB			0xff
+/* JESD216 has 9 DWORDs, JESD216A added the ones up to DWORD 16. */
+#define BFPT_DWORDS_MIN			9
+#define BFPT_DWORDS_MAX			16
+
+struct sfdp_header {
+	uint32_t signature;
+	uint8_t minor;
+	uint8_t major;
+	uint8_t nph; /* Number of parameter headers - 1 */
+	uint8_t reserved;
+} __packed;
+
+struct sfdp_param_header {
+	uint8_t id_lsb;
+	uint8_t minor;
+	uint8_t major;
+	uint8_t dwords;
+	uint8_t table_pointer[3];
+	uint8_t id_msb;
+} __packed;
+
+/* DWORD 1 */
+#define BFPT1_4K_ERASE_MASK		0x3
+#define  BFPT1_4K_ERASE			0x1
+#define BFPT1_WRITE_GRANULARITY_64	(1 << 2)
+#define BFPT1_4K_ERASE_CMD(x)		(((x) >> 8) & 0xff)
+#define BFPT1_FAST_READ_1_1_2		(1 << 16)
+#define BFPT1_ADDR_BYTES(x)		(((x) >> 17) & 0x3)
+#define  BFPT1_ADDR_3B			0
+#define  BFPT1_ADDR_3B_OR_4B		1
+#define  BFPT1_ADDR_4B			2
+#define BFPT1_FAST_READ_1_2_2		(1 << 20)
+#define BFPT1_FAST_READ_1_4_4		(1 << 21)
+#define BFPT1_FAST_READ_1_1_4		(1 << 22)
+
+/* DWORD 2 */
+#define BFPT2_DENSITY_POW2		(1U << 31)
+
+/* DWORDs 3 and 4 describe two read modes each, one per 16-bit half. */
+#define BFPT_READ_CLOCKS(x)		(((x) & 0x1f) + (((x) >> 5) & 0x7))
+#define BFPT_READ_CMD(x)		(((x) >> 8) & 0xff)
+
+/* DWORDs 8 and 9 describe two erase types each, one per 16-bit half. */
+#define BFPT_ERASE_SIZE_SHIFT(x)	((x) & 0xff)
+#define BFPT_ERASE_CMD(x)		(((x) >> 8) & 0xff)
+
+/* DWORD 11 */
+#define BFPT11_PAGE_SIZE_SHIFT(x)	(((x) >> 4) & 0xf)
+
+/* DWORD 15 */
+#define BFPT15_QER(x)			(((x) >> 20) & 0x7)
+
+#define CMD_READ_STATUS2		0x35
+#define CMD_READ_STATUS2_3F		0x3f
+
+/*
+ * A fast read is only used if the part wants the mode plus dummy clocks after the address
+ * that spi_flash_cmd_read() sends for it.
+ */
+static bool read_mode_usable(const uint32_t *bfpt, uint32_t bfpt1_bit, uint16_t desc,
+			     uint8_t opcode, uint8_t clocks)
+{
+	return (bfpt[0] & bfpt1_bit) && BFPT_READ_CMD(desc) == opcode &&
+		BFPT_READ_CLOCKS(desc) == clocks;
+}
+
+static int sfdp_read(const struct spi_slave *spi, uint32_t offset, void *buf, size_t len)
+{
+	/* Always a 3-byte address and 8 dummy clocks, also in 4-byte address mode. */
+	uint8_t cmd[5] = { CMD_READ_SFDP };
+	uint8_t *data = buf;
+	int ret;
+
+	while (len) {
+		const size_t xfer_len = spi_crop_chunk(spi, sizeof(cmd), len);
+		struct spi_op vectors[] = {
+			[0] = { .dout = cmd, .bytesout = sizeof(cmd) },
+			[1] = { .din = data, .bytesin = xfer_len },
+		};
+
+		cmd[1] = offset >> 16;
+		cmd[2] = offset >> 8;
+		cmd[3] = offset;
+
+		ret = spi_claim_bus(spi);
+		if (ret)
+			return ret;
+		ret = spi_xfer_vector(spi, vectors, ARRAY_SIZE(vectors));
+		spi_release_bus(spi);
+		if (ret)
+			return ret;
+
+		offset += xfer_len;
+		data += xfer_len;
+		len -= xfer_len;
+	}
+
+	return 0;
+}
+
+static int sfdp_read_bfpt(const struct spi_slave *spi, uint32_t *bfpt, size_t *dwords)
+{
+	struct sfdp_header hdr;
+	struct sfdp_param_header phdr;
+	uint32_t table = 0;
+	size_t i;
+
+	if (sfdp_read(spi, 0, &hdr, sizeof(hdr)) ||
+	    le32toh(hdr.signature) != SFDP_SIGNATURE || hdr.major != 1)
+		return -1;
+
+	/* Vendors may append newer revisions of the table, use the last one. */
+	*dwords = 0;
+	for (i = 0; i <= hdr.nph; i++) {
+		if (sfdp_read(spi, sizeof(hdr) + i * sizeof(phdr), &phdr, sizeof(phdr)))
+			return -1;
+		if (phdr.id_lsb != BFPT_ID_LSB || phdr.id_msb != BFPT_ID_MSB ||
+		    phdr.major != 1 || phdr.dwords < BFPT_DWORDS_MIN)
+			continue;
+		table = phdr.table_pointer[0] | phdr.table_pointer[1] << 8 |
+			phdr.table_pointer[2] << 16;
+		*dwords = MIN(phdr.dwords, BFPT_DWORDS_MAX);
+	}
+
+	if (!*dwords)
+		return -1;
+
+	memset(bfpt, 0, BFPT_DWORDS_MAX * sizeof(*bfpt));
+	if (sfdp_read(spi, table, bfpt, *dwords * sizeof(*bfpt)))
+		return -1;
+
+	for (i = 0; i < *dwords; i++)
+		bfpt[i] = le32toh(bfpt[i]);
+
+	return 0;
+}
+
+/* Returns 1 if quad reads can be used, following the Quad Enable Requirements. */
+static int sfdp_quad_enabled(const struct spi_slave *spi, const uint32_t *bfpt,
+			     size_t dwords)
+{
+	uint8_t reg;
+
+	if (dwords < 15)
+		return 0;
+
+	switch (BFPT15_QER(bfpt[14])) {
+	case 0: /* No QE bit, IO2/IO3 never act as /WP and /HOLD. */
+		return 1;
+	case 2:
+		if (spi_flash_cmd(spi, CMD_READ_STATUS, &reg, sizeof(reg)))
+			return 0;
+		return !!(reg & (1 << 6));
+	case 3:
+		if (spi_flash_cmd(spi, CMD_READ_STATUS2_3F, &reg, sizeof(reg)))
+			return 0;
+		return !!(reg & (1 << 7));
+	case 4:
+	case 5:
+	case 6:
+		if (spi_flash_cmd(spi, CMD_READ_STATUS2, &reg, sizeof(reg)))
+			return 0;
+		return !!(reg & (1 << 1));
+	default:
+		/* QER 1 has no command to read the QE bit back. */
+		return 0;
+	}
+}
+
+static void sfdp_read_modes(struct spi_flash *flash, const uint32_t *bfpt, size_t dwords)
+{
+	const bool quad = sfdp_quad_enabled(&flash->spi, bfpt, dwords) == 1;
+
+	flash->flags.quad_io = quad && read_mode_usable(bfpt, BFPT1_FAST_READ_1_4_4,
+				bfpt[2], CMD_READ_FAST_QUAD_IO, 6);
+	flash->flags.quad_output = quad && read_mode_usable(bfpt, BFPT1_FAST_READ_1_1_4,
+				bfpt[2] >> 16, CMD_READ_FAST_QUAD_OUTPUT, 8);
+	flash->flags.dual_output = read_mode_usable(bfpt, BFPT1_FAST_READ_1_1_2,
+				bfpt[3], CMD_READ_FAST_DUAL_OUTPUT, 8);
+	flash->flags.dual_io = read_mode_usable(bfpt, BFPT1_FAST_READ_1_2_2,
+				bfpt[3] >> 16, CMD_READ_FAST_DUAL_IO, 4);
+}
+
+/*
+ * The smallest erase type becomes the sector, the largest one up to 64 KiB is used
+ * for aligned parts of bigger erases.
+ */
+static int sfdp_erase_types(struct spi_flash *flash, const uint32_t *bfpt)
+{
+	size_t i;
+
+	flash->sector_size = 0;
+	flash->block_erase_size = 0;
+
+	for (i = 0; i < 4; i++) {
+		const uint16_t desc = bfpt[7 + i / 2] >> (16 * (i % 2));
+		const uint8_t shift = BFPT_ERASE_SIZE_SHIFT(desc);
+
+		if (shift < 12 || shift > 16)
+			continue;
+		if (!flash->sector_size || (1U << shift) < flash->sector_size) {
+			flash->sector_size = 1U << shift;
+			flash->erase_cmd = BFPT_ERASE_CMD(desc);
+		}
+		if ((1U << shift) > flash->block_erase_size) {
+			flash->block_erase_size = 1U << shift;
+			flash->block_erase_cmd = BFPT_ERASE_CMD(desc);
+		}
+	}
+
+	if (!flash->sector_size && (bfpt[0] & BFPT1_4K_ERASE_MASK) == BFPT1_4K_ERASE) {
+		flash->sector_size = 4 * KiB;
+		flash->erase_cmd = BFPT1_4K_ERASE_CMD(bfpt[0]);
+	}
+
+	if (!flash->sector_size)
+		return -1;
+
+	if (flash->block_erase_size <= flash->sector_size)
+		flash->block_erase_size = 0;
+
+	return 0;
+}
+
+int spi_flash_sfdp_probe(const struct spi_slave *spi, struct spi_flash *flash,
+			 uint8_t manuf_id, const uint16_t id[2])
+{
+	uint32_t bfpt[BFPT_DWORDS_MAX];
+	size_t dwords;
+	uint64_t size;
+	uint32_t n;
+
+	if (sfdp_read_bfpt(spi, bfpt, &dwords)) {
+		printk(BIOS_DEBUG, "SF: No SFDP\n");
+		return -1;
+	}
+
+	/* Density in bits */
+	n = bfpt[1] & ~BFPT2_DENSITY_POW2;
+	if (bfpt[1] & BFPT2_DENSITY_POW2)
+		size = n < 35 ? 1ULL << n >> 3 : 0;
+	else
+		size = ((uint64_t)n + 1) >> 3;
+	if (!size || size > 2ULL * GiB) {
+		printk(BIOS_WARNING, "SF: Bad SFDP density %#x\n", bfpt[1]);
+		return -1;
+	}
+
+	switch (BFPT1_ADDR_BYTES(bfpt[0])) {
+	case BFPT1_ADDR_3B:
+		if (CONFIG(SPI_FLASH_FORCE_4_BYTE_ADDR_MODE)) {
+			printk(BIOS_WARNING, "SF: SFDP part has no 4-byte addressing\n");
+			return -1;
+		}
+		break;
+	case BFPT1_ADDR_4B:
+		if (!CONFIG(SPI_FLASH_FORCE_4_BYTE_ADDR_MODE)) {
+			printk(BIOS_WARNING, "SF: SFDP part needs 4-byte addressing\n");
+			return -1;
+		}
+		break;
+	}
+
+	memset(flash, 0, sizeof(*flash));
+	memcpy(&flash->spi, spi, sizeof(*spi));
+	flash->vendor = manuf_id;
+	flash->model = id[0];
+	flash->size = size;
+
+	if (sfdp_erase_types(flash, bfpt))
+		return -1;
+
+	if (dwords >= 11)
+		flash->page_size = 1U << BFPT11_PAGE_SIZE_SHIFT(bfpt[10]);
+	else
+		flash->page_size = (bfpt[0] & BFPT1_WRITE_GRANULARITY_64) ? 64 : 1;
+
+	flash->status_cmd = spi_flash_pp_0x20_sector_desc.status_cmd;
+	flash->pp_cmd = spi_flash_pp_0x20_sector_desc.pp_cmd;
+	flash->wren_cmd = spi_flash_pp_0x20_sector_desc.wren_cmd;
+	flash->ops = &spi_flash_pp_0x20_sector_desc.ops;
+
+	sfdp_read_modes(flash, bfpt, dwords);
+
+	printk(BIOS_INFO, "SF: SFDP part %04x %04x, %u KiB, %u KiB sectors%s%s\n",
+	       id[0], id[1], flash->size / KiB, flash->sector_size / KiB,
+	       flash->flags.quad_io || flash->flags.quad_output ? ", quad reads" : "",
+	       flash->flags.dual_io || flash->flags.dual_output ? ", dual reads" : "");
+
+	return 0;
+}
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <spi-generic.h>
 #include <spi_flash.h>
+#include <thread.h>
 #include <timer.h>
 #include <types.h>
 
@@ -67,8 +68,12 @@ static int do_spi_flash_cmd(const struct spi_slave *spi, const u8 *dout,
 	return ret;
 }
 
-static int do_dual_output_cmd(const struct spi_slave *spi, const u8 *dout,
-			      size_t bytes_out, void *din, size_t bytes_in)
+typedef int (*spi_xfer_fn)(const struct spi_slave *slave, const void *dout,
+			   size_t bytesout, void *din, size_t bytesin);
+
+/* Opcode, address and dummy bytes in single mode, data in multi-bit mode. */
+static int do_multi_output_cmd(const struct spi_slave *spi, spi_xfer_fn xfer_multi,
+			       const u8 *dout, size_t bytes_out, void *din, size_t bytes_in)
 {
 	int ret;
 
@@ -89,14 +94,15 @@ static int do_dual_output_cmd(const struct spi_slave *spi, const u8 *dout,
 	ret = spi_xfer_vector(spi, &vector, 1);
 
 	if (!ret)
-		ret = spi->ctrlr->xfer_dual(spi, NULL, 0, din, bytes_in);
+		ret = xfer_multi(spi, NULL, 0, din, bytes_in);
 
 	spi_release_bus(spi);
 	return ret;
 }
 
-static int do_dual_io_cmd(const struct spi_slave *spi, const u8 *dout,
-			  size_t bytes_out, void *din, size_t bytes_in)
+/* Opcode in single mode, address, mode/dummy bytes and data in multi-bit mode. */
+static int do_multi_io_cmd(const struct spi_slave *spi, spi_xfer_fn xfer_multi,
+			   const u8 *dout, size_t bytes_out, void *din, size_t bytes_in)
 {
 	int ret;
 
@@ -111,15 +117,50 @@ static int do_dual_io_cmd(const struct spi_slave *spi, const u8 *dout,
 	ret = spi_xfer_vector(spi, &vector, 1);
 
 	if (!ret)
-		ret = spi->ctrlr->xfer_dual(spi, &dout[1], bytes_out - 1, NULL, 0);
+		ret = xfer_multi(spi, &dout[1], bytes_out - 1, NULL, 0);
 
 	if (!ret)
-		ret = spi->ctrlr->xfer_dual(spi, NULL, 0, din, bytes_in);
+		ret = xfer_multi(spi, NULL, 0, din, bytes_in);
 
 	spi_release_bus(spi);
 	return ret;
 }
 
+static int do_dual_output_cmd(const struct spi_slave *spi, const u8 *dout,
+			      size_t bytes_out, void *din, size_t bytes_in)
+{
+	return do_multi_output_cmd(spi, spi->ctrlr->xfer_dual, dout, bytes_out,
+				   din, bytes_in);
+}
+
+static int do_dual_io_cmd(const struct spi_slave *spi, const u8 *dout,
+			  size_t bytes_out, void *din, size_t bytes_in)
+{
+	return do_multi_io_cmd(spi, spi->ctrlr->xfer_dual, dout, bytes_out,
+			       din, bytes_in);
+}
+
+static int do_quad_output_cmd(const struct spi_slave *spi, const u8 *dout,
+			      size_t bytes_out, void *din, size_t bytes_in)
+{
+	return do_multi_output_cmd(spi, spi->ctrlr->xfer_quad, dout, bytes_out,
+				   din, bytes_in);
+}
+
+static int do_quad_io_cmd(const struct spi_slave *spi, const u8 *dout,
+			  size_t bytes_out, void *din, size_t bytes_in)
+{
+	return do_multi_io_cmd(spi, spi->ctrlr->xfer_quad, dout, bytes_out,
+			       din, bytes_in);
+}
+
+static int do_quad_io_dtr_cmd(const struct spi_slave *spi, const u8 *dout,
+			      size_t bytes_out, void *din, size_t bytes_in)
+{
+	return do_multi_io_cmd(spi, spi->ctrlr->xfer_quad_dtr, dout, bytes_out,
+			       din, bytes_in);
+}
+
 int spi_flash_cmd(const struct spi_slave *spi, u8 cmd, void *response, size_t len)
 {
 	int ret = do_spi_flash_cmd(spi, &cmd, sizeof(cmd), response, len);
@@ -153,36 +194,79 @@ int spi_flash_cmd_write(const struct spi_slave *spi, const u8 *cmd,
 }
 #pragma GCC diagnostic pop
 
+enum spi_flash_read_mode {
+	SF_READ_SLOW,
+	SF_READ_FAST,
+	SF_READ_DUAL_OUTPUT,
+	SF_READ_DUAL_IO,
+	SF_READ_QUAD_OUTPUT,
+	SF_READ_QUAD_IO,
+	SF_READ_QUAD_IO_DTR,
+};
+
+/*
+ * Number of bytes sent after the address. For the I/O modes these go out in
+ * the multi-bit mode as well, so the first one is the mode byte (M7-0, must
+ * not be 0xAx to stay out of continuous read mode) and the rest are dummy
+ * clocks: 1-2-2 has 4 mode clocks and no dummies, 1-4-4 has 2 mode and 4
+ * dummy clocks, and the DTR variant has 1 mode and 7 dummy clocks, all of
+ * which are the power-on defaults of the Winbond and Macronix parts.
+ */
+#define SF_READ_MAX_DUMMY_BYTES	8
+
+static const struct {
+	u8 opcode;
+	u8 dummy_bytes;
+	int (*do_cmd)(const struct spi_slave *spi, const u8 *dout,
+		      size_t bytes_out, void *din, size_t bytes_in);
+	const char *name;
+} read_modes[] = {
+	[SF_READ_SLOW] = { CMD_READ_ARRAY_SLOW, 0, do_spi_flash_cmd, "" },
+	[SF_READ_FAST] = { CMD_READ_ARRAY_FAST, 1, do_spi_flash_cmd, "" },
+	[SF_READ_DUAL_OUTPUT] = { CMD_READ_FAST_DUAL_OUTPUT, 1, do_dual_output_cmd,
+				  " (Dual Output mode)" },
+	[SF_READ_DUAL_IO] = { CMD_READ_FAST_DUAL_IO, 1, do_dual_io_cmd, " (Dual I/O mode)" },
+	[SF_READ_QUAD_OUTPUT] = { CMD_READ_FAST_QUAD_OUTPUT, 1, do_quad_output_cmd,
+				  " (Quad Output mode)" },
+	[SF_READ_QUAD_IO] = { CMD_READ_FAST_QUAD_IO, 3, do_quad_io_cmd, " (Quad I/O mode)" },
+	[SF_READ_QUAD_IO_DTR] = { CMD_READ_FAST_QUAD_IO_DTR, 8, do_quad_io_dtr_cmd,
+				  " (Quad I/O DTR mode)" },
+};
+
+/* Pick the fastest read both the flash part and the controller support. */
+static enum spi_flash_read_mode spi_flash_read_mode(const struct spi_flash *flash,
+						    const struct spi_ctrlr *ctrlr)
+{
+	if (CONFIG(SPI_FLASH_NO_FAST_READ))
+		return SF_READ_SLOW;
+	if (flash->flags.quad_io_dtr && ctrlr->xfer_quad_dtr)
+		return SF_READ_QUAD_IO_DTR;
+	if (flash->flags.quad_io && ctrlr->xfer_quad)
+		return SF_READ_QUAD_IO;
+	if (flash->flags.quad_output && ctrlr->xfer_quad)
+		return SF_READ_QUAD_OUTPUT;
+	if (flash->flags.dual_io && ctrlr->xfer_dual)
+		return SF_READ_DUAL_IO;
+	if (flash->flags.dual_output && ctrlr->xfer_dual)
+		return SF_READ_DUAL_OUTPUT;
+	return SF_READ_FAST;
+}
+
 /* Perform the read operation honoring spi controller fifo size, reissuing
  * the read command until the full request completed. */
 int spi_flash_cmd_read(const struct spi_flash *flash, u32 offset,
 				  size_t len, void *buf)
 {
-	u8 cmd[5 + ADDR_MOD];
+	u8 cmd[4 + ADDR_MOD + SF_READ_MAX_DUMMY_BYTES];
 	int ret, cmd_len;
 	int (*do_cmd)(const struct spi_slave *spi, const u8 *din,
 		      size_t in_bytes, void *out, size_t out_bytes);
+	const enum spi_flash_read_mode mode = spi_flash_read_mode(flash, flash->spi.ctrlr);
 
-	if (CONFIG(SPI_FLASH_NO_FAST_READ)) {
-		cmd_len = 4 + ADDR_MOD;
-		cmd[0] = CMD_READ_ARRAY_SLOW;
-		do_cmd = do_spi_flash_cmd;
-	} else if (flash->flags.dual_io && flash->spi.ctrlr->xfer_dual) {
-		cmd_len = 5 + ADDR_MOD;
-		cmd[0] = CMD_READ_FAST_DUAL_IO;
-		cmd[4 + ADDR_MOD] = 0;
-		do_cmd = do_dual_io_cmd;
-	} else if (flash->flags.dual_output && flash->spi.ctrlr->xfer_dual) {
-		cmd_len = 5 + ADDR_MOD;
-		cmd[0] = CMD_READ_FAST_DUAL_OUTPUT;
-		cmd[4 + ADDR_MOD] = 0;
-		do_cmd = do_dual_output_cmd;
-	} else {
-		cmd_len = 5 + ADDR_MOD;
-		cmd[0] = CMD_READ_ARRAY_FAST;
-		cmd[4 + ADDR_MOD] = 0;
-		do_cmd = do_spi_flash_cmd;
-	}
+	cmd_len = 4 + ADDR_MOD + read_modes[mode].dummy_bytes;
+	cmd[0] = read_modes[mode].opcode;
+	memset(&cmd[4 + ADDR_MOD], 0, read_modes[mode].dummy_bytes);
+	do_cmd = read_modes[mode].do_cmd;
 
 	uint8_t *data = buf;
 	while (len) {
@@ -203,6 +287,16 @@ int spi_flash_cmd_read(const struct spi_flash *flash, u32 offset,
 	return 0;
 }
 
+/*
+ * The part whose erase or program the current thread waits for with
+ * spi_flash_cmd_wait_busy(), if the wait lets other threads run.
+ */
+static const struct spi_flash *busy_flash;
+static bool busy_erase;
+/* Time the erase gets to make progress after a resume before it may be suspended again. */
+#define SPI_FLASH_ERASE_RESUME_US	1000
+static struct stopwatch erase_resumed;
+
 int spi_flash_cmd_poll_bit(const struct spi_flash *flash, unsigned long timeout,
 			   u8 cmd, u8 poll_bit)
 {
@@ -214,7 +308,9 @@ int spi_flash_cmd_poll_bit(const struct spi_flash *flash, unsigned long timeout,
 
 	stopwatch_init_msecs_expire(&sw, timeout);
 	do {
-		attempt++;
+		/* The status is read once more after a yield before the timeout counts. */
+		if (attempt++ && busy_flash == flash)
+			thread_yield();
 
 		ret = do_spi_flash_cmd(spi, &cmd, 1, &status, 1);
 		if (ret) {
@@ -241,6 +337,69 @@ int spi_flash_cmd_wait_ready(const struct spi_flash *flash,
 		CMD_READ_STATUS, STATUS_WIP);
 }
 
+static int spi_flash_cmd_wait_busy(const struct spi_flash *flash, unsigned long timeout,
+				   bool erase)
+{
+	int ret;
+
+	if (!CONFIG(SPI_FLASH_YIELD_WHILE_BUSY) || !ENV_SUPPORTS_COOP)
+		return spi_flash_cmd_wait_ready(flash, timeout);
+
+	busy_flash = flash;
+	busy_erase = erase;
+	stopwatch_init(&erase_resumed);
+	ret = spi_flash_cmd_wait_ready(flash, timeout);
+	busy_flash = NULL;
+
+	return ret;
+}
+
+static bool same_part(const struct spi_flash *a, const struct spi_flash *b)
+{
+	return a->spi.bus == b->spi.bus && a->spi.cs == b->spi.cs;
+}
+
+/*
+ * Wait until another thread's erase or program of the part is done. Reads may instead
+ * suspend a sector erase, in that case this returns true with cooperative multitasking
+ * disabled, so the erasing thread can't see the suspended part as ready, and
+ * spi_flash_access_end() resumes the erase.
+ */
+static bool spi_flash_access_begin(const struct spi_flash *flash, bool read)
+{
+	if (!CONFIG(SPI_FLASH_YIELD_WHILE_BUSY))
+		return false;
+
+	while (busy_flash && same_part(busy_flash, flash)) {
+		if (read && busy_erase && busy_flash->flags.erase_suspend &&
+		    stopwatch_expired(&erase_resumed)) {
+			thread_coop_disable();
+			/* WIP clears once the part is suspended, within tens of us. */
+			if (!spi_flash_cmd(&flash->spi, CMD_ERASE_SUSPEND, NULL, 0) &&
+			    !spi_flash_cmd_wait_ready(flash, 1))
+				return true;
+			printk(BIOS_WARNING, "SF: Erase suspend failed\n");
+			spi_flash_cmd(&flash->spi, CMD_ERASE_RESUME, NULL, 0);
+			thread_coop_enable();
+		}
+		if (thread_yield() < 0)
+			break;
+	}
+
+	return false;
+}
+
+static void spi_flash_access_end(const struct spi_flash *flash, bool suspended)
+{
+	if (!suspended)
+		return;
+
+	if (spi_flash_cmd(&flash->spi, CMD_ERASE_RESUME, NULL, 0))
+		printk(BIOS_ERR, "SF: Erase resume failed\n");
+	stopwatch_init_usecs_expire(&erase_resumed, SPI_FLASH_ERASE_RESUME_US);
+	thread_coop_enable();
+}
+
 int spi_flash_cmd_erase(const struct spi_flash *flash, u32 offset, size_t len)
 {
 	u32 start, end, erase_size;
@@ -257,11 +416,21 @@ int spi_flash_cmd_erase(const struct spi_flash *flash, u32 offset, size_t len)
 		return -1;
 	}
 
-	cmd[0] = flash->erase_cmd;
 	start = offset;
 	end = start + len;
 
 	while (offset < end) {
+		unsigned long timeout = SPI_FLASH_PAGE_ERASE_TIMEOUT_MS;
+
+		cmd[0] = flash->erase_cmd;
+		erase_size = flash->sector_size;
+		if (flash->block_erase_size && IS_ALIGNED(offset, flash->block_erase_size) &&
+		    end - offset >= flash->block_erase_size) {
+			cmd[0] = flash->block_erase_cmd;
+			erase_size = flash->block_erase_size;
+			timeout = SPI_FLASH_BLOCK_ERASE_TIMEOUT_MS;
+		}
+
 		spi_flash_addr(offset, cmd);
 		offset += erase_size;
 
@@ -282,8 +451,7 @@ int spi_flash_cmd_erase(const struct spi_flash *flash, u32 offset, size_t len)
 		if (ret)
 			goto out;
 
-		ret = spi_flash_cmd_wait_ready(flash,
-				SPI_FLASH_PAGE_ERASE_TIMEOUT_MS);
+		ret = spi_flash_cmd_wait_busy(flash, timeout, true);
 		if (ret)
 			goto out;
 	}
@@ -344,7 +512,7 @@ int spi_flash_cmd_write_page_program(const struct spi_flash *flash, u32 offset,
 			goto out;
 		}
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT_MS);
+		ret = spi_flash_cmd_wait_busy(flash, SPI_FLASH_PROG_TIMEOUT_MS, false);
 		if (ret)
 			goto out;
 
@@ -421,11 +589,22 @@ static int fill_spi_flash(const struct spi_slave *spi, struct spi_flash *flash,
 
 	flash->flags.dual_output = part->fast_read_dual_output_support;
 	flash->flags.dual_io = part->fast_read_dual_io_support;
+	flash->flags.quad_output = part->fast_read_quad_output_support;
+	flash->flags.quad_io = part->fast_read_quad_io_support;
+	flash->flags.erase_suspend = vi->can_suspend_erase && vi->can_suspend_erase(flash);
 
 	flash->ops = &vi->desc->ops;
 	flash->prot_ops = vi->prot_ops;
 	flash->part = part;
 
+	/* Without QE set IO2/IO3 are /WP and /HOLD, so quad reads can't be used. */
+	if ((flash->flags.quad_output || flash->flags.quad_io) &&
+	    (!vi->quad_enabled || vi->quad_enabled(flash) != 1)) {
+		flash->flags.quad_output = 0;
+		flash->flags.quad_io = 0;
+		flash->flags.quad_io_dtr = 0;
+	}
+
 	if (vi->after_probe)
 		return vi->after_probe(flash);
 
@@ -474,6 +653,10 @@ static int find_match(const struct spi_slave *spi, struct spi_flash *flash,
 	}
 
 	printk(BIOS_WARNING, "SF: no match for ID %04x %04x\n", id[0], id[1]);
+
+	if (CONFIG(SPI_FLASH_SFDP))
+		return spi_flash_sfdp_probe(spi, flash, manuf_id, id);
+
 	return -1;
 }
 
@@ -539,11 +722,7 @@ int spi_flash_probe(unsigned int bus, unsigned int cs, struct spi_flash *flash)
 		return -1;
 	}
 
-	const char *mode_string = "";
-	if (flash->flags.dual_io && spi.ctrlr->xfer_dual)
-		mode_string = " (Dual I/O mode)";
-	else if (flash->flags.dual_output && spi.ctrlr->xfer_dual)
-		mode_string = " (Dual Output mode)";
+	const char *mode_string = read_modes[spi_flash_read_mode(flash, spi.ctrlr)].name;
 	printk(BIOS_INFO,
 	       "SF: Detected %02x %04x with sector size 0x%x, total 0x%x%s\n",
 		flash->vendor, flash->model, flash->sector_size, flash->size, mode_string);
@@ -565,7 +744,14 @@ int spi_flash_probe(unsigned int bus, unsigned int cs, struct spi_flash *flash)
 int spi_flash_read(const struct spi_flash *flash, u32 offset, size_t len,
 		void *buf)
 {
-	return flash->ops->read(flash, offset, len, buf);
+	const bool suspended = spi_flash_access_begin(flash, true);
+	int ret;
+
+	ret = flash->ops->read(flash, offset, len, buf);
+
+	spi_flash_access_end(flash, suspended);
+
+	return ret;
 }
 
 int spi_flash_write(const struct spi_flash *flash, u32 offset, size_t len,
@@ -573,6 +759,8 @@ int spi_flash_write(const struct spi_flash *flash, u32 offset, size_t len,
 {
 	int ret;
 
+	spi_flash_access_begin(flash, false);
+
 	if (spi_flash_volatile_group_begin(flash))
 		return -1;
 
@@ -588,6 +776,8 @@ int spi_flash_erase(const struct spi_flash *flash, u32 offset, size_t len)
 {
 	int ret;
 
+	spi_flash_access_begin(flash, false);
+
 	if (spi_flash_volatile_group_begin(flash))
 		return -1;
 
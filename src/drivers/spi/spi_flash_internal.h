@@ -16,6 +16,9 @@
 
 #define CMD_READ_FAST_DUAL_OUTPUT	0x3b
 #define CMD_READ_FAST_DUAL_IO		0xbb
+#define CMD_READ_FAST_QUAD_OUTPUT	0x6b
+#define CMD_READ_FAST_QUAD_IO		0xeb
+#define CMD_READ_FAST_QUAD_IO_DTR	0xed
 
 #define CMD_READ_STATUS			0x05
 #define CMD_WRITE_ENABLE		0x06
@@ -24,6 +27,10 @@
 
 #define CMD_EXIT_4BYTE_ADDR_MODE	0xe9
 
+/* Only sent to parts with flags.erase_suspend set. */
+#define CMD_ERASE_SUSPEND		0x75
+#define CMD_ERASE_RESUME		0x7a
+
 /* Common status */
 #define STATUS_WIP			0x01
 
@@ -60,6 +67,13 @@ int spi_flash_cmd_write_page_program(const struct spi_flash *flash, u32 offset,
 /* Read len bytes into buf at offset. */
 int spi_flash_cmd_read(const struct spi_flash *flash, u32 offset, size_t len, void *buf);
 
+/*
+ * Fill flash from the part's SFDP Basic Flash Parameter Table. Returns 0 on success,
+ * -1 if the part has no usable table.
+ */
+int spi_flash_sfdp_probe(const struct spi_slave *spi, struct spi_flash *flash,
+			 uint8_t manuf_id, const uint16_t id[2]);
+
 /* Release from deep sleep an provide alternative rdid information. */
 int stmicro_release_deep_sleep_identify(const struct spi_slave *spi, u8 *idcode);
 
@@ -74,7 +88,8 @@ struct spi_flash_part_id {
 	uint16_t nr_sectors_shift : 4;
 	uint16_t fast_read_dual_output_support : 1;	/*  1-1-2 read */
 	uint16_t fast_read_dual_io_support : 1;		/*  1-2-2 read */
-	uint16_t _reserved_for_flags : 2;
+	uint16_t fast_read_quad_output_support : 1;	/*  1-1-4 read */
+	uint16_t fast_read_quad_io_support : 1;		/*  1-4-4 read */
 	/* Block protection. Currently used by Winbond. */
 	uint16_t protection_granularity_shift : 5;
 	uint16_t bp_bits : 3;
@@ -103,6 +118,17 @@ struct spi_flash_vendor_info {
 	const struct spi_flash_protection_ops *prot_ops;
 	/* Returns 0 on success. !0 otherwise. */
 	int (*after_probe)(const struct spi_flash *flash);
+	/*
+	 * Returns 1 if the part's Quad Enable bit is set, 0 if it is not and
+	 * <0 on error. Quad reads are only used if this returns 1, since with
+	 * QE cleared IO2/IO3 still act as /WP and /HOLD.
+	 */
+	int (*quad_enabled)(const struct spi_flash *flash);
+	/*
+	 * Returns true if the part can suspend a sector erase with
+	 * CMD_ERASE_SUSPEND, be read and resume it with CMD_ERASE_RESUME.
+	 */
+	bool (*can_suspend_erase)(const struct spi_flash *flash);
 };
 
 /* Manufacturer-specific probe information */
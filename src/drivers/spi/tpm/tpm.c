@@ -501,23 +501,31 @@ tpm_result_t tpm2_init(struct spi_slave *spi_if)
  * long time to complete.
  */
 #define MAX_STATUS_TIMEOUT 120
+/*
+ * Most commands complete in well under a millisecond, so poll right away and back off
+ * to the old 1ms interval only for the slow ones.
+ */
+#define STATUS_POLL_MIN_US 20
+#define STATUS_POLL_MAX_US 1000
 static enum cb_err wait_for_status(uint32_t status_mask, uint32_t status_expected)
 {
 	uint32_t status;
 	struct stopwatch sw;
+	unsigned int delay_us = STATUS_POLL_MIN_US;
 
 	stopwatch_init_usecs_expire(&sw, MAX_STATUS_TIMEOUT * 1000 * 1000);
-	do {
-		udelay(1000);
+	while (1) {
+		read_tpm_sts(&status);
+		if ((status & status_mask) == status_expected)
+			return CB_SUCCESS;
 		if (stopwatch_expired(&sw)) {
 			printk(BIOS_ERR, "failed to get expected status %#x\n",
 			       status_expected);
 			return CB_ERR;
 		}
-		read_tpm_sts(&status);
-	} while ((status & status_mask) != status_expected);
-
-	return CB_SUCCESS;
+		udelay(delay_us);
+		delay_us = MIN(delay_us * 2, STATUS_POLL_MAX_US);
+	}
 }
 
 enum fifo_transfer_direction {
@@ -533,21 +541,23 @@ union fifo_transfer_buffer {
 
 /*
  * Transfer requested number of bytes to or from TPM FIFO, accounting for the
- * current burst count value.
+ * current burst count value. The burst count is the number of bytes the TPM
+ * can take or provide without further flow control, so it is only read again
+ * once that many bytes have been transferred.
  */
 static enum cb_err __must_check fifo_transfer(size_t transfer_size,
 					   union fifo_transfer_buffer buffer,
 					   enum fifo_transfer_direction direction)
 {
 	size_t transaction_size;
-	size_t burst_count;
+	size_t burst_count = 0;
 	size_t handled_so_far = 0;
 
 	do {
-		do {
+		while (!burst_count) {
 			/* Could be zero when TPM is busy. */
 			burst_count = get_burst_count();
-		} while (!burst_count);
+		}
 
 		transaction_size = transfer_size - handled_so_far;
 		transaction_size = MIN(transaction_size, burst_count);
@@ -571,6 +581,7 @@ static enum cb_err __must_check fifo_transfer(size_t transfer_size,
 		}
 
 		handled_so_far += transaction_size;
+		burst_count -= transaction_size;
 
 	} while (handled_so_far != transfer_size);
 
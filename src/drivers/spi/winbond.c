@@ -102,6 +102,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 8,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 	},
 	{
 		/* W25Q16_V */
@@ -109,6 +111,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 9,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 3,
 	},
@@ -118,6 +122,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 9,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 3,
 	},
@@ -127,6 +133,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 10,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 3,
 	},
@@ -136,6 +144,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 10,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 3,
 	},
@@ -145,6 +155,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 11,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 17,
 		.bp_bits			= 3,
 	},
@@ -154,6 +166,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 11,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 17,
 		.bp_bits			= 3,
 	},
@@ -163,6 +177,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 11,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 17,
 		.bp_bits			= 3,
 	},
@@ -172,6 +188,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 12,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 18,
 		.bp_bits			= 3,
 	},
@@ -181,6 +199,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 12,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 18,
 		.bp_bits			= 3,
 	},
@@ -190,6 +210,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 12,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 18,
 		.bp_bits			= 3,
 	},
@@ -199,6 +221,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 12,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 18,
 		.bp_bits			= 3,
 	},
@@ -208,6 +232,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 14,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 4,
 	},
@@ -217,6 +243,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 13,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 4,
 	},
@@ -226,6 +254,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 13,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 4,
 	},
@@ -235,6 +265,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 13,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 4,
 	},
@@ -244,6 +276,8 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 13,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.fast_read_quad_output_support	= 1,
+		.fast_read_quad_io_support	= 1,
 		.protection_granularity_shift	= 16,
 		.bp_bits			= 4,
 	},
@@ -606,6 +640,24 @@ winbond_set_write_protection(const struct spi_flash *flash,
 	return ret;
 }
 
+static int winbond_quad_enabled(const struct spi_flash *flash)
+{
+	union status_reg2 reg2 = { .u = 0 };
+	int ret;
+
+	ret = spi_flash_cmd(&flash->spi, CMD_W25_RDSR2, &reg2.u, sizeof(reg2.u));
+	if (ret)
+		return ret;
+
+	return reg2.qe;
+}
+
+/* The W25X parts (0x20xx and 0x30xx) have no erase suspend. */
+static bool winbond_can_suspend_erase(const struct spi_flash *flash)
+{
+	return flash->model >= 0x4000;
+}
+
 static const struct spi_flash_protection_ops spi_flash_protection_ops = {
 	.get_write = winbond_get_write_protection,
 	.set_write = winbond_set_write_protection,
@@ -620,4 +672,6 @@ const struct spi_flash_vendor_info spi_flash_winbond_vi = {
 	.nr_part_ids = ARRAY_SIZE(flash_table),
 	.desc = &spi_flash_pp_0x20_sector_desc,
 	.prot_ops = &spi_flash_protection_ops,
+	.quad_enabled = winbond_quad_enabled,
+	.can_suspend_erase = winbond_can_suspend_erase,
 };
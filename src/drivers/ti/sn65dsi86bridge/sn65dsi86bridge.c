@@ -234,7 +234,9 @@ enum cb_err sn65dsi86_bridge_read_edid(uint8_t bus, uint8_t chip, struct edid *o
 		return err;
 	}
 
-	if (edid[EDID_EXTENSION_FLAG]) {
+	/* An unchanged panel is decoded from the cache, its extensions aren't needed. */
+	if (edid[EDID_EXTENSION_FLAG] &&
+	    !(CONFIG(EDID_CACHE) && edid_cache_matches(edid))) {
 		edid_size += EDID_LENGTH;
 		reg_addr = EDID_LENGTH;
 		err = sn65dsi86_bridge_aux_request(bus, chip, EDID_I2C_ADDR, 1,
@@ -19,16 +19,52 @@
 #define SINGLE_CHAR_TIMEOUT	(50 * 1000)
 #define FIFO_TIMEOUT		(16 * SINGLE_CHAR_TIMEOUT)
 
+/* Bytes that still fit into the TX FIFO of tx_port before THRE has to be polled again */
+static unsigned int tx_port;
+static unsigned int tx_fifo_room;
+
 static int uart8250_can_tx_byte(unsigned int base_port)
 {
 	return inb(base_port + UART8250_LSR) & UART8250_LSR_THRE;
 }
 
+static unsigned int uart8250_tx_fifo_size(unsigned int base_port)
+{
+	/* The IIR reports whether FCR_FIFO_EN took, i.e. whether there is a FIFO. */
+	if ((inb(base_port + UART8250_IIR) & UART8250_IIR_FIFO_EN) == UART8250_IIR_FIFO_EN)
+		return CONFIG_DRIVERS_UART_8250_FIFO_SIZE;
+	return 1;
+}
+
+static int uart8250_try_tx_byte(unsigned int base_port, unsigned char data)
+{
+	if (base_port != tx_port) {
+		tx_port = base_port;
+		tx_fifo_room = 0;
+	}
+
+	/* With FIFOs enabled, THRE means that the whole FIFO is empty. */
+	if (!tx_fifo_room) {
+		if (!uart8250_can_tx_byte(base_port))
+			return 0;
+		tx_fifo_room = uart8250_tx_fifo_size(base_port);
+	}
+
+	tx_fifo_room--;
+	outb(data, base_port + UART8250_TBR);
+	return 1;
+}
+
 static void uart8250_tx_byte(unsigned int base_port, unsigned char data)
 {
 	unsigned long int i = SINGLE_CHAR_TIMEOUT;
-	while (i-- && !uart8250_can_tx_byte(base_port));
-	outb(data, base_port + UART8250_TBR);
+	while (!uart8250_try_tx_byte(base_port, data)) {
+		if (!i--) {
+			/* Assume the UART is stuck and write anyway. */
+			outb(data, base_port + UART8250_TBR);
+			return;
+		}
+	}
 }
 
 static void uart8250_tx_flush(unsigned int base_port)
@@ -99,6 +135,11 @@ void uart_tx_byte(unsigned int idx, unsigned char data)
 	uart8250_tx_byte(uart_platform_base(idx), data);
 }
 
+int uart_try_tx_byte(unsigned int idx, unsigned char data)
+{
+	return uart8250_try_tx_byte(uart_platform_base(idx), data);
+}
+
 unsigned char uart_rx_byte(unsigned int idx)
 {
 	return uart8250_rx_byte(uart_platform_base(idx));
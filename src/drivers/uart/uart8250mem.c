@@ -39,17 +39,53 @@ static void uart8250_write(void *base, uint8_t reg, uint8_t data)
 }
 #endif
 
+/* Bytes that still fit into the TX FIFO of tx_base before THRE has to be polled again */
+static void *tx_base;
+static unsigned int tx_fifo_room;
+
 static int uart8250_mem_can_tx_byte(void *base)
 {
 	return uart8250_read(base, UART8250_LSR) & UART8250_LSR_THRE;
 }
 
+static unsigned int uart8250_mem_tx_fifo_size(void *base)
+{
+	/* The IIR reports whether FCR_FIFO_EN took, i.e. whether there is a FIFO. */
+	if ((uart8250_read(base, UART8250_IIR) & UART8250_IIR_FIFO_EN) == UART8250_IIR_FIFO_EN)
+		return CONFIG_DRIVERS_UART_8250_FIFO_SIZE;
+	return 1;
+}
+
+static int uart8250_mem_try_tx_byte(void *base, unsigned char data)
+{
+	if (base != tx_base) {
+		tx_base = base;
+		tx_fifo_room = 0;
+	}
+
+	/* With FIFOs enabled, THRE means that the whole FIFO is empty. */
+	if (!tx_fifo_room) {
+		if (!uart8250_mem_can_tx_byte(base))
+			return 0;
+		tx_fifo_room = uart8250_mem_tx_fifo_size(base);
+	}
+
+	tx_fifo_room--;
+	uart8250_write(base, UART8250_TBR, data);
+	return 1;
+}
+
 static void uart8250_mem_tx_byte(void *base, unsigned char data)
 {
 	unsigned long int i = SINGLE_CHAR_TIMEOUT;
-	while (i-- && !uart8250_mem_can_tx_byte(base))
+	while (!uart8250_mem_try_tx_byte(base, data)) {
+		if (!i--) {
+			/* Assume the UART is stuck and write anyway. */
+			uart8250_write(base, UART8250_TBR, data);
+			return;
+		}
 		udelay(1);
-	uart8250_write(base, UART8250_TBR, data);
+	}
 }
 
 static void uart8250_mem_tx_flush(void *base)
@@ -117,6 +153,14 @@ void uart_tx_byte(unsigned int idx, unsigned char data)
 	uart8250_mem_tx_byte(base, data);
 }
 
+int uart_try_tx_byte(unsigned int idx, unsigned char data)
+{
+	void *base = uart_platform_baseptr(idx);
+	if (!base)
+		return 1;
+	return uart8250_mem_try_tx_byte(base, data);
+}
+
 unsigned char uart_rx_byte(unsigned int idx)
 {
 	void *base = uart_platform_baseptr(idx);
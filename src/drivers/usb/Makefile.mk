@@ -6,3 +6,5 @@ romstage-$(CONFIG_USBDEBUG) += ehci_debug.c pci_ehci.c console.c gadget.c
 postcar-$(CONFIG_USBDEBUG) += ehci_debug.c console.c
 
 ramstage-$(CONFIG_USBDEBUG) += ehci_debug.c pci_ehci.c console.c gadget.c
+
+ramstage-$(CONFIG_USBDEBUG_XHCI_DBC) += xhci_dbc.c
@@ -0,0 +1,518 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <commonlib/bsd/helpers.h>
+#include <console/xhci_dbc.h>
+#include <device/mmio.h>
+#include <device/pci_def.h>
+#include <device/pci_ops.h>
+#include <device/xhci.h>
+#include <string.h>
+#include <timer.h>
+#include <types.h>
+
+/*
+ * Console on the Debug Capability (DbC) of an xHCI controller. With DbC enabled, a
+ * USB 3 port of the controller shows up as a device with one bulk endpoint pair on
+ * the host on the other end of an A-to-A debug cable. Linux drives it with the
+ * usb_debug serial driver (/dev/ttyUSBx).
+ *
+ * Output is collected in a few page sized buffers, each of which goes out in a single
+ * bulk IN transfer. Up to DBC_TX_BUFS transfers are in flight while the next buffer is
+ * filled, so a flush after every line doesn't wait for the host. All DMA structures
+ * are in ramstage's .bss, which is why this is a ramstage only console.
+ */
+
+#define PCI_XHCI_CLASSCODE	0x0c0330
+
+/* DbC registers, relative to the extended capability */
+#define DBC_DCID		0x00
+#define DBC_DCDB		0x04
+#define  DBC_DCDB_TARGET_IN	(1 << 8)
+#define DBC_DCERSTSZ		0x08
+#define DBC_DCERSTBA		0x10
+#define DBC_DCERDP		0x18
+#define DBC_DCCTRL		0x20
+#define  DBC_DCCTRL_DCR		(1 << 0)
+#define  DBC_DCCTRL_LSE		(1 << 1)
+#define  DBC_DCCTRL_HIT		(1 << 3)
+#define  DBC_DCCTRL_DRC		(1 << 4)
+#define  DBC_DCCTRL_MAX_BURST(x) (((x) >> 16) & 0xff)
+#define  DBC_DCCTRL_DCE		(1 << 31)
+#define DBC_DCPORTSC		0x28
+#define  DBC_DCPORTSC_CCS	(1 << 0)
+#define  DBC_DCPORTSC_CHANGE	(0xf << 21 | 1 << 17)
+#define DBC_DCCP		0x30
+#define DBC_DCDDI1		0x38
+#define DBC_DCDDI2		0x3c
+
+/* Same IDs as the early DbC console of Linux, which the usb_debug driver binds to. */
+#define DBC_VENDOR_ID		0x1d6b
+#define DBC_PRODUCT_ID		0x0011
+#define DBC_DEVICE_REV		0x0010
+#define DBC_PROTOCOL		0
+
+#define TRB_CYCLE		(1 << 0)
+#define TRB_TC			(1 << 1)
+#define TRB_IOC			(1 << 5)
+#define TRB_TYPE(x)		((x) << 10)
+#define TRB_GET_TYPE(x)		(((x) >> 10) & 0x3f)
+#define  TRB_NORMAL		1
+#define  TRB_LINK		6
+#define  TRB_TRANSFER_EVENT	32
+#define  TRB_PORT_STATUS_EVENT	34
+
+#define EP_TYPE_BULK_OUT	2
+#define EP_TYPE_BULK_IN		6
+#define EP_MAX_PACKET		1024
+
+#define DBC_RING_TRBS		16
+#define DBC_EVENT_TRBS		16
+#define DBC_TX_BUFS		4
+#define DBC_TX_BUF_SIZE		(4 * KiB)
+#define DBC_STRING_SIZE		64
+
+#define DBC_ENABLE_TIMEOUT_MS	10
+/* Without a cable the port never connects, don't hold up the boot for long. */
+#define DBC_CONNECT_TIMEOUT_MS	200
+#define DBC_CONFIGURE_TIMEOUT_MS 2000
+/* How long to wait for a free buffer before assuming nobody reads on the host. */
+#define DBC_TX_TIMEOUT_MS	100
+
+struct dbc_trb {
+	uint32_t field[4];
+};
+
+struct dbc_erst_entry {
+	uint64_t seg_addr;
+	uint32_t seg_size;
+	uint32_t reserved;
+};
+
+struct dbc_info_ctx {
+	uint64_t string0;
+	uint64_t manufacturer;
+	uint64_t product;
+	uint64_t serial;
+	uint32_t length;
+	uint32_t reserved[7];
+};
+
+struct dbc_ep_ctx {
+	uint32_t ep_info1;
+	uint32_t ep_info2;
+	uint64_t deq;
+	uint32_t tx_info;
+	uint32_t reserved[11];
+};
+
+struct dbc_ctx {
+	struct dbc_info_ctx info;
+	struct dbc_ep_ctx out;
+	struct dbc_ep_ctx in;
+};
+
+/* Everything the controller reads or writes. The page alignment keeps each buffer
+   within a 64KiB boundary as TRBs require. */
+static struct {
+	uint8_t tx_buf[DBC_TX_BUFS][DBC_TX_BUF_SIZE];
+	struct dbc_trb event_ring[DBC_EVENT_TRBS];
+	struct dbc_trb out_ring[DBC_RING_TRBS];
+	struct dbc_trb in_ring[DBC_RING_TRBS];
+	struct dbc_ctx ctx __aligned(64);
+	struct dbc_erst_entry erst __aligned(64);
+	uint8_t strings[4][DBC_STRING_SIZE] __aligned(16);
+} dbc_dma __aligned(4 * KiB);
+
+static struct {
+	pci_devfn_t dev;
+	/* Offset of the DbC capability in the controller's MMIO space */
+	unsigned int cap;
+	/* DbC registers, 0 if DbC isn't usable right now */
+	uintptr_t regs;
+	bool configured;
+	/* Set when a transfer timed out, until the host takes data again */
+	bool stalled;
+
+	unsigned int evt_idx;
+	uint32_t evt_cycle;
+	unsigned int in_idx;
+	uint32_t in_cycle;
+
+	/* Buffer that is being filled, the ones before it are in flight */
+	unsigned int head;
+	unsigned int pending;
+	size_t fill;
+} dbc;
+
+static uint32_t dbc_read(unsigned int reg)
+{
+	return read32p(dbc.regs + reg);
+}
+
+static void dbc_write(unsigned int reg, uint32_t value)
+{
+	write32p(dbc.regs + reg, value);
+}
+
+static void dbc_write64(unsigned int reg, uint64_t value)
+{
+	write32p(dbc.regs + reg, value);
+	write32p(dbc.regs + reg + 4, value >> 32);
+}
+
+static uintptr_t xhci_mmio_base(void)
+{
+	uint32_t bar = pci_s_read_config32(dbc.dev, PCI_BASE_ADDRESS_0);
+	uint64_t base = bar & ~PCI_BASE_ADDRESS_MEM_ATTR_MASK;
+
+	if ((bar & PCI_BASE_ADDRESS_MEM_LIMIT_MASK) == PCI_BASE_ADDRESS_MEM_LIMIT_64)
+		base |= (uint64_t)pci_s_read_config32(dbc.dev, PCI_BASE_ADDRESS_1) << 32;
+
+	/* 32-bit ramstage can't reach a BAR above 4GiB. */
+	if (base != (uintptr_t)base)
+		return 0;
+
+	return base;
+}
+
+static void xhci_enable_mmio(void)
+{
+	const uint16_t cmd = pci_s_read_config16(dbc.dev, PCI_COMMAND);
+
+	pci_s_write_config16(dbc.dev, PCI_COMMAND,
+			     cmd | PCI_COMMAND_MEMORY | PCI_COMMAND_MASTER);
+}
+
+static unsigned int xhci_find_dbc(uintptr_t base)
+{
+	unsigned int offset = read16p(base + XHCI_HCCPARAMS1_XECP) << 2;
+
+	while (offset) {
+		const uint32_t cap = read32p(base + offset);
+		const unsigned int next = (cap >> 8) & 0xff;
+
+		if ((cap & 0xff) == XHCI_ECP_CAP_ID_DBC)
+			return offset;
+
+		offset = next ? offset + (next << 2) : 0;
+	}
+
+	return 0;
+}
+
+static uint8_t dbc_string(uint8_t *desc, const char *str)
+{
+	const size_t len = MIN(strlen(str), DBC_STRING_SIZE / 2 - 1);
+	size_t i;
+
+	desc[0] = 2 + 2 * len;
+	desc[1] = 3; /* USB_DT_STRING */
+	for (i = 0; i < len; i++) {
+		desc[2 + 2 * i] = str[i];
+		desc[3 + 2 * i] = 0;
+	}
+
+	return desc[0];
+}
+
+static void dbc_init_ring(struct dbc_trb *ring)
+{
+	struct dbc_trb *link = &ring[DBC_RING_TRBS - 1];
+
+	memset(ring, 0, DBC_RING_TRBS * sizeof(*ring));
+	link->field[0] = (uintptr_t)ring;
+	link->field[1] = (uint64_t)(uintptr_t)ring >> 32;
+	link->field[3] = TRB_TYPE(TRB_LINK) | TRB_TC;
+}
+
+/* Reset both transfer rings, the controller picks them up when it gets configured. */
+static void dbc_init_transfer_rings(void)
+{
+	dbc_init_ring(dbc_dma.out_ring);
+	dbc_init_ring(dbc_dma.in_ring);
+	dbc_dma.ctx.out.deq = (uintptr_t)dbc_dma.out_ring | TRB_CYCLE;
+	dbc_dma.ctx.in.deq = (uintptr_t)dbc_dma.in_ring | TRB_CYCLE;
+
+	dbc.in_idx = 0;
+	dbc.in_cycle = TRB_CYCLE;
+	/* Whatever was in flight is gone, the buffer being filled stays. */
+	dbc.pending = 0;
+	dbc.stalled = false;
+}
+
+static void dbc_init_context(void)
+{
+	struct dbc_info_ctx *info = &dbc_dma.ctx.info;
+	const uint32_t max_burst = DBC_DCCTRL_MAX_BURST(dbc_read(DBC_DCCTRL));
+	uint8_t len[4];
+
+	/* String descriptor zero holds the supported language, US English. */
+	dbc_dma.strings[0][0] = 4;
+	dbc_dma.strings[0][1] = 3;
+	dbc_dma.strings[0][2] = 0x09;
+	dbc_dma.strings[0][3] = 0x04;
+	len[0] = 4;
+	len[1] = dbc_string(dbc_dma.strings[1], "coreboot");
+	len[2] = dbc_string(dbc_dma.strings[2], "coreboot console");
+	len[3] = dbc_string(dbc_dma.strings[3], "0001");
+
+	info->string0 = (uintptr_t)dbc_dma.strings[0];
+	info->manufacturer = (uintptr_t)dbc_dma.strings[1];
+	info->product = (uintptr_t)dbc_dma.strings[2];
+	info->serial = (uintptr_t)dbc_dma.strings[3];
+	info->length = len[0] | len[1] << 8 | len[2] << 16 | len[3] << 24;
+
+	dbc_dma.ctx.out.ep_info2 = EP_TYPE_BULK_OUT << 3 | max_burst << 8 |
+				   EP_MAX_PACKET << 16;
+	dbc_dma.ctx.in.ep_info2 = EP_TYPE_BULK_IN << 3 | max_burst << 8 |
+				  EP_MAX_PACKET << 16;
+	dbc_init_transfer_rings();
+
+	memset(dbc_dma.event_ring, 0, sizeof(dbc_dma.event_ring));
+	dbc_dma.erst.seg_addr = (uintptr_t)dbc_dma.event_ring;
+	dbc_dma.erst.seg_size = DBC_EVENT_TRBS;
+	dbc.evt_idx = 0;
+	dbc.evt_cycle = TRB_CYCLE;
+
+	dbc_write(DBC_DCERSTSZ, 1);
+	dbc_write64(DBC_DCERSTBA, (uintptr_t)&dbc_dma.erst);
+	dbc_write64(DBC_DCERDP, (uintptr_t)dbc_dma.event_ring);
+	dbc_write64(DBC_DCCP, (uintptr_t)&dbc_dma.ctx);
+	dbc_write(DBC_DCDDI1, DBC_VENDOR_ID << 16 | DBC_PROTOCOL);
+	dbc_write(DBC_DCDDI2, DBC_DEVICE_REV << 16 | DBC_PRODUCT_ID);
+}
+
+static void dbc_poll_events(void)
+{
+	bool handled = false;
+	uint32_t ctrl;
+
+	for (;;) {
+		const volatile struct dbc_trb *trb = &dbc_dma.event_ring[dbc.evt_idx];
+		const uint32_t control = trb->field[3];
+		const uintptr_t ptr = trb->field[0];
+
+		if ((control & TRB_CYCLE) != dbc.evt_cycle)
+			break;
+
+		switch (TRB_GET_TYPE(control)) {
+		case TRB_TRANSFER_EVENT:
+			/* Transfers complete in order, so this is the oldest one. */
+			if (ptr >= (uintptr_t)dbc_dma.in_ring &&
+			    ptr < (uintptr_t)&dbc_dma.in_ring[DBC_RING_TRBS] && dbc.pending) {
+				dbc.pending--;
+				dbc.stalled = false;
+			}
+			break;
+		case TRB_PORT_STATUS_EVENT:
+			dbc_write(DBC_DCPORTSC, dbc_read(DBC_DCPORTSC) | DBC_DCPORTSC_CHANGE);
+			break;
+		}
+
+		if (++dbc.evt_idx == DBC_EVENT_TRBS) {
+			dbc.evt_idx = 0;
+			dbc.evt_cycle ^= TRB_CYCLE;
+		}
+		handled = true;
+	}
+
+	if (handled)
+		dbc_write64(DBC_DCERDP, (uintptr_t)&dbc_dma.event_ring[dbc.evt_idx]);
+
+	ctrl = dbc_read(DBC_DCCTRL);
+	if (ctrl & DBC_DCCTRL_DRC) {
+		/* The host went away, start over once it configures us again. */
+		dbc_write(DBC_DCCTRL, ctrl);
+		dbc.configured = false;
+		dbc_init_transfer_rings();
+	}
+	if (ctrl & DBC_DCCTRL_DCR)
+		dbc.configured = true;
+}
+
+/* Hand the buffer that is being filled to the controller, if it can take it. */
+static void dbc_submit(void)
+{
+	struct dbc_trb *trb = &dbc_dma.in_ring[dbc.in_idx];
+	const uintptr_t buf = (uintptr_t)dbc_dma.tx_buf[dbc.head];
+
+	if (!dbc.configured || !dbc.fill || dbc.pending == DBC_TX_BUFS)
+		return;
+	if (dbc_read(DBC_DCCTRL) & DBC_DCCTRL_HIT)
+		return;
+
+	/* The cycle bit goes last, it passes the TRB to the controller. */
+	write32(&trb->field[0], buf);
+	write32(&trb->field[1], (uint64_t)buf >> 32);
+	write32(&trb->field[2], dbc.fill);
+	write32(&trb->field[3], TRB_TYPE(TRB_NORMAL) | TRB_IOC | dbc.in_cycle);
+
+	if (++dbc.in_idx == DBC_RING_TRBS - 1) {
+		struct dbc_trb *link = &dbc_dma.in_ring[DBC_RING_TRBS - 1];
+
+		write32(&link->field[3], TRB_TYPE(TRB_LINK) | TRB_TC | dbc.in_cycle);
+		dbc.in_idx = 0;
+		dbc.in_cycle ^= TRB_CYCLE;
+	}
+
+	dbc_write(DBC_DCDB, DBC_DCDB_TARGET_IN);
+
+	dbc.head = (dbc.head + 1) % DBC_TX_BUFS;
+	dbc.pending++;
+	dbc.fill = 0;
+}
+
+/* Wait until at most `pending` transfers are in flight. */
+static void dbc_wait(unsigned int pending)
+{
+	struct stopwatch sw;
+
+	if (dbc.stalled)
+		return;
+
+	stopwatch_init_msecs_expire(&sw, DBC_TX_TIMEOUT_MS);
+	do {
+		dbc_poll_events();
+		if (dbc.pending <= pending)
+			return;
+	} while (!stopwatch_expired(&sw));
+
+	dbc.stalled = true;
+}
+
+void xhci_dbc_tx_byte(unsigned char data)
+{
+	if (!dbc.regs)
+		return;
+
+	if (dbc.fill == DBC_TX_BUF_SIZE || dbc.pending == DBC_TX_BUFS) {
+		dbc_poll_events();
+		dbc_submit();
+		if (dbc.pending == DBC_TX_BUFS) {
+			dbc_wait(DBC_TX_BUFS - 1);
+			dbc_submit();
+		}
+		/* Drop output while nobody takes it. */
+		if (dbc.fill == DBC_TX_BUF_SIZE || dbc.pending == DBC_TX_BUFS)
+			return;
+	}
+
+	dbc_dma.tx_buf[dbc.head][dbc.fill++] = data;
+}
+
+void xhci_dbc_tx_flush(void)
+{
+	if (!dbc.regs)
+		return;
+
+	dbc_poll_events();
+	dbc_submit();
+}
+
+void xhci_dbc_sync(void)
+{
+	if (!dbc.regs)
+		return;
+
+	dbc_poll_events();
+	dbc_submit();
+	if (dbc.fill) {
+		dbc_wait(DBC_TX_BUFS - 1);
+		dbc_submit();
+	}
+	dbc_wait(0);
+}
+
+void xhci_dbc_init(void)
+{
+	uintptr_t base;
+	uint8_t pm_cap;
+
+	dbc.dev = PCI_DEV(0, PCI_SLOT(CONFIG_USBDEBUG_XHCI_DBC_DEVFN),
+			  PCI_FUNC(CONFIG_USBDEBUG_XHCI_DBC_DEVFN));
+
+	if (pci_s_read_config32(dbc.dev, PCI_CLASS_REVISION) >> 8 != PCI_XHCI_CLASSCODE)
+		return;
+
+	pm_cap = pci_s_find_capability(dbc.dev, PCI_CAP_ID_PM);
+	if (pm_cap) {
+		uint16_t pm_ctrl = pci_s_read_config16(dbc.dev, pm_cap + PCI_PM_CTRL);
+		/* Set to D0 and disable PM events. */
+		pm_ctrl &= ~(PCI_PM_CTRL_PME_ENABLE | PCI_PM_CTRL_STATE_MASK);
+		pci_s_write_config16(dbc.dev, pm_cap + PCI_PM_CTRL, pm_ctrl);
+	}
+
+	base = xhci_mmio_base();
+	if (!base) {
+		pci_s_write_config32(dbc.dev, PCI_BASE_ADDRESS_0, CONFIG_USBDEBUG_XHCI_DBC_BAR);
+		pci_s_write_config32(dbc.dev, PCI_BASE_ADDRESS_1, 0);
+		base = CONFIG_USBDEBUG_XHCI_DBC_BAR;
+	}
+	xhci_enable_mmio();
+
+	dbc.cap = xhci_find_dbc(base);
+	if (!dbc.cap)
+		return;
+	dbc.regs = base + dbc.cap;
+
+	/* Start from scratch, whatever enabled DbC before us left stale pointers. */
+	dbc_write(DBC_DCCTRL, 0);
+	if (!wait_ms(DBC_ENABLE_TIMEOUT_MS, !(dbc_read(DBC_DCCTRL) & DBC_DCCTRL_DCE)))
+		goto fail;
+
+	dbc_init_context();
+
+	dbc_write(DBC_DCCTRL, DBC_DCCTRL_DCE | DBC_DCCTRL_LSE);
+	if (!wait_ms(DBC_ENABLE_TIMEOUT_MS, dbc_read(DBC_DCCTRL) & DBC_DCCTRL_DCE))
+		goto fail;
+
+	/*
+	 * Give the host some time to enumerate us when a cable is plugged in. When it
+	 * doesn't, DbC stays enabled and output starts when the host gets to it.
+	 */
+	if (wait_ms(DBC_CONNECT_TIMEOUT_MS, dbc_read(DBC_DCPORTSC) & DBC_DCPORTSC_CCS))
+		wait_ms(DBC_CONFIGURE_TIMEOUT_MS, dbc_read(DBC_DCCTRL) & DBC_DCCTRL_DCR);
+	dbc_poll_events();
+	return;
+
+fail:
+	dbc_write(DBC_DCCTRL, 0);
+	dbc.regs = 0;
+	dbc.cap = 0;
+}
+
+/* The resource allocator may move the BAR, stop using it until it's done. */
+static void dbc_pause(void *unused)
+{
+	xhci_dbc_sync();
+	dbc.regs = 0;
+}
+
+static void dbc_resume(void *unused)
+{
+	const uintptr_t base = xhci_mmio_base();
+
+	if (!dbc.cap || !base)
+		return;
+
+	xhci_enable_mmio();
+	dbc.regs = base + dbc.cap;
+}
+
+/* The DMA structures are in memory that is handed to the OS, shut DbC down. */
+static void dbc_disable(void *unused)
+{
+	if (!dbc.regs)
+		return;
+
+	xhci_dbc_sync();
+	dbc_write(DBC_DCCTRL, 0);
+	dbc.regs = 0;
+	dbc.cap = 0;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_RESOURCES, BS_ON_ENTRY, dbc_pause, NULL);
+BOOT_STATE_INIT_ENTRY(BS_DEV_RESOURCES, BS_ON_EXIT, dbc_resume, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, dbc_disable, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, dbc_disable, NULL);
@@ -18,6 +18,14 @@ cbfs-files-$(CONFIG_USE_SAR) += wifi_sar_defaults.hex
 wifi_sar_defaults.hex-file := $(CONFIG_WIFI_SAR_CBFS_FILEPATH)
 wifi_sar_defaults.hex-type := raw
 
+cbfs-files-$(CONFIG_WIFI_SAR_PREENCODE) += wifi_sar_defaults.aml
+wifi_sar_defaults.aml-file := $(obj)/wifi_sar_defaults.aml
+wifi_sar_defaults.aml-type := raw
+
+$(obj)/wifi_sar_defaults.aml: $(CONFIG_WIFI_SAR_CBFS_FILEPATH) util/wifi_sar/sar-aml.py
+	@printf "    SAR-AML    $(subst $(obj)/,,$(@))\n"
+	util/wifi_sar/sar-aml.py $< $@
+
 endif
 
 CONFIG_WIFI_MTCL_CBFS_FILEPATH := $(call strip_quotes,$(CONFIG_WIFI_MTCL_CBFS_FILEPATH))
@@ -3,6 +3,7 @@
 #include <acpi/acpi_device.h>
 #include <acpi/acpigen.h>
 #include <acpi/acpigen_pci.h>
+#include <cbfs.h>
 #include <console/console.h>
 #include <device/pci_ids.h>
 #include <mtcl.h>
@@ -41,6 +42,11 @@ __weak int get_wifi_sar_limits(union wifi_sar_limits *sar_limits)
 	return -1;
 }
 
+__weak const struct sar_aml_header *get_wifi_sar_aml(void)
+{
+	return NULL;
+}
+
 /*
  * Function 1: Allow PC OEMs to set ETSI 5.8GHz SRD in Passive/Disabled ESTI SRD
  * Channels: 149, 153, 157, 161, 165
@@ -576,6 +582,29 @@ static void sar_emit_wbem(const struct wbem_profile *wbem)
 	acpigen_write_package_end();
 }
 
+/* Copy the SAR objects pre-encoded at build time. Returns false if there are none. */
+static bool emit_sar_aml(struct dsm_profile *dsm, struct bsar_profile *bsar,
+			 bool *bsar_loaded)
+{
+	const struct sar_aml_header *header = get_wifi_sar_aml();
+
+	if (header == NULL)
+		return false;
+
+	acpigen_emit_stream((const char *)header->aml, header->aml_size);
+
+	if (header->flags & SAR_AML_HAS_DSM)
+		memcpy(dsm, &header->dsm, sizeof(*dsm));
+
+	if (header->flags & SAR_AML_HAS_BSAR) {
+		memcpy(bsar, &header->bsar, sizeof(*bsar));
+		*bsar_loaded = true;
+	}
+
+	cbfs_unmap((void *)header);
+	return true;
+}
+
 static void emit_sar_acpi_structures(const struct device *dev, struct dsm_profile *dsm,
 				     struct bsar_profile *bsar, bool *bsar_loaded)
 {
@@ -588,6 +617,9 @@ static void emit_sar_acpi_structures(const struct device *dev, struct dsm_profil
 	if (dev->path.type == DEVICE_PATH_PCI && dev->vendor != PCI_VID_INTEL)
 		return;
 
+	if (CONFIG(WIFI_SAR_PREENCODE) && emit_sar_aml(dsm, bsar, bsar_loaded))
+		return;
+
 	/* Retrieve the SAR limits data */
 	if (get_wifi_sar_limits(&sar_limits) < 0) {
 		printk(BIOS_ERR, "failed getting SAR limits!\n");
@@ -383,6 +383,7 @@ typedef struct acpi_srat {
 
 #define ACPI_SRAT_STRUCTURE_LAPIC 0
 #define ACPI_SRAT_STRUCTURE_MEM   1
+#define ACPI_SRAT_STRUCTURE_X2APIC 2
 #define ACPI_SRAT_STRUCTURE_GIA   5
 
 /* SRAT: Processor x2APIC Structure */
@@ -1777,6 +1778,11 @@ struct pptt_topology *acpi_get_pptt_topology(void);
 int acpi_create_madt_ioapic_from_hw(acpi_madt_ioapic_t *ioapic, u32 addr);
 
 unsigned long acpi_create_madt_one_lapic(unsigned long current, u32 cpu, u32 apic);
+/*
+ * Returns the number of enabled CPUs and points *cpus to them in the order of the MADT:
+ * by thread ID first and then by APIC ID. The list is built on the first call.
+ */
+size_t acpi_get_madt_cpus(const struct device *const **cpus);
 
 unsigned long acpi_create_madt_lapic_nmis(unsigned long current);
 
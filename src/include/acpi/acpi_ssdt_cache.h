@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __ACPI_SSDT_CACHE_H__
+#define __ACPI_SSDT_CACHE_H__
+
+#include <types.h>
+
+/*
+ * The SSDT cache keeps the body (everything after the table header) of the
+ * generated SSDT in an FMAP region. It is keyed by a hash over the coreboot
+ * build, the devicetree including the assigned resources, fw_config and the
+ * location of the coreboot tables. If the key matches, the cached body is
+ * used instead of calling every device's acpi_fill_ssdt().
+ */
+#if CONFIG(ACPI_SSDT_CACHE)
+/*
+ * Copy the cached SSDT body to |body|. Returns the size of the body or 0
+ * if there is no valid cache entry for the current configuration.
+ */
+size_t acpi_ssdt_cache_load(void *body);
+
+/* Queue a freshly generated SSDT body to be written back to flash. */
+void acpi_ssdt_cache_stash(const void *body, size_t size);
+#else
+static inline size_t acpi_ssdt_cache_load(void *body)
+{
+	return 0;
+}
+
+static inline void acpi_ssdt_cache_stash(const void *body, size_t size) {}
+#endif
+
+#endif /* __ACPI_SSDT_CACHE_H__ */
@@ -368,10 +368,37 @@ struct cppc_config {
 
 #define ACPI_MUTEX_NO_TIMEOUT		0xffff
 
+/*
+ * A template records a stretch of generated AML once and replays it on later use. AML is
+ * position independent, so objects that are identical in many scopes, like the _CST and
+ * _PSS of all threads of a CPU, only have to be generated once:
+ *
+ *	static struct acpigen_template tmpl;
+ *
+ *	if (!acpigen_template_replay(&tmpl)) {
+ *		acpigen_template_begin(&tmpl);
+ *		... generate objects ...
+ *		acpigen_template_end(&tmpl);
+ *	}
+ *
+ * The recorded bytes must not depend on anything that differs between the uses, and
+ * a template must not contain an unbalanced acpigen_write_len_f()/acpigen_pop_len().
+ */
+struct acpigen_template {
+	char *start;
+	char *data;
+	size_t len;
+};
+
+bool acpigen_template_replay(const struct acpigen_template *tmpl);
+void acpigen_template_begin(struct acpigen_template *tmpl);
+void acpigen_template_end(struct acpigen_template *tmpl);
+
 void acpigen_write_return_integer(uint64_t arg);
 void acpigen_write_return_namestr(const char *arg);
 void acpigen_write_return_string(const char *arg);
 void acpigen_write_len_f(void);
+void acpigen_write_len(size_t len);
 void acpigen_pop_len(void);
 void acpigen_set_current(char *curr);
 char *acpigen_get_current(void);
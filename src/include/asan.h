@@ -16,6 +16,7 @@
 #define ASAN_STACK_RIGHT	0xF3
 #define ASAN_STACK_PARTIAL	0xF4
 #define ASAN_USE_AFTER_SCOPE	0xF8
+#define ASAN_HEAP_FREE		0xFB
 
 #define _RET_IP_	((unsigned long)__builtin_return_address(0))
 #define likely(x)	__builtin_expect(!!(x), 1)
@@ -62,6 +63,20 @@ void asan_init(void);
 void check_memory_region(unsigned long addr, size_t size, bool write,
 				unsigned long ret_ip);
 
+/*
+ * malloc() keeps a poisoned redzone after each allocation, so that overflows into the
+ * next one are caught as well.
+ */
+#if ENV_RAMSTAGE && CONFIG(ASAN_IN_RAMSTAGE)
+#define ASAN_HEAP_REDZONE	ASAN_SHADOW_SCALE_SIZE
+void asan_heap_alloc(const void *addr, size_t size);
+void asan_heap_free(const void *addr, size_t size);
+#else
+#define ASAN_HEAP_REDZONE	0
+static inline void asan_heap_alloc(const void *addr, size_t size) {}
+static inline void asan_heap_free(const void *addr, size_t size) {}
+#endif
+
 uintptr_t __asan_shadow_offset(uintptr_t addr);
 void __asan_register_globals(struct asan_global *globals, size_t size);
 void __asan_unregister_globals(struct asan_global *globals, size_t size);
@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef BOOT_TASK_H
+#define BOOT_TASK_H
+
+#include <bootstate.h>
+#include <thread.h>
+#include <timer.h>
+#include <types.h>
+
+/*
+ * Boot tasks are pieces of ramstage work that don't belong to one fixed
+ * point of the boot state machine. Instead of attaching to a (state, seq)
+ * pair, a task declares what it needs and by when it has to be finished:
+ *
+ *   needs    - mask of boot states that must have completed before the task
+ *              can start (see the BOOT_TASK_NEEDS_* aliases below). 0 means
+ *              the task can run as soon as ramstage has CBMEM.
+ *   after    - optional NULL-terminated list of tasks that must have
+ *              finished before this one starts.
+ *   deadline - the boot state that must not be entered before the task is
+ *              done. Defaults to BS_OS_RESUME_CHECK, which is reached on
+ *              both the normal and the S3 resume path.
+ *
+ * With COOP_MULTITASKING a task is started on its own thread as soon as its
+ * inputs are ready, so it overlaps with the states that are still running
+ * on the main thread. Without threads, ready tasks run inline at the state
+ * transition that made them ready. Each task is bracketed by
+ * TS_BOOT_TASK_START/END timestamps and a summary of which tasks held up
+ * their deadline state (the critical path) is printed before the OS or the
+ * payload is entered.
+ *
+ * Example:
+ *
+ *	static void read_vpd(void *arg) { ... }
+ *
+ *	static struct boot_task vpd_task = {
+ *		.name = "VPD",
+ *		.run = read_vpd,
+ *		.needs = BOOT_TASK_NEEDS_CBMEM,
+ *		.deadline = BS_WRITE_TABLES,
+ *	};
+ *	BOOT_TASK(vpd_task);
+ */
+
+#define BOOT_TASK_AFTER(state_)			(1U << (state_))
+
+#define BOOT_TASK_NEEDS_CBMEM			0
+#define BOOT_TASK_NEEDS_CHIPS_INITIALIZED	BOOT_TASK_AFTER(BS_DEV_INIT_CHIPS)
+#define BOOT_TASK_NEEDS_PCI_ENUMERATED		BOOT_TASK_AFTER(BS_DEV_ENUMERATE)
+#define BOOT_TASK_NEEDS_RESOURCES_ASSIGNED	BOOT_TASK_AFTER(BS_DEV_RESOURCES)
+#define BOOT_TASK_NEEDS_DEVICES_ENABLED		BOOT_TASK_AFTER(BS_DEV_ENABLE)
+#define BOOT_TASK_NEEDS_DEVICES_INITIALIZED	BOOT_TASK_AFTER(BS_DEV_INIT)
+#define BOOT_TASK_NEEDS_TABLES_WRITTEN		BOOT_TASK_AFTER(BS_WRITE_TABLES)
+
+enum boot_task_state {
+	BOOT_TASK_PENDING,
+	BOOT_TASK_RUNNING,
+	BOOT_TASK_DONE,
+};
+
+struct boot_task {
+	const char *name;
+	void (*run)(void *arg);
+	void *arg;
+	uint32_t needs;
+	struct boot_task *const *after;
+	boot_state_t deadline;
+
+	/* Private to the scheduler. */
+	enum boot_task_state state;
+	struct thread_handle handle;
+	struct mono_time ready;
+	struct mono_time start;
+	struct mono_time end;
+};
+
+#if ENV_RAMSTAGE
+#define BOOT_TASK_ATTR  __attribute__((used, section(".boot_tasks")))
+#else
+#define BOOT_TASK_ATTR  __attribute__((unused))
+#endif
+
+#define BOOT_TASK(task_)						\
+	static struct boot_task *const boot_task_ptr_ ## task_		\
+		BOOT_TASK_ATTR = &(task_)
+
+/* Called by the boot state machine. */
+void boot_tasks_init(void);
+void boot_tasks_state_entered(boot_state_t state);
+void boot_tasks_state_completed(boot_state_t state);
+
+#endif /* BOOT_TASK_H */
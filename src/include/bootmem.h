@@ -94,7 +94,25 @@ bool bootmem_walk(range_action_t action, void *arg);
 int bootmem_region_targets_type(uint64_t start, uint64_t size,
 		enum bootmem_type dest_type);
 
-/* Allocate a temporary buffer from the unused RAM areas. */
+/*
+ * Allocate a temporary buffer from the unused RAM areas. Memory in the proximity domain of
+ * the BSP is preferred if the domains are known.
+ */
 void *bootmem_allocate_buffer(size_t size);
 
+/*
+ * Record the NUMA proximity domain of a memory range, as reported in the SRAT. This can be
+ * called before the memory table is written.
+ */
+void bootmem_add_proximity_domain(uint64_t start, uint64_t size, uint32_t domain);
+
+/* Record the proximity domain of the BSP, buffers are preferably allocated from it. */
+void bootmem_set_bsp_proximity_domain(uint32_t domain);
+
+/*
+ * Returns the proximity domain of the range, or -1 if it is unknown or the range spans
+ * more than one domain.
+ */
+int bootmem_proximity_domain(uint64_t start, uint64_t size);
+
 #endif /* BOOTMEM_H */
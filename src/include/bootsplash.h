@@ -15,6 +15,9 @@ void set_bootsplash(unsigned char *framebuffer, unsigned int x_resolution,
 		    unsigned int y_resolution, unsigned int bytes_per_line,
 		    unsigned int fb_resolution);
 
+/* Returns true if the bootsplash was already drawn from a boot task. */
+bool bootsplash_is_drawn(void);
+
 /*
  * Allow platform-specific BMP logo overrides via HAVE_CUSTOM_BMP_LOGO config.
  * For example: Introduce configurable BMP logo for customization on platforms like ChromeOS
@@ -127,6 +127,29 @@ static inline void *cbfs_unverified_area_cbmem_alloc(const char *area, const cha
  */
 void cbfs_preload(const char *name);
 
+/*
+ * Preloads the files that the prefetch hints (see CBFS_PREFETCH_HINTS) list for the current
+ * stage. Ramstage calls this automatically, other stages that support cbfs_preload() can
+ * call it as soon as their threads are up.
+ */
+void cbfs_preload_hints(void);
+
+/* Records an access to a CBFS file in the CBMEM trace (see CBFS_ACCESS_TRACE). */
+void cbfs_trace_access(const char *name, size_t size);
+
+/*
+ * Mappings kept in CBMEM across stages (see CBFS_MAP_CACHE). A file is identified by its
+ * name and location on the boot device, and with CBFS_VERIFICATION also by its file hash.
+ * cbfs_map_cache_find() returns the mapping and the file hash that was verified when it
+ * was cached. cbfs_map_cache_reserve() returns a buffer to load the file into, which only
+ * becomes visible to cbfs_map_cache_find() after a successful cbfs_map_cache_commit().
+ */
+void *cbfs_map_cache_find(const union cbfs_mdata *mdata, const struct region_device *rdev,
+			  size_t size, const struct vb2_hash **hash);
+void *cbfs_map_cache_reserve(const union cbfs_mdata *mdata, const struct region_device *rdev,
+			     size_t size, int *slot);
+void cbfs_map_cache_commit(int slot, bool success);
+
 /* Removes a previously allocated CBFS mapping. Should try to unmap mappings in strict LIFO
    order where possible, since mapping backends often don't support more complicated cases. */
 void cbfs_unmap(void *mapping);
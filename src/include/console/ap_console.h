@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef _CONSOLE_AP_CONSOLE_H_
+#define _CONSOLE_AP_CONSOLE_H_
+
+#include <stdarg.h>
+
+/*
+ * Per-CPU console rings for APs. Each AP formats its messages into a ring of
+ * its own, so APs never contend for the console lock or wait for a slow UART.
+ * The BSP merges all rings into the regular console in timestamp order at
+ * safe points (after the MP flight plan, after AP work is done and before
+ * leaving ramstage).
+ */
+
+#define __AP_CONSOLE_ENABLE__	(CONFIG(CONSOLE_AP_RINGS) && ENV_RAMSTAGE)
+
+#if __AP_CONSOLE_ENABLE__
+/* Set up rings for |num_cpus| CPUs. Must run on the BSP before APs start. */
+void ap_console_init(int num_cpus);
+/* Returns the number of characters logged, or < 0 if the ring can't be used. */
+int ap_console_vprintk(int msg_level, const char *fmt, va_list args);
+/* Print everything the APs logged so far. BSP only. */
+void ap_console_flush(void);
+#else
+static inline void ap_console_init(int num_cpus) {}
+static inline int ap_console_vprintk(int msg_level, const char *fmt, va_list args)
+{
+	return -1;
+}
+static inline void ap_console_flush(void) {}
+#endif
+
+#endif /* _CONSOLE_AP_CONSOLE_H_ */
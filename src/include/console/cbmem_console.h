@@ -2,8 +2,10 @@
 #ifndef _CONSOLE_CBMEM_CONSOLE_H_
 #define _CONSOLE_CBMEM_CONSOLE_H_
 
-#include <stdint.h>
+#include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 void cbmemc_init(void);
 void cbmemc_tx_byte(unsigned char data);
@@ -26,6 +28,22 @@ static inline void __cbmemc_tx_byte(u8 data)	{}
  */
 void cbmemc_copy_in(void *buffer, size_t size);
 
+/*
+ * Deferred UART output (CONSOLE_SERIAL_DEFERRED): once the CBMEM console is up,
+ * cbmemc_drain() copies up to |len| bytes that were logged since the last call
+ * into |buf|. |lost| returns how many bytes were overwritten before they could
+ * be drained.
+ */
+bool cbmemc_drain_enabled(void);
+size_t cbmemc_drain(u8 *buf, size_t len, u32 *lost);
+
+/*
+ * CONSOLE_CBMEM_BINARY_LOG: store a message as a binary record instead of text,
+ * see commonlib/console_binlog.h. Returns < 0 if the message has to be printed
+ * as text, args may be used up in that case.
+ */
+int cbmemc_binlog_vprintk(int msg_level, const char *fmt, va_list args);
+
 void cbmem_dump_console_to_uart(void);
 void cbmem_dump_console(void);
 #endif
@@ -62,6 +62,10 @@ void do_putchar(unsigned char byte);
 long console_time_get_and_reset(void);
 void console_time_report(void);
 
+/* Write out what consoles hold back to batch their writes, e.g. before the
+   stage hands off or the system halts. */
+void console_sync(void);
+
 /*
  * "Fast" basically means only the CBMEM console right now. This is used to still
  * print debug messages there when loglevel disables the other consoles. It is also
@@ -71,8 +75,9 @@ void console_time_report(void);
 enum { CONSOLE_LOG_NONE = 0, CONSOLE_LOG_FAST, CONSOLE_LOG_ALL };
 #define HAS_ONLY_FAST_CONSOLES !(CONFIG(SPKMODEM) || CONFIG(CONSOLE_QEMU_DEBUGCON) || \
 	CONFIG(CONSOLE_SERIAL) || CONFIG(CONSOLE_NE2K) || CONFIG(CONSOLE_USB) || \
-	CONFIG(EM100PRO_SPI_CONSOLE) || CONFIG(CONSOLE_SPI_FLASH) || \
-	CONFIG(CONSOLE_SYSTEM76_EC) || CONFIG(CONSOLE_AMD_SIMNOW))
+	CONFIG(CONSOLE_XHCI_DBC) || CONFIG(EM100PRO_SPI_CONSOLE) || \
+	CONFIG(CONSOLE_SPI_FLASH) || CONFIG(CONSOLE_SYSTEM76_EC) || \
+	CONFIG(CONSOLE_AMD_SIMNOW) || CONFIG(CONSOLE_ESPI))
 
 #else
 static inline int get_log_level(void) { return -1; }
@@ -85,6 +90,7 @@ static inline int vprintk(int LEVEL, const char *fmt, va_list args) { return 0;
 static inline void do_putchar(unsigned char byte) {}
 static inline long console_time_get_and_reset(void) { return 0; }
 static inline void console_time_report(void) {}
+static inline void console_sync(void) {}
 #endif
 
 #endif /* CONSOLE_CONSOLE_H_ */
@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _CONSOLE_ESPI_H_
+#define _CONSOLE_ESPI_H_
+
+#include <stdint.h>
+
+/*
+ * Layout of the shared memory window of the eSPI console. coreboot fills the ring
+ * behind the header and advances `head`, the EC or BMC reads up to `head` and moves
+ * `tail` behind what it consumed. Both are byte offsets into the ring. coreboot
+ * writes whole dwords, NUL bytes in the ring are padding.
+ */
+struct espi_console_header {
+	uint32_t signature;
+	/* Size of the ring behind the header, a multiple of 4 */
+	uint32_t size;
+	uint32_t head;
+	uint32_t tail;
+} __packed;
+
+#define ESPI_CONSOLE_SIGNATURE	0x474f4c43	/* "CLOG" */
+
+void espi_console_init(void);
+void espi_console_tx_byte(unsigned char data);
+void espi_console_tx_flush(void);
+
+#define __CONSOLE_ESPI_ENABLE__	(CONFIG(CONSOLE_ESPI) && ENV_X86 && !ENV_SMM)
+
+#if __CONSOLE_ESPI_ENABLE__
+static inline void __espi_console_init(void)	{ espi_console_init(); }
+static inline void __espi_console_tx_byte(u8 data)	{ espi_console_tx_byte(data); }
+static inline void __espi_console_tx_flush(void)	{ espi_console_tx_flush(); }
+#else
+static inline void __espi_console_init(void)	{}
+static inline void __espi_console_tx_byte(u8 data)	{}
+static inline void __espi_console_tx_flush(void)	{}
+#endif
+
+#endif /* _CONSOLE_ESPI_H_ */
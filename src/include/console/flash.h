@@ -8,6 +8,8 @@
 void flashconsole_init(void);
 void flashconsole_tx_byte(unsigned char c);
 void flashconsole_tx_flush(void);
+/* Write out a partial page that CONSOLE_SPI_FLASH_PAGE_WRITES holds back. */
+void flashconsole_sync(void);
 
 #define __CONSOLE_FLASH_ENABLE__	CONFIG(CONSOLE_SPI_FLASH)
 
@@ -21,10 +23,12 @@ static inline void __flashconsole_tx_flush(void)
 {
 	flashconsole_tx_flush();
 }
+static inline void __flashconsole_sync(void)	{ flashconsole_sync(); }
 #else
 static inline void __flashconsole_init(void)	{}
 static inline void __flashconsole_tx_byte(u8 data)	{}
 static inline void __flashconsole_tx_flush(void)	{}
+static inline void __flashconsole_sync(void)	{}
 #endif /* __CONSOLE_FLASH_ENABLE__ */
 
 #endif /* CONSOLE_FLASH_H */
@@ -3,6 +3,7 @@
 #ifndef CONSOLE_UART_H
 #define CONSOLE_UART_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Return the clock frequency UART uses as reference clock for
@@ -51,6 +52,8 @@ void uart_init(unsigned int idx);
 void uart_tx_byte(unsigned int idx, unsigned char data);
 void uart_tx_flush(unsigned int idx);
 unsigned char uart_rx_byte(unsigned int idx);
+/* Writes the byte if the TX FIFO has room and returns 0 otherwise. Only 8250 drivers. */
+int uart_try_tx_byte(unsigned int idx, unsigned char data);
 
 uintptr_t uart_platform_base(unsigned int idx);
 
@@ -65,6 +68,30 @@ void oxford_remap(unsigned int new_base);
 	(ENV_BOOTBLOCK || ENV_SEPARATE_ROMSTAGE || ENV_RAMSTAGE || ENV_SEPARATE_VERSTAGE \
 	 || ENV_POSTCAR || (ENV_SMM && CONFIG(DEBUG_SMI))))
 
+/*
+ * With CONSOLE_SERIAL_DEFERRED, ramstage console output only goes to the CBMEM
+ * console once that is available, and a background thread copies it to the
+ * UART while the boot flow waits on something else.
+ */
+#if CONFIG(CONSOLE_SERIAL_DEFERRED) && ENV_RAMSTAGE
+bool uart_console_deferred(void);
+/* Synchronously write out everything that hasn't been drained yet. */
+void uart_console_drain_all(void);
+#else
+static inline bool uart_console_deferred(void) { return false; }
+static inline void uart_console_drain_all(void) {}
+#endif
+
+/*
+ * With CONSOLE_SERIAL_TX_RING, output that doesn't fit into the UART's FIFO is kept in
+ * a ring buffer. uart_ring_poll() moves as much of it to the UART as fits without waiting,
+ * uart_ring_sync() writes out all of it.
+ */
+#define __UART_TX_RING_ENABLE__	(CONFIG(CONSOLE_SERIAL_TX_RING) && !ENV_SMM)
+void uart_ring_tx_byte(unsigned char data);
+void uart_ring_poll(void);
+void uart_ring_sync(void);
+
 #if __CONSOLE_SERIAL_ENABLE__
 static inline void __uart_init(void)
 {
@@ -72,16 +99,32 @@ static inline void __uart_init(void)
 }
 static inline void __uart_tx_byte(u8 data)
 {
-	uart_tx_byte(get_uart_for_console(), data);
+	if (uart_console_deferred())
+		return;
+	if (__UART_TX_RING_ENABLE__)
+		uart_ring_tx_byte(data);
+	else
+		uart_tx_byte(get_uart_for_console(), data);
 }
 static inline void __uart_tx_flush(void)
 {
-	uart_tx_flush(get_uart_for_console());
+	if (uart_console_deferred())
+		return;
+	if (__UART_TX_RING_ENABLE__)
+		uart_ring_poll();
+	else
+		uart_tx_flush(get_uart_for_console());
+}
+static inline void __uart_sync(void)
+{
+	if (__UART_TX_RING_ENABLE__)
+		uart_ring_sync();
 }
 #else
 static inline void __uart_init(void)		{}
 static inline void __uart_tx_byte(u8 data)	{}
 static inline void __uart_tx_flush(void)	{}
+static inline void __uart_sync(void)		{}
 #endif
 
 #if CONFIG(GDB_STUB) && (ENV_ROMSTAGE_OR_BEFORE || ENV_RAMSTAGE)
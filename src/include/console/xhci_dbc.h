@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _CONSOLE_XHCI_DBC_H_
+#define _CONSOLE_XHCI_DBC_H_
+
+void xhci_dbc_init(void);
+void xhci_dbc_tx_byte(unsigned char data);
+void xhci_dbc_tx_flush(void);
+/* Wait until all output went out, or the host stopped taking it. */
+void xhci_dbc_sync(void);
+
+/* The DMA structures need DRAM, so there is no DbC console before ramstage. */
+#define __CONSOLE_XHCI_DBC_ENABLE__	(CONFIG(CONSOLE_XHCI_DBC) && ENV_RAMSTAGE)
+
+#if __CONSOLE_XHCI_DBC_ENABLE__
+static inline void __xhci_dbc_init(void)	{ xhci_dbc_init(); }
+static inline void __xhci_dbc_tx_byte(unsigned char data)	{ xhci_dbc_tx_byte(data); }
+static inline void __xhci_dbc_tx_flush(void)	{ xhci_dbc_tx_flush(); }
+static inline void __xhci_dbc_sync(void)	{ xhci_dbc_sync(); }
+#else
+static inline void __xhci_dbc_init(void)	{}
+static inline void __xhci_dbc_tx_byte(unsigned char data)	{}
+static inline void __xhci_dbc_tx_flush(void)	{}
+static inline void __xhci_dbc_sync(void)	{}
+#endif
+
+#endif /* _CONSOLE_XHCI_DBC_H_ */
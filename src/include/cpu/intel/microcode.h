@@ -8,14 +8,13 @@
  * config selected. */
 void intel_reload_microcode(void);
 
+/* Update the microcode of the calling CPU. Threads of a core update one after
+ * the other, different cores update in parallel. */
 void intel_update_microcode_from_cbfs(void);
-/* Find a microcode that matches the revision and platform family returning
- * NULL if none found. The found microcode is cached for faster access on
- * subsequent calls of this function.
- *
- * Since this function caches the found microcode (NULL or a valid microcode
- * pointer), it is expected to be run from BSP before starting any other APs.
- * It is not multithread safe otherwise. */
+/* Find a microcode that matches the signature and platform ID of the calling
+ * CPU returning NULL if none found. The found microcode is cached per signature
+ * and platform ID for faster access on subsequent calls of this function, also
+ * from other CPUs. */
 const void *intel_microcode_find(void);
 
 /* It is up to the caller to determine if parallel loading is possible as
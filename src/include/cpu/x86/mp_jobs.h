@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef CPU_X86_MP_JOBS_H
+#define CPU_X86_MP_JOBS_H
+
+#include <smp/atomic.h>
+#include <types.h>
+
+/*
+ * A small job system on top of PARALLEL_MP_AP_WORK. Between mp_jobs_begin() and mp_jobs_end()
+ * the APs run a worker loop. Every CPU has its own deque of jobs: a CPU pushes and pops jobs
+ * on its own deque and steals from the other end of the other deques when its own runs dry.
+ * mp_job_join() runs other jobs while it waits, so jobs can submit and join jobs themselves.
+ *
+ * Without MP_JOBS, or if the APs can't be started, everything still works: the jobs are run
+ * by the CPUs that submit or join them.
+ *
+ *	struct mp_job jobs[N];
+ *
+ *	mp_jobs_begin();
+ *	for (i = 0; i < N; i++)
+ *		mp_job_submit(&jobs[i], hash_chunk, &chunks[i]);
+ *	for (i = 0; i < N; i++)
+ *		mp_job_join(&jobs[i]);
+ *	mp_jobs_end();
+ *
+ * While the job system is running, mp_run_on_aps() and friends can't be used.
+ */
+
+struct mp_job {
+	void (*func)(void *arg);
+	void *arg;
+	atomic_t done;
+};
+
+#if CONFIG(MP_JOBS)
+/* Start the worker loop on all APs. */
+enum cb_err mp_jobs_begin(void);
+
+/* Wait until all submitted jobs are done and return the APs to mp_run_on_aps(). */
+void mp_jobs_end(void);
+
+/* Queue |job| on the deque of the current CPU. The job must stay valid until it is joined. */
+void mp_job_submit(struct mp_job *job, void (*func)(void *arg), void *arg);
+
+/* Wait for |job| to finish, running other queued jobs in the meantime. */
+void mp_job_join(struct mp_job *job);
+#else
+static inline enum cb_err mp_jobs_begin(void)
+{
+	return CB_ERR;
+}
+
+static inline void mp_jobs_end(void)
+{
+}
+
+static inline void mp_job_submit(struct mp_job *job, void (*func)(void *arg), void *arg)
+{
+	func(arg);
+	atomic_set(&job->done, 1);
+}
+
+static inline void mp_job_join(struct mp_job *job)
+{
+}
+#endif
+
+#endif /* CPU_X86_MP_JOBS_H */
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef _CPU_X86_MP_TIMESTAMP_H_
+#define _CPU_X86_MP_TIMESTAMP_H_
+
+#include <stdint.h>
+#include <timestamp.h>
+
+/*
+ * Per-CPU timestamp buffers. Each CPU records into a buffer of its own, so APs
+ * can take timestamps in parallel. The BSP merges the buffers into the
+ * timestamp table, with the CPU index in each entry_id (see TIMESTAMP_CPU()).
+ */
+
+#define __MP_TIMESTAMPS_ENABLE__	(CONFIG(MP_TIMESTAMPS) && ENV_RAMSTAGE)
+
+#if __MP_TIMESTAMPS_ENABLE__
+/* Set up buffers for |num_cpus| CPUs. Must run on the BSP before APs start. */
+void mp_timestamp_init(int num_cpus);
+/* Record a timestamp for the calling CPU. Safe on any CPU with cpu_info set up. */
+void mp_timestamp_add(enum timestamp_id id, uint64_t ts_time);
+/* Add everything the CPUs recorded so far to the timestamp table. BSP only. */
+void mp_timestamp_flush(void);
+#else
+static inline void mp_timestamp_init(int num_cpus) {}
+static inline void mp_timestamp_add(enum timestamp_id id, uint64_t ts_time) {}
+static inline void mp_timestamp_flush(void) {}
+#endif
+
+static inline void mp_timestamp_add_now(enum timestamp_id id)
+{
+	mp_timestamp_add(id, timestamp_get());
+}
+
+#endif /* _CPU_X86_MP_TIMESTAMP_H_ */
@@ -83,6 +83,13 @@ void x86_setup_mtrrs(void);
  */
 void x86_setup_mtrrs_with_detect(void);
 void x86_setup_mtrrs_with_detect_no_above_4gb(void);
+/*
+ * x86_commit_mtrrs() programs the fixed and variable MTRRs of the calling CPU
+ * with the solution the BSP derived in an earlier x86_setup_mtrrs*() call. It
+ * doesn't walk the memory map or log anything, so it is cheap enough to run on
+ * all APs at once. Does nothing if the BSP has no solution yet.
+ */
+void x86_commit_mtrrs(void);
 /*
  * x86_setup_var_mtrrs() parameters:
  * address_bits - number of physical address bits supported by cpu
@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef CPU_X86_PROFILER_H
+#define CPU_X86_PROFILER_H
+
+/* IDT vector used by the LAPIC timer interrupt of the ramstage profiler. */
+#define PROFILER_VECTOR 0x20
+
+#if !defined(__ASSEMBLER__)
+
+#include <arch/registers.h>
+
+#if CONFIG(RAMSTAGE_PROFILER) && ENV_RAMSTAGE
+/* Called from the interrupt handler to record the interrupted stack. */
+void profiler_sample(struct eregs *info);
+
+/*
+ * Stop sampling around code that has to run with interrupts disabled, like FSP. The time
+ * spent until profiler_resume() is recorded as a single weighted sample of the caller's
+ * stack, so it still shows up in the profile.
+ */
+void profiler_suspend(void);
+void profiler_resume(void);
+#else
+static inline void profiler_suspend(void) {}
+static inline void profiler_resume(void) {}
+#endif
+
+#endif /* !__ASSEMBLER__ */
+
+#endif /* CPU_X86_PROFILER_H */
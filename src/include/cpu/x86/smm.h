@@ -80,6 +80,47 @@ struct smm_pci_resource_info {
 	struct resource resources[SMM_PCI_RESOURCE_STORE_NUM_RESOURCES];
 };
 
+/*
+ * Ring of SMI latencies in CBMEM. The SMI handler writes entry 'count' modulo the
+ * number of entries and increments 'count' afterwards.
+ */
+struct smm_latency_entry {
+	u64 entry_tsc;
+	u64 exit_tsc;
+	u32 cpu;
+	u32 reserved;
+} __packed;
+
+struct smm_latency_log {
+	u32 num_entries;
+	u32 count;
+	struct smm_latency_entry entries[];
+} __packed;
+
+/*
+ * Histogram of SMI durations. Bucket 0 counts durations of less than
+ * 2^(SMM_HISTOGRAM_SHIFT + 1) TSC ticks, bucket n those from
+ * 2^(SMM_HISTOGRAM_SHIFT + n) on, the last bucket everything longer.
+ * Sources 0-31 are southbridge specific (SMI_STS bits on Intel), source
+ * SMM_HISTOGRAM_TOTAL is the whole SMI.
+ */
+#define SMM_HISTOGRAM_SOURCES	33
+#define SMM_HISTOGRAM_TOTAL	32
+#define SMM_HISTOGRAM_BUCKETS	16
+#define SMM_HISTOGRAM_SHIFT	10
+
+struct smm_latency_histogram {
+	u32 sources;
+	u32 buckets;
+	u32 shift;
+	u32 count[SMM_HISTOGRAM_SOURCES][SMM_HISTOGRAM_BUCKETS];
+} __packed;
+
+/* Count an SMI or a part of it that took 'ticks' TSC ticks. */
+void smm_latency_histogram_add(unsigned int source, u64 ticks);
+/* Copy the histogram out of SMRAM. Returns 0 on success, -1 if buf is unusable. */
+int smm_latency_histogram_read(void *buf, size_t size);
+
 struct smm_runtime {
 	u32 smbase;
 	u32 smm_size;
@@ -95,6 +136,9 @@ struct smm_runtime {
 	int smm_log_level;
 	uintptr_t smmstore_com_buffer_base;
 	size_t smmstore_com_buffer_size;
+#if CONFIG(SMM_LATENCY_LOG)
+	uintptr_t latency_log;
+#endif
 } __packed;
 
 struct smm_module_params {
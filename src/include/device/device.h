@@ -23,6 +23,7 @@ struct spi_bus_operations;
 struct usb_bus_operations;
 struct gpio_operations;
 struct mdio_bus_operations;
+struct pciexp_ext_caps;
 
 /* Chip operations */
 struct chip_operations {
@@ -48,6 +49,9 @@ struct device_operations {
 	void (*enable)(struct device *dev);
 	void (*vga_disable)(struct device *dev);
 	void (*reset_bus)(struct bus *bus);
+	/* With MINIMAL_S3_RESUME, called on S3 resume instead of setting up
+	   the resources and calling enable_resources() and init(). */
+	void (*resume)(struct device *dev);
 
 	int (*get_smbios_data)(struct device *dev, int *handle,
 		unsigned long *current);
@@ -67,6 +71,10 @@ struct device_operations {
 	const struct pnp_mode_ops *ops_pnp_mode;
 	const struct gpio_operations *ops_gpio;
 	const struct mdio_bus_operations *ops_mdio;
+
+	/* With PARALLEL_DEVICE_INIT, init() of this device and its whole
+	   downstream subtree may run on a separate cooperative thread. */
+	bool init_concurrent;
 };
 
 /**
@@ -128,6 +136,8 @@ struct device {
 	struct device_operations *ops;
 	struct chip_operations *chip_ops;
 	const char *name;
+	/* Extended capabilities, read in one walk by pciexp_find_extended_cap(). */
+	struct pciexp_ext_caps *ext_caps;
 #if CONFIG(GENERATE_SMBIOS_TABLES)
 	u8 smbios_slot_type;
 	u8 smbios_slot_data_width;
@@ -159,6 +169,11 @@ struct device {
 extern DEVTREE_CONST struct device	dev_root;
 /* list of all devices */
 extern DEVTREE_CONST struct device * DEVTREE_CONST all_devices;
+#if !DEVTREE_EARLY
+/* PCI devices on the root bus from the static tree, indexed by devfn (static.c). */
+extern DEVTREE_CONST struct device *const pci_root_devfn_table[];
+extern const size_t pci_root_devfn_table_size;
+#endif
 extern struct resource	*free_resources;
 extern struct bus	*free_links;
 
@@ -170,6 +185,7 @@ void dev_enumerate(void);
 void dev_configure(void);
 void dev_enable(void);
 void dev_initialize(void);
+void dev_resume(void);
 void dev_finalize(void);
 void dev_finalize_chips(void);
 /* Function used to override device state */
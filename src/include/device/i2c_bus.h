@@ -13,6 +13,25 @@ struct i2c_bus_operations {
 	int (*transfer)(struct device *, const struct i2c_msg *, size_t count);
 };
 
+/* What the bus of a device can do in one transaction, see i2c_dev_bus_caps(). */
+#define I2C_BUS_CAP_TRANSFER		(1 << 0)	/* I2C message lists */
+#define I2C_BUS_CAP_SMBUS_BLOCK		(1 << 1)	/* SMBus block read/write */
+#define I2C_BUS_CAP_I2C_BLOCK_READ	(1 << 2)	/* I2C (EEPROM style) block read */
+
+/*
+ * Returns the I2C_BUS_CAP_* flags of the bus `dev` sits on or 0 if it has no
+ * I2C or SMBus operations at all.
+ */
+unsigned int i2c_dev_bus_caps(struct device *dev);
+
+/*
+ * Runs the list of `count` messages as one transfer on the I2C bus of `dev`.
+ * The messages need to have `slave` set. Only works on I2C buses.
+ *
+ * Returns 0 on success, negative `enum cb_err` value on error.
+ */
+int i2c_dev_transfer(struct device *dev, const struct i2c_msg *msgs, size_t count);
+
 /**
  * Determine device presence at a given slave address.
  */
@@ -92,6 +111,8 @@ int i2c_dev_writeb_at(struct device *, uint8_t off, uint8_t val);
 int i2c_dev_read_at16(struct device *, uint8_t *buf, size_t len, uint16_t off);
 /*
  * Sends the 8-bit register offset `off` and reads `len` bytes into `buf`.
+ * On SMBus, this uses I2C block reads if the controller supports them and
+ * falls back to reading byte by byte.
  *
  * Returns the number of bytes read on success, negative `enum cb_err`
  * value on error.
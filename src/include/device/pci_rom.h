@@ -57,5 +57,13 @@ void pci_rom_ssdt(const struct device *device);
 
 u32 map_oprom_vendev(u32 vendev);
 
+/*
+ * Copy the VGA image cached from an earlier run of `rom` to the legacy VGA
+ * segment. Returns CB_ERR if there is no valid cache for this exact ROM.
+ */
+enum cb_err pci_rom_post_cache_restore(const struct device *dev, const struct rom_header *rom);
+/* Schedule the VGA image `rom` left behind after it was run to be cached. */
+void pci_rom_post_cache_save(const struct device *dev, const struct rom_header *rom);
+
 int verified_boot_should_run_oprom(struct rom_header *rom_header);
 #endif
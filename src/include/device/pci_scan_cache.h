@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef DEVICE_PCI_SCAN_CACHE_H
+#define DEVICE_PCI_SCAN_CACHE_H
+
+#include <device/device.h>
+#include <types.h>
+
+/*
+ * The PCI scan cache remembers which functions were present on each bus
+ * during the last full enumeration. On boots where the hardware can't have
+ * changed (see pci_scan_cache_allowed()), pci_scan_bus() then only probes
+ * those functions instead of every devfn of the bus.
+ */
+
+#define PCI_SCAN_CACHE_MAP_WORDS	(256 / 32)
+
+/*
+ * Returns true if the cache may be used on this boot. The default allows it
+ * on S3 resume only. Platforms that can detect warm resets may override it.
+ */
+bool pci_scan_cache_allowed(void);
+
+#if CONFIG(PCI_SCAN_CACHE)
+/* Fill |map| with the functions found on |bus| last time. Returns false if unknown. */
+bool pci_scan_cache_lookup(const struct bus *bus, uint32_t map[PCI_SCAN_CACHE_MAP_WORDS]);
+
+/* Record the functions found on |bus| during this boot. */
+void pci_scan_cache_record(const struct bus *bus, const uint32_t map[PCI_SCAN_CACHE_MAP_WORDS]);
+#else
+static inline bool pci_scan_cache_lookup(const struct bus *bus,
+					 uint32_t map[PCI_SCAN_CACHE_MAP_WORDS])
+{
+	return false;
+}
+
+static inline void pci_scan_cache_record(const struct bus *bus,
+					 const uint32_t map[PCI_SCAN_CACHE_MAP_WORDS]) {}
+#endif
+
+#endif /* DEVICE_PCI_SCAN_CACHE_H */
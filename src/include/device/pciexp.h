@@ -26,6 +26,14 @@ void pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
 
 void pciexp_scan_bridge(struct device *dev);
 
+/*
+ * From pciexp_defer_tuning() on, pciexp_scan_bus() only starts the link retraining that
+ * tuning the devices on a bus may need and leaves the rest to pciexp_finish_tuning(), so
+ * that the links of all buses scanned in between train at the same time.
+ */
+void pciexp_defer_tuning(void);
+void pciexp_finish_tuning(void);
+
 extern struct device_operations default_pciexp_ops_bus;
 
 void pciexp_hotplug_scan_bridge(struct device *dev);
@@ -3,6 +3,7 @@
 #ifndef __DEVICE_PNP_OPS_H__
 #define __DEVICE_PNP_OPS_H__
 
+#include <stddef.h>
 #include <stdint.h>
 #include <device/pnp.h>
 
@@ -71,6 +72,36 @@ void pnp_set_drq(pnp_devfn_t dev, unsigned int index, unsigned int drq)
 	pnp_write_config(dev, index, drq & 0xff);
 }
 
+/*
+ * Apply a list of register writes in one config mode session, entered and left with
+ * the chip specific enter() and exit(). The LDN is only selected when it changes from
+ * one entry to the next, so each write costs one index/data pair instead of a full
+ * enter, select, write and exit sequence. All entries have to use the same port.
+ */
+static inline
+void pnp_write_config_batch(const struct pnp_config_write *writes, size_t count,
+			    void (*enter)(pnp_devfn_t), void (*exit)(pnp_devfn_t))
+{
+	unsigned int ldn = ~0;
+	size_t i;
+
+	if (!count)
+		return;
+
+	enter(writes[0].dev);
+	for (i = 0; i < count; i++) {
+		if ((writes[i].dev & 0xff) != ldn) {
+			pnp_set_logical_device(writes[i].dev);
+			ldn = writes[i].dev & 0xff;
+		}
+		pnp_write_config(writes[i].dev, writes[i].reg, writes[i].value);
+		/* Writing the LDN register directly switches to another device. */
+		if (writes[i].reg == 0x07)
+			ldn = writes[i].value;
+	}
+	exit(writes[count - 1].dev);
+}
+
 #endif
 
 #endif
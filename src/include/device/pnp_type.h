@@ -9,6 +9,13 @@ typedef u32 pnp_devfn_t;
 
 #define PNP_DEV(PORT, FUNC) (((PORT) << 8) | (FUNC))
 
+/* One register write of a batch, see pnp_write_config_batch(). */
+struct pnp_config_write {
+	pnp_devfn_t dev;
+	uint8_t reg;
+	uint8_t value;
+};
+
 #if defined(__SIMPLE_DEVICE__)
 #define ENV_PNP_SIMPLE_DEVICE 1
 #else
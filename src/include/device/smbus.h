@@ -16,6 +16,8 @@ struct smbus_bus_operations {
 	int (*block_read)(struct device *dev, u8 cmd, u8 bytes, u8 *buffer);
 	int (*block_write)(struct device *dev, u8 cmd, u8 bytes,
 			   const u8 *buffer);
+	/* Read `bytes` bytes starting at `offset` without an SMBus byte count. */
+	int (*i2c_block_read)(struct device *dev, u8 offset, u8 bytes, u8 *buffer);
 };
 
 static inline const struct smbus_bus_operations *ops_smbus_bus(struct bus *bus)
@@ -10,6 +10,7 @@
 
 #define XHCI_ECP_CAP_ID_LEGACY 1
 #define XHCI_ECP_CAP_ID_SUPP 2
+#define XHCI_ECP_CAP_ID_DBC 10
 
 /* Status flags */
 /* Wake on disconnect enable */
@@ -3,6 +3,7 @@
 #ifndef EDID_H
 #define EDID_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <framebuffer_info.h>
 #include "commonlib/coreboot_tables.h"
@@ -98,4 +99,12 @@ void edid_set_framebuffer_bits_per_pixel(struct edid *edid, int fb_bpp,
 					 int row_byte_alignment);
 int set_display_mode(struct edid *edid, enum edid_modes mode);
 
+/* Defined in src/lib/edid_cache.c */
+/* Returns true if the cached EDID decode belongs to this 128-byte base block. */
+bool edid_cache_matches(const unsigned char *base_block);
+/* Fills out from the cache if it belongs to the base block of edid. */
+bool edid_cache_lookup(const unsigned char *edid, int size, struct edid *out);
+/* Queues a conforming decode of edid to be written to the cache. */
+void edid_cache_store(const unsigned char *edid, int size, const struct edid *decoded);
+
 #endif /* EDID_H */
@@ -63,7 +63,9 @@ void fit_update_memory(struct device_tree *tree);
  * @param config The extracted FIT config
  * @param kernel out-argument where to place the kernel
  * @param fdt out-argument where to place the devicetree
- * @param initrd out-argument where to place the initrd (optional)
+ * @param initrd out-argument where to place the initrd (optional). If its offset
+ *               is set on entry, the initrd already is in memory reserved for the
+ *               payload and may be left there.
  * @return True if all config nodes could be placed, the corresponding
  *         regions have been updated and the entry point has been set.
  *         False on error.
@@ -83,4 +85,14 @@ struct fit_config_node *fit_load(void *fit);
 void fit_add_ramdisk(struct device_tree *tree, void *ramdisk_addr,
 		     size_t ramdisk_size);
 
+/*
+ * Same as fit_update_chosen(), fit_update_memory() and fit_add_ramdisk(), but edit a
+ * flattened tree in place, see fdt_is_editable(). Return 0 on success and -1 if the
+ * buffer is too small, in which case the tree may have been partially updated.
+ */
+int fit_update_chosen_flat(void *fdt, size_t buf_size, const char *cmd_line);
+int fit_update_memory_flat(void *fdt, size_t buf_size);
+int fit_add_ramdisk_flat(void *fdt, size_t buf_size, void *ramdisk_addr,
+			 size_t ramdisk_size);
+
 #endif /* __LIB_FIT_H__ */
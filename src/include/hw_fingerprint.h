@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __HW_FINGERPRINT_H__
+#define __HW_FINGERPRINT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 64-bit fingerprint of the hardware inventory, for caches whose contents stay valid as
+ * long as the hardware doesn't change. Store it with the cached data and only use the
+ * data while it still matches.
+ *
+ * It covers the CPUID signature, fw_config, the IDs of the devices on PCI bus 0 and
+ * everything passed to hw_fingerprint_add() before it is finalized. That happens when
+ * CBMEM is created in romstage, and the value is kept in CBMEM so that later stages use
+ * the same one. It does not cover the coreboot build; caches that depend on the build
+ * have to check that themselves.
+ */
+
+#if CONFIG(HW_FINGERPRINT)
+/* Add data identifying the hardware, e.g. the SPD of the DIMMs. Only before finalizing. */
+void hw_fingerprint_add(const void *data, size_t size);
+uint64_t hw_fingerprint(void);
+#else
+static inline void hw_fingerprint_add(const void *data, size_t size) {}
+static inline uint64_t hw_fingerprint(void) { return 0; }
+#endif
+
+/* Mainboard hook to add signals only the board knows about, e.g. SKU straps. */
+void mainboard_hw_fingerprint(void);
+
+#endif /* __HW_FINGERPRINT_H__ */
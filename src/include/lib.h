@@ -10,6 +10,53 @@
 /* Defined in src/lib/lzma.c. Returns decompressed size or 0 on error. */
 size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn);
 
+/* Scratchpad size the LZMA decoder needs for the probability tables of a stream whose lc
+   and lp properties add up to |lclp|. cbfstool uses lc=1 and lp=0. */
+#define LZMA_SCRATCHPAD_SIZE_FOR(lclp) ((1846 + (768 << (lclp))) * 2)
+
+/* Scratchpad size the LZMA decoder needs for the probability tables. */
+#define LZMA_SCRATCHPAD_SIZE LZMA_SCRATCHPAD_SIZE_FOR(3)
+
+/* Same as ulzman() but uses the caller's scratchpad instead of a static one, so multiple
+   decompressions can run concurrently (e.g. on different CPUs). */
+size_t ulzman_scratch(const void *src, size_t srcn, void *dst, size_t dstn, void *scratchpad,
+		      size_t scratchpad_size);
+
+/* Same as ulzman() for input that only becomes valid piece by piece. Works like
+   ulz4fn_wait(): before reading past what it has seen, the decoder calls wait(arg, needed),
+   which returns how many bytes from the start of src are valid. */
+size_t ulzman_wait(const void *src, size_t srcn, void *dst, size_t dstn,
+		   size_t (*wait)(void *arg, size_t needed), void *arg);
+
+/*
+ * LZMA decoder with a fixed memory footprint for stages that can't map the whole input or
+ * hold the whole output:
+ *
+ *   read       - returns the next piece of compressed input in *buf and its size, 0 at the
+ *                end. A piece has to stay valid until the next call.
+ *   write      - optional, consumes |size| decompressed bytes at the start of the window
+ *                before it wraps around and once more at the end. Must not modify them and
+ *                returns 0 on success. Without it the output goes straight to the window,
+ *                which is then the destination buffer.
+ *   window     - ring buffer for the output. Matches can only reach back this far, so a
+ *                window smaller than the output only works with streams compressed with a
+ *                dictionary that fits.
+ *   scratchpad - probability tables, see LZMA_SCRATCHPAD_SIZE_FOR().
+ *
+ * Returns the decompressed size or 0 on error.
+ */
+struct ulzma_stream {
+	size_t (*read)(void *arg, const void **buf);
+	int (*write)(void *arg, const void *buf, size_t size);
+	void *arg;
+	void *window;
+	size_t window_size;
+	void *scratchpad;
+	size_t scratchpad_size;
+};
+
+size_t ulzman_stream(const struct ulzma_stream *stream);
+
 /* Defined in src/lib/ramtest.c */
 /* Assumption is 32-bit addressable UC memory. */
 void ram_check(uintptr_t start);
@@ -23,6 +70,16 @@ int primitive_memtest(uintptr_t base, uintptr_t size);
 /* Defined in src/lib/stack.c */
 int checkstack(void *top_of_stack, int core);
 
+/* Defined in src/lib/mem_usage.c */
+/* Fill a stack with the pattern that stack_usage() looks for. */
+void stack_poison(void *base, size_t size);
+/* Number of bytes at the top of a poisoned stack that were written to. */
+size_t stack_usage(const void *base, size_t size);
+/* Poison the unused part of the stack of the current stage. */
+void mem_usage_stack_init(void);
+/* Record the memory high-water marks of the current stage in CBMEM. */
+void mem_usage_record(void);
+
 /*
  * Defined in src/lib/hexdump.c
  * Use the Linux command "xxd" for matching output.  xxd is found in package
@@ -13,6 +13,9 @@ struct memranges {
 	/* coreboot doesn't have a free() function. Therefore, keep a cache of
 	 * free'd entries.  */
 	struct range_entry *free_list;
+	/* Most recently inserted entry. Updates starting above it begin their
+	 * walk there, which makes building a map in address order linear. */
+	struct range_entry *hint;
 	/* Alignment(log 2) for base and end addresses of the range. */
 	unsigned char align;
 };
@@ -152,6 +152,16 @@ uintptr_t nhlt_serialize_oem_overrides(struct nhlt *nhlt, uintptr_t acpi_addr,
 		const char *oem_id, const char *oem_table_id,
 		uint32_t oem_revision);
 
+/*
+ * Copy a complete NHLT table that was assembled ahead of time from the CBFS file
+ * 'name' to acpi_addr, e.g. one file per fw_config audio variant instead of one
+ * blob per format. Only the ACPI header is rewritten, with the given OEM fields,
+ * and the checksum. Returns the address of the next ACPI table, or acpi_addr if
+ * the file is missing or not an NHLT table.
+ */
+uintptr_t nhlt_serialize_from_cbfs(const char *name, uintptr_t acpi_addr,
+	const char *oem_id, const char *oem_table_id, uint32_t oem_revision);
+
 /*
  * While very similar to nhlt_serialize() the SoC specific function allows
  * the chipset to perform any needed accounting work such as updating ACPI
@@ -168,6 +178,10 @@ uintptr_t nhlt_soc_serialize_oem_overrides(struct nhlt *nhlt,
 	uintptr_t acpi_addr, const char *oem_id, const char *oem_table_id,
 	uint32_t oem_revision);
 
+/* SoC specific version of nhlt_serialize_from_cbfs(). */
+uintptr_t nhlt_soc_serialize_from_cbfs(const char *name, uintptr_t acpi_addr,
+	const char *oem_id, const char *oem_table_id, uint32_t oem_revision);
+
 /* Link and device types. */
 enum {
 	NHLT_LINK_HDA,
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef NV_WRITE_QUEUE_H
+#define NV_WRITE_QUEUE_H
+
+#include <types.h>
+
+/*
+ * Deferred writes to the boot media. With DEFER_NV_WRITES, ramstage users
+ * queue a commit function instead of writing right away, and all of them
+ * are run in queue order once BS_OS_RESUME_CHECK is done. That is after
+ * the late MRC cache update and before SPI lockdown, on both the normal
+ * and the S3 resume path. With COOP_MULTITASKING the commits run on their
+ * own thread, overlapped with the writing of tables.
+ *
+ * A commit function writes whatever its user has pending at the time it
+ * runs, so queuing an already queued write again is a no-op. A write that
+ * is requested while its commit is running, e.g. an event log entry for
+ * the MRC cache update, is queued behind the ones still waiting. Once the
+ * queue has been flushed, writes are no longer deferred.
+ *
+ * Example:
+ *
+ *	static void foo_commit(void *arg) { ... }
+ *
+ *	static struct nv_write foo_write = {
+ *		.name = "foo",
+ *		.commit = foo_commit,
+ *	};
+ *
+ *	if (!nv_write_defer(&foo_write))
+ *		foo_commit(NULL);
+ */
+
+struct nv_write {
+	const char *name;
+	void (*commit)(void *arg);
+	void *arg;
+
+	/* Private to the queue. */
+	struct nv_write *next;
+	bool queued;
+};
+
+#if ENV_RAMSTAGE && CONFIG(DEFER_NV_WRITES)
+/* Returns true if the write was queued, false if the caller has to write now. */
+bool nv_write_defer(struct nv_write *w);
+#else
+static inline bool nv_write_defer(struct nv_write *w)
+{
+	return false;
+}
+#endif
+
+#endif /* NV_WRITE_QUEUE_H */
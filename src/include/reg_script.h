@@ -87,6 +87,8 @@ struct reg_script_context {
 	struct device *dev;
 #endif
 	struct resource *res;
+	/* Platform specific bus of the last step that used one. */
+	const struct reg_script_bus_entry *bus;
 	const struct reg_script *step;
 	uint8_t display_state;    /* Only modified by reg_script_run_step */
 	uint8_t display_features; /* Step routine modifies to control display */
@@ -31,6 +31,15 @@ int region_file_init(struct region_file *f, const struct region_device *p);
  */
 int region_file_data(const struct region_file *f, struct region_device *rdev);
 
+/*
+ * Same as region_file_data() for older updates that are still present in the
+ * region: |age| 0 is the latest update, 1 the one before it and so on. Updates
+ * are only kept until the region fills up and has to be emptied. Returns < 0
+ * if there is no such update, 0 on success.
+ */
+int region_file_data_history(const struct region_file *f, size_t age,
+			     struct region_device *rdev);
+
 /*
  * Create region file entry struct to insert multiple data buffers
  * into the same region_file.
@@ -48,6 +57,12 @@ int region_file_update_data_arr(struct region_file *f,
 				  size_t num_entries);
 int region_file_update_data(struct region_file *f, const void *buf, size_t size);
 
+/*
+ * Returns 1 if an update of |size| bytes can be appended without emptying the
+ * region first, i.e. without losing the older updates. Returns 0 otherwise.
+ */
+int region_file_update_fits(const struct region_file *f, size_t size);
+
 /* Declared here for easy object allocation. */
 struct region_file {
 	/* Region device covering file */
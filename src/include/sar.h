@@ -19,6 +19,10 @@
 #define SAR_FILE_REVISION	1
 #define SAR_STR_PREFIX		"$SAR"
 #define SAR_STR_PREFIX_SIZE	4
+#define SAR_AML_MARKER		"$SAA"
+#define SAR_AML_VERSION		1
+#define SAR_AML_HAS_DSM		(1 << 0)
+#define SAR_AML_HAS_BSAR	(1 << 1)
 
 struct geo_profile {
 	uint8_t revision;
@@ -85,6 +89,21 @@ struct sar_header {
 	uint16_t offsets[];
 } __packed;
 
+/*
+ * SAR file with the ACPI objects pre-encoded by util/wifi_sar/sar-aml.py. The
+ * DSM and BSAR profiles are kept as they are, since they aren't plain names.
+ */
+struct sar_aml_header {
+	char marker[SAR_STR_PREFIX_SIZE];
+	uint8_t version;
+	uint8_t flags;
+	uint16_t aml_size;
+	struct dsm_profile dsm;
+	struct bsar_profile bsar;
+	/* Followed by aml_size bytes of WRDS, EWRD, WGDS, PPAG, WTAS and WBEM */
+	uint8_t aml[];
+} __packed;
+
 /* Wifi SAR limit table structure */
 union wifi_sar_limits {
 	struct {
@@ -107,6 +126,14 @@ union wifi_sar_limits {
  */
 int get_wifi_sar_limits(union wifi_sar_limits *sar_limits);
 
+/*
+ * Map the pre-encoded SAR file that belongs to get_wifi_sar_cbfs_filename(), which has
+ * ".aml" instead of ".hex" at the end of its name.
+ *
+ * Returns: The validated file to be unmapped with cbfs_unmap(), or NULL if there is none
+ */
+const struct sar_aml_header *get_wifi_sar_aml(void);
+
 #define WIFI_SAR_CBFS_DEFAULT_FILENAME	"wifi_sar_defaults.hex"
 
 const char *get_wifi_sar_cbfs_filename(void);
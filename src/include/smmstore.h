@@ -14,12 +14,14 @@
 #define SMMSTORE_CMD_CLEAR 1
 #define SMMSTORE_CMD_READ 2
 #define SMMSTORE_CMD_APPEND 3
+#define SMMSTORE_CMD_LOOKUP 8
 
 /* Version 2 */
 #define SMMSTORE_CMD_INIT_DEPRECATED 4
 #define SMMSTORE_CMD_RAW_READ 5
 #define SMMSTORE_CMD_RAW_WRITE 6
 #define SMMSTORE_CMD_RAW_CLEAR 7
+#define SMMSTORE_CMD_RAW_BATCH 9
 
 /* Version 1 */
 struct smmstore_params_read {
@@ -34,6 +36,18 @@ struct smmstore_params_append {
 	size_t valsize;
 };
 
+/*
+ * Reads the latest value of @key into @val. On input @valsize is the size of
+ * the buffer, on output the size of the value, also if the buffer was too
+ * small for it.
+ */
+struct smmstore_params_lookup {
+	void *key;
+	size_t keysize;
+	void *val;
+	size_t valsize;
+};
+
 /* Version 2 */
 /*
  * The Version 2 protocol separates the SMMSTORE into 64KiB blocks, each
@@ -98,6 +112,32 @@ struct smmstore_params_raw_clear {
 	uint32_t block_id;
 } __packed;
 
+/*
+ * Runs a list of @num_ops raw reads, writes and clears in one SMI. The list
+ * of smmstore_raw_batch_op is placed in the communication buffer at
+ * @list_offset. The operations run in order and processing stops at the
+ * first failure. @completed returns the number of operations that succeeded.
+ */
+struct smmstore_params_raw_batch {
+	uint32_t num_ops;
+	uint32_t list_offset;
+	uint32_t completed;
+} __packed;
+
+/*
+ * One operation of a batch. @command is SMMSTORE_CMD_RAW_READ, _WRITE or
+ * _CLEAR. Unlike the single commands, the data of each operation sits at its
+ * own @bufoffset in the communication buffer, independent of the @offset
+ * within the block. @bufsize, @offset and @bufoffset are ignored for clears.
+ */
+struct smmstore_raw_batch_op {
+	uint32_t command;
+	uint32_t block_id;
+	uint32_t offset;
+	uint32_t bufsize;
+	uint32_t bufoffset;
+} __packed;
+
 
 /* SMM handler */
 uint32_t smmstore_exec(uint8_t command, void *param);
@@ -105,6 +145,7 @@ uint32_t smmstore_exec(uint8_t command, void *param);
 /* Implementation of Version 1 */
 int smmstore_read_region(void *buf, ssize_t *bufsize);
 int smmstore_append_data(void *key, uint32_t key_sz, void *value, uint32_t value_sz);
+int smmstore_lookup_data(void *key, uint32_t key_sz, void *value, uint32_t *value_sz);
 int smmstore_clear_region(void);
 
 /* Implementation of Version 2 */
@@ -112,6 +153,7 @@ int smmstore_init(void *buf, size_t len);
 int smmstore_rawread_region(uint32_t block_id, uint32_t offset, uint32_t bufsize);
 int smmstore_rawwrite_region(uint32_t block_id, uint32_t offset, uint32_t bufsize);
 int smmstore_rawclear_region(uint32_t block_id);
+int smmstore_rawbatch_region(uint32_t list_offset, uint32_t num_ops, uint32_t *completed);
 #if ENV_RAMSTAGE
 int smmstore_get_info(struct smmstore_params_info *info);
 #endif
@@ -56,6 +56,14 @@ void get_spd_smbus(struct spd_block *blk);
  */
 enum cb_err get_spd_sn(u8 addr, u32 *sn);
 
+/*
+ * get_spd_sns returns the serial numbers of all DIMMs in blk->addr_map in sn, which has
+ * CONFIG_DIMM_MAX entries. It's like calling get_spd_sn for each DIMM, but needs fewer SMBus
+ * transactions. sn[i]=0xffffffff if DIMM i is not present or has no address.
+ *  return CB_ERR, if the dram_type of any DIMM is not supported.
+ */
+enum cb_err get_spd_sns(const struct spd_block *blk, u32 *sn);
+
 /* expects SPD size to be 128 bytes, reads from "spd.bin" in CBFS and
    verifies the checksum. Only available if CONFIG_DIMM_SPD_SIZE == 128. */
 int read_ddr3_spd_from_cbfs(u8 *buf, int idx);
@@ -9,6 +9,7 @@
  */
 #define SPI_FLASH_PROG_TIMEOUT_MS		200
 #define SPI_FLASH_PAGE_ERASE_TIMEOUT_MS		500
+#define SPI_FLASH_BLOCK_ERASE_TIMEOUT_MS	2000
 
 #include <commonlib/region.h>
 #include <stdint.h>
@@ -134,6 +135,9 @@ enum {
  * xfer:		Perform one SPI transfer operation.
  * xfer_vector:	Vector of SPI transfer operations.
  * xfer_dual:		(optional) Perform one SPI transfer in Dual SPI mode.
+ * xfer_quad:		(optional) Perform one SPI transfer in Quad SPI mode.
+ * xfer_quad_dtr:	(optional) Perform one SPI transfer in Quad SPI mode,
+ *			clocking data on both edges (one byte per clock).
  * max_xfer_size:	Maximum transfer size supported by the controller
  *			(0 = invalid,
  *			 SPI_CTRLR_DEFAULT_MAX_XFER_SIZE = unlimited)
@@ -156,6 +160,10 @@ struct spi_ctrlr {
 			struct spi_op vectors[], size_t count);
 	int (*xfer_dual)(const struct spi_slave *slave, const void *dout,
 			 size_t bytesout, void *din, size_t bytesin);
+	int (*xfer_quad)(const struct spi_slave *slave, const void *dout,
+			 size_t bytesout, void *din, size_t bytesin);
+	int (*xfer_quad_dtr)(const struct spi_slave *slave, const void *dout,
+			     size_t bytesout, void *din, size_t bytesin);
 	uint32_t max_xfer_size;
 	uint32_t flags;
 	int (*flash_probe)(const struct spi_slave *slave,
@@ -99,7 +99,11 @@ struct spi_flash {
 		struct {
 			u8 dual_output	: 1;
 			u8 dual_io	: 1;
-			u8 _reserved	: 6;
+			u8 quad_output	: 1;
+			u8 quad_io	: 1;
+			u8 quad_io_dtr	: 1;
+			u8 erase_suspend : 1;
+			u8 _reserved	: 2;
 		};
 	} flags;
 	u16 model;
@@ -107,6 +111,9 @@ struct spi_flash {
 	u32 sector_size;
 	u32 page_size;
 	u8 erase_cmd;
+	/* If !0, aligned parts of erases use block_erase_cmd for this size. */
+	u32 block_erase_size;
+	u8 block_erase_cmd;
 	u8 status_cmd;
 	u8 pp_cmd; /* Page program command. */
 	u8 wren_cmd; /* Write Enable command. */
@@ -6,4 +6,7 @@
 #include <commonlib/bsd/stdlib.h>
 #include <stddef.h>
 
+/* Size of the heap and the highest number of bytes that were allocated from it at once. */
+void heap_usage(size_t *size, size_t *peak);
+
 #endif /* STDLIB_H */
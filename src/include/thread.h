@@ -79,6 +79,15 @@ asmlinkage void switch_to_thread(uintptr_t new_stack, uintptr_t *saved_stack);
  * saved_stack field in the struct thread needs to be updated accordingly. */
 void arch_prepare_thread(struct thread *t,
 			 asmlinkage void (*thread_entry)(void *), void *arg);
+/* Wait until the monotonic time reaches deadline, called by the idle thread
+ * when no thread is runnable before the next timer callback is due. The
+ * default spins, platforms that can stop the CPU until then without relying
+ * on interrupts may provide their own. */
+struct mono_time;
+void arch_thread_idle_until(const struct mono_time *deadline);
+
+/* Stack usage of the thread stack that was used most, needs MEM_USAGE_STATS. */
+size_t thread_stack_peak_usage(void);
 #else
 static inline int thread_yield(void)
 {
@@ -94,6 +103,11 @@ static inline void thread_coop_disable(void) {}
 static inline void thread_mutex_lock(struct thread_mutex *mutex) {}
 
 static inline void thread_mutex_unlock(struct thread_mutex *mutex) {}
+
+static inline size_t thread_stack_peak_usage(void)
+{
+	return 0;
+}
 #endif
 
 #endif /* THREAD_H_ */
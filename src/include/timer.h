@@ -29,6 +29,7 @@ struct timeout_callback {
 	void (*callback)(struct timeout_callback *tocb);
 	/* Not for public use. The timer library uses the fields below. */
 	struct mono_time expiration;
+	int index;
 };
 
 /* Obtain the current monotonic time. The assumption is that the time counts
@@ -49,6 +50,14 @@ int timers_run(void);
  * 0 returned on success, < 0 on error. */
 int timer_sched_callback(struct timeout_callback *tocb, uint64_t us);
 
+/* Remove a scheduled callback from the queue before it runs.
+ * 0 returned on success, < 0 if it wasn't scheduled. */
+int timer_cancel_callback(struct timeout_callback *tocb);
+
+/* Get the expiration of the callback that runs next.
+ * 0 returned on success, < 0 if there are no callbacks scheduled. */
+int timer_next_expiration(struct mono_time *mt);
+
 /* Set an absolute time to a number of microseconds. */
 static inline void mono_time_set_usecs(struct mono_time *mt, uint64_t us)
 {
@@ -146,12 +155,20 @@ static inline void stopwatch_tick(struct stopwatch *sw)
 		sw->current.microseconds = 0;
 }
 
+/*
+ * Yield the current thread if it has used up its time slice, see COOP_TIME_SLICE.
+ * Implemented in lib/thread.c.
+ */
+void thread_time_slice_check(const struct mono_time *now);
+
 /*
  * Tick and check the stopwatch for expiration. Returns non-zero on expiration.
  */
 static inline int stopwatch_expired(struct stopwatch *sw)
 {
 	stopwatch_tick(sw);
+	if (CONFIG(COOP_TIME_SLICE) && ENV_SUPPORTS_COOP)
+		thread_time_slice_check(&sw->current);
 	return !mono_time_before(&sw->current, &sw->expires);
 }
 
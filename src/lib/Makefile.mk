@@ -9,9 +9,13 @@ endif
 
 # Ensure that asan_shadow_offset_callback patch is applied to GCC before ASan is used.
 CFLAGS_asan += -fsanitize=kernel-address --param asan-use-shadow-offset-callback=1 \
-		--param asan-stack=1 -fsanitize-address-use-after-scope \
-		--param asan-instrumentation-with-call-threshold=0 \
+		--param asan-stack=1 --param asan-instrumentation-with-call-threshold=0
+ifeq ($(CONFIG_ASAN_USE_AFTER_SCOPE),y)
+CFLAGS_asan += -fsanitize-address-use-after-scope \
 		--param use-after-scope-direct-emission-threshold=0
+else
+CFLAGS_asan += -fno-sanitize-address-use-after-scope
+endif
 
 ifeq ($(CONFIG_ASAN_IN_ROMSTAGE),y)
 romstage-y += asan.c
@@ -46,6 +50,9 @@ bootblock-y += bootblock.c
 bootblock-y += prog_loaders.c
 bootblock-y += prog_ops.c
 bootblock-y += cbfs.c
+bootblock-$(CONFIG_CBFS_ACCESS_TRACE) += cbfs_trace.c
+bootblock-$(CONFIG_MEM_USAGE_STATS) += mem_usage.c
+bootblock-$(CONFIG_HW_FINGERPRINT) += hw_fingerprint.c
 bootblock-$(CONFIG_GENERIC_GPIO_LIB) += gpio.c
 bootblock-y += libgcc.c
 ifneq ($(CONFIG_VBOOT_STARTS_BEFORE_BOOTBLOCK),y)
@@ -63,9 +70,11 @@ bootblock-y += memchr.c
 bootblock-y += memcmp.c
 bootblock-y += boot_device.c
 bootblock-y += fmap.c
+bootblock-$(CONFIG_COMPRESS_PRERAM_STAGES_LZMA) += lzma.c lzmadecode.c
 
 verstage-y += prog_loaders.c
 verstage-y += prog_ops.c
+verstage-$(CONFIG_MEM_USAGE_STATS) += mem_usage.c
 verstage-y += delay.c
 verstage-y += cbfs.c
 verstage-y += halt.c
@@ -77,6 +86,7 @@ verstage-y += string.c
 verstage-$(CONFIG_COLLECT_TIMESTAMPS) += timestamp.c
 verstage-y += boot_device.c
 verstage-$(CONFIG_CONSOLE_CBMEM) += cbmem_console.c
+verstage-$(CONFIG_COMPRESS_PRERAM_STAGES_LZMA) += lzma.c lzmadecode.c
 
 verstage-$(CONFIG_GENERIC_UDELAY) += timer.c
 verstage-$(CONFIG_GENERIC_GPIO_LIB) += gpio.c
@@ -93,6 +103,10 @@ $(foreach arch,$(ARCH_SUPPORTED),\
 romstage-y += fmap.c
 romstage-y += delay.c
 romstage-y += cbfs.c
+romstage-$(CONFIG_CBFS_ACCESS_TRACE) += cbfs_trace.c
+romstage-$(CONFIG_CBFS_MAP_CACHE) += cbfs_map_cache.c
+romstage-$(CONFIG_MEM_USAGE_STATS) += mem_usage.c
+romstage-$(CONFIG_HW_FINGERPRINT) += hw_fingerprint.c
 ifneq ($(CONFIG_COMPRESS_RAMSTAGE_LZMA)$(CONFIG_FSP_COMPRESS_FSP_M_LZMA),)
 romstage-y += lzma.c lzmadecode.c
 endif
@@ -129,6 +143,8 @@ ramstage-$(CONFIG_PROBE_RAM) += ramdetect.c
 ramstage-y += prog_loaders.c
 ramstage-y += prog_ops.c
 ramstage-y += hardwaremain.c
+ramstage-y += boot_task.c
+ramstage-$(CONFIG_DEFER_NV_WRITES) += nv_write_queue.c
 ramstage-y += selfboot.c
 ramstage-y += coreboot_table.c
 ramstage-$(CONFIG_GENERATE_SMBIOS_TABLES) += smbios.c
@@ -142,6 +158,10 @@ ramstage-y += dimm_info_util.c
 ramstage-y += delay.c
 ramstage-y += fallback_boot.c
 ramstage-y += cbfs.c
+ramstage-$(CONFIG_CBFS_ACCESS_TRACE) += cbfs_trace.c
+ramstage-$(CONFIG_CBFS_MAP_CACHE) += cbfs_map_cache.c
+ramstage-$(CONFIG_MEM_USAGE_STATS) += mem_usage.c
+ramstage-$(CONFIG_HW_FINGERPRINT) += hw_fingerprint.c
 ramstage-y += lzma.c lzmadecode.c
 ramstage-y += stack.c
 ramstage-y += hexstrtobin.c
@@ -154,6 +174,7 @@ ramstage-$(CONFIG_COLLECT_TIMESTAMPS) += timestamp.c
 ramstage-$(CONFIG_COVERAGE) += libgcov.c
 ramstage-y += dp_aux.c
 ramstage-y += edid.c
+ramstage-$(CONFIG_EDID_CACHE) += edid_cache.c
 ramstage-y += edid_fill_fb.c
 ramstage-y += memrange.c
 ramstage-$(CONFIG_GENERIC_GPIO_LIB) += gpio.c
@@ -273,10 +294,15 @@ smm-y += crc_byte.c
 
 romstage-y += xxhash.c
 ramstage-y += xxhash.c
+smm-$(CONFIG_SMMSTORE) += xxhash.c
 
 postcar-y += bootmode.c
 postcar-y += boot_device.c
 postcar-y += cbfs.c
+postcar-$(CONFIG_CBFS_ACCESS_TRACE) += cbfs_trace.c
+postcar-$(CONFIG_CBFS_MAP_CACHE) += cbfs_map_cache.c
+postcar-$(CONFIG_MEM_USAGE_STATS) += mem_usage.c
+postcar-$(CONFIG_HW_FINGERPRINT) += hw_fingerprint.c
 postcar-y += delay.c
 postcar-y += fmap.c
 postcar-y += gcc.c
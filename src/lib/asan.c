@@ -14,26 +14,30 @@
 #include <arch/symbols.h>
 #include <asan.h>
 
-static inline void *asan_mem_to_shadow(const void *addr)
-{
 #if ENV_SEPARATE_ROMSTAGE
-	return (void *)((uintptr_t)&_asan_shadow + (((uintptr_t)addr -
-		(uintptr_t)&_car_region_start) >> ASAN_SHADOW_SCALE_SHIFT));
+#define ASAN_REGION_START	((uintptr_t)&_car_region_start)
+#define ASAN_REGION_END		((uintptr_t)&_ebss)
 #elif ENV_RAMSTAGE
-	return (void *)((uintptr_t)&_asan_shadow + (((uintptr_t)addr -
-		(uintptr_t)&_data) >> ASAN_SHADOW_SCALE_SHIFT));
+#define ASAN_REGION_START	((uintptr_t)&_data)
+#define ASAN_REGION_END		((uintptr_t)&_eheap)
 #endif
+
+static inline void *asan_mem_to_shadow(const void *addr)
+{
+	return (void *)((uintptr_t)&_asan_shadow + (((uintptr_t)addr -
+		ASAN_REGION_START) >> ASAN_SHADOW_SCALE_SHIFT));
 }
 
 static inline const void *asan_shadow_to_mem(const void *shadow_addr)
 {
-#if ENV_SEPARATE_ROMSTAGE
-	return (void *)((uintptr_t)&_car_region_start + (((uintptr_t)shadow_addr -
+	return (void *)(ASAN_REGION_START + (((uintptr_t)shadow_addr -
 		(uintptr_t)&_asan_shadow) << ASAN_SHADOW_SCALE_SHIFT));
-#elif ENV_RAMSTAGE
-	return (void *)((uintptr_t)&_data + (((uintptr_t)shadow_addr -
-		(uintptr_t)&_asan_shadow) << ASAN_SHADOW_SCALE_SHIFT));
-#endif
+}
+
+/* Accesses outside of the region that has a shadow are not checked. */
+static __always_inline bool addr_has_shadow(unsigned long addr)
+{
+	return addr - ASAN_REGION_START < ASAN_REGION_END - ASAN_REGION_START;
 }
 
 static void asan_poison_shadow(const void *address, size_t size, u8 value)
@@ -214,6 +218,9 @@ static const char *get_shadow_bug_type(const void *addr, size_t size)
 	case ASAN_USE_AFTER_SCOPE:
 		bug_type = "use-after-scope";
 		break;
+	case ASAN_HEAP_FREE:
+		bug_type = "heap-out-of-bounds";
+		break;
 	default:
 		bug_type = "unknown-crash";
 	}
@@ -237,23 +244,12 @@ static __always_inline void check_memory_region_inline(unsigned long addr,
 						size_t size, bool write,
 						unsigned long ret_ip)
 {
-#if ENV_SEPARATE_ROMSTAGE
-	if (((uintptr_t)addr < (uintptr_t)&_car_region_start) ||
-		((uintptr_t)addr > (uintptr_t)&_ebss))
-		return;
-#elif ENV_RAMSTAGE
-	if (((uintptr_t)addr < (uintptr_t)&_data) ||
-		((uintptr_t)addr > (uintptr_t)&_eheap))
-		return;
-#endif
-	if (unlikely(size == 0))
+	/* The start of the region is the start of what the shadow covers. */
+	if (!addr_has_shadow(addr))
 		return;
 
-	if (unlikely((void *)addr <
-		asan_shadow_to_mem((void *) &_asan_shadow))) {
-		asan_report(addr, size, write, ret_ip);
+	if (unlikely(size == 0))
 		return;
-	}
 
 	if (likely(!memory_is_poisoned(addr, size)))
 		return;
@@ -261,21 +257,38 @@ static __always_inline void check_memory_region_inline(unsigned long addr,
 	asan_report(addr, size, write, ret_ip);
 }
 
-void check_memory_region(unsigned long addr, size_t size, bool write,
-				unsigned long ret_ip)
+void __attribute__((noinline)) check_memory_region(unsigned long addr, size_t size,
+						   bool write, unsigned long ret_ip)
 {
 	check_memory_region_inline(addr, size, write, ret_ip);
 }
 
+/*
+ * Fast path of the fixed size checks. Nearly all accesses are naturally aligned and in
+ * a fully accessible granule, or two for 16 bytes, so a single shadow load decides.
+ * Everything else goes to the out-of-line check, which keeps the entry points small.
+ */
+static __always_inline void check_access(unsigned long addr, size_t size, bool write,
+					 unsigned long ret_ip)
+{
+	if (!addr_has_shadow(addr))
+		return;
+
+	if (size == 16) {
+		if (likely(IS_ALIGNED(addr, ASAN_SHADOW_SCALE_SIZE) &&
+			   !*(u16 *)asan_mem_to_shadow((void *)addr)))
+			return;
+	} else if (likely(IS_ALIGNED(addr, size) &&
+			  !*(u8 *)asan_mem_to_shadow((void *)addr))) {
+		return;
+	}
+
+	check_memory_region(addr, size, write, ret_ip);
+}
+
 uintptr_t __asan_shadow_offset(uintptr_t addr)
 {
-#if ENV_SEPARATE_ROMSTAGE
-	return (uintptr_t)&_asan_shadow - (((uintptr_t)&_car_region_start) >>
-		ASAN_SHADOW_SCALE_SHIFT);
-#elif ENV_RAMSTAGE
-	return (uintptr_t)&_asan_shadow - (((uintptr_t)&_data) >>
-		ASAN_SHADOW_SCALE_SHIFT);
-#endif
+	return (uintptr_t)&_asan_shadow - (ASAN_REGION_START >> ASAN_SHADOW_SCALE_SHIFT);
 }
 
 static void register_global(struct asan_global *global)
@@ -321,14 +334,34 @@ static void asan_ctors(void)
 }
 #endif
 
+#if ENV_RAMSTAGE
+void asan_heap_alloc(const void *addr, size_t size)
+{
+	const uintptr_t start = ALIGN_DOWN((uintptr_t)addr, ASAN_SHADOW_SCALE_SIZE);
+
+	asan_unpoison_shadow((void *)start, (uintptr_t)addr + size - start);
+}
+
+void asan_heap_free(const void *addr, size_t size)
+{
+	const uintptr_t start = ALIGN_UP((uintptr_t)addr, ASAN_SHADOW_SCALE_SIZE);
+	const uintptr_t end = ALIGN_UP((uintptr_t)addr + size, ASAN_SHADOW_SCALE_SIZE);
+
+	if (start < end)
+		asan_poison_shadow((void *)start, end - start, ASAN_HEAP_FREE);
+}
+#endif
+
 void asan_init(void)
 {
 #if ENV_SEPARATE_ROMSTAGE
 	size_t size = (size_t)&_ebss - (size_t)&_car_region_start;
 	asan_unpoison_shadow((void *)&_car_region_start, size);
 #elif ENV_RAMSTAGE
-	size_t size = (size_t)&_eheap - (size_t)&_data;
+	size_t size = (size_t)&_heap - (size_t)&_data;
 	asan_unpoison_shadow((void *)&_data, size);
+	/* The heap is poisoned as a whole and malloc() unpoisons what it hands out. */
+	asan_heap_free(&_heap, (size_t)&_eheap - (size_t)&_heap);
 	asan_ctors();
 #endif
 }
@@ -347,19 +380,19 @@ void __asan_unpoison_stack_memory(const void *addr, size_t size)
 #define DEFINE_ASAN_LOAD_STORE(size)	\
 	void __asan_load##size(unsigned long addr)	\
 	{	\
-		check_memory_region_inline(addr, size, false, _RET_IP_);\
+		check_access(addr, size, false, _RET_IP_);	\
 	}	\
 	void __asan_load##size##_noabort(unsigned long addr)	\
 	{	\
-		check_memory_region_inline(addr, size, false, _RET_IP_);\
+		check_access(addr, size, false, _RET_IP_);	\
 	}	\
 	void __asan_store##size(unsigned long addr)	\
 	{	\
-		check_memory_region_inline(addr, size, true, _RET_IP_);	\
+		check_access(addr, size, true, _RET_IP_);	\
 	}	\
 	void __asan_store##size##_noabort(unsigned long addr)	\
 	{	\
-		check_memory_region_inline(addr, size, true, _RET_IP_);	\
+		check_access(addr, size, true, _RET_IP_);	\
 	}
 
 DEFINE_ASAN_LOAD_STORE(1);
@@ -2,8 +2,10 @@
 
 #include <acpi/acpi.h>
 #include <bootsplash.h>
+#include <bootstate.h>
 #include <cbfs.h>
 #include <cbmem.h>
+#include <console/console.h>
 #include <stdint.h>
 #include <vendorcode/google/chromeos/chromeos.h>
 
@@ -45,3 +47,15 @@ void bmp_release_logo(void)
 		cbmem_entry_remove(logo_entry);
 	logo_entry = NULL;
 }
+
+/* The logo is handed to FSP-S during chip init, start reading it before that. */
+static void preload_logo(void *unused)
+{
+	if (!CONFIG(CBFS_PRELOAD) || acpi_is_wakeup_s3())
+		return;
+
+	printk(BIOS_DEBUG, "Preloading %s\n", bmp_logo_filename());
+	cbfs_preload(bmp_logo_filename());
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, preload_logo, NULL);
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <boot_task.h>
+#include <bootstate.h>
+#include <console/console.h>
+#include <thread.h>
+#include <timer.h>
+#include <timestamp.h>
+#include <types.h>
+
+extern struct boot_task *_boot_tasks[];
+
+#define for_each_boot_task(slot, task) \
+	for (slot = &_boot_tasks[0]; (task = *slot) != NULL; slot++)
+
+#define BOOT_TASK_DEFAULT_DEADLINE	BS_OS_RESUME_CHECK
+
+static uint32_t entered_states;
+static uint32_t completed_states;
+static struct mono_time base_time;
+static struct mono_time state_entry[BS_PAYLOAD_BOOT + 1];
+
+static bool boot_task_is_ready(const struct boot_task *task)
+{
+	struct boot_task *const *dep;
+
+	if (task->state != BOOT_TASK_PENDING || (task->needs & ~completed_states))
+		return false;
+
+	for (dep = task->after; dep && *dep; dep++)
+		if ((*dep)->state != BOOT_TASK_DONE)
+			return false;
+
+	return true;
+}
+
+static void boot_task_run(struct boot_task *task)
+{
+	timer_monotonic_get(&task->start);
+	timestamp_add_now(TS_BOOT_TASK_START);
+	task->run(task->arg);
+	timestamp_add_now(TS_BOOT_TASK_END);
+	timer_monotonic_get(&task->end);
+	task->state = BOOT_TASK_DONE;
+}
+
+static void boot_tasks_dispatch(void);
+
+static enum cb_err boot_task_thread(void *arg)
+{
+	boot_task_run(arg);
+
+	/* Tasks that were waiting for this one may be ready now. */
+	boot_tasks_dispatch();
+
+	return CB_SUCCESS;
+}
+
+static void boot_tasks_dispatch(void)
+{
+	struct boot_task **slot, *task;
+	bool progress;
+
+	do {
+		progress = false;
+
+		for_each_boot_task(slot, task) {
+			if (!boot_task_is_ready(task))
+				continue;
+
+			timer_monotonic_get(&task->ready);
+			task->state = BOOT_TASK_RUNNING;
+
+			if (CONFIG(COOP_MULTITASKING) &&
+			    thread_run_until(&task->handle, boot_task_thread, task,
+					     task->deadline, BS_ON_ENTRY) == 0)
+				continue;
+
+			boot_task_run(task);
+			progress = true;
+		}
+	} while (progress);
+}
+
+void boot_tasks_init(void)
+{
+	struct boot_task **slot, *task;
+
+	timer_monotonic_get(&base_time);
+
+	for_each_boot_task(slot, task) {
+		if (task->deadline == BS_PRE_DEVICE)
+			task->deadline = BOOT_TASK_DEFAULT_DEADLINE;
+
+		/* A task can't depend on the state it has to finish before. */
+		if (task->needs & ~(BOOT_TASK_AFTER(task->deadline) - 1)) {
+			printk(BIOS_ERR, "BT: %s needs state after its deadline %d\n",
+			       task->name, task->deadline);
+			task->deadline = BS_PAYLOAD_BOOT;
+		}
+	}
+
+	boot_tasks_dispatch();
+}
+
+static void boot_tasks_report(void)
+{
+	struct boot_task **slot, *task;
+	const struct mono_time *deadline;
+	int64_t ready, start, end, stall;
+
+	for_each_boot_task(slot, task) {
+		if (task->state != BOOT_TASK_DONE) {
+			printk(BIOS_WARNING, "BT: %s never ran\n", task->name);
+			continue;
+		}
+
+		ready = mono_time_diff_microseconds(&base_time, &task->ready);
+		start = mono_time_diff_microseconds(&base_time, &task->start);
+		end = mono_time_diff_microseconds(&base_time, &task->end);
+		deadline = &state_entry[task->deadline];
+		stall = 0;
+		if ((entered_states & BOOT_TASK_AFTER(task->deadline)) &&
+		    mono_time_after(&task->end, deadline))
+			stall = mono_time_diff_microseconds(deadline, &task->end);
+
+		printk(BIOS_DEBUG, "BT: %-24s ready %7lld start %7lld end %7lld us", task->name,
+		       ready, start, end);
+		if (stall)
+			printk(BIOS_DEBUG, ", critical: held state %d for %lld us",
+			       task->deadline, stall);
+		printk(BIOS_DEBUG, "\n");
+	}
+}
+
+void boot_tasks_state_entered(boot_state_t state)
+{
+	struct boot_task **slot, *task;
+
+	entered_states |= BOOT_TASK_AFTER(state);
+	timer_monotonic_get(&state_entry[state]);
+
+	for_each_boot_task(slot, task) {
+		/*
+		 * Running tasks already block their deadline state. A task that is
+		 * still pending here never had its inputs satisfied in time.
+		 */
+		if (task->state == BOOT_TASK_PENDING && task->deadline == state)
+			printk(BIOS_ERR, "BT: %s not ready before state %d\n",
+			       task->name, state);
+
+		/*
+		 * Nothing may be left running once ramstage hands off, e.g. tasks
+		 * with a deadline after BS_OS_RESUME on the S3 resume path.
+		 */
+		if (CONFIG(COOP_MULTITASKING) && task->state == BOOT_TASK_RUNNING &&
+		    (state == BS_OS_RESUME || state == BS_PAYLOAD_BOOT))
+			thread_join(&task->handle);
+	}
+
+	if (state == BS_OS_RESUME || state == BS_PAYLOAD_BOOT)
+		boot_tasks_report();
+}
+
+void boot_tasks_state_completed(boot_state_t state)
+{
+	completed_states |= BOOT_TASK_AFTER(state);
+	boot_tasks_dispatch();
+}
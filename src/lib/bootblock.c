@@ -5,6 +5,7 @@
 #include <bootblock_common.h>
 #include <console/console.h>
 #include <delay.h>
+#include <lib.h>
 #include <metadata_hash.h>
 #include <option.h>
 #include <post.h>
@@ -29,6 +30,9 @@ __weak void bootblock_mainboard_init(void) { /* do nothing */ }
 void bootblock_main_with_timestamp(uint64_t base_timestamp,
 	struct timestamp_entry *timestamps, size_t num_timestamps)
 {
+	if (CONFIG(MEM_USAGE_STATS))
+		mem_usage_stack_init();
+
 	/* Initialize timestamps if we have TIMESTAMP region in memlayout.ld. */
 	if (CONFIG(COLLECT_TIMESTAMPS) &&
 	    REGION_SIZE(timestamp) > 0) {
@@ -13,6 +13,12 @@ static int table_written;
 static struct memranges bootmem;
 static struct memranges bootmem_os;
 
+/* Proximity domains of memory ranges, tagged with the domain. */
+static struct memranges bootmem_domains;
+static bool domains_initialized;
+static bool bsp_domain_known;
+static uint32_t bsp_domain;
+
 static int bootmem_is_initialized(void)
 {
 	return initialized;
@@ -218,6 +224,62 @@ int bootmem_region_targets_type(uint64_t start, uint64_t size,
 	return 0;
 }
 
+void bootmem_add_proximity_domain(uint64_t start, uint64_t size, uint32_t domain)
+{
+	if (!domains_initialized) {
+		memranges_init_empty(&bootmem_domains, NULL, 0);
+		domains_initialized = true;
+	}
+
+	memranges_insert(&bootmem_domains, start, size, domain);
+}
+
+void bootmem_set_bsp_proximity_domain(uint32_t domain)
+{
+	bsp_domain = domain;
+	bsp_domain_known = true;
+}
+
+int bootmem_proximity_domain(uint64_t start, uint64_t size)
+{
+	const struct range_entry *r;
+	const uint64_t end = start + size;
+
+	if (!domains_initialized)
+		return -1;
+
+	memranges_each_entry(r, &bootmem_domains) {
+		if (start >= range_entry_base(r) && end <= range_entry_end(r))
+			return range_entry_tag(r);
+	}
+
+	return -1;
+}
+
+/*
+ * Returns the end of the highest piece of BSP local memory in [begin, end) that can hold
+ * |size| bytes, or 0 if there is none.
+ */
+static resource_t bsp_local_end(resource_t begin, resource_t end, size_t size)
+{
+	const struct range_entry *r;
+	resource_t local_end = 0;
+
+	if (!domains_initialized || !bsp_domain_known)
+		return 0;
+
+	memranges_each_entry(r, &bootmem_domains) {
+		const resource_t b = MAX(begin, range_entry_base(r));
+		const resource_t e = MIN(end, range_entry_end(r));
+
+		if (range_entry_tag(r) != bsp_domain || e <= b || e - b < size)
+			continue;
+		local_end = e;
+	}
+
+	return local_end;
+}
+
 void *bootmem_allocate_buffer(size_t size)
 {
 	const struct range_entry *r;
@@ -226,6 +288,7 @@ void *bootmem_allocate_buffer(size_t size)
 	const resource_t max_addr = 1ULL << 32;
 	resource_t begin;
 	resource_t end;
+	resource_t local = 0;
 
 	if (!bootmem_is_initialized()) {
 		printk(BIOS_ERR, "%s: lib uninitialized!\n", __func__);
@@ -253,15 +316,21 @@ void *bootmem_allocate_buffer(size_t size)
 			continue;
 
 		region = r;
+		local = MAX(local, bsp_local_end(range_entry_base(r), end, size));
 	}
 
 	if (region == NULL)
 		return NULL;
 
-	/* region now points to the highest usable region for the given size. */
-	end = range_entry_end(region);
-	if (end > max_addr)
-		end = max_addr;
+	if (local) {
+		/* The highest usable piece of BSP local memory. */
+		end = local;
+	} else {
+		/* region now points to the highest usable region for the given size. */
+		end = range_entry_end(region);
+		if (end > max_addr)
+			end = max_addr;
+	}
 	begin = end - size;
 
 	/* Mark buffer as unusable for future buffer use. */
@@ -1,13 +1,21 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <acpi/acpi.h>
+#include <boot/coreboot_tables.h>
+#include <boot_task.h>
+#include <bootstate.h>
 #include <cbfs.h>
 #include <vbe.h>
 #include <console/console.h>
 #include <endian.h>
 #include <bootsplash.h>
+#include <timestamp.h>
 
 #include "jpeg.h"
 
+#define BOOTSPLASH_FILE_NAME	"bootsplash.jpg"
+
+static bool drawn;
 
 void set_bootsplash(unsigned char *framebuffer, unsigned int x_resolution,
 		    unsigned int y_resolution, unsigned int bytes_per_line,
@@ -21,7 +29,7 @@ void set_bootsplash(unsigned char *framebuffer, unsigned int x_resolution,
 	printk(BIOS_INFO, "Setting up bootsplash in %dx%d@%d\n", x_resolution, y_resolution,
 	       fb_resolution);
 	size_t filesize;
-	unsigned char *jpeg = cbfs_map("bootsplash.jpg", &filesize);
+	unsigned char *jpeg = cbfs_map(BOOTSPLASH_FILE_NAME, &filesize);
 	if (!jpeg) {
 		printk(BIOS_ERR, "Could not find bootsplash.jpg\n");
 		return;
@@ -45,8 +53,10 @@ void set_bootsplash(unsigned char *framebuffer, unsigned int x_resolution,
 	framebuffer += (yres - image_height) / 2 * bytes_per_line
 		       + (xres - image_width) / 2 * (fb_resolution / 8);
 
+	timestamp_add_now(TS_BOOTSPLASH_START);
 	int ret = jpeg_decode(jpeg, filesize, framebuffer, image_width, image_height,
 			      bytes_per_line, fb_resolution);
+	timestamp_add_now(TS_BOOTSPLASH_END);
 	cbfs_unmap(jpeg);
 	if (ret != 0) {
 		printk(BIOS_ERR, "Bootsplash could not be decoded. jpeg_decode returned %d.\n",
@@ -55,3 +65,45 @@ void set_bootsplash(unsigned char *framebuffer, unsigned int x_resolution,
 	}
 	printk(BIOS_INFO, "Bootsplash loaded\n");
 }
+
+bool bootsplash_is_drawn(void)
+{
+	return drawn;
+}
+
+#if CONFIG(BOOTSPLASH_IN_BACKGROUND)
+static void preload_bootsplash(void *unused)
+{
+	if (!CONFIG(CBFS_PRELOAD) || acpi_is_wakeup_s3())
+		return;
+
+	printk(BIOS_DEBUG, "Preloading %s\n", BOOTSPLASH_FILE_NAME);
+	cbfs_preload(BOOTSPLASH_FILE_NAME);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, preload_bootsplash, NULL);
+
+/*
+ * Graphics init registers the framebuffer during device init. If it didn't,
+ * lb_framebuffer() still draws the splash once the tables are written.
+ */
+static void draw_bootsplash(void *unused)
+{
+	struct lb_framebuffer fb;
+
+	if (acpi_is_wakeup_s3() || fill_lb_framebuffer(&fb))
+		return;
+
+	set_bootsplash((uint8_t *)(uintptr_t)fb.physical_address, fb.x_resolution,
+		       fb.y_resolution, fb.bytes_per_line, fb.bits_per_pixel);
+	drawn = true;
+}
+
+static struct boot_task bootsplash_task = {
+	.name = "bootsplash",
+	.run = draw_bootsplash,
+	.needs = BOOT_TASK_NEEDS_DEVICES_INITIALIZED,
+	.deadline = BS_WRITE_TABLES,
+};
+BOOT_TASK(bootsplash_task);
+#endif
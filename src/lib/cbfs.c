@@ -2,10 +2,13 @@
 
 #include <assert.h>
 #include <boot_device.h>
+#include <bootstate.h>
 #include <cbfs.h>
 #include <cbmem.h>
 #include <commonlib/bsd/cbfs_private.h>
 #include <commonlib/bsd/compression.h>
+#include <commonlib/cbfs_trace_serialized.h>
+#include <commonlib/endian.h>
 #include <commonlib/list.h>
 #include <console/console.h>
 #include <fmap.h>
@@ -20,15 +23,22 @@
 #include <thread.h>
 #include <timestamp.h>
 
+#if CONFIG(CBFS_CACHE_FREE_LIST)
+static __maybe_unused struct mem_pool_block cbfs_cache_blocks[CONFIG_CBFS_CACHE_FREE_LIST_BLOCKS];
+#define CBFS_CACHE_INIT(buf, size)						\
+	MEM_POOL_INIT_FREE_LIST(buf, size, CONFIG_CBFS_CACHE_ALIGN, cbfs_cache_blocks,	\
+				ARRAY_SIZE(cbfs_cache_blocks))
+#else
+#define CBFS_CACHE_INIT(buf, size) MEM_POOL_INIT(buf, size, CONFIG_CBFS_CACHE_ALIGN)
+#endif
+
 #if ENV_X86 && (ENV_POSTCAR || ENV_SMM)
 struct mem_pool cbfs_cache = MEM_POOL_INIT(NULL, 0, 0);
 #elif CONFIG(POSTRAM_CBFS_CACHE_IN_BSS) && ENV_RAMSTAGE
 static u8 cache_buffer[CONFIG_RAMSTAGE_CBFS_CACHE_SIZE];
-struct mem_pool cbfs_cache =
-	MEM_POOL_INIT(cache_buffer, sizeof(cache_buffer), CONFIG_CBFS_CACHE_ALIGN);
+struct mem_pool cbfs_cache = CBFS_CACHE_INIT(cache_buffer, sizeof(cache_buffer));
 #else
-struct mem_pool cbfs_cache =
-	MEM_POOL_INIT(_cbfs_cache, REGION_SIZE(cbfs_cache), CONFIG_CBFS_CACHE_ALIGN);
+struct mem_pool cbfs_cache = CBFS_CACHE_INIT(_cbfs_cache, REGION_SIZE(cbfs_cache));
 #endif
 
 static void switch_to_postram_cache(int unused)
@@ -98,7 +108,8 @@ void cbfs_unmap(void *mapping)
 	 * direct mappings) -- mem_pool_free() just does nothing for addresses it doesn't
 	 * recognize. This hardcodes the assumption that if platforms implement an rdev_mmap()
 	 * that requires a free() for the boot_device, they need to implement it via the
-	 * cbfs_cache mem_pool.
+	 * cbfs_cache mem_pool. Mappings from the CBFS_MAP_CACHE live in CBMEM and are kept
+	 * for later stages.
 	 */
 	mem_pool_free(&cbfs_cache, mapping);
 }
@@ -145,6 +156,9 @@ static inline bool cbfs_lzma_enabled(void)
 	/* Payload loader (ramstage) always needs LZMA. */
 	if (ENV_PAYLOAD_LOADER)
 		return true;
+	/* Bootblock and verstage load the LZMA compressed romstage and verstage. */
+	if ((ENV_BOOTBLOCK || ENV_SEPARATE_VERSTAGE) && CONFIG(COMPRESS_PRERAM_STAGES_LZMA))
+		return true;
 	/* Only other use of LZMA is ramstage compression. */
 	if (!CONFIG(COMPRESS_RAMSTAGE_LZMA))
 		return false;
@@ -158,8 +172,30 @@ static inline bool cbfs_lzma_enabled(void)
 	return ENV_BOOTBLOCK;
 }
 
+static inline bool cbfs_zstd_enabled(void)
+{
+	/* Keep the decoder and its tables out of stages that don't load Zstandard files. */
+	if (ENV_PAYLOAD_LOADER && CONFIG(COMPRESSED_PAYLOAD_ZSTD))
+		return true;
+	if ((ENV_BOOTBLOCK || ENV_SEPARATE_VERSTAGE) && CONFIG(COMPRESS_PRERAM_STAGES_ZSTD))
+		return true;
+	if (!CONFIG(COMPRESS_RAMSTAGE_ZSTD))
+		return false;
+	/* Same stages as for LZMA compressed ramstages. */
+	if (CONFIG(POSTCAR_STAGE))
+		return ENV_POSTCAR;
+	if (CONFIG(SEPARATE_ROMSTAGE))
+		return ENV_SEPARATE_ROMSTAGE;
+	return ENV_BOOTBLOCK;
+}
+
+/*
+ * Verifies and/or measures a loaded file. |calculated| is an optional digest of |buffer|
+ * that was already computed on the way in, which is used instead of hashing it again.
+ */
 static bool cbfs_file_hash_mismatch(const void *buffer, size_t size,
-				    const union cbfs_mdata *mdata, bool skip_verification)
+				    const union cbfs_mdata *mdata, bool skip_verification,
+				    const struct vb2_hash *calculated)
 {
 	/* Avoid linking hash functions when verification and measurement are disabled. */
 	if (!CONFIG(CBFS_VERIFICATION) && !CONFIG(TPM_MEASURED_BOOT))
@@ -174,7 +210,12 @@ static bool cbfs_file_hash_mismatch(const void *buffer, size_t size,
 			return true;
 		}
 
-		vb2_error_t rv = vb2_hash_verify(vboot_hwcrypto_allowed(), buffer, size, hash);
+		vb2_error_t rv;
+		if (calculated && calculated->algo == hash->algo)
+			rv = memcmp(calculated->raw, hash->raw, vb2_digest_size(hash->algo)) ?
+				VB2_ERROR_SHA_MISMATCH : VB2_SUCCESS;
+		else
+			rv = vb2_hash_verify(vboot_hwcrypto_allowed(), buffer, size, hash);
 		if (rv != VB2_SUCCESS) {
 			ERROR("'%s' file hash mismatch!\n", mdata->h.filename);
 			if (CONFIG(VBOOT_CBFS_INTEGRATION) && !vboot_recovery_mode_enabled()
@@ -189,7 +230,9 @@ static bool cbfs_file_hash_mismatch(const void *buffer, size_t size,
 		struct vb2_hash calculated_hash;
 
 		/* No need to re-hash file if we already have it from verification. */
-		if (!hash || hash->algo != TPM_MEASURE_ALGO) {
+		if (calculated && calculated->algo == TPM_MEASURE_ALGO) {
+			hash = calculated;
+		} else if (!hash || hash->algo != TPM_MEASURE_ALGO) {
 			if (vb2_hash_calculate(vboot_hwcrypto_allowed(), buffer, size,
 					       TPM_MEASURE_ALGO, &calculated_hash))
 				hash = NULL;
@@ -206,12 +249,251 @@ static bool cbfs_file_hash_mismatch(const void *buffer, size_t size,
 	return false;
 }
 
+struct cbfs_preload_context {
+	struct region_device rdev;
+	struct thread_handle handle;
+	struct list_node list_node;
+	void *buffer;
+	/* Bytes at the start of buffer that have been read so far. */
+	size_t available;
+	char name[];
+};
+
+static size_t cbfs_preload_wait(void *arg, size_t needed)
+{
+	struct cbfs_preload_context *context = arg;
+
+	while (context->available < needed && context->handle.state != THREAD_DONE)
+		assert(thread_yield() == 0);
+
+	return context->available;
+}
+
+#define CBFS_HASH_CHUNK_SIZE	(16 * KiB)
+
+struct cbfs_hash_stream {
+	struct vb2_digest_context ctx;
+	const uint8_t *data;
+	size_t size;
+	/* Bytes at the start of data that have been fed to the digest. */
+	size_t hashed;
+	bool failed;
+	struct cbfs_preload_context *preload;
+};
+
+/*
+ * Returns the algorithm for a digest that is calculated while the file is decompressed, or
+ * VB2_HASH_INVALID if the file has to be hashed up front. A single digest has to be enough
+ * for both verification and measurement, and the compressed data must not be overwritten
+ * by the output (in-place LZ4 stages) before the decompressor is done with it.
+ */
+static enum vb2_hash_algorithm cbfs_stream_hash_algo(const void *map, size_t in_size,
+						     const void *buffer, size_t buffer_size,
+						     const union cbfs_mdata *mdata,
+						     bool skip_verification)
+{
+	enum vb2_hash_algorithm algo = VB2_HASH_INVALID;
+
+	if (!CONFIG(CBFS_HASH_WHILE_DECOMPRESSING))
+		return VB2_HASH_INVALID;
+
+	if ((uintptr_t)map < (uintptr_t)buffer + buffer_size &&
+	    (uintptr_t)buffer < (uintptr_t)map + in_size)
+		return VB2_HASH_INVALID;
+
+	if (CONFIG(CBFS_VERIFICATION) && !skip_verification) {
+		const struct vb2_hash *hash = cbfs_file_hash(mdata);
+		/* The regular path reports the missing hash. */
+		if (!hash)
+			return VB2_HASH_INVALID;
+		algo = hash->algo;
+	}
+
+	if (CONFIG(TPM_MEASURED_BOOT) && !ENV_SMM) {
+		if (algo != VB2_HASH_INVALID && algo != TPM_MEASURE_ALGO)
+			return VB2_HASH_INVALID;
+		algo = TPM_MEASURE_ALGO;
+	}
+
+	return algo;
+}
+
+/* Input callback for the decompressors that hashes each piece right before it is used. */
+static size_t cbfs_hash_wait(void *arg, size_t needed)
+{
+	struct cbfs_hash_stream *hs = arg;
+	size_t end;
+
+	if (needed <= hs->hashed || hs->failed)
+		return hs->hashed;
+
+	/* Run a bit ahead of the decompressor so the digest isn't fed tiny pieces. */
+	end = MIN(ALIGN_UP(needed, CBFS_HASH_CHUNK_SIZE), hs->size);
+	if (CONFIG(CBFS_PRELOAD_STREAMING) && hs->preload)
+		end = MIN(end, cbfs_preload_wait(hs->preload, needed));
+
+	if (end > hs->hashed) {
+		if (vb2_digest_extend(&hs->ctx, hs->data + hs->hashed, end - hs->hashed)) {
+			hs->failed = true;
+			return hs->hashed;
+		}
+		hs->hashed = end;
+	}
+
+	return hs->hashed;
+}
+
+/*
+ * Decompresses |map| while it is being hashed, so every compressed byte is read from the
+ * boot medium (or the cbfs_cache) only once and is still in the CPU cache when the
+ * decompressor gets to it. The output is wiped again if the finished digest doesn't match.
+ */
+static size_t cbfs_hash_and_decompress(const void *map, size_t in_size, void *buffer,
+				       size_t buffer_size, uint32_t compression,
+				       enum vb2_hash_algorithm algo,
+				       const union cbfs_mdata *mdata, bool skip_verification,
+				       struct cbfs_preload_context *preload)
+{
+	struct cbfs_hash_stream hs = {
+		.data = map,
+		.size = in_size,
+		.preload = preload,
+	};
+	struct vb2_hash hash = { .algo = algo };
+	size_t out_size;
+
+	if (vb2_digest_init(&hs.ctx, vboot_hwcrypto_allowed(), algo, in_size))
+		return 0;
+
+	if (compression == CBFS_COMPRESS_LZ4) {
+		timestamp_add_now(TS_ULZ4F_START);
+		out_size = ulz4fn_wait(map, in_size, buffer, buffer_size, cbfs_hash_wait, &hs);
+		timestamp_add_now(TS_ULZ4F_END);
+	} else {
+		timestamp_add_now(TS_ULZMA_START);
+		out_size = ulzman_wait(map, in_size, buffer, buffer_size, cbfs_hash_wait, &hs);
+		timestamp_add_now(TS_ULZMA_END);
+	}
+
+	/* The decompressor may stop before the end of the input, the hash covers all of it. */
+	if (cbfs_hash_wait(&hs, in_size) < in_size || hs.failed ||
+	    vb2_digest_finalize(&hs.ctx, hash.raw, vb2_digest_size(algo)) ||
+	    cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification, &hash)) {
+		memset(buffer, 0, out_size);
+		return 0;
+	}
+
+	return out_size;
+}
+
+/*
+ * Without a memory mapped boot device, mapping a file takes as much cbfs_cache as the file
+ * is big. The stages that load LZMA compressed pre-RAM stages read them in small pieces.
+ */
+static inline bool cbfs_lzma_stream_input(void)
+{
+	return CONFIG(COMPRESS_PRERAM_STAGES_LZMA) && !CONFIG(BOOT_DEVICE_MEMORY_MAPPED) &&
+	       (ENV_BOOTBLOCK || ENV_SEPARATE_VERSTAGE);
+}
+
+#define CBFS_LZMA_STREAM_CHUNK	(1 * KiB)
+
+struct cbfs_lzma_stream {
+	const struct region_device *rdev;
+	size_t offset;
+	struct vb2_digest_context ctx;
+	bool hash;
+	bool failed;
+	uint8_t buf[CBFS_LZMA_STREAM_CHUNK];
+};
+
+static size_t cbfs_lzma_stream_read(void *arg, const void **buf)
+{
+	struct cbfs_lzma_stream *ls = arg;
+	size_t size = MIN(sizeof(ls->buf), region_device_sz(ls->rdev) - ls->offset);
+
+	if (!size || ls->failed)
+		return 0;
+
+	if (rdev_readat(ls->rdev, ls->buf, ls->offset, size) != size ||
+	    (ls->hash && vb2_digest_extend(&ls->ctx, ls->buf, size))) {
+		ls->failed = true;
+		return 0;
+	}
+
+	ls->offset += size;
+	*buf = ls->buf;
+	return size;
+}
+
+/*
+ * Decompresses an LZMA file piece by piece straight from |rdev|, hashing each piece on the
+ * way if the file has to be verified or measured. Returns false if the file can't be
+ * handled this way, in which case it has to be mapped.
+ */
+static bool cbfs_stream_lzma(const struct region_device *rdev, void *buffer,
+			     size_t buffer_size, const union cbfs_mdata *mdata,
+			     bool skip_verification, size_t *out_size)
+{
+	static uint8_t scratchpad[LZMA_SCRATCHPAD_SIZE_FOR(1)];
+	static struct cbfs_lzma_stream ls;
+	const struct ulzma_stream stream = {
+		.read = cbfs_lzma_stream_read,
+		.arg = &ls,
+		.window = buffer,
+		.window_size = buffer_size,
+		.scratchpad = scratchpad,
+		.scratchpad_size = sizeof(scratchpad),
+	};
+	const void *piece;
+	struct vb2_hash hash = { .algo = VB2_HASH_INVALID };
+
+	ls.rdev = rdev;
+	ls.offset = 0;
+	ls.hash = (CONFIG(CBFS_VERIFICATION) && !skip_verification) ||
+		  (CONFIG(TPM_MEASURED_BOOT) && !ENV_SMM);
+	ls.failed = false;
+
+	if (ls.hash) {
+		/* There is no mapping that could overlap with the output. */
+		hash.algo = cbfs_stream_hash_algo(NULL, 0, buffer, buffer_size, mdata,
+						  skip_verification);
+		if (hash.algo == VB2_HASH_INVALID)
+			return false;
+		if (vb2_digest_init(&ls.ctx, vboot_hwcrypto_allowed(), hash.algo,
+				    region_device_sz(rdev)))
+			return false;
+	}
+
+	timestamp_add_now(TS_ULZMA_START);
+	*out_size = ulzman_stream(&stream);
+	timestamp_add_now(TS_ULZMA_END);
+
+	if (!ls.hash)
+		return true;
+
+	/* The decompressor may stop before the end of the input, the hash covers all of it. */
+	while (cbfs_lzma_stream_read(&ls, &piece))
+		;
+
+	if (ls.failed || vb2_digest_finalize(&ls.ctx, hash.raw, vb2_digest_size(hash.algo)) ||
+	    cbfs_file_hash_mismatch(NULL, region_device_sz(rdev), mdata, skip_verification,
+				    &hash)) {
+		memset(buffer, 0, *out_size);
+		*out_size = 0;
+	}
+
+	return true;
+}
+
 static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *buffer,
 				       size_t buffer_size, uint32_t compression,
-				       const union cbfs_mdata *mdata, bool skip_verification)
+				       const union cbfs_mdata *mdata, bool skip_verification,
+				       struct cbfs_preload_context *stream)
 {
 	size_t in_size = region_device_sz(rdev);
 	size_t out_size = 0;
+	enum vb2_hash_algorithm algo;
 	void *map;
 
 	DEBUG("Decompressing %zu bytes from '%s' to %p with algo %d\n",
@@ -230,7 +512,7 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 			return 0;
 		if (rdev_readat(rdev, buffer, 0, in_size) != in_size)
 			return 0;
-		if (cbfs_file_hash_mismatch(buffer, in_size, mdata, skip_verification))
+		if (cbfs_file_hash_mismatch(buffer, in_size, mdata, skip_verification, NULL))
 			return 0;
 		return in_size;
 
@@ -244,7 +526,25 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 		if (map == NULL)
 			return 0;
 
-		if (!cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification)) {
+		algo = cbfs_stream_hash_algo(map, in_size, buffer, buffer_size, mdata,
+					     skip_verification);
+		if (algo != VB2_HASH_INVALID) {
+			out_size = cbfs_hash_and_decompress(map, in_size, buffer, buffer_size,
+							    compression, algo, mdata,
+							    skip_verification, stream);
+		} else if (CONFIG(CBFS_PRELOAD_STREAMING) && stream) {
+			/* Decompress blocks as soon as the preload thread has read them. The
+			   file can only be measured once it has fully arrived. (Streaming is
+			   not available with CBFS_VERIFICATION, see Kconfig.) */
+			timestamp_add_now(TS_ULZ4F_START);
+			out_size = ulz4fn_wait(map, in_size, buffer, buffer_size,
+					       cbfs_preload_wait, stream);
+			timestamp_add_now(TS_ULZ4F_END);
+			if (cbfs_preload_wait(stream, in_size) < in_size ||
+			    cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification, NULL))
+				out_size = 0;
+		} else if (!cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification,
+						    NULL)) {
 			timestamp_add_now(TS_ULZ4F_START);
 			out_size = ulz4fn(map, in_size, buffer, buffer_size);
 			timestamp_add_now(TS_ULZ4F_END);
@@ -257,11 +557,24 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 	case CBFS_COMPRESS_LZMA:
 		if (!cbfs_lzma_enabled())
 			return 0;
+
+		if (cbfs_lzma_stream_input() &&
+		    cbfs_stream_lzma(rdev, buffer, buffer_size, mdata, skip_verification,
+				     &out_size))
+			return out_size;
+
 		map = rdev_mmap_full(rdev);
 		if (map == NULL)
 			return 0;
 
-		if (!cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification)) {
+		algo = cbfs_stream_hash_algo(map, in_size, buffer, buffer_size, mdata,
+					     skip_verification);
+		if (algo != VB2_HASH_INVALID) {
+			out_size = cbfs_hash_and_decompress(map, in_size, buffer, buffer_size,
+							    compression, algo, mdata,
+							    skip_verification, NULL);
+		} else if (!cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification,
+						    NULL)) {
 			/* Note: timestamp not useful for memory-mapped media (x86) */
 			timestamp_add_now(TS_ULZMA_START);
 			out_size = ulzman(map, in_size, buffer, buffer_size);
@@ -272,19 +585,31 @@ static size_t cbfs_load_and_decompress(const struct region_device *rdev, void *b
 
 		return out_size;
 
+	case CBFS_COMPRESS_ZSTD:
+		if (!cbfs_zstd_enabled())
+			return 0;
+
+		/* Zstandard can't be decompressed in place and there is no streaming
+		   variant, the whole file is mapped and checked up front. */
+		map = rdev_mmap_full(rdev);
+		if (map == NULL)
+			return 0;
+
+		if (!cbfs_file_hash_mismatch(map, in_size, mdata, skip_verification, NULL)) {
+			timestamp_add_now(TS_UZSTD_START);
+			out_size = uzstdn(map, in_size, buffer, buffer_size);
+			timestamp_add_now(TS_UZSTD_END);
+		}
+
+		rdev_munmap(rdev, map);
+
+		return out_size;
+
 	default:
 		return 0;
 	}
 }
 
-struct cbfs_preload_context {
-	struct region_device rdev;
-	struct thread_handle handle;
-	struct list_node list_node;
-	void *buffer;
-	char name[];
-};
-
 static struct list_node cbfs_preload_context_list;
 
 static struct cbfs_preload_context *alloc_cbfs_preload_context(size_t additional)
@@ -314,18 +639,47 @@ static void free_cbfs_preload_context(struct cbfs_preload_context *context)
 	mem_pool_free(&cbfs_cache, context);
 }
 
+static size_t cbfs_preload_chunk_size(size_t size)
+{
+#if CONFIG(CBFS_PRELOAD_STREAMING)
+	return MIN(size, CONFIG_CBFS_PRELOAD_CHUNK_SIZE);
+#else
+	return size;
+#endif
+}
+
 static enum cb_err cbfs_preload_thread_entry(void *arg)
 {
 	struct cbfs_preload_context *context = arg;
-
-	if (rdev_read_full(&context->rdev, context->buffer) < 0) {
-		ERROR("%s(name='%s') readat failed\n", __func__, context->name);
-		return CB_ERR;
+	const size_t size = region_device_sz(&context->rdev);
+	const size_t chunk = cbfs_preload_chunk_size(size);
+
+	/* Read in chunks so a streaming consumer can start on the data that has arrived. */
+	while (context->available < size) {
+		size_t len = MIN(chunk, size - context->available);
+		if (rdev_readat(&context->rdev, context->buffer + context->available,
+				context->available, len) != len) {
+			ERROR("%s(name='%s') readat failed\n", __func__, context->name);
+			return CB_ERR;
+		}
+		context->available += len;
 	}
 
 	return CB_SUCCESS;
 }
 
+static struct cbfs_preload_context *find_cbfs_preload_context(const char *name)
+{
+	struct cbfs_preload_context *context;
+
+	list_for_each(context, cbfs_preload_context_list, list_node) {
+		if (strcmp(context->name, name) == 0)
+			return context;
+	}
+
+	return NULL;
+}
+
 void cbfs_preload(const char *name)
 {
 	struct region_device rdev;
@@ -343,6 +697,11 @@ void cbfs_preload(const char *name)
 
 	DEBUG("%s(name='%s')\n", __func__, name);
 
+	if (find_cbfs_preload_context(name)) {
+		DEBUG("%s(name='%s') already preloading\n", __func__, name);
+		return;
+	}
+
 	if (_cbfs_boot_lookup(name, force_ro, &mdata, &rdev))
 		return;
 
@@ -376,19 +735,85 @@ out:
 	free_cbfs_preload_context(context);
 }
 
-static struct cbfs_preload_context *find_cbfs_preload_context(const char *name)
+#define PREFETCH_HINTS_MAX	16
+
+void cbfs_preload_hints(void)
 {
-	struct cbfs_preload_context *context;
+	char names[PREFETCH_HINTS_MAX][CBFS_TRACE_NAME_LEN];
+	const struct cbfs_prefetch_hints *hints;
+	size_t hints_size, budget, used = 0;
+	unsigned int i, count = 0;
 
-	list_for_each(context, cbfs_preload_context_list, list_node) {
-		if (strcmp(context->name, name) == 0)
-			return context;
+	if (!CONFIG(CBFS_PREFETCH_HINTS) || !ENV_SUPPORTS_COOP)
+		return;
+
+	hints = cbfs_map(CBFS_PREFETCH_HINTS_NAME, &hints_size);
+	if (!hints)
+		return;
+
+	if (hints_size < sizeof(*hints) || read_le32(&hints->magic) !=
+	    CBFS_PREFETCH_HINTS_MAGIC || read_le32(&hints->num_records) >
+	    (hints_size - sizeof(*hints)) / sizeof(hints->records[0])) {
+		ERROR("Invalid %s\n", CBFS_PREFETCH_HINTS_NAME);
+		cbfs_unmap((void *)hints);
+		return;
 	}
 
-	return NULL;
+	/* Copy the names out first, the mapping must be gone before the preload buffers are
+	   allocated from the cbfs_cache. */
+	for (i = 0; i < read_le32(&hints->num_records) && count < ARRAY_SIZE(names); i++) {
+		const struct cbfs_access_record *rec = &hints->records[i];
+
+		if (strncmp(rec->stage, ENV_STRING, sizeof(rec->stage)) != 0 ||
+		    strnlen(rec->name, sizeof(rec->name)) == sizeof(rec->name))
+			continue;
+		strcpy(names[count++], rec->name);
+	}
+	cbfs_unmap((void *)hints);
+
+	/* Leave room for mapping compressed files and for files that were not hinted. */
+	budget = cbfs_cache.size / 2;
+	for (i = 0; i < count; i++) {
+		const size_t size = cbfs_get_size(names[i]);
+
+		if (!size)
+			continue;
+		if (used + size > budget) {
+			DEBUG("%s: skipping '%s' (%zu bytes), over budget\n", __func__,
+			      names[i], size);
+			continue;
+		}
+		used += size;
+		cbfs_preload(names[i]);
+	}
+}
+
+#if ENV_RAMSTAGE
+static void preload_hints(void *unused)
+{
+	cbfs_preload_hints();
+}
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, preload_hints, NULL);
+#endif
+
+static bool cbfs_preload_can_stream(const union cbfs_mdata *mdata)
+{
+	if (!CONFIG(CBFS_PRELOAD_STREAMING) || !cbfs_lz4_enabled())
+		return false;
+
+	const struct cbfs_file_attr_compression *cattr = cbfs_find_attr(mdata,
+				CBFS_FILE_ATTR_TAG_COMPRESSION, sizeof(*cattr));
+	return cattr && be32toh(cattr->compression) == CBFS_COMPRESS_LZ4;
 }
 
-static enum cb_err get_preload_rdev(struct region_device *rdev, const char *name)
+/*
+ * Points rdev at the preload buffer for this file. If the file can be decompressed while it
+ * is still being read, the preload thread is left running and its context is returned in
+ * *stream. The caller must then hand it to finish_preload_stream() when done.
+ */
+static enum cb_err get_preload_rdev(struct region_device *rdev, const char *name,
+				    const union cbfs_mdata *mdata,
+				    struct cbfs_preload_context **stream)
 {
 	enum cb_err err;
 	struct cbfs_preload_context *context;
@@ -400,6 +825,13 @@ static enum cb_err get_preload_rdev(struct region_device *rdev, const char *name
 	if (!context)
 		return CB_ERR_ARG;
 
+	if (cbfs_preload_can_stream(mdata) &&
+	    rdev_chain_mem(rdev, context->buffer, region_device_sz(&context->rdev)) == 0) {
+		DEBUG("%s(name='%s') streaming from preload\n", __func__, name);
+		*stream = context;
+		return CB_SUCCESS;
+	}
+
 	err = thread_join(&context->handle);
 	if (err != CB_SUCCESS) {
 		ERROR("%s(name='%s') Preload thread failed: %u\n", __func__, name, err);
@@ -424,9 +856,78 @@ out:
 	return err;
 }
 
+static void finish_preload_stream(struct cbfs_preload_context *context)
+{
+	enum cb_err err = thread_join(&context->handle);
+	if (err != CB_SUCCESS)
+		ERROR("%s(name='%s') Preload thread failed: %u\n", __func__, context->name,
+		      err);
+
+	free_cbfs_preload_context(context);
+}
+
+/*
+ * Whether a cbfs_map() of this file can be served from and added to the CBFS_MAP_CACHE. A
+ * cache hit has no raw file data to hash, so with measured boot the verified file hash has
+ * to be usable for the measurement.
+ */
+static bool cbfs_map_cache_allowed(const union cbfs_mdata *mdata, uint32_t compression)
+{
+	const struct vb2_hash *hash;
+
+	if (!CONFIG(CBFS_MAP_CACHE) || !ENV_HAS_CBMEM)
+		return false;
+
+	/*
+	 * Those are mapped in place, unless they would have to be hashed from the boot device
+	 * on every map. A verified copy only costs the same read and hash once.
+	 */
+	if (compression == CBFS_COMPRESS_NONE && CONFIG(BOOT_DEVICE_MEMORY_MAPPED) &&
+	    !CONFIG(CBFS_VERIFICATION))
+		return false;
+
+	if (!CONFIG(TPM_MEASURED_BOOT) || ENV_SMM)
+		return true;
+
+	hash = cbfs_file_hash(mdata);
+	return CONFIG(CBFS_VERIFICATION) && hash && hash->algo == TPM_MEASURE_ALGO;
+}
+
+static void *cbfs_map_cached(union cbfs_mdata *mdata, struct region_device *rdev,
+			     size_t size, uint32_t compression,
+			     struct cbfs_preload_context *stream, bool *handled)
+{
+	const struct vb2_hash *hash;
+	void *loc;
+	int slot;
+
+	*handled = true;
+
+	loc = cbfs_map_cache_find(mdata, rdev, size, &hash);
+	if (loc) {
+		DEBUG("'%s' mapped from the CBMEM cache\n", mdata->h.filename);
+		/* Checks the cached hash against the metadata and measures the file. */
+		if (cbfs_file_hash_mismatch(NULL, 0, mdata, false, hash))
+			return NULL;
+		return loc;
+	}
+
+	loc = cbfs_map_cache_reserve(mdata, rdev, size, &slot);
+	if (!loc) {
+		*handled = false;
+		return NULL;
+	}
+
+	size = cbfs_load_and_decompress(rdev, loc, size, compression, mdata, false, stream);
+	cbfs_map_cache_commit(slot, size != 0);
+
+	return size ? loc : NULL;
+}
+
 static void *do_alloc(union cbfs_mdata *mdata, struct region_device *rdev,
 		      cbfs_allocator_t allocator, void *arg, size_t *size_out,
-		      bool skip_verification)
+		      bool skip_verification, struct cbfs_preload_context *stream,
+		      bool map_cache)
 {
 	size_t size = region_device_sz(rdev);
 	void *loc = NULL;
@@ -442,6 +943,14 @@ static void *do_alloc(union cbfs_mdata *mdata, struct region_device *rdev,
 	if (size_out)
 		*size_out = size;
 
+	if (!allocator && map_cache && !skip_verification &&
+	    cbfs_map_cache_allowed(mdata, compression)) {
+		bool handled;
+		loc = cbfs_map_cached(mdata, rdev, size, compression, stream, &handled);
+		if (handled)
+			return loc;
+	}
+
 	/* allocator == NULL means do a cbfs_map() */
 	if (allocator) {
 		loc = allocator(arg, size, mdata);
@@ -449,7 +958,7 @@ static void *do_alloc(union cbfs_mdata *mdata, struct region_device *rdev,
 		void *mapping = rdev_mmap_full(rdev);
 		if (!mapping)
 			return NULL;
-		if (cbfs_file_hash_mismatch(mapping, size, mdata, skip_verification)) {
+		if (cbfs_file_hash_mismatch(mapping, size, mdata, skip_verification, NULL)) {
 			rdev_munmap(rdev, mapping);
 			return NULL;
 		}
@@ -468,7 +977,8 @@ static void *do_alloc(union cbfs_mdata *mdata, struct region_device *rdev,
 		return NULL;
 	}
 
-	size = cbfs_load_and_decompress(rdev, loc, size, compression, mdata, skip_verification);
+	size = cbfs_load_and_decompress(rdev, loc, size, compression, mdata, skip_verification,
+					stream);
 	if (!size)
 		return NULL;
 
@@ -480,6 +990,7 @@ void *_cbfs_alloc(const char *name, cbfs_allocator_t allocator, void *arg,
 {
 	struct region_device rdev;
 	bool preload_successful = false;
+	struct cbfs_preload_context *stream = NULL;
 	union cbfs_mdata mdata;
 
 	DEBUG("%s(name='%s', alloc=%p(%p), force_ro=%s, type=%d)\n", __func__, name, allocator,
@@ -499,11 +1010,19 @@ void *_cbfs_alloc(const char *name, cbfs_allocator_t allocator, void *arg,
 		}
 	}
 
+	if (CONFIG(CBFS_ACCESS_TRACE) && ENV_HAS_CBMEM)
+		cbfs_trace_access(name, region_device_sz(&rdev));
+
 	/* Update the rdev with the preload content */
-	if (!force_ro && get_preload_rdev(&rdev, name) == CB_SUCCESS)
+	if (!force_ro && get_preload_rdev(&rdev, name, &mdata, &stream) == CB_SUCCESS)
 		preload_successful = true;
 
-	void *ret = do_alloc(&mdata, &rdev, allocator, arg, size_out, false);
+	/* The cache is keyed by the location on the boot device, not the preload buffer. */
+	void *ret = do_alloc(&mdata, &rdev, allocator, arg, size_out, false, stream,
+			     !preload_successful);
+
+	if (CONFIG(CBFS_PRELOAD_STREAMING) && stream)
+		finish_preload_stream(stream);
 
 	/* When using cbfs_preload we need to free the preload buffer after populating the
 	 * destination buffer. We know we must have a mem_rdev here, so extra mmap is fine. */
@@ -533,7 +1052,7 @@ void *_cbfs_unverified_area_alloc(const char *area, const char *name,
 	if (rdev_chain(&file_rdev, &area_rdev, data_offset, be32toh(mdata.h.len)))
 		return NULL;
 
-	return do_alloc(&mdata, &file_rdev, allocator, arg, size_out, true);
+	return do_alloc(&mdata, &file_rdev, allocator, arg, size_out, true, NULL, false);
 }
 
 void *_cbfs_default_allocator(void *arg, size_t size, const union cbfs_mdata *unused)
@@ -584,7 +1103,8 @@ enum cb_err cbfs_prog_stage_load(struct prog *pstage)
 	    !CONFIG(NO_XIP_EARLY_STAGES) && CONFIG(BOOT_DEVICE_MEMORY_MAPPED)) {
 		void *mapping = rdev_mmap_full(&rdev);
 		rdev_munmap(&rdev, mapping);
-		if (cbfs_file_hash_mismatch(mapping, region_device_sz(&rdev), &mdata, false))
+		if (cbfs_file_hash_mismatch(mapping, region_device_sz(&rdev), &mdata, false,
+					    NULL))
 			return CB_CBFS_HASH_MISMATCH;
 		if (mapping == prog_start(pstage))
 			return CB_SUCCESS;
@@ -601,7 +1121,7 @@ enum cb_err cbfs_prog_stage_load(struct prog *pstage)
 	}
 
 	size_t fsize = cbfs_load_and_decompress(&rdev, prog_start(pstage), prog_size(pstage),
-						compression, &mdata, false);
+						compression, &mdata, false, NULL);
 	if (!fsize)
 		return CB_ERR;
 
@@ -714,7 +1234,7 @@ static void mcache_to_cbmem(const struct cbfs_boot_device *cbd, u32 cbmem_id)
 		       cbmem_id, real_size);
 		return;
 	}
-	memcpy(cbmem_mcache, cbd->mcache, real_size);
+	cbfs_mcache_copy(cbmem_mcache, cbd->mcache, cbd->mcache_size);
 }
 
 static void cbfs_mcache_migrate(int unused)
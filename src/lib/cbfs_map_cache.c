@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbfs.h>
+#include <cbmem.h>
+#include <commonlib/bsd/cbfs_private.h>
+#include <console/console.h>
+#include <string.h>
+
+#define MAP_CACHE_NAME_LEN	64
+
+struct cbfs_map_cache_entry {
+	char name[MAP_CACHE_NAME_LEN];
+	uint32_t offset;		/* Of the file data on the boot device */
+	uint32_t len;			/* Of the file data in CBFS */
+	uint32_t size;			/* Of the mapping */
+	struct vb2_hash hash;		/* File hash that was verified, with CBFS_VERIFICATION */
+	uint8_t valid;
+	uint8_t reserved;		/* Being loaded by cbfs_map_cache_reserve() */
+};
+
+/* Index of the cached mappings, the data of entry i is in CBMEM_ID_CBFS_MAPx + i. */
+struct cbfs_map_cache {
+	uint32_t used;
+	struct cbfs_map_cache_entry entries[CONFIG_CBFS_MAP_CACHE_ENTRIES];
+};
+
+static struct cbfs_map_cache *map_cache;
+
+static struct cbfs_map_cache *get_map_cache(void)
+{
+	if (!ENV_HAS_CBMEM || !cbmem_online())
+		return NULL;
+
+	if (!map_cache)
+		map_cache = cbmem_find(CBMEM_ID_CBFS_MAP_CACHE);
+
+	return map_cache;
+}
+
+static bool entry_matches(const struct cbfs_map_cache_entry *e, const union cbfs_mdata *mdata,
+			  const struct region_device *rdev, size_t size)
+{
+	const struct vb2_hash *hash;
+
+	if (strncmp(e->name, mdata->h.filename, sizeof(e->name)) ||
+	    e->offset != region_device_offset(rdev) || e->len != region_device_sz(rdev) ||
+	    e->size != size)
+		return false;
+
+	if (!CONFIG(CBFS_VERIFICATION))
+		return true;
+
+	hash = cbfs_file_hash(mdata);
+	return hash && hash->algo == e->hash.algo &&
+	       !memcmp(hash->raw, e->hash.raw, vb2_digest_size(hash->algo));
+}
+
+void *cbfs_map_cache_find(const union cbfs_mdata *mdata, const struct region_device *rdev,
+			  size_t size, const struct vb2_hash **hash)
+{
+	struct cbfs_map_cache *mc = get_map_cache();
+	size_t i;
+
+	if (!mc)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(mc->entries); i++) {
+		const struct cbfs_map_cache_entry *e = &mc->entries[i];
+
+		if (!e->valid || !entry_matches(e, mdata, rdev, size))
+			continue;
+
+		*hash = &e->hash;
+		return cbmem_find(CBMEM_ID_CBFS_MAPx + i);
+	}
+
+	return NULL;
+}
+
+void *cbfs_map_cache_reserve(const union cbfs_mdata *mdata, const struct region_device *rdev,
+			     size_t size, int *slot)
+{
+	struct cbfs_map_cache *mc = get_map_cache();
+	const struct cbmem_entry *entry;
+	const struct vb2_hash *hash;
+	void *buf;
+	size_t i;
+
+	if (!mc || region_device_offset(rdev) > UINT32_MAX || size > UINT32_MAX ||
+	    strnlen(mdata->h.filename, MAP_CACHE_NAME_LEN) >= MAP_CACHE_NAME_LEN)
+		return NULL;
+
+	hash = cbfs_file_hash(mdata);
+	if (CONFIG(CBFS_VERIFICATION) && !hash)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(mc->entries); i++) {
+		struct cbfs_map_cache_entry *e = &mc->entries[i];
+
+		if (e->valid || e->reserved)
+			continue;
+
+		/* CBMEM entries can't be freed, so slots keep their buffer once it exists. */
+		entry = cbmem_entry_find(CBMEM_ID_CBFS_MAPx + i);
+		if (entry) {
+			if (cbmem_entry_size(entry) < size)
+				continue;
+			buf = cbmem_entry_start(entry);
+		} else {
+			if (mc->used + size > CONFIG_CBFS_MAP_CACHE_SIZE * KiB)
+				return NULL;
+			buf = cbmem_add(CBMEM_ID_CBFS_MAPx + i, size);
+			if (!buf)
+				return NULL;
+			mc->used += size;
+		}
+
+		memset(e, 0, sizeof(*e));
+		strcpy(e->name, mdata->h.filename);
+		e->offset = region_device_offset(rdev);
+		e->len = region_device_sz(rdev);
+		e->size = size;
+		if (CONFIG(CBFS_VERIFICATION))
+			memcpy(&e->hash, hash, sizeof(e->hash));
+		e->reserved = 1;
+
+		*slot = i;
+		return buf;
+	}
+
+	return NULL;
+}
+
+void cbfs_map_cache_commit(int slot, bool success)
+{
+	struct cbfs_map_cache *mc = get_map_cache();
+
+	if (!mc || slot < 0 || slot >= ARRAY_SIZE(mc->entries))
+		return;
+
+	mc->entries[slot].reserved = 0;
+	mc->entries[slot].valid = success;
+}
+
+static void cbfs_map_cache_init(int is_recovery)
+{
+	struct cbfs_map_cache *mc;
+	size_t i;
+
+	mc = cbmem_add(CBMEM_ID_CBFS_MAP_CACHE, sizeof(*mc));
+	if (!mc) {
+		printk(BIOS_ERR, "Could not allocate the CBFS map cache\n");
+		return;
+	}
+
+	if (!is_recovery) {
+		memset(mc, 0, sizeof(*mc));
+	} else {
+		/* The boot media may have been updated since the mappings were made. */
+		for (i = 0; i < ARRAY_SIZE(mc->entries); i++)
+			mc->entries[i].valid = 0;
+	}
+	for (i = 0; i < ARRAY_SIZE(mc->entries); i++)
+		mc->entries[i].reserved = 0;
+
+	map_cache = mc;
+}
+CBMEM_CREATION_HOOK(cbfs_map_cache_init);
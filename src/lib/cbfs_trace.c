@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbfs.h>
+#include <cbmem.h>
+#include <commonlib/cbfs_trace_serialized.h>
+#include <console/console.h>
+#include <string.h>
+
+#define EARLY_RECORDS	16
+
+/* Accesses of the CBMEM creating stage from before CBMEM is up. */
+static struct cbfs_access_record early_records[ENV_CREATES_CBMEM ? EARLY_RECORDS : 0];
+static uint32_t early_num, early_dropped;
+
+static struct cbfs_access_trace *trace;
+
+static bool fill_record(struct cbfs_access_record *rec, const char *name, size_t size)
+{
+	if (strnlen(name, CBFS_TRACE_NAME_LEN) >= CBFS_TRACE_NAME_LEN)
+		return false;
+
+	memset(rec, 0, sizeof(*rec));
+	strncpy(rec->stage, ENV_STRING, sizeof(rec->stage) - 1);
+	strcpy(rec->name, name);
+	rec->size = size;
+	return true;
+}
+
+static void record_access(struct cbfs_access_trace *t, const char *name, size_t size)
+{
+	if (t->num_entries >= t->max_entries ||
+	    !fill_record(&t->records[t->num_entries], name, size)) {
+		t->dropped++;
+		return;
+	}
+	t->num_entries++;
+}
+
+void cbfs_trace_access(const char *name, size_t size)
+{
+	if (!ENV_HAS_CBMEM)
+		return;
+
+	if (!cbmem_online()) {
+		if (!ENV_CREATES_CBMEM)
+			return;
+		if (early_num >= ARRAY_SIZE(early_records) ||
+		    !fill_record(&early_records[early_num], name, size))
+			early_dropped++;
+		else
+			early_num++;
+		return;
+	}
+
+	if (!trace)
+		trace = cbmem_find(CBMEM_ID_CBFS_TRACE);
+	if (trace)
+		record_access(trace, name, size);
+}
+
+static void cbfs_trace_init(int is_recovery)
+{
+	const size_t max = CONFIG_CBFS_ACCESS_TRACE_ENTRIES;
+	uint32_t i;
+
+	trace = cbmem_add(CBMEM_ID_CBFS_TRACE,
+			  sizeof(*trace) + max * sizeof(struct cbfs_access_record));
+	if (!trace) {
+		printk(BIOS_ERR, "Could not allocate the CBFS access trace\n");
+		return;
+	}
+
+	/* cbmem_add() returns the old trace on S3 resume, every boot starts a new one. */
+	trace->max_entries = max;
+	trace->num_entries = 0;
+	trace->dropped = early_dropped;
+
+	for (i = 0; i < early_num; i++) {
+		if (trace->num_entries >= trace->max_entries) {
+			trace->dropped++;
+			continue;
+		}
+		trace->records[trace->num_entries++] = early_records[i];
+	}
+}
+CBMEM_CREATION_HOOK(cbfs_trace_init);
@@ -4,6 +4,9 @@
 #include <console/console.h>
 #include <console/uart.h>
 #include <cbmem.h>
+#include <commonlib/bsd/compression.h>
+#include <commonlib/console_archive_serialized.h>
+#include <string.h>
 #include <symbols.h>
 #include <types.h>
 
@@ -41,6 +44,25 @@ static struct cbmem_console *current_console;
 
 static bool console_paused;
 
+#define DEFERRED_DRAIN (CONFIG(CONSOLE_SERIAL_DEFERRED) && ENV_RAMSTAGE)
+
+/*
+ * Bytes written to / drained from the CBMEM console since the deferred UART
+ * drain was started, and the buffer position that corresponds to byte 0.
+ */
+static struct {
+	bool enabled;
+	u32 start;
+	u32 written;
+	u32 drained;
+} drain;
+
+#define ARCHIVE (CONFIG(CONSOLE_CBMEM_ARCHIVE) && ENV_HAS_CBMEM)
+#define ARCHIVE_PAGE_SIZE 4096
+
+/* Where overwritten pages of the CBMEM console go, see console_archive_serialized.h. */
+static struct console_archive *archive;
+
 /*
  * While running from ROM, before DRAM is initialized, some area in cache as
  * RAM space is used for the console buffer storage. The size and location of
@@ -97,6 +119,106 @@ void cbmemc_init(void)
 	}
 }
 
+static struct console_archive_segment *archive_segment(u32 offset)
+{
+	return (struct console_archive_segment *)&archive->data[offset];
+}
+
+static u32 archive_segment_end(u32 offset)
+{
+	const struct console_archive_segment *seg = archive_segment(offset);
+
+	return offset + ALIGN_UP(sizeof(*seg) + (seg->block_size & ~CONSOLE_ARCHIVE_STORED), 4);
+}
+
+static void archive_drop_oldest(void)
+{
+	u32 next = archive_segment_end(archive->head);
+
+	archive->dropped += archive_segment(archive->head)->text_size;
+	if (next + sizeof(struct console_archive_segment) > archive->size ||
+	    !archive_segment(next)->text_size)
+		next = 0;
+	archive->head = next;
+
+	if (!--archive->segments)
+		archive->head = archive->tail = 0;
+}
+
+/* Drops the oldest segments until there are need bytes free at the tail. */
+static bool archive_make_room(u32 need)
+{
+	if (need > archive->size)
+		return false;
+
+	if (archive->tail + need > archive->size) {
+		/* Everything behind the tail is lost when it wraps around. */
+		while (archive->segments && archive->head >= archive->tail)
+			archive_drop_oldest();
+		if (archive->segments) {
+			if (archive->tail + sizeof(struct console_archive_segment) <= archive->size)
+				archive_segment(archive->tail)->text_size = 0;
+			archive->tail = 0;
+		}
+	}
+
+	while (archive->segments && archive->head >= archive->tail &&
+	       archive->head < archive->tail + need)
+		archive_drop_oldest();
+
+	return true;
+}
+
+/* Compresses the rest of the console page that starts at or before cursor. */
+static void archive_page(u32 cursor)
+{
+	const u32 end = MIN(ALIGN_DOWN(cursor, ARCHIVE_PAGE_SIZE) + ARCHIVE_PAGE_SIZE,
+			    current_console->size);
+	const u32 size = end - cursor;
+	struct console_archive_segment *seg;
+	size_t block_size;
+
+	if (!archive_make_room(ALIGN_UP(sizeof(*seg) + size, 4)))
+		return;
+
+	seg = archive_segment(archive->tail);
+	block_size = lz4_compress_block(&current_console->body[cursor], size, seg + 1,
+					size - 1);
+	if (!block_size) {
+		memcpy(seg + 1, &current_console->body[cursor], size);
+		block_size = size | CONSOLE_ARCHIVE_STORED;
+	}
+	seg->text_size = size;
+	seg->block_size = block_size;
+
+	archive->tail = archive_segment_end(archive->tail);
+	archive->segments++;
+}
+
+static void archive_init(void)
+{
+	const size_t size = CONFIG_CONSOLE_CBMEM_ARCHIVE_SIZE;
+	/* If CBMEM entry already existed, old contents are not altered. */
+	struct console_archive *a = cbmem_add(CBMEM_ID_CONSOLE_ARCHIVE, size);
+
+	if (!a || !current_console)
+		return;
+
+	archive = a;
+	if (a->magic == CONSOLE_ARCHIVE_MAGIC && a->size == size - sizeof(*a) &&
+	    a->page_size == ARCHIVE_PAGE_SIZE && a->head < a->size && a->tail <= a->size)
+		return;
+
+	memset(a, 0, sizeof(*a));
+	a->magic = CONSOLE_ARCHIVE_MAGIC;
+	a->size = size - sizeof(*a);
+	a->page_size = ARCHIVE_PAGE_SIZE;
+
+	/* The next page may already be partly overwritten, keep the rest of it. */
+	if (current_console->cursor & OVERFLOW)
+		archive_page(current_console->cursor & CURSOR_MASK);
+}
+
 void cbmemc_tx_byte(unsigned char data)
 {
 	if (!current_console || !current_console->size || console_paused)
@@ -112,6 +234,37 @@ void cbmemc_tx_byte(unsigned char data)
 	}
 
 	current_console->cursor = flags | cursor;
+
+	/* Save the page that is overwritten next. */
+	if (ARCHIVE && archive && (flags & OVERFLOW) && !(cursor % ARCHIVE_PAGE_SIZE))
+		archive_page(cursor);
+
+	if (DEFERRED_DRAIN)
+		drain.written++;
+}
+
+size_t cbmemc_drain(u8 *buf, size_t len, u32 *lost)
+{
+	size_t i, pending;
+
+	*lost = 0;
+	if (!DEFERRED_DRAIN || !drain.enabled || !current_console)
+		return 0;
+
+	/* Anything that has been overwritten already is gone, skip over it. */
+	pending = drain.written - drain.drained;
+	if (pending > current_console->size) {
+		*lost = pending - current_console->size;
+		drain.drained += *lost;
+		pending = current_console->size;
+	}
+
+	len = MIN(len, pending);
+	for (i = 0; i < len; i++)
+		buf[i] = current_console->body[(drain.start + drain.drained++) %
+					       current_console->size];
+
+	return len;
 }
 
 /*
@@ -164,7 +317,21 @@ static void cbmemc_reinit(int is_recovery)
 	struct cbmem_console *previous_cons_p = current_console;
 
 	init_console_ptr(cbmem_cons_p, size);
+	if (ARCHIVE)
+		archive_init();
 	copy_console_buffer(previous_cons_p);
+
+	/* Output from before this point already went to the UART directly. */
+	if (DEFERRED_DRAIN && current_console) {
+		drain.start = current_console->cursor & CURSOR_MASK;
+		drain.written = drain.drained = 0;
+		drain.enabled = true;
+	}
+}
+
+bool cbmemc_drain_enabled(void)
+{
+	return DEFERRED_DRAIN && drain.enabled;
 }
 
 /* Run this hook early so that the console region is one of the earliest created, and
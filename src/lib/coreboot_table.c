@@ -53,18 +53,12 @@ static struct lb_header *lb_table_init(unsigned long addr)
 	header->header_bytes = sizeof(*header);
 	header->header_checksum = 0;
 	header->table_bytes = 0;
-	header->table_checksum = 0;
+	/* Updated as records are completed, starting with the checksum of no data. */
+	header->table_checksum = ipchksum(NULL, 0);
 	header->table_entries = 0;
 	return header;
 }
 
-static struct lb_record *lb_first_record(struct lb_header *header)
-{
-	struct lb_record *rec;
-	rec = (void *)(((char *)header) + sizeof(*header));
-	return rec;
-}
-
 static struct lb_record *lb_last_record(struct lb_header *header)
 {
 	struct lb_record *rec;
@@ -73,13 +67,24 @@ static struct lb_record *lb_last_record(struct lb_header *header)
 	return rec;
 }
 
+/*
+ * Records are complete once the next one is started, so each one is added to the table
+ * checksum right away instead of summing up the whole table at the end.
+ */
+static void lb_close_record(struct lb_header *header, struct lb_record *rec)
+{
+	assert(IS_ALIGNED(rec->size, LB_ENTRY_ALIGN));
+	header->table_checksum = ipchksum_add(header->table_bytes, header->table_checksum,
+					      ipchksum(rec, rec->size));
+	header->table_bytes += rec->size;
+}
+
 struct lb_record *lb_new_record(struct lb_header *header)
 {
 	struct lb_record *rec;
 	rec = lb_last_record(header);
 	if (header->table_entries) {
-		assert(IS_ALIGNED(rec->size, LB_ENTRY_ALIGN));
-		header->table_bytes += rec->size;
+		lb_close_record(header, rec);
 		rec = lb_last_record(header);
 	}
 	header->table_entries++;
@@ -132,7 +137,13 @@ static void lb_pcie(struct lb_header *header)
 {
 	struct lb_pcie pcie = { .tag = LB_TAG_PCIE, .size = sizeof(pcie) };
 
-	if (fill_lb_pcie(&pcie) != CB_SUCCESS)
+#if CONFIG(ECAM_MMCONF_SUPPORT)
+	/* Lets payloads use MMIO instead of the much slower port IO config access. */
+	pcie.ecam_base = CONFIG_ECAM_MMCONF_BASE_ADDRESS;
+	pcie.ecam_size = CONFIG_ECAM_MMCONF_LENGTH;
+#endif
+
+	if (fill_lb_pcie(&pcie) != CB_SUCCESS && !pcie.ecam_base)
 		return;
 
 	memcpy(lb_new_record(header), &pcie, sizeof(pcie));
@@ -151,7 +162,7 @@ static void lb_framebuffer(struct lb_header *header)
 	framebuffer->tag = LB_TAG_FRAMEBUFFER;
 	framebuffer->size = sizeof(*framebuffer);
 
-	if (CONFIG(BOOTSPLASH)) {
+	if (CONFIG(BOOTSPLASH) && !bootsplash_is_drawn()) {
 		uint8_t *fb_ptr = (uint8_t *)(uintptr_t)framebuffer->physical_address;
 		unsigned int width = framebuffer->x_resolution;
 		unsigned int height = framebuffer->y_resolution;
@@ -423,15 +434,11 @@ static struct lb_forward *lb_forward(struct lb_header *header,
 
 static unsigned long lb_table_fini(struct lb_header *head)
 {
-	struct lb_record *rec, *first_rec;
+	struct lb_record *rec;
 	rec = lb_last_record(head);
-	if (head->table_entries) {
-		assert(IS_ALIGNED(rec->size, LB_ENTRY_ALIGN));
-		head->table_bytes += rec->size;
-	}
+	if (head->table_entries)
+		lb_close_record(head, rec);
 
-	first_rec = lb_first_record(head);
-	head->table_checksum = ipchksum(first_rec, head->table_bytes);
 	head->header_checksum = 0;
 	head->header_checksum = ipchksum(head, sizeof(*head));
 	printk(BIOS_DEBUG,
@@ -1121,6 +1121,11 @@ int decode_edid(unsigned char *edid, int size, struct edid *out)
 		return EDID_ABSENT;
 	}
 
+	if (CONFIG(EDID_CACHE) && edid_cache_lookup(edid, size, out)) {
+		printk(BIOS_DEBUG, "EDID: Using cached decode\n");
+		return EDID_CONFORMANT;
+	}
+
 	dump_breakdown(edid);
 
 	if (memcmp(edid, "\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00", 8)) {
@@ -1604,6 +1609,10 @@ int decode_edid(unsigned char *edid, int size, struct edid *out)
 	if (c.warning_zero_preferred_refresh)
 		printk(BIOS_ERR,
 		       "Warning: CVT block does not set preferred refresh rate\n");
+
+	if (CONFIG(EDID_CACHE) && c.conformant == EDID_CONFORMANT)
+		edid_cache_store(edid, size, out);
+
 	return c.conformant;
 }
 
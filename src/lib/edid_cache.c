@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <commonlib/bsd/ipchksum.h>
+#include <commonlib/region.h>
+#include <console/console.h>
+#include <edid.h>
+#include <fmap.h>
+#include <string.h>
+#include <types.h>
+
+/*
+ * The decoded EDID of a fixed panel is kept in the RW_EDID_CACHE FMAP region
+ * together with the base block it was decoded from. The base block includes
+ * the checksum and the extension count, so a panel that still reports the
+ * same one is taken to have the same extensions too.
+ */
+#define EDID_CACHE_FMAP_NAME	"RW_EDID_CACHE"
+#define EDID_CACHE_SIGNATURE	0x31434445	/* 'EDC1' */
+#define EDID_BLOCK_SIZE		128
+
+struct edid_cache {
+	uint32_t signature;
+	/* Rejects caches written by a build with a different struct edid. */
+	uint32_t decoded_size;
+	uint32_t checksum;
+	uint8_t base_block[EDID_BLOCK_SIZE];
+	struct edid decoded;
+} __packed;
+
+static struct edid_cache cached;
+static bool cache_loaded;
+static bool cache_dirty;
+
+static uint32_t cache_checksum(const struct edid_cache *c)
+{
+	return ipchksum(&c->decoded, sizeof(c->decoded));
+}
+
+static bool cache_valid(const struct edid_cache *c)
+{
+	return c->signature == EDID_CACHE_SIGNATURE &&
+	       c->decoded_size == sizeof(c->decoded) &&
+	       c->checksum == cache_checksum(c);
+}
+
+static const struct edid_cache *load_cache(void)
+{
+	struct region_device rdev;
+
+	if (!cache_loaded) {
+		cache_loaded = true;
+		if (fmap_locate_area_as_rdev(EDID_CACHE_FMAP_NAME, &rdev) ||
+		    rdev_readat(&rdev, &cached, 0, sizeof(cached)) != sizeof(cached))
+			cached.signature = 0;
+	}
+
+	return cache_valid(&cached) ? &cached : NULL;
+}
+
+bool edid_cache_matches(const unsigned char *base_block)
+{
+	const struct edid_cache *c = load_cache();
+
+	return c && !memcmp(c->base_block, base_block, EDID_BLOCK_SIZE);
+}
+
+bool edid_cache_lookup(const unsigned char *edid, int size, struct edid *out)
+{
+	if (size < EDID_BLOCK_SIZE || !edid_cache_matches(edid))
+		return false;
+
+	memcpy(out, &cached.decoded, sizeof(*out));
+	return true;
+}
+
+void edid_cache_store(const unsigned char *edid, int size, const struct edid *decoded)
+{
+	if (size < EDID_BLOCK_SIZE || edid_cache_matches(edid))
+		return;
+
+	/* Flash is written later, so that displays come up first. */
+	memset(&cached, 0, sizeof(cached));
+	cached.signature = EDID_CACHE_SIGNATURE;
+	cached.decoded_size = sizeof(cached.decoded);
+	memcpy(cached.base_block, edid, EDID_BLOCK_SIZE);
+	memcpy(&cached.decoded, decoded, sizeof(cached.decoded));
+	/* Only set by set_display_mode(), and a pointer into this build. */
+	cached.decoded.mode.name = NULL;
+	cached.checksum = cache_checksum(&cached);
+	cache_dirty = true;
+}
+
+static void write_edid_cache(void *unused)
+{
+	struct region_device rdev;
+	size_t erase_size;
+
+	if (!cache_dirty)
+		return;
+
+	if (fmap_locate_area_as_rdev_rw(EDID_CACHE_FMAP_NAME, &rdev)) {
+		printk(BIOS_ERR, "%s: No %s FMAP section.\n", __func__,
+		       EDID_CACHE_FMAP_NAME);
+		return;
+	}
+
+	erase_size = MIN(ALIGN_UP(sizeof(cached), 4 * KiB), region_device_sz(&rdev));
+	if (sizeof(cached) > erase_size ||
+	    rdev_eraseat(&rdev, 0, erase_size) != erase_size ||
+	    rdev_writeat(&rdev, &cached, 0, sizeof(cached)) != sizeof(cached)) {
+		printk(BIOS_ERR, "Failed to write EDID cache to flash\n");
+		return;
+	}
+
+	printk(BIOS_DEBUG, "EDID cache updated\n");
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME_CHECK, BS_ON_ENTRY, write_edid_cache, NULL);
@@ -1,11 +1,24 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <cbmem.h>
+#include <commonlib/bsd/compression.h>
+#include <commonlib/endian.h>
 #include <console/console.h>
 #include <imd.h>
 #include <stage_cache.h>
 #include <string.h>
 
+/*
+ * With STAGE_CACHE_LZ4, stages are kept as an LZ4 frame of independent blocks with the
+ * content size in its header, which ulz4fn() decompresses to the load address.
+ */
+#define LZ4F_MAGIC		0x184d2204
+#define LZ4F_FLAGS		0x68	/* Version 1, independent blocks, content size */
+#define LZ4F_BLOCK_MAX		0x40	/* 64KiB */
+#define LZ4F_HEADER_SIZE	15
+#define LZ4F_UNCOMPRESSED	0x80000000
+#define LZ4F_BLOCK_SIZE		(32 * KiB)
+
 static struct imd imd_stage_cache;
 
 static void stage_cache_create_empty(void)
@@ -37,6 +50,98 @@ static void stage_cache_recover(void)
 		printk(BIOS_DEBUG, "Unable to recover external stage cache.\n");
 }
 
+/* Size of the frame if no block compresses at all. */
+static size_t lz4f_bound(size_t size)
+{
+	return LZ4F_HEADER_SIZE + DIV_ROUND_UP(size, LZ4F_BLOCK_SIZE) * sizeof(uint32_t) +
+	       size + sizeof(uint32_t);
+}
+
+static size_t lz4f_compress(const void *src, size_t size, uint8_t *dst)
+{
+	const uint8_t *in = src;
+	uint8_t *out = dst;
+	size_t offset, len, block;
+
+	write_le32(out, LZ4F_MAGIC);
+	out[4] = LZ4F_FLAGS;
+	out[5] = LZ4F_BLOCK_MAX;
+	write_le64(out + 6, size);
+	out[14] = 0;	/* Header checksum, which ulz4fn() doesn't check. */
+	out += LZ4F_HEADER_SIZE;
+
+	for (offset = 0; offset < size; offset += len) {
+		len = MIN(size - offset, LZ4F_BLOCK_SIZE);
+
+		/* Blocks that don't get smaller are stored as they are. */
+		block = lz4_compress_block(in + offset, len, out + sizeof(uint32_t), len - 1);
+		if (block) {
+			write_le32(out, block);
+		} else {
+			memcpy(out + sizeof(uint32_t), in + offset, len);
+			write_le32(out, len | LZ4F_UNCOMPRESSED);
+			block = len;
+		}
+		out += sizeof(uint32_t) + block;
+	}
+
+	/* End mark */
+	write_le32(out, 0);
+	out += sizeof(uint32_t);
+
+	return out - dst;
+}
+
+static bool stage_cache_add_compressed(struct imd *imd, int stage_id, const void *data,
+				       size_t size)
+{
+	const struct imd_entry *e;
+	void *buf, *c;
+	size_t c_size;
+
+	/*
+	 * Compress into an entry that is large enough in any case, then replace it with
+	 * one of the compressed size. It takes the place of the end of the first one.
+	 */
+	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id, lz4f_bound(size));
+	if (e == NULL)
+		return false;
+
+	buf = imd_entry_at(imd, e);
+	c_size = lz4f_compress(data, size, buf);
+
+	if (imd_entry_remove(imd, e))
+		return true;
+
+	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id, c_size);
+	if (e == NULL)
+		return false;
+
+	c = imd_entry_at(imd, e);
+	memmove(c, buf, c_size);
+
+	printk(BIOS_DEBUG, "Stage cache: Compressed %x from %zu to %zu bytes\n",
+	       CBMEM_ID_STAGEx_CACHE + stage_id, size, c_size);
+
+	return true;
+}
+
+static bool stage_cache_load_compressed(const void *c, size_t c_size, void *dest,
+					size_t *size)
+{
+	if (c_size < LZ4F_HEADER_SIZE || read_le32(c) != LZ4F_MAGIC)
+		return false;
+
+	*size = read_le64((const uint8_t *)c + 6);
+
+	if (ulz4fn(c, c_size, dest, *size) != *size) {
+		printk(BIOS_ERR, "Stage cache: Can't decompress stage\n");
+		*size = 0;
+	}
+
+	return true;
+}
+
 void stage_cache_add(int stage_id, const struct prog *stage)
 {
 	struct imd *imd;
@@ -67,6 +172,10 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 		p_size -= CONFIG_HEAP_SIZE;
 	}
 
+	if (CONFIG(STAGE_CACHE_LZ4) &&
+	    stage_cache_add_compressed(imd, stage_id, prog_start(stage), p_size))
+		return;
+
 	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id, p_size);
 
 	if (e == NULL) {
@@ -150,7 +259,13 @@ void stage_cache_load_stage(int stage_id, struct prog *stage)
 	c = imd_entry_at(imd, e);
 	size = imd_entry_size(e);
 
-	memcpy((void *)(uintptr_t)meta->load_addr, c, size);
+	/* Stages that didn't fit compressed are cached as they are. */
+	if (!CONFIG(STAGE_CACHE_LZ4) ||
+	    !stage_cache_load_compressed(c, size, (void *)(uintptr_t)meta->load_addr, &size))
+		memcpy((void *)(uintptr_t)meta->load_addr, c, size);
+
+	if (!size)
+		return;
 
 	prog_set_area(stage, (void *)(uintptr_t)meta->load_addr, size);
 	prog_set_entry(stage, (void *)(uintptr_t)meta->entry_addr,
@@ -22,9 +22,86 @@ static struct list_node compat_strings;
 
 struct compat_string_entry {
 	const char *compat_string;
+	/* Position in compat_strings, higher is preferred. */
+	int rank;
 	struct list_node list_node;
 };
 
+/*
+ * Images and board compat strings are looked up by name through hash tables, so that
+ * FIT images with hundreds of configs don't spend their time in string compares.
+ */
+struct fit_name_entry {
+	const char *name;
+	size_t len;
+	uint32_t hash;
+	void *value;
+};
+
+struct fit_name_table {
+	size_t size;
+	struct fit_name_entry *entries;
+};
+
+static struct fit_name_table image_table;
+static struct fit_name_table compat_table;
+
+static uint32_t fit_name_hash(const char *name, size_t len)
+{
+	uint32_t hash = 2166136261;
+
+	while (len--)
+		hash = (hash ^ (uint8_t)*name++) * 16777619;
+
+	return hash;
+}
+
+static void fit_name_table_init(struct fit_name_table *table, size_t count)
+{
+	table->size = 16;
+	while (table->size < 2 * count)
+		table->size *= 2;
+	table->entries = xzalloc(table->size * sizeof(*table->entries));
+}
+
+static struct fit_name_entry *fit_name_table_slot(const struct fit_name_table *table,
+						  const char *name, size_t len, uint32_t hash)
+{
+	size_t i;
+
+	for (i = hash & (table->size - 1); table->entries[i].name;
+	     i = (i + 1) & (table->size - 1)) {
+		struct fit_name_entry *e = &table->entries[i];
+
+		if (e->hash == hash && e->len == len && !memcmp(e->name, name, len))
+			break;
+	}
+
+	return &table->entries[i];
+}
+
+/* Add a name to the table, replacing the value of an earlier entry with the same name. */
+static void fit_name_table_add(struct fit_name_table *table, const char *name, void *value)
+{
+	const size_t len = strlen(name);
+	const uint32_t hash = fit_name_hash(name, len);
+	struct fit_name_entry *e = fit_name_table_slot(table, name, len, hash);
+
+	e->name = name;
+	e->len = len;
+	e->hash = hash;
+	e->value = value;
+}
+
+static void *fit_name_table_find(const struct fit_name_table *table, const char *name,
+				 size_t len)
+{
+	if (!table->size)
+		return NULL;
+
+	return fit_name_table_slot(table, name, len, fit_name_hash(name, len))->value;
+}
+
 /* Convert string to lowercase and replace '_' and spaces with '-'. */
 static char *clean_compat_string(char *str)
 {
@@ -72,11 +149,10 @@ static void fit_add_default_compat_strings(void)
 
 static struct fit_image_node *find_image(const char *name)
 {
-	struct fit_image_node *image;
-	list_for_each(image, image_nodes, list_node) {
-		if (!strcmp(image->name, name))
-			return image;
-	}
+	struct fit_image_node *image = fit_name_table_find(&image_table, name,
+							   strlen(name));
+	if (image)
+		return image;
 	printk(BIOS_ERR, "Cannot find image node %s!\n", name);
 	return NULL;
 }
@@ -159,10 +235,19 @@ static void fit_unpack(struct device_tree *tree, const char **default_config)
 	struct device_tree_node *child;
 	struct device_tree_node *images = dt_find_node_by_path(tree, "/images",
 							       NULL, NULL, 0);
+	size_t count = 0;
+	struct fit_image_node *image;
+
 	if (images)
 		list_for_each(child, images->children, list_node)
 			image_node(child);
 
+	list_for_each(image, image_nodes, list_node)
+		count++;
+	fit_name_table_init(&image_table, count);
+	list_for_each(image, image_nodes, list_node)
+		fit_name_table_add(&image_table, image->name, image);
+
 	struct device_tree_node *configs = dt_find_node_by_path(tree,
 		"/configurations", NULL, NULL, 0);
 	if (configs) {
@@ -194,22 +279,6 @@ static int fdt_find_compat(const void *blob, uint32_t start_offset,
 	return -1;
 }
 
-static int fit_check_compat(struct fdt_property *compat_prop,
-			    const char *compat_name)
-{
-	int bytes = compat_prop->size;
-	const char *compat_str = compat_prop->data;
-
-	for (int pos = 0; bytes && compat_str[0]; pos++) {
-		if (!strncmp(compat_str, compat_name, bytes))
-			return pos;
-		int len = strlen(compat_str) + 1;
-		compat_str += len;
-		bytes -= len;
-	}
-	return -1;
-}
-
 void fit_update_chosen(struct device_tree *tree, const char *cmd_line)
 {
 	const char *path[] = { "chosen", NULL };
@@ -219,6 +288,16 @@ void fit_update_chosen(struct device_tree *tree, const char *cmd_line)
 	dt_add_string_prop(node, "bootargs", cmd_line);
 }
 
+int fit_update_chosen_flat(void *fdt, size_t buf_size, const char *cmd_line)
+{
+	uint32_t node = fdt_add_node_by_path(fdt, buf_size, "/chosen", NULL, NULL);
+
+	if (!node)
+		return -1;
+
+	return fdt_set_prop(fdt, buf_size, node, "bootargs", cmd_line, strlen(cmd_line) + 1);
+}
+
 void fit_add_ramdisk(struct device_tree *tree, void *ramdisk_addr,
 		     size_t ramdisk_size)
 {
@@ -233,6 +312,23 @@ void fit_add_ramdisk(struct device_tree *tree, void *ramdisk_addr,
 	dt_add_u64_prop(node, "linux,initrd-end", end);
 }
 
+int fit_add_ramdisk_flat(void *fdt, size_t buf_size, void *ramdisk_addr,
+			 size_t ramdisk_size)
+{
+	uint32_t node = fdt_add_node_by_path(fdt, buf_size, "/chosen", NULL, NULL);
+	u64 start = htobe64((uintptr_t)ramdisk_addr);
+	u64 end = htobe64((uintptr_t)ramdisk_addr + ramdisk_size);
+
+	if (!node)
+		return -1;
+
+	if (fdt_set_prop(fdt, buf_size, node, "linux,initrd-start", &start, sizeof(start)))
+		return -1;
+
+	/* Setting the first property may have moved the node's children, but not the node. */
+	return fdt_set_prop(fdt, buf_size, node, "linux,initrd-end", &end, sizeof(end));
+}
+
 static void update_reserve_map(uint64_t start, uint64_t end,
 			       struct device_tree *tree)
 {
@@ -308,12 +404,52 @@ void fit_add_compat_string(const char *str)
 	list_insert_after(&compat_node->list_node, &compat_strings);
 }
 
+/*
+ * Collect the memory the OS may use and encode its RAM ranges as the 'reg' property of a
+ * memory node. The caller tears down the ranges in map.
+ */
+static void *memory_reg_data(struct mem_map *map, u32 addr_cells, u32 size_cells,
+			     size_t *length)
+{
+	const struct range_entry *r;
+
+	memranges_init_empty(&map->mem, NULL, 0);
+	memranges_init_empty(&map->reserved, NULL, 0);
+
+	bootmem_walk_os_mem(walk_memory_table, map);
+
+	/*
+	 * Count the amount of 'reg' entries we need (account for size limits).
+	 */
+	size_t count = 0;
+	memranges_each_entry(r, &map->mem) {
+		uint64_t size = range_entry_size(r);
+		uint64_t max_size = max_range(size_cells);
+		count += DIV_ROUND_UP(size, max_size);
+	}
+
+	/* Allocate the right amount of space and fill up the entries. */
+	*length = count * (addr_cells + size_cells) * sizeof(u32);
+
+	void *data = xzalloc(*length);
+
+	struct entry_params add_params = { addr_cells, size_cells, data };
+	memranges_each_entry(r, &map->mem) {
+		update_mem_property(range_entry_base(r), range_entry_end(r),
+				    &add_params);
+	}
+	assert(add_params.data - data == *length);
+
+	return data;
+}
+
 void fit_update_memory(struct device_tree *tree)
 {
 	const struct range_entry *r;
 	struct device_tree_node *node;
 	u32 addr_cells = 1, size_cells = 1;
 	struct mem_map map;
+	size_t length;
 
 	printk(BIOS_INFO, "FIT: Updating devicetree memory entries\n");
 
@@ -325,7 +461,7 @@ void fit_update_memory(struct device_tree *tree)
 	list_for_each(node, tree->root->children, list_node) {
 		const char *devtype = dt_find_string_prop(node, "device_type");
 		if (devtype && !strcmp(devtype, "memory"))
-			list_remove(&node->list_node);
+			dt_delete_node(node);
 	}
 
 	node = xzalloc(sizeof(*node));
@@ -334,10 +470,7 @@ void fit_update_memory(struct device_tree *tree)
 	list_insert_after(&node->list_node, &tree->root->children);
 	dt_add_string_prop(node, "device_type", (char *)"memory");
 
-	memranges_init_empty(&map.mem, NULL, 0);
-	memranges_init_empty(&map.reserved, NULL, 0);
-
-	bootmem_walk_os_mem(walk_memory_table, &map);
+	void *data = memory_reg_data(&map, addr_cells, size_cells, &length);
 
 	/* CBMEM regions are both carved out and explicitly reserved. */
 	memranges_each_entry(r, &map.reserved) {
@@ -345,33 +478,69 @@ void fit_update_memory(struct device_tree *tree)
 				   tree);
 	}
 
+	/* Assemble the final property and add it to the device tree. */
+	dt_add_bin_prop(node, "reg", data, length);
+
+	memranges_teardown(&map.mem);
+	memranges_teardown(&map.reserved);
+}
+
+int fit_update_memory_flat(void *fdt, size_t buf_size)
+{
+	const struct fdt_header *header = fdt;
+	const uint32_t root = be32toh(header->structure_offset);
+	const struct range_entry *r;
+	u32 addr_cells = 1, size_cells = 1;
+	struct fdt_property prop;
+	struct mem_map map;
+	uint32_t offset, node;
+	size_t length;
+	int size, ret = -1;
+
+	printk(BIOS_INFO, "FIT: Updating devicetree memory entries\n");
+
+	if (fdt_read_prop(fdt, root, "#address-cells", &prop))
+		addr_cells = be32dec(prop.data);
+	if (fdt_read_prop(fdt, root, "#size-cells", &prop))
+		size_cells = be32dec(prop.data);
+
 	/*
-	 * Count the amount of 'reg' entries we need (account for size limits).
+	 * First remove all existing device_type="memory" nodes, then add ours.
 	 */
-	size_t count = 0;
-	memranges_each_entry(r, &map.mem) {
-		uint64_t size = range_entry_size(r);
-		uint64_t max_size = max_range(size_cells);
-		count += DIV_ROUND_UP(size, max_size);
+	offset = root + fdt_next_node_name(fdt, root, NULL);
+	while ((size = fdt_next_property(fdt, offset, NULL)))
+		offset += size;
+	while (fdt_next_node_name(fdt, offset, NULL)) {
+		if (fdt_read_prop(fdt, offset, "device_type", &prop) && prop.size &&
+		    !strcmp(prop.data, "memory"))
+			fdt_delete_node(fdt, offset);
+		else
+			offset += fdt_skip_node(fdt, offset);
 	}
 
-	/* Allocate the right amount of space and fill up the entries. */
-	size_t length = count * (addr_cells + size_cells) * sizeof(u32);
+	node = fdt_add_node(fdt, buf_size, root, "memory");
+	if (!node || fdt_set_prop(fdt, buf_size, node, "device_type", "memory",
+				  sizeof("memory")))
+		return -1;
 
-	void *data = xzalloc(length);
+	void *data = memory_reg_data(&map, addr_cells, size_cells, &length);
 
-	struct entry_params add_params = { addr_cells, size_cells, data };
-	memranges_each_entry(r, &map.mem) {
-		update_mem_property(range_entry_base(r), range_entry_end(r),
-				    &add_params);
-	}
-	assert(add_params.data - data == length);
+	if (fdt_set_prop(fdt, buf_size, node, "reg", data, length))
+		goto out;
 
-	/* Assemble the final property and add it to the device tree. */
-	dt_add_bin_prop(node, "reg", data, length);
+	/* CBMEM regions are both carved out and explicitly reserved. */
+	memranges_each_entry(r, &map.reserved) {
+		if (fdt_add_reserve_map_entry(fdt, buf_size, range_entry_base(r),
+					      range_entry_size(r)))
+			goto out;
+	}
 
+	ret = 0;
+out:
+	free(data);
 	memranges_teardown(&map.mem);
 	memranges_teardown(&map.reserved);
+	return ret;
 }
 
 /*
@@ -410,20 +579,22 @@ static int fit_update_compat(struct fit_config_node *config)
 		}
 	}
 
+	/* The best match is the highest ranked board compat string, at its first position. */
 	config->compat_pos = -1;
 	config->compat_rank = -1;
-	size_t i = 0;
-	struct compat_string_entry *compat_node;
-	list_for_each(compat_node, compat_strings, list_node) {
-		int pos = fit_check_compat(&config->compat,
-					   compat_node->compat_string);
-		if (pos >= 0) {
+	int bytes = config->compat.size;
+	const char *compat_str = config->compat.data;
+	for (int pos = 0; bytes > 0 && compat_str[0]; pos++) {
+		size_t len = strnlen(compat_str, bytes);
+		struct compat_string_entry *compat_node =
+			fit_name_table_find(&compat_table, compat_str, len);
+		if (compat_node && compat_node->rank > config->compat_rank) {
 			config->compat_pos = pos;
-			config->compat_rank = i;
-			config->compat_string =
-				compat_node->compat_string;
+			config->compat_rank = compat_node->rank;
+			config->compat_string = compat_node->compat_string;
 		}
-		i++;
+		compat_str += len + 1;
+		bytes -= len + 1;
 	}
 
 	return 0;
@@ -460,10 +631,16 @@ struct fit_config_node *fit_load(void *fit)
 	printk(BIOS_DEBUG, "FIT: Compat preference "
 	       "(lowest to highest priority) :");
 
+	int rank = 0;
 	list_for_each(compat_node, compat_strings, list_node) {
 		printk(BIOS_DEBUG, " %s", compat_node->compat_string);
+		compat_node->rank = rank++;
 	}
 	printk(BIOS_DEBUG, "\n");
+
+	fit_name_table_init(&compat_table, rank);
+	list_for_each(compat_node, compat_strings, list_node)
+		fit_name_table_add(&compat_table, compat_node->compat_string, compat_node);
 	/* Process and list the configs. */
 	list_for_each(config, config_nodes, list_node) {
 		if (!config->kernel) {
@@ -13,6 +13,10 @@
 #include <string.h>
 #include <lib.h>
 #include <boardid.h>
+#include <endian.h>
+
+/* Room for the fixups fit_payload() applies to a flattened tree in place. */
+#define FDT_EDIT_SLACK		(16 * KiB)
 
 /* Pack the device_tree and place it at given position. */
 static void pack_fdt(struct region *fdt, struct device_tree *dt)
@@ -24,6 +28,15 @@ static void pack_fdt(struct region *fdt, struct device_tree *dt)
 	prog_segment_loaded(fdt->offset, fdt->size, 0);
 }
 
+/* Copy the patched FDT to given position. */
+static void place_fdt(struct region *fdt, const void *blob)
+{
+	printk(BIOS_INFO, "FIT: Placing FDT at %p\n", (void *)fdt->offset);
+
+	memcpy((void *)fdt->offset, blob, fdt->size);
+	prog_segment_loaded(fdt->offset, fdt->size, 0);
+}
+
 /**
  * Extract a node to given regions.
  * Returns true on error, false on success.
@@ -102,6 +115,28 @@ static struct device_tree *unpack_fdt(struct fit_image_node *image_node)
 	return fdt_unflatten(data);
 }
 
+/*
+ * Copy or decompress the FDT into a buffer with room to apply the fixups to the flattened
+ * tree. Returns NULL if that isn't possible.
+ */
+static void *unpack_fdt_flat(struct fit_image_node *image_node, size_t *buf_size)
+{
+	/* Same heuristic for the decompressed size as in unpack_fdt(). */
+	struct region r = { .offset = 0, .size = image_node->size };
+	void *data;
+
+	if (image_node->compression != CBFS_COMPRESS_NONE)
+		r.size *= 5;
+
+	*buf_size = r.size + FDT_EDIT_SLACK;
+	data = malloc(*buf_size);
+	r.offset = (uintptr_t)data;
+	if (!data || extract(&r, image_node) || !fdt_is_editable(data, *buf_size))
+		return NULL;
+
+	return data;
+}
+
 /**
  * Add coreboot tables, CBMEM information and optional board specific strapping
  * IDs to the device tree loaded via FIT.
@@ -163,6 +198,104 @@ static void add_cb_fdt_data(struct device_tree *tree)
 		dt_add_u32_prop(coreboot_node, "ram-code", ram_code());
 }
 
+static int add_u32_prop_flat(void *blob, size_t buf_size, uint32_t node, const char *name,
+			     u32 val)
+{
+	val = htobe32(val);
+	return fdt_set_prop(blob, buf_size, node, name, &val, sizeof(val));
+}
+
+/* Same as add_cb_fdt_data(), but for a flattened tree. Returns 0 on success. */
+static int add_cb_fdt_data_flat(void *blob, size_t buf_size)
+{
+	u32 addr_cells = 1, size_cells = 1;
+	u8 reg[2 * 4 * sizeof(u32)], *data = reg;
+	uint32_t firmware_node, coreboot_node;
+	void *baseptr = NULL;
+	size_t size = 0;
+
+	firmware_node = fdt_add_node_by_path(blob, buf_size, "/firmware", &addr_cells,
+					     &size_cells);
+
+	/* Need to add 'ranges' to the intermediate node to make 'reg' work. */
+	if (!firmware_node || fdt_set_prop(blob, buf_size, firmware_node, "ranges", NULL, 0))
+		return -1;
+
+	coreboot_node = fdt_add_node_by_path(blob, buf_size, "/firmware/coreboot",
+					     &addr_cells, &size_cells);
+	if (!coreboot_node || fdt_set_prop(blob, buf_size, coreboot_node, "compatible",
+					   "coreboot", sizeof("coreboot")))
+		return -1;
+
+	/* Fetch CB tables from cbmem */
+	void *cbtable = cbmem_find(CBMEM_ID_CBTABLE);
+	if (!cbtable) {
+		printk(BIOS_WARNING, "FIT: No coreboot table found!\n");
+		return 0;
+	}
+
+	cbmem_get_region(&baseptr, &size);
+	if (!baseptr || size == 0) {
+		printk(BIOS_WARNING, "FIT: CBMEM pointer/size not found!\n");
+		return 0;
+	}
+
+	if (addr_cells > 2 || size_cells > 2)
+		return -1;
+
+	/* The coreboot table, followed by the CBMEM area (which usually includes it). */
+	const struct lb_header *header = cbtable;
+	dt_write_int(data, (uintptr_t)header, addr_cells * sizeof(u32));
+	data += addr_cells * sizeof(u32);
+	dt_write_int(data, header->header_bytes + header->table_bytes,
+		     size_cells * sizeof(u32));
+	data += size_cells * sizeof(u32);
+	dt_write_int(data, (uintptr_t)baseptr, addr_cells * sizeof(u32));
+	data += addr_cells * sizeof(u32);
+	dt_write_int(data, size, size_cells * sizeof(u32));
+	data += size_cells * sizeof(u32);
+
+	if (fdt_set_prop(blob, buf_size, coreboot_node, "reg", reg, data - reg))
+		return -1;
+
+	/* Expose board ID, SKU ID, and RAM code to payload.*/
+	if (board_id() != UNDEFINED_STRAPPING_ID &&
+	    add_u32_prop_flat(blob, buf_size, coreboot_node, "board-id", board_id()))
+		return -1;
+
+	if (sku_id() != UNDEFINED_STRAPPING_ID &&
+	    add_u32_prop_flat(blob, buf_size, coreboot_node, "sku-id", sku_id()))
+		return -1;
+
+	if (ram_code() != UNDEFINED_STRAPPING_ID &&
+	    add_u32_prop_flat(blob, buf_size, coreboot_node, "ram-code", ram_code()))
+		return -1;
+
+	return 0;
+}
+
+/* Apply the fixups to a flattened FDT. Returns false if they don't fit into the buffer. */
+static bool fixup_fdt_flat(struct fit_config_node *config, void *blob, size_t buf_size)
+{
+	/* Insert coreboot specific information */
+	if (add_cb_fdt_data_flat(blob, buf_size))
+		return false;
+
+	/* Update device_tree */
+#if defined(CONFIG_LINUX_COMMAND_LINE)
+	if (fit_update_chosen_flat(blob, buf_size, (char *)CONFIG_LINUX_COMMAND_LINE))
+		return false;
+#endif
+	if (fit_update_memory_flat(blob, buf_size))
+		return false;
+
+	/* Add the initrd properties now so that the tree doesn't grow after it was placed. */
+	if (config->ramdisk && fit_add_ramdisk_flat(blob, buf_size, NULL, 0))
+		return false;
+
+	return true;
+}
+
 /*
  * Parse the uImage FIT, choose a configuration and extract images.
  */
@@ -170,6 +303,8 @@ void fit_payload(struct prog *payload, void *data)
 {
 	struct device_tree *dt = NULL;
 	struct region kernel = {0}, fdt = {0}, initrd = {0};
+	void *blob = NULL;
+	size_t blob_size;
 
 	printk(BIOS_INFO, "FIT: Examine payload %s\n", payload->name);
 
@@ -180,37 +315,64 @@ void fit_payload(struct prog *payload, void *data)
 		return;
 	}
 
-	dt = unpack_fdt(config->fdt);
-	if (!dt) {
-		printk(BIOS_ERR, "Failed to unflatten the FDT.\n");
-		return;
+	/*
+	 * Without overlays and board fixups, which need the unflattened tree, the few fixups
+	 * left can be applied to the flattened one.
+	 */
+	if (!config->overlays.next && !device_tree_fixups.next) {
+		blob = unpack_fdt_flat(config->fdt, &blob_size);
+		if (blob && !fixup_fdt_flat(config, blob, blob_size)) {
+			printk(BIOS_INFO, "FIT: FDT fixups don't fit, unflattening\n");
+			free(blob);
+			blob = NULL;
+		}
 	}
 
-	struct fit_overlay_chain *chain;
-	list_for_each(chain, config->overlays, list_node) {
-		struct device_tree *overlay = unpack_fdt(chain->overlay);
-		if (!overlay || dt_apply_overlay(dt, overlay)) {
-			printk(BIOS_ERR, "Failed to apply overlay %s!\n",
-			       chain->overlay->name);
+	if (!blob) {
+		dt = unpack_fdt(config->fdt);
+		if (!dt) {
+			printk(BIOS_ERR, "Failed to unflatten the FDT.\n");
+			return;
 		}
-	}
 
-	dt_apply_fixups(dt);
+		struct fit_overlay_chain *chain;
+		list_for_each(chain, config->overlays, list_node) {
+			struct device_tree *overlay = unpack_fdt(chain->overlay);
+			if (!overlay || dt_apply_overlay(dt, overlay)) {
+				printk(BIOS_ERR, "Failed to apply overlay %s!\n",
+				       chain->overlay->name);
+			}
+		}
 
-	/* Insert coreboot specific information */
-	add_cb_fdt_data(dt);
+		dt_apply_fixups(dt);
 
-	/* Update device_tree */
+		/* Insert coreboot specific information */
+		add_cb_fdt_data(dt);
+
+		/* Update device_tree */
 #if defined(CONFIG_LINUX_COMMAND_LINE)
-	fit_update_chosen(dt, (char *)CONFIG_LINUX_COMMAND_LINE);
+		fit_update_chosen(dt, (char *)CONFIG_LINUX_COMMAND_LINE);
 #endif
-	fit_update_memory(dt);
+		fit_update_memory(dt);
+	}
 
 	/* Collect infos for fit_payload_arch */
 	kernel.size = config->kernel->size;
-	fdt.size = dt_flat_size(dt);
+	if (blob)
+		fdt.size = be32toh(((struct fdt_header *)blob)->totalsize);
+	else
+		fdt.size = dt_flat_size(dt);
 	initrd.size = config->ramdisk ? config->ramdisk->size : 0;
 
+	/*
+	 * An uncompressed ramdisk in memory that is already reserved for the payload (see
+	 * payload_load()) doesn't need to be copied.
+	 */
+	if (config->ramdisk && config->ramdisk->compression == CBFS_COMPRESS_NONE &&
+	    bootmem_region_targets_type((uintptr_t)config->ramdisk->data, initrd.size,
+					BM_MEM_PAYLOAD))
+		initrd.offset = (uintptr_t)config->ramdisk->data;
+
 	/* Invoke arch specific payload placement and fixups */
 	if (!fit_payload_arch(payload, config, &kernel, &fdt, &initrd)) {
 		printk(BIOS_ERR, "Failed to find free memory region\n");
@@ -218,15 +380,24 @@ void fit_payload(struct prog *payload, void *data)
 		return;
 	}
 
-	/* Update ramdisk location in FDT */
-	if (config->ramdisk)
-		fit_add_ramdisk(dt, (void *)initrd.offset, initrd.size);
-
-	/* Repack FDT for handoff to kernel */
-	pack_fdt(&fdt, dt);
+	/* Update ramdisk location in FDT and hand it off to the kernel */
+	if (blob) {
+		/* The properties exist already, so this can't fail. */
+		if (config->ramdisk)
+			fit_add_ramdisk_flat(blob, blob_size, (void *)initrd.offset,
+					     initrd.size);
+		place_fdt(&fdt, blob);
+	} else {
+		if (config->ramdisk)
+			fit_add_ramdisk(dt, (void *)initrd.offset, initrd.size);
+		pack_fdt(&fdt, dt);
+	}
 
-	if (config->ramdisk &&
-	    extract(&initrd, config->ramdisk)) {
+	if (config->ramdisk && initrd.offset == (uintptr_t)config->ramdisk->data) {
+		printk(BIOS_INFO, "FIT: Leaving %s in place at %p\n",
+		       config->ramdisk->name, config->ramdisk->data);
+	} else if (config->ramdisk &&
+		   extract(&initrd, config->ramdisk)) {
 		printk(BIOS_ERR, "Failed to extract initrd\n");
 		prog_set_entry(payload, NULL, NULL);
 		return;
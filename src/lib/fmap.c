@@ -2,6 +2,7 @@
 
 #include <boot_device.h>
 #include <cbmem.h>
+#include <commonlib/bsd/fmap_index.h>
 #include <console/console.h>
 #include <fmap.h>
 #include <metadata_hash.h>
@@ -18,6 +19,9 @@
 
 static int fmap_print_once;
 static struct region_device fmap_cache;
+/* The CBMEM copy of the FMAP, used for the hash index lookups if it has one. */
+static const struct fmap *fmap_cbmem;
+static size_t fmap_cbmem_size;
 
 #define print_once(...) do { \
 		if (!fmap_print_once) \
@@ -176,6 +180,23 @@ int fmap_locate_area(const char *name, struct region *ar)
 	if (name == NULL || ar == NULL)
 		return -1;
 
+	if (fmap_cbmem) {
+		const struct fmap_area *area;
+		enum cb_err err = fmap_index_find(fmap_cbmem, fmap_cbmem_size, name, &area);
+
+		if (err == CB_SUCCESS) {
+			printk(BIOS_DEBUG, "FMAP: area %s found @ %x (%d bytes)\n",
+			       name, le32toh(area->offset), le32toh(area->size));
+			ar->offset = le32toh(area->offset);
+			ar->size = le32toh(area->size);
+			return 0;
+		}
+		if (err == CB_ERR) {
+			printk(BIOS_DEBUG, "FMAP: area %s not found\n", name);
+			return -1;
+		}
+	}
+
 	if (find_fmap_directory(&fmrd))
 		return -1;
 
@@ -291,6 +312,8 @@ static void fmap_register_cbmem_cache(void)
 		return;
 
 	rdev_chain_mem(&fmap_cache, cbmem_entry_start(e), cbmem_entry_size(e));
+	fmap_cbmem = cbmem_entry_start(e);
+	fmap_cbmem_size = cbmem_entry_size(e);
 }
 
 /*
@@ -300,13 +323,21 @@ static void fmap_register_cbmem_cache(void)
 static void fmap_add_cbmem_cache(void)
 {
 	struct region_device fmrd;
+	struct fmap hdr;
 
 	if (find_fmap_directory(&fmrd))
 		return;
 
 	/* Reloads the FMAP even on ACPI S3 resume */
 	const size_t s = region_device_sz(&fmrd);
-	struct fmap *fmap = cbmem_add(CBMEM_ID_FMAP, s);
+	if (rdev_readat(&fmrd, &hdr, 0, sizeof(hdr)) != sizeof(hdr)) {
+		printk(BIOS_ERR, "Failed to read FMAP header\n");
+		return;
+	}
+
+	/* The hash index for payloads and the OS goes after the (unmodified) FMAP region. */
+	const size_t total = ALIGN_UP(s, sizeof(uint32_t)) + fmap_index_size(&hdr);
+	struct fmap *fmap = cbmem_add(CBMEM_ID_FMAP, total);
 	if (!fmap) {
 		printk(BIOS_ERR, "Failed to allocate CBMEM\n");
 		return;
@@ -318,6 +349,9 @@ static void fmap_add_cbmem_cache(void)
 		cbmem_entry_remove(cbmem_entry_find(CBMEM_ID_FMAP));
 		return;
 	}
+
+	if (fmap_index_build(fmap, total) != CB_SUCCESS)
+		printk(BIOS_WARNING, "FMAP: Could not build the area index\n");
 }
 
 static void fmap_setup_cbmem_cache(int unused)
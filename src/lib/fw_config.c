@@ -72,6 +72,22 @@ uint64_t fw_config_get_field(const struct fw_config_field *field)
 	return value;
 }
 
+static bool probe_matches(uint64_t fw_config, const struct fw_config *match)
+{
+	return (fw_config & match->mask) == match->value;
+}
+
+static void print_match(const struct fw_config *match)
+{
+	if (match->field_name && match->option_name)
+		printk(BIOS_INFO, "fw_config match found: %s=%s\n", match->field_name,
+		       match->option_name);
+	else
+		printk(BIOS_INFO, "fw_config match found: mask=0x%" PRIx64 " value=0x%"
+		       PRIx64 "\n",
+		       match->mask, match->value);
+}
+
 bool fw_config_probe(const struct fw_config *match)
 {
 	/* If fw_config is not provisioned, then there is nothing to match. */
@@ -79,23 +95,23 @@ bool fw_config_probe(const struct fw_config *match)
 		return false;
 
 	/* Compare to system value. */
-	if ((fw_config_get() & match->mask) == match->value) {
-		if (match->field_name && match->option_name)
-			printk(BIOS_INFO, "fw_config match found: %s=%s\n", match->field_name,
-			       match->option_name);
-		else
-			printk(BIOS_INFO, "fw_config match found: mask=0x%" PRIx64 " value=0x%"
-			       PRIx64 "\n",
-			       match->mask, match->value);
+	if (probe_matches(fw_config_get(), match)) {
+		print_match(match);
 		return true;
 	}
 
 	return false;
 }
 
+/*
+ * Devices are probed a lot (is_dev_enabled() in early stages, for each device in
+ * ramstage), so this compares the mask/value pairs sconfig generated against a single
+ * fw_config value and doesn't log. fw_config_init() logs the matches once.
+ */
 bool fw_config_probe_dev(const struct device *dev, const struct fw_config **matching_probe)
 {
 	const struct fw_config *probe;
+	uint64_t fw_config;
 
 	if (matching_probe)
 		*matching_probe = NULL;
@@ -104,8 +120,13 @@ bool fw_config_probe_dev(const struct device *dev, const struct fw_config **matc
 	if (!dev->probe_list)
 		return true;
 
-	for (probe = dev->probe_list; probe && probe->mask != 0; probe++) {
-		if (!fw_config_probe(probe))
+	/* If fw_config is not provisioned, then there is nothing to match. */
+	if (!fw_config_is_provisioned())
+		return false;
+
+	fw_config = fw_config_get();
+	for (probe = dev->probe_list; probe->mask != 0; probe++) {
+		if (!probe_matches(fw_config, probe))
 			continue;
 
 		if (matching_probe)
@@ -164,8 +185,10 @@ static void fw_config_init(void *unused)
 			continue;
 		}
 
-		if (probe)
+		if (probe) {
+			print_match(probe);
 			cached_configs[probe_index(probe->mask)] = probe;
+		}
 	}
 }
 BOOT_STATE_INIT_ENTRY(BS_DEV_INIT_CHIPS, BS_ON_ENTRY, fw_config_init, NULL);
@@ -1,119 +1,157 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
-#include <stdint.h>
 #include <bootstate.h>
 #include <cbmem.h>
+#include <commonlib/coverage_serialized.h>
+#include <stdbool.h>
+#include <stdint.h>
 
-typedef struct file {
-	uint32_t magic;
-	struct file *next;
-	char *filename;
-	char *data;
-	int offset;
-	int len;
-} FILE;
+/*
+ * Instead of writing .gcda files through an emulated file API, the counters of all
+ * objects are dumped in the compact format of coverage_serialized.h. The dump is sized
+ * in a first pass, so it always fits into its CBMEM entry.
+ */
 
-#define SEEK_SET       0       /* Seek from beginning of file.  */
+struct coverage_writer {
+	uint32_t *buf;		/* NULL while sizing */
+	size_t words;
+};
 
-#define DIR_SEPARATOR '/'
-#define IS_DIR_SEPARATOR(ch) ((ch) == DIR_SEPARATOR)
-#define HAS_DRIVE_SPEC(f) (0)
+static void put(struct coverage_writer *w, uint32_t value)
+{
+	if (w->buf)
+		w->buf[w->words] = value;
+	w->words++;
+}
 
-#define COVERAGE_SIZE (32*1024)
+static void put_string(struct coverage_writer *w, const char *s)
+{
+	const size_t len = strlen(s) + 1;
+	size_t i;
 
-#define COVERAGE_MAGIC 0x584d4153
+	for (i = 0; i < len; i += sizeof(uint32_t)) {
+		uint32_t word = 0;
 
-static FILE *current_file = NULL;
-static FILE *previous_file = NULL;
+		memcpy(&word, s + i, MIN(len - i, sizeof(word)));
+		put(w, word);
+	}
+}
 
-static FILE *fopen(const char *path, const char *mode)
+static bool counters_are_zero(const struct gcov_ctr_info *ci)
 {
-#if CONFIG(DEBUG_COVERAGE)
-	printk(BIOS_DEBUG, "%s %s with mode %s\n", __func__, path, mode);
-#endif
-	if (!current_file) {
-		current_file = cbmem_add(CBMEM_ID_COVERAGE, 32*1024);
-	} else {
-		previous_file = current_file;
-		current_file =
-			(FILE *)(ALIGN_UP(((unsigned long)previous_file->data
-			+ previous_file->len), 16));
-	}
+	gcov_unsigned_t i;
 
-	// TODO check if we're at the end of the CBMEM region (ENOMEM)
-	if (current_file) {
-		current_file->magic = COVERAGE_MAGIC;
-		current_file->next = NULL;
-		if (previous_file)
-			previous_file->next = current_file;
-		current_file->filename = (char *)&current_file[1];
-		strcpy(current_file->filename, path);
-		current_file->data =
-			(char *)ALIGN_UP(((unsigned long)current_file->filename
-			+ strlen(path) + 1), 16);
-		current_file->offset = 0;
-		current_file->len = 0;
-	}
+	for (i = 0; i < ci->num; i++)
+		if (ci->values[i])
+			return false;
 
-	return current_file;
+	return true;
 }
 
-static int fclose(FILE *stream)
+static void put_function(struct coverage_writer *w, const struct gcov_info *gi,
+			 const struct gcov_fn_info *gfi)
 {
-#if CONFIG(DEBUG_COVERAGE)
-	printk(BIOS_DEBUG, "%s %s\n", __func__, stream->filename);
-#endif
-	return 0;
-}
+	const struct gcov_ctr_info *ci;
+	unsigned int t_ix;
 
-static int fseek(FILE *stream, long offset, int whence)
-{
-	/* fseek should only be called with offset==0 and whence==SEEK_SET
-	 * to a freshly opened file. */
-	gcc_assert(offset == 0 && whence == SEEK_SET);
-#if CONFIG(DEBUG_COVERAGE)
-	printk(BIOS_DEBUG, "%s %s offset=%ld whence=%d\n",
-		__func__, stream->filename, offset, whence);
-#endif
-	return 0;
-}
+	if (!gfi || gfi->key != gi) {
+		put(w, 0);
+		return;
+	}
 
-static long ftell(FILE *stream)
-{
-	/* ftell should currently not be called */
-	BUG();
-#if CONFIG(DEBUG_COVERAGE)
-	printk(BIOS_DEBUG, "%s %s\n", __func__, stream->filename);
-#endif
-	return 0;
+	put(w, 1);
+	put(w, gfi->ident);
+	put(w, gfi->lineno_checksum);
+	put(w, gfi->cfg_checksum);
+
+	ci = gfi->ctrs;
+	for (t_ix = 0; t_ix < GCOV_COUNTERS; t_ix++) {
+		gcov_unsigned_t i;
+
+		if (!gi->merge[t_ix])
+			continue;
+
+		if (counters_are_zero(ci)) {
+			put(w, ci->num | COVERAGE_CTR_ZERO);
+			ci++;
+			continue;
+		}
+
+		put(w, ci->num);
+		for (i = 0; i < ci->num; i++) {
+			put(w, (uint64_t)ci->values[i]);
+			put(w, (uint64_t)ci->values[i] >> 32);
+		}
+		ci++;
+	}
 }
 
-static size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
+static void coverage_serialize(struct coverage_writer *w)
 {
-#if CONFIG(DEBUG_COVERAGE)
-	printk(BIOS_DEBUG, "%s: ptr=%p size=%zd nmemb=%zd FILE*=%p\n",
-		__func__, ptr, size, nmemb, stream);
-#endif
-	return 0;
-}
+	const struct gcov_info *gi;
+	uint32_t num_objects = 0;
+
+	w->words = sizeof(struct coverage_header) / sizeof(uint32_t);
+
+	for (gi = gcov_list; gi; gi = gi->next) {
+		const size_t start = w->words;
+		uint32_t ctr_mask = 0;
+		unsigned int t_ix, f_ix;
+
+		for (t_ix = 0; t_ix < GCOV_COUNTERS; t_ix++)
+			if (gi->merge[t_ix])
+				ctr_mask |= 1 << t_ix;
+
+		put(w, 0);	/* size, filled in below */
+		put(w, GCOV_VERSION);
+		put(w, gi->stamp);
+		put(w, gi->n_functions);
+		put(w, ctr_mask);
+		put(w, ALIGN_UP(strlen(gi->filename) + 1, sizeof(uint32_t)));
+		put_string(w, gi->filename);
+
+		for (f_ix = 0; f_ix < gi->n_functions; f_ix++)
+			put_function(w, gi, gi->functions[f_ix]);
+
+		if (w->buf)
+			w->buf[start] = (w->words - start) * sizeof(uint32_t);
+		num_objects++;
+	}
 
-static size_t fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
-{
-#if CONFIG(DEBUG_COVERAGE)
-	printk(BIOS_DEBUG, "%s: %zd * %zd bytes to file %s\n",
-		__func__, nmemb, size, stream->filename);
-#endif
-	// TODO check if file is last opened file and fail otherwise.
+	if (w->buf) {
+		struct coverage_header *header = (struct coverage_header *)w->buf;
 
-	memcpy(stream->data + stream->offset, ptr, size * nmemb);
-	stream->len += (nmemb * size) - (stream->len - stream->offset);
-	stream->offset += nmemb * size;
-	return nmemb;
+		header->magic = COVERAGE_MAGIC;
+		header->version = COVERAGE_VERSION;
+		header->size = w->words * sizeof(uint32_t);
+		header->num_objects = num_objects;
+	}
 }
 
-static void setbuf(FILE *stream, char *buf)
+static void gcov_exit(void)
 {
-	gcc_assert(buf == 0);
+	struct coverage_writer w = { 0 };
+	const struct cbmem_entry *entry;
+	size_t size;
+
+	coverage_serialize(&w);
+	size = w.words * sizeof(uint32_t);
+
+	/* On S3 resume the entry of the last boot is still there. */
+	entry = cbmem_entry_find(CBMEM_ID_COVERAGE);
+	if (!entry)
+		entry = cbmem_entry_add(CBMEM_ID_COVERAGE, size);
+	if (!entry || cbmem_entry_size(entry) < size) {
+		printk(BIOS_ERR, "Could not store %zu bytes of coverage data\n", size);
+		return;
+	}
+
+	w.buf = cbmem_entry_start(entry);
+	coverage_serialize(&w);
+
+#if CONFIG(DEBUG_COVERAGE)
+	printk(BIOS_DEBUG, "Stored %zu bytes of coverage data\n", size);
+#endif
 }
 
 static void coverage_init(void *unused)
@@ -509,7 +509,8 @@ extern int __gcov_execve(const char *, char  *const [], char *const [])
 
 #endif /* IN_LIBGCOV */
 
-#if IN_LIBGCOV >= 0
+/* coreboot doesn't write .gcda files itself, see gcov-glue.c. */
+#if IN_LIBGCOV >= 0 && !defined(__COREBOOT__)
 
 /* Optimum number of gcov_unsigned_t's read from or written to disk.  */
 #define GCOV_BLOCK_SIZE (1 << 10)
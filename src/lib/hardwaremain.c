@@ -10,12 +10,14 @@
 #include <adainit.h>
 #include <arch/exception.h>
 #include <boot/tables.h>
+#include <boot_task.h>
 #include <bootstate.h>
 #include <cbmem.h>
 #include <commonlib/console/post_codes.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
 #include <delay.h>
+#include <lib.h>
 #include <device/device.h>
 #include <device/pci.h>
 #include <program_loading.h>
@@ -109,8 +111,20 @@ static boot_state_t bs_dev_enumerate(void *arg)
 	return BS_DEV_RESOURCES;
 }
 
+/*
+ * On a minimal S3 resume, devices are only enumerated and then get their
+ * resume() method called. Boot state callbacks and final() still run.
+ */
+static bool minimal_resume(void)
+{
+	return CONFIG(MINIMAL_S3_RESUME) && acpi_is_wakeup_s3();
+}
+
 static boot_state_t bs_dev_resources(void *arg)
 {
+	if (minimal_resume())
+		return BS_DEV_ENABLE;
+
 	timestamp_add_now(TS_DEVICE_CONFIGURE);
 
 	/* Now compute and assign the bus resources. */
@@ -121,6 +135,9 @@ static boot_state_t bs_dev_resources(void *arg)
 
 static boot_state_t bs_dev_enable(void *arg)
 {
+	if (minimal_resume())
+		return BS_DEV_INIT;
+
 	timestamp_add_now(TS_DEVICE_ENABLE);
 
 	/* Now actually enable devices on the bus */
@@ -131,6 +148,12 @@ static boot_state_t bs_dev_enable(void *arg)
 
 static boot_state_t bs_dev_init(void *arg)
 {
+	if (minimal_resume()) {
+		timestamp_add_now(TS_DEVICE_RESUME);
+		dev_resume();
+		return BS_POST_DEVICE;
+	}
+
 	timestamp_add_now(TS_DEVICE_INITIALIZE);
 
 	/* And of course initialize devices on the bus */
@@ -336,6 +359,8 @@ static void bs_walk_state_machine(void)
 
 		bs_sample_time(state);
 
+		boot_tasks_state_entered(state->id);
+
 		bs_call_callbacks(state, current_phase.seq);
 		/* Update the current sequence so that any calls to block the
 		 * current state from the run_state() function will place a
@@ -369,6 +394,8 @@ static void bs_walk_state_machine(void)
 		bs_sample_time(state);
 
 		state->complete = true;
+
+		boot_tasks_state_completed(state->id);
 	}
 }
 
@@ -435,6 +462,9 @@ void main(void)
 	 */
 	ramstage_adainit();
 
+	if (CONFIG(MEM_USAGE_STATS))
+		mem_usage_stack_init();
+
 	/* TODO: Understand why this is here and move to arch/platform code. */
 	/* For MMIO UART this needs to be called before any other printk. */
 	if (ENV_X86)
@@ -462,6 +492,9 @@ void main(void)
 	/* Schedule the static boot state entries. */
 	boot_state_schedule_static_entries();
 
+	/* Start the boot tasks that only need CBMEM. */
+	boot_tasks_init();
+
 	bs_walk_state_machine();
 
 	die("Boot state machine failure.\n");
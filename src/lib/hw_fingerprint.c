@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbmem.h>
+#include <console/console.h>
+#include <device/pci_def.h>
+#include <fw_config.h>
+#include <hw_fingerprint.h>
+#include <stdbool.h>
+#include <types.h>
+#include <xxhash.h>
+
+#if ENV_X86
+#include <arch/cpu.h>
+#include <device/pci_ops.h>
+#endif
+
+static struct xxh64_state state;
+static bool started;
+static bool finalized;
+static uint64_t fingerprint;
+
+__weak void mainboard_hw_fingerprint(void)
+{
+}
+
+void hw_fingerprint_add(const void *data, size_t size)
+{
+	if (finalized) {
+		printk(BIOS_ERR, "HW fingerprint: Already finalized, ignoring %zu bytes\n",
+		       size);
+		return;
+	}
+
+	if (!started) {
+		xxh64_reset(&state, 0);
+		started = true;
+	}
+
+	xxh64_update(&state, data, size);
+}
+
+static void add_u32(uint32_t value)
+{
+	hw_fingerprint_add(&value, sizeof(value));
+}
+
+static void add_u64(uint64_t value)
+{
+	hw_fingerprint_add(&value, sizeof(value));
+}
+
+static void add_cpu(void)
+{
+#if ENV_X86
+	struct cpuid_result res = cpuid(0);
+
+	/* Vendor string and highest leaf */
+	add_u32(res.eax);
+	add_u32(res.ebx);
+	add_u32(res.ecx);
+	add_u32(res.edx);
+	add_u32(cpu_get_cpuid());
+#endif
+}
+
+/* Vendor and device IDs of everything on bus 0, cheap to read before the PCI scan. */
+static void add_pci_bus0(void)
+{
+#if ENV_X86
+	unsigned int slot, func;
+
+	if (!CONFIG(PCI))
+		return;
+
+	for (slot = 0; slot < 32; slot++) {
+		for (func = 0; func < 8; func++) {
+			const pci_devfn_t dev = PCI_DEV(0, slot, func);
+			const uint32_t id = pci_s_read_config32(dev, PCI_VENDOR_ID);
+
+			if (id == 0xffffffff || id == 0 || id == 0xffff0000) {
+				if (func == 0)
+					break;
+				continue;
+			}
+
+			add_u32(PCI_DEVFN(slot, func));
+			add_u32(id);
+
+			if (func == 0 &&
+			    !(pci_s_read_config8(dev, PCI_HEADER_TYPE) & 0x80))
+				break;
+		}
+	}
+#endif
+}
+
+static void hw_fingerprint_finalize(void)
+{
+	add_cpu();
+
+	if (CONFIG(FW_CONFIG))
+		add_u64(fw_config_get());
+
+	add_pci_bus0();
+	mainboard_hw_fingerprint();
+
+	fingerprint = xxh64_digest(&state);
+	finalized = true;
+
+	printk(BIOS_DEBUG, "HW fingerprint: %016llx\n", (unsigned long long)fingerprint);
+}
+
+uint64_t hw_fingerprint(void)
+{
+	uint64_t *stored;
+
+	if (finalized)
+		return fingerprint;
+
+	/* Use what romstage found, the signals added there are gone by now. */
+	if (!ENV_CREATES_CBMEM && cbmem_online()) {
+		stored = cbmem_find(CBMEM_ID_HW_FINGERPRINT);
+		if (stored) {
+			fingerprint = *stored;
+			finalized = true;
+			return fingerprint;
+		}
+		printk(BIOS_WARNING, "HW fingerprint: Not in CBMEM, computing it again\n");
+	}
+
+	hw_fingerprint_finalize();
+	return fingerprint;
+}
+
+static void hw_fingerprint_store(int is_recovery)
+{
+	uint64_t *stored;
+
+	/* On S3 resume, replace the one of the last boot. */
+	stored = cbmem_find(CBMEM_ID_HW_FINGERPRINT);
+	if (!stored)
+		stored = cbmem_add(CBMEM_ID_HW_FINGERPRINT, sizeof(*stored));
+	if (!stored) {
+		printk(BIOS_ERR, "HW fingerprint: Could not store it in CBMEM\n");
+		return;
+	}
+
+	*stored = hw_fingerprint();
+}
+
+CBMEM_CREATION_HOOK(hw_fingerprint_store);
@@ -97,6 +97,115 @@ static void imdr_init(struct imdr *ir, void *upper_limit)
 	ir->r = NULL;
 }
 
+/*
+ * Per-stage index of the entries of a root sorted by ID, with entry 0 covering
+ * the root left out. It is updated lazily on lookup whenever the number of
+ * entries changed, which covers both additions and removals since entries are
+ * only ever added or removed at the end.
+ */
+#define IMD_INDEX_ENTRIES ((LIMIT_ALIGN - sizeof(struct imd_root_pointer) - \
+			    sizeof(struct imd_root)) / sizeof(struct imd_entry))
+
+_Static_assert(IMD_INDEX_ENTRIES <= UINT8_MAX + 1, "IMD index entries don't fit uint8_t");
+
+struct imdr_index {
+	const struct imd_root *r;
+	uint32_t num_entries;
+	uint8_t order[IMD_INDEX_ENTRIES];
+};
+
+/* One each for the large and the small region. */
+static struct imdr_index imdr_indices[2];
+
+/*
+ * Returns the first position in the index whose entry has an ID not smaller than id, or
+ * with after set, the first one whose ID is larger than id.
+ */
+static size_t imdr_index_bound(const struct imdr_index *idx, uint32_t id, bool after)
+{
+	size_t lo = 0, hi = idx->num_entries - 1;
+
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		const uint32_t mid_id = idx->r->entries[idx->order[mid]].id;
+
+		if (mid_id < id || (after && mid_id == id))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/* Inserts the next entry, after all entries with the same ID to keep the lookup order. */
+static void imdr_index_insert_next(struct imdr_index *idx)
+{
+	const size_t n = idx->num_entries;
+	size_t pos;
+
+	pos = imdr_index_bound(idx, idx->r->entries[n].id, true);
+	memmove(&idx->order[pos + 1], &idx->order[pos], n - 1 - pos);
+	idx->order[pos] = n;
+	idx->num_entries++;
+}
+
+static void imdr_index_invalidate(const struct imd_root *r)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(imdr_indices); i++) {
+		if (imdr_indices[i].r == r)
+			imdr_indices[i].r = NULL;
+	}
+}
+
+static struct imdr_index *imdr_get_index(const struct imd_root *r)
+{
+	static size_t next_slot;
+	struct imdr_index *idx = NULL;
+	size_t i;
+
+	if (r->num_entries < 1 || r->num_entries > IMD_INDEX_ENTRIES)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(imdr_indices); i++) {
+		if (imdr_indices[i].r == r)
+			idx = &imdr_indices[i];
+	}
+
+	if (idx == NULL) {
+		idx = &imdr_indices[next_slot++ % ARRAY_SIZE(imdr_indices)];
+		idx->r = r;
+		idx->num_entries = 1;
+	}
+
+	/* Rebuild from scratch unless entries were only added. */
+	if (idx->num_entries > r->num_entries)
+		idx->num_entries = 1;
+
+	while (idx->num_entries < r->num_entries)
+		imdr_index_insert_next(idx);
+
+	return idx;
+}
+
+static const struct imd_entry *imdr_index_find(const struct imd_root *r, uint32_t id)
+{
+	const struct imdr_index *idx;
+	size_t pos;
+
+	idx = imdr_get_index(r);
+	if (idx == NULL)
+		return NULL;
+
+	pos = imdr_index_bound(idx, id, false);
+	if (pos < idx->num_entries - 1 && r->entries[idx->order[pos]].id == id)
+		return &r->entries[idx->order[pos]];
+
+	return NULL;
+}
+
 static int imdr_create_empty(struct imdr *imdr, size_t root_size,
 				size_t entry_align)
 {
@@ -141,6 +250,9 @@ static int imdr_create_empty(struct imdr *imdr, size_t root_size,
 	memset(r, 0, sizeof(*r));
 	r->entry_align = entry_align;
 
+	if (CONFIG(IMD_SORTED_INDEX))
+		imdr_index_invalidate(r);
+
 	/* Calculate size left for entries. */
 	r->max_entries = root_num_entries(root_size);
 
@@ -206,6 +318,9 @@ static int imdr_recover(struct imdr *imdr)
 	/* Set root pointer. */
 	imdr->r = r;
 
+	if (CONFIG(IMD_SORTED_INDEX))
+		imdr_index_invalidate(r);
+
 	return 0;
 }
 
@@ -221,6 +336,9 @@ static const struct imd_entry *imdr_entry_find(const struct imdr *imdr,
 	if (r == NULL)
 		return NULL;
 
+	if (CONFIG(IMD_SORTED_INDEX) && r->num_entries <= IMD_INDEX_ENTRIES)
+		return imdr_index_find(r, id);
+
 	e = NULL;
 	/* Skip first entry covering the root. */
 	for (i = 1; i < r->num_entries; i++) {
@@ -606,6 +724,10 @@ int imd_entry_remove(const struct imd *imd, const struct imd_entry *entry)
 
 	r->num_entries--;
 
+	/* A new entry could take its place before the next lookup. */
+	if (CONFIG(IMD_SORTED_INDEX))
+		imdr_index_invalidate(r);
+
 	return 0;
 }
 
@@ -7,6 +7,7 @@
 #include <cbmem.h>
 #include <imd.h>
 #include <lib.h>
+#include <smp/spinlock.h>
 #include <types.h>
 
 /* The program loader passes on cbmem_top and the program entry point
@@ -15,6 +16,9 @@ uintptr_t _cbmem_top_ptr;
 
 static struct imd imd;
 
+/* Entries can be added and looked up from APs as well, e.g. from MP jobs. */
+DECLARE_SPIN_LOCK(cbmem_lock)
+
 void *cbmem_top(void)
 {
 	if (ENV_CREATES_CBMEM) {
@@ -135,7 +139,9 @@ const struct cbmem_entry *cbmem_entry_add(u32 id, u64 size64)
 {
 	const struct imd_entry *e;
 
+	spin_lock(&cbmem_lock);
 	e = imd_entry_find_or_add(&imd, id, size64);
+	spin_unlock(&cbmem_lock);
 
 	return imd_to_cbmem(e);
 }
@@ -144,7 +150,9 @@ void *cbmem_add(u32 id, u64 size)
 {
 	const struct imd_entry *e;
 
+	spin_lock(&cbmem_lock);
 	e = imd_entry_find_or_add(&imd, id, size);
+	spin_unlock(&cbmem_lock);
 
 	if (e == NULL)
 		return NULL;
@@ -157,7 +165,9 @@ const struct cbmem_entry *cbmem_entry_find(u32 id)
 {
 	const struct imd_entry *e;
 
+	spin_lock(&cbmem_lock);
 	e = imd_entry_find(&imd, id);
+	spin_unlock(&cbmem_lock);
 
 	return imd_to_cbmem(e);
 }
@@ -166,7 +176,9 @@ void *cbmem_find(u32 id)
 {
 	const struct imd_entry *e;
 
+	spin_lock(&cbmem_lock);
 	e = imd_entry_find(&imd, id);
+	spin_unlock(&cbmem_lock);
 
 	if (e == NULL)
 		return NULL;
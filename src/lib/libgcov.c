@@ -32,7 +32,6 @@ permissions described in the GCC Runtime Library Exception, version
 typedef s32 pid_t;
 #define gcc_assert(x) ASSERT(x)
 #define fprintf(file, x...) printk(BIOS_ERR, x)
-#include "gcov-glue.c"
 
 /* Define MACROs to be used by coreboot compilation.  */
 # define L_gcov
@@ -108,6 +107,7 @@ void __gcov_merge_add(gcov_type *counters  __attribute__((unused)),
 #endif /* __COREBOOT__ */
 
 #ifdef L_gcov
+#ifndef __COREBOOT__
 #include "gcov-io.c"
 
 struct gcov_fn_buffer {
@@ -116,6 +116,7 @@ struct gcov_fn_buffer {
 	struct gcov_fn_info info;
 	/* note gcov_fn_info ends in a trailing array.  */
 };
+#endif /* __COREBOOT__ */
 
 /* Chain of per-object gcov structures.  */
 static struct gcov_info *gcov_list;
@@ -123,6 +124,11 @@ static struct gcov_info *gcov_list;
 /* Size of the longest file name. */
 static size_t gcov_max_filename = 0;
 
+#ifdef __COREBOOT__
+/* coreboot dumps the counters to CBMEM instead of writing .gcda files. */
+#include "gcov-glue.c"
+#else
+
 /* Make sure path component of the given FILENAME exists, create
    missing directories. FILENAME must be writable.
    Returns zero on success, or -1 if an error occurred.  */
@@ -130,10 +136,6 @@ static size_t gcov_max_filename = 0;
 static int
 create_file_directory(char *filename)
 {
-#ifdef __COREBOOT__
-	(void) filename;
-	return 0;
-#else
 #if !defined(TARGET_POSIX_IO) && !defined(_WIN32)
 	(void) filename;
 	return -1;
@@ -173,7 +175,6 @@ create_file_directory(char *filename)
 	};
 	return 0;
 #endif
-#endif
 }
 
 static struct gcov_fn_buffer *
@@ -271,6 +272,7 @@ crc32_unsigned(gcov_unsigned_t crc32, gcov_unsigned_t value)
 
 	return crc32;
 }
+#endif /* __COREBOOT__ */
 
 /* Check if VERSION of the info block PTR matches libgcov one.
    Return 1 on success, or zero in case of versions mismatch.
@@ -295,6 +297,7 @@ gcov_version(struct gcov_info *ptr, gcov_unsigned_t version,
 	return 1;
 }
 
+#ifndef __COREBOOT__
 /* Dump the coverage counts. We merge with existing counts when
    possible, to avoid growing the .da files ad infinitum. We use this
    program's checksum to make sure we only accumulate whole program
@@ -725,6 +728,8 @@ read_fatal:;
 	}
 }
 
+#endif /* __COREBOOT__ */
+
 /* Add a new object file onto the bb chain.  Invoked automatically
    when running an object file's global ctors.  */
 
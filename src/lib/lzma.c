@@ -17,8 +17,26 @@
 
 #include "lzmadecode.h"
 
-size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+struct lzma_wait_context {
+	size_t (*wait)(void *arg, size_t needed);
+	void *arg;
+};
+
+/* The decoder counts from the start of the compressed data, the caller from the header. */
+static SizeT lzma_wait_data(void *arg, SizeT needed)
 {
+	struct lzma_wait_context *context = arg;
+	const size_t data_offset = LZMA_PROPERTIES_SIZE + 8;
+	size_t avail = context->wait(context->arg, needed + data_offset);
+
+	return avail > data_offset ? avail - data_offset : 0;
+}
+
+static size_t _ulzman(const void *src, size_t srcn, void *dst, size_t dstn, void *scratchpad,
+		      size_t scratchpad_size, size_t (*wait)(void *arg, size_t needed),
+		      void *arg)
+{
+	struct lzma_wait_context wait_context = { .wait = wait, .arg = arg };
 	unsigned char properties[LZMA_PROPERTIES_SIZE];
 	const int data_offset = LZMA_PROPERTIES_SIZE + 8;
 	UInt32 outSize;
@@ -27,13 +45,16 @@ size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
 	int res;
 	CLzmaDecoderState state;
 	SizeT mallocneeds;
-	static unsigned char scratchpad[15980];
 	const unsigned char *cp;
 
 	if (srcn < data_offset) {
 		printk(BIOS_WARNING, "lzma: Input too small.\n");
 		return 0;
 	}
+	if (wait && wait(arg, data_offset) < data_offset) {
+		printk(BIOS_WARNING, "lzma: Input header never arrived.\n");
+		return 0;
+	}
 
 	memcpy(properties, src, LZMA_PROPERTIES_SIZE);
 	/* The outSize in LZMA stream is a 64bit integer stored in little-endian
@@ -50,11 +71,13 @@ size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
 		return 0;
 	}
 	mallocneeds = (LzmaGetNumProbs(&state.Properties) * sizeof(CProb));
-	if (mallocneeds > 15980) {
+	if (mallocneeds > scratchpad_size) {
 		printk(BIOS_WARNING, "lzma: Decoder scratchpad too small!\n");
 		return 0;
 	}
 	state.Probs = (CProb *)scratchpad;
+	state.Wait = wait ? lzma_wait_data : NULL;
+	state.WaitArg = &wait_context;
 	res = LzmaDecode(&state, src + data_offset, srcn - data_offset,
 			 &inProcessed, dst, outSize, &outProcessed);
 	if (res != 0) {
@@ -63,3 +86,111 @@ size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
 	}
 	return outProcessed;
 }
+
+static unsigned char lzma_scratchpad[LZMA_SCRATCHPAD_SIZE];
+
+size_t ulzman_scratch(const void *src, size_t srcn, void *dst, size_t dstn, void *scratchpad,
+		      size_t scratchpad_size)
+{
+	return _ulzman(src, srcn, dst, dstn, scratchpad, scratchpad_size, NULL, NULL);
+}
+
+size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	return _ulzman(src, srcn, dst, dstn, lzma_scratchpad, sizeof(lzma_scratchpad), NULL, NULL);
+}
+
+size_t ulzman_wait(const void *src, size_t srcn, void *dst, size_t dstn,
+		   size_t (*wait)(void *arg, size_t needed), void *arg)
+{
+	return _ulzman(src, srcn, dst, dstn, lzma_scratchpad, sizeof(lzma_scratchpad), wait, arg);
+}
+
+struct lzma_stream_context {
+	const struct ulzma_stream *stream;
+	/* Part of the first input piece that follows the header. */
+	const unsigned char *rest;
+	size_t rest_size;
+};
+
+static SizeT lzma_stream_read(void *arg, const Byte **buf)
+{
+	struct lzma_stream_context *context = arg;
+	const void *piece;
+	size_t size;
+
+	if (context->rest_size) {
+		*buf = context->rest;
+		size = context->rest_size;
+		context->rest_size = 0;
+		return size;
+	}
+
+	size = context->stream->read(context->stream->arg, &piece);
+	*buf = piece;
+	return size;
+}
+
+static int lzma_stream_flush(void *arg, const Byte *buf, SizeT size)
+{
+	struct lzma_stream_context *context = arg;
+
+	return context->stream->write(context->stream->arg, buf, size);
+}
+
+size_t ulzman_stream(const struct ulzma_stream *stream)
+{
+	struct lzma_stream_context context = { .stream = stream };
+	unsigned char header[LZMA_PROPERTIES_SIZE + 8];
+	const void *piece;
+	size_t have = 0;
+	size_t size, n;
+	UInt32 outSize;
+	SizeT outProcessed;
+	CLzmaDecoderState state = { 0 };
+	int res;
+
+	/* The header may be split over several pieces of input. */
+	while (have < sizeof(header)) {
+		size = stream->read(stream->arg, &piece);
+		if (!size) {
+			printk(BIOS_WARNING, "lzma: Input too small.\n");
+			return 0;
+		}
+		n = MIN(size, sizeof(header) - have);
+		memcpy(header + have, piece, n);
+		have += n;
+		context.rest = (const unsigned char *)piece + n;
+		context.rest_size = size - n;
+	}
+
+	/* Only the low 32 bits of the 64-bit little-endian size, like ulzman(). */
+	outSize = header[LZMA_PROPERTIES_SIZE + 3] << 24 | header[LZMA_PROPERTIES_SIZE + 2] << 16 |
+		  header[LZMA_PROPERTIES_SIZE + 1] << 8 | header[LZMA_PROPERTIES_SIZE];
+	if (!stream->write && outSize > stream->window_size)
+		outSize = stream->window_size;
+
+	if (LzmaDecodeProperties(&state.Properties, header,
+				 LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK) {
+		printk(BIOS_WARNING, "lzma: Incorrect stream properties.\n");
+		return 0;
+	}
+	if (LzmaGetNumProbs(&state.Properties) * sizeof(CProb) > stream->scratchpad_size) {
+		printk(BIOS_WARNING, "lzma: Decoder scratchpad too small!\n");
+		return 0;
+	}
+
+	state.Probs = (CProb *)stream->scratchpad;
+	state.Read = lzma_stream_read;
+	state.Flush = stream->write ? lzma_stream_flush : NULL;
+	state.StreamArg = &context;
+	state.Window = stream->window;
+	state.WindowSize = stream->window_size;
+
+	res = LzmaDecodeStream(&state, outSize, &outProcessed);
+	if (res != 0) {
+		printk(BIOS_WARNING, "lzma: Decoding error = %d\n", res);
+		return 0;
+	}
+	return outProcessed;
+}
@@ -26,7 +26,7 @@
 #endif
 
 #include "lzmadecode.h"
-#include <types.h>
+#include <stdint.h>
 
 #define kNumTopBits 24
 #define kTopValue ((UInt32)1 << kNumTopBits)
@@ -57,7 +57,15 @@
 }
 
 
-#define RC_TEST { if (Buffer == BufferLim) return LZMA_RESULT_DATA_ERROR; }
+#define RC_TEST { if (Buffer == BufferLim) {					\
+		if (stream) {							\
+			if (!LzmaRead(vs, &Buffer, &BufferLim))			\
+				return LZMA_RESULT_DATA_ERROR;			\
+		} else if ((BufferLim = LzmaWait(vs, inStream, inSize,		\
+						 BufferLim)) == Buffer) {	\
+			return LZMA_RESULT_DATA_ERROR;				\
+		}								\
+	} }
 
 #define RC_INIT(buffer, bufferSize) Buffer = buffer; \
 	BufferLim = buffer + bufferSize; RC_INIT2
@@ -110,6 +118,29 @@
 }
 
 
+/*
+ * Output goes straight to outStream, or in stream mode to the Window ring buffer which is
+ * handed to Flush() before it wraps around. Flush() must leave the window untouched, later
+ * matches still refer to it. nowPos always counts the whole output.
+ */
+#define OUT_GET(dist)								\
+	(stream ? outStream[wPos >= (dist) ? wPos - (dist) : wPos + vs->WindowSize - (dist)] \
+	 : outStream[nowPos - (dist)])
+
+#define OUT_PUT(b) {								\
+	if (stream) {								\
+		if (wPos == vs->WindowSize) {					\
+			if (!vs->Flush || vs->Flush(vs->StreamArg, outStream, wPos)) \
+				return LZMA_RESULT_DATA_ERROR;			\
+			wPos = 0;						\
+		}								\
+		outStream[wPos++] = (b);					\
+	} else {								\
+		outStream[nowPos] = (b);					\
+	}									\
+	nowPos++;								\
+}
+
 #define kNumPosBitsMax 4
 #define kNumPosStatesMax (1 << kNumPosBitsMax)
 
@@ -189,13 +220,49 @@ int LzmaDecodeProperties(CLzmaProperties *propsRes,
 
 #define kLzmaStreamWasFinishedId (-1)
 
-__lzma_attribute_Ofast__
-int LzmaDecode(CLzmaDecoderState *vs,
+/* Returns the new input limit once the decoder has consumed everything up to BufferLim. */
+static __attribute__((noinline)) const Byte *LzmaWait(CLzmaDecoderState *vs, const Byte *inStream,
+	SizeT inSize, const Byte *BufferLim)
+{
+	SizeT valid = BufferLim - inStream;
+	SizeT avail;
+
+	if (!vs->Wait || valid == inSize)
+		return BufferLim;
+
+	avail = vs->Wait(vs->WaitArg, valid + 1);
+	if (avail <= valid)
+		return BufferLim;
+
+	return inStream + (avail < inSize ? avail : inSize);
+}
+
+/* Moves on to the next piece of input in stream mode. Returns 0 at the end of the input. */
+static __attribute__((noinline)) int LzmaRead(CLzmaDecoderState *vs, const Byte **Buffer,
+	const Byte **BufferLim)
+{
+	const Byte *buf;
+	SizeT size = vs->Read(vs->StreamArg, &buf);
+
+	if (!size)
+		return 0;
+
+	*Buffer = buf;
+	*BufferLim = buf + size;
+	return 1;
+}
+
+/*
+ * The decoder proper. It is instantiated once for whole buffers and once for stream mode,
+ * so the former doesn't pay for the ring buffer arithmetic.
+ */
+static __always_inline int lzma_decode(CLzmaDecoderState *vs,
 	const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
-	unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed)
+	unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed, const int stream)
 {
 	CProb *p = vs->Probs;
 	SizeT nowPos = 0;
+	SizeT wPos = 0;
 	Byte previousByte = 0;
 	UInt32 posStateMask = (1 << (vs->Properties.pb)) - 1;
 	UInt32 literalPosMask = (1 << (vs->Properties.lp)) - 1;
@@ -226,7 +293,8 @@ int LzmaDecode(CLzmaDecoderState *vs,
 			p[i] = kBitModelTotal >> 1;
 	}
 
-	RC_INIT(inStream, inSize);
+	/* With a wait callback or in stream mode, input only arrives as the decoder asks for it. */
+	RC_INIT(inStream, ((stream || vs->Wait) ? 0 : inSize));
 
 
 	while (nowPos < outSize) {
@@ -244,7 +312,7 @@ int LzmaDecode(CLzmaDecoderState *vs,
 
 			if (state >= kNumLitStates) {
 				int matchByte;
-				matchByte = outStream[nowPos - rep0];
+				matchByte = OUT_GET(rep0);
 				do {
 					int bit;
 					CProb *probLit;
@@ -264,7 +332,7 @@ int LzmaDecode(CLzmaDecoderState *vs,
 			}
 			previousByte = (Byte)symbol;
 
-			outStream[nowPos++] = previousByte;
+			OUT_PUT(previousByte);
 			if (state < 4)
 				state = 0;
 			else if (state < 10)
@@ -297,10 +365,8 @@ int LzmaDecode(CLzmaDecoderState *vs,
 
 						state = state < kNumLitStates
 							? 9 : 11;
-						previousByte = outStream[nowPos
-							- rep0];
-						outStream[nowPos++] =
-							previousByte;
+						previousByte = OUT_GET(rep0);
+						OUT_PUT(previousByte);
 
 						continue;
 					} else {
@@ -419,12 +485,15 @@ int LzmaDecode(CLzmaDecoderState *vs,
 			len += kMatchMinLen;
 			if (rep0 > nowPos)
 				return LZMA_RESULT_DATA_ERROR;
+			/* The match reaches back further than the window. */
+			if (stream && rep0 > vs->WindowSize)
+				return LZMA_RESULT_DATA_ERROR;
 
 
 			do {
-				previousByte = outStream[nowPos - rep0];
+				previousByte = OUT_GET(rep0);
 				len--;
-				outStream[nowPos++] = previousByte;
+				OUT_PUT(previousByte);
 			} while (len != 0 && nowPos < outSize);
 		}
 	}
@@ -434,8 +503,32 @@ int LzmaDecode(CLzmaDecoderState *vs,
 	 */
 	 (void)len;
 
+	/* Hand out what is left in the window. */
+	if (stream && wPos && vs->Flush && vs->Flush(vs->StreamArg, outStream, wPos))
+		return LZMA_RESULT_DATA_ERROR;
 
-	*inSizeProcessed = (SizeT)(Buffer - inStream);
+	*inSizeProcessed = stream ? 0 : (SizeT)(Buffer - inStream);
 	*outSizeProcessed = nowPos;
 	return LZMA_RESULT_OK;
 }
+
+__lzma_attribute_Ofast__
+int LzmaDecode(CLzmaDecoderState *vs,
+	const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
+	unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed)
+{
+	return lzma_decode(vs, inStream, inSize, inSizeProcessed, outStream, outSize,
+			   outSizeProcessed, 0);
+}
+
+__lzma_attribute_Ofast__
+int LzmaDecodeStream(CLzmaDecoderState *vs, SizeT outSize, SizeT *outSizeProcessed)
+{
+	SizeT inSizeProcessed;
+
+	if (!vs->Read || !vs->Window || !vs->WindowSize)
+		return LZMA_RESULT_DATA_ERROR;
+
+	return lzma_decode(vs, NULL, 0, &inSizeProcessed, vs->Window, outSize,
+			   outSizeProcessed, 1);
+}
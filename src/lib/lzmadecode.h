@@ -22,7 +22,7 @@
 #ifndef __LZMADECODE_H
 #define __LZMADECODE_H
 
-#include <types.h>
+#include <stddef.h>
 
 typedef unsigned char Byte;
 typedef unsigned short UInt16;
@@ -57,6 +57,16 @@ int LzmaDecodeProperties(CLzmaProperties *propsRes,
 typedef struct _CLzmaDecoderState {
 	CLzmaProperties Properties;
 	CProb *Probs;
+	/* Optional. Called when the decoder runs out of valid input, must return how many
+	   bytes from the start of inStream are valid now (see ulzman_wait()). */
+	SizeT (*Wait)(void *arg, SizeT needed);
+	void *WaitArg;
+	/* Stream mode only, see LzmaDecodeStream(). */
+	SizeT (*Read)(void *arg, const Byte **buf);
+	int (*Flush)(void *arg, const Byte *buf, SizeT size);
+	void *StreamArg;
+	Byte *Window;
+	SizeT WindowSize;
 } CLzmaDecoderState;
 
 
@@ -64,4 +74,9 @@ int LzmaDecode(CLzmaDecoderState *vs,
 	const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
 	unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed);
 
+/* Decodes input from Read() into the Window ring buffer, which is passed to Flush() every
+   time it fills up and once more at the end. Flush() may be NULL if the window can hold
+   all outSize bytes. Matches must not reach back further than WindowSize. */
+int LzmaDecodeStream(CLzmaDecoderState *vs, SizeT outSize, SizeT *outSizeProcessed);
+
 #endif
@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <asan.h>
 #include <console/console.h>
+#include <smp/spinlock.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -15,6 +17,10 @@ static void *free_mem_ptr = &_heap;		/* Start of heap */
 static void *free_mem_end_ptr = &_eheap;	/* End of heap */
 static void *free_last_alloc_ptr = &_heap;	/* End of heap before
 						   last allocation */
+static void *free_mem_peak_ptr = &_heap;	/* Highest free_mem_ptr */
+
+/* APs may allocate as well, e.g. from MP jobs. */
+DECLARE_SPIN_LOCK(malloc_lock)
 
 /* We don't restrict the boundary. This is firmware,
  * you are supposed to know what you are doing.
@@ -26,10 +32,12 @@ void *memalign(size_t boundary, size_t size)
 	MALLOCDBG("%s Enter, boundary %zu, size %zu, free_mem_ptr %p\n",
 		__func__, boundary, size, free_mem_ptr);
 
+	spin_lock(&malloc_lock);
+
 	free_mem_ptr = (void *)ALIGN_UP((unsigned long)free_mem_ptr, boundary);
 
 	p = free_mem_ptr;
-	free_mem_ptr += size;
+	free_mem_ptr += size + ASAN_HEAP_REDZONE;
 	/*
 	 * Store last allocation pointer after ALIGN, as malloc() will
 	 * return it. This may cause n bytes of gap between allocations
@@ -47,9 +55,17 @@ void *memalign(size_t boundary, size_t size)
 		printk(BIOS_ERR, "Error! %s: Out of memory "
 				"(free_mem_ptr >= free_mem_end_ptr)",
 				__func__);
+		spin_unlock(&malloc_lock);
 		return NULL;
 	}
 
+	if (free_mem_ptr > free_mem_peak_ptr)
+		free_mem_peak_ptr = free_mem_ptr;
+
+	asan_heap_alloc(p, size);
+
+	spin_unlock(&malloc_lock);
+
 	MALLOCDBG("%s %p\n", __func__, p);
 
 	return p;
@@ -69,6 +85,12 @@ void *calloc(size_t nitems, size_t size)
 	return p;
 }
 
+void heap_usage(size_t *size, size_t *peak)
+{
+	*size = &_eheap - &_heap;
+	*peak = free_mem_peak_ptr - (void *)&_heap;
+}
+
 void free(void *ptr)
 {
 	if (ptr == NULL)
@@ -84,8 +106,11 @@ void free(void *ptr)
 	 * Rewind the heap pointer to the end of heap
 	 * before the last successful malloc().
 	 */
+	spin_lock(&malloc_lock);
 	if (ptr == free_last_alloc_ptr) {
+		asan_heap_free(free_last_alloc_ptr, free_mem_ptr - free_last_alloc_ptr);
 		free_mem_ptr = free_last_alloc_ptr;
 		free_last_alloc_ptr = NULL;
 	}
+	spin_unlock(&malloc_lock);
 }
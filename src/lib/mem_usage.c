@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbfs.h>
+#include <cbmem.h>
+#include <commonlib/mem_usage_serialized.h>
+#include <console/console.h>
+#include <lib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <symbols.h>
+#include <thread.h>
+#include <types.h>
+
+#if ENV_X86
+#include <arch/symbols.h>
+#endif
+
+#define STACK_POISON	0xDEADBEEF
+
+/* Leave some room below the current stack frame for the calls that do the painting. */
+#define STACK_POISON_MARGIN	256
+
+void stack_poison(void *base, size_t size)
+{
+	u32 *stack = base;
+
+	for (size_t i = 0; i < size / sizeof(*stack); i++)
+		stack[i] = STACK_POISON;
+}
+
+size_t stack_usage(const void *base, size_t size)
+{
+	const u32 *stack = base;
+	size_t i;
+
+	for (i = 0; i < size / sizeof(*stack); i++)
+		if (stack[i] != STACK_POISON)
+			break;
+
+	return size - i * sizeof(*stack);
+}
+
+static void stage_stack(u8 **base, size_t *size)
+{
+#if ENV_X86 && ENV_CACHE_AS_RAM
+	*base = (u8 *)_car_stack;
+	*size = _car_stack_size;
+#else
+	*base = (u8 *)_stack;
+	*size = REGION_SIZE(stack);
+#endif
+}
+
+void mem_usage_stack_init(void)
+{
+	u8 *base, *sp = __builtin_frame_address(0);
+	size_t size;
+
+	stage_stack(&base, &size);
+	if (sp < base + STACK_POISON_MARGIN || sp > base + size)
+		return;
+
+	stack_poison(base, sp - STACK_POISON_MARGIN - base);
+}
+
+void mem_usage_record(void)
+{
+	struct mem_usage_table *table;
+	struct mem_usage_record *rec;
+	u8 *stack_base;
+	size_t stack_size, heap_size, heap_peak;
+
+	if (!ENV_HAS_CBMEM || !cbmem_online())
+		return;
+
+	table = cbmem_find(CBMEM_ID_MEM_USAGE);
+	if (!table) {
+		table = cbmem_add(CBMEM_ID_MEM_USAGE, sizeof(*table));
+		if (!table) {
+			printk(BIOS_ERR, "Could not allocate the memory usage table\n");
+			return;
+		}
+		table->num_entries = 0;
+	} else if (ENV_CREATES_CBMEM) {
+		/* Left over from before an S3 resume, every boot starts a new table. */
+		table->num_entries = 0;
+	}
+
+	if (table->num_entries >= ARRAY_SIZE(table->records))
+		return;
+
+	rec = &table->records[table->num_entries++];
+	memset(rec, 0, sizeof(*rec));
+	strncpy(rec->stage, ENV_STRING, sizeof(rec->stage) - 1);
+
+	rec->cbfs_cache_size = cbfs_cache.size;
+	rec->cbfs_cache_peak = mem_pool_peak(&cbfs_cache);
+
+	if (ENV_RAMSTAGE) {
+		heap_usage(&heap_size, &heap_peak);
+		rec->heap_size = heap_size;
+		rec->heap_peak = heap_peak;
+	}
+
+	/* Before RAM, the stack high-water mark includes the stages that ran before. */
+	if (ENV_ROMSTAGE_OR_BEFORE || ENV_RAMSTAGE) {
+		stage_stack(&stack_base, &stack_size);
+		rec->stack_size = stack_size;
+		rec->stack_peak = stack_usage(stack_base, stack_size);
+	}
+
+	if (ENV_SUPPORTS_COOP) {
+		rec->thread_stack_size = CONFIG_STACK_SIZE;
+		rec->thread_stack_peak = thread_stack_peak_usage();
+	}
+
+#if ENV_X86 && ENV_CACHE_AS_RAM
+	rec->car_size = _car_region_size;
+	rec->car_used = _car_unallocated_start - _car_region_start;
+#endif
+
+	printk(BIOS_DEBUG, "Memory usage: heap %u/%u, cbfs_cache %u/%u, stack %u/%u\n",
+	       rec->heap_peak, rec->heap_size, rec->cbfs_cache_peak, rec->cbfs_cache_size,
+	       rec->stack_peak, rec->stack_size);
+}
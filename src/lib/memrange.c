@@ -24,6 +24,8 @@ static inline void range_entry_unlink_and_free(struct memranges *ranges,
 					       struct range_entry **prev_ptr,
 					       struct range_entry *r)
 {
+	if (ranges->hint == r)
+		ranges->hint = NULL;
 	range_entry_unlink(prev_ptr, r);
 	range_entry_link(&ranges->free_list, r);
 }
@@ -61,6 +63,23 @@ range_list_add(struct memranges *ranges, struct range_entry **prev_ptr,
 	return new_entry;
 }
 
+/* Return the link to start a walk for a range beginning at begin from. */
+static struct range_entry **memranges_walk_start(struct memranges *ranges,
+						 resource_t begin)
+{
+	/* Entries are sorted, so everything up to the hint can be skipped. */
+	if (ranges->hint != NULL && ranges->hint->end < begin)
+		return &ranges->hint->next;
+
+	return &ranges->entries;
+}
+
+static bool range_entries_mergeable(const struct range_entry *prev,
+				    const struct range_entry *cur)
+{
+	return prev->end + 1 >= cur->begin && prev->tag == cur->tag;
+}
+
 static void merge_neighbor_entries(struct memranges *ranges)
 {
 	struct range_entry *cur;
@@ -78,7 +97,7 @@ static void merge_neighbor_entries(struct memranges *ranges)
 		/* If the previous entry merges with the current update the
 		 * previous entry to cover full range and delete current from
 		 * the list. */
-		if (prev->end + 1 >= cur->begin && prev->tag == cur->tag) {
+		if (range_entries_mergeable(prev, cur)) {
 			prev->end = cur->end;
 			range_entry_unlink_and_free(ranges, &prev->next, cur);
 			/* Set cur to prev so cur->next is valid since cur
@@ -99,8 +118,8 @@ static void remove_memranges(struct memranges *ranges,
 	struct range_entry *next;
 	struct range_entry **prev_ptr;
 
-	prev_ptr = &ranges->entries;
-	for (cur = ranges->entries; cur != NULL; cur = next) {
+	prev_ptr = memranges_walk_start(ranges, begin);
+	for (cur = *prev_ptr; cur != NULL; cur = next) {
 		resource_t tmp_end;
 
 		/* Cache the next value to handle unlinks. */
@@ -162,32 +181,47 @@ static void merge_add_memranges(struct memranges *ranges,
 				unsigned long tag)
 {
 	struct range_entry *cur;
+	struct range_entry *prev;
+	struct range_entry *new_entry;
 	struct range_entry **prev_ptr;
 
-	prev_ptr = &ranges->entries;
-
 	/* Remove all existing entries covered by the range. */
 	remove_memranges(ranges, begin, end, -1);
 
 	/* Find the entry to place the new entry after. Since
 	 * remove_memranges() was called above there is a guaranteed
 	 * spot for this new entry. */
-	for (cur = ranges->entries; cur != NULL; cur = cur->next) {
+	prev_ptr = memranges_walk_start(ranges, begin);
+	for (cur = *prev_ptr; cur != NULL; cur = cur->next) {
 		/* Found insertion spot before current entry. */
 		if (end < cur->begin)
 			break;
 
 		/* Keep track of previous entry to insert new entry after it. */
 		prev_ptr = &cur->next;
+	}
 
-		/* The new entry starts after this one. */
-		if (begin > cur->end)
-			continue;
+	new_entry = range_list_add(ranges, prev_ptr, begin, end, tag);
+	if (new_entry == NULL)
+		return;
+
+	/* Only the direct neighbors of the new entry can merge with it. */
+	cur = new_entry->next;
+	if (cur != NULL && range_entries_mergeable(new_entry, cur)) {
+		new_entry->end = cur->end;
+		range_entry_unlink_and_free(ranges, &new_entry->next, cur);
 	}
 
-	/* Add new entry and merge with neighbors. */
-	range_list_add(ranges, prev_ptr, begin, end, tag);
-	merge_neighbor_entries(ranges);
+	if (prev_ptr != &ranges->entries) {
+		prev = container_of(prev_ptr, struct range_entry, next);
+		if (range_entries_mergeable(prev, new_entry)) {
+			prev->end = new_entry->end;
+			range_entry_unlink_and_free(ranges, &prev->next, new_entry);
+			new_entry = prev;
+		}
+	}
+
+	ranges->hint = new_entry;
 }
 
 void memranges_update_tag(struct memranges *ranges, unsigned long old_tag,
@@ -287,6 +321,7 @@ void memranges_init_empty_with_alignment(struct memranges *ranges,
 
 	ranges->entries = NULL;
 	ranges->free_list = NULL;
+	ranges->hint = NULL;
 	ranges->align = align;
 
 	for (i = 0; i < num_free; i++)
@@ -366,22 +366,12 @@ uintptr_t nhlt_serialize(struct nhlt *nhlt, uintptr_t acpi_addr)
 	return nhlt_serialize_oem_overrides(nhlt, acpi_addr, NULL, NULL, 0);
 }
 
-uintptr_t nhlt_serialize_oem_overrides(struct nhlt *nhlt,
-	uintptr_t acpi_addr, const char *oem_id, const char *oem_table_id,
-	uint32_t oem_revision)
+static void nhlt_write_header(acpi_header_t *header, size_t sz, const char *oem_id,
+			      const char *oem_table_id, uint32_t oem_revision)
 {
-	struct cursor cur;
-	acpi_header_t *header;
-	size_t sz;
 	size_t oem_id_len;
 	size_t oem_table_id_len;
 
-	printk(BIOS_DEBUG, "ACPI:    * NHLT\n");
-
-	sz = nhlt_current_size(nhlt);
-
-	/* Create header */
-	header = (void *)acpi_addr;
 	memset(header, 0, sizeof(acpi_header_t));
 	memcpy(header->signature, "NHLT", 4);
 	write_le32(&header->length, sz);
@@ -400,6 +390,23 @@ uintptr_t nhlt_serialize_oem_overrides(struct nhlt *nhlt,
 	memcpy(header->oem_table_id, oem_table_id, oem_table_id_len);
 	write_le32(&header->oem_revision, oem_revision);
 	memcpy(header->asl_compiler_id, ASLC, 4);
+}
+
+uintptr_t nhlt_serialize_oem_overrides(struct nhlt *nhlt,
+	uintptr_t acpi_addr, const char *oem_id, const char *oem_table_id,
+	uint32_t oem_revision)
+{
+	struct cursor cur;
+	acpi_header_t *header;
+	size_t sz;
+
+	printk(BIOS_DEBUG, "ACPI:    * NHLT\n");
+
+	sz = nhlt_current_size(nhlt);
+
+	/* Create header */
+	header = (void *)acpi_addr;
+	nhlt_write_header(header, sz, oem_id, oem_table_id, oem_revision);
 
 	cur.buf = (void *)(acpi_addr + sizeof(acpi_header_t));
 	nhlt_serialize_endpoints(nhlt, &cur);
@@ -414,6 +421,43 @@ uintptr_t nhlt_serialize_oem_overrides(struct nhlt *nhlt,
 	return acpi_addr;
 }
 
+uintptr_t nhlt_serialize_from_cbfs(const char *name, uintptr_t acpi_addr,
+	const char *oem_id, const char *oem_table_id, uint32_t oem_revision)
+{
+	acpi_header_t *header = (void *)acpi_addr;
+	const acpi_header_t *table;
+	size_t file_size;
+	size_t sz;
+
+	printk(BIOS_DEBUG, "ACPI:    * NHLT (%s)\n", name);
+
+	table = cbfs_map(name, &file_size);
+	if (!table) {
+		printk(BIOS_ERR, "NHLT: %s not found in CBFS\n", name);
+		return acpi_addr;
+	}
+
+	sz = file_size >= sizeof(*table) ? read_le32(&table->length) : 0;
+	if (memcmp(table->signature, "NHLT", 4) || sz < sizeof(*table) + sizeof(uint32_t) ||
+	    sz > file_size) {
+		printk(BIOS_ERR, "NHLT: %s is not an NHLT table\n", name);
+		cbfs_unmap((void *)table);
+		return acpi_addr;
+	}
+
+	/* Only the header differs between boards sharing a table, the body is copied as is. */
+	memcpy(header, table, sz);
+	cbfs_unmap((void *)table);
+
+	nhlt_write_header(header, sz, oem_id, oem_table_id, oem_revision);
+	write_le8(&header->checksum, acpi_checksum((void *)header, sz));
+
+	acpi_addr += sz;
+	acpi_addr = ALIGN_UP(acpi_addr, 16);
+
+	return acpi_addr;
+}
+
 static int _nhlt_add_single_endpoint(struct nhlt *nhlt, int virtual_bus_id,
 					const struct nhlt_endp_descriptor *epd)
 {
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <boot_task.h>
+#include <bootstate.h>
+#include <console/console.h>
+#include <nv_write_queue.h>
+#include <types.h>
+
+static struct nv_write *queue_head;
+static struct nv_write **queue_tail = &queue_head;
+static bool queue_flushed;
+
+bool nv_write_defer(struct nv_write *w)
+{
+	if (queue_flushed)
+		return false;
+
+	if (w->queued)
+		return true;
+
+	w->queued = true;
+	w->next = NULL;
+	*queue_tail = w;
+	queue_tail = &w->next;
+
+	printk(BIOS_DEBUG, "NV: deferring %s write\n", w->name);
+
+	return true;
+}
+
+static void nv_write_flush(void *unused)
+{
+	struct nv_write *w;
+
+	while ((w = queue_head) != NULL) {
+		queue_head = w->next;
+		if (queue_head == NULL)
+			queue_tail = &queue_head;
+
+		/* Anything the commit adds for this user goes to the back. */
+		w->queued = false;
+
+		printk(BIOS_DEBUG, "NV: committing %s write\n", w->name);
+		w->commit(w->arg);
+	}
+
+	queue_flushed = true;
+}
+
+/*
+ * The late MRC cache update is requested at BS_OS_RESUME_CHECK entry, SPI
+ * lockdown happens as late as BS_PAYLOAD_LOAD exit or BS_OS_RESUME entry.
+ * Boot tasks are joined before the latter on the S3 resume path.
+ */
+static struct boot_task nv_write_task = {
+	.name = "NV writes",
+	.run = nv_write_flush,
+	.needs = BOOT_TASK_AFTER(BS_OS_RESUME_CHECK),
+	.deadline = BS_PAYLOAD_LOAD,
+};
+BOOT_TASK(nv_write_task);
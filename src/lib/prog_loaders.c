@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <bootmem.h>
 #include <cbfs.h>
 #include <cbmem.h>
 #include <console/console.h>
@@ -147,6 +148,33 @@ void payload_preload(void)
 	cbfs_preload(global_payload.name);
 }
 
+static void *payload_buffer_allocator(void *arg, size_t size, const union cbfs_mdata *unused)
+{
+	return bootmem_allocate_buffer(size);
+}
+
+/*
+ * Without a memory mapped boot device, mapping the payload would stage all of it in the
+ * cbfs_cache. FIT payloads are loaded into a buffer reserved for the payload instead, so
+ * that fit_payload() can leave uncompressed images (e.g. a large initrd) where they are.
+ */
+static void *payload_map(struct prog *payload)
+{
+	void *mapping;
+
+	if (CONFIG(PAYLOAD_FIT_SUPPORT) && !CONFIG(BOOT_DEVICE_MEMORY_MAPPED) &&
+	    cbfs_get_type(prog_name(payload)) == CBFS_TYPE_FIT_PAYLOAD) {
+		payload->cbfs_type = CBFS_TYPE_FIT_PAYLOAD;
+		mapping = cbfs_type_alloc(prog_name(payload), payload_buffer_allocator, NULL,
+					  NULL, &payload->cbfs_type);
+		if (mapping)
+			return mapping;
+	}
+
+	payload->cbfs_type = CBFS_TYPE_QUERY;
+	return cbfs_type_map(prog_name(payload), NULL, &payload->cbfs_type);
+}
+
 void payload_load(void)
 {
 	struct prog *payload = &global_payload;
@@ -157,9 +185,7 @@ void payload_load(void)
 	if (prog_locate_hook(payload))
 		goto out;
 
-	payload->cbfs_type = CBFS_TYPE_QUERY;
-	mapping = cbfs_type_map(prog_name(payload), NULL, &payload->cbfs_type);
-
+	mapping = payload_map(payload);
 	if (!mapping)
 		goto out;
 
@@ -1,6 +1,9 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <console/console.h>
+#include <lib.h>
 #include <program_loading.h>
+#include <security/tpm/tspi.h>
 #include <types.h>
 
 /* For each segment of a program loaded this function is called*/
@@ -24,6 +27,15 @@ void __weak arch_segment_loaded(uintptr_t start, size_t size,
 
 void prog_run(struct prog *prog)
 {
+	/* The next stage starts with an empty queue. */
+	if (CONFIG(TPM_MEASURE_DEFERRED) && !ENV_DECOMPRESSOR)
+		tpm_flush_deferred_extends();
+
+	if (CONFIG(MEM_USAGE_STATS) && !ENV_DECOMPRESSOR)
+		mem_usage_record();
+
+	console_sync();
+
 	platform_prog_run(prog);
 	arch_prog_run(prog);
 }
@@ -393,7 +393,7 @@ static void reg_script_write_msr(struct reg_script_context *ctx)
 
 /* Locate the structure containing the platform specific bus access routines */
 static const struct reg_script_bus_entry
-	*find_bus(const struct reg_script *step)
+	*find_bus(struct reg_script_context *ctx, const struct reg_script *step)
 {
 	extern const struct reg_script_bus_entry *_rsbe_init_begin[];
 	extern const struct reg_script_bus_entry *_ersbe_init_begin[];
@@ -401,12 +401,18 @@ static const struct reg_script_bus_entry
 	size_t table_entries;
 	size_t i;
 
+	/* Scripts usually access the same bus many times in a row. */
+	if (ctx->bus != NULL && ctx->bus->type == step->type)
+		return ctx->bus;
+
 	/* Locate the platform specific bus */
 	bus = _rsbe_init_begin;
 	table_entries = &_ersbe_init_begin[0] - &_rsbe_init_begin[0];
 	for (i = 0; i < table_entries; i++) {
-		if (bus[i]->type == step->type)
+		if (bus[i]->type == step->type) {
+			ctx->bus = bus[i];
 			return bus[i];
+		}
 	}
 
 	/* Bus not found */
@@ -477,7 +483,7 @@ static uint64_t reg_script_read(struct reg_script_context *ctx)
 			const struct reg_script_bus_entry *bus;
 
 			/* Read from the platform specific bus */
-			bus = find_bus(step);
+			bus = find_bus(ctx, step);
 			if (bus != NULL) {
 				value = bus->reg_script_read(ctx);
 				break;
@@ -533,7 +539,7 @@ static void reg_script_write(struct reg_script_context *ctx)
 			const struct reg_script_bus_entry *bus;
 
 			/* Write to the platform specific bus */
-			bus = find_bus(step);
+			bus = find_bus(ctx, step);
 			if (bus != NULL) {
 				bus->reg_script_write(ctx);
 				break;
@@ -691,6 +697,7 @@ void reg_script_run_on_dev(struct device *dev, const struct reg_script *step)
 	struct reg_script_context ctx;
 
 	ctx.display_state = REG_SCRIPT_DISPLAY_NOTHING;
+	ctx.bus = NULL;
 	reg_script_set_dev(&ctx, dev);
 	reg_script_set_step(&ctx, step);
 	reg_script_run_with_context(&ctx);
@@ -27,6 +27,12 @@
  * write and the data write results in blocks being allocated but not
  * entirely written. It's up to the user of the library to sanity check
  * data stored.
+ *
+ * Emptying a full file only erases its first erase block, which is enough
+ * to mark it empty. The erase blocks an allocation or update reaches into
+ * are erased when they are about to be written and don't read back blank.
+ * All bytes behind the latest update stay erased that way, while the cost
+ * of an erase is spread over the updates that need the space.
  */
 
 #define REGF_BLOCK_SHIFT		4
@@ -35,6 +41,8 @@
 #define REGF_UNALLOCATED_BLOCK		0xffff
 #define REGF_UPDATES_PER_METADATA_BLOCK	\
 	(REGF_METADATA_BLOCK_SIZE / sizeof(uint16_t))
+#define REGF_ERASE_BLOCK_SIZE		(4 * KiB)
+#define REGF_WRITE_PAGE_SIZE		256
 
 enum {
 	RF_ONLY_METADATA = 0,
@@ -255,6 +263,79 @@ int region_file_data(const struct region_file *f, struct region_device *rdev)
 	return rdev_chain(rdev, &f->rdev, offset, size);
 }
 
+int region_file_data_history(const struct region_file *f, size_t age,
+			     struct region_device *rdev)
+{
+	uint16_t blocks[2];
+	size_t offset;
+	size_t size;
+
+	if (age == 0)
+		return region_file_data(f, rdev);
+
+	/* Slot indicates if any data is available, slot 0 is the end of the metadata. */
+	if (f->slot <= RF_ONLY_METADATA || age >= f->slot)
+		return -1;
+
+	offset = (f->slot - age - 1) * sizeof(blocks[0]);
+	if (rdev_readat(&f->metadata, blocks, offset, sizeof(blocks)) < 0)
+		return -1;
+
+	/* Same checks as fill_data_boundaries() does for the latest update. */
+	if (blocks[0] >= blocks[1] ||
+	    blocks[1] > bytes_to_block(region_device_sz(&f->rdev)))
+		return -1;
+
+	offset = block_to_bytes(blocks[0]);
+	size = block_to_bytes(blocks[1]) - offset;
+
+	return rdev_chain(rdev, &f->rdev, offset, size);
+}
+
+static int erase_block_is_blank(const struct region_file *f, size_t offset, size_t size)
+{
+	uint8_t buf[64];
+	size_t i, len;
+
+	while (size) {
+		len = MIN(size, sizeof(buf));
+		if (rdev_readat(&f->rdev, buf, offset, len) != len)
+			return 0;
+		for (i = 0; i < len; i++) {
+			if (buf[i] != 0xff)
+				return 0;
+		}
+		offset += len;
+		size -= len;
+	}
+
+	return 1;
+}
+
+/*
+ * Make sure the erase blocks starting in [begin, end) can be written. The
+ * erase block that begin lies in is already prepared, it holds the end of
+ * the previous update or belongs to the range an empty file starts with.
+ */
+static int prepare_erase_blocks(const struct region_file *f, size_t begin, size_t end)
+{
+	const size_t region_size = region_device_sz(&f->rdev);
+	size_t offset, size;
+
+	for (offset = ALIGN_UP(begin, REGF_ERASE_BLOCK_SIZE); offset < end;
+	     offset += REGF_ERASE_BLOCK_SIZE) {
+		size = MIN(REGF_ERASE_BLOCK_SIZE, region_size - offset);
+		if (erase_block_is_blank(f, offset, size))
+			continue;
+		if (rdev_eraseat(&f->rdev, offset, size) != size) {
+			printk(BIOS_ERR, "REGF erase at 0x%zx failed.\n", offset);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 /*
  * Allocate enough metadata blocks to maximize data updates. Do this in
  * terms of blocks. To solve the balance of metadata vs data, 2 linear
@@ -306,8 +387,11 @@ static int allocate_metadata(struct region_file *f, size_t data_blks)
 	/* Now calculate how many metadata blocks are needed. */
 	y = ALIGN_UP(x, a) / a;
 
-	/* Need to commit the metadata allocation. */
+	/* Need to commit the metadata allocation. Nothing in an empty file is
+	 * valid, so the whole range of the first update can be erased. */
 	tot_metadata = m * y;
+	if (prepare_erase_blocks(f, 0, block_to_bytes(tot_metadata + d)))
+		return -1;
 	if (rdev_writeat(&f->rdev, &tot_metadata, 0, sizeof(tot_metadata)) < 0)
 		return -1;
 
@@ -347,6 +431,15 @@ static int update_can_fit(const struct region_file *f, size_t data_blks)
 	return 1;
 }
 
+int region_file_update_fits(const struct region_file *f, size_t size)
+{
+	/* Empty or to be emptied files have nothing that could be kept. */
+	if (f->slot < RF_ONLY_METADATA)
+		return 0;
+
+	return update_can_fit(f, bytes_to_block(ALIGN_UP(size, REGF_BLOCK_GRANULARITY)));
+}
+
 static int commit_data_allocation(struct region_file *f, size_t data_blks)
 {
 	size_t offset;
@@ -364,16 +457,56 @@ static int commit_data_allocation(struct region_file *f, size_t data_blks)
 	return 0;
 }
 
+/*
+ * Flash is programmed in pages. Entries that end within a page, like a header
+ * in front of the data, are gathered so each page is written only once.
+ */
 static int commit_data(const struct region_file *f,
 		       const struct update_region_file_entry *entries,
 		       size_t num_entries)
 {
+	uint8_t page[REGF_WRITE_PAGE_SIZE];
 	size_t offset = block_to_bytes(region_file_data_begin(f));
+	size_t fill = 0;
+
 	for (int i = 0; i < num_entries; i++) {
-		if (rdev_writeat(&f->rdev, entries[i].data, offset, entries[i].size) < 0)
-			return -1;
-		offset += entries[i].size;
+		const uint8_t *data = entries[i].data;
+		size_t size = entries[i].size;
+
+		while (size) {
+			const size_t pos = offset + fill;
+			const size_t page_end = ALIGN_DOWN(pos, sizeof(page)) + sizeof(page);
+			size_t len;
+
+			/* Nothing gathered, write all pages the entry fills directly. */
+			if (fill == 0 && size >= page_end - pos) {
+				len = ALIGN_DOWN(pos + size, sizeof(page)) - pos;
+				if (rdev_writeat(&f->rdev, data, pos, len) != len)
+					return -1;
+				offset += len;
+				data += len;
+				size -= len;
+				continue;
+			}
+
+			len = MIN(size, page_end - pos);
+			memcpy(&page[fill], data, len);
+			fill += len;
+			data += len;
+			size -= len;
+
+			if (pos + len == page_end) {
+				if (rdev_writeat(&f->rdev, page, offset, fill) != fill)
+					return -1;
+				offset += fill;
+				fill = 0;
+			}
+		}
 	}
+
+	if (fill && rdev_writeat(&f->rdev, page, offset, fill) != fill)
+		return -1;
+
 	return 0;
 }
 
@@ -392,7 +525,10 @@ static int handle_empty(struct region_file *f, size_t data_blks)
 
 static int handle_need_to_empty(struct region_file *f)
 {
-	if (rdev_eraseat(&f->rdev, 0, region_device_sz(&f->rdev)) < 0) {
+	const size_t size = MIN(REGF_ERASE_BLOCK_SIZE, region_device_sz(&f->rdev));
+
+	/* An unallocated first metadata block marks the file empty. */
+	if (rdev_eraseat(&f->rdev, 0, size) != size) {
 		printk(BIOS_ERR, "REGF empty failed.\n");
 		return -1;
 	}
@@ -412,6 +548,12 @@ static int handle_update(struct region_file *f, size_t blocks,
 		return 0;
 	}
 
+	if (prepare_erase_blocks(f, block_to_bytes(region_file_data_end(f)),
+				 block_to_bytes(region_file_data_end(f) + blocks))) {
+		printk(BIOS_ERR, "REGF failed to prepare data blocks.\n");
+		return -1;
+	}
+
 	if (commit_data_allocation(f, blocks)) {
 		printk(BIOS_ERR, "REGF failed to commit data allocation.\n");
 		return -1;
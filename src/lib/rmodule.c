@@ -111,26 +111,35 @@ static inline size_t rmodule_number_relocations(const struct rmodule *module)
 	return r;
 }
 
-static void rmodule_copy_payload(const struct rmodule *module)
+static void rmodule_adjust(uintptr_t *adjust_loc, uintptr_t adjustment)
 {
-	printk(BIOS_DEBUG, "Loading module at %p with entry %p. "
-	       "filesize: 0x%x memsize: 0x%x\n",
-	       module->location, rmodule_entry(module),
-	       module->payload_size, rmodule_memory_size(module));
-
-	/* No need to copy the payload if the load location and the
-	 * payload location are the same. */
-	if (module->location == module->payload)
-		return;
-
-	memcpy(module->location, module->payload, module->payload_size);
+	printk(PK_ADJ_LEVEL, "Adjusting %p: 0x%08lx -> 0x%08lx\n",
+	       adjust_loc, (unsigned long) *adjust_loc,
+	       (unsigned long) (*adjust_loc + adjustment));
+	*adjust_loc += adjustment;
 }
 
-static int rmodule_relocate(const struct rmodule *module)
+/*
+ * Copy the payload to the load location and apply the relocations in the same pass.
+ * rmodtool emits the relocations sorted by address, so the payload is copied piecewise
+ * up to each relocated word, which is then adjusted while it's still hot in the cache.
+ * This avoids a second walk over a freshly copied image. Out of order relocations or
+ * ones outside of the payload are adjusted at their load address like before.
+ */
+static int rmodule_copy_and_relocate(const struct rmodule *module)
 {
+	const uintptr_t link_start = module->header->module_link_start_address;
+	const char *src = module->payload;
+	char *dst = module->location;
 	size_t num_relocations;
 	const uintptr_t *reloc;
 	uintptr_t adjustment;
+	size_t copied = 0;
+
+	printk(BIOS_DEBUG, "Loading module at %p with entry %p. "
+	       "filesize: 0x%x memsize: 0x%x\n",
+	       module->location, rmodule_entry(module),
+	       module->payload_size, rmodule_memory_size(module));
 
 	/* Each relocation needs to be adjusted relative to the beginning of
 	 * the loaded program. */
@@ -142,20 +151,26 @@ static int rmodule_relocate(const struct rmodule *module)
 	printk(BIOS_DEBUG, "Processing %zu relocs. Offset value of 0x%08lx\n",
 	       num_relocations, (unsigned long)adjustment);
 
-	while (num_relocations > 0) {
-		uintptr_t *adjust_loc;
+	/* No need to copy the payload if the load location and the
+	 * payload location are the same. */
+	if (module->location == module->payload)
+		copied = module->payload_size;
 
-		/* If the adjustment location is non-NULL adjust it. */
-		adjust_loc = rmodule_load_addr(module, *reloc);
-		printk(PK_ADJ_LEVEL, "Adjusting %p: 0x%08lx -> 0x%08lx\n",
-		       adjust_loc, (unsigned long) *adjust_loc,
-		       (unsigned long) (*adjust_loc + adjustment));
-		*adjust_loc += adjustment;
+	for (; num_relocations > 0; reloc++, num_relocations--) {
+		const size_t end = MIN(*reloc - link_start + sizeof(uintptr_t),
+				       (size_t)module->payload_size);
 
-		reloc++;
-		num_relocations--;
+		if (end > copied) {
+			memcpy(&dst[copied], &src[copied], end - copied);
+			copied = end;
+		}
+
+		rmodule_adjust(rmodule_load_addr(module, *reloc), adjustment);
 	}
 
+	if (module->payload_size > copied)
+		memcpy(&dst[copied], &src[copied], module->payload_size - copied);
+
 	return 0;
 }
 
@@ -173,15 +188,14 @@ int rmodule_load(void *base, struct rmodule *module)
 	/*
 	 * In order to load the module at a given address, the following steps
 	 * take place:
-	 *  1. Copy payload to base address.
-	 *  2. Adjust relocations within the module to new base address.
-	 *  3. Clear the bss segment last since the relocations live where
+	 *  1. Copy payload to base address and adjust relocations within
+	 *     the module to the new base address while doing so.
+	 *  2. Clear the bss segment last since the relocations live where
 	 *     the bss is. If an rmodule is being loaded from its load
 	 *     address the relocations need to be processed before the bss.
 	 */
 	module->location = base;
-	rmodule_copy_payload(module);
-	if (rmodule_relocate(module))
+	if (rmodule_copy_and_relocate(module))
 		return -1;
 	rmodule_clear_bss(module);
 
@@ -11,8 +11,17 @@
 #include <program_loading.h>
 #include <timestamp.h>
 #include <cbmem.h>
+#include <stdlib.h>
 #include <types.h>
 
+#if CONFIG(PAYLOAD_PARALLEL_DECOMPRESSION)
+#include <arch/cpu.h>
+#include <cpu/x86/mp.h>
+#include <smp/atomic.h>
+#include <smp/spinlock.h>
+#include <timer.h>
+#endif
+
 /* The type syntax for C is essentially unparsable. -- Rob Pike */
 typedef int (*checker_t)(struct cbfs_payload_segment *cbfssegs, void *args);
 
@@ -87,6 +96,15 @@ static int load_one_segment(uint8_t *dest,
 			return 0;
 		break;
 	}
+	case CBFS_COMPRESS_ZSTD: {
+		printk(BIOS_DEBUG, "using Zstandard\n");
+		timestamp_add_now(TS_UZSTD_START);
+		len = uzstdn(src, len, dest, memsz);
+		timestamp_add_now(TS_UZSTD_END);
+		if (!len) /* Decompression Error. */
+			return 0;
+		break;
+	}
 	case CBFS_COMPRESS_NONE: {
 		printk(BIOS_DEBUG, "it's not compressed!\n");
 		memcpy(dest, src, len);
@@ -124,6 +142,212 @@ static int load_one_segment(uint8_t *dest,
 	return 1;
 }
 
+#if CONFIG(PAYLOAD_PARALLEL_DECOMPRESSION)
+struct segment_job {
+	uint8_t *dest;
+	const uint8_t *src;
+	size_t len;
+	size_t memsz;
+	uint32_t compression;
+	int flags;
+	void *lzma_scratchpad;
+	bool failed;
+};
+
+/* Segments waiting to be expanded in parallel. Static, so that an AP accepting the work late
+   can't access a stale stack frame after the BSP already finished all jobs. */
+static struct {
+	struct segment_job jobs[32];
+	int count;
+	int next;
+	atomic_t done;
+} segment_queue;
+
+DECLARE_SPIN_LOCK(segment_queue_lock)
+
+static bool expand_segment(struct segment_job *job)
+{
+	size_t len;
+
+	switch (job->compression) {
+	case CBFS_COMPRESS_LZMA:
+		len = ulzman_scratch(job->src, job->len, job->dest, job->memsz,
+				     job->lzma_scratchpad, LZMA_SCRATCHPAD_SIZE);
+		if (!len)
+			return false;
+		break;
+	case CBFS_COMPRESS_LZ4:
+		len = ulz4fn(job->src, job->len, job->dest, job->memsz);
+		if (!len)
+			return false;
+		break;
+	case CBFS_COMPRESS_NONE:
+		len = job->len;
+		memcpy(job->dest, job->src, len);
+		break;
+	default:
+		return false;
+	}
+
+	if (len < job->memsz)
+		memset(job->dest + len, 0, job->memsz - len);
+
+	return true;
+}
+
+/* Runs on the BSP and all APs: keep taking jobs until there are none left. */
+static void segment_worker(void *unused)
+{
+	while (1) {
+		struct segment_job *job = NULL;
+
+		spin_lock(&segment_queue_lock);
+		if (segment_queue.next < segment_queue.count)
+			job = &segment_queue.jobs[segment_queue.next++];
+		spin_unlock(&segment_queue_lock);
+
+		if (!job)
+			return;
+
+		job->failed = !expand_segment(job);
+		atomic_inc(&segment_queue.done);
+	}
+}
+
+static int run_segment_queue(void)
+{
+	bool has_lzma = false, has_lz4 = false;
+	int i, ret = 1;
+
+	if (!segment_queue.count)
+		return 1;
+
+	for (i = 0; i < segment_queue.count; i++) {
+		has_lzma |= segment_queue.jobs[i].compression == CBFS_COMPRESS_LZMA;
+		has_lz4 |= segment_queue.jobs[i].compression == CBFS_COMPRESS_LZ4;
+	}
+
+	printk(BIOS_DEBUG, "Expanding %d payload segments in parallel\n", segment_queue.count);
+	if (has_lzma)
+		timestamp_add_now(TS_ULZMA_START);
+	if (has_lz4)
+		timestamp_add_now(TS_ULZ4F_START);
+
+	segment_queue.next = 0;
+	atomic_set(&segment_queue.done, 0);
+
+	/* If the APs don't pick up the work the BSP just does all of it by itself. */
+	if (mp_run_on_all_aps(segment_worker, NULL, 100 * USECS_PER_MSEC, true) != CB_SUCCESS)
+		printk(BIOS_WARNING, "Payload segments are expanded by the BSP only\n");
+	segment_worker(NULL);
+
+	while (atomic_read(&segment_queue.done) < segment_queue.count)
+		cpu_relax();
+
+	if (has_lzma)
+		timestamp_add_now(TS_ULZMA_END);
+	if (has_lz4)
+		timestamp_add_now(TS_ULZ4F_END);
+
+	for (i = 0; i < segment_queue.count; i++) {
+		struct segment_job *job = &segment_queue.jobs[i];
+
+		if (job->failed) {
+			printk(BIOS_ERR, "Expanding segment at %p (compression %d) failed\n",
+			       job->dest, job->compression);
+			ret = 0;
+			continue;
+		}
+		prog_segment_loaded((uintptr_t)job->dest, job->memsz, job->flags);
+	}
+
+	/* The heap can only release the most recent allocation, so free in reverse order. */
+	for (i = segment_queue.count - 1; i >= 0; i--)
+		free(segment_queue.jobs[i].lzma_scratchpad);
+
+	segment_queue.count = 0;
+
+	return ret;
+}
+
+static bool segment_overlaps_queue(const uint8_t *dest, size_t memsz)
+{
+	int i;
+
+	for (i = 0; i < segment_queue.count; i++) {
+		const struct segment_job *job = &segment_queue.jobs[i];
+		if (dest < job->dest + job->memsz && job->dest < dest + memsz)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Queue a segment to be expanded later by run_segment_queue(). Segments whose destinations
+ * overlap are never in the queue together, so the order in which they are written still
+ * follows the order in the payload.
+ */
+static int queue_one_segment(uint8_t *dest, uint8_t *src, size_t len, size_t memsz,
+			     uint32_t compression, int flags)
+{
+	struct segment_job *job;
+	void *lzma_scratchpad = NULL;
+
+	if (segment_queue.count == ARRAY_SIZE(segment_queue.jobs) ||
+	    segment_overlaps_queue(dest, memsz)) {
+		if (!run_segment_queue())
+			return 0;
+	}
+
+	switch (compression) {
+	case CBFS_COMPRESS_LZMA:
+		/* The default ulzman() scratchpad is static, every job needs its own. */
+		lzma_scratchpad = malloc(LZMA_SCRATCHPAD_SIZE);
+		if (!lzma_scratchpad) {
+			if (!run_segment_queue())
+				return 0;
+			return load_one_segment(dest, src, len, memsz, compression, flags);
+		}
+		break;
+	case CBFS_COMPRESS_LZ4:
+	case CBFS_COMPRESS_NONE:
+		break;
+	case CBFS_COMPRESS_ZSTD:
+		/* The Zstandard decoder state is static, it only runs on one CPU at a time. */
+	default:
+		/* Let the serial path report it. */
+		if (!run_segment_queue())
+			return 0;
+		return load_one_segment(dest, src, len, memsz, compression, flags);
+	}
+
+	job = &segment_queue.jobs[segment_queue.count++];
+	*job = (struct segment_job) {
+		.dest = dest,
+		.src = src,
+		.len = len,
+		.memsz = memsz,
+		.compression = compression,
+		.flags = flags,
+		.lzma_scratchpad = lzma_scratchpad,
+	};
+
+	return 1;
+}
+#else
+static int run_segment_queue(void)
+{
+	return 1;
+}
+
+static int queue_one_segment(uint8_t *dest, uint8_t *src, size_t len, size_t memsz,
+			     uint32_t compression, int flags)
+{
+	return load_one_segment(dest, src, len, memsz, compression, flags);
+}
+#endif
+
 /* Note: this function is a bit dangerous so is not exported.
  * It assumes you're smart enough not to call it with the very
  * last segment, since it uses seg + 1 */
@@ -208,6 +432,8 @@ static int load_payload_segments(struct cbfs_payload_segment *cbfssegs, uintptr_
 			 * as last segment. Thus, we use the occurrence of the
 			 * entry point as break condition for the loop.
 			 */
+			if (!run_segment_queue())
+				return -1;
 			return 0;
 
 		default:
@@ -222,7 +448,7 @@ static int load_payload_segments(struct cbfs_payload_segment *cbfssegs, uintptr_
 		 * is always last. */
 		if (last_loadable_segment(seg))
 			flags = SEG_FINAL;
-		if (!load_one_segment(dest, src, filesz, memsz, compression, flags))
+		if (!queue_one_segment(dest, src, filesz, memsz, compression, flags))
 			return -1;
 	}
 
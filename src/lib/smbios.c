@@ -27,10 +27,111 @@ static u8 smbios_checksum(u8 *p, u32 length)
 	return -ret;
 }
 
+/*
+ * The string table that a string was last added to. Tables are filled one at a time, so
+ * remembering its length and a hash set of its strings makes adding a string and getting
+ * the table length independent of the number of strings already in it.
+ */
+#define STRING_SET_SIZE 64
+
+static struct {
+	const u8 *start;
+	size_t len;		/* Without the final '\0' */
+	int count;
+	bool overflow;		/* Some strings aren't in the set */
+	struct {
+		uint32_t hash;
+		uint16_t offset;
+		uint8_t index;	/* 0 for empty slots */
+	} set[STRING_SET_SIZE];
+} strings;
+
+static uint32_t string_hash(const char *str)
+{
+	uint32_t hash = 0x811c9dc5;
+
+	while (*str)
+		hash = (hash ^ (unsigned char)*str++) * 0x01000193;
+
+	return hash;
+}
+
+static void string_set_insert(uint32_t hash, size_t offset, int index)
+{
+	size_t i, slot;
+
+	/* Keep the set half empty, so probe sequences stay short. */
+	if (index > STRING_SET_SIZE / 2 || offset > UINT16_MAX) {
+		strings.overflow = true;
+		return;
+	}
+
+	for (i = 0; i < STRING_SET_SIZE; i++) {
+		slot = (hash + i) % STRING_SET_SIZE;
+		if (strings.set[slot].index)
+			continue;
+		strings.set[slot].hash = hash;
+		strings.set[slot].offset = offset;
+		strings.set[slot].index = index;
+		return;
+	}
+}
+
+static int string_set_find(const u8 *start, const char *str, uint32_t hash)
+{
+	const char *p;
+	size_t i, slot;
+	int index;
+
+	for (i = 0; i < STRING_SET_SIZE; i++) {
+		slot = (hash + i) % STRING_SET_SIZE;
+		if (!strings.set[slot].index)
+			break;
+		if (strings.set[slot].hash == hash &&
+		    !strcmp((const char *)start + strings.set[slot].offset, str))
+			return strings.set[slot].index;
+	}
+
+	if (!strings.overflow)
+		return 0;
+
+	/* Walk the strings that didn't fit into the set. */
+	for (p = (const char *)start, index = 1; *p; p += strlen(p) + 1, index++) {
+		if (index > STRING_SET_SIZE / 2 && !strcmp(p, str))
+			return index;
+	}
+
+	return 0;
+}
+
+/* Whether the remembered state still describes the string table at start. */
+static bool string_table_is_current(const u8 *start)
+{
+	if (strings.start != start || start[strings.len] != '\0')
+		return false;
+
+	return !strings.len || (start[0] != '\0' && start[strings.len - 1] == '\0');
+}
+
+static void string_table_load(const u8 *start)
+{
+	const char *p;
+
+	memset(&strings, 0, sizeof(strings));
+	strings.start = start;
+
+	while (start[strings.len]) {
+		p = (const char *)start + strings.len;
+		string_set_insert(string_hash(p), strings.len, ++strings.count);
+		strings.len += strlen(p) + 1;
+	}
+}
+
 int smbios_add_string(u8 *start, const char *str)
 {
-	int i = 1;
-	char *p = (char *)start;
+	uint32_t hash;
+	size_t len;
+	int index;
 
 	/*
 	 * Return 0 as required for empty strings.
@@ -39,21 +140,21 @@ int smbios_add_string(u8 *start, const char *str)
 	if (str == NULL || *str == '\0')
 		return 0;
 
-	for (;;) {
-		if (!*p) {
-			strcpy(p, str);
-			p += strlen(str);
-			*p++ = '\0';
-			*p++ = '\0';
-			return i;
-		}
+	if (!string_table_is_current(start))
+		string_table_load(start);
 
-		if (!strcmp(p, str))
-			return i;
+	hash = string_hash(str);
+	index = string_set_find(start, str, hash);
+	if (index)
+		return index;
 
-		p += strlen(p)+1;
-		i++;
-	}
+	len = strlen(str);
+	memcpy(start + strings.len, str, len + 1);
+	string_set_insert(hash, strings.len, ++strings.count);
+	strings.len += len + 1;
+	start[strings.len] = '\0';
+
+	return strings.count;
 }
 
 int smbios_string_table_len(u8 *start)
@@ -61,6 +162,9 @@ int smbios_string_table_len(u8 *start)
 	char *p = (char *)start;
 	int i, len = 0;
 
+	if (string_table_is_current(start))
+		return strings.len ? strings.len + 1 : 2;
+
 	while (*p) {
 		i = strlen(p) + 1;
 		p += i;
@@ -84,6 +188,8 @@ void *smbios_carve_table(unsigned long start, u8 type, u8 length, u16 handle)
 
 	assert(length >= sizeof(*t));
 	memset(t, 0, length);
+	/* The string table of a new table may be where the previous one was. */
+	strings.start = NULL;
 	t->type = type;
 	t->length = length - 2;
 	t->handle = handle;
@@ -150,21 +150,24 @@ static bool get_cached_dimm_present(uint8_t *spd_cache, uint8_t idx)
 bool check_if_dimm_changed(u8 *spd_cache, struct spd_block *blk)
 {
 	int i;
-	u32 sn;
+	u32 sn[SC_SPD_NUMS];
 	bool dimm_present_in_cache;
 	bool dimm_changed = false;
+
+	/* Only the serial numbers are read, the full SPD is read again if anything changed. */
+	/* Return true if any error happened here. */
+	if (get_spd_sns(blk, sn) == CB_ERR)
+		return true;
+
 	/* Check if the dimm is the same with last system boot. */
 	for (i = 0; i < SC_SPD_NUMS && !dimm_changed; i++) {
 		if (blk->addr_map[i] == 0) {
 			printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d does not exist\n", i);
 			continue;
 		}
-		/* Return true if any error happened here. */
-		if (get_spd_sn(blk->addr_map[i], &sn) == CB_ERR)
-			return true;
 		dimm_present_in_cache = get_cached_dimm_present(spd_cache, i);
 		/* Dimm is not present now. */
-		if (sn == 0xffffffff) {
+		if (sn[i] == 0xffffffff) {
 			if (!dimm_present_in_cache)
 				printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is not present\n", i);
 			else {
@@ -173,7 +176,7 @@ bool check_if_dimm_changed(u8 *spd_cache, struct spd_block *blk)
 			}
 		} else { /* Dimm is present now. */
 			if (dimm_present_in_cache) {
-				if (memcmp(&sn, spd_cache + SC_SPD_OFFSET(i) + DDR4_SPD_SN_OFF,
+				if (memcmp(&sn[i], spd_cache + SC_SPD_OFFSET(i) + DDR4_SPD_SN_OFF,
 						SPD_SN_LEN) == 0)
 					printk(BIOS_NOTICE, "SPD_CACHE: DIMM%d is the same\n",
 											i);
@@ -3,12 +3,14 @@
 #include <assert.h>
 #include <bootstate.h>
 #include <console/console.h>
+#include <lib.h>
 #include <smp/node.h>
 #include <thread.h>
 #include <timer.h>
 #include <types.h>
 
-static u8 thread_stacks[CONFIG_STACK_SIZE * CONFIG_NUM_THREADS] __aligned(sizeof(uint64_t));
+static u8 thread_stacks[CONFIG_STACK_SIZE * CONFIG_NUM_THREADS] __aligned(sizeof(uint64_t))
+	__noinit;
 static bool initialized;
 
 static void idle_thread_init(void);
@@ -26,6 +28,9 @@ static struct thread *free_threads;
 
 static struct thread *active_thread;
 
+/* When the running thread got the CPU, see COOP_TIME_SLICE. */
+static struct mono_time slice_start;
+
 static inline int thread_can_yield(const struct thread *t)
 {
 	return (t != NULL && t->can_yield > 0);
@@ -99,15 +104,31 @@ static inline void free_thread(struct thread *t)
 	push_thread(&free_threads, t);
 }
 
+__weak void arch_thread_idle_until(const struct mono_time *deadline)
+{
+	struct mono_time now;
+
+	do {
+		cpu_relax();
+		timer_monotonic_get(&now);
+	} while (mono_time_before(&now, deadline));
+}
+
 /* The idle thread is ran whenever there isn't anything else that is runnable.
  * It's sole responsibility is to ensure progress is made by running the timer
- * callbacks. */
+ * callbacks. Only a timer callback can make a thread runnable again, so it
+ * can wait for the next one to be due without looking at the queue. */
 __noreturn static enum cb_err idle_thread(void *unused)
 {
+	struct mono_time next;
+
 	/* This thread never voluntarily yields. */
 	thread_coop_disable();
-	while (1)
+	while (1) {
 		timers_run();
+		if (!timer_next_expiration(&next))
+			arch_thread_idle_until(&next);
+	}
 }
 
 static void schedule(struct thread *t)
@@ -129,6 +150,9 @@ static void schedule(struct thread *t)
 
 	set_current_thread(t);
 
+	if (CONFIG(COOP_TIME_SLICE))
+		timer_monotonic_get(&slice_start);
+
 	switch_to_thread(t->stack_current, &current->stack_current);
 }
 
@@ -247,6 +271,9 @@ static void threads_initialize(void)
 	if (initialized)
 		return;
 
+	if (CONFIG(MEM_USAGE_STATS))
+		stack_poison(thread_stacks, sizeof(thread_stacks));
+
 	t = &all_threads[0];
 
 	set_current_thread(t);
@@ -266,6 +293,9 @@ static void threads_initialize(void)
 
 	idle_thread_init();
 
+	if (CONFIG(COOP_TIME_SLICE))
+		timer_monotonic_get(&slice_start);
+
 	initialized = 1;
 }
 
@@ -355,6 +385,17 @@ int thread_yield_microseconds(unsigned int microsecs)
 	return 0;
 }
 
+void thread_time_slice_check(const struct mono_time *now)
+{
+	if (!thread_can_yield(current_thread()))
+		return;
+
+	if (mono_time_diff_microseconds(&slice_start, now) < CONFIG_COOP_TIME_SLICE_US)
+		return;
+
+	thread_yield();
+}
+
 void thread_coop_enable(void)
 {
 	struct thread *current;
@@ -423,3 +464,17 @@ void thread_mutex_unlock(struct thread_mutex *mutex)
 	assert(mutex->locked);
 	mutex->locked = 0;
 }
+
+size_t thread_stack_peak_usage(void)
+{
+	size_t i, peak = 0;
+
+	if (!CONFIG(MEM_USAGE_STATS) || !initialized)
+		return 0;
+
+	for (i = 0; i < CONFIG_NUM_THREADS; i++)
+		peak = MAX(peak, stack_usage(&thread_stacks[i * CONFIG_STACK_SIZE],
+					     CONFIG_STACK_SIZE));
+
+	return peak;
+}
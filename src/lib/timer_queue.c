@@ -2,10 +2,12 @@
 
 #include <timer.h>
 
-#define MAX_TIMER_QUEUE_ENTRIES 64
+#define MAX_TIMER_QUEUE_ENTRIES CONFIG_TIMER_QUEUE_ENTRIES
 
 /* The timer queue is implemented using a min heap. Therefore the first
- * element is the one with smallest time to expiration. */
+ * element is the one with smallest time to expiration. Every queued
+ * timeout_callback knows its own slot, so it can be cancelled without
+ * searching the heap. */
 struct timer_queue {
 	int num_entries;
 	int max_entries;
@@ -35,18 +37,25 @@ static inline struct timeout_callback *timer_queue_head(struct timer_queue *tq)
 	return tq->queue[0];
 }
 
-static int timer_queue_insert(struct timer_queue *tq,
-			      struct timeout_callback *tocb)
+static inline void timer_queue_set(struct timer_queue *tq, int index,
+				   struct timeout_callback *tocb)
 {
-	int index;
+	tq->queue[index] = tocb;
+	tocb->index = index;
+}
 
-	/* No more slots. */
-	if (timer_queue_full(tq))
-		return -1;
+static inline int timer_queue_contains(struct timer_queue *tq,
+				       const struct timeout_callback *tocb)
+{
+	/* The index of a callback that isn't queued may be stale. */
+	return tocb->index >= 0 && tocb->index < tq->num_entries &&
+	       tq->queue[tocb->index] == tocb;
+}
 
-	index = tq->num_entries;
-	tq->num_entries++;
-	tq->queue[index] = tocb;
+/* Move the entry at index towards the root until its parent is not later. */
+static void timer_queue_sift_up(struct timer_queue *tq, int index)
+{
+	struct timeout_callback *tocb = tq->queue[index];
 
 	while (index != 0) {
 		struct timeout_callback *parent;
@@ -60,13 +69,11 @@ static int timer_queue_insert(struct timer_queue *tq,
 			break;
 
 		/* The parent is greater than current. Swap them. */
-		tq->queue[parent_index] = tocb;
-		tq->queue[index] = parent;
-
+		timer_queue_set(tq, index, parent);
 		index = parent_index;
 	}
 
-	return 0;
+	timer_queue_set(tq, index, tocb);
 }
 
 /* Get the index containing the entry with smallest value. */
@@ -92,18 +99,11 @@ static int timer_queue_min_child_index(struct timer_queue *tq, int index)
 	return right_child_index;
 }
 
-static void timer_queue_remove_head(struct timer_queue *tq)
+/* Move the entry at index away from the root until no child is earlier. */
+static void timer_queue_sift_down(struct timer_queue *tq, int index)
 {
-	int index;
-	struct timeout_callback *tocb;
+	struct timeout_callback *tocb = tq->queue[index];
 
-	/* In order to remove the head the deepest child is replaced in the
-	 * head slot and bubbled down the tree. */
-	tq->num_entries--;
-	tocb = tq->queue[tq->num_entries];
-	tq->queue[0] = tocb;
-
-	index = 0;
 	while (1) {
 		int min_child_index;
 		struct timeout_callback *child;
@@ -122,11 +122,43 @@ static void timer_queue_remove_head(struct timer_queue *tq)
 			break;
 
 		/* Need to swap with smallest child. */
-		tq->queue[min_child_index] = tocb;
-		tq->queue[index] = child;
-
+		timer_queue_set(tq, index, child);
 		index = min_child_index;
 	}
+
+	timer_queue_set(tq, index, tocb);
+}
+
+static int timer_queue_insert(struct timer_queue *tq,
+			      struct timeout_callback *tocb)
+{
+	/* No more slots. */
+	if (timer_queue_full(tq))
+		return -1;
+
+	timer_queue_set(tq, tq->num_entries++, tocb);
+	timer_queue_sift_up(tq, tocb->index);
+
+	return 0;
+}
+
+static void timer_queue_remove(struct timer_queue *tq, int index)
+{
+	struct timeout_callback *removed = tq->queue[index];
+	struct timeout_callback *last;
+
+	/* The deepest entry takes the slot and then moves to its place,
+	 * which may be up or down when the slot isn't the head. */
+	tq->num_entries--;
+	last = tq->queue[tq->num_entries];
+	removed->index = -1;
+
+	if (index == tq->num_entries)
+		return;
+
+	timer_queue_set(tq, index, last);
+	timer_queue_sift_up(tq, index);
+	timer_queue_sift_down(tq, last->index);
 }
 
 static struct timeout_callback *
@@ -143,7 +175,7 @@ timer_queue_expired(struct timer_queue *tq, struct mono_time *current_time)
 	if (mono_time_before(current_time, &tocb->expiration))
 		return NULL;
 
-	timer_queue_remove_head(tq);
+	timer_queue_remove(tq, 0);
 
 	return tocb;
 }
@@ -155,6 +187,9 @@ int timer_sched_callback(struct timeout_callback *tocb, uint64_t us)
 	if ((long)us < 0)
 		return -1;
 
+	/* Scheduling a queued callback again moves it. */
+	timer_cancel_callback(tocb);
+
 	timer_monotonic_get(&current_time);
 	tocb->expiration = current_time;
 	mono_time_add_usecs(&tocb->expiration, us);
@@ -166,15 +201,40 @@ int timer_sched_callback(struct timeout_callback *tocb, uint64_t us)
 	return timer_queue_insert(&global_timer_queue, tocb);
 }
 
+int timer_cancel_callback(struct timeout_callback *tocb)
+{
+	struct timer_queue *tq = &global_timer_queue;
+
+	if (!timer_queue_contains(tq, tocb))
+		return -1;
+
+	timer_queue_remove(tq, tocb->index);
+
+	return 0;
+}
+
+int timer_next_expiration(struct mono_time *mt)
+{
+	struct timeout_callback *tocb;
+
+	tocb = timer_queue_head(&global_timer_queue);
+
+	if (tocb == NULL)
+		return -1;
+
+	*mt = tocb->expiration;
+
+	return 0;
+}
+
 int timers_run(void)
 {
 	struct timeout_callback *tocb;
 	struct mono_time current_time;
 
+	/* Run everything that is due, callbacks may queue more. */
 	timer_monotonic_get(&current_time);
-	tocb = timer_queue_expired(&global_timer_queue, &current_time);
-
-	if (tocb != NULL)
+	while ((tocb = timer_queue_expired(&global_timer_queue, &current_time)))
 		tocb->callback(tocb);
 
 	return !timer_queue_empty(&global_timer_queue);
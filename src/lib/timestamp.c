@@ -10,10 +10,16 @@
 #include <smp/node.h>
 
 #define MAX_TIMESTAMPS 192
+/* Number of CBMEM_ID_TIMESTAMPx tables a full CBMEM table can continue in */
+#define MAX_TIMESTAMP_TABLES 256
 
 /* This points to the active timestamp_table and can change within a stage
    as CBMEM comes available. */
 static struct timestamp_table *glob_ts_table;
+/* Last table of the chain starting at glob_ts_table, where new entries go */
+static struct timestamp_table *glob_ts_last;
+/* Number of CBMEM_ID_TIMESTAMPx tables in the chain */
+static unsigned int ts_next_tables;
 
 static void timestamp_cache_init(struct timestamp_table *ts_cache,
 				 uint64_t base)
@@ -41,11 +47,11 @@ static struct timestamp_table *timestamp_cache_get(void)
 	return ts_cache;
 }
 
-static struct timestamp_table *timestamp_alloc_cbmem_table(void)
+static struct timestamp_table *timestamp_alloc_cbmem_table(uint32_t id)
 {
 	struct timestamp_table *tst;
 
-	tst = cbmem_add(CBMEM_ID_TIMESTAMP,
+	tst = cbmem_add(id,
 			sizeof(struct timestamp_table) +
 			MAX_TIMESTAMPS * sizeof(struct timestamp_entry));
 
@@ -80,13 +86,65 @@ static struct timestamp_table *timestamp_table_get(void)
 		return glob_ts_table;
 
 	glob_ts_table = timestamp_cache_get();
+	glob_ts_last = glob_ts_table;
 
 	return glob_ts_table;
 }
 
+static struct timestamp_table *timestamp_last_table_get(void)
+{
+	if (!timestamp_table_get())
+		return NULL;
+
+	return glob_ts_last;
+}
+
 static void timestamp_table_set(struct timestamp_table *ts)
 {
 	glob_ts_table = ts;
+	glob_ts_last = ts;
+}
+
+static struct timestamp_table *timestamp_next_table(const struct timestamp_table *ts_table)
+{
+	const struct timestamp_entry *tse;
+
+	if (!ts_table->num_entries || ts_table->num_entries != ts_table->max_entries)
+		return NULL;
+
+	tse = &ts_table->entries[ts_table->num_entries - 1];
+	if (tse->entry_id != TIMESTAMP_TABLE_CONTINUED)
+		return NULL;
+
+	return (struct timestamp_table *)(uintptr_t)tse->entry_stamp;
+}
+
+/* Link a new CBMEM table into the last entry of a full one. */
+static struct timestamp_table *timestamp_extend_table(struct timestamp_table *ts_table)
+{
+	struct timestamp_table *next;
+	struct timestamp_entry *tse;
+
+	/* The cache gets synced to CBMEM and can't continue anywhere. */
+	if (!ENV_HAS_CBMEM || ts_table == timestamp_cache_get())
+		return NULL;
+
+	if (ts_next_tables == MAX_TIMESTAMP_TABLES)
+		return NULL;
+
+	next = timestamp_alloc_cbmem_table(CBMEM_ID_TIMESTAMPx + ts_next_tables);
+	if (!next)
+		return NULL;
+
+	ts_next_tables++;
+	next->base_time = ts_table->base_time;
+	next->tick_freq_mhz = ts_table->tick_freq_mhz;
+
+	tse = &ts_table->entries[ts_table->num_entries++];
+	tse->entry_id = TIMESTAMP_TABLE_CONTINUED;
+	tse->entry_stamp = (uintptr_t)next;
+
+	return next;
 }
 
 static const char *timestamp_name(enum timestamp_id id)
@@ -101,13 +159,22 @@ static const char *timestamp_name(enum timestamp_id id)
 	return "Unknown timestamp ID";
 }
 
-static void timestamp_add_table_entry(struct timestamp_table *ts_table,
-				      enum timestamp_id id, int64_t ts_time)
+/* Returns the table the entry went to, which is the new last table of the chain. */
+static struct timestamp_table *timestamp_add_table_entry(struct timestamp_table *ts_table,
+							  enum timestamp_id id, int64_t ts_time)
 {
+	struct timestamp_table *next;
 	struct timestamp_entry *tse;
 
 	if (ts_table->num_entries >= ts_table->max_entries)
-		return;
+		return ts_table;
+
+	/* The last slot links to the next table, if there can be one. */
+	if (ts_table->num_entries == ts_table->max_entries - 1) {
+		next = timestamp_extend_table(ts_table);
+		if (next)
+			ts_table = next;
+	}
 
 	tse = &ts_table->entries[ts_table->num_entries++];
 	tse->entry_id = id;
@@ -115,6 +182,8 @@ static void timestamp_add_table_entry(struct timestamp_table *ts_table,
 
 	if (ts_table->num_entries == ts_table->max_entries)
 		printk(BIOS_ERR, "Timestamp table full\n");
+
+	return ts_table;
 }
 
 void timestamp_add(enum timestamp_id id, int64_t ts_time)
@@ -124,7 +193,7 @@ void timestamp_add(enum timestamp_id id, int64_t ts_time)
 	if (!timestamp_should_run())
 		return;
 
-	ts_table = timestamp_table_get();
+	ts_table = timestamp_last_table_get();
 
 	if (!ts_table) {
 		printk(BIOS_ERR, "No timestamp table found\n");
@@ -132,7 +201,7 @@ void timestamp_add(enum timestamp_id id, int64_t ts_time)
 	}
 
 	ts_time -= ts_table->base_time;
-	timestamp_add_table_entry(ts_table, id, ts_time);
+	glob_ts_last = timestamp_add_table_entry(ts_table, id, ts_time);
 
 	if (CONFIG(TIMESTAMPS_ON_CONSOLE))
 		printk(BIOS_INFO, "Timestamp - %s: %lld\n", timestamp_name(id), ts_time);
@@ -163,7 +232,9 @@ void timestamp_init(uint64_t base)
 	timestamp_table_set(ts_cache);
 }
 
-static void timestamp_sync_cache_to_cbmem(struct timestamp_table *ts_cbmem_table)
+/* Returns the last table of the chain the cache went to. */
+static struct timestamp_table *
+timestamp_sync_cache_to_cbmem(struct timestamp_table *ts_cbmem_table)
 {
 	uint32_t i;
 	struct timestamp_table *ts_cache_table;
@@ -171,7 +242,7 @@ static void timestamp_sync_cache_to_cbmem(struct timestamp_table *ts_cbmem_table
 	ts_cache_table = timestamp_table_get();
 	if (!ts_cache_table) {
 		printk(BIOS_ERR, "No timestamp cache found\n");
-		return;
+		return ts_cbmem_table;
 	}
 
 	/*
@@ -198,25 +269,28 @@ static void timestamp_sync_cache_to_cbmem(struct timestamp_table *ts_cbmem_table
 
 	for (i = 0; i < ts_cache_table->num_entries; i++) {
 		struct timestamp_entry *tse = &ts_cache_table->entries[i];
-		timestamp_add_table_entry(ts_cbmem_table, tse->entry_id,
-					  tse->entry_stamp);
+		ts_cbmem_table = timestamp_add_table_entry(ts_cbmem_table, tse->entry_id,
+							   tse->entry_stamp);
 	}
 
 	/* Cache no longer required. */
 	ts_cache_table->num_entries = 0;
+
+	return ts_cbmem_table;
 }
 
 static void timestamp_reinit(int is_recovery)
 {
-	struct timestamp_table *ts_cbmem_table;
+	struct timestamp_table *ts_cbmem_table, *ts_last, *ts;
 
 	if (!timestamp_should_run())
 		return;
 
 	/* First time into romstage we make a clean new table. For platforms that travel
 	   through this path on resume, ARCH_X86 S3, timestamps are also reset. */
+	ts_next_tables = 0;
 	if (ENV_CREATES_CBMEM) {
-		ts_cbmem_table = timestamp_alloc_cbmem_table();
+		ts_cbmem_table = timestamp_alloc_cbmem_table(CBMEM_ID_TIMESTAMP);
 	} else {
 		/* Find existing table in cbmem. */
 		ts_cbmem_table = cbmem_find(CBMEM_ID_TIMESTAMP);
@@ -228,14 +302,24 @@ static void timestamp_reinit(int is_recovery)
 		return;
 	}
 
+	/* Find the end of the chain that earlier stages left. */
+	ts_last = ts_cbmem_table;
+	while ((ts = timestamp_next_table(ts_last)) && ts_next_tables < MAX_TIMESTAMP_TABLES) {
+		ts_last = ts;
+		ts_next_tables++;
+	}
+
 	if (ENV_CREATES_CBMEM)
-		timestamp_sync_cache_to_cbmem(ts_cbmem_table);
+		ts_last = timestamp_sync_cache_to_cbmem(ts_cbmem_table);
 
 	/* Seed the timestamp tick frequency in ENV_PAYLOAD_LOADER. */
-	if (ENV_PAYLOAD_LOADER)
-		ts_cbmem_table->tick_freq_mhz = timestamp_tick_freq_mhz();
+	if (ENV_PAYLOAD_LOADER) {
+		for (ts = ts_cbmem_table; ts; ts = timestamp_next_table(ts))
+			ts->tick_freq_mhz = timestamp_tick_freq_mhz();
+	}
 
 	timestamp_table_set(ts_cbmem_table);
+	glob_ts_last = ts_last;
 }
 
 void timestamp_rescale_table(uint16_t N, uint16_t M)
@@ -257,12 +341,16 @@ void timestamp_rescale_table(uint16_t N, uint16_t M)
 		return;
 	}
 
-	ts_table->base_time /= M;
-	ts_table->base_time *= N;
-	for (i = 0; i < ts_table->num_entries; i++) {
-		struct timestamp_entry *tse = &ts_table->entries[i];
-		tse->entry_stamp /= M;
-		tse->entry_stamp *= N;
+	for (; ts_table; ts_table = timestamp_next_table(ts_table)) {
+		ts_table->base_time /= M;
+		ts_table->base_time *= N;
+		for (i = 0; i < ts_table->num_entries; i++) {
+			struct timestamp_entry *tse = &ts_table->entries[i];
+			if (tse->entry_id == TIMESTAMP_TABLE_CONTINUED)
+				continue;
+			tse->entry_stamp /= M;
+			tse->entry_stamp *= N;
+		}
 	}
 }
 
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <cbfs.h>
+#include <commonlib/endian.h>
 #include <console/console.h>
 #include <security/vboot/misc.h>
 #include <stddef.h>
@@ -13,6 +14,7 @@
 #define LANG_ID_LEN 3
 
 #define PRERAM_LOCALES_VERSION_BYTE 0x01
+#define PRERAM_LOCALES_INDEXED_VERSION_BYTE 0x02
 #define PRERAM_LOCALES_NAME "preram_locales"
 
 /* We need different delimiters to deal with the case where 'string_name' is the same as
@@ -34,6 +36,20 @@
  * [\x01]
  * [string_name_2] [\x00] ...
  *
+ * Version 2 of the file puts a hash table between the version byte and the
+ * strings, so a lookup doesn't have to go through all of them:
+ *
+ * [PRERAM_LOCALES_INDEXED_VERSION_BYTE]
+ * [index_size (16-bit LE, power of 2)]
+ * [index_size * { hash, name_offset, offset } (32-bit LE each)]
+ * [string_name_1] [\x00] ... (as in version 1)
+ *
+ * Every language_id of every string_name has an entry, at the first empty slot
+ * starting from (hash % index_size). The hash is FNV-1a over string_name, a
+ * \x00 and language_id. name_offset points to the string_name, offset to the
+ * language_id and both are relative to the start of the file. Empty slots have
+ * an offset of 0.
+ *
  * This file contains tools to locate the file and search for localized strings
  * with specific language ID.
  */
@@ -113,10 +129,118 @@ static size_t search_for_id(const char *data, size_t offset, size_t size,
 	return search_for(data, offset, size, int_to_str, DELIM_STR);
 }
 
+/*
+ * Find the language ID of a string_name in a version 1 file. Returns its offset and the end
+ * of the string_name in *end, or an offset >= *end if there is none.
+ */
+static size_t search_strings(const char *data, size_t size, const char *name,
+			     uint32_t lang_id, size_t *end)
+{
+	size_t offset, name_offset, next_name_offset;
+
+	/* Search for name. Skip the version byte. */
+	offset = search_for_name(data, 1, size, name);
+	if (offset >= size) {
+		printk(BIOS_ERR, "%s: Name %s not found.\n", __func__, name);
+		*end = size;
+		return size;
+	}
+	name_offset = offset;
+
+	/* Search for language ID. We should not search beyond the range of the current
+	   string_name. */
+	next_name_offset = move_next(data, offset, size, DELIM_NAME);
+	assert(next_name_offset <= size);
+	*end = next_name_offset;
+	offset = search_for_id(data,  name_offset, next_name_offset, lang_id);
+	/* Language ID not supported; fallback to English if the current language is not
+	   English (0). */
+	if (offset >= next_name_offset) {
+		/* Since we only support a limited charset, it is very normal that a language
+		   is not supported and we fallback here silently. */
+		if (lang_id != 0)
+			offset = search_for_id(data, name_offset, next_name_offset, 0);
+		if (offset >= next_name_offset)
+			printk(BIOS_ERR, "%s: Neither %d nor 0 found.\n", __func__, lang_id);
+	}
+
+	return offset;
+}
+
+#define INDEX_ENTRY_SIZE (3 * sizeof(uint32_t))
+
+static uint32_t index_hash(const char *name, const char *id)
+{
+	uint32_t hash = 0x811c9dc5;
+
+	do
+		hash = (hash ^ (unsigned char)*name) * 0x01000193;
+	while (*name++);
+	while (*id)
+		hash = (hash ^ (unsigned char)*id++) * 0x01000193;
+
+	return hash;
+}
+
+/* Look up the language ID of a string_name in the index of a version 2 file. */
+static size_t search_index_for_id(const char *data, size_t size, const char *name,
+				  uint32_t lang_id)
+{
+	char id[LANG_ID_LEN] = {};
+	const char *entry;
+	size_t index_size, name_offset, offset, i;
+	uint32_t hash;
+
+	index_size = size >= 3 ? read_le16(data + 1) : 0;
+	if (!index_size || (index_size & (index_size - 1)) ||
+	    3 + index_size * INDEX_ENTRY_SIZE > size)
+		return size;
+
+	snprintf(id, LANG_ID_LEN, "%u", lang_id);
+	hash = index_hash(name, id);
+
+	for (i = 0; i < index_size; i++) {
+		entry = data + 3 + ((hash + i) & (index_size - 1)) * INDEX_ENTRY_SIZE;
+		name_offset = read_le32(entry + 4);
+		offset = read_le32(entry + 8);
+		if (!offset)
+			break;
+		if (read_le32(entry) != hash || name_offset >= size || offset >= size)
+			continue;
+		if (!strncmp(data + name_offset, name, size - name_offset) &&
+		    !strncmp(data + offset, id, size - offset))
+			return offset;
+	}
+
+	return size;
+}
+
+/*
+ * Find the language ID of a string_name in a version 2 file. Like search_strings(), but the
+ * text is only checked to end within the file.
+ */
+static size_t search_index(const char *data, size_t size, const char *name,
+			   uint32_t lang_id, size_t *end)
+{
+	size_t offset;
+
+	*end = size;
+
+	offset = search_index_for_id(data, size, name, lang_id);
+	/* Silently fall back to English, like search_strings(). */
+	if (offset >= size && lang_id != 0)
+		offset = search_index_for_id(data, size, name, 0);
+	if (offset >= size)
+		printk(BIOS_ERR, "%s: Neither %s/%d nor %s/0 found.\n", __func__, name,
+		       lang_id, name);
+
+	return offset;
+}
+
 const char *ux_locales_get_text(const char *name)
 {
 	const char *data;
-	size_t size, offset, name_offset, next_name_offset, next;
+	size_t size, offset, end, next;
 	uint32_t lang_id = 0; /* default language English (0) */
 	unsigned char version;
 
@@ -143,46 +267,26 @@ const char *ux_locales_get_text(const char *name)
 
 	/* Check if the version byte is the expected version. */
 	version = (unsigned char)data[0];
-	if (version != PRERAM_LOCALES_VERSION_BYTE) {
+	if (version == PRERAM_LOCALES_INDEXED_VERSION_BYTE) {
+		offset = search_index(data, size, name, lang_id, &end);
+	} else if (version == PRERAM_LOCALES_VERSION_BYTE) {
+		offset = search_strings(data, size, name, lang_id, &end);
+	} else {
 		printk(BIOS_ERR, "%s: The version %u is not the expected one %u\n",
 		       __func__, version, PRERAM_LOCALES_VERSION_BYTE);
 		return NULL;
 	}
-
-	/* Search for name. Skip the version byte. */
-	offset = search_for_name(data, 1, size, name);
-	if (offset >= size) {
-		printk(BIOS_ERR, "%s: Name %s not found.\n", __func__, name);
+	if (offset >= end)
 		return NULL;
-	}
-	name_offset = offset;
-
-	/* Search for language ID. We should not search beyond the range of the current
-	   string_name. */
-	next_name_offset = move_next(data, offset, size, DELIM_NAME);
-	assert(next_name_offset <= size);
-	offset = search_for_id(data,  name_offset, next_name_offset, lang_id);
-	/* Language ID not supported; fallback to English if the current language is not
-	   English (0). */
-	if (offset >= next_name_offset) {
-		/* Since we only support a limited charset, it is very normal that a language
-		   is not supported and we fallback here silently. */
-		if (lang_id != 0)
-			offset = search_for_id(data, name_offset, next_name_offset, 0);
-		if (offset >= next_name_offset) {
-			printk(BIOS_ERR, "%s: Neither %d nor 0 found.\n", __func__, lang_id);
-			return NULL;
-		}
-	}
 
 	/* Move to the corresponding localized_string. */
-	offset = move_next(data, offset, next_name_offset, DELIM_STR);
-	if (offset >= next_name_offset)
+	offset = move_next(data, offset, end, DELIM_STR);
+	if (offset >= end)
 		return NULL;
 
 	/* Validity check that the returned string must be NULL terminated. */
-	next = move_next(data, offset, next_name_offset, DELIM_STR) - 1;
-	if (next >= next_name_offset || data[next] != '\0') {
+	next = move_next(data, offset, end, DELIM_STR) - 1;
+	if (next >= end || data[next] != '\0') {
 		printk(BIOS_ERR, "%s: %s is not NULL terminated.\n",
 		       __func__, PRERAM_LOCALES_NAME);
 		return NULL;
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
 #include <bootblock_common.h>
+#include <commonlib/helpers.h>
 #include <northbridge/intel/x4x/x4x.h>
 #include <southbridge/intel/i82801gx/i82801gx.h>
 #include <superio/ite/common/ite.h>
@@ -9,24 +10,28 @@
 #define SERIAL_DEV PNP_DEV(0x2e, IT8720F_SP1)
 #define GPIO_DEV PNP_DEV(0x2e, IT8720F_GPIO)
 
+static const struct pnp_config_write sio_gpio_setup[] = {
+	{ GPIO_DEV, 0x25, 0x01 },
+	{ GPIO_DEV, 0x26, 0x04 },
+	{ GPIO_DEV, 0x27, 0x00 },
+	{ GPIO_DEV, 0x28, 0x40 },
+	{ GPIO_DEV, 0x29, 0x01 },
+	{ GPIO_DEV, 0x73, 0x00 },
+	{ GPIO_DEV, 0x74, 0x00 },
+	{ GPIO_DEV, 0xb1, 0x04 },
+	{ GPIO_DEV, 0xb8, 0x20 },
+	{ GPIO_DEV, 0xbb, 0x01 },
+	{ GPIO_DEV, 0xc0, 0x00 },
+	{ GPIO_DEV, 0xc3, 0x01 },
+	{ GPIO_DEV, 0xcb, 0x01 },
+	{ GPIO_DEV, 0xf5, 0x28 },
+	{ GPIO_DEV, 0xf6, 0x12 },
+};
+
 void bootblock_mainboard_early_init(void)
 {
 	/* Set up GPIOs on Super I/O. */
-	ite_reg_write(GPIO_DEV, 0x25, 0x01);
-	ite_reg_write(GPIO_DEV, 0x26, 0x04);
-	ite_reg_write(GPIO_DEV, 0x27, 0x00);
-	ite_reg_write(GPIO_DEV, 0x28, 0x40);
-	ite_reg_write(GPIO_DEV, 0x29, 0x01);
-	ite_reg_write(GPIO_DEV, 0x73, 0x00);
-	ite_reg_write(GPIO_DEV, 0x74, 0x00);
-	ite_reg_write(GPIO_DEV, 0xb1, 0x04);
-	ite_reg_write(GPIO_DEV, 0xb8, 0x20);
-	ite_reg_write(GPIO_DEV, 0xbb, 0x01);
-	ite_reg_write(GPIO_DEV, 0xc0, 0x00);
-	ite_reg_write(GPIO_DEV, 0xc3, 0x01);
-	ite_reg_write(GPIO_DEV, 0xcb, 0x01);
-	ite_reg_write(GPIO_DEV, 0xf5, 0x28);
-	ite_reg_write(GPIO_DEV, 0xf6, 0x12);
+	ite_reg_write_batch(sio_gpio_setup, ARRAY_SIZE(sio_gpio_setup));
 	ite_enable_3vsbsw(GPIO_DEV);
 
 	/* Set up IRQ routing. */
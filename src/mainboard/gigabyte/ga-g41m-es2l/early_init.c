@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
 #include <bootblock_common.h>
+#include <commonlib/helpers.h>
 #include <device/pci_ops.h>
 #include <southbridge/intel/i82801gx/i82801gx.h>
 #include <northbridge/intel/x4x/x4x.h>
@@ -11,6 +12,39 @@
 #define GPIO_DEV PNP_DEV(0x2e, IT8718F_GPIO)
 #define EC_DEV PNP_DEV(0x2e, IT8718F_EC)
 
+static const struct pnp_config_write sio_setup[] = {
+	{ GPIO_DEV, 0x25, 0x00 },
+	{ GPIO_DEV, 0x26, 0xc7 },
+	{ GPIO_DEV, 0x27, 0x80 },
+	{ GPIO_DEV, 0x28, 0x41 },
+	{ GPIO_DEV, 0x29, 0x0a },
+	{ GPIO_DEV, 0x2c, 0x01 },
+	{ GPIO_DEV, 0x62, 0x08 },
+	{ GPIO_DEV, 0x72, 0x00 },
+	{ GPIO_DEV, 0x73, 0x00 },
+	{ GPIO_DEV, 0xb8, 0x00 },
+	{ GPIO_DEV, 0xbb, 0x40 },
+	{ GPIO_DEV, 0xc0, 0x00 },
+	{ GPIO_DEV, 0xc1, 0xc7 },
+	{ GPIO_DEV, 0xc2, 0x80 },
+	{ GPIO_DEV, 0xc3, 0x01 },
+	{ GPIO_DEV, 0xc4, 0x0a },
+	{ GPIO_DEV, 0xc8, 0x00 },
+	{ GPIO_DEV, 0xc9, 0x04 },
+	{ GPIO_DEV, 0xcb, 0x00 },
+	{ GPIO_DEV, 0xcc, 0x02 },
+	{ GPIO_DEV, 0xf0, 0x10 },
+	{ GPIO_DEV, 0xf1, 0x40 },
+	{ GPIO_DEV, 0xf6, 0x26 },
+	{ GPIO_DEV, 0xfc, 0x52 },
+	{ EC_DEV, 0xf0, 0x80 },
+	{ EC_DEV, 0xf1, 0x00 },
+	{ EC_DEV, 0xf2, 0x0a },
+	{ EC_DEV, 0xf3, 0x80 },
+	{ EC_DEV, 0x70, 0x00 }, /* Don't use IRQ9 */
+	{ EC_DEV, 0x30, 0x01 }, /* Enable */
+};
+
 /* Early mainboard specific GPIO setup.
  * We should use standard gpio.h eventually
  */
@@ -18,37 +52,7 @@
 void bootblock_mainboard_early_init(void)
 {
 	/* Set default GPIOs on superio */
-	ite_reg_write(GPIO_DEV, 0x25, 0x00);
-	ite_reg_write(GPIO_DEV, 0x26, 0xc7);
-	ite_reg_write(GPIO_DEV, 0x27, 0x80);
-	ite_reg_write(GPIO_DEV, 0x28, 0x41);
-	ite_reg_write(GPIO_DEV, 0x29, 0x0a);
-	ite_reg_write(GPIO_DEV, 0x2c, 0x01);
-	ite_reg_write(GPIO_DEV, 0x62, 0x08);
-	ite_reg_write(GPIO_DEV, 0x72, 0x00);
-	ite_reg_write(GPIO_DEV, 0x73, 0x00);
-	ite_reg_write(GPIO_DEV, 0xb8, 0x00);
-	ite_reg_write(GPIO_DEV, 0xbb, 0x40);
-	ite_reg_write(GPIO_DEV, 0xc0, 0x00);
-	ite_reg_write(GPIO_DEV, 0xc1, 0xc7);
-	ite_reg_write(GPIO_DEV, 0xc2, 0x80);
-	ite_reg_write(GPIO_DEV, 0xc3, 0x01);
-	ite_reg_write(GPIO_DEV, 0xc4, 0x0a);
-	ite_reg_write(GPIO_DEV, 0xc8, 0x00);
-	ite_reg_write(GPIO_DEV, 0xc9, 0x04);
-	ite_reg_write(GPIO_DEV, 0xcb, 0x00);
-	ite_reg_write(GPIO_DEV, 0xcc, 0x02);
-	ite_reg_write(GPIO_DEV, 0xf0, 0x10);
-	ite_reg_write(GPIO_DEV, 0xf1, 0x40);
-	ite_reg_write(GPIO_DEV, 0xf6, 0x26);
-	ite_reg_write(GPIO_DEV, 0xfc, 0x52);
-
-	ite_reg_write(EC_DEV, 0xf0, 0x80);
-	ite_reg_write(EC_DEV, 0xf1, 0x00);
-	ite_reg_write(EC_DEV, 0xf2, 0x0a);
-	ite_reg_write(EC_DEV, 0xf3, 0x80);
-	ite_reg_write(EC_DEV, 0x70, 0x00); // Don't use IRQ9
-	ite_reg_write(EC_DEV, 0x30, 0x01); // Enable
+	ite_reg_write_batch(sio_setup, ARRAY_SIZE(sio_setup));
 
 	ite_enable_serial(SERIAL_DEV, CONFIG_TTYS0_BASE);
 
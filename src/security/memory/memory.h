@@ -1,5 +1,13 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <stdbool.h>
+#include <stdint.h>
 
 bool security_clear_dram_request(void);
+
+/*
+ * Returns the socket whose memory controller owns [base, base + size), or -1 if unknown.
+ * Platforms with multiple sockets can override this, so that SECURITY_CLEAR_DRAM_PARALLEL
+ * has each socket clear its local memory.
+ */
+int memory_clear_range_socket(uint64_t base, uint64_t size);
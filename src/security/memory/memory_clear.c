@@ -20,6 +20,16 @@
 #include <security/memory/memory.h>
 #include <cbmem.h>
 #include <acpi/acpi.h>
+#include <timestamp.h>
+
+#if CONFIG(SECURITY_CLEAR_DRAM_PARALLEL)
+#include <arch/cpu.h>
+#include <cpu/x86/mp.h>
+#include <device/device.h>
+#include <smp/atomic.h>
+#include <smp/spinlock.h>
+#include <timer.h>
+#endif
 
 /* Helper to find free space for memset_pae. */
 static uintptr_t get_free_memory_range(struct memranges *mem,
@@ -44,6 +54,162 @@ static uintptr_t get_free_memory_range(struct memranges *mem,
 	return 0;
 }
 
+/* Can the range be cleared with a regular memset? */
+static bool range_is_addressable(const struct range_entry *r)
+{
+	return sizeof(resource_t) == sizeof(void *) ||
+	       !(range_entry_end(r) >> (sizeof(void *) * 8));
+}
+
+int __weak memory_clear_range_socket(uint64_t base, uint64_t size)
+{
+	return -1;
+}
+
+#if CONFIG(SECURITY_CLEAR_DRAM_PARALLEL)
+
+#define CLEAR_MAX_JOBS		512
+#define CLEAR_MIN_CHUNK		(64 * MiB)
+#define CLEAR_MAX_SOCKETS	8
+
+struct clear_job {
+	uint64_t base;
+	uint64_t size;
+	int socket;		/* Socket the memory is attached to, -1 if unknown */
+	bool taken;
+	int cleared_by;		/* Socket of the CPU that cleared it */
+	uint64_t end;
+};
+
+static struct {
+	struct clear_job jobs[CLEAR_MAX_JOBS];
+	int count;
+	atomic_t done;
+} clear_queue;
+
+DECLARE_SPIN_LOCK(clear_queue_lock)
+
+static int current_socket(void)
+{
+	const struct device *cpu = cpu_info()->cpu;
+
+	return cpu ? cpu->path.apic.package_id : 0;
+}
+
+static struct clear_job *take_clear_job(int socket)
+{
+	struct clear_job *job = NULL;
+	int i;
+
+	spin_lock(&clear_queue_lock);
+	/* Prefer the memory of our own socket, then help out with the rest. */
+	for (i = 0; i < clear_queue.count && !job; i++) {
+		if (!clear_queue.jobs[i].taken && clear_queue.jobs[i].socket == socket)
+			job = &clear_queue.jobs[i];
+	}
+	for (i = 0; i < clear_queue.count && !job; i++) {
+		if (!clear_queue.jobs[i].taken)
+			job = &clear_queue.jobs[i];
+	}
+	if (job)
+		job->taken = true;
+	spin_unlock(&clear_queue_lock);
+
+	return job;
+}
+
+static void clear_worker(void *unused)
+{
+	const int socket = current_socket();
+	struct clear_job *job;
+
+	while ((job = take_clear_job(socket))) {
+		memset((void *)(uintptr_t)job->base, 0, job->size);
+		job->cleared_by = socket;
+		job->end = timestamp_get();
+		atomic_inc(&clear_queue.done);
+	}
+}
+
+static void queue_clear_range(uint64_t base, uint64_t size, uint64_t chunk)
+{
+	while (size) {
+		/* Only possible with hundreds of tiny ranges, not worth splitting them up. */
+		if (clear_queue.count == CLEAR_MAX_JOBS) {
+			memset((void *)(uintptr_t)base, 0, size);
+			return;
+		}
+
+		struct clear_job *job = &clear_queue.jobs[clear_queue.count++];
+
+		job->base = base;
+		job->size = MIN(size, chunk);
+		job->socket = memory_clear_range_socket(job->base, job->size);
+		job->taken = false;
+		base += job->size;
+		size -= job->size;
+	}
+}
+
+/*
+ * Clears the BM_MEM_RAM ranges that memset can reach with the BSP and all APs. The ranges
+ * are split into chunks, each CPU clears the chunks of its own socket first.
+ */
+static void clear_memory_parallel(struct memranges *mem)
+{
+	uint64_t total = 0, chunk, socket_end[CLEAR_MAX_SOCKETS] = { 0 };
+	const struct range_entry *r;
+	int ranges = 0, i;
+
+	memranges_each_entry(r, mem) {
+		if (range_entry_tag(r) != BM_MEM_RAM || !range_is_addressable(r))
+			continue;
+		total += range_entry_size(r);
+		ranges++;
+	}
+	if (!ranges)
+		return;
+
+	/* Every range can end in a partial chunk, keep room for that. */
+	chunk = MAX(DIV_ROUND_UP(total, CLEAR_MAX_JOBS - MIN(ranges, CLEAR_MAX_JOBS / 2)),
+		    (uint64_t)CLEAR_MIN_CHUNK);
+	chunk = ALIGN_UP(chunk, 2 * MiB);
+
+	clear_queue.count = 0;
+	memranges_each_entry(r, mem) {
+		if (range_entry_tag(r) != BM_MEM_RAM || !range_is_addressable(r))
+			continue;
+		printk(BIOS_DEBUG, "%s: Clearing DRAM %016llx-%016llx\n",
+		       __func__, range_entry_base(r), range_entry_end(r));
+		queue_clear_range(range_entry_base(r), range_entry_size(r), chunk);
+	}
+
+	printk(BIOS_DEBUG, "%s: %llu MiB in %d chunks\n", __func__, total / MiB,
+	       clear_queue.count);
+	atomic_set(&clear_queue.done, 0);
+
+	/* If the APs don't pick up the work the BSP just does all of it by itself. */
+	if (mp_run_on_all_aps(clear_worker, NULL, 100 * USECS_PER_MSEC, true) != CB_SUCCESS)
+		printk(BIOS_WARNING, "DRAM is cleared by the BSP only\n");
+	clear_worker(NULL);
+
+	while (atomic_read(&clear_queue.done) < clear_queue.count)
+		cpu_relax();
+
+	for (i = 0; i < clear_queue.count; i++) {
+		const struct clear_job *job = &clear_queue.jobs[i];
+
+		if (job->cleared_by >= 0 && job->cleared_by < CLEAR_MAX_SOCKETS)
+			socket_end[job->cleared_by] = MAX(socket_end[job->cleared_by], job->end);
+	}
+	for (i = 0; i < CLEAR_MAX_SOCKETS; i++) {
+		if (socket_end[i])
+			timestamp_add(TS_DRAM_CLEAR_SOCKET0_END + i, socket_end[i]);
+	}
+}
+
+#endif
+
 /*
  * Clears all memory regions marked as BM_MEM_RAM.
  * Uses memset_pae if the memory region can't be accessed by memset and
@@ -95,16 +261,24 @@ static void clear_memory(void *unused)
 		__func__, (void *)pgtbl, (void *)vmem_addr);
 	}
 
+	timestamp_add_now(TS_DRAM_CLEAR_START);
+
+#if CONFIG(SECURITY_CLEAR_DRAM_PARALLEL)
+	clear_memory_parallel(&mem);
+#endif
+
 	/* Now clear all usable DRAM */
 	memranges_each_entry(r, &mem) {
 		if (range_entry_tag(r) != BM_MEM_RAM)
 			continue;
+		/* Already done in parallel */
+		if (CONFIG(SECURITY_CLEAR_DRAM_PARALLEL) && range_is_addressable(r))
+			continue;
 		printk(BIOS_DEBUG, "%s: Clearing DRAM %016llx-%016llx\n",
 		       __func__, range_entry_base(r), range_entry_end(r));
 
 		/* Does regular memset work? */
-		if (sizeof(resource_t) == sizeof(void *) ||
-		    !(range_entry_end(r) >> (sizeof(void *) * 8))) {
+		if (range_is_addressable(r)) {
 			/* fastpath */
 			memset((void *)(uintptr_t)range_entry_base(r), 0,
 			       range_entry_size(r));
@@ -130,6 +304,8 @@ static void clear_memory(void *unused)
 		memset((void *)pgtbl, 0, PAE_PGTL_SIZE);
 	}
 
+	timestamp_add_now(TS_DRAM_CLEAR_END);
+
 	memranges_teardown(&mem);
 }
 
@@ -141,6 +141,22 @@ tpm_result_t tpm_extend_pcr(int pcr, enum vb2_hash_algorithm digest_algo,
 			    const uint8_t *digest, size_t digest_len,
 			    const char *name);
 
+/**
+ * Like tpm_extend_pcr(), but with TPM_MEASURE_DEFERRED only log the digest and leave the PCR
+ * extend to tpm_flush_deferred_extends(). Digests are extended in the order they were logged,
+ * and tpm_extend_pcr() flushes the deferred ones first.
+ * @return TPM_SUCCESS on success. If not a tpm error is returned
+ */
+tpm_result_t tpm_extend_pcr_deferred(int pcr, enum vb2_hash_algorithm digest_algo,
+				     const uint8_t *digest, size_t digest_len,
+				     const char *name);
+
+/**
+ * Extend all deferred digests into their PCRs. Called before a stage hands off.
+ * @return TPM_SUCCESS on success. If not a tpm error is returned
+ */
+tpm_result_t tpm_flush_deferred_extends(void);
+
 /**
  * Issue a TPM_Clear and re-enable/reactivate the TPM.
  * @return TPM_SUCCESS on success. If not a tpm error is returned
@@ -152,8 +152,8 @@ tpm_result_t tspi_cbfs_measurement(const char *name, uint32_t type, const struct
 
 	snprintf(tpm_log_metadata, TPM_CB_LOG_PCR_HASH_NAME, "CBFS: %s", name);
 
-	return tpm_extend_pcr(pcr_index, hash->algo, hash->raw, vb2_digest_size(hash->algo),
-			      tpm_log_metadata);
+	return tpm_extend_pcr_deferred(pcr_index, hash->algo, hash->raw,
+				       vb2_digest_size(hash->algo), tpm_log_metadata);
 }
 
 void *tpm_log_init(void)
@@ -225,9 +225,16 @@ static void recover_tpm_log(int is_recovery)
 		return;
 	}
 
+	/* Deferred extends still refer to the last entries, which are copied in order. */
 	tpm_log_copy_entries(_tpm_log, ram_log);
 }
 CBMEM_CREATION_HOOK(recover_tpm_log);
 #endif
 
+static void flush_deferred_extends(void *unused)
+{
+	tpm_flush_deferred_extends();
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, flush_deferred_extends, NULL);
 BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, tpm_log_dump, NULL);
@@ -219,6 +219,87 @@ tpm_result_t tpm_clear_and_reenable(void)
 	return TPM_SUCCESS;
 }
 
+/* Number of entries at the end of the TPM log that are not extended into their PCRs yet. */
+static uint16_t deferred_extends;
+
+tpm_result_t tpm_flush_deferred_extends(void)
+{
+	const char *event_name;
+	const uint8_t *digest_data;
+	enum vb2_hash_algorithm digest_algo;
+	const void *log;
+	tpm_result_t rc;
+	uint16_t size;
+	int i, pcr;
+
+	if (!CONFIG(TPM_MEASURE_DEFERRED) || !deferred_extends)
+		return TPM_SUCCESS;
+
+	log = tpm_log_init();
+	if (!log) {
+		printk(BIOS_ERR, "TPM: Log lost with %u deferred extends\n", deferred_extends);
+		return TPM_CB_FAIL;
+	}
+
+	rc = tlcl_lib_init();
+	if (rc != TPM_SUCCESS) {
+		printk(BIOS_ERR, "TPM Error (%#x): Can't initialize library.\n", rc);
+		return rc;
+	}
+
+	size = tpm_log_get_size(log);
+	printk(BIOS_DEBUG, "TPM: Extending %u deferred digests\n", deferred_extends);
+
+	/* The log holds the deferred digests in the order they were measured. */
+	for (i = size - MIN(deferred_extends, size); i < size; i++) {
+		if (tpm_log_get(i, &pcr, &digest_data, &digest_algo, &event_name))
+			return TPM_CB_FAIL;
+
+		rc = tlcl_extend(pcr, digest_data, digest_algo);
+		if (rc != TPM_SUCCESS) {
+			printk(BIOS_ERR, "TPM Error (%#x): Extending hash for `%s` into PCR %d failed.\n",
+			       rc, event_name, pcr);
+			return rc;
+		}
+		deferred_extends--;
+	}
+
+	deferred_extends = 0;
+	return TPM_SUCCESS;
+}
+
+tpm_result_t tpm_extend_pcr_deferred(int pcr, enum vb2_hash_algorithm digest_algo,
+				     const uint8_t *digest, size_t digest_len, const char *name)
+{
+	const void *log;
+	uint16_t size;
+
+	if (!CONFIG(TPM_MEASURE_DEFERRED) || !digest || !tspi_tpm_is_setup())
+		return tpm_extend_pcr(pcr, digest_algo, digest, digest_len, name);
+
+	/*
+	 * The TPM log is the queue: the digest is logged now and extended from the log later.
+	 * If the log is full, there is nothing to extend from.
+	 */
+	log = tpm_log_init();
+	if (!log)
+		return tpm_extend_pcr(pcr, digest_algo, digest, digest_len, name);
+
+	size = tpm_log_get_size(log);
+	tpm_log_add_table_entry(name, pcr, digest_algo, digest, digest_len);
+	if (tpm_log_get_size(log) != size + 1) {
+		tpm_result_t rc = tpm_flush_deferred_extends();
+		if (rc != TPM_SUCCESS)
+			return rc;
+		return tpm_extend_pcr(pcr, digest_algo, digest, digest_len, name);
+	}
+
+	deferred_extends++;
+	printk(BIOS_DEBUG, "TPM: Digest of `%s` to PCR %d deferred\n", name, pcr);
+
+	return TPM_SUCCESS;
+}
+
 tpm_result_t tpm_extend_pcr(int pcr, enum vb2_hash_algorithm digest_algo,
 			const uint8_t *digest, size_t digest_len, const char *name)
 {
@@ -228,6 +309,11 @@ tpm_result_t tpm_extend_pcr(int pcr, enum vb2_hash_algorithm digest_algo,
 		return TPM_IOERROR;
 
 	if (tspi_tpm_is_setup()) {
+		/* Keep the PCRs extended in log order. */
+		rc = tpm_flush_deferred_extends();
+		if (rc != TPM_SUCCESS)
+			return rc;
+
 		rc = tlcl_lib_init();
 		if (rc != TPM_SUCCESS) {
 			printk(BIOS_ERR, "TPM Error (%#x): Can't initialize library.\n", rc);
@@ -102,7 +102,9 @@ static uint32_t get_vboot_hash_offset(enum vb2_firmware_selection select)
 
 /*
  * Asks the EC to calculate a hash of the specified firmware image, and
- * returns the information in **hash and *hash_size.
+ * returns the information in **hash and *hash_size. Verstage already started
+ * the calculation of the active image, so this usually only waits for the
+ * rest of it.
  */
 static vb2_error_t ec_hash_image(enum vb2_firmware_selection select,
 				 const uint8_t **hash, int *hash_size)
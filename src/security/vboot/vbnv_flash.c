@@ -80,10 +80,12 @@ static int init_vbnv(void)
 			printk(BIOS_ERR, "failed to read nvdata\n");
 			return 1;
 		}
-		if (!memcmp(buf, empty_blob, BLOB_SIZE))
+		if (!memcmp(buf, empty_blob, BLOB_SIZE)) {
 			empty_above = guess;
-		else
+		} else {
 			used_below = guess;
+			memcpy(ctx->cache, buf, BLOB_SIZE);
+		}
 	}
 
 	/*
@@ -92,8 +94,8 @@ static int init_vbnv(void)
 	 */
 	offset = used_below * BLOB_SIZE;
 
-	/* reread the nvdata and write it to the cache */
-	if (rdev_readat(rdev, ctx->cache, offset, BLOB_SIZE) < 0) {
+	/* The search already read any blob but the first one into the cache. */
+	if (used_below == 0 && rdev_readat(rdev, ctx->cache, offset, BLOB_SIZE) < 0) {
 		printk(BIOS_ERR, "failed to read nvdata\n");
 		return 1;
 	}
@@ -241,6 +241,26 @@ static void check_boot_mode(struct vb2_context *ctx)
 		ctx->flags |= VB2_CONTEXT_EC_TRUSTED;
 }
 
+/*
+ * EC software sync in romstage waits for the EC to hash its RW image. Unless the EC has a
+ * hash already, have it start one now, so it is calculated while the rest of verstage and
+ * the loading of romstage run.
+ */
+static void start_ec_hash(void)
+{
+	struct ec_response_vboot_hash resp;
+
+	if (google_chromeec_get_vboot_hash(EC_VBOOT_HASH_OFFSET_ACTIVE, &resp))
+		return;
+
+	if (resp.status != EC_VBOOT_HASH_STATUS_NONE)
+		return;
+
+	if (google_chromeec_start_vboot_hash(EC_VBOOT_HASH_TYPE_SHA256,
+					     EC_VBOOT_HASH_OFFSET_ACTIVE, &resp))
+		printk(BIOS_WARNING, "Failed to start EC hash calculation\n");
+}
+
 /* Verify and select the firmware in the RW image */
 void verstage_main(void)
 {
@@ -360,6 +380,9 @@ void verstage_main(void)
 	if (rv)
 		vboot_save_and_reboot(ctx, rv);
 
+	if (CONFIG(VBOOT_EARLY_EC_SYNC))
+		start_ec_hash();
+
 	printk(BIOS_INFO, "Phase 4\n");
 	if (CONFIG(VBOOT_CBFS_INTEGRATION)) {
 		struct vb2_hash *metadata_hash;
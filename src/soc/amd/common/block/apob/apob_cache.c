@@ -112,40 +112,102 @@ static enum cb_err get_nv_rdev_rw(struct region_device *r)
 	return CB_SUCCESS;
 }
 
+/*
+ * The flash copy is compared, hashed and rewritten in chunks of one erase sector, so only the
+ * sectors that actually changed need to be erased and written again.
+ */
+#define APOB_SECTOR_SIZE	(4 * KiB)
+#define APOB_SECTORS		(DEFAULT_MRC_CACHE_SIZE / APOB_SECTOR_SIZE)
+
+_Static_assert(DEFAULT_MRC_CACHE_SIZE % APOB_SECTOR_SIZE == 0,
+	"MRC CACHE size must be a multiple of the APOB sector size");
+
 static struct apob_thread_context {
 	uint8_t buffer[DEFAULT_MRC_CACHE_SIZE] __aligned(64);
 	struct thread_handle handle;
 	struct region_device apob_rdev;
+	const struct apob_base_header *apob_ram;
+	/* With SOC_AMD_COMMON_BLOCK_APOB_HASH: hash of the APOB in RAM */
+	uint64_t ram_hash;
+	/* Without SOC_AMD_COMMON_BLOCK_APOB_HASH: sectors where the flash differs from RAM */
+	bool dirty[APOB_SECTORS];
 } global_apob_thread;
 
+/* Returns true if the APOB data or hash in the sector at |offset| differ from |nv|. */
+static bool apob_sector_differs(const struct apob_base_header *apob_ram, uint64_t ram_hash,
+				const uint8_t *nv, size_t offset)
+{
+	const size_t end = offset + APOB_SECTOR_SIZE;
+
+	if (offset < apob_ram->size &&
+	    memcmp((const uint8_t *)apob_ram + offset, nv,
+		   MIN(end, apob_ram->size) - offset))
+		return true;
+
+	if (CONFIG(SOC_AMD_COMMON_BLOCK_APOB_HASH) && MRC_HASH_OFFSET >= offset &&
+	    MRC_HASH_OFFSET < end &&
+	    memcmp(&ram_hash, nv + MRC_HASH_OFFSET - offset, MRC_HASH_SIZE))
+		return true;
+
+	return false;
+}
+
 static enum cb_err apob_thread_entry(void *arg)
 {
-	ssize_t size;
 	struct apob_thread_context *thread = arg;
+	struct xxh64_state state;
+	size_t offset;
 
 	printk(BIOS_DEBUG, "APOB thread running\n");
-	size = rdev_readat(&thread->apob_rdev, thread->buffer, 0,
-		    region_device_sz(&thread->apob_rdev));
 
-	printk(BIOS_DEBUG, "APOB thread done\n");
+	if (CONFIG(SOC_AMD_COMMON_BLOCK_APOB_HASH)) {
+		/* Hash the RAM copy a sector at a time, so the main thread isn't held up. */
+		xxh64_reset(&state, 0);
+		for (offset = 0; offset < thread->apob_ram->size; offset += APOB_SECTOR_SIZE) {
+			xxh64_update(&state, (const uint8_t *)thread->apob_ram + offset,
+				     MIN(APOB_SECTOR_SIZE, thread->apob_ram->size - offset));
+			thread_yield();
+		}
+		thread->ram_hash = xxh64_digest(&state);
 
-	if (size == region_device_sz(&thread->apob_rdev))
+		printk(BIOS_DEBUG, "APOB thread done\n");
 		return CB_SUCCESS;
+	}
+
+	/* Compare every sector with the RAM copy as soon as it has been read. */
+	for (offset = 0; offset < region_device_sz(&thread->apob_rdev);
+	     offset += APOB_SECTOR_SIZE) {
+		if (rdev_readat(&thread->apob_rdev, thread->buffer + offset, offset,
+				APOB_SECTOR_SIZE) != APOB_SECTOR_SIZE) {
+			printk(BIOS_ERR, "APOB thread failed to read flash\n");
+			return CB_ERR;
+		}
+		thread->dirty[offset / APOB_SECTOR_SIZE] =
+			apob_sector_differs(thread->apob_ram, 0, thread->buffer + offset, offset);
+		thread_yield();
+	}
 
-	return CB_ERR;
+	printk(BIOS_DEBUG, "APOB thread done\n");
+
+	return CB_SUCCESS;
 }
 
 void start_apob_cache_read(void)
 {
 	struct apob_thread_context *thread = &global_apob_thread;
 
-	if (!CONFIG(COOP_MULTITASKING) || CONFIG(SOC_AMD_COMMON_BLOCK_APOB_HASH))
+	if (!CONFIG(COOP_MULTITASKING))
 		return;
 
 	/* We don't perform any comparison on S3 resume */
 	if (acpi_is_wakeup_s3())
 		return;
 
+	/* The PSP is done with the APOB in DRAM before x86 runs, so this is its final state. */
+	thread->apob_ram = get_apob_dram_address();
+	if (thread->apob_ram == NULL)
+		return;
+
 	if (get_nv_rdev(&thread->apob_rdev) != CB_SUCCESS)
 		return;
 
@@ -186,21 +248,61 @@ static uint64_t get_apob_hash_from_nv_rdev(const struct region_device *read_rdev
 	return hash;
 }
 
-static void update_apob_nv_hash(uint64_t hash, struct region_device *write_rdev)
+/* Erase and rewrite the sectors marked in |dirty| with the RAM copy (and hash). */
+static enum cb_err update_apob_nv_sectors(const struct apob_base_header *apob_src_ram,
+					  uint64_t ram_hash, const bool *dirty,
+					  struct region_device *write_rdev)
 {
-	if (rdev_writeat(write_rdev, &hash, MRC_HASH_OFFSET, MRC_HASH_SIZE) < 0) {
-		printk(BIOS_ERR, "APOB hash flash region update failed\n");
+	size_t i, offset, end;
+
+	timestamp_add_now(TS_AMD_APOB_ERASE_START);
+
+	for (i = 0; i < APOB_SECTORS; i++) {
+		if (dirty[i] && rdev_eraseat(write_rdev, i * APOB_SECTOR_SIZE,
+					     APOB_SECTOR_SIZE) < 0) {
+			printk(BIOS_ERR, "APOB flash region erase failed\n");
+			return CB_ERR;
+		}
 	}
+
+	timestamp_add_now(TS_AMD_APOB_WRITE_START);
+
+	for (i = 0; i < APOB_SECTORS; i++) {
+		offset = i * APOB_SECTOR_SIZE;
+		end = offset + APOB_SECTOR_SIZE;
+
+		if (!dirty[i])
+			continue;
+
+		if (offset < apob_src_ram->size &&
+		    rdev_writeat(write_rdev, (const uint8_t *)apob_src_ram + offset, offset,
+				 MIN(end, apob_src_ram->size) - offset) < 0) {
+			printk(BIOS_ERR, "APOB flash region update failed\n");
+			return CB_ERR;
+		}
+
+		if (CONFIG(SOC_AMD_COMMON_BLOCK_APOB_HASH) && MRC_HASH_OFFSET >= offset &&
+		    MRC_HASH_OFFSET < end &&
+		    rdev_writeat(write_rdev, &ram_hash, MRC_HASH_OFFSET, MRC_HASH_SIZE) < 0) {
+			printk(BIOS_ERR, "APOB hash flash region update failed\n");
+			return CB_ERR;
+		}
+	}
+
+	return CB_SUCCESS;
 }
 
 /* Save APOB buffer to flash */
 static void soc_update_apob_cache(void *unused)
 {
-	struct apob_base_header *apob_rom = NULL;
+	struct apob_thread_context *thread = &global_apob_thread;
+	const uint8_t *apob_rom = NULL;
 	struct region_device read_rdev, write_rdev;
-	bool update_needed = false;
 	const struct apob_base_header *apob_src_ram;
-	uint64_t ram_hash, nv_hash;
+	bool thread_done = false;
+	bool dirty[APOB_SECTORS];
+	uint64_t ram_hash = 0;
+	size_t i, num_dirty = 0;
 
 	/* Nothing to update in case of S3 resume. */
 	if (acpi_is_wakeup_s3())
@@ -215,38 +317,46 @@ static void soc_update_apob_cache(void *unused)
 
 	timestamp_add_now(TS_AMD_APOB_READ_START);
 
+	if (CONFIG(COOP_MULTITASKING) && thread->apob_ram == apob_src_ram &&
+	    thread_join(&thread->handle) == CB_SUCCESS)
+		thread_done = true;
+
 	if (CONFIG(SOC_AMD_COMMON_BLOCK_APOB_HASH)) {
-		nv_hash = get_apob_hash_from_nv_rdev(&read_rdev);
-		ram_hash = xxh64(apob_src_ram, apob_src_ram->size, 0);
+		ram_hash = thread_done ? thread->ram_hash :
+					 xxh64(apob_src_ram, apob_src_ram->size, 0);
 
-		if (nv_hash != ram_hash) {
-			printk(BIOS_INFO, "APOB RAM hash differs from flash\n");
-			update_needed = true;
-		} else {
+		if (get_apob_hash_from_nv_rdev(&read_rdev) == ram_hash) {
 			printk(BIOS_DEBUG, "APOB hash matches flash\n");
 			timestamp_add_now(TS_AMD_APOB_END);
 			return;
 		}
+		printk(BIOS_INFO, "APOB RAM hash differs from flash\n");
 	}
 
-	if (CONFIG(COOP_MULTITASKING) && thread_join(&global_apob_thread.handle) == CB_SUCCESS)
-		apob_rom = (struct apob_base_header *)global_apob_thread.buffer;
-	else if (!update_needed)
+	if (thread_done && !CONFIG(SOC_AMD_COMMON_BLOCK_APOB_HASH)) {
+		memcpy(dirty, thread->dirty, sizeof(dirty));
+	} else {
 		apob_rom = get_apob_from_nv_rdev(&read_rdev);
+		for (i = 0; i < APOB_SECTORS; i++)
+			dirty[i] = !apob_rom || apob_sector_differs(apob_src_ram, ram_hash,
+						apob_rom + i * APOB_SECTOR_SIZE,
+						i * APOB_SECTOR_SIZE);
+		if (apob_rom)
+			rdev_munmap(&read_rdev, (void *)apob_rom);
+	}
 
-	if (apob_rom == NULL) {
-		update_needed = true;
-	} else if (memcmp(apob_src_ram, apob_rom, apob_src_ram->size)) {
-		printk(BIOS_INFO, "APOB RAM copy differs from flash\n");
-		update_needed = true;
-	} else
-		printk(BIOS_DEBUG, "APOB valid copy is already in flash\n");
+	for (i = 0; i < APOB_SECTORS; i++)
+		num_dirty += dirty[i];
 
-	if (!update_needed) {
+	if (!num_dirty) {
+		printk(BIOS_DEBUG, "APOB valid copy is already in flash\n");
 		timestamp_add_now(TS_AMD_APOB_END);
 		return;
 	}
 
+	printk(BIOS_INFO, "APOB RAM copy differs from flash in %zu of %u sectors\n",
+	       num_dirty, (unsigned int)APOB_SECTORS);
+
 	printk(BIOS_SPEW, "Copy APOB from RAM %p/%#x to flash %#zx/%#zx\n",
 		apob_src_ram, apob_src_ram->size,
 		region_device_offset(&read_rdev), region_device_sz(&read_rdev));
@@ -254,23 +364,8 @@ static void soc_update_apob_cache(void *unused)
 	if (get_nv_rdev_rw(&write_rdev) != CB_SUCCESS)
 		return;
 
-	timestamp_add_now(TS_AMD_APOB_ERASE_START);
-
-	/* write data to flash region */
-	if (rdev_eraseat(&write_rdev, 0, DEFAULT_MRC_CACHE_SIZE) < 0) {
-		printk(BIOS_ERR, "APOB flash region erase failed\n");
+	if (update_apob_nv_sectors(apob_src_ram, ram_hash, dirty, &write_rdev) != CB_SUCCESS)
 		return;
-	}
-
-	timestamp_add_now(TS_AMD_APOB_WRITE_START);
-
-	if (rdev_writeat(&write_rdev, apob_src_ram, 0, apob_src_ram->size) < 0) {
-		printk(BIOS_ERR, "APOB flash region update failed\n");
-		return;
-	}
-
-	if (CONFIG(SOC_AMD_COMMON_BLOCK_APOB_HASH))
-		update_apob_nv_hash(ram_hash, &write_rdev);
 
 	timestamp_add_now(TS_AMD_APOB_END);
 
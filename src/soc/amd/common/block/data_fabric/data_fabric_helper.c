@@ -43,15 +43,53 @@ void data_fabric_write32(uint16_t fn_reg, uint8_t instance_id, uint32_t data)
 	data_fabric_broadcast_write32(DF_FICAD_LO, data);
 }
 
+const struct df_routing *data_fabric_get_routing(void)
+{
+	static struct df_routing routing;
+	static bool valid;
+	unsigned int i;
+
+	if (valid)
+		return &routing;
+
+	for (i = 0; i < DF_MMIO_REG_SET_COUNT; i++) {
+		routing.mmio_base[i] = data_fabric_broadcast_read32(DF_MMIO_BASE(i));
+		routing.mmio_limit[i] = data_fabric_broadcast_read32(DF_MMIO_LIMIT(i));
+		routing.mmio_control[i].raw = data_fabric_broadcast_read32(DF_MMIO_CONTROL(i));
+#if CONFIG(SOC_AMD_COMMON_BLOCK_DATA_FABRIC_EXTENDED_MMIO)
+		routing.mmio_addr_ext[i].raw =
+			data_fabric_broadcast_read32(DF_MMIO_ADDR_EXT(i));
+#endif
+	}
+
+	for (i = 0; i < DF_IO_REG_COUNT; i++) {
+		routing.io_base[i].raw = data_fabric_broadcast_read32(DF_IO_BASE(i));
+		routing.io_limit[i].raw = data_fabric_broadcast_read32(DF_IO_LIMIT(i));
+	}
+
+	for (i = 0; i < DF_PCI_CFG_MAP_COUNT; i++) {
+#if CONFIG(SOC_AMD_COMMON_BLOCK_DATA_FABRIC_MULTI_PCI_SEGMENT)
+		routing.pci_cfg_base[i].raw = data_fabric_broadcast_read32(DF_PCI_CFG_BASE(i));
+		routing.pci_cfg_limit[i].raw = data_fabric_broadcast_read32(DF_PCI_CFG_LIMIT(i));
+#else
+		routing.pci_cfg_map[i].raw = data_fabric_broadcast_read32(DF_PCI_CFG_MAP(i));
+#endif
+	}
+
+	valid = true;
+	return &routing;
+}
+
 void data_fabric_print_mmio_conf(void)
 {
+	const struct df_routing *routing = data_fabric_get_routing();
 	union df_mmio_control control;
 	uint64_t base, limit;
 	printk(BIOS_SPEW,
 		"=== Data Fabric MMIO configuration registers ===\n"
 		"idx             base            limit  control R W NP F-ID\n");
 	for (unsigned int i = 0; i < DF_MMIO_REG_SET_COUNT; i++) {
-		control.raw = data_fabric_broadcast_read32(DF_MMIO_CONTROL(i));
+		control = routing->mmio_control[i];
 		data_fabric_get_mmio_base_size(i, &base, &limit);
 		printk(BIOS_SPEW, " %2u %16llx %16llx %8x %s %s  %s %4x\n",
 		       i, base, limit, control.raw,
@@ -90,6 +90,7 @@ static void report_data_fabric_mmio(struct device *domain, unsigned long idx,
 static void add_data_fabric_mmio_regions(struct device *domain, unsigned long *idx)
 {
 	const signed int iohc_dest_fabric_id = get_iohc_fabric_id(domain);
+	const struct df_routing *routing = data_fabric_get_routing();
 	union df_mmio_control ctrl;
 	resource_t mmio_base;
 	resource_t mmio_limit;
@@ -99,7 +100,7 @@ static void add_data_fabric_mmio_regions(struct device *domain, unsigned long *i
 		(1ULL << cpu_phys_address_size()) - DF_RESERVED_TOP_12GB_MMIO_SIZE;
 
 	for (unsigned int i = 0; i < DF_MMIO_REG_SET_COUNT; i++) {
-		ctrl.raw = data_fabric_broadcast_read32(DF_MMIO_CONTROL(i));
+		ctrl = routing->mmio_control[i];
 
 		/* Relevant MMIO regions need to have both reads and writes enabled */
 		if (!ctrl.we || !ctrl.re)
@@ -152,19 +153,20 @@ static void report_data_fabric_io(struct device *domain, unsigned long idx,
 static void add_data_fabric_io_regions(struct device *domain, unsigned long *idx)
 {
 	const signed int iohc_dest_fabric_id = get_iohc_fabric_id(domain);
+	const struct df_routing *routing = data_fabric_get_routing();
 	union df_io_base base_reg;
 	union df_io_limit limit_reg;
 	resource_t io_base;
 	resource_t io_limit;
 
 	for (unsigned int i = 0; i < DF_IO_REG_COUNT; i++) {
-		base_reg.raw = data_fabric_broadcast_read32(DF_IO_BASE(i));
+		base_reg = routing->io_base[i];
 
 		/* Relevant IO regions need to have both reads and writes enabled */
 		if (!base_reg.we || !base_reg.re)
 			continue;
 
-		limit_reg.raw = data_fabric_broadcast_read32(DF_IO_LIMIT(i));
+		limit_reg = routing->io_limit[i];
 
 		/* Only look at IO regions that are decoded to the right PCI root */
 		if (limit_reg.dst_fabric_id != iohc_dest_fabric_id)
@@ -8,11 +8,10 @@
 void data_fabric_get_mmio_base_size(unsigned int reg, resource_t *mmio_base,
 				    resource_t *mmio_limit)
 {
-	const uint32_t base_reg = data_fabric_broadcast_read32(DF_MMIO_BASE(reg));
-	const uint32_t limit_reg = data_fabric_broadcast_read32(DF_MMIO_LIMIT(reg));
-	const union df_mmio_addr_ext ext_reg = {
-		.raw = data_fabric_broadcast_read32(DF_MMIO_ADDR_EXT(reg))
-	};
+	const struct df_routing *routing = data_fabric_get_routing();
+	const uint32_t base_reg = routing->mmio_base[reg];
+	const uint32_t limit_reg = routing->mmio_limit[reg];
+	const union df_mmio_addr_ext ext_reg = routing->mmio_addr_ext[reg];
 	/* The raw register values in the base and limit registers are bits 47..16  of the
 	   actual address. The MMIO address extension register contains the extended MMIO base
 	   and limit bits starting with bit 48 of the actual address. */
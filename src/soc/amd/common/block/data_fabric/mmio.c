@@ -8,8 +8,9 @@
 void data_fabric_get_mmio_base_size(unsigned int reg, resource_t *mmio_base,
 				    resource_t *mmio_limit)
 {
-	const uint32_t base_reg = data_fabric_broadcast_read32(DF_MMIO_BASE(reg));
-	const uint32_t limit_reg = data_fabric_broadcast_read32(DF_MMIO_LIMIT(reg));
+	const struct df_routing *routing = data_fabric_get_routing();
+	const uint32_t base_reg = routing->mmio_base[reg];
+	const uint32_t limit_reg = routing->mmio_limit[reg];
 	/* The raw register values are bits 47..16  of the actual address */
 	*mmio_base = (resource_t)base_reg << DF_MMIO_SHIFT;
 	*mmio_limit = (((resource_t)limit_reg + 1) << DF_MMIO_SHIFT) - 1;
@@ -10,12 +10,13 @@ enum cb_err data_fabric_get_pci_bus_numbers(struct device *domain, uint8_t *segm
 					    uint8_t *first_bus, uint8_t *last_bus)
 {
 	const signed int iohc_dest_fabric_id = get_iohc_fabric_id(domain);
+	const struct df_routing *routing = data_fabric_get_routing();
 	union df_pci_cfg_base pci_bus_base;
 	union df_pci_cfg_limit pci_bus_limit;
 
 	for (unsigned int i = 0; i < DF_PCI_CFG_MAP_COUNT; i++) {
-		pci_bus_base.raw = data_fabric_broadcast_read32(DF_PCI_CFG_BASE(i));
-		pci_bus_limit.raw = data_fabric_broadcast_read32(DF_PCI_CFG_LIMIT(i));
+		pci_bus_base = routing->pci_cfg_base[i];
+		pci_bus_limit = routing->pci_cfg_limit[i];
 
 		if (pci_bus_limit.dst_fabric_id != iohc_dest_fabric_id)
 			continue;
@@ -10,10 +10,11 @@ enum cb_err data_fabric_get_pci_bus_numbers(struct device *domain, uint8_t *segm
 					    uint8_t *first_bus, uint8_t *last_bus)
 {
 	const signed int iohc_dest_fabric_id = get_iohc_fabric_id(domain);
+	const struct df_routing *routing = data_fabric_get_routing();
 	union df_pci_cfg_map pci_bus_map;
 
 	for (unsigned int i = 0; i < DF_PCI_CFG_MAP_COUNT; i++) {
-		pci_bus_map.raw = data_fabric_broadcast_read32(DF_PCI_CFG_MAP(i));
+		pci_bus_map = routing->pci_cfg_map[i];
 
 		if (pci_bus_map.dst_fabric_id != iohc_dest_fabric_id)
 			continue;
@@ -26,6 +26,31 @@
 /* Last 12GB of the usable address space are reserved */
 #define DF_RESERVED_TOP_12GB_MMIO_SIZE		(12ULL * GiB)
 
+/*
+ * Raw values of the registers that route MMIO, IO and PCI bus numbers to the PCI roots.
+ * Nothing in ramstage changes them, so they are read once and the copy is used to build
+ * the domain resources instead of going to the data fabric for every lookup.
+ */
+struct df_routing {
+	uint32_t mmio_base[DF_MMIO_REG_SET_COUNT];
+	uint32_t mmio_limit[DF_MMIO_REG_SET_COUNT];
+	union df_mmio_control mmio_control[DF_MMIO_REG_SET_COUNT];
+#if CONFIG(SOC_AMD_COMMON_BLOCK_DATA_FABRIC_EXTENDED_MMIO)
+	union df_mmio_addr_ext mmio_addr_ext[DF_MMIO_REG_SET_COUNT];
+#endif
+	union df_io_base io_base[DF_IO_REG_COUNT];
+	union df_io_limit io_limit[DF_IO_REG_COUNT];
+#if CONFIG(SOC_AMD_COMMON_BLOCK_DATA_FABRIC_MULTI_PCI_SEGMENT)
+	union df_pci_cfg_base pci_cfg_base[DF_PCI_CFG_MAP_COUNT];
+	union df_pci_cfg_limit pci_cfg_limit[DF_PCI_CFG_MAP_COUNT];
+#else
+	union df_pci_cfg_map pci_cfg_map[DF_PCI_CFG_MAP_COUNT];
+#endif
+};
+
+/* Reads the routing registers on the first call */
+const struct df_routing *data_fabric_get_routing(void);
+
 uint32_t data_fabric_read32(uint16_t fn_reg, uint8_t instance_id);
 void data_fabric_write32(uint16_t fn_reg, uint8_t instance_id, uint32_t data);
 
@@ -6,6 +6,7 @@
 #include <types.h>
 #include <commonlib/helpers.h>
 #include <amdblocks/psp.h>
+#include <timer.h>
 
 #define CORE_2_PSP_MSG_38_OFFSET	0x10998 /* 4 byte */
 #define   CORE_2_PSP_MSG_38_FUSE_SPL		BIT(12)
@@ -113,6 +114,26 @@ void psp_print_cmd_status(int cmd_status, struct mbox_buffer_header *header);
 /* This command needs to be implemented by the generation specific code. */
 int send_psp_command(u32 command, void *buffer);
 
+/*
+ * Asynchronous mailbox commands, gen2 only. psp_command_submit() starts a command and
+ * returns right away, the PSP works on it while the caller does other things. The
+ * buffer has to stay around until the command is done. psp_command_done() checks
+ * without blocking and psp_command_wait() blocks until the PSP is done or the
+ * command timed out, both leave the result in req->status. Only one command can be
+ * in flight, submitting another one, also with send_psp_command(), first waits for
+ * the previous one.
+ */
+struct psp_cmd_request {
+	u32 command;
+	bool pending;
+	int status;
+	struct stopwatch sw;
+};
+
+int psp_command_submit(struct psp_cmd_request *req, u32 command, void *buffer);
+bool psp_command_done(struct psp_cmd_request *req);
+int psp_command_wait(struct psp_cmd_request *req);
+
 uint32_t soc_read_c2p38(void);
 
 #endif /* __AMD_PSP_DEF_H__ */
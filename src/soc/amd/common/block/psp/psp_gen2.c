@@ -54,11 +54,11 @@ static void wr_mbox_buffer_ptr(void *buffer)
 	smn_write32(SMN_PSP_PUBLIC_BASE + PSP_MAILBOX_BUFFER_L_OFFSET, buf_addr_l);
 }
 
-static int wait_command(bool wait_for_ready)
+/* Check once whether the mailbox is idle, and ready as well if wait_for_ready is set. */
+static bool command_done(bool wait_for_ready)
 {
 	union pspv2_mbox_command and_mask = { .val = ~0 };
 	union pspv2_mbox_command expected = { .val = 0 };
-	struct stopwatch sw;
 	u32 tmp;
 
 	/* Zero fields from and_mask that should be kept */
@@ -69,40 +69,94 @@ static int wait_command(bool wait_for_ready)
 	if (wait_for_ready)
 		expected.fields.ready = 1;
 
+	tmp = smn_read32(SMN_PSP_PUBLIC_BASE + PSP_MAILBOX_COMMAND_OFFSET);
+	tmp &= ~and_mask.val;
+
+	return tmp == expected.val;
+}
+
+static int wait_command(bool wait_for_ready)
+{
+	struct stopwatch sw;
+
 	stopwatch_init_msecs_expire(&sw, PSP_CMD_TIMEOUT);
 
 	do {
-		tmp = smn_read32(SMN_PSP_PUBLIC_BASE + PSP_MAILBOX_COMMAND_OFFSET);
-		tmp &= ~and_mask.val;
-		if (tmp == expected.val)
+		if (command_done(wait_for_ready))
 			return 0;
 	} while (!stopwatch_expired(&sw));
 
 	return -PSPSTS_CMD_TIMEOUT;
 }
 
-int send_psp_command(u32 command, void *buffer)
+/* There is only one mailbox, so at most one command can be in flight. */
+static struct psp_cmd_request *inflight;
+
+int psp_command_submit(struct psp_cmd_request *req, u32 command, void *buffer)
 {
+	if (inflight)
+		psp_command_wait(inflight);
+
+	req->command = command;
+	req->pending = false;
+
 	if (rd_mbox_recovery())
-		return -PSPSTS_RECOVERY;
+		return req->status = -PSPSTS_RECOVERY;
 
 	if (wait_command(true))
-		return -PSPSTS_CMD_TIMEOUT;
+		return req->status = -PSPSTS_CMD_TIMEOUT;
 
 	/* set address of command-response buffer and write command register */
 	wr_mbox_buffer_ptr(buffer);
 	wr_mbox_cmd(command);
 
+	stopwatch_init_msecs_expire(&req->sw, PSP_CMD_TIMEOUT);
+	req->status = 0;
+	req->pending = true;
+	inflight = req;
+
+	return 0;
+}
+
+bool psp_command_done(struct psp_cmd_request *req)
+{
+	if (!req->pending)
+		return true;
+
 	/* PSP clears command register when complete.  All commands except
 	 * SxInfo set the Ready bit. */
-	if (wait_command(command != MBOX_BIOS_CMD_SX_INFO))
-		return -PSPSTS_CMD_TIMEOUT;
+	if (command_done(req->command != MBOX_BIOS_CMD_SX_INFO)) {
+		/* check delivery status */
+		req->status = rd_mbox_sts() ? -PSPSTS_SEND_ERROR : 0;
+	} else if (stopwatch_expired(&req->sw)) {
+		req->status = -PSPSTS_CMD_TIMEOUT;
+	} else {
+		return false;
+	}
+
+	req->pending = false;
+	inflight = NULL;
+
+	return true;
+}
+
+int psp_command_wait(struct psp_cmd_request *req)
+{
+	while (!psp_command_done(req))
+		;
 
-	/* check delivery status */
-	if (rd_mbox_sts())
-		return -PSPSTS_SEND_ERROR;
+	return req->status;
+}
 
-	return 0;
+int send_psp_command(u32 command, void *buffer)
+{
+	struct psp_cmd_request req;
+	const int status = psp_command_submit(&req, command, buffer);
+
+	if (status)
+		return status;
+
+	return psp_command_wait(&req);
 }
 
 uint32_t soc_read_c2p38(void)
@@ -5,14 +5,16 @@
 #include <types.h>
 #include "psp_def.h"
 
+/* The PSP works on the fusing request while the payload is loaded. */
+static struct psp_cmd_request spl_fuse_req;
+static struct mbox_cmd_late_spl_buffer spl_fuse_buffer = {
+	.header = {
+		.size = sizeof(spl_fuse_buffer)
+	}
+};
+
 static void psp_set_spl_fuse(void *unused)
 {
-	int cmd_status = 0;
-	struct mbox_cmd_late_spl_buffer buffer = {
-		.header = {
-			.size = sizeof(buffer)
-		}
-	};
 	uint32_t c2p38 = soc_read_c2p38();
 
 	if (c2p38 & CORE_2_PSP_MSG_38_FUSE_SPL) {
@@ -42,8 +44,22 @@ static void psp_set_spl_fuse(void *unused)
 		return;
 
 	printk(BIOS_DEBUG, "PSP: SPL Fusing Update Requested.\n");
-	cmd_status = send_psp_command(MBOX_BIOS_CMD_SET_SPL_FUSE, &buffer);
+	psp_command_submit(&spl_fuse_req, MBOX_BIOS_CMD_SET_SPL_FUSE, &spl_fuse_buffer);
+}
+
+static void psp_finish_spl_fuse(void *unused)
+{
+	int cmd_status;
+
+	/* Nothing was submitted */
+	if (!spl_fuse_req.command)
+		return;
+
+	/* Returns right away if another PSP command already waited for this one. */
+	cmd_status = psp_command_wait(&spl_fuse_req);
+	printk(BIOS_DEBUG, "PSP: SPL Fusing Update... ");
 	psp_print_cmd_status(cmd_status, NULL);
 }
 
 BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_LOAD, BS_ON_ENTRY, psp_set_spl_fuse, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_LOAD, BS_ON_EXIT, psp_finish_spl_fuse, NULL);
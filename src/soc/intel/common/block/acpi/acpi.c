@@ -196,30 +196,34 @@ int common_calculate_power_ratio(int tdp, int p1_ratio, int ratio)
 
 static void generate_c_state_entries(void)
 {
+	/* The C-states are the same for all cores, so encode them only once. */
+	static struct acpigen_template cst_template;
 	const acpi_cstate_t *c_state_map;
 	size_t entries;
 
+	if (acpigen_template_replay(&cst_template))
+		return;
+
+	acpigen_template_begin(&cst_template);
+
 	c_state_map = soc_get_cstate_map(&entries);
 
 	/* Generate C-state tables */
 	acpigen_write_CST_package(c_state_map, entries);
+
+	acpigen_template_end(&cst_template);
 }
 
 void generate_p_state_entries(int core, int cores_per_package)
 {
+	/* Only the _PSD differs between cores, the _PSS table is encoded once. */
+	static struct acpigen_template pss_template;
 	int ratio_min, ratio_max, ratio_turbo, ratio_step;
 	int coord_type, power_max, num_entries;
 	int ratio, power, clock, clock_max;
 	bool turbo;
 
 	coord_type = cpu_get_coord_type();
-	ratio_min = cpu_get_min_ratio();
-	ratio_max = cpu_get_max_ratio();
-	clock_max = (ratio_max * cpu_get_bus_clock()) / KHz;
-	turbo = (get_turbo_state() == TURBO_ENABLED);
-
-	/* Calculate CPU TDP in mW */
-	power_max = cpu_get_power_max();
 
 	/* Write _PCT indicating use of FFixedHW */
 	acpigen_write_empty_PCT();
@@ -229,6 +233,19 @@ void generate_p_state_entries(int core, int cores_per_package)
 	/* Write PSD indicating configured coordination type */
 	acpigen_write_PSD_package(core, 1, coord_type);
 
+	if (acpigen_template_replay(&pss_template))
+		return;
+
+	ratio_min = cpu_get_min_ratio();
+	ratio_max = cpu_get_max_ratio();
+	clock_max = (ratio_max * cpu_get_bus_clock()) / KHz;
+	turbo = (get_turbo_state() == TURBO_ENABLED);
+
+	/* Calculate CPU TDP in mW */
+	power_max = cpu_get_power_max();
+
+	acpigen_template_begin(&pss_template);
+
 	/* Add P-state entries in _PSS table */
 	acpigen_write_name("_PSS");
 
@@ -286,6 +303,8 @@ void generate_p_state_entries(int core, int cores_per_package)
 	}
 	/* Fix package length */
 	acpigen_pop_len();
+
+	acpigen_template_end(&pss_template);
 }
 
 __weak acpi_tstate_t *soc_get_tss_table(int *entries)
@@ -12,6 +12,7 @@
 #include <intelblocks/fast_spi.h>
 #include <intelblocks/mp_init.h>
 #include <intelblocks/msr.h>
+#include <smp/node.h>
 #include <soc/cpu.h>
 
 static void initialize_microcode(void)
@@ -177,7 +178,11 @@ static void post_cpus_add_romcache(void)
 
 static void wrapper_x86_setup_mtrrs(void *unused)
 {
-	x86_setup_mtrrs_with_detect();
+	/* The BSP runs first and derives the MTRRs, the APs only copy them. */
+	if (boot_cpu())
+		x86_setup_mtrrs_with_detect();
+	else
+		x86_commit_mtrrs();
 }
 
 static void wrapper_set_bios_done(void *unused)
@@ -280,12 +280,7 @@ bool discover_crashlog(void)
 	return (cpu_cl_discovered || pmc_cl_discovered);
 }
 
-bool cl_copy_data_from_sram(u32 src_bar,
-				u32 offset,
-				u32 size,
-				u32 *dest_addr,
-				u32 buffer_index,
-				bool pmc_sram)
+bool cl_sram_record_present(u32 src_bar, u32 offset, u32 buffer_index, bool pmc_sram)
 {
 	if (src_bar == 0) {
 		printk(BIOS_ERR, "Invalid bar 0x%x and offset 0x%x for %s\n",
@@ -293,9 +288,7 @@ bool cl_copy_data_from_sram(u32 src_bar,
 		return false;
 	}
 
-	u32 src_addr = src_bar + offset;
-
-	u32 data =  read32((u32 *)(uintptr_t)src_addr);
+	u32 data =  read32((u32 *)(uintptr_t)(src_bar + offset));
 
 	/* First 32bits of the record must not be 0xdeadbeef */
 	if (data == INVALID_CRASHLOG_RECORD) {
@@ -317,10 +310,33 @@ bool cl_copy_data_from_sram(u32 src_bar,
 		return false;
 	}
 
+	return true;
+}
+
+bool cl_copy_data_from_sram(u32 src_bar,
+				u32 offset,
+				u32 size,
+				u32 *dest_addr,
+				u32 buffer_index,
+				bool pmc_sram)
+{
+	if (!cl_sram_record_present(src_bar, offset, buffer_index, pmc_sram))
+		return false;
+
+	uintptr_t src_addr = src_bar + offset;
 	u32 copied = 0;
+
+	/* Only byte access to the SRAMs is not allowed, so use QW reads where aligned. */
+	if (!((src_addr | (uintptr_t)dest_addr) & 7)) {
+		u64 *dest64 = (u64 *)dest_addr;
+
+		for (; copied + 2 <= size; copied += 2, src_addr += 8)
+			*dest64++ = read64p(src_addr);
+		dest_addr = (u32 *)dest64;
+	}
+
 	while (copied < size) {
-		/* DW by DW copy: byte access to PMC SRAM not allowed */
-		*dest_addr = read32((u32 *)(uintptr_t)src_addr);
+		*dest_addr = read32p(src_addr);
 		dest_addr++;
 		src_addr += 4;
 		copied++;
@@ -398,13 +414,20 @@ void __weak cl_get_pmc_sram_data(cl_node_t *head)
 
 	if (discovery_buf.bits.discov_mechanism == 1) {
 		for (int i = 0; i < descriptor_table.numb_regions; i++) {
-			cl_node_t *cl_node = malloc_cl_node(descriptor_table.regions[i].bits.size);
-			if (!cl_node) {
-				printk(BIOS_DEBUG, "failed to allocate cl_node [region = %d]\n", i);
-				goto pmc_send_re_arm_after_reset;
+			cl_node_t *cl_node = NULL;
+
+			/* Don't allocate buffers for regions without a record. */
+			if (cl_sram_record_present(tmp_bar_addr,
+						descriptor_table.regions[i].bits.offset, i, pmc_sram)) {
+				cl_node = malloc_cl_node(descriptor_table.regions[i].bits.size);
+				if (!cl_node) {
+					printk(BIOS_DEBUG, "failed to allocate cl_node [region = %d]\n",
+					       i);
+					goto pmc_send_re_arm_after_reset;
+				}
 			}
 
-			if (cl_copy_data_from_sram(tmp_bar_addr,
+			if (cl_node && cl_copy_data_from_sram(tmp_bar_addr,
 						descriptor_table.regions[i].bits.offset,
 						descriptor_table.regions[i].bits.size,
 						cl_node->data,
@@ -422,13 +445,18 @@ void __weak cl_get_pmc_sram_data(cl_node_t *head)
 			}
 		}
 	} else {
-		cl_node_t *cl_node = malloc_cl_node(discovery_buf.bits.size);
-		if (!cl_node) {
-			printk(BIOS_DEBUG, "failed to allocate cl_node\n");
-			goto pmc_send_re_arm_after_reset;
+		cl_node_t *cl_node = NULL;
+
+		if (cl_sram_record_present(tmp_bar_addr, discovery_buf.bits.base_offset, 0,
+					   pmc_sram)) {
+			cl_node = malloc_cl_node(discovery_buf.bits.size);
+			if (!cl_node) {
+				printk(BIOS_DEBUG, "failed to allocate cl_node\n");
+				goto pmc_send_re_arm_after_reset;
+			}
 		}
 
-		if (cl_copy_data_from_sram(tmp_bar_addr,
+		if (cl_node && cl_copy_data_from_sram(tmp_bar_addr,
 					discovery_buf.bits.base_offset,
 					discovery_buf.bits.size,
 					cl_node->data,
@@ -483,13 +511,19 @@ void cl_get_cpu_sram_data(cl_node_t *head)
 			continue;
 		}
 
-		cl_node_t *cl_node = malloc_cl_node(cpu_cl_disc_tab.buffers[i].fields.size);
-		if (!cl_node) {
-			printk(BIOS_DEBUG, "failed to allocate cl_node [buffer = %d]\n", i);
-			return;
+		cl_node_t *cl_node = NULL;
+
+		if (cl_sram_record_present(cpu_bar_addr, cpu_cl_disc_tab.buffers[i].fields.offset,
+					   i, pmc_sram)) {
+			cl_node = malloc_cl_node(cpu_cl_disc_tab.buffers[i].fields.size);
+			if (!cl_node) {
+				printk(BIOS_DEBUG, "failed to allocate cl_node [buffer = %d]\n",
+				       i);
+				return;
+			}
 		}
 
-		if (cl_copy_data_from_sram(cpu_bar_addr,
+		if (cl_node && cl_copy_data_from_sram(cpu_bar_addr,
 					cpu_cl_disc_tab.buffers[i].fields.offset,
 					cpu_cl_disc_tab.buffers[i].fields.size,
 					cl_node->data,
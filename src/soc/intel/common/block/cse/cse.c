@@ -32,6 +32,8 @@
 #define HECI_DELAY_READY_MS	(15 * 1000)
 /* Wait up to 100 usec between circular buffer polls */
 #define HECI_DELAY_US		100
+/* First delay between circular buffer polls, doubled up to HECI_DELAY_US */
+#define HECI_DELAY_MIN_US	2
 /* Wait up to 5 sec for CSE to chew something we sent */
 #define HECI_SEND_TIMEOUT_MS	(5 * 1000)
 /* Wait up to 5 sec for CSE to blurp a reply */
@@ -197,32 +199,40 @@ static void write_slot(uint32_t val)
 	write_bar(PCH_DEV_CSE, MMIO_CSE_CB_WW, val);
 }
 
-static int wait_write_slots(size_t cnt)
+/*
+ * Polls until slots() reports at least cnt slots. Most commands are handled by the CSE
+ * within a few microseconds, so the delay between polls starts short and only grows to
+ * HECI_DELAY_US for commands that take longer.
+ */
+static int wait_slots(size_t (*slots)(void), size_t cnt, long timeout_ms)
 {
+	unsigned int delay = HECI_DELAY_MIN_US;
 	struct stopwatch sw;
 
-	stopwatch_init_msecs_expire(&sw, HECI_SEND_TIMEOUT_MS);
-	while (host_empty_slots() < cnt) {
-		udelay(HECI_DELAY_US);
-		if (stopwatch_expired(&sw)) {
-			printk(BIOS_ERR, "HECI: timeout, buffer not drained\n");
+	stopwatch_init_msecs_expire(&sw, timeout_ms);
+	while (slots() < cnt) {
+		udelay(delay);
+		delay = MIN(delay * 2, HECI_DELAY_US);
+		if (stopwatch_expired(&sw))
 			return 0;
-		}
 	}
 	return 1;
 }
 
-static int wait_read_slots(size_t cnt)
+static int wait_write_slots(size_t cnt)
 {
-	struct stopwatch sw;
+	if (!wait_slots(host_empty_slots, cnt, HECI_SEND_TIMEOUT_MS)) {
+		printk(BIOS_ERR, "HECI: timeout, buffer not drained\n");
+		return 0;
+	}
+	return 1;
+}
 
-	stopwatch_init_msecs_expire(&sw, HECI_READ_TIMEOUT_MS);
-	while (cse_filled_slots() < cnt) {
-		udelay(HECI_DELAY_US);
-		if (stopwatch_expired(&sw)) {
-			printk(BIOS_ERR, "HECI: timed out reading answer!\n");
-			return 0;
-		}
+static int wait_read_slots(size_t cnt)
+{
+	if (!wait_slots(cse_filled_slots, cnt, HECI_READ_TIMEOUT_MS)) {
+		printk(BIOS_ERR, "HECI: timed out reading answer!\n");
+		return 0;
 	}
 	return 1;
 }
@@ -386,19 +396,19 @@ send_one_message(uint32_t hdr, const void *buff)
 	uint32_t tmp;
 	const uint32_t *p = buff;
 
-	/* Get space for the header */
-	if (!wait_write_slots(1))
-		return 0;
-
-	/* First, write header */
-	write_slot(hdr);
-
 	pend_len = hdr_get_length(hdr);
 	pend_slots = bytes_to_slots(pend_len);
 
-	if (!wait_write_slots(pend_slots))
+	/*
+	 * heci_send() never makes a message longer than the circular buffer, so wait for
+	 * the header and the body at once and write them back to back.
+	 */
+	if (!wait_write_slots(1 + pend_slots))
 		return 0;
 
+	/* First, write header */
+	write_slot(hdr);
+
 	/* Write the body in whole slots */
 	i = 0;
 	while (i < ALIGN_DOWN(pend_len, SLOT_SIZE)) {
@@ -503,7 +513,8 @@ recv_one_message(uint32_t *hdr, void *buff, size_t maxlen, size_t *recv_len)
 	}
 
 	/* wait for the rest of messages to arrive */
-	wait_read_slots(recv_slots);
+	if (!wait_read_slots(recv_slots))
+		return CSE_RX_ERR_TIMEOUT;
 
 	/* fetch whole slots first */
 	while (i < ALIGN_DOWN(*recv_len, SLOT_SIZE)) {
@@ -164,18 +164,15 @@ static enum cse_fw_state get_cse_state(const struct fw_version *cur_cse_fw_ver,
  * Helper function that stores current CSE firmware version to CBMEM memory,
  * except during recovery mode.
  */
-static void cse_store_rw_fw_version(void)
+static void cse_store_rw_fw_version(const struct fw_version *rw_version)
 {
-	const struct cse_bp_entry *cse_bp;
-	cse_bp = cse_get_bp_entry(RW);
-
 	if (vboot_recovery_mode_enabled())
 		return;
 
 	if (CONFIG(SOC_INTEL_CSE_LITE_SYNC_IN_ROMSTAGE)) {
 		/* update current CSE version and return */
 		memcpy(&(cse_info.cse_fwp_version.cur_cse_fw_version),
-		 &(cse_bp->fw_ver), sizeof(struct fw_version));
+		 rw_version, sizeof(struct fw_version));
 		return;
 	}
 
@@ -192,14 +189,14 @@ static void cse_store_rw_fw_version(void)
 	cmos_read_fw_partition_info(&cse_info_in_cmos);
 
 	/* Get current cse firmware state */
-	enum cse_fw_state fw_state = get_cse_state(&(cse_bp->fw_ver),
+	enum cse_fw_state fw_state = get_cse_state(rw_version,
 		 &(cse_info_in_cmos.cse_fwp_version.cur_cse_fw_version),
 		 &(cse_info_in_cbmem->cse_fwp_version.cur_cse_fw_version));
 
 	/* Reset CBMEM data and update current CSE version */
 	memset(cse_info_in_cbmem, 0, sizeof(*cse_info_in_cbmem));
 	memcpy(&(cse_info_in_cbmem->cse_fwp_version.cur_cse_fw_version),
-		 &(cse_bp->fw_ver), sizeof(struct fw_version));
+		 rw_version, sizeof(struct fw_version));
 
 	/* Update the CRC */
 	store_cse_info_crc(cse_info_in_cbmem);
@@ -1319,6 +1316,30 @@ static enum csme_failure_reason cse_sub_part_fw_update(void)
 	return handle_cse_sub_part_fw_update_rv(rv);
 }
 
+/*
+ * Check whether the last successful sync still holds: the CSE runs its RW partition, which
+ * is only the case after coreboot switched it there, and the CSE RW version in CBFS is the
+ * one that sync ended with. On success, rw_version is the version of the running CSE RW.
+ */
+static bool cse_is_synced(struct fw_version *rw_version)
+{
+	struct fw_version cbfs_rw_version;
+
+	if (!cse_is_hfs1_cws_normal() || !cse_is_hfs1_com_normal())
+		return false;
+
+	if (cmos_read_cse_sync_version(rw_version) < 0)
+		return false;
+
+	if (!is_cse_fw_update_enabled())
+		return true;
+
+	if (get_cse_ver_from_cbfs(&cbfs_rw_version) != CB_SUCCESS)
+		return false;
+
+	return !cse_compare_sub_part_version(&cbfs_rw_version, rw_version);
+}
+
 static void do_cse_fw_sync(void)
 {
 	/*
@@ -1336,6 +1357,22 @@ static void do_cse_fw_sync(void)
 		return;
 	}
 
+	if (CONFIG(SOC_INTEL_CSE_LITE_SYNC_CACHE)) {
+		struct fw_version rw_version;
+
+		if (cse_is_synced(&rw_version)) {
+			printk(BIOS_DEBUG, "cse_lite: CSE RW %d.%d.%d.%d is in sync\n",
+			       rw_version.major, rw_version.minor, rw_version.hotfix,
+			       rw_version.build);
+			if (CONFIG(SOC_INTEL_STORE_CSE_FW_VERSION))
+				cse_store_rw_fw_version(&rw_version);
+			return;
+		}
+
+		/* The sync below may change the boot partition or update the RW firmware */
+		cmos_clear_cse_sync_version();
+	}
+
 	if (cse_get_bp_info() != CB_SUCCESS) {
 		printk(BIOS_ERR, "cse_lite: Failed to get CSE boot partition info\n");
 
@@ -1351,7 +1388,7 @@ static void do_cse_fw_sync(void)
 
 	/* Store the CSE RW Firmware Version into CBMEM */
 	if (CONFIG(SOC_INTEL_STORE_CSE_FW_VERSION))
-		cse_store_rw_fw_version();
+		cse_store_rw_fw_version(cse_get_rw_version());
 
 	/*
 	 * If system is in recovery mode, CSE Lite update has to be skipped but CSE
@@ -1393,6 +1430,10 @@ static void do_cse_fw_sync(void)
 		printk(BIOS_ERR, "cse_lite: Failed to switch to RW\n");
 		cse_trigger_vboot_recovery(CSE_LITE_SKU_RW_SWITCH_ERROR);
 	}
+
+	/* The CSE runs the RW firmware from CBFS, later boots can skip the checks above */
+	if (CONFIG(SOC_INTEL_CSE_LITE_SYNC_CACHE))
+		cmos_write_cse_sync_version(cse_get_rw_version());
 }
 
 void cse_fw_sync(void)
@@ -38,6 +38,17 @@
 #endif
 
 #define PSR_BACKUP_STATUS_SIGNATURE 0x42525350	/* 'PSRB' */
+#define CSE_SYNC_SIGNATURE 0x4e595343		/* 'CSYN' */
+
+#define CSE_SYNC_CMOS_OFFSET (PARTITION_FW_CMOS_OFFSET + sizeof(struct cse_specific_info) + \
+			      sizeof(struct psr_backup_status))
+
+/* Record of the last successful CSE firmware sync, stored behind `psr_backup_status` */
+struct cse_sync_record {
+	uint32_t signature;
+	struct fw_version rw_version;
+	uint16_t checksum;
+} __packed;
 
 /* Helper function to read CSE fpt information from cmos memory. */
 void cmos_read_fw_partition_info(struct cse_specific_info *info)
@@ -104,6 +115,47 @@ void update_psr_backup_status(int8_t status)
 	printk(BIOS_INFO, "PSR backup status updated\n");
 }
 
+static void cse_sync_record_cmos_write(const struct cse_sync_record *rec)
+{
+	const uint8_t *p = (const uint8_t *)rec;
+
+	for (size_t i = 0; i < sizeof(*rec); i++)
+		cmos_write(p[i], CSE_SYNC_CMOS_OFFSET + i);
+}
+
+int cmos_read_cse_sync_version(struct fw_version *version)
+{
+	struct cse_sync_record rec;
+
+	for (uint8_t *p = (uint8_t *)&rec, i = 0; i < sizeof(rec); i++, p++)
+		*p = cmos_read(CSE_SYNC_CMOS_OFFSET + i);
+
+	if (rec.signature != CSE_SYNC_SIGNATURE ||
+	    rec.checksum != ipchksum(&rec, offsetof(struct cse_sync_record, checksum)))
+		return -1;
+
+	*version = rec.rw_version;
+	return 0;
+}
+
+void cmos_write_cse_sync_version(const struct fw_version *version)
+{
+	struct cse_sync_record rec = {
+		.signature = CSE_SYNC_SIGNATURE,
+		.rw_version = *version,
+	};
+
+	rec.checksum = ipchksum(&rec, offsetof(struct cse_sync_record, checksum));
+	cse_sync_record_cmos_write(&rec);
+}
+
+void cmos_clear_cse_sync_version(void)
+{
+	const struct cse_sync_record rec = { 0 };
+
+	cse_sync_record_cmos_write(&rec);
+}
+
 /*
  * Helper function to retrieve the current `psr_backup_status` in CMOS memory
  * Returns current status on success, the status can be PSR_BACKUP_DONE or PSR_BACKUP_PENDING.
@@ -21,4 +21,16 @@ void update_psr_backup_status(int8_t status);
  */
 int8_t get_psr_backup_status(void);
 
+/*
+ * Helper function to read the CSE RW version of the last successful CSE firmware sync from
+ * CMOS memory. Returns 0 on success and -1 if no valid record is stored.
+ */
+int cmos_read_cse_sync_version(struct fw_version *version);
+
+/* Helper function to store the CSE RW version of a successful CSE firmware sync in CMOS. */
+void cmos_write_cse_sync_version(const struct fw_version *version);
+
+/* Helper function to drop the record of the last CSE firmware sync from CMOS memory. */
+void cmos_clear_cse_sync_version(void);
+
 #endif /* SOC_INTEL_COMMON_BLOCK_CSE_LITE_CMOS_H */
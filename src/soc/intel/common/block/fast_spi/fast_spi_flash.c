@@ -171,6 +171,18 @@ static int exec_sync_hwseq_xfer(struct fast_spi_flash_ctx *ctx,
 	return wait_for_hwseq_xfer(ctx, flash_addr);
 }
 
+/*
+ * Execute the next cycle of a read, write or erase. The previous cycle ended with FDONE,
+ * so the controller is idle and SCIP doesn't need to be polled again.
+ */
+static int exec_next_hwseq_xfer(struct fast_spi_flash_ctx *ctx,
+				uint32_t hsfsts_cycle, uint32_t flash_addr,
+				size_t len)
+{
+	start_hwseq_xfer(ctx, hsfsts_cycle, flash_addr, len);
+	return wait_for_hwseq_xfer(ctx, flash_addr);
+}
+
 int fast_spi_cycle_in_progress(void)
 {
 	BOILERPLATE_CREATE_CTX(ctx);
@@ -184,7 +196,7 @@ int fast_spi_cycle_in_progress(void)
 }
 
 /*
- * Ensure read/write xfer len is not greater than SPIBAR_FDATA_FIFO_SIZE and
+ * Ensure write xfer len is not greater than SPIBAR_FDATA_FIFO_SIZE and
  * that the operation does not cross page boundary.
  */
 static size_t get_xfer_len(const struct spi_flash *flash, uint32_t addr,
@@ -205,6 +217,7 @@ static int fast_spi_flash_erase(const struct spi_flash *flash,
 	int ret;
 	size_t erase_size;
 	uint32_t erase_cycle;
+	bool first = true;
 
 	BOILERPLATE_CREATE_CTX(ctx);
 
@@ -224,9 +237,13 @@ static int fast_spi_flash_erase(const struct spi_flash *flash,
 		printk(BIOS_SPEW, "Erasing flash addr %x + %zu KiB\n",
 		       offset, erase_size / KiB);
 
-		ret = exec_sync_hwseq_xfer(ctx, erase_cycle, offset, 0);
+		if (first)
+			ret = exec_sync_hwseq_xfer(ctx, erase_cycle, offset, 0);
+		else
+			ret = exec_next_hwseq_xfer(ctx, erase_cycle, offset, 0);
 		if (ret != SUCCESS)
 			return ret;
+		first = false;
 
 		offset += erase_size;
 		len -= erase_size;
@@ -245,10 +262,15 @@ static int fast_spi_flash_read(const struct spi_flash *flash,
 	BOILERPLATE_CREATE_CTX(ctx);
 
 	while (len) {
-		xfer_len = get_xfer_len(flash, addr, len);
-
-		ret = exec_sync_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_READ,
-						addr, xfer_len);
+		/* Reads may cross pages, so every cycle but the last one is full size. */
+		xfer_len = MIN(len, SPIBAR_FDATA_FIFO_SIZE);
+
+		if (data == buf)
+			ret = exec_sync_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_READ,
+						   addr, xfer_len);
+		else
+			ret = exec_next_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_READ,
+						   addr, xfer_len);
 		if (ret != SUCCESS)
 			return ret;
 
@@ -275,8 +297,12 @@ static int fast_spi_flash_write(const struct spi_flash *flash,
 		xfer_len = get_xfer_len(flash, addr, len);
 		fill_xfer_fifo(ctx, data, xfer_len);
 
-		ret = exec_sync_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_WRITE,
-						addr, xfer_len);
+		if (data == buf)
+			ret = exec_sync_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_WRITE,
+						   addr, xfer_len);
+		else
+			ret = exec_next_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_WRITE,
+						   addr, xfer_len);
 		if (ret != SUCCESS)
 			return ret;
 
@@ -139,73 +139,71 @@ static const struct pad_community *gpio_get_community(gpio_t pad)
 	return NULL;
 }
 
-static void gpio_configure_owner(const struct pad_config *cfg,
-				const struct pad_community *comm)
+/*
+ * The HOSTSW_OWN and GPI enable registers hold one bit per pad of a group. Pad tables
+ * usually list the pads of a group one after another, so the bits of such a run of pads
+ * are collected and each register is accessed once per run instead of once per pad.
+ */
+struct gpio_group_batch {
+	const struct pad_community *comm;
+	size_t group;
+	/* Pads of the group that were configured and which of them are owned by the host */
+	uint32_t own_mask;
+	uint32_t own_value;
+	/* Pads to enable for SMI, NMI and GPE */
+	uint32_t smi_en;
+	uint32_t nmi_en;
+	uint32_t gpe_en;
+};
+
+static void gpio_configure_owner(const struct pad_community *comm, size_t group,
+				 uint32_t own_mask, uint32_t own_value)
 {
-	uint32_t hostsw_own;
+	uint32_t hostsw_own, old;
 	uint16_t hostsw_own_offset;
-	int pin;
-
-	pin = relative_pad_in_comm(comm, cfg->pad);
 
 	/* Based on the gpio pin number configure the corresponding bit in
 	 * HOSTSW_OWN register. Value of 0x1 indicates GPIO Driver onwership.
 	 */
-	hostsw_own_offset = comm->host_own_reg_0;
-	hostsw_own_offset += gpio_group_index_scaled(comm, pin,
-		sizeof(uint32_t));
-
-	hostsw_own = pcr_read32(comm->port, hostsw_own_offset);
+	hostsw_own_offset = comm->host_own_reg_0 + group * sizeof(uint32_t);
 
-	/* The 4th bit in pad_config 1 (RO) is used to indicate if the pad
-	 * needs GPIO driver ownership.  Set the bit if GPIO driver ownership
-	 * requested, otherwise clear the bit.
-	 */
-	if (cfg->pad_config[1] & PAD_CFG_OWN_GPIO_DRIVER)
-		hostsw_own |= gpio_bitmask_within_group(comm, pin);
-	else
-		hostsw_own &= ~gpio_bitmask_within_group(comm, pin);
+	old = pcr_read32(comm->port, hostsw_own_offset);
+	hostsw_own = (old & ~own_mask) | own_value;
 
-	pcr_write32(comm->port, hostsw_own_offset, hostsw_own);
+	if (hostsw_own != old)
+		pcr_write32(comm->port, hostsw_own_offset, hostsw_own);
 }
 
-static void gpi_enable_gpe(const struct pad_config *cfg,
-			const struct pad_community *comm, int group, int pin)
+static void gpi_enable_gpe(const struct pad_community *comm, size_t group,
+			   uint32_t en_value)
 {
 	uint16_t en_reg;
-	uint32_t en_value;
 
-	/* Do not configure GPE_EN if PAD is not configured for SCI/wake */
-	if (((cfg->pad_config[0]) & PAD_CFG0_ROUTE_SCI) != PAD_CFG0_ROUTE_SCI)
+	if (!en_value)
 		return;
 
-	/* Get comm offset and bit mask to be set as per pin */
 	en_reg = GPI_GPE_EN_OFFSET(comm, group);
-	en_value = gpio_bitmask_within_group(comm, pin);
 
 	/* Set enable bits */
 	pcr_or32(comm->port, en_reg, en_value);
 
 	if (CONFIG(DEBUG_GPIO)) {
-		printk(BIOS_DEBUG, "GPE_EN[0x%02x, %02zd]: Reg: 0x%x, Value = 0x%x\n",
-			comm->port, relative_pad_in_comm(comm, cfg->pad), en_reg,
-			pcr_read32(comm->port, en_reg));
+		printk(BIOS_DEBUG, "GPE_EN[0x%02x, group %02zd]: Reg: 0x%x, Value = 0x%x\n",
+			comm->port, group, en_reg, pcr_read32(comm->port, en_reg));
 	}
 }
 
-static void gpi_enable_smi(const struct pad_config *cfg,
-			const struct pad_community *comm, int group, int pin)
+static void gpi_enable_smi(const struct pad_community *comm, size_t group,
+			   uint32_t en_value)
 {
 	uint16_t sts_reg;
 	uint16_t en_reg;
-	uint32_t en_value;
 
-	if (((cfg->pad_config[0]) & PAD_CFG0_ROUTE_SMI) != PAD_CFG0_ROUTE_SMI)
+	if (!en_value)
 		return;
 
 	sts_reg = GPI_SMI_STS_OFFSET(comm, group);
 	en_reg = GPI_SMI_EN_OFFSET(comm, group);
-	en_value = gpio_bitmask_within_group(comm, pin);
 
 	/* Write back 1 to reset the sts bit */
 	pcr_rmw32(comm->port, sts_reg, en_value, 0);
@@ -214,14 +212,13 @@ static void gpi_enable_smi(const struct pad_config *cfg,
 	pcr_or32(comm->port, en_reg, en_value);
 }
 
-static void gpi_enable_nmi(const struct pad_config *cfg,
-			const struct pad_community *comm, int group, int pin)
+static void gpi_enable_nmi(const struct pad_community *comm, size_t group,
+			   uint32_t en_value)
 {
 	uint16_t sts_reg;
 	uint16_t en_reg;
-	uint32_t en_value;
 
-	if (((cfg->pad_config[0]) & PAD_CFG0_ROUTE_NMI) != PAD_CFG0_ROUTE_NMI)
+	if (!en_value)
 		return;
 
 	/* Do not configure NMI if the platform doesn't support it */
@@ -230,7 +227,6 @@ static void gpi_enable_nmi(const struct pad_config *cfg,
 
 	sts_reg = GPI_NMI_STS_OFFSET(comm, group);
 	en_reg = GPI_NMI_EN_OFFSET(comm, group);
-	en_value = gpio_bitmask_within_group(comm, pin);
 
 	/* Write back 1 to reset the sts bit */
 	pcr_rmw32(comm->port, sts_reg, en_value, 0);
@@ -239,6 +235,50 @@ static void gpi_enable_nmi(const struct pad_config *cfg,
 	pcr_or32(comm->port, en_reg, en_value);
 }
 
+static void gpio_batch_flush(struct gpio_group_batch *batch)
+{
+	if (!batch->own_mask)
+		return;
+
+	gpio_configure_owner(batch->comm, batch->group, batch->own_mask, batch->own_value);
+	gpi_enable_smi(batch->comm, batch->group, batch->smi_en);
+	gpi_enable_nmi(batch->comm, batch->group, batch->nmi_en);
+	gpi_enable_gpe(batch->comm, batch->group, batch->gpe_en);
+
+	memset(batch, 0, sizeof(*batch));
+}
+
+static void gpio_batch_add(struct gpio_group_batch *batch, const struct pad_config *cfg,
+			   const struct pad_community *comm, size_t group, int pin)
+{
+	const uint32_t bit = 1U << (pin - comm->groups[group].first_pad);
+
+	if (batch->comm != comm || batch->group != group) {
+		gpio_batch_flush(batch);
+		batch->comm = comm;
+		batch->group = group;
+	}
+
+	batch->own_mask |= bit;
+
+	/* The 4th bit in pad_config 1 (RO) is used to indicate if the pad
+	 * needs GPIO driver ownership.  Set the bit if GPIO driver ownership
+	 * requested, otherwise clear the bit.
+	 */
+	if (cfg->pad_config[1] & PAD_CFG_OWN_GPIO_DRIVER)
+		batch->own_value |= bit;
+	else
+		batch->own_value &= ~bit;
+
+	if ((cfg->pad_config[0] & PAD_CFG0_ROUTE_SMI) == PAD_CFG0_ROUTE_SMI)
+		batch->smi_en |= bit;
+	if ((cfg->pad_config[0] & PAD_CFG0_ROUTE_NMI) == PAD_CFG0_ROUTE_NMI)
+		batch->nmi_en |= bit;
+	/* Do not configure GPE_EN if PAD is not configured for SCI/wake */
+	if ((cfg->pad_config[0] & PAD_CFG0_ROUTE_SCI) == PAD_CFG0_ROUTE_SCI)
+		batch->gpe_en |= bit;
+}
+
 /* 120 GSIs is the default for IOxAPIC */
 static uint32_t gpio_ioapic_irqs_used[120 / (sizeof(uint32_t) * BITS_PER_BYTE) + 1];
 static void set_ioapic_used(uint32_t irq)
@@ -331,12 +371,13 @@ static const int mask[4] = {
 	PAD_DW0_MASK, PAD_DW1_MASK, PAD_DW2_MASK, PAD_DW3_MASK
 };
 
-static void gpio_configure_pad(const struct pad_config *cfg)
+static void gpio_configure_pad(const struct pad_config *cfg, struct gpio_group_batch *batch)
 {
 	const struct pad_community *comm;
 	uint16_t config_offset;
 	uint32_t pad_conf, soc_pad_conf;
-	int i, pin, group;
+	int i, pin;
+	size_t group;
 
 	if (!cfg) {
 		printk(BIOS_ERR, "%s: cfg value is NULL\n", __func__);
@@ -381,20 +422,24 @@ static void gpio_configure_pad(const struct pad_config *cfg)
 	}
 
 	gpio_configure_itss(cfg, comm->port, config_offset);
-	gpio_configure_owner(cfg, comm);
-	gpi_enable_smi(cfg, comm, group, pin);
-	gpi_enable_nmi(cfg, comm, group, pin);
-	gpi_enable_gpe(cfg, comm, group, pin);
-	if (cfg->lock_action)
+	gpio_batch_add(batch, cfg, comm, group, pin);
+
+	/* The ownership must be final before the pad is locked. */
+	if (cfg->lock_action) {
+		gpio_batch_flush(batch);
 		gpio_lock_pad(cfg->pad, cfg->lock_action);
+	}
 }
 
 void gpio_configure_pads(const struct pad_config *cfg, size_t num_pads)
 {
+	struct gpio_group_batch batch = { 0 };
 	size_t i;
 
 	for (i = 0; i < num_pads; i++)
-		gpio_configure_pad(cfg + i);
+		gpio_configure_pad(cfg + i, &batch);
+
+	gpio_batch_flush(&batch);
 }
 
 /*
@@ -424,14 +469,17 @@ void gpio_configure_pads_with_override(const struct pad_config *base_cfg,
 					const struct pad_config *override_cfg,
 					size_t override_num_pads)
 {
+	struct gpio_group_batch batch = { 0 };
 	size_t i;
 	const struct pad_config *c;
 
 	for (i = 0; i < base_num_pads; i++) {
 		c = gpio_get_config(base_cfg + i, override_cfg,
 				override_num_pads);
-		gpio_configure_pad(c);
+		gpio_configure_pad(c, &batch);
 	}
+
+	gpio_batch_flush(&batch);
 }
 
 struct pad_config *new_padbased_table(void)
@@ -456,14 +504,17 @@ void gpio_padbased_override(struct pad_config *padbased_table,
 
 void gpio_configure_pads_with_padbased(struct pad_config *padbased_table)
 {
+	struct gpio_group_batch batch = { 0 };
 	size_t i;
 	const struct pad_config *cfg = padbased_table;
 	for (i = 0; i < TOTAL_PADS; i++) {
 		/* Consider unmapped pin as default setting, skip */
 		if (cfg[i].pad == 0 && cfg[i].pad_config[0] == 0)
 			continue;
-		gpio_configure_pad(&cfg[i]);
+		gpio_configure_pad(&cfg[i], &batch);
 	}
+
+	gpio_batch_flush(&batch);
 }
 
 void *gpio_dwx_address(const gpio_t pad)
@@ -492,25 +543,25 @@ uint8_t gpio_get_pad_portid(const gpio_t pad)
 void gpio_input_pulldown(gpio_t gpio)
 {
 	struct pad_config cfg = PAD_CFG_GPI(gpio, DN_20K, DEEP);
-	gpio_configure_pad(&cfg);
+	gpio_configure_pads(&cfg, 1);
 }
 
 void gpio_input_pullup(gpio_t gpio)
 {
 	struct pad_config cfg = PAD_CFG_GPI(gpio, UP_20K, DEEP);
-	gpio_configure_pad(&cfg);
+	gpio_configure_pads(&cfg, 1);
 }
 
 void gpio_input(gpio_t gpio)
 {
 	struct pad_config cfg = PAD_CFG_GPI(gpio, NONE, DEEP);
-	gpio_configure_pad(&cfg);
+	gpio_configure_pads(&cfg, 1);
 }
 
 void gpio_output(gpio_t gpio, int value)
 {
 	struct pad_config cfg = PAD_CFG_GPO(gpio, value, DEEP);
-	gpio_configure_pad(&cfg);
+	gpio_configure_pads(&cfg, 1);
 }
 
 int gpio_get(gpio_t gpio_num)
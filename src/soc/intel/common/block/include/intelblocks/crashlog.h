@@ -215,6 +215,8 @@ int cl_pmc_re_arm_after_reset(void);
 int cl_pmc_clear(void);
 int cl_pmc_en_gen_on_all_reboot(void);
 bool discover_crashlog(void);
+/* Check the first DWORD of an SRAM region for a valid record without copying it. */
+bool cl_sram_record_present(u32 src_bar, u32 offset, u32 buffer_index, bool pmc_sram);
 bool cl_copy_data_from_sram(u32 src_bar,
 			u32 offset,
 			u32 size,
@@ -3,6 +3,7 @@
 #include <console/console.h>
 #include <intelblocks/meminit.h>
 #include <commonlib/region.h>
+#include <hw_fingerprint.h>
 #include <spd_bin.h>
 #include <spd_cache.h>
 #include <string.h>
@@ -172,6 +173,8 @@ static bool read_spd_dimm(FSPM_UPD *memupd, const struct soc_mem_cfg *soc_mem_cf
 				continue;
 
 			print_spd_info(spd_data);
+			/* The SPD carries the DIMM serial numbers. */
+			hw_fingerprint_add(spd_data, blk.len);
 
 			channel_data->spd[mrc_ch][dimm] = (uintptr_t)(void *)spd_data;
 			pop_mask |= BIT(ch);
@@ -92,6 +92,18 @@ void get_spd_smbus(struct spd_block *blk)
 	update_spd_len(blk);
 }
 
+/* Read the 4 serial number bytes at offset, as one I2C read if the controller supports it. */
+static void read_spd_sn(u8 addr, u8 offset, u32 *sn)
+{
+	u8 i;
+
+	if (i2c_eeprom_read(addr, offset, SPD_SN_LEN, (u8 *)sn) == 0)
+		return;
+
+	for (i = 0; i < SPD_SN_LEN; i++)
+		*((u8 *)sn + i) = smbus_read_byte(addr, offset + i);
+}
+
 /*
  * get_spd_sn returns the SODIMM serial number. It only supports DDR3 and DDR4.
  *  return CB_SUCCESS, sn is the serial number and sn=0xffffffff if the dimm is not present.
@@ -99,7 +111,6 @@ void get_spd_smbus(struct spd_block *blk)
  */
 enum cb_err get_spd_sn(u8 addr, u32 *sn)
 {
-	u8 i;
 	u8 dram_type;
 	int smbus_ret;
 
@@ -127,16 +138,12 @@ enum cb_err get_spd_sn(u8 addr, u32 *sn)
 		/* Switch to page 1 */
 		smbus_write_byte(SPD_PAGE_1, 0, 0);
 
-		for (i = 0; i < SPD_SN_LEN; i++)
-			*((u8 *)sn + i) = smbus_read_byte(addr,
-						i + DDR4_SPD_SN_OFF);
+		read_spd_sn(addr, DDR4_SPD_SN_OFF - SPD_PAGE_LEN, sn);
 
 		/* Restore to page 0 */
 		smbus_write_byte(SPD_PAGE_0, 0, 0);
 	} else if (dram_type == SPD_DRAM_DDR3) {
-		for (i = 0; i < SPD_SN_LEN; i++)
-			*((u8 *)sn + i) = smbus_read_byte(addr,
-							i + DDR3_SPD_SN_OFF);
+		read_spd_sn(addr, DDR3_SPD_SN_OFF, sn);
 	} else {
 		printk(BIOS_ERR, "Unsupported dram_type\n");
 		return CB_ERR;
@@ -144,3 +151,52 @@ enum cb_err get_spd_sn(u8 addr, u32 *sn)
 
 	return CB_SUCCESS;
 }
+
+enum cb_err get_spd_sns(const struct spd_block *blk, u32 *sn)
+{
+	u8 dram_type[CONFIG_DIMM_MAX];
+	bool has_ddr4 = false;
+	int smbus_ret;
+	u8 i;
+
+	/* The page select commands go to all SPDs on the bus, so each one is sent only once. */
+	if (CONFIG_DIMM_SPD_SIZE > SPD_PAGE_LEN)
+		smbus_write_byte(SPD_PAGE_0, 0, 0);
+
+	for (i = 0; i < CONFIG_DIMM_MAX; i++) {
+		sn[i] = 0xffffffff;
+		dram_type[i] = 0;
+
+		if (blk->addr_map[i] == 0)
+			continue;
+
+		smbus_ret = smbus_read_byte(blk->addr_map[i], SPD_DRAM_TYPE);
+		if (smbus_ret < 0) {
+			printk(BIOS_INFO, "No memory dimm at address %02X\n",
+			       blk->addr_map[i] << 1);
+			continue;
+		}
+
+		dram_type[i] = smbus_ret & 0xff;
+		if (dram_type[i] == SPD_DRAM_DDR4 && CONFIG_DIMM_SPD_SIZE > SPD_PAGE_LEN) {
+			has_ddr4 = true;
+		} else if (dram_type[i] == SPD_DRAM_DDR3) {
+			read_spd_sn(blk->addr_map[i], DDR3_SPD_SN_OFF, &sn[i]);
+		} else {
+			printk(BIOS_ERR, "Unsupported dram_type\n");
+			return CB_ERR;
+		}
+	}
+
+	if (!has_ddr4)
+		return CB_SUCCESS;
+
+	smbus_write_byte(SPD_PAGE_1, 0, 0);
+	for (i = 0; i < CONFIG_DIMM_MAX; i++) {
+		if (dram_type[i] == SPD_DRAM_DDR4)
+			read_spd_sn(blk->addr_map[i], DDR4_SPD_SN_OFF - SPD_PAGE_LEN, &sn[i]);
+	}
+	smbus_write_byte(SPD_PAGE_0, 0, 0);
+
+	return CB_SUCCESS;
+}
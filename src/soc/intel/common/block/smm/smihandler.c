@@ -6,6 +6,7 @@
 #include <cpu/x86/cache.h>
 #include <cpu/x86/msr.h>
 #include <cpu/x86/smm.h>
+#include <cpu/x86/tsc.h>
 #include <cpu/intel/em64t100_save_state.h>
 #include <cpu/intel/em64t101_save_state.h>
 #include <cpu/intel/msr.h>
@@ -20,6 +21,7 @@
 #include <intelblocks/smihandler.h>
 #include <intelblocks/tco.h>
 #include <intelblocks/uart.h>
+#include <lib.h>
 #include <smmstore.h>
 #include <soc/nvs.h>
 #include <soc/pci_devs.h>
@@ -535,13 +537,17 @@ void southbridge_smi_handler(void)
 
 	save_state_ops = get_smm_save_state_ops();
 
-	/* Call SMI sub handler for each of the status bits */
-	for (i = 0; i < ARRAY_SIZE(southbridge_smi); i++) {
-		if (!(smi_sts & (1 << i)))
-			continue;
+	/* Call SMI sub handler for each of the status bits that are set */
+	for (; smi_sts; smi_sts &= smi_sts - 1) {
+		i = __ffs(smi_sts);
 
 		if (southbridge_smi[i] != NULL) {
+			const u64 start = CONFIG(SMM_LATENCY_HISTOGRAM) ? rdtscll() : 0;
+
 			southbridge_smi[i](save_state_ops);
+
+			if (CONFIG(SMM_LATENCY_HISTOGRAM))
+				smm_latency_histogram_add(i, rdtscll() - start);
 		} else {
 			printk(BIOS_DEBUG,
 			       "SMI_STS[%d] occurred, but no "
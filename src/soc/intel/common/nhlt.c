@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <acpi/acpi.h>
 #include <acpi/acpi_gnvs.h>
 #include <nhlt.h>
 #include <soc/nvs.h>
@@ -27,3 +28,26 @@ uintptr_t nhlt_soc_serialize_oem_overrides(struct nhlt *nhlt,
 	return nhlt_serialize_oem_overrides(nhlt, acpi_addr,
 					oem_id, oem_table_id, oem_revision);
 }
+
+uintptr_t nhlt_soc_serialize_from_cbfs(const char *name, uintptr_t acpi_addr,
+	const char *oem_id, const char *oem_table_id, uint32_t oem_revision)
+{
+	struct global_nvs *gnvs;
+	uintptr_t next;
+
+	gnvs = acpi_get_gnvs();
+
+	if (gnvs == NULL)
+		return acpi_addr;
+
+	next = nhlt_serialize_from_cbfs(name, acpi_addr, oem_id, oem_table_id,
+					oem_revision);
+	if (next == acpi_addr)
+		return acpi_addr;
+
+	/* Update NHLT GNVS Data */
+	gnvs->nhla = (uintptr_t)acpi_addr;
+	gnvs->nhll = ((acpi_header_t *)acpi_addr)->length;
+
+	return next;
+}
@@ -144,14 +144,20 @@ void cl_get_pmc_sram_data(cl_node_t *head)
 			else
 				continue;
 
-			cl_node_t *cl_node = malloc_cl_node(descriptor_table.regions[i].bits.size);
-
-			if (!cl_node) {
-				printk(BIOS_DEBUG, "failed to allocate cl_node [region = %d]\n", i);
-				goto pmc_send_re_arm_after_reset;
+			cl_node_t *cl_node = NULL;
+
+			/* Don't allocate buffers for regions without a record. */
+			if (cl_sram_record_present(sram_base,
+						descriptor_table.regions[i].bits.offset, i, pmc_sram)) {
+				cl_node = malloc_cl_node(descriptor_table.regions[i].bits.size);
+				if (!cl_node) {
+					printk(BIOS_DEBUG, "failed to allocate cl_node [region = %d]\n",
+					       i);
+					goto pmc_send_re_arm_after_reset;
+				}
 			}
 
-			if (cl_copy_data_from_sram(sram_base,
+			if (cl_node && cl_copy_data_from_sram(sram_base,
 						descriptor_table.regions[i].bits.offset,
 						descriptor_table.regions[i].bits.size,
 						cl_node->data,
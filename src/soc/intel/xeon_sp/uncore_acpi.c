@@ -5,7 +5,6 @@
 #include <arch/ioapic.h>
 #include <assert.h>
 #include <cpu/x86/lapic.h>
-#include <commonlib/sort.h>
 #include <device/mmio.h>
 #include <device/pci.h>
 #include <device/pciexp.h>
@@ -22,40 +21,14 @@
 
 /* NUMA related ACPI table generation. SRAT, SLIT, etc */
 
-/* Increase if necessary. Currently all x86 CPUs only have 2 SMP threads */
-#define MAX_THREAD 2
-
 unsigned long acpi_create_srat_lapics(unsigned long current)
 {
-	struct device *cpu;
-	unsigned int num_cpus = 0;
-	int apic_ids[CONFIG_MAX_CPUS] = {};
-
-	unsigned int sort_start = 0;
-	for (unsigned int thread_id = 0; thread_id < MAX_THREAD; thread_id++) {
-		for (cpu = all_devices; cpu; cpu = cpu->next) {
-			if (!is_enabled_cpu(cpu))
-				continue;
-			if (num_cpus >= ARRAY_SIZE(apic_ids))
-				break;
-			if (cpu->path.apic.thread_id != thread_id)
-				continue;
-			apic_ids[num_cpus++] = cpu->path.apic.apic_id;
-		}
-		bubblesort(&apic_ids[sort_start], num_cpus - sort_start, NUM_ASCENDING);
-		sort_start = num_cpus;
-	}
+	const struct device *const *cpus;
+	const size_t num_cpus = acpi_get_madt_cpus(&cpus);
 
+	/* List the CPUs in the same order as the MADT. */
 	for (unsigned int i = 0; i < num_cpus; i++) {
-		/* Match the sorted apic_ids to a struct device */
-		for (cpu = all_devices; cpu; cpu = cpu->next) {
-			if (!is_enabled_cpu(cpu))
-				continue;
-			if (cpu->path.apic.apic_id == apic_ids[i])
-				break;
-		}
-		if (!cpu)
-			continue;
+		const struct device *cpu = cpus[i];
 
 		if (is_x2apic_mode()) {
 			printk(BIOS_DEBUG, "SRAT: x2apic cpu_index=%04x, node_id=%02x, apic_id=%08x\n",
@@ -17,6 +17,7 @@ void mtk_mmu_init(void)
 	mmu_inited = true;
 
 	mmu_init();
+	mmu_config_begin();
 
 	/*
 	 * Set 0x0 to 8GB address as device memory. We want to config IO_PHYS
@@ -35,6 +36,7 @@ void mtk_mmu_init(void)
 	mmu_config_range(_dma_coherent, REGION_SIZE(dma_coherent),
 			 SECURE_UNCACHED_MEM);
 
+	mmu_config_end();
 	mmu_enable();
 }
 
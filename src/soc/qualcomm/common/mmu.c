@@ -12,6 +12,8 @@ void qc_mmu_dram_config_post_dram_init(void *ddr_base, size_t ddr_size)
 	void *start = NULL;
 	void *end = NULL;
 
+	mmu_config_begin();
+
 	if (!soc_modem_carve_out(&start, &end)) {
 		mmu_config_range((void *)ddr_base, ddr_size, CACHED_RAM);
 	} else {
@@ -23,4 +25,6 @@ void qc_mmu_dram_config_post_dram_init(void *ddr_base, size_t ddr_size)
 							CACHED_RAM);
 	mmu_config_range((void *)_aop_data_ram, REGION_SIZE(aop_data_ram),
 							CACHED_RAM);
+
+	mmu_config_end();
 }
@@ -178,7 +178,9 @@ int edp_read_edid(struct edid *out)
 		return err;
 	}
 
-	if (edid[EDID_EXTENSION_FLAG]) {
+	/* An unchanged panel is decoded from the cache, its extensions aren't needed. */
+	if (edid[EDID_EXTENSION_FLAG] &&
+	    !(CONFIG(EDID_CACHE) && edid_cache_matches(edid))) {
 		printk(BIOS_ERR, " read EDID ext block.\n");
 		edid_size += EDID_LENGTH;
 		reg_addr = EDID_LENGTH;
@@ -49,6 +49,11 @@ void ite_reg_write(pnp_devfn_t dev, u8 reg, u8 value)
 	pnp_exit_conf_state(dev);
 }
 
+void ite_reg_write_batch(const struct pnp_config_write *writes, size_t count)
+{
+	pnp_write_config_batch(writes, count, pnp_enter_conf_state, pnp_exit_conf_state);
+}
+
 /*
  * in romstage.c
  * #define CLKIN_DEV PNP_DEV(0x2e, ITE_GPIO)
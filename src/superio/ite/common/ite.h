@@ -5,6 +5,7 @@
 
 #include <device/pnp_type.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define ITE_UART_CLK_PREDIVIDE_48 0x00 /* default */
@@ -15,6 +16,8 @@ void ite_enable_serial(pnp_devfn_t dev, u16 iobase);
 
 /* Some boards need to init wdt+gpio's very early */
 void ite_reg_write(pnp_devfn_t dev, u8 reg, u8 value);
+/* Like ite_reg_write() for a whole list, in one config mode session */
+void ite_reg_write_batch(const struct pnp_config_write *writes, size_t count);
 void ite_set_3vsbsw(pnp_devfn_t dev, bool enable);
 void ite_delay_pwrgd3(pnp_devfn_t dev);
 void ite_kill_watchdog(pnp_devfn_t dev);
@@ -323,6 +323,40 @@ error:
 	return ret;
 }
 
+const struct sar_aml_header *get_wifi_sar_aml(void)
+{
+	const struct sar_aml_header *header;
+	const char *filename;
+	char aml_filename[CBFS_METADATA_MAX_SIZE];
+	size_t len, size;
+
+	filename = get_wifi_sar_cbfs_filename();
+	if (filename == NULL)
+		return NULL;
+
+	len = strlen(filename);
+	if (len > 4 && !strcmp(filename + len - 4, ".hex"))
+		len -= 4;
+	if (snprintf(aml_filename, sizeof(aml_filename), "%.*s.aml", (int)len, filename)
+	    >= sizeof(aml_filename))
+		return NULL;
+
+	header = cbfs_map(aml_filename, &size);
+	if (!header)
+		return NULL;
+
+	if (size < sizeof(*header)
+	    || memcmp(header->marker, SAR_AML_MARKER, SAR_STR_PREFIX_SIZE)
+	    || header->version != SAR_AML_VERSION
+	    || size != sizeof(*header) + header->aml_size) {
+		printk(BIOS_ERR, "Invalid pre-encoded SAR file %s!\n", aml_filename);
+		cbfs_unmap((void *)header);
+		return NULL;
+	}
+
+	return header;
+}
+
 __weak
 const char *get_wifi_sar_cbfs_filename(void)
 {
@@ -28,8 +28,9 @@ stages := decompressor bootblock romstage smm verstage
 stages += ramstage rmodule postcar libagesa
 
 alltests :=
-subdirs := tests/arch tests/acpi tests/commonlib tests/console tests/cpu
-subdirs += tests/device tests/drivers tests/ec tests/lib
+allbenchmarks :=
+subdirs := tests/arch tests/acpi tests/benchmarks tests/commonlib tests/console
+subdirs += tests/cpu tests/device tests/drivers tests/ec tests/lib
 subdirs += tests/mainboard tests/northbridge tests/security tests/soc
 subdirs += tests/southbridge tests/superio tests/vendorcode
 
@@ -47,22 +48,37 @@ $(if $(findstring $($(1)$(2)-stage), $(stages)),,
 		Check your $(dir $(1)$(2))Makefile.mk))
 endef
 
+# Benchmarks take the same attributes as tests, see tests/benchmarks/Makefile.mk
+define benchmarks-handler
+allbenchmarks += $(1)$(2)
+$(foreach attribute,$(attributes),
+	$(eval $(1)$(2)-$(attribute) += $($(2)-$(attribute))))
+$(foreach attribute,$(attributes),
+	$(eval $(2)-$(attribute) := ))
+
+$(eval $(1)$(2)-stage := $(if $($(1)$(2)-stage),$($(1)$(2)-stage),ramstage))
+$(if $(findstring $($(1)$(2)-stage), $(stages)),,
+	$(error Wrong $(1)$(2)-stage value $($(1)$(2)-stage). \
+		Check your $(dir $(1)$(2))Makefile.mk))
+endef
+
 $(call add-special-class, tests)
+$(call add-special-class, benchmarks)
 $(call evaluate_subdirs)
 
-$(foreach test, $(alltests), \
+$(foreach test, $(alltests) $(allbenchmarks), \
 	$(eval $(test)-srcobjs := $(addprefix $(testobj)/$(test)/, \
 		$(patsubst %.c,%.o,$(filter src/%,$($(test)-srcs))))) \
 	$(eval $(test)-sysobjs := $(addprefix $(testobj)/$(test)/, \
 		$(patsubst %.c,%.o,$($(test)-syssrcs)))) \
 	$(eval $(test)-objs := $(addprefix $(testobj)/$(test)/, \
 		$(patsubst %.c,%.o,$($(test)-srcs)))))
-$(foreach test, $(alltests), \
+$(foreach test, $(alltests) $(allbenchmarks), \
 	$(eval $(test)-bin := $(testobj)/$(test)/run))
-$(foreach test, $(alltests), \
+$(foreach test, $(alltests) $(allbenchmarks), \
 	$(eval $(call TEST_CC_template,$(test))))
 
-$(foreach test, $(alltests), \
+$(foreach test, $(alltests) $(allbenchmarks), \
 	$(eval all-test-objs += $($(test)-objs)))
 $(foreach test, $(alltests), \
 	$(eval test-bins += $($(test)-bin)))
@@ -176,6 +192,38 @@ $(addprefix clean-,$(alltests)): clean-%:
 clean-unit-tests:
 	rm -rf $(testobj)
 
+BENCHMARKS_JSON_FILE := $(testobj)/benchmarks.json
+
+.PHONY: $(allbenchmarks) $(addprefix run-,$(allbenchmarks))
+.PHONY: benchmarks build-benchmarks list-benchmarks
+
+# A single benchmark writes its results next to its binary.
+$(addprefix run-,$(allbenchmarks)): run-%: $$(%-bin)
+	rm -f $(testobj)/$*/results.json
+	BENCH_OUTPUT=$(testobj)/$*/results.json $^
+	cat $(testobj)/$*/results.json
+
+$(allbenchmarks): run-$$(@)
+
+build-benchmarks: $(foreach bench,$(allbenchmarks),$($(bench)-bin))
+
+# Run one benchmark after the other even with -j, so they don't disturb each
+# other's timing, and collect all results in one JSON array.
+benchmarks: build-benchmarks
+	rm -f $(BENCHMARKS_JSON_FILE).tmp
+	for bench in $(allbenchmarks); do \
+		BENCH_OUTPUT=$(BENCHMARKS_JSON_FILE).tmp $(testobj)/$$bench/run || exit 1; \
+	done
+	(echo '['; sed '$$!s/$$/,/' $(BENCHMARKS_JSON_FILE).tmp; echo ']') > $(BENCHMARKS_JSON_FILE)
+	rm -f $(BENCHMARKS_JSON_FILE).tmp
+	echo "Benchmark results written to $(BENCHMARKS_JSON_FILE)"
+
+list-benchmarks:
+	@echo "benchmarks:"
+	for b in $(sort $(allbenchmarks)); do \
+		echo "  $$b"; \
+	done
+
 list-unit-tests:
 	@echo "unit-tests:"
 	for t in $(sort $(alltests)); do \
@@ -193,4 +241,8 @@ help-unit-tests help::
 	@echo  '  clean-<unit-test>     - Remove single unit-test build artifacts'
 	@echo  '  coverage-report       - Generate a code coverage report'
 	@echo  '  clean-coverage-report - Remove the code coverage report'
+	@echo  '  benchmarks            - Run all benchmarks from tests/benchmarks/ and'
+	@echo  '                          write the results to benchmarks.json'
+	@echo  '  list-benchmarks       - List all benchmarks'
+	@echo  '  <benchmark>           - Build and run single benchmark'
 	@echo
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <acpi/acpi.h>
+#include <arch/ioapic.h>
+#include <device/device.h>
+#include <stdlib.h>
+#include <tests/test.h>
+#include <types.h>
+
+/* Two threads per core, with most APIC IDs out of reach of xAPIC entries. */
+#define TEST_CPUS	CONFIG_MAX_CPUS
+
+static struct device cluster = {
+	.path = { .type = DEVICE_PATH_CPU_CLUSTER },
+	.enabled = 1,
+};
+static struct bus cluster_bus = { .dev = &cluster };
+static struct device cpus[TEST_CPUS];
+struct device *all_devices;
+
+bool is_enabled_cpu(const struct device *cpu)
+{
+	return cpu->path.type == DEVICE_PATH_APIC &&
+	       cpu->upstream->dev->path.type == DEVICE_PATH_CPU_CLUSTER && cpu->enabled;
+}
+
+uintptr_t cpu_get_lapic_addr(void)
+{
+	return 0xfee00000;
+}
+
+u8 get_ioapic_id(uintptr_t ioapic_base)
+{
+	return 0;
+}
+
+unsigned int ioapic_get_max_vectors(uintptr_t ioapic_base)
+{
+	return 24;
+}
+
+void ioapic_get_sci_pin(u8 *gsi, u8 *irq, u8 *flags)
+{
+	*gsi = *irq = 9;
+	*flags = 0;
+}
+
+/* The device list is sorted by APIC ID, so the two threads of each core alternate. */
+static int setup_cpus(void **state)
+{
+	for (size_t i = 0; i < TEST_CPUS; i++) {
+		cpus[i].path.type = DEVICE_PATH_APIC;
+		cpus[i].path.apic.apic_id = i;
+		cpus[i].path.apic.thread_id = i & 1;
+		cpus[i].upstream = &cluster_bus;
+		cpus[i].enabled = 1;
+		cpus[i].next = i + 1 < TEST_CPUS ? &cpus[i + 1] : NULL;
+	}
+	all_devices = &cpus[0];
+	return 0;
+}
+
+static void test_madt_cpu_order(void **state)
+{
+	const struct device *const *list;
+	const size_t num = acpi_get_madt_cpus(&list);
+
+	assert_int_equal(TEST_CPUS, num);
+	for (size_t i = 0; i < num; i++) {
+		/* All first threads come before all second threads. */
+		assert_int_equal(i >= num / 2, list[i]->path.apic.thread_id);
+		if (i % (num / 2))
+			assert_true(list[i - 1]->path.apic.apic_id <
+				    list[i]->path.apic.apic_id);
+	}
+}
+
+static void test_madt_lapic_entries(void **state)
+{
+	const unsigned long size = TEST_CPUS * sizeof(acpi_madt_lx2apic_t) + 4 * KiB;
+	u8 *buf = calloc(1, size);
+	acpi_madt_t madt = {};
+	unsigned long current = (uintptr_t)buf;
+	size_t lapics = 0, x2apics = 0;
+	u32 last_uid = 0;
+
+	assert_non_null(buf);
+	current = acpi_arch_fill_madt(&madt, current);
+	assert_true(current - (uintptr_t)buf < size);
+
+	for (u8 *p = buf; p < (u8 *)current; p += p[1]) {
+		assert_true(p[1] > 0);
+		if (p[0] == LOCAL_APIC) {
+			const acpi_madt_lapic_t *l = (void *)p;
+
+			assert_int_equal(sizeof(*l), l->length);
+			assert_true(l->apic_id <= ACPI_MADT_MAX_LAPIC_ID);
+			assert_int_equal(lapics, l->processor_id);
+			lapics++;
+		} else if (p[0] == LOCAL_X2APIC) {
+			const acpi_madt_lx2apic_t *x = (void *)p;
+
+			assert_int_equal(sizeof(*x), x->length);
+			/* Processor UIDs above 255 need x2APIC entries, whatever the APIC ID. */
+			assert_true(x->x2apic_id > ACPI_MADT_MAX_LAPIC_ID ||
+				    x->processor_id > UINT8_MAX);
+			assert_int_equal(lapics + x2apics, x->processor_id);
+			last_uid = x->processor_id;
+			x2apics++;
+		}
+	}
+
+	assert_int_equal(TEST_CPUS, lapics + x2apics);
+	/* Only the first threads with APIC IDs up to 254 come early enough for xAPIC. */
+	assert_int_equal(128, lapics);
+	assert_int_equal(TEST_CPUS - 1, last_uid);
+
+	free(buf);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_madt_cpu_order),
+		cmocka_unit_test(test_madt_lapic_entries),
+	};
+
+	return cb_run_group_tests(tests, setup_cpus, NULL);
+}
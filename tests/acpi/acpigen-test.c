@@ -133,6 +133,70 @@ static void test_acpigen_write_package(void **state)
 	assert_int_equal(package_length, block_length);
 }
 
+static void test_acpigen_write_len(void **state)
+{
+	char *acpigen_buf = *state;
+	char *expected = acpigen_buf + ACPIGEN_TEST_BUFFER_SZ / 2;
+	const size_t lengths[] = { 0, 1, 0x3e, 0x3f, 0x40, 0xffd, 0xffe, 0x1000 };
+
+	for (size_t i = 0; i < ARRAY_SIZE(lengths); i++) {
+		const size_t len = lengths[i];
+		size_t expected_size;
+
+		/* Reference encoding through the PkgLength fixup */
+		acpigen_set_current(expected);
+		acpigen_emit_byte(BUFFER_OP);
+		acpigen_write_len_f();
+		for (size_t j = 0; j < len; j++)
+			acpigen_emit_byte(j);
+		acpigen_pop_len();
+		expected_size = acpigen_get_current() - expected;
+
+		acpigen_set_current(acpigen_buf);
+		acpigen_emit_byte(BUFFER_OP);
+		acpigen_write_len(len);
+		for (size_t j = 0; j < len; j++)
+			acpigen_emit_byte(j);
+
+		assert_int_equal(acpigen_get_current() - acpigen_buf, expected_size);
+		assert_memory_equal(acpigen_buf, expected, expected_size);
+		assert_int_equal(decode_package_length(acpigen_buf),
+				 get_current_block_length(acpigen_buf));
+	}
+}
+
+static void test_acpigen_template(void **state)
+{
+	char *acpigen_buf = *state;
+	struct acpigen_template tmpl = {};
+	char *first, *second;
+	size_t len;
+
+	acpigen_set_current(acpigen_buf);
+
+	/* The scope gets a 1 byte PkgLength, which moves its contents down by 2 bytes. */
+	acpigen_write_scope("CPU0");
+	first = acpigen_get_current();
+	assert_false(acpigen_template_replay(&tmpl));
+	acpigen_template_begin(&tmpl);
+	acpigen_write_name_integer("_UID", 0x1234);
+	acpigen_write_name_string("_HID", "ACPI0007");
+	acpigen_template_end(&tmpl);
+	len = acpigen_get_current() - first;
+	acpigen_pop_len();
+	first -= 2;
+
+	acpigen_write_scope("CPU1");
+	second = acpigen_get_current();
+	assert_true(acpigen_template_replay(&tmpl));
+	assert_int_equal(acpigen_get_current() - second, len);
+	acpigen_pop_len();
+	second -= 2;
+
+	assert_memory_equal(first, second, len);
+	free(tmpl.data);
+}
+
 static void test_acpigen_scope_with_contents(void **state)
 {
 	char *acpigen_buf = *state;
@@ -213,6 +277,10 @@ int main(void)
 						teardown_acpigen),
 		cmocka_unit_test_setup_teardown(test_acpigen_write_package, setup_acpigen,
 						teardown_acpigen),
+		cmocka_unit_test_setup_teardown(test_acpigen_write_len, setup_acpigen,
+						teardown_acpigen),
+		cmocka_unit_test_setup_teardown(test_acpigen_template, setup_acpigen,
+						teardown_acpigen),
 		cmocka_unit_test_setup_teardown(test_acpigen_scope_with_contents, setup_acpigen,
 						teardown_acpigen),
 	};
@@ -0,0 +1,56 @@
+# SPDX-License-Identifier: GPL-2.0-only
+
+# Benchmarks are built like unit tests, but only run by `make benchmarks`.
+
+benchmarks-y += memory-benchmark
+benchmarks-y += decompression-benchmark
+benchmarks-y += cbfs-benchmark
+benchmarks-y += cbfs-mcache-index-benchmark
+benchmarks-y += imd-benchmark
+benchmarks-y += imd-sorted-index-benchmark
+benchmarks-y += memrange-benchmark
+benchmarks-y += vtxprintf-benchmark
+
+memory-benchmark-srcs += tests/benchmarks/memory-benchmark.c
+memory-benchmark-syssrcs += tests/helpers/bench.c
+# Keep GCC from turning the byte loops into calls to the libc functions.
+memory-benchmark-cflags += -fno-tree-loop-distribute-patterns
+
+decompression-benchmark-srcs += tests/benchmarks/decompression-benchmark.c
+decompression-benchmark-srcs += tests/stubs/console.c
+decompression-benchmark-srcs += src/lib/lzma.c
+decompression-benchmark-srcs += src/lib/lzmadecode.c
+decompression-benchmark-srcs += src/commonlib/bsd/lz4_wrapper.c
+decompression-benchmark-syssrcs += tests/helpers/bench.c
+decompression-benchmark-syssrcs += tests/helpers/file.c
+
+cbfs-benchmark-srcs += tests/benchmarks/cbfs-benchmark.c
+cbfs-benchmark-srcs += tests/stubs/console.c
+cbfs-benchmark-srcs += src/commonlib/bsd/cbfs_private.c
+cbfs-benchmark-srcs += src/commonlib/bsd/cbfs_mcache.c
+cbfs-benchmark-srcs += src/commonlib/region.c
+cbfs-benchmark-syssrcs += tests/helpers/bench.c
+cbfs-benchmark-config += CONFIG_CBFS_VERIFICATION=0 \
+			CONFIG_CBFS_MCACHE_HASH_INDEX=0
+
+$(call copy-test,cbfs-benchmark,cbfs-mcache-index-benchmark)
+cbfs-mcache-index-benchmark-config += CONFIG_CBFS_MCACHE_HASH_INDEX=1
+
+imd-benchmark-srcs += tests/benchmarks/imd-benchmark.c
+imd-benchmark-srcs += tests/stubs/console.c
+imd-benchmark-srcs += src/lib/imd.c
+imd-benchmark-syssrcs += tests/helpers/bench.c
+
+$(call copy-test,imd-benchmark,imd-sorted-index-benchmark)
+imd-sorted-index-benchmark-config += CONFIG_IMD_SORTED_INDEX=1
+
+memrange-benchmark-srcs += tests/benchmarks/memrange-benchmark.c
+memrange-benchmark-srcs += tests/stubs/console.c
+memrange-benchmark-srcs += src/lib/memrange.c
+memrange-benchmark-srcs += src/device/device_util.c
+memrange-benchmark-syssrcs += tests/helpers/bench.c
+
+vtxprintf-benchmark-srcs += tests/benchmarks/vtxprintf-benchmark.c
+vtxprintf-benchmark-srcs += src/console/vtxprintf.c
+vtxprintf-benchmark-srcs += src/commonlib/bsd/string.c
+vtxprintf-benchmark-syssrcs += tests/helpers/bench.c
@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/cbfs_private.h>
+#include <commonlib/helpers.h>
+#include <commonlib/region.h>
+#include <endian.h>
+#include <helpers/bench.h>
+#include <stdio.h>
+#include <string.h>
+#include <tests/test.h>
+
+/* About the number of files in a CBFS of a ChromeOS build. */
+#define CBFS_FILES		128
+#define CBFS_FILE_DATA_SIZE	256
+#define CBFS_NAME_SIZE		32
+#define CBFS_ENTRY_SIZE		ALIGN_UP(sizeof(struct cbfs_file) + CBFS_NAME_SIZE + \
+					 CBFS_FILE_DATA_SIZE, CBFS_ALIGNMENT)
+#define MCACHE_SIZE		(64 * KiB)
+
+static uint8_t cbfs_buffer[CBFS_FILES * CBFS_ENTRY_SIZE] __aligned(CBFS_ALIGNMENT);
+static uint8_t mcache[MCACHE_SIZE] __aligned(CBFS_MCACHE_ALIGNMENT);
+static struct mem_region_device cbfs_mdev;
+
+struct cbfs_bench_case {
+	const char *name;
+};
+
+static void file_name(char *buf, size_t size, int i)
+{
+	snprintf(buf, size, "fallback/file-%03d", i);
+}
+
+static int setup_cbfs(void **state)
+{
+	struct cbfs_file *f;
+	int i;
+
+	memset(cbfs_buffer, 0xff, sizeof(cbfs_buffer));
+	for (i = 0; i < CBFS_FILES; i++) {
+		f = (struct cbfs_file *)(cbfs_buffer + i * CBFS_ENTRY_SIZE);
+		memset(f, 0, sizeof(*f) + CBFS_NAME_SIZE);
+		memcpy(f->magic, CBFS_FILE_MAGIC, sizeof(f->magic));
+		f->len = cpu_to_be32(CBFS_FILE_DATA_SIZE);
+		f->type = cpu_to_be32(CBFS_TYPE_RAW);
+		f->offset = cpu_to_be32(sizeof(*f) + CBFS_NAME_SIZE);
+		file_name(f->filename, CBFS_NAME_SIZE, i);
+		memset((uint8_t *)f + sizeof(*f) + CBFS_NAME_SIZE, i, CBFS_FILE_DATA_SIZE);
+	}
+
+	mem_region_device_ro_init(&cbfs_mdev, cbfs_buffer, sizeof(cbfs_buffer));
+	return 0;
+}
+
+static void bench_cbfs_lookup(void *arg)
+{
+	const struct cbfs_bench_case *c = arg;
+	union cbfs_mdata mdata;
+	size_t data_offset;
+
+	cbfs_lookup(&cbfs_mdev.rdev, c->name, &mdata, &data_offset, NULL);
+}
+
+static void bench_cbfs_mcache_build(void *arg)
+{
+	cbfs_mcache_build(&cbfs_mdev.rdev, mcache, sizeof(mcache), NULL);
+}
+
+static void bench_cbfs_mcache_lookup(void *arg)
+{
+	const struct cbfs_bench_case *c = arg;
+	union cbfs_mdata mdata;
+	size_t data_offset;
+
+	cbfs_mcache_lookup(mcache, sizeof(mcache), c->name, &mdata, &data_offset);
+}
+
+static void benchmark_cbfs_lookup(void **state)
+{
+	char first[CBFS_NAME_SIZE], last[CBFS_NAME_SIZE];
+	struct cbfs_bench_case c;
+	union cbfs_mdata mdata;
+	size_t data_offset;
+
+	file_name(first, sizeof(first), 0);
+	file_name(last, sizeof(last), CBFS_FILES - 1);
+	assert_int_equal(CB_SUCCESS, cbfs_lookup(&cbfs_mdev.rdev, last, &mdata, &data_offset,
+						 NULL));
+	assert_int_equal((CBFS_FILES - 1) * CBFS_ENTRY_SIZE + sizeof(struct cbfs_file) +
+			 CBFS_NAME_SIZE, data_offset);
+
+	c.name = first;
+	test_bench_run("cbfs_lookup(first)", bench_cbfs_lookup, &c, 0);
+	c.name = last;
+	test_bench_run("cbfs_lookup(last)", bench_cbfs_lookup, &c, 0);
+	c.name = "fallback/missing";
+	test_bench_run("cbfs_lookup(missing)", bench_cbfs_lookup, &c, 0);
+}
+
+static void benchmark_cbfs_mcache(void **state)
+{
+	char first[CBFS_NAME_SIZE], last[CBFS_NAME_SIZE];
+	struct cbfs_bench_case c;
+	union cbfs_mdata mdata;
+	size_t data_offset;
+
+	test_bench_run("cbfs_mcache_build", bench_cbfs_mcache_build, NULL, sizeof(cbfs_buffer));
+
+	assert_int_equal(CB_SUCCESS, cbfs_mcache_build(&cbfs_mdev.rdev, mcache, sizeof(mcache),
+						       NULL));
+	file_name(first, sizeof(first), 0);
+	file_name(last, sizeof(last), CBFS_FILES - 1);
+	assert_int_equal(CB_SUCCESS, cbfs_mcache_lookup(mcache, sizeof(mcache), last, &mdata,
+							&data_offset));
+	assert_int_equal((CBFS_FILES - 1) * CBFS_ENTRY_SIZE + sizeof(struct cbfs_file) +
+			 CBFS_NAME_SIZE, data_offset);
+
+	c.name = first;
+	test_bench_run("cbfs_mcache_lookup(first)", bench_cbfs_mcache_lookup, &c, 0);
+	c.name = last;
+	test_bench_run("cbfs_mcache_lookup(last)", bench_cbfs_mcache_lookup, &c, 0);
+	c.name = "fallback/missing";
+	test_bench_run("cbfs_mcache_lookup(missing)", bench_cbfs_mcache_lookup, &c, 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(benchmark_cbfs_lookup),
+		cmocka_unit_test(benchmark_cbfs_mcache),
+	};
+
+	return cb_run_group_tests(tests, setup_cbfs, NULL);
+}
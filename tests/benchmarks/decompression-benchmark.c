@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/compression.h>
+#include <helpers/bench.h>
+#include <helpers/file.h>
+#include <lib.h>
+#include <stdio.h>
+#include <string.h>
+#include <tests/test.h>
+
+struct decompression_bench_state {
+	const char *name;
+	uint8_t *raw;
+	size_t raw_size;
+	uint8_t *lzma;
+	size_t lzma_size;
+	uint8_t *lz4;
+	size_t lz4_size;
+	uint8_t *out;
+};
+
+static uint8_t *read_data_file(const char *path, size_t *size)
+{
+	const int file_size = test_get_file_size(path);
+	uint8_t *buf;
+
+	if (file_size <= 0)
+		return NULL;
+	buf = test_malloc(file_size);
+	if (test_read_file(path, buf, file_size) != file_size) {
+		test_free(buf);
+		return NULL;
+	}
+
+	*size = file_size;
+	return buf;
+}
+
+/* The same files as the LZMA and LZ4 tests use. */
+static int setup_data_file(void **state)
+{
+	struct decompression_bench_state *s = test_malloc(sizeof(*s));
+	char path[64];
+
+	memset(s, 0, sizeof(*s));
+	s->name = *state;
+	*state = s;
+
+	snprintf(path, sizeof(path), "lib/lzma-test/%s.bin", s->name);
+	s->raw = read_data_file(path, &s->raw_size);
+	snprintf(path, sizeof(path), "lib/lzma-test/%s.lzma.bin", s->name);
+	s->lzma = read_data_file(path, &s->lzma_size);
+	snprintf(path, sizeof(path), "commonlib/bsd/lz4-test/%s.lz4.bin", s->name);
+	s->lz4 = read_data_file(path, &s->lz4_size);
+	if (!s->raw || !s->lzma || !s->lz4)
+		return 1;
+
+	s->out = test_malloc(s->raw_size);
+	return 0;
+}
+
+static int teardown_data_file(void **state)
+{
+	struct decompression_bench_state *s = *state;
+
+	test_free(s->raw);
+	test_free(s->lzma);
+	test_free(s->lz4);
+	test_free(s->out);
+	test_free(s);
+
+	return 0;
+}
+
+static void bench_ulzman(void *arg)
+{
+	struct decompression_bench_state *s = arg;
+
+	ulzman(s->lzma, s->lzma_size, s->out, s->raw_size);
+}
+
+static void bench_ulz4fn(void *arg)
+{
+	struct decompression_bench_state *s = arg;
+
+	ulz4fn(s->lz4, s->lz4_size, s->out, s->raw_size);
+}
+
+static void benchmark_ulzman(void **state)
+{
+	struct decompression_bench_state *s = *state;
+	char name[32];
+
+	assert_int_equal(s->raw_size, ulzman(s->lzma, s->lzma_size, s->out, s->raw_size));
+	assert_memory_equal(s->raw, s->out, s->raw_size);
+
+	snprintf(name, sizeof(name), "ulzman(%s)", s->name);
+	test_bench_run(name, bench_ulzman, s, s->raw_size);
+}
+
+static void benchmark_ulz4fn(void **state)
+{
+	struct decompression_bench_state *s = *state;
+	char name[32];
+
+	assert_int_equal(s->raw_size, ulz4fn(s->lz4, s->lz4_size, s->out, s->raw_size));
+	assert_memory_equal(s->raw, s->out, s->raw_size);
+
+	snprintf(name, sizeof(name), "ulz4fn(%s)", s->name);
+	test_bench_run(name, bench_ulz4fn, s, s->raw_size);
+}
+
+#define DECOMPRESSION_BENCH(_func, _file)                                                      \
+	{                                                                                      \
+		.name = #_func "(" _file ")", .test_func = _func,                              \
+		.setup_func = setup_data_file, .teardown_func = teardown_data_file,            \
+		.initial_state = (_file)                                                       \
+	}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		/* util/cbfs-compression-tool, an executable. */
+		DECOMPRESSION_BENCH(benchmark_ulzman, "data.1"),
+		DECOMPRESSION_BENCH(benchmark_ulz4fn, "data.1"),
+		/* tests/lib/imd-test.c, structured text. */
+		DECOMPRESSION_BENCH(benchmark_ulzman, "data.3"),
+		DECOMPRESSION_BENCH(benchmark_ulz4fn, "data.3"),
+		/* libcmocka.so.0.7.0, a shared object. */
+		DECOMPRESSION_BENCH(benchmark_ulzman, "data.4"),
+		DECOMPRESSION_BENCH(benchmark_ulz4fn, "data.4"),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <helpers/bench.h>
+#include <imd.h>
+#include <imd_private.h>
+#include <stdlib.h>
+#include <tests/test.h>
+
+/* About the number of CBMEM entries late in ramstage. */
+#define IMD_ENTRIES		48
+#define IMD_ROOT_SIZE		(4 * KiB)
+#define IMD_ENTRY_ALIGN		16
+#define IMD_ENTRY_SIZE		64
+#define IMD_ID(i)		(0x494d4400 + (i) * 0x11)
+#define IMD_SIZE		(64 * KiB)
+
+static struct imd imd;
+static void *imd_base;
+
+struct imd_bench_case {
+	uint32_t id;
+};
+
+static int setup_imd(void **state)
+{
+	int i;
+
+	imd_base = malloc(IMD_SIZE + LIMIT_ALIGN);
+	if (!imd_base)
+		return 1;
+
+	imd_handle_init(&imd, (uint8_t *)imd_base + IMD_SIZE + LIMIT_ALIGN);
+	if (imd_create_empty(&imd, IMD_ROOT_SIZE, IMD_ENTRY_ALIGN))
+		return 2;
+
+	/* Not in ID order, like CBMEM. */
+	for (i = 0; i < IMD_ENTRIES; i++)
+		if (!imd_entry_add(&imd, IMD_ID((i * 7) % IMD_ENTRIES), IMD_ENTRY_SIZE))
+			return 3;
+
+	return 0;
+}
+
+static int teardown_imd(void **state)
+{
+	free(imd_base);
+	return 0;
+}
+
+static void bench_imd_entry_find(void *arg)
+{
+	const struct imd_bench_case *c = arg;
+
+	imd_entry_find(&imd, c->id);
+}
+
+static void benchmark_imd_entry_find(void **state)
+{
+	struct imd_bench_case c;
+	int i;
+
+	for (i = 0; i < IMD_ENTRIES; i++)
+		assert_non_null(imd_entry_find(&imd, IMD_ID(i)));
+	assert_null(imd_entry_find(&imd, IMD_ID(IMD_ENTRIES)));
+
+	/* The first and the last entry that was added. */
+	c.id = IMD_ID(0);
+	test_bench_run("imd_entry_find(first)", bench_imd_entry_find, &c, 0);
+	c.id = IMD_ID(((IMD_ENTRIES - 1) * 7) % IMD_ENTRIES);
+	test_bench_run("imd_entry_find(last)", bench_imd_entry_find, &c, 0);
+	c.id = IMD_ID(IMD_ENTRIES);
+	test_bench_run("imd_entry_find(missing)", bench_imd_entry_find, &c, 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(benchmark_imd_entry_find),
+	};
+
+	return cb_run_group_tests(tests, setup_imd, teardown_imd);
+}
@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/* Include the generic implementations under other names, to compare them with libc. */
+#define memcpy cb_memcpy
+#include "../lib/memcpy.c"
+#undef memcpy
+#define memmove cb_memmove
+#include "../lib/memmove.c"
+#undef memmove
+#define memset cb_memset
+#include "../lib/memset.c"
+#undef memset
+
+#include <commonlib/helpers.h>
+#include <helpers/bench.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tests/test.h>
+
+/* Prototypes from string.h were renamed above. */
+void *memcpy(void *dest, const void *src, size_t n);
+void *memset(void *s, int c, size_t n);
+
+#define BUFFER_SZ	(1 * MiB)
+
+struct memory_bench_state {
+	uint8_t *dst;
+	uint8_t *src;
+	size_t size;
+};
+
+static uint8_t *buffer_a;
+static uint8_t *buffer_b;
+
+static void bench_cb_memcpy(void *arg)
+{
+	struct memory_bench_state *s = arg;
+
+	cb_memcpy(s->dst, s->src, s->size);
+}
+
+static void bench_libc_memcpy(void *arg)
+{
+	struct memory_bench_state *s = arg;
+
+	memcpy(s->dst, s->src, s->size);
+}
+
+static void bench_cb_memmove(void *arg)
+{
+	struct memory_bench_state *s = arg;
+
+	/* Overlapping, towards higher addresses, so it has to copy backwards. */
+	cb_memmove(s->dst + 1, s->dst, s->size - 1);
+}
+
+static void bench_cb_memset(void *arg)
+{
+	struct memory_bench_state *s = arg;
+
+	cb_memset(s->dst, 0xa5, s->size);
+}
+
+static void bench_libc_memset(void *arg)
+{
+	struct memory_bench_state *s = arg;
+
+	memset(s->dst, 0xa5, s->size);
+}
+
+static void run_sizes(const char *name, void (*fn)(void *arg))
+{
+	static const size_t sizes[] = { 64, 4 * KiB, 256 * KiB, BUFFER_SZ };
+	struct memory_bench_state s = { .dst = buffer_b, .src = buffer_a };
+	char case_name[64];
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		s.size = sizes[i];
+		snprintf(case_name, sizeof(case_name), "%s(%zu)", name, sizes[i]);
+		test_bench_run(case_name, fn, &s, sizes[i]);
+	}
+}
+
+static int setup_buffers(void **state)
+{
+	size_t i;
+
+	buffer_a = malloc(BUFFER_SZ);
+	buffer_b = malloc(BUFFER_SZ);
+	if (!buffer_a || !buffer_b)
+		return 1;
+
+	for (i = 0; i < BUFFER_SZ; i++)
+		buffer_a[i] = i * 7 + (i >> 8);
+
+	return 0;
+}
+
+static int teardown_buffers(void **state)
+{
+	free(buffer_a);
+	free(buffer_b);
+
+	return 0;
+}
+
+static void benchmark_memcpy(void **state)
+{
+	cb_memcpy(buffer_b, buffer_a, BUFFER_SZ);
+	assert_memory_equal(buffer_a, buffer_b, BUFFER_SZ);
+
+	run_sizes("cb_memcpy", bench_cb_memcpy);
+	run_sizes("libc_memcpy", bench_libc_memcpy);
+}
+
+static void benchmark_memmove(void **state)
+{
+	run_sizes("cb_memmove", bench_cb_memmove);
+}
+
+static void benchmark_memset(void **state)
+{
+	run_sizes("cb_memset", bench_cb_memset);
+	run_sizes("libc_memset", bench_libc_memset);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(benchmark_memcpy),
+		cmocka_unit_test(benchmark_memmove),
+		cmocka_unit_test(benchmark_memset),
+	};
+
+	return cb_run_group_tests(tests, setup_buffers, teardown_buffers);
+}
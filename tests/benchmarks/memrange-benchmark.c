@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <helpers/bench.h>
+#include <memrange.h>
+#include <tests/test.h>
+
+/* Enough for a memory map with many reserved regions, as seen on large servers. */
+#define RANGES		64
+#define FREE_ENTRIES	(2 * RANGES + 8)
+
+struct memrange_bench_state {
+	struct memranges ranges;
+	struct range_entry free[FREE_ENTRIES];
+};
+
+/* Separate ranges of different types with holes between them, inserted out of order. */
+static void fill_ranges(struct memrange_bench_state *s)
+{
+	int i, j;
+
+	memranges_init_empty(&s->ranges, s->free, ARRAY_SIZE(s->free));
+	for (i = 0; i < RANGES; i++) {
+		j = (i * 37) % RANGES;
+		memranges_insert(&s->ranges, (resource_t)j * 64 * MiB, 16 * MiB, 1 + j % 3);
+	}
+}
+
+static void bench_memranges_insert(void *arg)
+{
+	fill_ranges(arg);
+}
+
+static void bench_memranges_overlap(void *arg)
+{
+	struct memrange_bench_state *s = arg;
+
+	fill_ranges(s);
+	/* Replaces every other range and merges it with its neighbours. */
+	memranges_insert(&s->ranges, 0, (resource_t)RANGES * 32 * MiB, 1);
+}
+
+static void bench_memranges_fill_holes(void *arg)
+{
+	struct memrange_bench_state *s = arg;
+
+	fill_ranges(s);
+	memranges_fill_holes_up_to(&s->ranges, (resource_t)RANGES * 64 * MiB, 4);
+}
+
+static void benchmark_memranges(void **state)
+{
+	struct memrange_bench_state s;
+	const struct range_entry *r;
+	size_t count = 0;
+
+	fill_ranges(&s);
+	memranges_each_entry(r, &s.ranges)
+		count++;
+	assert_int_equal(RANGES, count);
+
+	test_bench_run("memranges_insert", bench_memranges_insert, &s, 0);
+	test_bench_run("memranges_insert(overlapping)", bench_memranges_overlap, &s, 0);
+	test_bench_run("memranges_fill_holes_up_to", bench_memranges_fill_holes, &s, 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(benchmark_memranges),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
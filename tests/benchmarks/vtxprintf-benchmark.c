@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/vtxprintf.h>
+#include <helpers/bench.h>
+#include <stdarg.h>
+#include <string.h>
+#include <tests/test.h>
+
+struct vtxprintf_bench_buffer {
+	char data[256];
+	size_t len;
+};
+
+static struct vtxprintf_bench_buffer out;
+
+static void tx_byte(unsigned char byte, void *data)
+{
+	struct vtxprintf_bench_buffer *buf = data;
+
+	if (buf->len < sizeof(buf->data) - 1)
+		buf->data[buf->len++] = byte;
+}
+
+static int bench_printf(const char *fmt, ...)
+{
+	va_list args;
+	int ret;
+
+	out.len = 0;
+	va_start(args, fmt);
+	ret = vtxprintf(tx_byte, fmt, args, &out);
+	va_end(args);
+	out.data[out.len] = '\0';
+
+	return ret;
+}
+
+/* Lines like the ones the console prints most often during boot. */
+static void bench_string(void *arg)
+{
+	bench_printf("%s: %s\n", "CBFS", "Found 'fallback/ramstage' @0x80 size 0x1a2b3");
+}
+
+static void bench_hex(void *arg)
+{
+	bench_printf("PCI: %02x:%02x.%01x [%04x/%04x] enabled\n", 0, 0x1f, 3, 0x8086, 0xa0c8);
+}
+
+static void bench_decimal(void *arg)
+{
+	bench_printf("Timestamp %d: %llu us, %zu bytes\n", 42, 1234567890ULL, (size_t)65536);
+}
+
+static void bench_resource(void *arg)
+{
+	bench_printf("%s %02lx <- [0x%016llx - 0x%016llx] size 0x%08llx gran 0x%02x %s\n",
+		     "PCI: 00:02.0", 0x10UL, 0xc0000000ULL, 0xcfffffffULL, 0x10000000ULL, 28,
+		     "prefmem");
+}
+
+static void benchmark_vtxprintf(void **state)
+{
+	bench_hex(NULL);
+	assert_string_equal("PCI: 00:1f.3 [8086/a0c8] enabled\n", out.data);
+	bench_decimal(NULL);
+	assert_string_equal("Timestamp 42: 1234567890 us, 65536 bytes\n", out.data);
+
+	test_bench_run("vtxprintf(string)", bench_string, NULL, 0);
+	test_bench_run("vtxprintf(hex)", bench_hex, NULL, 0);
+	test_bench_run("vtxprintf(decimal)", bench_decimal, NULL, 0);
+	test_bench_run("vtxprintf(resource)", bench_resource, NULL, 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(benchmark_vtxprintf),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
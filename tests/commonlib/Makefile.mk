@@ -3,6 +3,7 @@
 subdirs-y += bsd
 
 tests-y += list-test
+tests-y += mem_pool-test
 tests-y += rational-test
 tests-y += region-test
 tests-y += device_tree-test
@@ -10,13 +11,18 @@ tests-y += device_tree-test
 device_tree-test-srcs += tests/commonlib/device_tree-test.c
 device_tree-test-srcs += tests/stubs/console.c
 device_tree-test-srcs += src/commonlib/device_tree.c
+device_tree-test-srcs += src/commonlib/list.c
 device_tree-test-syssrcs += tests/helpers/file.c
 
 list-test-srcs += tests/commonlib/list-test.c
 list-test-srcs += src/commonlib/list.c
 
+mem_pool-test-srcs += tests/commonlib/mem_pool-test.c
+mem_pool-test-srcs += src/commonlib/mem_pool.c
+
 rational-test-srcs += tests/commonlib/rational-test.c
 rational-test-srcs += src/commonlib/rational.c
 
 region-test-srcs += tests/commonlib/region-test.c
 region-test-srcs += src/commonlib/region.c
+region-test-srcs += src/commonlib/mem_pool.c
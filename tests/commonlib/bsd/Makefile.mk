@@ -4,6 +4,10 @@ tests-y += helpers-test
 tests-y += gcd-test
 tests-y += ipchksum-test
 tests-y += string-test
+tests-y += lz4-test
+tests-y += lz4-careful-test
+tests-y += zstd-test
+tests-y += zstd-small-test
 
 helpers-test-srcs += tests/commonlib/bsd/helpers-test.c
 
@@ -15,3 +19,22 @@ ipchksum-test-srcs += src/commonlib/bsd/ipchksum.c
 
 string-test-srcs += tests/commonlib/bsd/string-test.c
 string-test-srcs += src/commonlib/bsd/string.c
+
+lz4-test-srcs += tests/commonlib/bsd/lz4-test.c
+lz4-test-srcs += src/commonlib/bsd/lz4_wrapper.c
+lz4-test-syssrcs += tests/helpers/clock.c
+lz4-test-syssrcs += tests/helpers/file.c
+
+# Same tests and benchmark without the fast decoding loop.
+$(call copy-test,lz4-test,lz4-careful-test)
+lz4-careful-test-cflags += -DLZ4_FAST_DEC_LOOP=0
+
+zstd-test-srcs += tests/commonlib/bsd/zstd-test.c
+zstd-test-srcs += src/commonlib/bsd/zstd_decompress.c
+zstd-test-syssrcs += tests/helpers/clock.c
+zstd-test-syssrcs += tests/helpers/file.c
+zstd-test-cflags += -DZSTD_SMALL=0
+
+# Same tests and benchmark with the pre-RAM decoder variant.
+$(call copy-test,zstd-test,zstd-small-test)
+zstd-small-test-cflags := -DZSTD_SMALL=1
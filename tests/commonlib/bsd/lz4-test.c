@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/compression.h>
+#include <helpers/clock.h>
+#include <helpers/file.h>
+#include <stdio.h>
+#include <string.h>
+#include <tests/test.h>
+
+#define BENCH_BYTES	(64 * MiB)
+
+struct lz4_test_state {
+	const char *name;
+	uint8_t *raw;
+	size_t raw_size;
+	uint8_t *comp;
+	size_t comp_size;
+};
+
+/*
+ * The raw data is shared with the LZMA test, the LZ4 frames were created with
+ * `lz4 -9 -B7 --content-size`.
+ */
+static int setup_lz4_file(void **state)
+{
+	const char *name = *state;
+	struct lz4_test_state *s = test_malloc(sizeof(*s));
+	char path[64];
+
+	if (!s)
+		return 1;
+	memset(s, 0, sizeof(*s));
+	s->name = name;
+
+	snprintf(path, sizeof(path), "lib/lzma-test/%s.bin", name);
+	s->raw_size = test_get_file_size(path);
+	s->raw = test_malloc(s->raw_size);
+	if (s->raw_size == -1 || test_read_file(path, s->raw, s->raw_size) != s->raw_size)
+		return 2;
+
+	snprintf(path, sizeof(path), "commonlib/bsd/lz4-test/%s.lz4.bin", name);
+	s->comp_size = test_get_file_size(path);
+	s->comp = test_malloc(s->comp_size);
+	if (s->comp_size == -1 || test_read_file(path, s->comp, s->comp_size) != s->comp_size)
+		return 3;
+
+	*state = s;
+	return 0;
+}
+
+static int teardown_lz4_file(void **state)
+{
+	struct lz4_test_state *s = *state;
+
+	test_free(s->raw);
+	test_free(s->comp);
+	test_free(s);
+
+	return 0;
+}
+
+static void test_ulz4fn(void **state)
+{
+	struct lz4_test_state *s = *state;
+	uint8_t *out = test_malloc(s->raw_size);
+
+	assert_int_equal(s->raw_size, ulz4fn(s->comp, s->comp_size, out, s->raw_size));
+	assert_memory_equal(s->raw, out, s->raw_size);
+
+	/* Too little output space or truncated input must fail without overrunning. */
+	assert_int_equal(0, ulz4fn(s->comp, s->comp_size, out, s->raw_size - 1));
+	assert_int_equal(0, ulz4fn(s->comp, s->comp_size / 2, out, s->raw_size));
+
+	test_free(out);
+}
+
+/* Like cbfs_prog_stage_load(), with the compressed data at the end of the output buffer. */
+static void test_ulz4fn_in_place(void **state)
+{
+	struct lz4_test_state *s = *state;
+	const size_t size = s->raw_size + 64;
+	uint8_t *buf = test_malloc(size);
+	uint8_t *in = buf + size - s->comp_size;
+
+	memcpy(in, s->comp, s->comp_size);
+	assert_int_equal(s->raw_size, ulz4fn(in, s->comp_size, buf, size));
+	assert_memory_equal(s->raw, buf, s->raw_size);
+
+	test_free(buf);
+}
+
+/* Not a pass/fail test, compare the numbers of lz4-test and lz4-careful-test. */
+static void test_ulz4fn_benchmark(void **state)
+{
+	struct lz4_test_state *s = *state;
+	uint8_t *out = test_malloc(s->raw_size);
+	const size_t iters = BENCH_BYTES / s->raw_size + 1;
+	uint64_t start, ns;
+	size_t i;
+
+	start = test_clock_ns();
+	for (i = 0; i < iters; i++)
+		assert_int_equal(s->raw_size, ulz4fn(s->comp, s->comp_size, out, s->raw_size));
+	ns = test_clock_ns() - start;
+
+	print_message("%s: %zu bytes x %zu in %llu us, %llu MB/s\n", s->name, s->raw_size,
+		      iters, (unsigned long long)ns / 1000,
+		      ns ? (unsigned long long)(s->raw_size * iters * 1000 / ns) : 0);
+
+	test_free(out);
+}
+
+#define LZ4_FILE_TEST(_func, _file)                                                            \
+	{                                                                                      \
+		.name = #_func "(" _file ")", .test_func = _func,                              \
+		.setup_func = setup_lz4_file, .teardown_func = teardown_lz4_file,              \
+		.initial_state = (_file)                                                       \
+	}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		/* util/cbfs-compression-tool, an executable. */
+		LZ4_FILE_TEST(test_ulz4fn, "data.1"),
+		/* tests/lib/imd-test.c, structured text. */
+		LZ4_FILE_TEST(test_ulz4fn, "data.3"),
+		/* libcmocka.so.0.7.0, a shared object. */
+		LZ4_FILE_TEST(test_ulz4fn, "data.4"),
+
+		LZ4_FILE_TEST(test_ulz4fn_in_place, "data.1"),
+		LZ4_FILE_TEST(test_ulz4fn_in_place, "data.3"),
+		LZ4_FILE_TEST(test_ulz4fn_in_place, "data.4"),
+
+		LZ4_FILE_TEST(test_ulz4fn_benchmark, "data.1"),
+		LZ4_FILE_TEST(test_ulz4fn_benchmark, "data.3"),
+		LZ4_FILE_TEST(test_ulz4fn_benchmark, "data.4"),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/compression.h>
+#include <helpers/clock.h>
+#include <helpers/file.h>
+#include <stdio.h>
+#include <string.h>
+#include <tests/test.h>
+
+#define BENCH_BYTES	(64 * MiB)
+
+struct zstd_test_state {
+	const char *name;
+	uint8_t *raw;
+	size_t raw_size;
+	uint8_t *comp;
+	size_t comp_size;
+};
+
+/*
+ * The raw data is shared with the LZMA test, the Zstandard frames were created with
+ * `zstd -19`, so they also carry a content checksum.
+ */
+static int setup_zstd_file(void **state)
+{
+	const char *name = *state;
+	struct zstd_test_state *s = test_malloc(sizeof(*s));
+	char path[64];
+
+	if (!s)
+		return 1;
+	memset(s, 0, sizeof(*s));
+	s->name = name;
+
+	snprintf(path, sizeof(path), "lib/lzma-test/%s.bin", name);
+	s->raw_size = test_get_file_size(path);
+	s->raw = test_malloc(s->raw_size);
+	if (s->raw_size == -1 || test_read_file(path, s->raw, s->raw_size) != s->raw_size)
+		return 2;
+
+	snprintf(path, sizeof(path), "commonlib/bsd/zstd-test/%s.zst.bin", name);
+	s->comp_size = test_get_file_size(path);
+	s->comp = test_malloc(s->comp_size);
+	if (s->comp_size == -1 || test_read_file(path, s->comp, s->comp_size) != s->comp_size)
+		return 3;
+
+	*state = s;
+	return 0;
+}
+
+static int teardown_zstd_file(void **state)
+{
+	struct zstd_test_state *s = *state;
+
+	test_free(s->raw);
+	test_free(s->comp);
+	test_free(s);
+
+	return 0;
+}
+
+static void test_uzstdn(void **state)
+{
+	struct zstd_test_state *s = *state;
+	uint8_t *out = test_malloc(s->raw_size);
+
+	assert_int_equal(s->raw_size, uzstdn(s->comp, s->comp_size, out, s->raw_size));
+	assert_memory_equal(s->raw, out, s->raw_size);
+
+	/* Too little output space or truncated input must fail without overrunning. */
+	assert_int_equal(0, uzstdn(s->comp, s->comp_size, out, s->raw_size - 1));
+	assert_int_equal(0, uzstdn(s->comp, s->comp_size / 2, out, s->raw_size));
+	assert_int_equal(0, uzstdn(s->comp, s->comp_size - 1, out, s->raw_size));
+
+	test_free(out);
+}
+
+/* Frames may be concatenated, with skippable frames in between. */
+static void test_uzstdn_multiple_frames(void **state)
+{
+	struct zstd_test_state *s = *state;
+	const uint8_t skippable[] = { 0x5a, 0x2a, 0x4d, 0x18, 3, 0, 0, 0, 0xde, 0xad, 0x00 };
+	const size_t in_size = 2 * s->comp_size + sizeof(skippable);
+	uint8_t *in = test_malloc(in_size);
+	uint8_t *out = test_malloc(2 * s->raw_size);
+
+	memcpy(in, s->comp, s->comp_size);
+	memcpy(in + s->comp_size, skippable, sizeof(skippable));
+	memcpy(in + s->comp_size + sizeof(skippable), s->comp, s->comp_size);
+
+	assert_int_equal(2 * s->raw_size, uzstdn(in, in_size, out, 2 * s->raw_size));
+	assert_memory_equal(s->raw, out, s->raw_size);
+	assert_memory_equal(s->raw, out + s->raw_size, s->raw_size);
+
+	/* The second frame doesn't fit anymore. */
+	assert_int_equal(0, uzstdn(in, in_size, out, 2 * s->raw_size - 1));
+
+	test_free(in);
+	test_free(out);
+}
+
+/* Not a pass/fail test, compare the numbers of zstd-test and zstd-small-test. */
+static void test_uzstdn_benchmark(void **state)
+{
+	struct zstd_test_state *s = *state;
+	uint8_t *out = test_malloc(s->raw_size);
+	const size_t iters = BENCH_BYTES / s->raw_size + 1;
+	uint64_t start, ns;
+	size_t i;
+
+	start = test_clock_ns();
+	for (i = 0; i < iters; i++)
+		assert_int_equal(s->raw_size, uzstdn(s->comp, s->comp_size, out, s->raw_size));
+	ns = test_clock_ns() - start;
+
+	print_message("%s: %zu bytes x %zu in %llu us, %llu MB/s\n", s->name, s->raw_size,
+		      iters, (unsigned long long)ns / 1000,
+		      ns ? (unsigned long long)(s->raw_size * iters * 1000 / ns) : 0);
+
+	test_free(out);
+}
+
+#define ZSTD_FILE_TEST(_func, _file)                                                           \
+	{                                                                                      \
+		.name = #_func "(" _file ")", .test_func = _func,                              \
+		.setup_func = setup_zstd_file, .teardown_func = teardown_zstd_file,            \
+		.initial_state = (_file)                                                       \
+	}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		/* util/cbfs-compression-tool, an executable. */
+		ZSTD_FILE_TEST(test_uzstdn, "data.1"),
+		/* tests/lib/imd-test.c, structured text. */
+		ZSTD_FILE_TEST(test_uzstdn, "data.3"),
+		/* libcmocka.so.0.7.0, a shared object. */
+		ZSTD_FILE_TEST(test_uzstdn, "data.4"),
+
+		ZSTD_FILE_TEST(test_uzstdn_multiple_frames, "data.3"),
+
+		ZSTD_FILE_TEST(test_uzstdn_benchmark, "data.1"),
+		ZSTD_FILE_TEST(test_uzstdn_benchmark, "data.3"),
+		ZSTD_FILE_TEST(test_uzstdn_benchmark, "data.4"),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -2,6 +2,7 @@
 
 #include <commonlib/device_tree.h>
 #include <console/console.h>
+#include <endian.h>
 #include <helpers/file.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -117,6 +118,142 @@ static void test_fdt_read_reg_prop(void **state)
 	assert_int_equal(0x00010000, regions[0].size);
 }
 
+static void check_phandles(struct device_tree_node *root, struct device_tree_node *node,
+			   size_t *count)
+{
+	struct device_tree_node *child;
+
+	if (node->phandle) {
+		assert_ptr_equal(node, dt_find_node_by_phandle(root, node->phandle));
+		(*count)++;
+	}
+
+	list_for_each(child, node->children, list_node)
+		check_phandles(root, child, count);
+}
+
+static void test_dt_unflatten_lookups(void **state)
+{
+	struct device_tree *tree = fdt_unflatten(*state);
+	struct device_tree_node *node, *created;
+	uint32_t addrcp, sizecp;
+	size_t count = 0;
+
+	assert_non_null(tree);
+
+	node = dt_find_node_by_path(tree, "/usb@7d004000/ethernet@2", &addrcp, &sizecp, 0);
+	assert_non_null(node);
+	assert_string_equal("ethernet@2", node->name);
+	assert_int_equal(1, addrcp);
+	assert_int_equal(0, sizecp);
+
+	node = dt_find_node_by_path(tree, "/pinmux@70000868/pinmux/drive_groups", NULL, NULL, 0);
+	assert_non_null(node);
+	assert_string_equal("drive_groups", node->name);
+
+	assert_null(dt_find_node_by_path(tree, "/test", NULL, NULL, 0));
+	assert_non_null(dt_find_node_by_alias(tree, "serial0"));
+
+	/* Created nodes are found again. */
+	created = dt_find_node_by_path(tree, "/firmware/coreboot", NULL, NULL, 1);
+	assert_non_null(created);
+	assert_ptr_equal(created, dt_find_node_by_path(tree, "/firmware/coreboot", NULL, NULL, 0));
+
+	/* Deleted nodes are not. */
+	node = dt_find_node_by_path(tree, "/usb@7d004000", NULL, NULL, 0);
+	assert_non_null(node);
+	dt_delete_node(node);
+	assert_null(dt_find_node_by_path(tree, "/usb@7d004000", NULL, NULL, 0));
+	assert_null(dt_find_node_by_path(tree, "/usb@7d004000/ethernet@2", NULL, NULL, 0));
+
+	check_phandles(tree->root, tree->root, &count);
+	assert_int_not_equal(0, count);
+	assert_null(dt_find_node_by_phandle(tree->root, tree->max_phandle + 1));
+	assert_ptr_equal(tree->root, dt_find_node_by_phandle(tree->root, 0));
+}
+
+static void test_fdt_edit_in_place(void **state)
+{
+	const struct fdt_header *header = *state;
+	const uint32_t orig_size = be32toh(header->totalsize);
+	const size_t buf_size = orig_size + 4096;
+	const uint64_t initrd = htobe64(0x12345678);
+	struct device_tree_reserve_map_entry *entry;
+	struct device_tree_node *node;
+	struct device_tree *tree;
+	struct fdt_property prop;
+	uint32_t addrcp = 0, sizecp = 0, offset;
+	void *blob = test_malloc(buf_size);
+	bool found = false;
+	const void *data;
+	size_t size;
+
+	memcpy(blob, *state, orig_size);
+	header = blob;
+	assert_true(fdt_is_editable(blob, buf_size));
+	assert_false(fdt_is_editable(blob, orig_size - 1));
+
+	/* New nodes and properties, with a property name that is not in the tree yet. */
+	offset = fdt_add_node_by_path(blob, buf_size, "/firmware/coreboot", &addrcp, &sizecp);
+	assert_int_not_equal(0, offset);
+	assert_int_equal(1, addrcp);
+	assert_int_equal(1, sizecp);
+	assert_int_equal(offset, fdt_find_node_by_path(blob, "/firmware/coreboot", NULL, NULL));
+	assert_int_equal(0, fdt_set_prop(blob, buf_size, offset, "compatible", "coreboot",
+					 sizeof("coreboot")));
+	assert_int_equal(0, fdt_set_prop(blob, buf_size, offset, "coreboot,test", "x", 2));
+
+	/* Existing properties grow and shrink. */
+	offset = fdt_find_node_by_path(blob, "/chosen", NULL, NULL);
+	assert_int_not_equal(0, offset);
+	assert_int_equal(0, fdt_set_prop(blob, buf_size, offset, "linux,initrd-start",
+					 &initrd, sizeof(initrd)));
+	offset = fdt_find_node_by_path(blob, "/clock", NULL, NULL);
+	assert_int_equal(0, fdt_set_prop(blob, buf_size, offset, "compatible", "fixed-clock-v2",
+					 sizeof("fixed-clock-v2")));
+	assert_int_equal(0, fdt_set_prop(blob, buf_size, offset, "compatible", "clk",
+					 sizeof("clk")));
+
+	offset = fdt_find_node_by_path(blob, "/usb@7d004000", NULL, NULL);
+	assert_int_not_equal(0, offset);
+	fdt_delete_node(blob, offset);
+	assert_int_equal(0, fdt_add_reserve_map_entry(blob, buf_size, 0x80000000, 0x1000));
+
+	/* Running out of space leaves the tree alone. */
+	offset = fdt_find_node_by_path(blob, "/chosen", NULL, NULL);
+	assert_int_equal(-1, fdt_set_prop(blob, buf_size, offset, "bootargs", blob, buf_size));
+
+	assert_true(fdt_is_editable(blob, buf_size));
+	assert_int_equal(0, fdt_find_node_by_path(blob, "/usb@7d004000", NULL, NULL));
+	assert_int_not_equal(0, fdt_find_node_by_alias(blob, "serial0", NULL, NULL));
+
+	offset = fdt_find_node_by_path(blob, "/clock", NULL, NULL);
+	assert_int_not_equal(0, fdt_read_prop(blob, offset, "compatible", &prop));
+	assert_string_equal("clk", (char *)prop.data);
+
+	/* The edited tree parses like one that was built with it. */
+	tree = fdt_unflatten(blob);
+	assert_non_null(tree);
+	node = dt_find_node_by_path(tree, "/firmware/coreboot", NULL, NULL, 0);
+	assert_non_null(node);
+	assert_string_equal("coreboot", dt_find_string_prop(node, "compatible"));
+	assert_string_equal("x", dt_find_string_prop(node, "coreboot,test"));
+	node = dt_find_node_by_path(tree, "/chosen", NULL, NULL, 0);
+	assert_non_null(node);
+	dt_find_bin_prop(node, "linux,initrd-start", &data, &size);
+	assert_int_equal(sizeof(initrd), size);
+	assert_memory_equal(&initrd, data, sizeof(initrd));
+	assert_null(dt_find_node_by_path(tree, "/usb@7d004000", NULL, NULL, 0));
+
+	list_for_each(entry, tree->reserve_map, list_node) {
+		if (entry->start == 0x80000000 && entry->size == 0x1000)
+			found = true;
+	}
+	assert_true(found);
+
+	test_free(blob);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -125,6 +262,8 @@ int main(void)
 		cmocka_unit_test(test_fdt_find_node_by_alias),
 		cmocka_unit_test(test_fdt_find_prop_in_node),
 		cmocka_unit_test(test_fdt_read_reg_prop),
+		cmocka_unit_test(test_dt_unflatten_lookups),
+		cmocka_unit_test(test_fdt_edit_in_place),
 	};
 
 	return cb_run_group_tests(tests, setup_device_tree_test_group,
@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/mem_pool.h>
+#include <string.h>
+#include <tests/test.h>
+
+#define POOL_SIZE	1024
+#define POOL_ALIGN	16
+
+static uint8_t pool_buf[POOL_SIZE] __aligned(POOL_ALIGN);
+static struct mem_pool_block pool_blocks[4];
+
+static void test_mem_pool_lifo(void **state)
+{
+	struct mem_pool mp = MEM_POOL_INIT(pool_buf, POOL_SIZE, POOL_ALIGN);
+	void *a, *b, *c;
+
+	a = mem_pool_alloc(&mp, 100);
+	b = mem_pool_alloc(&mp, 100);
+	assert_ptr_equal(a, pool_buf);
+	assert_ptr_equal(b, pool_buf + 112);
+
+	/* Out of order frees leak. */
+	mem_pool_free(&mp, a);
+	c = mem_pool_alloc(&mp, 16);
+	assert_ptr_equal(c, pool_buf + 224);
+
+	/* The two most recent allocations can be freed in reverse order. */
+	mem_pool_free(&mp, c);
+	mem_pool_free(&mp, b);
+	assert_ptr_equal(mem_pool_alloc(&mp, 16), pool_buf + 112);
+	assert_int_equal(mem_pool_peak(&mp), 240);
+
+	assert_null(mem_pool_alloc(&mp, POOL_SIZE));
+}
+
+static void test_mem_pool_free_list(void **state)
+{
+	struct mem_pool mp = MEM_POOL_INIT_FREE_LIST(pool_buf, POOL_SIZE, POOL_ALIGN,
+						      pool_blocks, ARRAY_SIZE(pool_blocks));
+	void *a, *b, *c, *d;
+
+	a = mem_pool_alloc(&mp, 200);
+	b = mem_pool_alloc(&mp, 100);
+	c = mem_pool_alloc(&mp, 300);
+	assert_ptr_equal(a, pool_buf);
+	assert_ptr_equal(b, pool_buf + 208);
+	assert_ptr_equal(c, pool_buf + 320);
+
+	/* Freed space in the middle is reused, the smallest gap that fits first. */
+	mem_pool_free(&mp, a);
+	mem_pool_free(&mp, b);
+	d = mem_pool_alloc(&mp, 250);
+	assert_ptr_equal(d, pool_buf);
+	mem_pool_free(&mp, d);
+
+	mem_pool_free(&mp, c);
+	b = mem_pool_alloc(&mp, 100);
+	assert_ptr_equal(b, pool_buf);
+
+	/* Freeing the same or a foreign pointer twice is ignored. */
+	mem_pool_free(&mp, c);
+	mem_pool_free(&mp, pool_buf + 1);
+	mem_pool_free(&mp, NULL);
+	assert_ptr_equal(mem_pool_alloc(&mp, 16), pool_buf + 112);
+
+	/* Out of block descriptors. */
+	assert_non_null(mem_pool_alloc(&mp, 16));
+	assert_non_null(mem_pool_alloc(&mp, 16));
+	assert_null(mem_pool_alloc(&mp, 16));
+
+	mem_pool_reset(&mp);
+	assert_ptr_equal(mem_pool_alloc(&mp, POOL_SIZE), pool_buf);
+	assert_null(mem_pool_alloc(&mp, 16));
+	assert_int_equal(mem_pool_peak(&mp), POOL_SIZE);
+}
+
+static void test_mem_pool_free_list_churn(void **state)
+{
+	struct mem_pool mp = MEM_POOL_INIT_FREE_LIST(pool_buf, POOL_SIZE, POOL_ALIGN,
+						      pool_blocks, ARRAY_SIZE(pool_blocks));
+	void *p[3];
+	int i;
+
+	/* Out of order map/unmap cycles must not leak any space. */
+	for (i = 0; i < 1000; i++) {
+		p[0] = mem_pool_alloc(&mp, 256);
+		p[1] = mem_pool_alloc(&mp, 64 + i % 128);
+		p[2] = mem_pool_alloc(&mp, 256);
+		assert_non_null(p[0]);
+		assert_non_null(p[1]);
+		assert_non_null(p[2]);
+		mem_pool_free(&mp, p[i % 3]);
+		mem_pool_free(&mp, p[(i + 2) % 3]);
+		mem_pool_free(&mp, p[(i + 1) % 3]);
+	}
+
+	assert_ptr_equal(mem_pool_alloc(&mp, POOL_SIZE), pool_buf);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_mem_pool_lifo),
+		cmocka_unit_test(test_mem_pool_free_list),
+		cmocka_unit_test(test_mem_pool_free_list_churn),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
@@ -391,6 +391,96 @@ static void test_mem_rdev(void **state)
 	assert_memory_equal(backing, scratch, size);
 }
 
+static u8 counted_backing[1024];
+static int counted_reads;
+
+static ssize_t counted_readat(const struct region_device *rdev, void *buffer, size_t offset,
+			      size_t size)
+{
+	counted_reads++;
+	memcpy(buffer, &counted_backing[offset], size);
+	return size;
+}
+
+static ssize_t counted_writeat(const struct region_device *rdev, const void *buffer,
+			       size_t offset, size_t size)
+{
+	memcpy(&counted_backing[offset], buffer, size);
+	return size;
+}
+
+static const struct region_device_ops counted_rdev_ops = {
+	.readat = counted_readat,
+	.writeat = counted_writeat,
+};
+
+static void test_cache_rdev(void **state)
+{
+	/* Backing device not a multiple of the block size to test the short last block. */
+	const struct region_device counted = REGION_DEV_INIT(&counted_rdev_ops, 0, 1000);
+	struct cache_region_device cdev;
+	struct cache_rdev_block blocks[4];
+	u8 cache_buf[4 * 64];
+	const struct region_device *rd;
+	u8 scratch[128];
+	int i;
+
+	for (i = 0; i < sizeof(counted_backing); i++)
+		counted_backing[i] = i * 7;
+
+	/* Block size must be a power of 2. */
+	assert_null(cache_region_device_init(&cdev, &counted, blocks, cache_buf, 4, 48, 0,
+					     NULL));
+
+	rd = cache_region_device_init(&cdev, &counted, blocks, cache_buf, 4, 64, 2, NULL);
+	assert_non_null(rd);
+	assert_int_equal(region_device_sz(rd), 1000);
+
+	/* A small read fills one block, further reads from it are hits. */
+	counted_reads = 0;
+	assert_int_equal(rdev_readat(rd, scratch, 10, 4), 4);
+	assert_memory_equal(scratch, &counted_backing[10], 4);
+	assert_int_equal(rdev_readat(rd, scratch, 40, 20), 20);
+	assert_memory_equal(scratch, &counted_backing[40], 20);
+	assert_int_equal(counted_reads, 1);
+
+	/* A sequential miss reads ahead: blocks 1-3 come in with a single read. */
+	assert_int_equal(rdev_readat(rd, scratch, 60, 8), 8);
+	assert_memory_equal(scratch, &counted_backing[60], 8);
+	assert_int_equal(rdev_readat(rd, scratch, 130, 8), 8);
+	assert_int_equal(rdev_readat(rd, scratch, 200, 50), 50);
+	assert_memory_equal(scratch, &counted_backing[200], 50);
+	assert_int_equal(counted_reads, 2);
+
+	/* Reads of a block or more bypass the cache. */
+	assert_int_equal(rdev_readat(rd, scratch, 300, 100), 100);
+	assert_memory_equal(scratch, &counted_backing[300], 100);
+	assert_int_equal(counted_reads, 3);
+
+	/* A random miss evicts the least recently used block (block 0) only. */
+	assert_int_equal(rdev_readat(rd, scratch, 600, 4), 4);
+	assert_int_equal(counted_reads, 4);
+	assert_int_equal(rdev_readat(rd, scratch, 64, 4), 4);
+	assert_int_equal(rdev_readat(rd, scratch, 200, 4), 4);
+	assert_int_equal(counted_reads, 4);
+	assert_int_equal(rdev_readat(rd, scratch, 0, 4), 4);
+	assert_int_equal(counted_reads, 5);
+
+	/* The short last block is served up to the end of the device. */
+	assert_int_equal(rdev_readat(rd, scratch, 990, 10), 10);
+	assert_memory_equal(scratch, &counted_backing[990], 10);
+
+	/* Writes go through and drop the stale block. */
+	memset(scratch, 0xa5, 16);
+	assert_int_equal(rdev_writeat(rd, scratch, 8, 16), 16);
+	assert_int_equal(counted_backing[8], 0xa5);
+	assert_int_equal(rdev_readat(rd, scratch, 0, 32), 32);
+	assert_memory_equal(scratch, counted_backing, 32);
+
+	/* No mem_pool, so no mmap. */
+	assert_null(rdev_mmap(rd, 0, 16));
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -402,6 +492,7 @@ int main(void)
 		cmocka_unit_test(test_rdev_chain),
 		cmocka_unit_test(test_rdev_double_chain),
 		cmocka_unit_test(test_mem_rdev),
+		cmocka_unit_test(test_cache_rdev),
 	};
 
 	return cb_run_group_tests(tests, NULL, NULL);
@@ -11,3 +11,12 @@ efivars-test-cflags += -I src/vendorcode/intel/edk2/UDK2017/MdePkg/Include/
 efivars-test-cflags += -I src/vendorcode/intel/edk2/UDK2017/MdePkg/Include/Ia32/
 efivars-test-cflags += -I src/vendorcode/intel/edk2/UDK2017/MdePkg/Include/Pi/
 efivars-test-cflags += -I src/vendorcode/intel/edk2/UDK2017/MdeModulePkg/Include/
+
+tests-y += smmstore-test
+
+smmstore-test-srcs += tests/drivers/smmstore.c
+smmstore-test-srcs += src/drivers/smmstore/store.c
+smmstore-test-srcs += src/lib/xxhash.c
+smmstore-test-srcs += tests/stubs/console.c
+smmstore-test-srcs += src/commonlib/region.c
+smmstore-test-cflags += -I tests/include/tests/drivers/smmstore
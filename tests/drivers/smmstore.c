@@ -0,0 +1,267 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <boot_device.h>
+#include <commonlib/region.h>
+#include <fmap.h>
+#include <fmap_config.h>
+#include <smmstore.h>
+#include <stdio.h>
+#include <string.h>
+#include <tests/test.h>
+#include <types.h>
+
+#define STORE_SIZE	FMAP_SECTION_SMMSTORE_SIZE
+#define HALF_SIZE	(STORE_SIZE / 2)
+#define HEADER_SIZE	8
+
+static uint8_t flash[STORE_SIZE];
+
+static void *flash_mmap(const struct region_device *rd, size_t offset, size_t size)
+{
+	return &flash[offset];
+}
+
+static int flash_munmap(const struct region_device *rd, void *mapping)
+{
+	return 0;
+}
+
+static ssize_t flash_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	memcpy(b, &flash[offset], size);
+	return size;
+}
+
+/* Like NOR flash, writes can only clear bits. */
+static ssize_t flash_writeat(const struct region_device *rd, const void *b, size_t offset,
+			     size_t size)
+{
+	const uint8_t *p = b;
+
+	for (size_t i = 0; i < size; i++)
+		flash[offset + i] &= p[i];
+	return size;
+}
+
+static ssize_t flash_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	memset(&flash[offset], 0xff, size);
+	return size;
+}
+
+static const struct region_device_ops flash_ops = {
+	.mmap = flash_mmap,
+	.munmap = flash_munmap,
+	.readat = flash_readat,
+	.writeat = flash_writeat,
+	.eraseat = flash_eraseat,
+};
+
+static const struct region_device flash_rdev = REGION_DEV_INIT(&flash_ops, 0, STORE_SIZE);
+
+int fmap_locate_area(const char *name, struct region *r)
+{
+	r->offset = 0;
+	r->size = STORE_SIZE;
+	return 0;
+}
+
+int boot_device_ro_subregion(const struct region *sub, struct region_device *subrd)
+{
+	return rdev_chain(subrd, &flash_rdev, region_offset(sub), region_sz(sub));
+}
+
+int boot_device_rw_subregion(const struct region *sub, struct region_device *subrd)
+{
+	return rdev_chain(subrd, &flash_rdev, region_offset(sub), region_sz(sub));
+}
+
+bool smm_region_overlaps_handler(const struct region *r)
+{
+	return false;
+}
+
+static int setup_store(void **state)
+{
+	memset(flash, 0xff, sizeof(flash));
+	/* Also drops what the store knows about the previous test. */
+	return smmstore_clear_region();
+}
+
+static void append(const char *key, uint32_t value)
+{
+	assert_int_equal(0, smmstore_append_data((void *)key, strlen(key), &value,
+						 sizeof(value)));
+}
+
+static void assert_value(const char *key, uint32_t expected)
+{
+	uint32_t value = 0, size = sizeof(value);
+
+	assert_int_equal(0, smmstore_lookup_data((void *)key, strlen(key), &value, &size));
+	assert_int_equal(sizeof(value), size);
+	assert_int_equal(expected, value);
+}
+
+static void test_smmstore_lookup(void **state)
+{
+	uint32_t value, size;
+	uint8_t buf[64];
+	ssize_t bufsize = sizeof(buf);
+
+	append("foo", 1);
+	append("bar", 2);
+	append("foo", 3);
+
+	assert_value("foo", 3);
+	assert_value("bar", 2);
+
+	size = sizeof(value);
+	assert_int_equal(-1, smmstore_lookup_data("baz", 3, &value, &size));
+
+	/* Too small buffers report the size of the value. */
+	size = 1;
+	assert_int_equal(-1, smmstore_lookup_data("foo", 3, &value, &size));
+	assert_int_equal(sizeof(value), size);
+
+	/* Readers of the whole store get the log without the header. */
+	assert_int_equal(0, smmstore_read_region(buf, &bufsize));
+	assert_int_equal(sizeof(buf), bufsize);
+	assert_int_equal(3, ((uint32_t *)buf)[0]);
+	assert_int_equal(sizeof(uint32_t), ((uint32_t *)buf)[1]);
+	assert_memory_equal("foo", &buf[8], 3);
+}
+
+static void test_smmstore_compaction(void **state)
+{
+	uint32_t i;
+
+	append("keep", 42);
+
+	/* Each entry takes 20 bytes, this fills each half several times. */
+	for (i = 0; i < 5 * HALF_SIZE / 20; i++) {
+		append("counter", i);
+		assert_value("counter", i);
+	}
+
+	assert_value("keep", 42);
+}
+
+static void test_smmstore_compaction_crash(void **state)
+{
+	uint32_t i;
+
+	for (i = 0; i < HALF_SIZE / 24; i++)
+		append("counter", i);
+
+	/*
+	 * Compacting into the second half that never got its header written
+	 * leaves the first half active.
+	 */
+	memset(&flash[HALF_SIZE + HEADER_SIZE], 0, 64);
+	assert_value("counter", i - 1);
+
+	append("counter", 1234);
+	assert_value("counter", 1234);
+}
+
+static void test_smmstore_legacy(void **state)
+{
+	const uint32_t k_sz = 3, v_sz = 4;
+	uint32_t i, value = 7;
+	size_t offset = 0;
+
+	/* A store from before the split: a log right at the start of the region. */
+	memcpy(&flash[offset], &k_sz, sizeof(k_sz));
+	memcpy(&flash[offset + 4], &v_sz, sizeof(v_sz));
+	memcpy(&flash[offset + 8], "old", k_sz);
+	memcpy(&flash[offset + 11], &value, v_sz);
+	flash[offset + 15] = 0;
+
+	assert_value("old", 7);
+
+	/* Each entry takes 16 bytes, fill past the first half to move the log. */
+	for (i = 0; i < HALF_SIZE / 16; i++)
+		append("new", i);
+
+	assert_value("old", 7);
+	assert_value("new", i - 1);
+	assert_int_equal(0, memcmp(&flash[HALF_SIZE], "1SMS", 4));
+}
+
+static void test_smmstore_many_keys(void **state)
+{
+	char key[8];
+	uint32_t i;
+
+	/* More keys than the index has slots. */
+	for (i = 0; i < 400; i++) {
+		snprintf(key, sizeof(key), "k%u", i);
+		append(key, i);
+	}
+
+	/* Compaction has to find the latest entries without the index as well. */
+	for (i = 0; i < HALF_SIZE / 20; i++)
+		append("counter", i);
+	assert_value("counter", i - 1);
+
+	for (i = 0; i < 400; i++) {
+		snprintf(key, sizeof(key), "k%u", i);
+		assert_value(key, i);
+	}
+}
+
+static void test_smmstore_raw_batch(void **state)
+{
+	static uint8_t com_buf[SMM_BLOCK_SIZE];
+	struct smmstore_raw_batch_op ops[] = {
+		{ .command = SMMSTORE_CMD_RAW_CLEAR, .block_id = 0 },
+		{ .command = SMMSTORE_CMD_RAW_WRITE, .block_id = 0, .offset = 0,
+		  .bufsize = 16, .bufoffset = 0x100 },
+		{ .command = SMMSTORE_CMD_RAW_WRITE, .block_id = 0, .offset = 16,
+		  .bufsize = 16, .bufoffset = 0x200 },
+		{ .command = SMMSTORE_CMD_RAW_READ, .block_id = 0, .offset = 0,
+		  .bufsize = 32, .bufoffset = 0x300 },
+		{ .command = SMMSTORE_CMD_RAW_READ, .block_id = 1 },
+	};
+	uint32_t completed;
+
+	memset(flash, 0, sizeof(flash));
+	memset(com_buf, 0, sizeof(com_buf));
+	memcpy(com_buf, ops, sizeof(ops));
+	memset(&com_buf[0x100], 'a', 16);
+	memset(&com_buf[0x200], 'b', 16);
+
+	assert_int_equal(0, smmstore_init(com_buf, sizeof(com_buf)));
+
+	assert_int_equal(0, smmstore_rawbatch_region(0, 4, &completed));
+	assert_int_equal(4, completed);
+	assert_memory_equal(&com_buf[0x100], &flash[0], 16);
+	assert_memory_equal(&com_buf[0x200], &flash[16], 16);
+	assert_memory_equal(&flash[0], &com_buf[0x300], 32);
+	assert_int_equal(0xff, flash[32]);
+
+	/* Stops at the block that doesn't exist. */
+	assert_int_equal(-1, smmstore_rawbatch_region(0, ARRAY_SIZE(ops), &completed));
+	assert_int_equal(4, completed);
+
+	/* The list has to be within the communication buffer. */
+	assert_int_equal(-1, smmstore_rawbatch_region(sizeof(com_buf) - sizeof(ops[0]) + 1,
+						      1, &completed));
+	assert_int_equal(0, completed);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_smmstore_lookup, setup_store),
+		cmocka_unit_test_setup(test_smmstore_compaction, setup_store),
+		cmocka_unit_test_setup(test_smmstore_compaction_crash, setup_store),
+		cmocka_unit_test_setup(test_smmstore_legacy, setup_store),
+		cmocka_unit_test_setup(test_smmstore_many_keys, setup_store),
+		cmocka_unit_test(test_smmstore_raw_batch),
+	};
+
+	return cb_run_group_tests(tests, NULL, NULL);
+}
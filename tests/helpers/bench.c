@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_SAMPLES	11
+#define BENCH_MAX_SAMPLES	101
+#define BENCH_DEFAULT_SAMPLE_MS	20
+
+static uint64_t clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static unsigned long env_ulong(const char *name, unsigned long def, unsigned long max)
+{
+	const char *s = getenv(name);
+	unsigned long v;
+
+	if (!s || !*s)
+		return def;
+	v = strtoul(s, NULL, 0);
+	if (!v)
+		return def;
+	return v < max ? v : max;
+}
+
+/* Migrating between CPUs in the middle of a sample is the largest source of noise. */
+static void pin_to_current_cpu(void)
+{
+	static int pinned;
+	cpu_set_t set;
+	int cpu;
+
+	if (pinned)
+		return;
+	pinned = 1;
+
+	cpu = sched_getcpu();
+	if (cpu < 0)
+		return;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+}
+
+static uint64_t time_calls(void (*fn)(void *arg), void *arg, uint64_t calls)
+{
+	uint64_t start, i;
+
+	start = clock_ns();
+	for (i = 0; i < calls; i++)
+		fn(arg);
+	return clock_ns() - start;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void print_json_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', f);
+		if ((unsigned char)*s >= 0x20)
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+void test_bench_run_named(const char *program, const char *name, void (*fn)(void *arg),
+			  void *arg, size_t bytes)
+{
+	const unsigned long samples = env_ulong("BENCH_SAMPLES", BENCH_DEFAULT_SAMPLES,
+						BENCH_MAX_SAMPLES);
+	const uint64_t sample_ns = env_ulong("BENCH_SAMPLE_MS", BENCH_DEFAULT_SAMPLE_MS,
+					     60 * 1000) * 1000000;
+	const char *output = getenv("BENCH_OUTPUT");
+	uint64_t ns[BENCH_MAX_SAMPLES];
+	uint64_t calls = 1, t;
+	double median, fastest;
+	unsigned long i;
+	FILE *f = stdout;
+
+	pin_to_current_cpu();
+
+	/* Find the number of calls that takes at least a quarter of a sample, then scale. */
+	while ((t = time_calls(fn, arg, calls)) < sample_ns / 4 && calls < (1ULL << 40))
+		calls *= 2;
+	if (t < sample_ns)
+		calls = calls * sample_ns / (t ? t : 1);
+	if (!calls)
+		calls = 1;
+
+	time_calls(fn, arg, calls);
+	for (i = 0; i < samples; i++)
+		ns[i] = time_calls(fn, arg, calls);
+	qsort(ns, samples, sizeof(ns[0]), cmp_u64);
+
+	median = (double)ns[samples / 2] / calls;
+	fastest = (double)ns[0] / calls;
+
+	if (output && *output) {
+		f = fopen(output, "a");
+		if (!f) {
+			perror(output);
+			exit(1);
+		}
+	}
+
+	fputs("{\"benchmark\": ", f);
+	print_json_string(f, program);
+	fputs(", \"case\": ", f);
+	print_json_string(f, name);
+	fprintf(f, ", \"calls_per_sample\": %llu, \"samples\": %lu", (unsigned long long)calls,
+		samples);
+	fprintf(f, ", \"ns_per_call\": %.2f, \"ns_per_call_min\": %.2f", median, fastest);
+	if (bytes)
+		fprintf(f, ", \"bytes_per_call\": %zu, \"mb_per_s\": %.1f", bytes,
+			bytes * 1000.0 / median);
+	fputs("}\n", f);
+
+	if (f != stdout)
+		fclose(f);
+}
@@ -0,0 +1,17 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Get a monotonic time stamp for benchmarks
+ *
+ * @return  Time in nanoseconds since an arbitrary point in the past.
+ */
+uint64_t test_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
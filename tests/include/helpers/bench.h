@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_HELPERS_BENCH_H
+#define _TESTS_HELPERS_BENCH_H
+
+#include <stddef.h>
+
+/*
+ * Time calls of fn(arg) and report them as one line of JSON, appended to the file named
+ * by the BENCH_OUTPUT environment variable, or printed if it isn't set.
+ *
+ * The number of calls per sample is chosen so that a sample takes BENCH_SAMPLE_MS (20 by
+ * default) milliseconds. After one sample to warm up caches, BENCH_SAMPLES (11 by default)
+ * samples are taken, and the median and fastest time per call are reported. Both vary a lot
+ * less between runs than a single long measurement.
+ *
+ * @param name   name of the case, unique within the benchmark program
+ * @param bytes  bytes processed per call to report throughput, or 0
+ */
+void test_bench_run_named(const char *program, const char *name, void (*fn)(void *arg),
+			  void *arg, size_t bytes);
+
+#define test_bench_run(name, fn, arg, bytes) \
+	test_bench_run_named(__TEST_NAME__, name, fn, arg, bytes)
+
+#endif
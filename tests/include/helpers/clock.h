@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_HELPERS_CLOCK_H
+#define _TESTS_HELPERS_CLOCK_H
+
+#include <stdint.h>
+
+uint64_t test_clock_ns(void);
+
+#endif
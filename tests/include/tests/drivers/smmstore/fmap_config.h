@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef FMAPTOOL_GENERATED_HEADER_H_
+#define FMAPTOOL_GENERATED_HEADER_H_
+
+/* Only what store.c checks, the tests mock the FMAP lookup. */
+#define FMAP_SECTION_SMMSTORE_START 0x0
+#define FMAP_SECTION_SMMSTORE_SIZE 0x10000
+
+#endif
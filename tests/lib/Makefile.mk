@@ -5,6 +5,7 @@ tests-y += string-test
 tests-y += b64_decode-test
 tests-y += hexstrtobin-test
 tests-y += imd-test
+tests-y += imd-sorted-index-test
 tests-y += timestamp-test
 tests-y += edid-test
 tests-y += cbmem_console-romstage-test
@@ -37,6 +38,7 @@ tests-y += cbfs-no-verification-no-sha512-test
 tests-y += cbfs-no-verification-has-sha512-test
 tests-y += cbfs-lookup-no-mcache-test
 tests-y += cbfs-lookup-has-mcache-test
+tests-y += cbfs-lookup-has-mcache-index-test
 tests-y += lzma-test
 tests-y += ux_locales-test
 
@@ -56,6 +58,11 @@ imd-test-srcs += tests/lib/imd-test.c
 imd-test-srcs += tests/stubs/console.c
 imd-test-srcs += src/lib/imd.c
 
+imd-sorted-index-test-srcs += tests/lib/imd-test.c
+imd-sorted-index-test-srcs += tests/stubs/console.c
+imd-sorted-index-test-srcs += src/lib/imd.c
+imd-sorted-index-test-config += CONFIG_IMD_SORTED_INDEX=1
+
 timestamp-test-srcs += tests/lib/timestamp-test.c
 timestamp-test-srcs += tests/stubs/timestamp.c
 timestamp-test-srcs += tests/stubs/console.c
@@ -230,6 +237,10 @@ cbfs-lookup-no-mcache-test-config += CONFIG_ARCH_X86=0 \
 $(call copy-test,cbfs-lookup-no-mcache-test,cbfs-lookup-has-mcache-test)
 cbfs-lookup-has-mcache-test-config += CONFIG_NO_CBFS_MCACHE=0
 
+$(call copy-test,cbfs-lookup-no-mcache-test,cbfs-lookup-has-mcache-index-test)
+cbfs-lookup-has-mcache-index-test-config += CONFIG_NO_CBFS_MCACHE=0 \
+					CONFIG_CBFS_MCACHE_HASH_INDEX=1
+
 lzma-test-srcs += tests/lib/lzma-test.c
 lzma-test-srcs += tests/stubs/console.c
 lzma-test-srcs += src/lib/lzma.c
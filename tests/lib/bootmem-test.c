@@ -400,6 +400,33 @@ static void test_bootmem_allocate_buffer(void **state)
 	assert_null(buf);
 }
 
+static void test_bootmem_allocate_buffer_proximity(void **state)
+{
+	void *buf;
+
+	init_memory_table_library();
+
+	/* Two domains, the BSP is in the lower one. */
+	bootmem_add_proximity_domain(CACHEABLE_START, 0x80000000 - CACHEABLE_START, 0);
+	bootmem_add_proximity_domain(0x80000000, CACHEABLE_END - 0x80000000, 1);
+	bootmem_set_bsp_proximity_domain(0);
+
+	assert_int_equal(0, bootmem_proximity_domain(CACHEABLE_START, 0x1000));
+	assert_int_equal(1, bootmem_proximity_domain(RESERVED_END, 0x1000));
+	assert_int_equal(-1, bootmem_proximity_domain(0x7ffff000, 0x2000));
+	assert_int_equal(-1, bootmem_proximity_domain(ZERO_REGION_START, ZERO_REGION_SIZE));
+
+	/* The top of the BSP local memory instead of the top of memory below 4 GiB */
+	buf = bootmem_allocate_buffer(0x1000000);
+	assert_ptr_equal((void *)0x7f000000, buf);
+	assert_int_equal(0, bootmem_proximity_domain((uintptr_t)buf, 0x1000000));
+
+	/* Doesn't fit into local memory anymore, fall back to any memory. */
+	buf = bootmem_allocate_buffer(0x70000000);
+	assert_ptr_equal((void *)0x90000000, buf);
+	assert_int_equal(1, bootmem_proximity_domain((uintptr_t)buf, 0x70000000));
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -407,7 +434,8 @@ int main(void)
 		cmocka_unit_test(test_bootmem_add_range),
 		cmocka_unit_test(test_bootmem_walk),
 		cmocka_unit_test(test_bootmem_allocate_buffer),
-		cmocka_unit_test(test_bootmem_region_targets_type)
+		cmocka_unit_test(test_bootmem_region_targets_type),
+		cmocka_unit_test(test_bootmem_allocate_buffer_proximity),
 	};
 
 	return cb_run_group_tests(tests, NULL, NULL);
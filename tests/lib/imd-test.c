@@ -547,6 +547,62 @@ static void test_imd_entry_find(void **state)
 	free(base);
 }
 
+static const struct imd_entry *find_entry_linear(const struct imd_root *r, uint32_t id)
+{
+	size_t i;
+
+	for (i = 1; i < r->num_entries; i++) {
+		if (r->entries[i].id == id)
+			return &r->entries[i];
+	}
+
+	return NULL;
+}
+
+/* Checks lookups among a full root, including duplicate IDs and a replaced last entry. */
+static void test_imd_entry_find_many(void **state)
+{
+	struct imd imd = {0};
+	const struct imd_entry *e;
+	struct imd_root *r;
+	void *base;
+	size_t i, n;
+	uint32_t id;
+
+	base = malloc(2 * LIMIT_ALIGN);
+	if (base == NULL)
+		fail_msg("Cannot allocate enough memory - fail test");
+	imd_handle_init(&imd, (void *)(2 * LIMIT_ALIGN + (uintptr_t)base));
+
+	assert_int_equal(0, imd_create_empty(&imd, LIMIT_ALIGN, SM_ENTRY_ALIGN));
+	r = imd.lg.r;
+	n = max_entries(LIMIT_ALIGN);
+
+	/* Scrambled IDs, every eighth of them used twice. */
+	for (i = 1; i < n; i++) {
+		id = (i % 8 == 0) ? (i - 1) * 37 % 101 : i * 37 % 101;
+		assert_non_null(imd_entry_add(&imd, id, SM_ENTRY_SIZE));
+
+		/* Look entries up while the root is filling up as well. */
+		if (i % 16 == 0)
+			assert_ptr_equal(find_entry_linear(r, id), imd_entry_find(&imd, id));
+	}
+	assert_int_equal(n, r->num_entries);
+
+	for (id = 0; id < 110; id++)
+		assert_ptr_equal(find_entry_linear(r, id), imd_entry_find(&imd, id));
+
+	/* Replace the last entry by one with a new ID. */
+	e = &r->entries[n - 1];
+	id = e->id;
+	assert_int_equal(0, imd_entry_remove(&imd, e));
+	assert_non_null(imd_entry_add(&imd, INVALID_REGION_ID, SM_ENTRY_SIZE));
+	assert_ptr_equal(&r->entries[n - 1], imd_entry_find(&imd, INVALID_REGION_ID));
+	assert_ptr_equal(find_entry_linear(r, id), imd_entry_find(&imd, id));
+
+	free(base);
+}
+
 static void test_imd_entry_find_or_add(void **state)
 {
 	struct imd imd = {0};
@@ -748,6 +804,7 @@ int main(void)
 		cmocka_unit_test(test_imd_region_used),
 		cmocka_unit_test(test_imd_entry_add),
 		cmocka_unit_test(test_imd_entry_find),
+		cmocka_unit_test(test_imd_entry_find_many),
 		cmocka_unit_test(test_imd_entry_find_or_add),
 		cmocka_unit_test(test_imd_entry_size),
 		cmocka_unit_test(test_imd_entry_at),
@@ -108,6 +108,222 @@ static void test_ulzman_correct_file(void **state)
 	test_free(comp_buf);
 }
 
+static void test_ulzman_scratch(void **state)
+{
+	struct lzma_test_state *s = *state;
+	uint8_t *raw_buf = test_malloc(s->raw_file_sz);
+	uint8_t *decomp_buf = test_malloc(s->raw_file_sz);
+	uint8_t *comp_buf = test_malloc(s->comp_file_sz);
+	uint8_t *scratchpad = test_malloc(LZMA_SCRATCHPAD_SIZE);
+
+	assert_non_null(raw_buf);
+	assert_non_null(decomp_buf);
+	assert_non_null(comp_buf);
+	assert_non_null(scratchpad);
+	assert_int_equal(s->raw_file_sz,
+			 test_read_file(s->raw_filename, raw_buf, s->raw_file_sz));
+	assert_int_equal(s->comp_file_sz,
+			 test_read_file(s->comp_filename, comp_buf, s->comp_file_sz));
+
+	/* Scratchpad too small for the probability tables must be rejected. */
+	assert_int_equal(0, ulzman_scratch(comp_buf, s->comp_file_sz, decomp_buf,
+					   s->raw_file_sz, scratchpad, 16));
+
+	assert_int_equal(s->raw_file_sz,
+			 ulzman_scratch(comp_buf, s->comp_file_sz, decomp_buf, s->raw_file_sz,
+					scratchpad, LZMA_SCRATCHPAD_SIZE));
+	assert_memory_equal(raw_buf, decomp_buf, s->raw_file_sz);
+
+	test_free(raw_buf);
+	test_free(decomp_buf);
+	test_free(comp_buf);
+	test_free(scratchpad);
+}
+
+struct wait_state {
+	size_t valid;
+	size_t limit;
+	size_t calls;
+};
+
+/* Reveal the input in small steps, but never more than |limit| bytes. */
+static size_t wait_in_steps(void *arg, size_t needed)
+{
+	struct wait_state *w = arg;
+
+	w->calls++;
+	if (needed > w->valid)
+		w->valid = MIN(needed + 97, w->limit);
+
+	return w->valid;
+}
+
+static void test_ulzman_wait(void **state)
+{
+	struct lzma_test_state *s = *state;
+	uint8_t *raw_buf = test_malloc(s->raw_file_sz);
+	uint8_t *decomp_buf = test_malloc(s->raw_file_sz);
+	uint8_t *comp_buf = test_malloc(s->comp_file_sz);
+	struct wait_state w = { .limit = s->comp_file_sz };
+
+	assert_non_null(raw_buf);
+	assert_non_null(decomp_buf);
+	assert_non_null(comp_buf);
+	assert_int_equal(s->raw_file_sz,
+			 test_read_file(s->raw_filename, raw_buf, s->raw_file_sz));
+	assert_int_equal(s->comp_file_sz,
+			 test_read_file(s->comp_filename, comp_buf, s->comp_file_sz));
+
+	assert_int_equal(s->raw_file_sz, ulzman_wait(comp_buf, s->comp_file_sz, decomp_buf,
+						     s->raw_file_sz, wait_in_steps, &w));
+	assert_memory_equal(raw_buf, decomp_buf, s->raw_file_sz);
+	assert_true(w.calls > s->comp_file_sz / 100);
+
+	/* Input that stops arriving halfway must fail instead of reading past it. */
+	w = (struct wait_state){ .limit = s->comp_file_sz / 2 };
+	assert_int_equal(0, ulzman_wait(comp_buf, s->comp_file_sz, decomp_buf,
+					s->raw_file_sz, wait_in_steps, &w));
+	assert_in_range(w.valid, 0, s->comp_file_sz / 2);
+
+	test_free(raw_buf);
+	test_free(decomp_buf);
+	test_free(comp_buf);
+}
+
+struct stream_state {
+	const uint8_t *in;
+	size_t in_size;
+	size_t in_pos;
+	size_t piece;
+	uint8_t *out;
+	size_t out_size;
+	size_t out_pos;
+	size_t writes;
+};
+
+/* Hand out the input in pieces of odd sizes so the header gets split, too. */
+static size_t stream_read(void *arg, const void **buf)
+{
+	struct stream_state *st = arg;
+	size_t size = MIN(st->piece, st->in_size - st->in_pos);
+
+	*buf = st->in + st->in_pos;
+	st->in_pos += size;
+	st->piece = st->piece % 61 + 7;
+
+	return size;
+}
+
+static int stream_write(void *arg, const void *buf, size_t size)
+{
+	struct stream_state *st = arg;
+
+	st->writes++;
+	if (size > st->out_size - st->out_pos)
+		return -1;
+
+	memcpy(st->out + st->out_pos, buf, size);
+	st->out_pos += size;
+
+	return 0;
+}
+
+static void test_ulzman_stream(void **state)
+{
+	struct lzma_test_state *s = *state;
+	uint8_t *raw_buf = test_malloc(s->raw_file_sz);
+	uint8_t *decomp_buf = test_malloc(s->raw_file_sz);
+	uint8_t *comp_buf = test_malloc(s->comp_file_sz);
+	/* cbfs-compression-tool uses lc=1 and lp=0. */
+	uint8_t scratchpad[LZMA_SCRATCHPAD_SIZE_FOR(1)];
+	struct stream_state st = { .piece = 5 };
+	struct ulzma_stream stream = {
+		.read = stream_read,
+		.arg = &st,
+		.window = decomp_buf,
+		.window_size = s->raw_file_sz,
+		.scratchpad = scratchpad,
+		.scratchpad_size = sizeof(scratchpad),
+	};
+
+	assert_non_null(raw_buf);
+	assert_non_null(decomp_buf);
+	assert_non_null(comp_buf);
+	assert_int_equal(s->raw_file_sz,
+			 test_read_file(s->raw_filename, raw_buf, s->raw_file_sz));
+	assert_int_equal(s->comp_file_sz,
+			 test_read_file(s->comp_filename, comp_buf, s->comp_file_sz));
+	st.in = comp_buf;
+	st.in_size = s->comp_file_sz;
+
+	/* Without a write callback the window is the destination. */
+	assert_int_equal(s->raw_file_sz, ulzman_stream(&stream));
+	assert_memory_equal(raw_buf, decomp_buf, s->raw_file_sz);
+
+	/* Input that ends early must fail. */
+	st.in_pos = 0;
+	st.in_size = s->comp_file_sz / 2;
+	assert_int_equal(0, ulzman_stream(&stream));
+
+	test_free(raw_buf);
+	test_free(decomp_buf);
+	test_free(comp_buf);
+}
+
+static void test_ulzman_stream_window(void **state)
+{
+	struct lzma_test_state *s = *state;
+	uint8_t *raw_buf = test_malloc(s->raw_file_sz);
+	uint8_t *decomp_buf = test_malloc(s->raw_file_sz);
+	uint8_t *comp_buf = test_malloc(s->comp_file_sz);
+	uint8_t scratchpad[LZMA_SCRATCHPAD_SIZE_FOR(1)];
+	/* Matches the dictionary size the data was compressed with. */
+	uint8_t window[4 * KiB];
+	struct stream_state st = { .piece = 5 };
+	struct ulzma_stream stream = {
+		.read = stream_read,
+		.write = stream_write,
+		.arg = &st,
+		.window = window,
+		.window_size = sizeof(window),
+		.scratchpad = scratchpad,
+		.scratchpad_size = sizeof(scratchpad),
+	};
+
+	assert_non_null(raw_buf);
+	assert_non_null(decomp_buf);
+	assert_non_null(comp_buf);
+	assert_int_equal(s->raw_file_sz,
+			 test_read_file(s->raw_filename, raw_buf, s->raw_file_sz));
+	assert_int_equal(s->comp_file_sz,
+			 test_read_file(s->comp_filename, comp_buf, s->comp_file_sz));
+	st.in = comp_buf;
+	st.in_size = s->comp_file_sz;
+	st.out = decomp_buf;
+	st.out_size = s->raw_file_sz;
+
+	assert_int_equal(s->raw_file_sz, ulzman_stream(&stream));
+	assert_int_equal(s->raw_file_sz, st.out_pos);
+	assert_memory_equal(raw_buf, decomp_buf, s->raw_file_sz);
+	assert_int_equal(DIV_ROUND_UP(s->raw_file_sz, sizeof(window)), st.writes);
+
+	/* A window smaller than the dictionary can't resolve all matches. */
+	st = (struct stream_state){ .in = comp_buf, .in_size = s->comp_file_sz, .piece = 5,
+				    .out = decomp_buf, .out_size = s->raw_file_sz };
+	stream.window_size = 256;
+	assert_int_equal(0, ulzman_stream(&stream));
+
+	/* A failing write callback aborts the decoding. */
+	st = (struct stream_state){ .in = comp_buf, .in_size = s->comp_file_sz, .piece = 5,
+				    .out = decomp_buf, .out_size = sizeof(window) };
+	stream.window_size = sizeof(window);
+	assert_int_equal(0, ulzman_stream(&stream));
+
+	test_free(raw_buf);
+	test_free(decomp_buf);
+	test_free(comp_buf);
+}
+
 static void test_ulzman_input_too_small(void **state)
 {
 	uint8_t in_buf[32] = {0};
@@ -159,6 +375,32 @@ int main(void)
 		   Another binary file, shared object. */
 		ULZMAN_CORRECT_FILE_TEST("data.4"),
 
+		{
+			.name = "test_ulzman_scratch(data.2)",
+			.test_func = test_ulzman_scratch, .setup_func = setup_ulzman_file,
+			.teardown_func = teardown_ulzman_file, .initial_state = "data.2"
+		},
+
+		{
+			.name = "test_ulzman_wait(data.4)",
+			.test_func = test_ulzman_wait, .setup_func = setup_ulzman_file,
+			.teardown_func = teardown_ulzman_file, .initial_state = "data.4"
+		},
+
+		{
+			.name = "test_ulzman_stream(data.4)",
+			.test_func = test_ulzman_stream, .setup_func = setup_ulzman_file,
+			.teardown_func = teardown_ulzman_file, .initial_state = "data.4"
+		},
+
+		/* tests/lib/imd-test.c again, compressed with a 4KiB dictionary, lc=1, lp=0
+		   and pb=0 by Python's lzma module. */
+		{
+			.name = "test_ulzman_stream_window(data.5)",
+			.test_func = test_ulzman_stream_window, .setup_func = setup_ulzman_file,
+			.teardown_func = teardown_ulzman_file, .initial_state = "data.5"
+		},
+
 		cmocka_unit_test(test_ulzman_input_too_small),
 
 		cmocka_unit_test(test_ulzman_zero_buffer),
@@ -689,6 +689,56 @@ static void test_memrange_add_resources_filter(void **state)
 	memranges_teardown(&test_memrange);
 }
 
+/* This test verifies that inserting ranges in address order, which takes the short path
+   starting at the last inserted entry, still merges, splits and orders entries correctly. */
+static void test_memrange_ordered_insert(void **state)
+{
+	struct memranges test_memrange;
+	struct range_entry range_entries[8] = {0};
+	struct range_entry *ptr;
+	size_t i;
+	const struct {
+		resource_t base;
+		resource_t size;
+		unsigned long tag;
+	} expected[] = {
+		{ 0x0, 0x4000, CACHEABLE_TAG },
+		{ 0x4000, 0x1000, RESERVED_TAG },
+		{ 0x5000, 0x1000, CACHEABLE_TAG },
+		{ 0x8000, 0x1000, READONLY_TAG },
+		{ 0x9000, 0x3000, CACHEABLE_TAG },
+	};
+
+	memranges_init_empty(&test_memrange, &range_entries[0], ARRAY_SIZE(range_entries));
+
+	/* Adjacent ranges with the same tag collapse into one entry. */
+	for (i = 0; i < 6; i++)
+		memranges_insert(&test_memrange, i * 0x1000, 0x1000, CACHEABLE_TAG);
+	check_range_entries_count_and_alignment(&test_memrange, 1, MEMRANGE_ALIGN);
+
+	/* Splitting the last inserted entry, then continuing above it. */
+	memranges_insert(&test_memrange, 0x4000, 0x1000, RESERVED_TAG);
+	memranges_insert(&test_memrange, 0x8000, 0x1000, READONLY_TAG);
+	memranges_insert(&test_memrange, 0x9000, 0x2000, CACHEABLE_TAG);
+	memranges_insert(&test_memrange, 0xb000, 0x1000, CACHEABLE_TAG);
+
+	/* Going back below the last inserted entry. */
+	memranges_insert(&test_memrange, 0x6000, 0x2000, HOLE_TAG);
+	memranges_create_hole(&test_memrange, 0x6000, 0x2000);
+
+	i = 0;
+	memranges_each_entry(ptr, &test_memrange) {
+		assert_true(i < ARRAY_SIZE(expected));
+		assert_int_equal(range_entry_base(ptr), expected[i].base);
+		assert_int_equal(range_entry_size(ptr), expected[i].size);
+		assert_int_equal(range_entry_tag(ptr), expected[i].tag);
+		i++;
+	}
+	assert_int_equal(i, ARRAY_SIZE(expected));
+
+	memranges_teardown(&test_memrange);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -698,6 +748,7 @@ int main(void)
 		cmocka_unit_test(test_memrange_steal),
 		cmocka_unit_test(test_memrange_init_and_teardown),
 		cmocka_unit_test(test_memrange_add_resources_filter),
+		cmocka_unit_test(test_memrange_ordered_insert),
 	};
 
 	return cmocka_run_group_tests_name(__TEST_NAME__ "(Boundary on 4GiB)", tests,
@@ -289,6 +289,161 @@ static void test_region_file_update_data_arr(void **state)
 	assert_memory_equal(&dummy_data[data3_offset], &output_buffer[data2_size], data3_size);
 }
 
+static void test_region_file_data_history(void **state)
+{
+	struct region_device *rdev = *state;
+	struct region_file regf;
+	struct region_device read_rdev;
+	uint8_t data[3][64];
+	uint8_t output_buffer[64];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		memset(data[i], 'A' + i, sizeof(data[i]));
+
+	assert_int_equal(0, region_file_init(&regf, rdev));
+	assert_int_equal(-1, region_file_data_history(&regf, 0, &read_rdev));
+
+	/* Each update has a different size, so the boundaries can be told apart. */
+	for (i = 0; i < ARRAY_SIZE(data); i++)
+		assert_int_equal(0, region_file_update_data(&regf, data[i], 16 * (i + 1)));
+
+	/* Re-open to make sure the history comes from the stored metadata. */
+	assert_int_equal(0, region_file_init(&regf, rdev));
+
+	for (i = 0; i < ARRAY_SIZE(data); i++) {
+		const int idx = ARRAY_SIZE(data) - 1 - i;
+
+		assert_int_equal(0, region_file_data_history(&regf, i, &read_rdev));
+		assert_int_equal(16 * (idx + 1), region_device_sz(&read_rdev));
+		assert_int_equal(16 * (idx + 1), rdev_readat(&read_rdev, output_buffer, 0,
+							     16 * (idx + 1)));
+		assert_memory_equal(data[idx], output_buffer, 16 * (idx + 1));
+	}
+
+	assert_int_equal(-1, region_file_data_history(&regf, ARRAY_SIZE(data), &read_rdev));
+}
+
+static void test_region_file_update_fits(void **state)
+{
+	struct region_device *rdev = *state;
+	struct region_file regf;
+	struct region_device read_rdev;
+	uint8_t data[64];
+
+	memset(data, 'A', sizeof(data));
+
+	assert_int_equal(0, region_file_init(&regf, rdev));
+
+	/* Nothing to keep in an empty file. */
+	assert_int_equal(0, region_file_update_fits(&regf, sizeof(data)));
+
+	assert_int_equal(0, region_file_update_data(&regf, data, sizeof(data)));
+	assert_int_equal(1, region_file_update_fits(&regf, sizeof(data)));
+	assert_int_equal(0, region_file_update_fits(&regf, REGION_FILE_BUFFER_SIZE));
+
+	/* Fill up the region. The next update has to empty it, dropping the history. */
+	while (region_file_update_fits(&regf, sizeof(data)))
+		assert_int_equal(0, region_file_update_data(&regf, data, sizeof(data)));
+	assert_int_equal(0, region_file_data_history(&regf, 1, &read_rdev));
+	assert_int_equal(0, region_file_update_data(&regf, data, sizeof(data)));
+	assert_int_equal(-1, region_file_data_history(&regf, 1, &read_rdev));
+}
+
+#define FLASH_SIZE	(4 * REGF_ERASE_BLOCK_SIZE)
+
+static uint8_t flash[FLASH_SIZE];
+static size_t flash_erased_bytes;
+
+static void *flash_mmap(const struct region_device *rd, size_t offset, size_t size)
+{
+	return &flash[offset];
+}
+
+static int flash_munmap(const struct region_device *rd, void *mapping)
+{
+	return 0;
+}
+
+static ssize_t flash_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	memcpy(b, &flash[offset], size);
+	return size;
+}
+
+/* Like NOR flash, writes can only clear bits. */
+static ssize_t flash_writeat(const struct region_device *rd, const void *b, size_t offset,
+			     size_t size)
+{
+	const uint8_t *p = b;
+
+	for (size_t i = 0; i < size; i++)
+		flash[offset + i] &= p[i];
+	return size;
+}
+
+static ssize_t flash_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	memset(&flash[offset], 0xff, size);
+	flash_erased_bytes += size;
+	return size;
+}
+
+static const struct region_device_ops flash_ops = {
+	.mmap = flash_mmap,
+	.munmap = flash_munmap,
+	.readat = flash_readat,
+	.writeat = flash_writeat,
+	.eraseat = flash_eraseat,
+};
+
+static const struct region_device flash_rdev = REGION_DEV_INIT(&flash_ops, 0, FLASH_SIZE);
+
+static void test_region_file_erase_on_demand(void **state)
+{
+	struct region_device read_rdev;
+	struct region_file regf;
+	struct update_region_file_entry entries[2];
+	uint8_t header[24];
+	uint8_t data[1000];
+	uint8_t output_buffer[sizeof(header) + sizeof(data)];
+	size_t i, last_begin = 0;
+	int emptied = 0;
+
+	memset(flash, 0xff, sizeof(flash));
+	flash_erased_bytes = 0;
+
+	entries[0] = (struct update_region_file_entry){ .size = sizeof(header), .data = header };
+	entries[1] = (struct update_region_file_entry){ .size = sizeof(data), .data = data };
+
+	/* Enough updates to fill the region twice, each one after a reboot. */
+	for (i = 0; i < 40; i++) {
+		memset(header, 'a' + i % 26, sizeof(header));
+		memset(data, 'A' + i % 26, sizeof(data));
+
+		assert_int_equal(0, region_file_init(&regf, &flash_rdev));
+		assert_int_equal(0, region_file_update_data_arr(&regf, entries, 2));
+
+		/* Writes into blocks that weren't erased would have corrupted the data. */
+		assert_int_equal(0, region_file_init(&regf, &flash_rdev));
+		assert_int_equal(0, region_file_data(&regf, &read_rdev));
+		assert_int_equal(sizeof(output_buffer),
+				 rdev_readat(&read_rdev, output_buffer, 0, sizeof(output_buffer)));
+		assert_memory_equal(header, output_buffer, sizeof(header));
+		assert_memory_equal(data, &output_buffer[sizeof(header)], sizeof(data));
+
+		if (region_file_data_begin(&regf) < last_begin && !emptied++) {
+			/* Emptying only erased the first block, the update fits into it. */
+			assert_int_equal(REGF_ERASE_BLOCK_SIZE, flash_erased_bytes);
+			assert_int_not_equal(0xff, flash[2 * REGF_ERASE_BLOCK_SIZE]);
+		}
+		last_begin = region_file_data_begin(&regf);
+	}
+
+	assert_int_equal(2, emptied);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -322,6 +477,13 @@ int main(void)
 		cmocka_unit_test_setup_teardown(test_region_file_update_data_arr,
 						setup_teardown_region_file_test,
 						setup_teardown_region_file_test),
+		cmocka_unit_test_setup_teardown(test_region_file_data_history,
+						setup_teardown_region_file_test,
+						setup_teardown_region_file_test),
+		cmocka_unit_test_setup_teardown(test_region_file_update_fits,
+						setup_teardown_region_file_test,
+						setup_teardown_region_file_test),
+		cmocka_unit_test(test_region_file_erase_on_demand),
 	};
 
 	return cb_run_group_tests(tests, setup_region_file_test_group,
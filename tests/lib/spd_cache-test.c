@@ -125,12 +125,11 @@ static void test_spd_cache_is_valid(void **state)
 
 /* Used for setting `sn` parameter value */
 static u32 get_spd_sn_ret_sn[SC_SPD_NUMS] = {0};
-static size_t get_spd_sn_ret_sn_idx = 0;
 /* Implementation for testing purposes.  */
-enum cb_err get_spd_sn(u8 addr, u32 *sn)
+enum cb_err get_spd_sns(const struct spd_block *blk, u32 *sn)
 {
-	*sn = get_spd_sn_ret_sn[get_spd_sn_ret_sn_idx];
-	get_spd_sn_ret_sn_idx = (get_spd_sn_ret_sn_idx + 1) % ARRAY_SIZE(get_spd_sn_ret_sn);
+	for (int i = 0; i < SC_SPD_NUMS; ++i)
+		sn[i] = blk->addr_map[i] ? get_spd_sn_ret_sn[i] : 0xffffffff;
 
 	return mock_type(enum cb_err);
 }
@@ -154,8 +153,7 @@ __attribute__((unused)) static void test_check_if_dimm_changed_not_changed(void
 	assert_int_equal(CB_SUCCESS, spd_fill_from_cache(spd_cache, &blk));
 
 	get_sn_from_spd_cache(spd_cache, get_spd_sn_ret_sn);
-	get_spd_sn_ret_sn_idx = 0;
-	will_return_count(get_spd_sn, CB_SUCCESS, SC_SPD_NUMS);
+	will_return(get_spd_sns, CB_SUCCESS);
 	assert_false(check_if_dimm_changed(spd_cache, &blk));
 }
 
@@ -171,7 +169,7 @@ __attribute__((unused)) static void test_check_if_dimm_changed_sn_error(void **s
 	assert_int_equal(CB_SUCCESS, spd_fill_from_cache(spd_cache, &blk));
 
 	/* Simulate error */
-	will_return_count(get_spd_sn, CB_ERR, 1);
+	will_return(get_spd_sns, CB_ERR);
 	assert_true(check_if_dimm_changed(spd_cache, &blk));
 }
 
@@ -188,8 +186,7 @@ __attribute__((unused)) static void test_check_if_dimm_changed_sodimm_lost(void
 	get_sn_from_spd_cache(spd_cache, get_spd_sn_ret_sn);
 	memset(spd_cache + spd_data_ddr4_1_sz, 0xff, spd_data_ddr4_2_sz);
 
-	get_spd_sn_ret_sn_idx = 0;
-	will_return_always(get_spd_sn, CB_SUCCESS);
+	will_return_always(get_spd_sns, CB_SUCCESS);
 	assert_true(check_if_dimm_changed(spd_cache, &blk));
 }
 
@@ -207,8 +204,7 @@ __attribute__((unused)) static void test_check_if_dimm_changed_new_sodimm(void *
 	memcpy(spd_cache + spd_data_ddr4_1_sz + spd_data_ddr4_2_sz, spd_data_ddr4_2,
 	       spd_data_ddr4_2_sz);
 
-	get_spd_sn_ret_sn_idx = 0;
-	will_return_always(get_spd_sn, CB_SUCCESS);
+	will_return_always(get_spd_sns, CB_SUCCESS);
 	assert_true(check_if_dimm_changed(spd_cache, &blk));
 }
 
@@ -225,8 +221,7 @@ __attribute__((unused)) static void test_check_if_dimm_changed_sn_changed(void *
 	get_sn_from_spd_cache(spd_cache, get_spd_sn_ret_sn);
 	*(u32 *)(spd_cache + SC_SPD_OFFSET(0) + DDR4_SPD_SN_OFF) = 0x43211234;
 
-	get_spd_sn_ret_sn_idx = 0;
-	will_return_always(get_spd_sn, CB_SUCCESS);
+	will_return_always(get_spd_sns, CB_SUCCESS);
 	assert_true(check_if_dimm_changed(spd_cache, &blk));
 }
 
@@ -244,8 +239,7 @@ __attribute__((unused)) static void test_check_if_dimm_changed_with_nonexistent(
 	assert_int_equal(CB_SUCCESS, spd_fill_from_cache(spd_cache, &blk));
 
 	get_sn_from_spd_cache(spd_cache, get_spd_sn_ret_sn);
-	get_spd_sn_ret_sn_idx = 0;
-	will_return_always(get_spd_sn, CB_SUCCESS);
+	will_return_always(get_spd_sns, CB_SUCCESS);
 	assert_false(check_if_dimm_changed(spd_cache, &blk));
 }
 
@@ -9,6 +9,21 @@
 #define TIMESTAMP_REGION_SIZE (1 * KiB)
 TEST_REGION(timestamp, TIMESTAMP_REGION_SIZE);
 
+#define CBMEM_TABLE_SIZE \
+	(sizeof(struct timestamp_table) + MAX_TIMESTAMPS * sizeof(struct timestamp_entry))
+static u8 cbmem_tables[3][CBMEM_TABLE_SIZE];
+
+void *cbmem_add(u32 id, u64 size)
+{
+	size_t i = id == CBMEM_ID_TIMESTAMP ? 0 : id - CBMEM_ID_TIMESTAMPx + 1;
+
+	assert_int_equal(CBMEM_TABLE_SIZE, size);
+	if (i >= ARRAY_SIZE(cbmem_tables))
+		return NULL;
+
+	return cbmem_tables[i];
+}
+
 void test_timestamp_init(void **state)
 {
 	timestamp_init(1000);
@@ -96,6 +111,36 @@ void test_timestamp_rescale_table(void **state)
 				 glob_ts_table->entries[i].entry_stamp);
 }
 
+void test_timestamp_table_chain(void **state)
+{
+	/* The third table fills up and can't continue anywhere. */
+	const int count = 3 * MAX_TIMESTAMPS;
+	struct timestamp_table *ts_table;
+	int i, tables = 0, entries = 0;
+
+	timestamp_table_set(timestamp_alloc_cbmem_table(CBMEM_ID_TIMESTAMP));
+	ts_next_tables = 0;
+
+	for (i = 0; i < count; ++i)
+		timestamp_add(TS_ROMSTAGE_START, i);
+
+	timestamp_rescale_table(1, 2);
+
+	for (ts_table = glob_ts_table; ts_table; ts_table = timestamp_next_table(ts_table)) {
+		assert_ptr_equal(cbmem_tables[tables++], ts_table);
+		assert_int_equal(MAX_TIMESTAMPS, ts_table->num_entries);
+		for (i = 0; i < ts_table->num_entries; ++i) {
+			if (ts_table->entries[i].entry_id == TIMESTAMP_TABLE_CONTINUED)
+				continue;
+			assert_int_equal(entries / 2, ts_table->entries[i].entry_stamp);
+			entries++;
+		}
+	}
+
+	assert_int_equal(ARRAY_SIZE(cbmem_tables), tables);
+	assert_int_equal(3 * MAX_TIMESTAMPS - 2, entries);
+}
+
 void test_get_us_since_boot(void **state)
 {
 	const int base_multipler = 10000;
@@ -126,6 +171,7 @@ int main(void)
 		cmocka_unit_test_setup(test_timestamp_add, setup_timestamp_and_freq),
 		cmocka_unit_test_setup(test_timestamp_add_now, setup_timestamp_and_freq),
 		cmocka_unit_test_setup(test_timestamp_rescale_table, setup_timestamp_and_freq),
+		cmocka_unit_test_setup(test_timestamp_table_chain, setup_timestamp_and_freq),
 		cmocka_unit_test_setup(test_get_us_since_boot, setup_timestamp_and_freq),
 	};
 
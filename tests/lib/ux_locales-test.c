@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <cbfs.h>
+#include <commonlib/endian.h>
 #include <stdbool.h>
 #include <string.h>
 #include <tests/test.h>
@@ -35,7 +36,12 @@ const unsigned char data_default[] = DATA_DEFAULT;
  */
 #define DATA_DEFAULT_SIZE (sizeof(DATA_DEFAULT) - 1)
 
-#define MAX_DATA_SIZE (DATA_DEFAULT_SIZE + 1)
+/* Version 2 files put an index of all (name, lang) pairs in front of the strings. */
+#define INDEX_SIZE 16
+#define INDEX_ENTRY_SIZE 12
+#define INDEXED_HEADER_SIZE (3 + INDEX_SIZE * INDEX_ENTRY_SIZE)
+
+#define MAX_DATA_SIZE (INDEXED_HEADER_SIZE + DATA_DEFAULT_SIZE)
 struct {
 	unsigned char raw[MAX_DATA_SIZE];
 	size_t size;
@@ -93,6 +99,61 @@ static int setup_default(void **state)
 	return 0;
 }
 
+static uint32_t index_hash(const char *name, const char *id)
+{
+	uint32_t hash = 0x811c9dc5;
+
+	do
+		hash = (hash ^ (unsigned char)*name) * 0x01000193;
+	while (*name++);
+	while (*id)
+		hash = (hash ^ (unsigned char)*id++) * 0x01000193;
+
+	return hash;
+}
+
+/* Turn DATA_DEFAULT into a version 2 file the way the generator of the file does. */
+static int setup_indexed(void **state)
+{
+	const char *name, *id;
+	unsigned char *entry;
+	size_t offset, name_offset;
+	uint32_t hash, slot;
+
+	memset(data.raw, 0xff, MAX_DATA_SIZE);
+	memset(data.raw, 0, INDEXED_HEADER_SIZE);
+	data.raw[0] = 0x02;
+	write_le16(data.raw + 1, INDEX_SIZE);
+	/* Strings are the same as in version 1. Skip the version byte. */
+	memcpy(data.raw + INDEXED_HEADER_SIZE, data_default + 1, DATA_DEFAULT_SIZE - 1);
+	data.size = INDEXED_HEADER_SIZE + DATA_DEFAULT_SIZE - 1;
+
+	offset = INDEXED_HEADER_SIZE;
+	while (offset < data.size) {
+		name_offset = offset;
+		name = (const char *)data.raw + name_offset;
+		offset += strlen(name) + 1;
+		while (data.raw[offset] != 0x01) {
+			id = (const char *)data.raw + offset;
+			hash = index_hash(name, id);
+			for (slot = hash % INDEX_SIZE;; slot = (slot + 1) % INDEX_SIZE) {
+				entry = data.raw + 3 + slot * INDEX_ENTRY_SIZE;
+				if (!read_le32(entry + 8))
+					break;
+			}
+			write_le32(entry, hash);
+			write_le32(entry + 4, name_offset);
+			write_le32(entry + 8, offset);
+			/* Skip the language ID and its text. */
+			offset += strlen(id) + 1;
+			offset += strlen((const char *)data.raw + offset) + 1;
+		}
+		offset++;
+	}
+
+	return 0;
+}
+
 static int setup_bad_version(void **state)
 {
 	int ret = setup_default(state);
@@ -179,17 +240,37 @@ static void test_ux_locales_null_terminated(void **state)
 	assert_null(ux_locales_get_text("name_20"));
 }
 
+static void test_ux_locales_indexed_bad_offset(void **state)
+{
+	size_t slot;
+
+	will_return_always(_cbfs_alloc, true);
+	will_return_always(vb2api_get_locale_id, 8);
+
+	/* Point all name offsets out of the file, nothing may be found then. */
+	for (slot = 0; slot < INDEX_SIZE; slot++) {
+		if (read_le32(data.raw + 3 + slot * INDEX_ENTRY_SIZE + 8))
+			write_le32(data.raw + 3 + slot * INDEX_ENTRY_SIZE + 4, data.size);
+	}
+
+	assert_null(ux_locales_get_text("name_20"));
+}
+
 /*
  * This macro helps test ux_locales_get_text with `_name` and `_lang_id`.
  * If `_expect` is NULL, then the function should not find anything.
  * Otherwise, the function should find the corresponding expect value.
  */
 #define UX_LOCALES_GET_TEXT_TEST(_name, _lang_id, _expect)                                     \
+	_UX_LOCALES_GET_TEXT_TEST(setup_default, _name, _lang_id, _expect)
+#define UX_LOCALES_GET_TEXT_INDEXED_TEST(_name, _lang_id, _expect)                             \
+	_UX_LOCALES_GET_TEXT_TEST(setup_indexed, _name, _lang_id, _expect)
+#define _UX_LOCALES_GET_TEXT_TEST(_setup, _name, _lang_id, _expect)                            \
 	((struct CMUnitTest) {                                                                 \
-		.name = "test_ux_locales_get_text(name=" _name ", lang_id=" #_lang_id          \
-			", expect=" #_expect ")",                                              \
+		.name = "test_ux_locales_get_text(" #_setup ", name=" _name                    \
+			", lang_id=" #_lang_id ", expect=" #_expect ")",                       \
 		.test_func = test_ux_locales_get_text,                                         \
-		.setup_func = setup_default,                                                   \
+		.setup_func = _setup,                                                          \
 		.teardown_func = teardown_unmap,                                               \
 		.initial_state = &(struct ux_locales_test_state) {                             \
 			.name = _name,                                                         \
@@ -229,6 +310,19 @@ int main(void)
 		/* Validity check of NULL terminated. */
 		cmocka_unit_test_setup_teardown(test_ux_locales_null_terminated,
 						setup_default, teardown_unmap),
+		/* The same lookups through the index of a version 2 file. */
+		UX_LOCALES_GET_TEXT_INDEXED_TEST("name_1", 0, "translation_1_0"),
+		UX_LOCALES_GET_TEXT_INDEXED_TEST("name_15", 25, "translation_15_25"),
+		UX_LOCALES_GET_TEXT_INDEXED_TEST("name_20", 8, "translation_20_8"),
+		UX_LOCALES_GET_TEXT_INDEXED_TEST("name_2", 3, NULL),
+		UX_LOCALES_GET_TEXT_INDEXED_TEST("name_15", 2, NULL),
+		UX_LOCALES_GET_TEXT_INDEXED_TEST("name_1", 7, "translation_1_0"),
+		UX_LOCALES_GET_TEXT_INDEXED_TEST("name_15", 8, NULL),
+		UX_LOCALES_GET_TEXT_INDEXED_TEST("name_1", 100, "translation_1_0"),
+		cmocka_unit_test_setup_teardown(test_ux_locales_null_terminated,
+						setup_indexed, teardown_unmap),
+		cmocka_unit_test_setup_teardown(test_ux_locales_indexed_bad_offset,
+						setup_indexed, teardown_unmap),
 	};
 
 	return cb_run_group_tests(tests, NULL, NULL);
@@ -1581,6 +1581,39 @@ static bool is_initial_alignment_required(enum platform soc_id)
 	}
 }
 
+/*
+ * Writes the EFS and the body like main() does, but only the blocks that changed, and
+ * records the blobs for the next incremental run.
+ */
+static int write_incremental_output(context *ctx, amd_cb_config *cb_config)
+{
+	uint32_t offset = cb_config->efs_location;
+	uint32_t bytes = cb_config->efs_location == cb_config->body_location ?
+			ctx->current - offset : sizeof(embedded_firmware);
+	char body_name[PATH_MAX];
+
+	if (incremental_write(cb_config->output, offset, BUFF_OFFSET(*ctx, offset), bytes) !=
+	    bytes) {
+		fprintf(stderr, "Error: Writing to file %s failed\n", cb_config->output);
+		return 1;
+	}
+
+	if (cb_config->efs_location != cb_config->body_location) {
+		bytes = ctx->current - cb_config->body_location;
+		snprintf(body_name, sizeof(body_name), "%s%s", cb_config->output,
+			 BODY_FILE_SUFFIX);
+		if (incremental_write(body_name, cb_config->body_location,
+				      BUFF_OFFSET(*ctx, cb_config->body_location),
+				      bytes) != bytes) {
+			fprintf(stderr, "Error: Writing body\n");
+			return 1;
+		}
+	}
+
+	incremental_close(cb_config->output);
+	return 0;
+}
+
 int main(int argc, char **argv)
 {
 	int retval = 0;
@@ -1616,6 +1649,10 @@ int main(int argc, char **argv)
 	}
 	memset(ctx.rom, 0xFF, ctx.rom_size);
 
+	if (cb_config.incremental)
+		incremental_open(cb_config.output, ctx.rom, cb_config.efs_location,
+				 cb_config.body_location);
+
 	romsig_offset = cb_config.efs_location ? cb_config.efs_location : AMD_ROMSIG_OFFSET;
 	set_current_pointer(&ctx, romsig_offset);
 
@@ -1802,35 +1839,41 @@ int main(int argc, char **argv)
 	} while (cb_config.use_combo && ++combo_index < MAX_COMBO_ENTRIES &&
 					cb_config.combo_config[combo_index] != NULL);
 
-	targetfd = open(cb_config.output, O_RDWR | O_CREAT | O_TRUNC, 0666);
-	if (targetfd >= 0) {
-		uint32_t offset = cb_config.efs_location;
-		uint32_t bytes = cb_config.efs_location == cb_config.body_location ?
-				ctx.current - offset : sizeof(embedded_firmware);
-		uint32_t ret_bytes;
-
-		ret_bytes = write_from_buf_to_file(targetfd, BUFF_OFFSET(ctx, offset), bytes);
-		if (bytes != ret_bytes) {
-			fprintf(stderr, "Error: Writing to file %s failed\n", cb_config.output);
+	if (cb_config.incremental) {
+		retval = write_incremental_output(&ctx, &cb_config);
+	} else {
+		targetfd = open(cb_config.output, O_RDWR | O_CREAT | O_TRUNC, 0666);
+		if (targetfd >= 0) {
+			uint32_t offset = cb_config.efs_location;
+			uint32_t bytes = cb_config.efs_location == cb_config.body_location ?
+					ctx.current - offset : sizeof(embedded_firmware);
+			uint32_t ret_bytes;
+
+			ret_bytes = write_from_buf_to_file(targetfd, BUFF_OFFSET(ctx, offset),
+							   bytes);
+			if (bytes != ret_bytes) {
+				fprintf(stderr, "Error: Writing to file %s failed\n",
+					cb_config.output);
+				retval = 1;
+			}
+			close(targetfd);
+		} else {
+			fprintf(stderr, "Error: could not open file: %s\n", cb_config.output);
 			retval = 1;
 		}
-		close(targetfd);
-	} else {
-		fprintf(stderr, "Error: could not open file: %s\n", cb_config.output);
-		retval = 1;
-	}
 
-	if (cb_config.efs_location != cb_config.body_location) {
-		ssize_t bytes;
+		if (cb_config.efs_location != cb_config.body_location) {
+			ssize_t bytes;
 
-		bytes = write_body(cb_config.output, BUFF_OFFSET(ctx, cb_config.body_location),
-			ctx.current - cb_config.body_location);
-		if (bytes != ctx.current - cb_config.body_location) {
-			fprintf(stderr, "Error: Writing body\n");
-			retval = 1;
+			bytes = write_body(cb_config.output,
+					   BUFF_OFFSET(ctx, cb_config.body_location),
+					   ctx.current - cb_config.body_location);
+			if (bytes != ctx.current - cb_config.body_location) {
+				fprintf(stderr, "Error: Writing body\n");
+				retval = 1;
+			}
 		}
 	}
-
 	if (cb_config.manifest_file) {
 		dump_blob_version(cb_config.manifest_file, amd_psp_fw_table);
 	}
@@ -426,6 +426,7 @@ typedef struct _amd_cb_config {
 	bool need_ish;
 	bool use_combo;
 	bool have_apcb_bk;
+	bool incremental;
 	enum platform soc_id;
 
 	uint8_t efs_spi_readmode, efs_spi_speed, efs_spi_micron_flag;
@@ -469,12 +470,16 @@ int find_bios_entry(amd_bios_type type);
 #define EFS_FILE_SUFFIX ".efs"
 #define TMP_FILE_SUFFIX ".tmp"
 #define BODY_FILE_SUFFIX ".body"
+#define STATE_FILE_SUFFIX ".state"
 
 void write_or_fail(int fd, void *ptr, size_t size);
 ssize_t read_from_file_to_buf(int fd, void *buf, size_t buf_size);
 ssize_t write_from_buf_to_file(int fd, const void *buf, size_t buf_size);
 ssize_t write_body(char *output, void *body_offset, ssize_t body_size);
 ssize_t copy_blob(void *dest, const char *src_file, size_t room);
+void incremental_open(char *output, char *rom, uint32_t efs_location, uint32_t body_location);
+ssize_t incremental_write(const char *name, uint32_t location, const void *buf, size_t size);
+void incremental_close(char *output);
 #define OK 0
 
 #define LINE_EOF (1)
@@ -4,6 +4,7 @@
 #include <errno.h>
 #include <limits.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <string.h>
@@ -131,6 +132,304 @@ ssize_t write_body(char *output, void *body_offset, ssize_t body_size)
 	return bytes;
 }
 
+/*
+ * Incremental mode keeps a state file next to the output, which lists where each blob was
+ * placed and the size, modification time and inode of the file it came from. A blob whose
+ * file didn't change since is copied out of the previous output if it lands at the same
+ * place again, and only the blocks of the output that changed are written back.
+ */
+#define STATE_MAGIC "amdfwtool-state 1"
+#define UPDATE_BLOCK_SIZE 4096
+
+struct blob_state {
+	uint32_t offset;
+	off_t size;
+	struct timespec mtime;
+	ino_t ino;
+	char *path;
+};
+
+struct prev_file {
+	char *map;
+	size_t size;
+	uint32_t location;
+	struct stat st;
+};
+
+static struct {
+	bool active;
+	char *rom;
+	char *state_name;
+	uint32_t efs_location, body_location;
+	/* The output and the body as they were before this run */
+	struct prev_file prev[2];
+	struct blob_state *old;
+	size_t old_count;
+	struct blob_state *new;
+	size_t new_count;
+} incr;
+
+static bool same_stat_time(const struct timespec *a, const struct timespec *b)
+{
+	return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+static void map_prev_file(struct prev_file *prev, const char *name, uint32_t location)
+{
+	int fd;
+
+	memset(prev, 0, sizeof(*prev));
+	fd = open(name, O_RDONLY);
+	if (fd < 0)
+		return;
+	if (!fstat(fd, &prev->st) && S_ISREG(prev->st.st_mode) && prev->st.st_size > 0) {
+		prev->map = mmap(NULL, prev->st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (prev->map == MAP_FAILED)
+			prev->map = NULL;
+		else
+			prev->size = prev->st.st_size;
+	}
+	prev->location = location;
+	close(fd);
+}
+
+static void unmap_prev_files(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(incr.prev); i++) {
+		if (incr.prev[i].map)
+			munmap(incr.prev[i].map, incr.prev[i].size);
+		incr.prev[i].map = NULL;
+	}
+}
+
+static void free_blob_states(struct blob_state *states, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		free(states[i].path);
+	free(states);
+}
+
+/* Returns whether the previous files are the ones the state file describes. */
+static bool read_state(FILE *f)
+{
+	char line[PATH_MAX + 128];
+	unsigned int efs_location, body_location;
+	long long size[2], sec[2];
+	long nsec[2];
+
+	if (!fgets(line, sizeof(line), f) ||
+	    strncmp(line, STATE_MAGIC " ", strlen(STATE_MAGIC) + 1) ||
+	    sscanf(line + strlen(STATE_MAGIC), "%x %x %lld %lld.%ld %lld %lld.%ld",
+		   &efs_location, &body_location, &size[0], &sec[0], &nsec[0],
+		   &size[1], &sec[1], &nsec[1]) != 8)
+		return false;
+	if (efs_location != incr.efs_location || body_location != incr.body_location)
+		return false;
+	for (size_t i = 0; i < ARRAY_SIZE(incr.prev); i++) {
+		const struct prev_file *prev = &incr.prev[i];
+		if ((long long)prev->size != size[i] || prev->st.st_mtim.tv_sec != sec[i] ||
+		    prev->st.st_mtim.tv_nsec != nsec[i])
+			return false;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		struct blob_state state;
+		unsigned int offset;
+		long long blob_size, blob_sec, ino;
+		long blob_nsec;
+		int path_start;
+		char *nl = strchr(line, '\n');
+
+		if (!nl)
+			return false;
+		*nl = '\0';
+		if (sscanf(line, "%x %llx %lld.%ld %lld %n", &offset, &blob_size, &blob_sec,
+			   &blob_nsec, &ino, &path_start) != 5)
+			return false;
+		state.offset = offset;
+		state.size = blob_size;
+		state.mtime.tv_sec = blob_sec;
+		state.mtime.tv_nsec = blob_nsec;
+		state.ino = ino;
+		state.path = strdup(line + path_start);
+		struct blob_state *old = realloc(incr.old, (incr.old_count + 1) * sizeof(*old));
+		if (!state.path || !old) {
+			free(state.path);
+			return false;
+		}
+		incr.old = old;
+		incr.old[incr.old_count++] = state;
+	}
+	return true;
+}
+
+void incremental_open(char *output, char *rom, uint32_t efs_location, uint32_t body_location)
+{
+	char body_name[PATH_MAX];
+	FILE *f;
+
+	memset(&incr, 0, sizeof(incr));
+	if (asprintf(&incr.state_name, "%s%s", output, STATE_FILE_SUFFIX) < 0 ||
+	    snprintf(body_name, sizeof(body_name), "%s%s", output, BODY_FILE_SUFFIX) >=
+			(int)sizeof(body_name)) {
+		fprintf(stderr, "Error: Output file name too long, ignoring --incremental\n");
+		free(incr.state_name);
+		incr.state_name = NULL;
+		return;
+	}
+	incr.active = true;
+	incr.rom = rom;
+	incr.efs_location = efs_location;
+	incr.body_location = body_location;
+
+	map_prev_file(&incr.prev[0], output, efs_location);
+	if (efs_location != body_location)
+		map_prev_file(&incr.prev[1], body_name, body_location);
+	else
+		memset(&incr.prev[1], 0, sizeof(incr.prev[1]));
+
+	f = fopen(incr.state_name, "r");
+	if (f && !read_state(f)) {
+		/* Something else changed the previous output, it can't be used. */
+		free_blob_states(incr.old, incr.old_count);
+		incr.old = NULL;
+		incr.old_count = 0;
+	}
+	if (f)
+		fclose(f);
+	/* The state is only valid again once the new output is complete. */
+	unlink(incr.state_name);
+}
+
+/* Copies a blob out of the previous output if its file didn't change since. */
+static bool copy_unchanged_blob(void *dest, const char *src_file, const struct stat *st)
+{
+	const uint32_t offset = (char *)dest - incr.rom;
+
+	for (size_t i = 0; i < incr.old_count; i++) {
+		const struct blob_state *old = &incr.old[i];
+
+		if (old->offset != offset || strcmp(old->path, src_file) ||
+		    old->size != st->st_size || old->ino != st->st_ino ||
+		    !same_stat_time(&old->mtime, &st->st_mtim))
+			continue;
+
+		for (size_t j = 0; j < ARRAY_SIZE(incr.prev); j++) {
+			const struct prev_file *prev = &incr.prev[j];
+
+			if (prev->map && offset >= prev->location &&
+			    offset - prev->location + (size_t)st->st_size <= prev->size) {
+				memcpy(dest, prev->map + offset - prev->location, st->st_size);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static void record_blob(void *dest, const char *src_file, const struct stat *st)
+{
+	struct blob_state *states = realloc(incr.new, (incr.new_count + 1) * sizeof(*states));
+	char *path = strdup(src_file);
+
+	if (!states || !path) {
+		/* Without the entry the blob is read again next time, that's all. */
+		free(path);
+		if (states)
+			incr.new = states;
+		return;
+	}
+	incr.new = states;
+	incr.new[incr.new_count++] = (struct blob_state) {
+		.offset = (char *)dest - incr.rom,
+		.size = st->st_size,
+		.mtime = st->st_mtim,
+		.ino = st->st_ino,
+		.path = path,
+	};
+}
+
+/* Writes only the blocks of a file that differ from its previous contents. */
+ssize_t incremental_write(const char *name, uint32_t location, const void *buf, size_t size)
+{
+	const struct prev_file *prev = NULL;
+	size_t off;
+	int fd;
+
+	for (size_t i = 0; i < ARRAY_SIZE(incr.prev); i++)
+		if (incr.prev[i].map && incr.prev[i].location == location)
+			prev = &incr.prev[i];
+
+	fd = open(name, O_RDWR | O_CREAT, 0666);
+	if (fd < 0) {
+		fprintf(stderr, "Error: Opening %s file: %s\n", name, strerror(errno));
+		return -1;
+	}
+
+	for (off = 0; off < size; off += UPDATE_BLOCK_SIZE) {
+		const size_t len = MIN(size - off, (size_t)UPDATE_BLOCK_SIZE);
+
+		if (prev && off + len <= prev->size && !memcmp(prev->map + off, buf + off, len))
+			continue;
+		if (pwrite(fd, buf + off, len, off) != (ssize_t)len) {
+			fprintf(stderr, "Write failure %s\n", strerror(errno));
+			close(fd);
+			return -1;
+		}
+	}
+
+	if (ftruncate(fd, size)) {
+		fprintf(stderr, "Error: Truncating %s: %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	close(fd);
+
+	return size;
+}
+
+/* Records the blobs of the new output for the next run, once it is complete. */
+void incremental_close(char *output)
+{
+	char body_name[PATH_MAX], tmp_name[PATH_MAX];
+	struct stat st[2] = { 0 };
+	FILE *f;
+
+	if (!incr.active)
+		return;
+	unmap_prev_files();
+
+	snprintf(body_name, sizeof(body_name), "%s%s", output, BODY_FILE_SUFFIX);
+	snprintf(tmp_name, sizeof(tmp_name), "%s%s", incr.state_name, TMP_FILE_SUFFIX);
+	if (stat(output, &st[0]))
+		goto out;
+	if (incr.efs_location != incr.body_location && stat(body_name, &st[1]))
+		goto out;
+
+	f = fopen(tmp_name, "w");
+	if (!f)
+		goto out;
+	fprintf(f, STATE_MAGIC " %x %x", incr.efs_location, incr.body_location);
+	for (size_t i = 0; i < ARRAY_SIZE(st); i++)
+		fprintf(f, " %lld %lld.%09ld", (long long)st[i].st_size,
+			(long long)st[i].st_mtim.tv_sec, st[i].st_mtim.tv_nsec);
+	fputc('\n', f);
+	for (size_t i = 0; i < incr.new_count; i++) {
+		const struct blob_state *state = &incr.new[i];
+		fprintf(f, "%x %llx %lld.%09ld %lld %s\n", state->offset,
+			(long long)state->size, (long long)state->mtime.tv_sec,
+			state->mtime.tv_nsec, (long long)state->ino, state->path);
+	}
+	if (fclose(f) || rename(tmp_name, incr.state_name))
+		unlink(tmp_name);
+
+out:
+	free_blob_states(incr.old, incr.old_count);
+	free_blob_states(incr.new, incr.new_count);
+	free(incr.state_name);
+	memset(&incr, 0, sizeof(incr));
+}
+
 ssize_t copy_blob(void *dest, const char *src_file, size_t room)
 {
 	int fd;
@@ -156,6 +455,12 @@ ssize_t copy_blob(void *dest, const char *src_file, size_t room)
 		return -3;
 	}
 
+	if (incr.active && copy_unchanged_blob(dest, src_file, &fd_stat)) {
+		close(fd);
+		record_blob(dest, src_file, &fd_stat);
+		return fd_stat.st_size;
+	}
+
 	bytes = read(fd, dest, (size_t)fd_stat.st_size);
 	close(fd);
 	if (bytes != (ssize_t)fd_stat.st_size) {
@@ -163,5 +468,8 @@ ssize_t copy_blob(void *dest, const char *src_file, size_t room)
 		return -4;
 	}
 
+	if (incr.active)
+		record_blob(dest, src_file, &fd_stat);
+
 	return bytes;
 }
@@ -61,6 +61,7 @@ enum {
 	AMDFW_OPT_SIGNED_OUTPUT,
 	AMDFW_OPT_SIGNED_ADDR,
 	AMDFW_OPT_BODY_LOCATION,
+	AMDFW_OPT_INCREMENTAL,
 	/* begin after ASCII characters */
 	LONGOPT_SPI_READ_MODE	= 256,
 	LONGOPT_SPI_SPEED	= 257,
@@ -123,6 +124,7 @@ static struct option long_options[] = {
 	{"anywhere",         no_argument,       0, AMDFW_OPT_ANYWHERE },
 	{"sharedmem",        required_argument, 0, AMDFW_OPT_SHAREDMEM },
 	{"sharedmem-size",   required_argument, 0, AMDFW_OPT_SHAREDMEM_SIZE },
+	{"incremental",            no_argument, 0, AMDFW_OPT_INCREMENTAL },
 
 	{"signed-output",           required_argument, 0, AMDFW_OPT_SIGNED_OUTPUT },
 	{"signed-addr",           required_argument, 0, AMDFW_OPT_SIGNED_ADDR },
@@ -181,6 +183,8 @@ static void usage(void)
 	printf("--sharedmem-size               Maximum size of the PSP/FW shared memory\n");
 	printf("                               area\n");
 	printf("--output-manifest <FILE>       Writes a manifest with the blobs versions\n");
+	printf("--incremental                  Update an existing output, only reading the\n");
+	printf("                               blobs that changed since it was written\n");
 	printf("\nEmbedded Firmware Structure options used by the PSP:\n");
 	printf("--spi-speed <HEX_VAL>          SPI fast speed to place in EFS Table\n");
 	printf("                               0x0 66.66Mhz\n");
@@ -557,6 +561,9 @@ int amdfwtool_getopt(int argc, char *argv[], amd_cb_config *cb_config, context *
 		case AMDFW_OPT_ANYWHERE:
 			any_location = 1;
 			break;
+		case AMDFW_OPT_INCREMENTAL:
+			cb_config->incremental = true;
+			break;
 		case AMDFW_OPT_SHAREDMEM:
 			/* shared memory destination */
 			register_bios_fw_addr(AMD_BIOS_PSP_SHARED_MEM, 0, optarg, 0);
@@ -328,15 +328,13 @@ static Elf64_Phdr **find_loadable_segments(struct parsed_elf *pelf)
 	return phdrs;
 }
 
-int parse_elf_to_xip_stage(const struct buffer *input, struct buffer *output,
-			   uint32_t location, const char *ignore_sections,
-			   struct cbfs_file_attr_stageheader *stageheader)
+int parse_elf_to_xip_program(const struct buffer *input, const char *ignore_sections,
+			     struct xip_stage *xip)
 {
 	struct xip_context xipctx;
 	struct rmod_context *rmodctx;
 	struct reloc_filter filter;
 	struct parsed_elf *pelf;
-	uint32_t adjustment, memsz = 0;
 	struct buffer binput;
 	struct buffer boutput;
 	Elf64_Phdr **toload, **phdr;
@@ -344,6 +342,7 @@ int parse_elf_to_xip_stage(const struct buffer *input, struct buffer *output,
 	int ret = -1;
 	size_t filesz = 0;
 
+	memset(xip, 0, sizeof(*xip));
 	rmodctx = &xipctx.rmodctx;
 	pelf = &rmodctx->pelf;
 
@@ -370,27 +369,22 @@ int parse_elf_to_xip_stage(const struct buffer *input, struct buffer *output,
 	if (!toload)
 		goto out;
 
-	for (phdr = toload; *phdr; phdr++)
+	for (phdr = toload; *phdr; phdr++) {
 		filesz += (*phdr)->p_filesz;
-	if (buffer_create(output, filesz, input->name) != 0) {
+		xip->memsz += (*phdr)->p_memsz;
+	}
+	for (i = 0; i < pelf->ehdr.e_phnum; i++)
+		if (pelf->phdr[i].p_type == PT_LOAD)
+			xip->align = MAX(xip->align, pelf->phdr[i].p_align);
+
+	if (buffer_create(&xip->program, filesz, input->name) != 0) {
 		ERROR("Unable to allocate memory: %m\n");
-		goto out;
+		goto out_free;
 	}
-	buffer_clone(&boutput, output);
+	buffer_clone(&boutput, &xip->program);
 	memset(buffer_get(&boutput), 0, filesz);
 	buffer_set_size(&boutput, 0);
 
-	/* The program segment moves to final location from based on virtual
-	 * address of loadable segment. */
-	adjustment = location - pelf->phdr->p_vaddr;
-	DEBUG("Relocation adjustment: %08x\n", adjustment);
-
-	for (phdr = toload; *phdr; phdr++)
-		memsz += (*phdr)->p_memsz;
-	fill_cbfs_stageheader(stageheader,
-			      (uint32_t)pelf->ehdr.e_entry + adjustment,
-			      (uint32_t)pelf->phdr->p_vaddr + adjustment,
-			      memsz);
 	for (phdr = toload; *phdr; phdr++) {
 		/* Need an adjustable buffer. */
 		buffer_clone(&binput, input);
@@ -398,20 +392,57 @@ int parse_elf_to_xip_stage(const struct buffer *input, struct buffer *output,
 		bputs(&boutput, buffer_get(&binput), (*phdr)->p_filesz);
 	}
 
-	buffer_clone(&boutput, output);
+	xip->entry = pelf->ehdr.e_entry;
+	xip->loadaddr = pelf->phdr->p_vaddr;
+
+	/* The relocations represent in-program addresses of the linked program. Keep the
+	 * offsets into the program, which don't depend on the final location. */
+	xip->relocs = calloc(MAX(1, rmodctx->nrelocs), sizeof(*xip->relocs));
+	if (!xip->relocs) {
+		ERROR("Unable to allocate memory: %m\n");
+		buffer_delete(&xip->program);
+		goto out_free;
+	}
+	for (i = 0; i < rmodctx->nrelocs; i++)
+		xip->relocs[i] = rmodctx->emitted_relocs[i] - pelf->phdr->p_vaddr;
+	xip->nrelocs = rmodctx->nrelocs;
+
+	ret = 0;
+
+out_free:
+	free(toload);
+out:
+	rmodule_cleanup(rmodctx);
+	return ret;
+}
+
+int link_xip_stage(const struct xip_stage *xip, struct buffer *output, uint32_t location,
+		   struct cbfs_file_attr_stageheader *stageheader)
+{
+	uint32_t adjustment;
+	size_t i;
+
+	if (buffer_create(output, buffer_size(&xip->program), xip->program.name) != 0) {
+		ERROR("Unable to allocate memory: %m\n");
+		return -1;
+	}
+	memcpy(buffer_get(output), buffer_get(&xip->program), buffer_size(&xip->program));
+
+	/* The program segment moves to final location from based on virtual
+	 * address of loadable segment. */
+	adjustment = location - xip->loadaddr;
+	DEBUG("Relocation adjustment: %08x\n", adjustment);
+
+	fill_cbfs_stageheader(stageheader, xip->entry + adjustment,
+			      xip->loadaddr + adjustment, xip->memsz);
 
 	/* Make adjustments to all the relocations within the program. */
-	for (i = 0; i < rmodctx->nrelocs; i++) {
-		size_t reloc_offset;
+	for (i = 0; i < xip->nrelocs; i++) {
+		size_t reloc_offset = xip->relocs[i];
 		uint32_t val;
 		struct buffer in, out;
 
-		/* The relocations represent in-program addresses of the
-		 * linked program. Obtain the offset into the program to do
-		 * the adjustment. */
-		reloc_offset = rmodctx->emitted_relocs[i] - pelf->phdr->p_vaddr;
-
-		buffer_clone(&out, &boutput);
+		buffer_clone(&out, output);
 		buffer_seek(&out, reloc_offset);
 		buffer_clone(&in, &out);
 		/* Appease around xdr semantics: xdr decrements buffer
@@ -424,9 +455,27 @@ int parse_elf_to_xip_stage(const struct buffer *input, struct buffer *output,
 		xdr_le.put32(&out, val + adjustment);
 	}
 
-	ret = 0;
+	return 0;
+}
 
-out:
-	rmodule_cleanup(rmodctx);
+void xip_stage_cleanup(struct xip_stage *xip)
+{
+	buffer_delete(&xip->program);
+	free(xip->relocs);
+	memset(xip, 0, sizeof(*xip));
+}
+
+int parse_elf_to_xip_stage(const struct buffer *input, struct buffer *output,
+			   uint32_t location, const char *ignore_sections,
+			   struct cbfs_file_attr_stageheader *stageheader)
+{
+	struct xip_stage xip;
+	int ret;
+
+	if (parse_elf_to_xip_program(input, ignore_sections, &xip))
+		return -1;
+
+	ret = link_xip_stage(&xip, output, location, stageheader);
+	xip_stage_cleanup(&xip);
 	return ret;
 }
@@ -8,6 +8,7 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <pthread.h>
 #include "common.h"
 #include "cbfs.h"
 #include "cbfs_image.h"
@@ -18,6 +19,7 @@
 #include <commonlib/bsd/cbfs_private.h>
 #include <commonlib/bsd/compression.h>
 #include <commonlib/bsd/metadata_hash.h>
+#include <commonlib/cbfs_trace_serialized.h>
 #include <commonlib/fsp.h>
 #include <commonlib/endian.h>
 #include <commonlib/helpers.h>
@@ -37,7 +39,7 @@ struct command {
 	bool modifies_region;
 };
 
-static struct param {
+struct param {
 	partitioned_file_t *image_file;
 	struct buffer *image_region;
 	const char *name;
@@ -108,16 +110,27 @@ static struct param {
 	 */
 	uint32_t ext_win_base;
 	uint32_t ext_win_size;
-} param = {
-	/* All variables not listed are initialized as zero. */
-	.arch = CBFS_ARCHITECTURE_UNKNOWN,
-	.compression = CBFS_COMPRESS_NONE,
-	.hash = VB2_HASH_INVALID,
-	.headeroffset = HEADER_OFFSET_UNKNOWN,
-	.region_name = SECTION_NAME_PRIMARY_CBFS,
-	.u64val = -1,
+	/* Number of threads used by the batch command */
+	unsigned int jobs;
+	bool optimize_layout;
 };
 
+#define PARAM_DEFAULTS {						\
+	/* All variables not listed are initialized as zero. */		\
+	.arch = CBFS_ARCHITECTURE_UNKNOWN,				\
+	.compression = CBFS_COMPRESS_NONE,				\
+	.hash = VB2_HASH_INVALID,					\
+	.headeroffset = HEADER_OFFSET_UNKNOWN,				\
+	.region_name = SECTION_NAME_PRIMARY_CBFS,			\
+	.u64val = -1,							\
+}
+
+/*
+ * Thread local, so that the worker threads of the batch command can each convert a file
+ * with its own set of parameters.
+ */
+static _Thread_local struct param param = PARAM_DEFAULTS;
+
 /*
  * This "metadata_hash cache" caches the value and location of the CBFS metadata
  * hash embedded in the bootblock when CBFS verification is enabled. The first
@@ -852,6 +865,32 @@ static int add_topswap_bootblock(struct buffer *buffer, uint32_t *offset)
 	return convert_region_offset(buffer_size(buffer), offset);
 }
 
+/*
+ * One line of a batch manifest. Loading and converting (i.e. compressing) the file doesn't
+ * depend on the image, so that step runs in a worker thread and the result is kept here
+ * until the file is placed into the image, in manifest order.
+ */
+struct batch_entry {
+	size_t command;
+	unsigned int line;
+	struct param param;
+	/* Whether the file can be converted before the preceding entries were added */
+	bool prepare;
+	/* Set while a worker thread runs the command, to stop it before the placement */
+	bool preparing;
+	bool prepared;
+	int ret;
+	struct buffer buffer;
+	struct cbfs_file *header;
+	uint32_t offset;
+	/* XIP stages are parsed by the worker, but only linked once they have a location. */
+	bool xip_parsed;
+	struct xip_stage xip;
+};
+
+/* The batch entry the current thread is working on, if any. */
+static _Thread_local struct batch_entry *batch_entry;
+
 static int cbfs_add_component(const char *filename,
 			      const char *name,
 			      uint32_t headeroffset,
@@ -902,25 +941,66 @@ static int cbfs_add_component(const char *filename,
 		return 1;
 	}
 
+	const bool preparing = batch_entry && batch_entry->preparing;
 	struct cbfs_image image;
-	if (cbfs_image_from_buffer(&image, param.image_region, headeroffset))
-		return 1;
+	if (!preparing) {
+		if (cbfs_image_from_buffer(&image, param.image_region, headeroffset))
+			return 1;
 
-	if (cbfs_get_entry(&image, name)) {
-		ERROR("'%s' already in ROM image.\n", name);
-		return 1;
+		if (cbfs_get_entry(&image, name)) {
+			ERROR("'%s' already in ROM image.\n", name);
+			return 1;
+		}
 	}
 
 	struct buffer buffer;
-	if (buffer_from_file(&buffer, filename) != 0) {
-		ERROR("Could not load file '%s'.\n", filename);
-		return 1;
-	}
+	struct cbfs_file *header;
+	if (batch_entry && batch_entry->prepared) {
+		/* A batch worker already loaded and converted the file. */
+		buffer = batch_entry->buffer;
+		header = batch_entry->header;
+		offset = batch_entry->offset;
+		batch_entry->prepared = false;
+
+		if (batch_entry->xip_parsed && convert(&buffer, &offset, header) != 0) {
+			ERROR("Failed to parse file '%s'.\n", filename);
+			goto error;
+		}
+	} else {
+		if (buffer_from_file(&buffer, filename) != 0) {
+			ERROR("Could not load file '%s'.\n", filename);
+			return 1;
+		}
 
-	struct cbfs_file *header =
-		cbfs_create_file_header(param.type, buffer.size, name);
-	if (!header)
-		goto error;
+		header = cbfs_create_file_header(param.type, buffer.size, name);
+		if (!header)
+			goto error;
+
+		/*
+		 * Check if Intel CPU topswap is specified this will require a
+		 * second bootblock to be added.
+		 */
+		if (param.type == CBFS_TYPE_BOOTBLOCK && param.topswap_size)
+			if (add_topswap_bootblock(&buffer, &offset))
+				goto error;
+
+		/* With --base-address we allow host space addresses -- if so, convert it here. */
+		if (IS_HOST_SPACE_ADDRESS(offset))
+			offset = convert_addr_space(param.image_region, offset);
+
+		if (convert && convert(&buffer, &offset, header) != 0) {
+			ERROR("Failed to parse file '%s'.\n", filename);
+			goto error;
+		}
+
+		if (preparing) {
+			batch_entry->buffer = buffer;
+			batch_entry->header = header;
+			batch_entry->offset = offset;
+			batch_entry->prepared = true;
+			return 0;
+		}
+	}
 
 	/* Bootblock and CBFS header should never have file hashes. When adding
 	   the bootblock it is important that we *don't* look up the metadata
@@ -939,23 +1019,6 @@ static int cbfs_add_component(const char *filename,
 		}
 	}
 
-	/*
-	 * Check if Intel CPU topswap is specified this will require a
-	 * second bootblock to be added.
-	 */
-	if (param.type == CBFS_TYPE_BOOTBLOCK && param.topswap_size)
-		if (add_topswap_bootblock(&buffer, &offset))
-			goto error;
-
-	/* With --base-address we allow host space addresses -- if so, convert it here. */
-	if (IS_HOST_SPACE_ADDRESS(offset))
-		offset = convert_addr_space(param.image_region, offset);
-
-	if (convert && convert(&buffer, &offset, header) != 0) {
-		ERROR("Failed to parse file '%s'.\n", filename);
-		goto error;
-	}
-
 	/* This needs to run after convert() to take compression into account. */
 	if (!offset && param.alignment)
 		if (do_cbfs_locate(&offset, buffer_size(&buffer)))
@@ -1156,25 +1219,32 @@ static int cbfstool_convert_mkstage(struct buffer *buffer, uint32_t *offset,
 	struct cbfs_file *header)
 {
 	struct buffer output;
+	struct xip_stage local_xip;
+	struct xip_stage *xip = batch_entry ? &batch_entry->xip : &local_xip;
 	int ret;
 
+	if (param.stage_xip && !(batch_entry && batch_entry->xip_parsed)) {
+		if (parse_elf_to_xip_program(buffer, param.ignore_sections, xip))
+			return -1;
+
+		/* Linking the stage needs its location, which the placement decides. */
+		if (batch_entry && batch_entry->preparing) {
+			batch_entry->xip_parsed = true;
+			return 0;
+		}
+	}
+
 	/*
-	 * We need a final location for XIP parsing, so we need to call do_cbfs_locate() early
+	 * We need a final location for XIP linking, so we need to call do_cbfs_locate() early
 	 * here. That is okay because XIP stages may not be compressed, so their size cannot
 	 * change anymore at a later point.
 	 */
 	if (param.stage_xip) {
-		size_t data_size, alignment;
-		if (elf_program_file_size_align(buffer, &data_size, &alignment) < 0) {
-			ERROR("Could not obtain ELF size & alignment\n");
-			return 1;
-		}
-
-		param.alignment = MAX(alignment, param.alignment);
+		param.alignment = MAX(xip->align, param.alignment);
 
-		if (do_cbfs_locate(offset, data_size)) {
+		if (do_cbfs_locate(offset, buffer_size(&xip->program))) {
 			ERROR("Could not find location for stage.\n");
-			return 1;
+			goto fail_xip;
 		}
 	}
 
@@ -1182,13 +1252,15 @@ static int cbfstool_convert_mkstage(struct buffer *buffer, uint32_t *offset,
 		cbfs_add_file_attr(header, CBFS_FILE_ATTR_TAG_STAGEHEADER,
 				   sizeof(struct cbfs_file_attr_stageheader));
 	if (!stageheader)
-		return -1;
+		goto fail_xip;
 
 	if (param.stage_xip) {
 		uint32_t host_space_address = convert_addr_space(param.image_region, *offset);
 		assert(IS_HOST_SPACE_ADDRESS(host_space_address));
-		ret = parse_elf_to_xip_stage(buffer, &output, host_space_address,
-					     param.ignore_sections, stageheader);
+		ret = link_xip_stage(xip, &output, host_space_address, stageheader);
+		xip_stage_cleanup(xip);
+		if (batch_entry)
+			batch_entry->xip_parsed = false;
 	} else {
 		ret = parse_elf_to_stage(buffer, &output, param.ignore_sections,
 					 stageheader);
@@ -1238,6 +1310,14 @@ static int cbfstool_convert_mkstage(struct buffer *buffer, uint32_t *offset,
 fail:
 	buffer_delete(&output);
 	return -1;
+
+fail_xip:
+	if (param.stage_xip) {
+		xip_stage_cleanup(xip);
+		if (batch_entry)
+			batch_entry->xip_parsed = false;
+	}
+	return -1;
 }
 
 static int cbfstool_convert_mkpayload(struct buffer *buffer,
@@ -1357,6 +1437,119 @@ static int cbfs_add_flat_binary(void)
 				  cbfstool_convert_mkflatpayload);
 }
 
+/*
+ * Turns the output of `cbmem -P` into the prefetch hints: the files each stage accessed in the
+ * order of the first access, limited to the files that are in this image.
+ */
+static int cbfstool_convert_prefetch_hints(struct buffer *buffer,
+	unused uint32_t *offset, struct cbfs_file *header)
+{
+	struct cbfs_access_record *records = NULL;
+	struct cbfs_image image;
+	struct buffer output;
+	size_t count = 0, i, n;
+	char *line, *saveptr;
+
+	if (cbfs_image_from_buffer(&image, param.image_region, param.headeroffset))
+		return -1;
+
+	/* The trace is text, make sure that it is terminated. */
+	char *text = malloc(buffer->size + 1);
+	if (!text)
+		return -1;
+	memcpy(text, buffer->data, buffer->size);
+	text[buffer->size] = '\0';
+
+	for (line = strtok_r(text, "\n", &saveptr); line;
+	     line = strtok_r(NULL, "\n", &saveptr)) {
+		struct cbfs_access_record rec = { 0 };
+		char *size_str, *name, *end;
+		struct cbfs_file *entry;
+
+		if (line[0] == '#')
+			continue;
+
+		size_str = strchr(line, '\t');
+		name = size_str ? strchr(size_str + 1, '\t') : NULL;
+		if (!name) {
+			ERROR("Malformed CBFS trace line '%s'\n", line);
+			goto fail;
+		}
+		*size_str++ = '\0';
+		*name++ = '\0';
+		end = name + strlen(name);
+		while (end > name && (end[-1] == '\r' || end[-1] == ' '))
+			*--end = '\0';
+		strtoul(size_str, &end, 0);
+		if (*end != '\0') {
+			ERROR("Malformed size '%s' in CBFS trace\n", size_str);
+			goto fail;
+		}
+
+		if (strlen(line) >= sizeof(rec.stage) || strlen(name) >= sizeof(rec.name) ||
+		    !strcmp(name, param.name))
+			continue;
+		entry = cbfs_get_entry(&image, name);
+		if (!entry) {
+			WARN("'%s' from the CBFS trace is not in the image\n", name);
+			continue;
+		}
+
+		strcpy(rec.stage, line);
+		strcpy(rec.name, name);
+		for (i = 0; i < count; i++) {
+			if (!strcmp(records[i].stage, rec.stage) &&
+			    !strcmp(records[i].name, rec.name))
+				break;
+		}
+		if (i < count)
+			continue;
+
+		/* Take the size from the image, the files may have changed since the trace. */
+		write_le32(&rec.size, be32toh(entry->len));
+
+		struct cbfs_access_record *tmp = realloc(records, (count + 1) * sizeof(*records));
+		if (!tmp)
+			goto fail;
+		records = tmp;
+		records[count++] = rec;
+	}
+
+	n = sizeof(struct cbfs_prefetch_hints) + count * sizeof(*records);
+	if (buffer_create(&output, n, buffer->name) != 0)
+		goto fail;
+	struct cbfs_prefetch_hints *hints = (struct cbfs_prefetch_hints *)output.data;
+	write_le32(&hints->magic, CBFS_PREFETCH_HINTS_MAGIC);
+	write_le32(&hints->num_records, count);
+	if (count)
+		memcpy(hints->records, records, count * sizeof(*records));
+	INFO("%zu prefetch hints\n", count);
+
+	free(records);
+	free(text);
+	buffer_delete(buffer);
+	// Direct assign, no dupe.
+	memcpy(buffer, &output, sizeof(*buffer));
+	header->len = htobe32(output.size);
+	return 0;
+
+fail:
+	free(records);
+	free(text);
+	return -1;
+}
+
+static int cbfs_add_prefetch_hints(void)
+{
+	if (!param.name)
+		param.name = CBFS_PREFETCH_HINTS_NAME;
+	param.type = CBFS_TYPE_RAW;
+	return cbfs_add_component(param.filename,
+				  param.name,
+				  param.headeroffset,
+				  cbfstool_convert_prefetch_hints);
+}
+
 static int cbfs_add_integer(void)
 {
 	if (!param.u64val_assigned) {
@@ -1787,6 +1980,8 @@ static int cbfs_truncate(void)
 	return result;
 }
 
+static int cbfs_batch(void);
+
 static const struct command commands[] = {
 	{"add", "H:r:f:n:t:c:b:a:p:yvA:j:gh?", cbfs_add, true, true},
 	{"add-flat-binary", "H:r:f:n:l:e:c:b:p:vA:gh?", cbfs_add_flat_binary,
@@ -1796,7 +1991,9 @@ static const struct command commands[] = {
 	{"add-stage", "a:H:r:f:n:t:c:b:P:QS:p:yvA:gh?", cbfs_add_stage,
 				true, true},
 	{"add-int", "H:r:i:n:b:vgh?", cbfs_add_integer, true, true},
+	{"add-prefetch-hints", "H:r:f:n:vh?", cbfs_add_prefetch_hints, true, true},
 	{"add-master-header", "H:r:vh?j:", cbfs_add_master_header, true, true},
+	{"batch", "r:f:J:vh?", cbfs_batch, true, true},
 	{"compact", "r:h?", cbfs_compact, true, true},
 	{"copy", "r:R:h?", cbfs_copy, true, true},
 	{"create", "M:r:s:B:b:H:o:m:vh?", cbfs_create, true, true},
@@ -1815,6 +2012,7 @@ enum {
 	LONGOPT_START = 256,
 	LONGOPT_IBB = LONGOPT_START,
 	LONGOPT_MMAP,
+	LONGOPT_OPTIMIZE_LAYOUT,
 	LONGOPT_END,
 };
 
@@ -1840,6 +2038,7 @@ static struct option long_options[] = {
 	{"ignore-sec",    required_argument, 0, 'S' },
 	{"initrd",        required_argument, 0, 'I' },
 	{"int",           required_argument, 0, 'i' },
+	{"jobs",          required_argument, 0, 'J' },
 	{"load-address",  required_argument, 0, 'l' },
 	{"machine",       required_argument, 0, 'm' },
 	{"name",          required_argument, 0, 'n' },
@@ -1857,6 +2056,7 @@ static struct option long_options[] = {
 	{"unprocessed",   no_argument,       0, 'U' },
 	{"ibb",           no_argument,       0, LONGOPT_IBB },
 	{"mmap",          required_argument, 0, LONGOPT_MMAP },
+	{"optimize-layout", no_argument,     0, LONGOPT_OPTIMIZE_LAYOUT },
 	{NULL,            0,                 0,  0  }
 };
 
@@ -1989,9 +2189,14 @@ static void usage(char *name)
 			"Add a 32bit flat mode binary\n"
 	     " add-int [-r image,regions] -i INTEGER -n NAME [-b base]     "
 			"Add a raw 64-bit integer value\n"
+	     " add-prefetch-hints [-r image,regions] -f TRACE [-n NAME]   "
+			"Add prefetch hints from a `cbmem -P` trace\n"
 	     " add-master-header [-r image,regions] \\                   \n"
 	     "        [-j topswap-size] (Intel CPUs only)                  "
 			"Add a legacy CBFS master header\n"
+	     " batch [-r image,regions] -f MANIFEST [-J jobs] \\\n"
+	     "        [--optimize-layout]                                  "
+			"Run the commands listed in MANIFEST (- for stdin)\n"
 	     " remove [-r image,regions] -n NAME                           "
 			"Remove a component\n"
 	     " compact -r image,regions                                    "
@@ -2065,251 +2270,674 @@ static bool valid_opt(size_t i, int c)
 	return false;
 }
 
-int main(int argc, char **argv)
+/*
+ * Parses the options for commands[i] into param. Also used for the lines of a batch
+ * manifest, with the command name in argv[0].
+ */
+static int parse_options(size_t i, int argc, char **argv)
 {
-	size_t i;
 	int c;
 
-	if (argc < 3) {
-		usage(argv[0]);
-		return 1;
-	}
-
-	char *image_name = argv[1];
-	char *cmd = argv[2];
-	optind += 2;
+	while (1) {
+		char *suffix = NULL;
+		int option_index = 0;
 
-	for (i = 0; i < ARRAY_SIZE(commands); i++) {
-		if (strcmp(cmd, commands[i].name) != 0)
-			continue;
+		c = getopt_long(argc, argv, commands[i].optstring,
+					long_options, &option_index);
+		if (c == -1) {
+			if (optind < argc) {
+				ERROR("%s: excessive argument -- '%s'"
+					"\n", argv[0], argv[optind]);
+				return 1;
+			}
+			break;
+		}
 
-		while (1) {
-			char *suffix = NULL;
-			int option_index = 0;
+		/* Filter out illegal long options */
+		if (!valid_opt(i, c)) {
+			ERROR("%s: invalid option -- '%d'\n",
+			      argv[0], c);
+			c = '?';
+		}
 
-			c = getopt_long(argc, argv, commands[i].optstring,
-						long_options, &option_index);
-			if (c == -1) {
-				if (optind < argc) {
-					ERROR("%s: excessive argument -- '%s'"
-						"\n", argv[0], argv[optind]);
-					return 1;
-				}
+		switch(c) {
+		case 'n':
+			param.name = optarg;
+			break;
+		case 't':
+			if (intfiletype(optarg) != ((uint64_t) - 1))
+				param.type = intfiletype(optarg);
+			else
+				param.type = strtoul(optarg, NULL, 0);
+			if (param.type == 0)
+				WARN("Unknown type '%s' ignored\n",
+						optarg);
+			break;
+		case 'c': {
+			if (strcmp(optarg, "precompression") == 0) {
+				param.precompression = 1;
 				break;
 			}
-
-			/* Filter out illegal long options */
-			if (!valid_opt(i, c)) {
-				ERROR("%s: invalid option -- '%d'\n",
-				      argv[0], c);
-				c = '?';
+			int algo = cbfs_parse_comp_algo(optarg);
+			if (algo >= 0)
+				param.compression = algo;
+			else
+				WARN("Unknown compression '%s' ignored.\n",
+								optarg);
+			break;
+		}
+		case 'A': {
+			if (!vb2_lookup_hash_alg(optarg, &param.hash)) {
+				ERROR("Unknown hash algorithm '%s'.\n",
+					optarg);
+				return 1;
 			}
-
-			switch(c) {
-			case 'n':
-				param.name = optarg;
-				break;
-			case 't':
-				if (intfiletype(optarg) != ((uint64_t) - 1))
-					param.type = intfiletype(optarg);
-				else
-					param.type = strtoul(optarg, NULL, 0);
-				if (param.type == 0)
-					WARN("Unknown type '%s' ignored\n",
-							optarg);
-				break;
-			case 'c': {
-				if (strcmp(optarg, "precompression") == 0) {
-					param.precompression = 1;
-					break;
-				}
-				int algo = cbfs_parse_comp_algo(optarg);
-				if (algo >= 0)
-					param.compression = algo;
-				else
-					WARN("Unknown compression '%s' ignored.\n",
-									optarg);
-				break;
+			break;
+		}
+		case 'M':
+			param.fmap = optarg;
+			break;
+		case 'r':
+			param.region_name = optarg;
+			break;
+		case 'R':
+			param.source_region = optarg;
+			break;
+		case 'b':
+			param.baseaddress_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid base address '%s'.\n",
+					optarg);
+				return 1;
 			}
-			case 'A': {
-				if (!vb2_lookup_hash_alg(optarg, &param.hash)) {
-					ERROR("Unknown hash algorithm '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
+			// baseaddress may be zero on non-x86, so we
+			// need an explicit "baseaddress_assigned".
+			param.baseaddress_assigned = 1;
+			break;
+		case 'l':
+			param.loadaddress = strtoull(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid load address '%s'.\n",
+					optarg);
+				return 1;
 			}
-			case 'M':
-				param.fmap = optarg;
-				break;
-			case 'r':
-				param.region_name = optarg;
-				break;
-			case 'R':
-				param.source_region = optarg;
-				break;
-			case 'b':
-				param.baseaddress_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid base address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				// baseaddress may be zero on non-x86, so we
-				// need an explicit "baseaddress_assigned".
-				param.baseaddress_assigned = 1;
-				break;
-			case 'l':
-				param.loadaddress = strtoull(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid load address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'e':
-				param.entrypoint = strtoull(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid entry point '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 's':
-				param.size = strtoul(optarg, &suffix, 0);
-				if (!*optarg) {
-					ERROR("Empty size specified.\n");
-					return 1;
-				}
-				switch (tolower((int)suffix[0])) {
-				case 'k':
-					param.size *= 1024;
-					break;
-				case 'm':
-					param.size *= 1024 * 1024;
-					break;
-				case '\0':
-					break;
-				default:
-					ERROR("Invalid suffix for size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'B':
-				param.bootblock = optarg;
-				break;
-			case 'H':
-				param.headeroffset_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid header offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.headeroffset_assigned = 1;
-				break;
-			case 'a':
-				param.alignment = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid alignment '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'p':
-				param.padding = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid pad size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'Q':
-				param.force_pow2_pagesize = 1;
-				break;
-			case 'o':
-				param.cbfsoffset_input = strtoll(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid cbfs offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.cbfsoffset_assigned = 1;
-				break;
-			case 'f':
-				param.filename = optarg;
-				break;
-			case 'F':
-				param.force = 1;
-				break;
-			case 'i':
-				param.u64val = strtoull(optarg, &suffix, 0);
-				param.u64val_assigned = 1;
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid int parameter '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'u':
-				param.fill_partial_upward = true;
-				break;
-			case 'd':
-				param.fill_partial_downward = true;
-				break;
-			case 'w':
-				param.show_immutable = true;
-				break;
-			case 'j':
-				param.topswap_size = strtol(optarg, NULL, 0);
-				if (!is_valid_topswap())
-					return 1;
-				break;
-			case 'q':
-				param.ucode_region = optarg;
-				break;
-			case 'v':
-				verbose++;
-				break;
-			case 'm':
-				param.arch = string_to_arch(optarg);
-				break;
-			case 'I':
-				param.initrd = optarg;
-				break;
-			case 'C':
-				param.cmdline = optarg;
-				break;
-			case 'S':
-				param.ignore_sections = optarg;
-				break;
-			case 'y':
-				param.stage_xip = true;
-				break;
-			case 'g':
-				param.autogen_attr = true;
-				break;
+			break;
+		case 'e':
+			param.entrypoint = strtoull(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid entry point '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 's':
+			param.size = strtoul(optarg, &suffix, 0);
+			if (!*optarg) {
+				ERROR("Empty size specified.\n");
+				return 1;
+			}
+			switch (tolower((int)suffix[0])) {
 			case 'k':
-				param.machine_parseable = true;
+				param.size *= 1024;
 				break;
-			case 'U':
-				param.unprocessed = true;
-				break;
-			case LONGOPT_IBB:
-				param.ibb = true;
+			case 'm':
+				param.size *= 1024 * 1024;
 				break;
-			case LONGOPT_MMAP:
-				if (decode_mmap_arg(optarg))
-					return 1;
+			case '\0':
 				break;
-			case 'h':
-			case '?':
-				usage(argv[0]);
-				return 1;
 			default:
+				ERROR("Invalid suffix for size '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'B':
+			param.bootblock = optarg;
+			break;
+		case 'H':
+			param.headeroffset_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid header offset '%s'.\n",
+					optarg);
+				return 1;
+			}
+			param.headeroffset_assigned = 1;
+			break;
+		case 'a':
+			param.alignment = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid alignment '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'p':
+			param.padding = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid pad size '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'Q':
+			param.force_pow2_pagesize = 1;
+			break;
+		case 'o':
+			param.cbfsoffset_input = strtoll(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid cbfs offset '%s'.\n",
+					optarg);
+				return 1;
+			}
+			param.cbfsoffset_assigned = 1;
+			break;
+		case 'f':
+			param.filename = optarg;
+			break;
+		case 'F':
+			param.force = 1;
+			break;
+		case 'i':
+			param.u64val = strtoull(optarg, &suffix, 0);
+			param.u64val_assigned = 1;
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid int parameter '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'u':
+			param.fill_partial_upward = true;
+			break;
+		case 'd':
+			param.fill_partial_downward = true;
+			break;
+		case 'w':
+			param.show_immutable = true;
+			break;
+		case 'j':
+			param.topswap_size = strtol(optarg, NULL, 0);
+			if (!is_valid_topswap())
+				return 1;
+			break;
+		case 'J':
+			param.jobs = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix) || !param.jobs) {
+				ERROR("Invalid number of jobs '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'q':
+			param.ucode_region = optarg;
+			break;
+		case 'v':
+			verbose++;
+			break;
+		case 'm':
+			param.arch = string_to_arch(optarg);
+			break;
+		case 'I':
+			param.initrd = optarg;
+			break;
+		case 'C':
+			param.cmdline = optarg;
+			break;
+		case 'S':
+			param.ignore_sections = optarg;
+			break;
+		case 'y':
+			param.stage_xip = true;
+			break;
+		case 'g':
+			param.autogen_attr = true;
+			break;
+		case 'k':
+			param.machine_parseable = true;
+			break;
+		case 'U':
+			param.unprocessed = true;
+			break;
+		case LONGOPT_IBB:
+			param.ibb = true;
+			break;
+		case LONGOPT_MMAP:
+			if (decode_mmap_arg(optarg))
+				return 1;
+			break;
+		case LONGOPT_OPTIMIZE_LAYOUT:
+			param.optimize_layout = true;
+			break;
+		case 'h':
+		case '?':
+			usage(argv[0]);
+			return 1;
+		default:
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/* Maximum number of arguments on one line of a batch manifest */
+#define BATCH_MAX_ARGS	64
+/* The LZ4HC compressor keeps its state on the stack, the default can be too small. */
+#define BATCH_STACK_SIZE	(8 * MiB)
+
+/*
+ * Splits a manifest line into arguments, in place. Arguments are separated by whitespace
+ * and can be put in double quotes to contain whitespace, a '#' at the start of an argument
+ * comments out the rest of the line. Returns the number of arguments, or -1 for a line
+ * with an open quote or too many arguments.
+ */
+static int batch_split_line(char *line, char **argv, int max_args)
+{
+	int argc = 0;
+	char *p = line;
+
+	while (1) {
+		while (isspace((unsigned char)*p))
+			p++;
+		if (!*p || *p == '#')
+			break;
+		if (argc == max_args)
+			return -1;
+
+		bool quoted = false;
+		char *arg = p;
+		argv[argc++] = arg;
+		while (*p && (quoted || !isspace((unsigned char)*p))) {
+			if (*p == '"')
+				quoted = !quoted;
+			else
+				*arg++ = *p;
+			p++;
+		}
+		if (quoted)
+			return -1;
+		if (*p)
+			p++;
+		*arg = '\0';
+	}
+
+	return argc;
+}
+
+static bool batch_can_prepare(size_t i)
+{
+	int (*function)(void) = commands[i].function;
+
+	if (function != cbfs_add && function != cbfs_add_stage &&
+	    function != cbfs_add_payload && function != cbfs_add_flat_binary)
+		return false;
+
+	/*
+	 * This needs the final location in the image to convert the file. XIP stages do too,
+	 * but only to link them, cbfstool_convert_mkstage() parses them before that.
+	 */
+	return !param.topswap_size;
+}
+
+/* Commands that run as they are during the placement. */
+static bool batch_can_run(size_t i)
+{
+	int (*function)(void) = commands[i].function;
+
+	return function == cbfs_add_integer || function == cbfs_remove ||
+	       function == cbfs_compact || function == cbfs_print;
+}
+
+/* Commands that depend on the files placed before them, which fixes the order. */
+static bool batch_is_barrier(size_t i)
+{
+	int (*function)(void) = commands[i].function;
+
+	return function == cbfs_remove || function == cbfs_compact || function == cbfs_print;
+}
+
+/*
+ * Parses one manifest line into a batch entry. The entry starts out with the default
+ * parameters, it only inherits the image and region from the batch command.
+ */
+static int batch_parse_line(struct batch_entry *entry, char *line)
+{
+	const struct param batch = param;
+	char *argv[BATCH_MAX_ARGS + 1];
+	size_t i;
+
+	int argc = batch_split_line(line, argv, BATCH_MAX_ARGS);
+	if (argc < 0) {
+		ERROR("%s:%u: Unterminated quote or too many arguments.\n",
+		      batch.filename, entry->line);
+		return 1;
+	}
+	argv[argc] = NULL;
+
+	for (i = 0; i < ARRAY_SIZE(commands); i++)
+		if (strcmp(argv[0], commands[i].name) == 0)
+			break;
+	if (i == ARRAY_SIZE(commands) || (!batch_can_prepare(i) && !batch_can_run(i))) {
+		ERROR("%s:%u: Command '%s' is not supported in a batch.\n",
+		      batch.filename, entry->line, argv[0]);
+		return 1;
+	}
+	if (batch.optimize_layout && batch_is_barrier(i)) {
+		ERROR("%s:%u: '%s' can't be used with --optimize-layout.\n",
+		      batch.filename, entry->line, argv[0]);
+		return 1;
+	}
+
+	param = (struct param)PARAM_DEFAULTS;
+	param.image_file = batch.image_file;
+	param.image_region = batch.image_region;
+	param.region_name = batch.region_name;
+
+	/* Restart getopt for the new argument vector. */
+	optind = 0;
+	int ret = parse_options(i, argc, argv);
+	if (!ret && param.region_name != batch.region_name) {
+		ERROR("%s:%u: Regions can only be selected for the whole batch.\n",
+		      batch.filename, entry->line);
+		ret = 1;
+	}
+	if (!ret)
+		ret = calculate_region_offsets();
+	/* The decode windows must be set up before the worker threads use them. */
+	if (!ret && param.baseaddress_assigned && IS_HOST_SPACE_ADDRESS(param.baseaddress))
+		create_mmap_windows();
+
+	entry->command = i;
+	entry->param = param;
+	entry->prepare = batch_can_prepare(i);
+
+	param = batch;
+	return ret;
+}
+
+/*
+ * With --optimize-layout, the files are placed in this order instead of manifest order:
+ *
+ * 0. Bootblocks, since the metadata hash in them is looked up when adding the others.
+ * 1. Files with a fixed location, everything else is laid out around them.
+ * 2. Files with an alignment requirement, the most strictly aligned first. Placing them
+ *    early keeps the gaps in front of them at the start of the free space, where the
+ *    remaining files fill them instead of leaving padding behind.
+ * 3. All other files, in manifest order. The manifest should list them in the order they
+ *    are loaded during boot, so that they end up next to each other.
+ */
+static int batch_placement_class(const struct batch_entry *entry)
+{
+	const struct param *p = &entry->param;
+
+	if (p->type == CBFS_TYPE_BOOTBLOCK)
+		return 0;
+	if (p->baseaddress_assigned || p->topswap_size)
+		return 1;
+	if (p->alignment || p->stage_xip)
+		return 2;
+	return 3;
+}
+
+static int batch_placement_cmp(const void *a, const void *b)
+{
+	const struct batch_entry *x = *(const struct batch_entry * const *)a;
+	const struct batch_entry *y = *(const struct batch_entry * const *)b;
+	int cx = batch_placement_class(x), cy = batch_placement_class(y);
+
+	if (cx != cy)
+		return cx - cy;
+	if (cx == 2 && x->param.alignment != y->param.alignment)
+		return x->param.alignment > y->param.alignment ? -1 : 1;
+	/* qsort() isn't stable, keep the manifest order for everything else. */
+	return x->line < y->line ? -1 : x->line > y->line;
+}
+
+struct batch_queue {
+	struct batch_entry *entries;
+	size_t count;
+	size_t next;
+	bool failed;
+	pthread_mutex_t lock;
+};
+
+static void *batch_worker(void *arg)
+{
+	struct batch_queue *queue = arg;
+
+	while (1) {
+		pthread_mutex_lock(&queue->lock);
+		size_t i = queue->next++;
+		bool done = queue->failed || i >= queue->count;
+		pthread_mutex_unlock(&queue->lock);
+		if (done)
+			break;
+
+		struct batch_entry *entry = &queue->entries[i];
+		if (!entry->prepare)
+			continue;
+
+		param = entry->param;
+		batch_entry = entry;
+		entry->preparing = true;
+		entry->ret = commands[entry->command].function();
+		entry->preparing = false;
+		batch_entry = NULL;
+		/* Keep anything the conversion decided, the placement needs it. */
+		entry->param = param;
+
+		if (entry->ret) {
+			pthread_mutex_lock(&queue->lock);
+			queue->failed = true;
+			pthread_mutex_unlock(&queue->lock);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Returns the contents of the manifest as a string, read from stdin if its name is "-".
+ */
+static char *batch_read_manifest(const char *filename)
+{
+	struct buffer manifest;
+	char *text;
+
+	if (strcmp(filename, "-") == 0) {
+		size_t size = 0, allocated = 0;
+
+		text = NULL;
+		do {
+			if (size + 1 >= allocated) {
+				allocated = MAX(4 * KiB, 2 * allocated);
+				char *grown = realloc(text, allocated);
+				if (!grown) {
+					free(text);
+					return NULL;
+				}
+				text = grown;
+			}
+			size += fread(text + size, 1, allocated - size - 1, stdin);
+		} while (!feof(stdin) && !ferror(stdin));
+
+		if (ferror(stdin)) {
+			ERROR("Could not read manifest from stdin.\n");
+			free(text);
+			return NULL;
+		}
+		text[size] = '\0';
+		return text;
+	}
+
+	if (buffer_from_file(&manifest, filename) != 0) {
+		ERROR("Could not load manifest '%s'.\n", filename);
+		return NULL;
+	}
+
+	text = malloc(buffer_size(&manifest) + 1);
+	if (text) {
+		memcpy(text, buffer_get(&manifest), buffer_size(&manifest));
+		text[buffer_size(&manifest)] = '\0';
+	}
+	buffer_delete(&manifest);
+	return text;
+}
+
+/*
+ * Runs the commands listed in a manifest file on one region, with only a single write
+ * of the image at the end. The files are loaded and compressed by a pool of worker threads
+ * first, then they are added to the image in manifest order so that the layout is the same
+ * as with one cbfstool invocation per line.
+ */
+static int cbfs_batch(void)
+{
+	const struct param batch = param;
+	struct batch_queue queue = { 0 };
+	struct batch_entry **order = NULL;
+	pthread_t *threads = NULL;
+	char *text = NULL;
+	size_t i;
+	int ret = 1;
+
+	if (!param.filename) {
+		ERROR("You need to specify -f/--filename.\n");
+		return 1;
+	}
+
+	/* The parameters of the entries point into the text, it has to stay around. */
+	text = batch_read_manifest(param.filename);
+	if (!text)
+		return 1;
+
+	unsigned int line = 0;
+	for (char *next, *cur = text; cur; cur = next) {
+		next = strchr(cur, '\n');
+		if (next)
+			*next++ = '\0';
+		line++;
+
+		char *p = cur;
+		while (isspace((unsigned char)*p))
+			p++;
+		if (!*p || *p == '#')
+			continue;
+
+		struct batch_entry *entries = realloc(queue.entries,
+					(queue.count + 1) * sizeof(*entries));
+		if (!entries)
+			goto out;
+		queue.entries = entries;
+
+		struct batch_entry *entry = &queue.entries[queue.count++];
+		memset(entry, 0, sizeof(*entry));
+		entry->line = line;
+		if (batch_parse_line(entry, cur))
+			goto out;
+	}
+
+	unsigned int jobs = param.jobs;
+	if (!jobs) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		jobs = cpus > 0 ? cpus : 1;
+	}
+	jobs = MAX(1, MIN(jobs, queue.count));
+
+	threads = calloc(jobs, sizeof(*threads));
+	if (!threads)
+		goto out;
+
+	/* The calling thread is one of the workers, the others are optional. */
+	pthread_attr_t attr;
+	unsigned int started = 0;
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, BATCH_STACK_SIZE);
+	while (started + 1 < jobs &&
+	       !pthread_create(&threads[started], &attr, batch_worker, &queue))
+		started++;
+	pthread_attr_destroy(&attr);
+	batch_worker(&queue);
+	for (unsigned int t = 0; t < started; t++)
+		pthread_join(threads[t], NULL);
+	pthread_mutex_destroy(&queue.lock);
+
+	if (queue.failed) {
+		for (i = 0; i < queue.count; i++) {
+			struct batch_entry *entry = &queue.entries[i];
+			if (entry->prepare && entry->ret) {
+				ERROR("%s:%u: Failed to prepare '%s'.\n", batch.filename,
+				      entry->line, entry->param.name ? entry->param.name : "");
 				break;
 			}
 		}
+		goto out;
+	}
+
+	order = calloc(MAX(1, queue.count), sizeof(*order));
+	if (!order)
+		goto out;
+	for (i = 0; i < queue.count; i++)
+		order[i] = &queue.entries[i];
+	if (batch.optimize_layout)
+		qsort(order, queue.count, sizeof(*order), batch_placement_cmp);
+
+	for (i = 0; i < queue.count; i++) {
+		struct batch_entry *entry = order[i];
+
+		param = entry->param;
+		batch_entry = entry;
+		entry->ret = commands[entry->command].function();
+		batch_entry = NULL;
+		param = batch;
+		if (entry->ret) {
+			ERROR("%s:%u: Failed to %s '%s'.\n", batch.filename, entry->line,
+			      commands[entry->command].name,
+			      entry->param.name ? entry->param.name : "");
+			goto out;
+		}
+	}
+
+	INFO("Ran %zu commands from '%s' using %u threads.\n", queue.count, batch.filename,
+	     started + 1);
+	ret = 0;
+
+out:
+	param = batch;
+	for (i = 0; i < queue.count; i++) {
+		if (queue.entries[i].prepared) {
+			free(queue.entries[i].header);
+			buffer_delete(&queue.entries[i].buffer);
+		}
+		if (queue.entries[i].xip_parsed)
+			xip_stage_cleanup(&queue.entries[i].xip);
+	}
+	free(queue.entries);
+	free(order);
+	free(threads);
+	free(text);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	size_t i;
+
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	char *image_name = argv[1];
+	char *cmd = argv[2];
+	optind += 2;
+
+	for (i = 0; i < ARRAY_SIZE(commands); i++) {
+		if (strcmp(cmd, commands[i].name) != 0)
+			continue;
+
+		if (parse_options(i, argc, argv))
+			return 1;
 
 		if (commands[i].function == cbfs_create) {
 			if (param.fmap) {
@@ -190,6 +190,27 @@ int parse_elf_to_xip_stage(const struct buffer *input, struct buffer *output,
 			   uint32_t location, const char *ignore_section,
 			   struct cbfs_file_attr_stageheader *stageheader);
 
+/*
+ * An XIP stage split into the part that doesn't depend on its final location, which is
+ * the expensive one, and the relocations that link_xip_stage() applies once the
+ * location is known.
+ */
+struct xip_stage {
+	struct buffer program;
+	uint32_t *relocs;	/* Offsets into program */
+	size_t nrelocs;
+	uint32_t entry;
+	uint32_t loadaddr;
+	uint32_t memsz;
+	size_t align;
+};
+int parse_elf_to_xip_program(const struct buffer *input, const char *ignore_sections,
+			     struct xip_stage *xip);
+/* location is TOP aligned. */
+int link_xip_stage(const struct xip_stage *xip, struct buffer *output, uint32_t location,
+		   struct cbfs_file_attr_stageheader *stageheader);
+void xip_stage_cleanup(struct xip_stage *xip);
+
 void print_supported_architectures(void);
 void print_supported_filetypes(void);
 
@@ -198,6 +219,9 @@ int do_lzma_compress(char *in, int in_len, char *out, int *out_len);
 int do_lzma_uncompress(char *dst, int dst_len, char *src, int src_len,
 			size_t *actual_size);
 
+/* zstd_compress.c */
+int do_zstd_compress(char *in, int in_len, char *out, int *out_len);
+
 /* xdr.c */
 struct xdr {
 	uint8_t (*get8)(struct buffer *input);
@@ -1,14 +1,126 @@
 /* compression handling for cbfstool */
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <inttypes.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "common.h"
 #include "lz4/lib/lz4frame.h"
+#include "lz4/lib/xxhash.h"
 #include <commonlib/bsd/compression.h>
 
-static int lz4_compress(char *in, int in_len, char *out, int *out_len)
+/*
+ * If this environment variable names a directory, compression results are kept there and
+ * reused when the same data is compressed with the same algorithm again. The file names
+ * contain a hash of the input, but a cached result is only used after decompressing it
+ * and comparing it against the input, so a hash collision can't produce a broken image.
+ */
+#define COMPRESSION_CACHE_ENV "CBFSTOOL_COMPRESSION_CACHE"
+
+/* Bump this when a compressor changes its output, so that old results aren't reused. */
+#define COMPRESSION_CACHE_VERSION 1
+
+static bool compression_cache_lookup(const char *path, enum cbfs_compression algo,
+				     char *in, int in_len, char *out, int *out_len)
+{
+	decomp_func_ptr decompress = decompression_function(algo);
+	bool hit = false;
+	char *check = NULL;
+	size_t actual_size;
+
+	FILE *fp = fopen(path, "rb");
+	if (!fp)
+		return false;
+
+	long size = -1;
+	if (!fseek(fp, 0, SEEK_END))
+		size = ftell(fp);
+	if (size <= 0 || size > in_len || fseek(fp, 0, SEEK_SET) ||
+	    fread(out, 1, size, fp) != (size_t)size)
+		goto out;
+
+	check = malloc(in_len);
+	if (!check || !decompress)
+		goto out;
+
+	if (!decompress(out, size, check, in_len, &actual_size) &&
+	    actual_size == (size_t)in_len && !memcmp(check, in, in_len)) {
+		DEBUG("Using cached compression result %s\n", path);
+		*out_len = size;
+		hit = true;
+	} else {
+		WARN("Ignoring mismatching compression cache file %s\n", path);
+	}
+
+out:
+	free(check);
+	fclose(fp);
+	return hit;
+}
+
+/* Writes to a temporary file first, concurrent builds may look for the same result. */
+static void compression_cache_store(const char *path, char *out, int out_len)
+{
+	size_t len = strlen(path) + sizeof(".XXXXXX");
+	char *tmp = malloc(len);
+	if (!tmp)
+		return;
+	snprintf(tmp, len, "%s.XXXXXX", path);
+
+	int fd = mkstemp(tmp);
+	if (fd < 0) {
+		WARN("Could not create compression cache file %s\n", tmp);
+		free(tmp);
+		return;
+	}
+
+	FILE *fp = fdopen(fd, "wb");
+	bool ok = fp && fwrite(out, 1, out_len, fp) == (size_t)out_len;
+	if (fp)
+		ok = !fclose(fp) && ok;
+	else
+		close(fd);
+
+	if (!ok || rename(tmp, path)) {
+		WARN("Could not write compression cache file %s\n", path);
+		unlink(tmp);
+	}
+	free(tmp);
+}
+
+static int cached_compress(enum cbfs_compression algo, comp_func_ptr compress,
+			   char *in, int in_len, char *out, int *out_len)
+{
+	const char *dir = getenv(COMPRESSION_CACHE_ENV);
+	int ret;
+
+	if (!dir || !*dir || in_len <= 0)
+		return compress(in, in_len, out, out_len);
+
+	uint64_t hash = XXH64(in, in_len, 0);
+	size_t len = snprintf(NULL, 0, "%s/%016" PRIx64 "-%x-%d-v%d", dir, hash, in_len,
+			      algo, COMPRESSION_CACHE_VERSION) + 1;
+	char *path = malloc(len);
+	if (!path)
+		return compress(in, in_len, out, out_len);
+	snprintf(path, len, "%s/%016" PRIx64 "-%x-%d-v%d", dir, hash, in_len, algo,
+		 COMPRESSION_CACHE_VERSION);
+
+	if (compression_cache_lookup(path, algo, in, in_len, out, out_len)) {
+		free(path);
+		return 0;
+	}
+
+	ret = compress(in, in_len, out, out_len);
+	if (!ret)
+		compression_cache_store(path, out, *out_len);
+	free(path);
+	return ret;
+}
+
+static int do_lz4_compress(char *in, int in_len, char *out, int *out_len)
 {
 	LZ4F_preferences_t prefs = {
 		.compressionLevel = 20,
@@ -32,6 +144,11 @@ static int lz4_compress(char *in, int in_len, char *out, int *out_len)
 	return 0;
 }
 
+static int lz4_compress(char *in, int in_len, char *out, int *out_len)
+{
+	return cached_compress(CBFS_COMPRESS_LZ4, do_lz4_compress, in, in_len, out, out_len);
+}
+
 static int lz4_decompress(char *in, int in_len, char *out, int out_len,
 			  size_t *actual_size)
 {
@@ -45,7 +162,8 @@ static int lz4_decompress(char *in, int in_len, char *out, int out_len,
 
 static int lzma_compress(char *in, int in_len, char *out, int *out_len)
 {
-	return do_lzma_compress(in, in_len, out, out_len);
+	return cached_compress(CBFS_COMPRESS_LZMA, do_lzma_compress, in, in_len, out,
+			       out_len);
 }
 
 static int lzma_decompress(char *in, int in_len, char *out, unused int out_len,
@@ -53,6 +171,24 @@ static int lzma_decompress(char *in, int in_len, char *out, unused int out_len,
 {
 	return do_lzma_uncompress(out, out_len, in, in_len, actual_size);
 }
+
+static int zstd_compress(char *in, int in_len, char *out, int *out_len)
+{
+	return cached_compress(CBFS_COMPRESS_ZSTD, do_zstd_compress, in, in_len, out,
+			       out_len);
+}
+
+static int zstd_decompress(char *in, int in_len, char *out, int out_len,
+			   size_t *actual_size)
+{
+	size_t result = uzstdn(in, in_len, out, out_len);
+	if (result == 0)
+		return -1;
+	if (actual_size != NULL)
+		*actual_size = result;
+	return 0;
+}
+
 static int none_compress(char *in, int in_len, char *out, int *out_len)
 {
 	memcpy(out, in, in_len);
@@ -82,6 +218,9 @@ comp_func_ptr compression_function(enum cbfs_compression algo)
 	case CBFS_COMPRESS_LZ4:
 		compress = lz4_compress;
 		break;
+	case CBFS_COMPRESS_ZSTD:
+		compress = zstd_compress;
+		break;
 	default:
 		ERROR("Unknown compression algorithm %d!\n", algo);
 		return NULL;
@@ -102,6 +241,9 @@ decomp_func_ptr decompression_function(enum cbfs_compression algo)
 	case CBFS_COMPRESS_LZ4:
 		decompress = lz4_decompress;
 		break;
+	case CBFS_COMPRESS_ZSTD:
+		decompress = zstd_decompress;
+		break;
 	default:
 		ERROR("Unknown compression algorithm %d!\n", algo);
 		return NULL;
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <common.h>
@@ -35,6 +36,7 @@ enum elogtool_return {
 static int cmd_list(const struct buffer *, enum elogtool_flag);
 static int cmd_clear(const struct buffer *, enum elogtool_flag);
 static int cmd_add(const struct buffer *, enum elogtool_flag);
+static int cmd_export(const struct buffer *, enum elogtool_flag);
 
 static const struct {
 	const char *name;
@@ -45,15 +47,31 @@ static const struct {
 	{"list", cmd_list, false},
 	{"clear", cmd_clear, true},
 	{"add", cmd_add, true},
+	{"export", cmd_export, false},
 };
 
 static char **cmd_argv;		/* Command arguments */
 static char *argv0;		/* Used as invoked_as */
 
+/* Events that list and export show. Everything is matched unless restricted. */
+static struct {
+	bool any_type;
+	bool types[256];
+	bool has_since;
+	time_t since;
+	bool has_until;
+	time_t until;
+} filter = {
+	.any_type = true,
+};
+
 static struct option long_options[] = {
 	{"file", required_argument, 0, 'f'},
 	{"help", no_argument, 0, 'h'},
 	{"utc", no_argument, 0, 'U'},
+	{"type", required_argument, 0, 't'},
+	{"since", required_argument, 0, 's'},
+	{"until", required_argument, 0, 'e'},
 	{NULL, 0, 0, 0},
 };
 
@@ -66,12 +84,20 @@ static void usage(char *invoked_as)
 			"  list                          lists all the event logs in human readable format\n"
 			"  clear                         clears all the event logs\n"
 			"  add <event_type> [event_data] add an entry to the event log\n"
+			"  export <csv|binary>           writes the event logs to stdout as CSV or\n"
+			"                                as a raw event log\n"
 			"\n"
 			"ARGS\n"
 			"-f, --file <filename>   File that holds event log partition.\n"
 			"                        If empty it will try to read/write from/to\n"
 			"                        the " ELOG_RW_REGION_NAME " using flashrom.\n"
 			"-U, --utc               Print timestamps in UTC time zone\n"
+			"-t, --type <types>      Only list/export events of these comma separated\n"
+			"                        hexadecimal types\n"
+			"-s, --since <time>      Only list/export events from this time on\n"
+			"-e, --until <time>      Only list/export events up to this time\n"
+			"                        <time> is seconds since the epoch or\n"
+			"                        \"YYYY-MM-DD[ HH:MM:SS]\", in local time unless -U\n"
 			"-h, --help              Print this help\n",
 			invoked_as);
 }
@@ -193,6 +219,38 @@ static int shrink_buffer(const struct buffer *buf, size_t bytes_to_shrink)
 	return ELOGTOOL_EXIT_SUCCESS;
 }
 
+/* Returns whether event is a complete event in buf, as opposed to the end of the log. */
+static bool event_is_valid(const struct buffer *buf, const struct event_header *event)
+{
+	return (const void *)event + sizeof(*event) < buffer_end(buf)
+		&& event->length > sizeof(*event)
+		&& event->length <= ELOG_MAX_EVENT_SIZE
+		&& (const void *)event + event->length < buffer_end(buf)
+		&& event->type != ELOG_TYPE_EOL;
+}
+
+/*
+ * Checks an event against the filter. Only the header is looked at, so that events
+ * which are filtered out cost no more than walking over them.
+ */
+static bool event_matches(const struct event_header *event)
+{
+	time_t time;
+
+	if (!filter.any_type && !filter.types[event->type])
+		return false;
+
+	if (!filter.has_since && !filter.has_until)
+		return true;
+
+	time = eventlog_event_time(event);
+	if (time == -1)
+		return false;
+
+	return (!filter.has_since || time >= filter.since) &&
+	       (!filter.has_until || time <= filter.until);
+}
+
 static int cmd_list(const struct buffer *buf, enum elogtool_flag flags)
 {
 	enum eventlog_timezone tz = EVENTLOG_TIMEZONE_LOCALTIME;
@@ -205,17 +263,9 @@ static int cmd_list(const struct buffer *buf, enum elogtool_flag flags)
 	/* Point to the first event */
 	event = buffer_get(buf) + sizeof(struct elog_header);
 
-	while ((const void *)(event) < buffer_end(buf)) {
-		if (((const void *)event + sizeof(*event)) >= buffer_end(buf)
-			|| event->length <= sizeof(*event)
-			|| event->length > ELOG_MAX_EVENT_SIZE
-			|| ((const void *)event + event->length) >= buffer_end(buf)
-			|| event->type == ELOG_TYPE_EOL)
-			break;
-
-		eventlog_print_event(event, count, tz);
-		event = elog_get_next_event(event);
-		count++;
+	for (; event_is_valid(buf, event); event = elog_get_next_event(event), count++) {
+		if (event_matches(event))
+			eventlog_print_event(event, count, tz);
 	}
 
 	return ELOGTOOL_EXIT_SUCCESS;
@@ -367,10 +417,152 @@ static int cmd_add(const struct buffer *buf,
 	return ELOGTOOL_EXIT_SUCCESS;
 }
 
+static void cmd_export_usage(void)
+{
+	usage(argv0);
+
+	fprintf(stderr, "\n\nSpecific to EXPORT command:\n"
+		"\n"
+		"csv:                   one line per event with the columns\n"
+		"                       index,time,type,name,data\n"
+		"binary:                the elog header followed by the events. The output\n"
+		"                       can be read again with '%s list -f <file>'\n"
+		"\n"
+		"Example:\n"
+		"%s export csv -t 17,a7 -s 2024-01-01  # boots and wakes since 2024\n",
+		argv0, argv0
+	);
+}
+
+static void export_csv_event(const struct event_header *event, unsigned int count,
+			     enum elogtool_flag flags)
+{
+	const uint8_t *data = (const uint8_t *)(event + 1);
+	const char *name = eventlog_event_type_name(event->type);
+	const time_t time = eventlog_event_time(event);
+	char tm_string[40] = "";
+	struct tm *tmptr;
+
+	if (time != -1) {
+		tmptr = (flags & ELOGTOOL_FLAG_UTC) ? gmtime(&time) : localtime(&time);
+		strftime(tm_string, sizeof(tm_string), "%Y-%m-%dT%H:%M:%S%z", tmptr);
+	}
+
+	/* Some type names contain commas. */
+	printf("%u,%s,0x%02x,\"%s\",", count, tm_string, event->type,
+	       name ? name : "Unknown");
+
+	/* The last byte is the checksum. */
+	for (size_t i = 0; i < event->length - sizeof(*event) - 1; i++)
+		printf("%02x", data[i]);
+	printf("\n");
+}
+
+/*
+ * Writes the events which match the filter to stdout. Events are emitted one by one
+ * while walking the log, without decoding the ones that are filtered out.
+ */
+static int cmd_export(const struct buffer *buf, enum elogtool_flag flags)
+{
+	const struct event_header *event;
+	const uint8_t eol = ELOG_TYPE_EOL;
+	unsigned int count = 0;
+	bool binary;
+
+	if (cmd_argv[0] == NULL || cmd_argv[1] != NULL) {
+		cmd_export_usage();
+		return ELOGTOOL_EXIT_BAD_ARGS;
+	}
+
+	if (!strcmp(cmd_argv[0], "binary")) {
+		binary = true;
+	} else if (!strcmp(cmd_argv[0], "csv")) {
+		binary = false;
+	} else {
+		cmd_export_usage();
+		return ELOGTOOL_EXIT_BAD_ARGS;
+	}
+
+	if (binary && fwrite(buffer_get(buf), sizeof(struct elog_header), 1, stdout) != 1)
+		goto write_error;
+
+	event = buffer_get(buf) + sizeof(struct elog_header);
+
+	for (; event_is_valid(buf, event); event = elog_get_next_event(event), count++) {
+		if (!event_matches(event))
+			continue;
+
+		if (!binary)
+			export_csv_event(event, count, flags);
+		else if (fwrite(event, event->length, 1, stdout) != 1)
+			goto write_error;
+	}
+
+	/* Terminate the log, readers only take events that are followed by something. */
+	if (binary && fwrite(&eol, sizeof(eol), 1, stdout) != 1)
+		goto write_error;
+
+	if (fflush(stdout) == 0 && !ferror(stdout))
+		return ELOGTOOL_EXIT_SUCCESS;
+
+write_error:
+	fprintf(stderr, "Failed to write the exported events\n");
+	return ELOGTOOL_EXIT_WRITE_ERROR;
+}
+
+static int parse_filter_types(const char *arg)
+{
+	char *endptr;
+	long value;
+
+	filter.any_type = false;
+
+	do {
+		/* Hexadecimal like the event type of the add command */
+		value = strtol(arg, &endptr, 16);
+		if (endptr == arg || (*endptr != ',' && *endptr != '\0') ||
+		    value < 0 || value > 255) {
+			fprintf(stderr, "Error: Invalid event type list: %s\n", arg);
+			return ELOGTOOL_EXIT_BAD_ARGS;
+		}
+		filter.types[value] = true;
+		arg = endptr + 1;
+	} while (*endptr == ',');
+
+	return ELOGTOOL_EXIT_SUCCESS;
+}
+
+static int parse_filter_time(const char *arg, bool utc, time_t *time)
+{
+	struct tm tm;
+	char *endptr;
+
+	/* Seconds since the epoch */
+	*time = strtoll(arg, &endptr, 10);
+	if (endptr != arg && *endptr == '\0')
+		return ELOGTOOL_EXIT_SUCCESS;
+
+	memset(&tm, 0, sizeof(tm));
+	endptr = strptime(arg, "%Y-%m-%d", &tm);
+	if (endptr && *endptr != '\0')
+		endptr = strptime(endptr, " %H:%M:%S", &tm);
+	if (!endptr || *endptr != '\0') {
+		fprintf(stderr, "Error: Invalid time: %s\n", arg);
+		return ELOGTOOL_EXIT_BAD_ARGS;
+	}
+
+	tm.tm_isdst = -1;
+	*time = utc ? timegm(&tm) : mktime(&tm);
+
+	return ELOGTOOL_EXIT_SUCCESS;
+}
+
 int main(int argc, char **argv)
 {
 	char *filename = NULL;
 	enum elogtool_flag flags = 0;
+	const char *since = NULL;
+	const char *until = NULL;
 	struct buffer buf;
 	unsigned int i;
 	int argflag;
@@ -383,7 +575,7 @@ int main(int argc, char **argv)
 
 	while (1) {
 		int option_index;
-		argflag = getopt_long(argc, argv, "Uhf:", long_options, &option_index);
+		argflag = getopt_long(argc, argv, "Uhf:t:s:e:", long_options, &option_index);
 		if (argflag == -1)
 			break;
 
@@ -404,6 +596,16 @@ int main(int argc, char **argv)
 		case 'U':
 			flags |= ELOGTOOL_FLAG_UTC;
 			break;
+		case 't':
+			if (parse_filter_types(optarg) != ELOGTOOL_EXIT_SUCCESS)
+				return ELOGTOOL_EXIT_BAD_ARGS;
+			break;
+		case 's':
+			since = optarg;
+			break;
+		case 'e':
+			until = optarg;
+			break;
 
 		default:
 			break;
@@ -416,6 +618,18 @@ int main(int argc, char **argv)
 		return ELOGTOOL_EXIT_BAD_ARGS;
 	}
 
+	/* Times are parsed once all options are known, -U may come later. */
+	if (since) {
+		if (parse_filter_time(since, flags & ELOGTOOL_FLAG_UTC, &filter.since))
+			return ELOGTOOL_EXIT_BAD_ARGS;
+		filter.has_since = true;
+	}
+	if (until) {
+		if (parse_filter_time(until, flags & ELOGTOOL_FLAG_UTC, &filter.until))
+			return ELOGTOOL_EXIT_BAD_ARGS;
+		filter.has_until = true;
+	}
+
 	/* Returned buffer must be freed. */
 	ret = elog_read(&buf, filename);
 	if (ret)
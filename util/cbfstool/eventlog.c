@@ -42,6 +42,115 @@ static void eventlog_printf(const char *format, ...)
 	va_end(args);
 }
 
+static const struct valstr elog_event_types[] = {
+	/* SMBIOS Event Log types, SMBIOSv2.4 section 3.3.16.1 */
+	{ELOG_TYPE_UNDEFINED_EVENT, "Reserved"},
+	{ELOG_TYPE_SINGLE_BIT_ECC_MEM_ERR, "Single-bit ECC memory error"},
+	{ELOG_TYPE_MULTI_BIT_ECC_MEM_ERR, "Multi-bit ECC memory error"},
+	{ELOG_TYPE_MEM_PARITY_ERR, "Parity memory error"},
+	{ELOG_TYPE_BUS_TIMEOUT, "Bus timeout"},
+	{ELOG_TYPE_IO_CHECK, "I/O channel check"},
+	{ELOG_TYPE_SW_NMI, "Software NMI"},
+	{ELOG_TYPE_POST_MEM_RESIZE, "POST memory resize"},
+	{ELOG_TYPE_POST_ERR, "POST error"},
+	{ELOG_TYPE_PCI_PERR, "PCI parity error"},
+	{ELOG_TYPE_PCI_SERR, "PCI system error"},
+	{ELOG_TYPE_CPU_FAIL, "CPU failure"},
+	{ELOG_TYPE_EISA_TIMEOUT, "EISA failsafe timer timeout"},
+	{ELOG_TYPE_CORRECTABLE_MEMLOG_DIS, "Correctable memory log disabled"},
+	{ELOG_TYPE_LOG_DISABLED, "Logging disabled, too many errors"},
+	{ELOG_TYPE_UNDEFINED_EVENT2, "Reserved"},
+	{ELOG_TYPE_SYS_LIMIT_EXCEED, "System limit exceeded"},
+	{ELOG_TYPE_ASYNC_HW_TIMER_EXPIRED, "Hardware watchdog reset"},
+	{ELOG_TYPE_SYS_CONFIG_INFO, "System configuration information"},
+	{ELOG_TYPE_HDD_INFO, "Hard-disk information"},
+	{ELOG_TYPE_SYS_RECONFIG, "System reconfigured"},
+	{ELOG_TYPE_CPU_ERROR, "Uncorrectable CPU-complex error"},
+	{ELOG_TYPE_LOG_CLEAR, "Log area cleared"},
+	{ELOG_TYPE_BOOT, "System boot"},
+
+	/* Extended events defined by OEMs */
+	{ELOG_TYPE_OS_EVENT, "Kernel Event"},
+	{ELOG_TYPE_OS_BOOT, "OS Boot"},
+	{ELOG_TYPE_EC_EVENT, "EC Event"},
+	{ELOG_TYPE_POWER_FAIL, "Power Fail"},
+	{ELOG_TYPE_SUS_POWER_FAIL, "SUS Power Fail"},
+	{ELOG_TYPE_PWROK_FAIL, "PWROK Fail"},
+	{ELOG_TYPE_SYS_PWROK_FAIL, "SYS PWROK Fail"},
+	{ELOG_TYPE_POWER_ON, "Power On"},
+	{ELOG_TYPE_POWER_BUTTON, "Power Button"},
+	{ELOG_TYPE_POWER_BUTTON_OVERRIDE, "Power Button Override"},
+	{ELOG_TYPE_RESET_BUTTON, "Reset Button"},
+	{ELOG_TYPE_SYSTEM_RESET, "System Reset"},
+	{ELOG_TYPE_RTC_RESET, "RTC Reset"},
+	{ELOG_TYPE_TCO_RESET, "TCO Reset"},
+	{ELOG_TYPE_ACPI_ENTER, "ACPI Enter"},
+	{ELOG_TYPE_ACPI_WAKE, "ACPI Wake"},
+	{ELOG_TYPE_ACPI_DEEP_WAKE, "ACPI Wake"},
+	{ELOG_TYPE_S0IX_ENTER, "S0ix Enter"},
+	{ELOG_TYPE_S0IX_EXIT, "S0ix Exit"},
+	{ELOG_TYPE_WAKE_SOURCE, "Wake Source"},
+	{ELOG_DEPRECATED_TYPE_CROS_DEVELOPER_MODE, "ChromeOS Developer Mode"},
+	{ELOG_DEPRECATED_TYPE_CROS_RECOVERY_MODE, "ChromeOS Recovery Mode"},
+	{ELOG_TYPE_MANAGEMENT_ENGINE, "Management Engine"},
+	{ELOG_TYPE_MANAGEMENT_ENGINE_EXT, "Management Engine Extra"},
+	{ELOG_TYPE_LAST_POST_CODE, "Last post code in previous boot"},
+	{ELOG_TYPE_POST_EXTRA, "Extra info from previous boot"},
+	{ELOG_TYPE_EC_SHUTDOWN, "EC Shutdown"},
+	{ELOG_TYPE_SLEEP, "Sleep"},
+	{ELOG_TYPE_WAKE, "Wake"},
+	{ELOG_TYPE_FW_WAKE, "FW Wake"},
+	{ELOG_TYPE_MEM_CACHE_UPDATE, "Memory Cache Update"},
+	{ELOG_TYPE_THERM_TRIP, "CPU Thermal Trip"},
+	{ELOG_TYPE_CR50_UPDATE, "cr50 Update Reset"},
+	{ELOG_TYPE_CR50_NEED_RESET, "cr50 Reset Required"},
+	{ELOG_TYPE_EC_DEVICE_EVENT, "EC Device"},
+	{ELOG_TYPE_EXTENDED_EVENT, "Extended Event"},
+	{ELOG_TYPE_CROS_DIAGNOSTICS, "Diagnostics Mode"},
+	{ELOG_TYPE_FW_VBOOT_INFO, "Firmware vboot info"},
+	{ELOG_TYPE_FW_EARLY_SOL, "Early Sign of Life"},
+	{ELOG_TYPE_PSR_DATA_BACKUP, "PSR data backup"},
+	{ELOG_TYPE_PSR_DATA_LOST, "PSR data lost"},
+	{ELOG_TYPE_FW_SPLASH_SCREEN, "Firmware Splash Screen"},
+	{ELOG_TYPE_EOL, "End of log"},
+};
+
+const char *eventlog_event_type_name(uint8_t type)
+{
+	/* Passing NULL as default, because the callers print the type if it fails */
+	return val2str_default(type, elog_event_types, NULL);
+}
+
+static int bcd_to_int(uint8_t bcd)
+{
+	if ((bcd & 0xf) > 9 || (bcd >> 4) > 9)
+		return -1;
+	return (bcd >> 4) * 10 + (bcd & 0xf);
+}
+
+time_t eventlog_event_time(const struct event_header *event)
+{
+	struct tm tm;
+
+	memset(&tm, 0, sizeof(tm));
+	tm.tm_year = bcd_to_int(event->year);
+	tm.tm_mon = bcd_to_int(event->month) - 1;
+	tm.tm_mday = bcd_to_int(event->day);
+	tm.tm_hour = bcd_to_int(event->hour);
+	tm.tm_min = bcd_to_int(event->minute);
+	tm.tm_sec = bcd_to_int(event->second);
+	if (tm.tm_year < 0 || tm.tm_mon < 0 || tm.tm_mday < 0 || tm.tm_hour < 0 ||
+	    tm.tm_min < 0 || tm.tm_sec < 0)
+		return -1;
+
+	/* Same as strptime("%y"): 69-99 are in the 20th century, 00-68 in the 21st. */
+	if (tm.tm_year < 69)
+		tm.tm_year += 100;
+
+	/* Like eventlog_print_timestamp(), the timestamps are taken as UTC. */
+	return timegm(&tm);
+}
+
 /*
  * eventlog_print_timestamp - forms the key-value pair for event timestamp
  *
@@ -98,82 +207,7 @@ static void eventlog_print_timestamp(const struct event_header *event,
  */
 static void eventlog_print_type(const struct event_header *event)
 {
-	const char *type;
-	static const struct valstr elog_event_types[] = {
-		/* SMBIOS Event Log types, SMBIOSv2.4 section 3.3.16.1 */
-		{ELOG_TYPE_UNDEFINED_EVENT, "Reserved"},
-		{ELOG_TYPE_SINGLE_BIT_ECC_MEM_ERR, "Single-bit ECC memory error"},
-		{ELOG_TYPE_MULTI_BIT_ECC_MEM_ERR, "Multi-bit ECC memory error"},
-		{ELOG_TYPE_MEM_PARITY_ERR, "Parity memory error"},
-		{ELOG_TYPE_BUS_TIMEOUT, "Bus timeout"},
-		{ELOG_TYPE_IO_CHECK, "I/O channel check"},
-		{ELOG_TYPE_SW_NMI, "Software NMI"},
-		{ELOG_TYPE_POST_MEM_RESIZE, "POST memory resize"},
-		{ELOG_TYPE_POST_ERR, "POST error"},
-		{ELOG_TYPE_PCI_PERR, "PCI parity error"},
-		{ELOG_TYPE_PCI_SERR, "PCI system error"},
-		{ELOG_TYPE_CPU_FAIL, "CPU failure"},
-		{ELOG_TYPE_EISA_TIMEOUT, "EISA failsafe timer timeout"},
-		{ELOG_TYPE_CORRECTABLE_MEMLOG_DIS, "Correctable memory log disabled"},
-		{ELOG_TYPE_LOG_DISABLED, "Logging disabled, too many errors"},
-		{ELOG_TYPE_UNDEFINED_EVENT2, "Reserved"},
-		{ELOG_TYPE_SYS_LIMIT_EXCEED, "System limit exceeded"},
-		{ELOG_TYPE_ASYNC_HW_TIMER_EXPIRED, "Hardware watchdog reset"},
-		{ELOG_TYPE_SYS_CONFIG_INFO, "System configuration information"},
-		{ELOG_TYPE_HDD_INFO, "Hard-disk information"},
-		{ELOG_TYPE_SYS_RECONFIG, "System reconfigured"},
-		{ELOG_TYPE_CPU_ERROR, "Uncorrectable CPU-complex error"},
-		{ELOG_TYPE_LOG_CLEAR, "Log area cleared"},
-		{ELOG_TYPE_BOOT, "System boot"},
-
-		/* Extended events defined by OEMs */
-		{ELOG_TYPE_OS_EVENT, "Kernel Event"},
-		{ELOG_TYPE_OS_BOOT, "OS Boot"},
-		{ELOG_TYPE_EC_EVENT, "EC Event"},
-		{ELOG_TYPE_POWER_FAIL, "Power Fail"},
-		{ELOG_TYPE_SUS_POWER_FAIL, "SUS Power Fail"},
-		{ELOG_TYPE_PWROK_FAIL, "PWROK Fail"},
-		{ELOG_TYPE_SYS_PWROK_FAIL, "SYS PWROK Fail"},
-		{ELOG_TYPE_POWER_ON, "Power On"},
-		{ELOG_TYPE_POWER_BUTTON, "Power Button"},
-		{ELOG_TYPE_POWER_BUTTON_OVERRIDE, "Power Button Override"},
-		{ELOG_TYPE_RESET_BUTTON, "Reset Button"},
-		{ELOG_TYPE_SYSTEM_RESET, "System Reset"},
-		{ELOG_TYPE_RTC_RESET, "RTC Reset"},
-		{ELOG_TYPE_TCO_RESET, "TCO Reset"},
-		{ELOG_TYPE_ACPI_ENTER, "ACPI Enter"},
-		{ELOG_TYPE_ACPI_WAKE, "ACPI Wake"},
-		{ELOG_TYPE_ACPI_DEEP_WAKE, "ACPI Wake"},
-		{ELOG_TYPE_S0IX_ENTER, "S0ix Enter"},
-		{ELOG_TYPE_S0IX_EXIT, "S0ix Exit"},
-		{ELOG_TYPE_WAKE_SOURCE, "Wake Source"},
-		{ELOG_DEPRECATED_TYPE_CROS_DEVELOPER_MODE, "ChromeOS Developer Mode"},
-		{ELOG_DEPRECATED_TYPE_CROS_RECOVERY_MODE, "ChromeOS Recovery Mode"},
-		{ELOG_TYPE_MANAGEMENT_ENGINE, "Management Engine"},
-		{ELOG_TYPE_MANAGEMENT_ENGINE_EXT, "Management Engine Extra"},
-		{ELOG_TYPE_LAST_POST_CODE, "Last post code in previous boot"},
-		{ELOG_TYPE_POST_EXTRA, "Extra info from previous boot"},
-		{ELOG_TYPE_EC_SHUTDOWN, "EC Shutdown"},
-		{ELOG_TYPE_SLEEP, "Sleep"},
-		{ELOG_TYPE_WAKE, "Wake"},
-		{ELOG_TYPE_FW_WAKE, "FW Wake"},
-		{ELOG_TYPE_MEM_CACHE_UPDATE, "Memory Cache Update"},
-		{ELOG_TYPE_THERM_TRIP, "CPU Thermal Trip"},
-		{ELOG_TYPE_CR50_UPDATE, "cr50 Update Reset"},
-		{ELOG_TYPE_CR50_NEED_RESET, "cr50 Reset Required"},
-		{ELOG_TYPE_EC_DEVICE_EVENT, "EC Device"},
-		{ELOG_TYPE_EXTENDED_EVENT, "Extended Event"},
-		{ELOG_TYPE_CROS_DIAGNOSTICS, "Diagnostics Mode"},
-		{ELOG_TYPE_FW_VBOOT_INFO, "Firmware vboot info"},
-		{ELOG_TYPE_FW_EARLY_SOL, "Early Sign of Life"},
-		{ELOG_TYPE_PSR_DATA_BACKUP, "PSR data backup"},
-		{ELOG_TYPE_PSR_DATA_LOST, "PSR data lost"},
-		{ELOG_TYPE_FW_SPLASH_SCREEN, "Firmware Splash Screen"},
-		{ELOG_TYPE_EOL, "End of log"},
-	};
-
-	/* Passing NULL as default, because we want to print the event->type if it fails */
-	type = val2str_default(event->type, elog_event_types, NULL);
+	const char *type = eventlog_event_type_name(event->type);
 
 	if (type == NULL) {
 		/* Indicate unknown type in value pair */
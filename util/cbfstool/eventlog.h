@@ -4,6 +4,7 @@
 #define EVENTLOG_H_
 
 #include <stdint.h>
+#include <time.h>
 
 struct event_header;
 struct buffer;
@@ -15,6 +16,10 @@ enum eventlog_timezone {
 
 void eventlog_print_event(const struct event_header *event, int count,
 			  enum eventlog_timezone tz);
+/* Returns the name of an event type, or NULL if it is unknown. */
+const char *eventlog_event_type_name(uint8_t type);
+/* Returns the timestamp of an event in seconds since the epoch, or -1 if it is invalid. */
+time_t eventlog_event_time(const struct event_header *event);
 int eventlog_init_event(const struct buffer *buf, uint8_t type,
 			const void *data, int data_size);
 
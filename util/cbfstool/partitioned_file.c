@@ -11,11 +11,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 struct partitioned_file {
 	struct fmap *fmap;
 	struct buffer buffer;
 	FILE *stream;
+	/* The buffer is a private mapping of the file instead of a copy. */
+	bool mapped;
 };
 
 static bool fill_ones_through(struct partitioned_file *file)
@@ -52,11 +56,6 @@ static partitioned_file_t *reopen_flat_file(const char *filename,
 		return NULL;
 	}
 
-	if (buffer_from_file(&file->buffer, filename)) {
-		free(file);
-		return NULL;
-	}
-
 	access_mode = write_access ?  "rb+" : "rb";
 	file->stream = fopen(filename, access_mode);
 
@@ -66,6 +65,27 @@ static partitioned_file_t *reopen_flat_file(const char *filename,
 		return NULL;
 	}
 
+	/*
+	 * Map the image instead of reading all of it: most commands only look
+	 * at a few regions. The mapping is private, so nothing reaches the
+	 * file before partitioned_file_write_region() is called for a region.
+	 */
+	struct stat st;
+	if (!fstat(fileno(file->stream), &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+				  fileno(file->stream), 0);
+		if (data != MAP_FAILED) {
+			buffer_init(&file->buffer, strdup(filename), data, st.st_size);
+			file->mapped = true;
+			return file;
+		}
+	}
+
+	if (buffer_from_file(&file->buffer, filename)) {
+		partitioned_file_close(file);
+		return NULL;
+	}
+
 	return file;
 }
 
@@ -269,7 +289,12 @@ void partitioned_file_close(partitioned_file_t *file)
 		return;
 
 	file->fmap = NULL;
-	buffer_delete(&file->buffer);
+	if (file->mapped) {
+		munmap(file->buffer.data, file->buffer.size);
+		free(file->buffer.name);
+	} else {
+		buffer_delete(&file->buffer);
+	}
 	if (file->stream) {
 		flock(fileno(file->stream), LOCK_UN);
 		fclose(file->stream);
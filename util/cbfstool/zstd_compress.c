@@ -0,0 +1,1036 @@
+/* Zstandard compression for cbfstool */
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/*
+ * Produces a single RFC 8878 frame with the content size, without checksum and without
+ * dictionary, which is what uzstdn() in commonlib expects. Matches are found with hash
+ * chains and two steps of lazy evaluation over the whole input, literals are Huffman
+ * coded and every block picks the cheapest of the predefined, RLE or its own FSE tables
+ * for the sequences. This doesn't reach the density of zstd's optimal parser, but keeps
+ * the output reproducible without depending on the host's libzstd version.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+#define ZSTD_MAGIC		0xfd2fb528
+#define ZSTD_BLOCK_SIZE		(128 * KiB)
+
+#define MIN_MATCH		4
+#define HASH_LOG		17
+#define CHAIN_DEPTH		256
+#define NICE_MATCH		256
+
+#define LL_CODES		36
+#define ML_CODES		53
+#define OF_CODES		32
+#define LL_MAX_LOG		9
+#define ML_MAX_LOG		9
+#define OF_MAX_LOG		8
+#define FSE_MIN_LOG		5
+#define FSE_MAX_SYMBOLS		256
+
+#define HUF_MAX_BITS		11
+#define HUF_SYMBOLS		256
+#define HUF_WEIGHT_MAX_LOG	6
+
+enum {
+	BLOCK_RAW = 0,
+	BLOCK_RLE = 1,
+	BLOCK_COMPRESSED = 2,
+};
+
+enum {
+	LIT_RAW = 0,
+	LIT_RLE = 1,
+	LIT_COMPRESSED = 2,
+};
+
+enum {
+	MODE_PREDEFINED = 0,
+	MODE_RLE = 1,
+	MODE_FSE = 2,
+};
+
+static const uint32_t ll_base[LL_CODES] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+	8192, 16384, 32768, 65536,
+};
+
+static const uint8_t ll_bits[LL_CODES] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16,
+};
+
+static const uint32_t ml_base[ML_CODES] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+	4099, 8195, 16387, 32771, 65539,
+};
+
+static const uint8_t ml_bits[ML_CODES] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16,
+};
+
+static const int16_t ll_default[LL_CODES] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1,
+};
+
+static const int16_t ml_default[ML_CODES] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1,
+};
+
+static const int16_t of_default[29] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1,
+};
+
+struct zstd_seq {
+	uint32_t litlen;
+	uint32_t matchlen;
+	uint32_t offval;
+};
+
+struct zstd_enc {
+	const uint8_t *src;
+	size_t size;
+	int32_t *head;
+	int32_t *chain;
+	size_t inserted;
+	uint32_t rep[3];
+	/* Parse results of the current block */
+	struct zstd_seq *seqs;
+	size_t nseq;
+	uint8_t *lits;
+	size_t nlits;
+};
+
+static unsigned int highbit32(uint32_t x)
+{
+	return 31 - __builtin_clz(x);
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static void write_le(uint8_t *p, uint64_t v, unsigned int bytes)
+{
+	while (bytes--) {
+		*p++ = v;
+		v >>= 8;
+	}
+}
+
+/* Forward bit writer, the decoder reads the result backwards from the end marker. */
+struct bitw {
+	uint8_t *p;
+	uint8_t *end;
+	uint64_t acc;
+	unsigned int n;
+	bool overflow;
+};
+
+static void bw_init(struct bitw *w, uint8_t *dst, size_t cap)
+{
+	w->p = dst;
+	w->end = dst + cap;
+	w->acc = 0;
+	w->n = 0;
+	w->overflow = false;
+}
+
+static void bw_add(struct bitw *w, uint64_t v, unsigned int bits)
+{
+	w->acc |= (v & ((1ULL << bits) - 1)) << w->n;
+	w->n += bits;
+	while (w->n >= 8) {
+		if (w->p < w->end)
+			*w->p++ = w->acc;
+		else
+			w->overflow = true;
+		w->acc >>= 8;
+		w->n -= 8;
+	}
+}
+
+/* Pads to a full byte and returns the number of bytes written, 0 on overflow. */
+static size_t bw_flush(struct bitw *w, uint8_t *start)
+{
+	if (w->n)
+		bw_add(w, 0, 8 - w->n);
+	return w->overflow ? 0 : w->p - start;
+}
+
+static size_t bw_close(struct bitw *w, uint8_t *start)
+{
+	bw_add(w, 1, 1);
+	return bw_flush(w, start);
+}
+
+/* log2(x) in 1/256 bits, piecewise linear which is plenty for picking table modes. */
+static uint32_t log2_q8(uint32_t x)
+{
+	const unsigned int hb = highbit32(x);
+
+	return (hb << 8) + (uint32_t)(((uint64_t)(x - (1U << hb)) << 8) >> hb);
+}
+
+/*
+ * FSE encoding tables, built exactly like the reference implementation so the encoding
+ * of the final states matches what decoders expect.
+ */
+struct fse_ctable {
+	unsigned int log;
+	uint16_t state[1 << LL_MAX_LOG];
+	struct {
+		int32_t delta_bits;
+		int32_t delta_state;
+	} sym[FSE_MAX_SYMBOLS];
+};
+
+struct fse_cstate {
+	const struct fse_ctable *ct;
+	uint32_t value;
+};
+
+static void fse_build_ctable(struct fse_ctable *ct, const int16_t *norm, unsigned int nsyms,
+			     unsigned int log)
+{
+	const unsigned int size = 1 << log;
+	const unsigned int step = (size >> 1) + (size >> 3) + 3;
+	unsigned int high = size - 1, pos = 0, s, u, max_bits;
+	uint32_t cumul[FSE_MAX_SYMBOLS + 1];
+	uint8_t spread[1 << LL_MAX_LOG];
+	int32_t total = 0;
+	int i;
+
+	ct->log = log;
+	cumul[0] = 0;
+	for (s = 0; s < nsyms; s++) {
+		if (norm[s] == -1) {
+			cumul[s + 1] = cumul[s] + 1;
+			spread[high--] = s;
+		} else {
+			cumul[s + 1] = cumul[s] + norm[s];
+		}
+	}
+
+	for (s = 0; s < nsyms; s++) {
+		for (i = 0; i < norm[s]; i++) {
+			spread[pos] = s;
+			do {
+				pos = (pos + step) & (size - 1);
+			} while (pos > high);
+		}
+	}
+
+	for (u = 0; u < size; u++)
+		ct->state[cumul[spread[u]]++] = size + u;
+
+	for (s = 0; s < nsyms; s++) {
+		switch (norm[s]) {
+		case 0:
+			ct->sym[s].delta_bits = ((log + 1) << 16) - size;
+			break;
+		case -1:
+		case 1:
+			ct->sym[s].delta_bits = (log << 16) - size;
+			ct->sym[s].delta_state = total - 1;
+			total++;
+			break;
+		default:
+			max_bits = log - highbit32(norm[s] - 1);
+			ct->sym[s].delta_bits = (max_bits << 16) - (norm[s] << max_bits);
+			ct->sym[s].delta_state = total - norm[s];
+			total += norm[s];
+		}
+	}
+}
+
+/* A table that always yields |symbol| without using any bits. */
+static void fse_build_ctable_rle(struct fse_ctable *ct, unsigned int symbol)
+{
+	ct->log = 0;
+	ct->state[0] = 0;
+	ct->sym[symbol].delta_bits = 0;
+	ct->sym[symbol].delta_state = 0;
+}
+
+static void fse_cinit(struct fse_cstate *st, const struct fse_ctable *ct, unsigned int s)
+{
+	const uint32_t bits = (uint32_t)(ct->sym[s].delta_bits + (1 << 15)) >> 16;
+	const uint32_t value = (bits << 16) - ct->sym[s].delta_bits;
+
+	st->ct = ct;
+	st->value = ct->state[(value >> bits) + ct->sym[s].delta_state];
+}
+
+static void fse_encode(struct bitw *w, struct fse_cstate *st, unsigned int s)
+{
+	const uint32_t bits = (uint32_t)(st->value + st->ct->sym[s].delta_bits) >> 16;
+
+	bw_add(w, st->value, bits);
+	st->value = st->ct->state[(st->value >> bits) + st->ct->sym[s].delta_state];
+}
+
+static void fse_cflush(struct bitw *w, const struct fse_cstate *st)
+{
+	bw_add(w, st->value, st->ct->log);
+}
+
+static unsigned int fse_table_log(size_t total, unsigned int max_symbol, unsigned int max_log)
+{
+	int log = max_log;
+	const int src_max = (int)highbit32(total - 1) - 2;
+	const int min_bits = MIN(highbit32(total) + 1, highbit32(max_symbol) + 2);
+
+	if (src_max < log)
+		log = src_max;
+	if (min_bits > log)
+		log = min_bits;
+
+	return MIN(MAX(log, FSE_MIN_LOG), (int)max_log);
+}
+
+/* Scales |count| to sum up to 1 << log, keeping every present symbol above zero. */
+static void fse_normalize(int16_t *norm, const uint32_t *count, unsigned int nsyms,
+			  size_t total, unsigned int log)
+{
+	const int size = 1 << log;
+	unsigned int s, largest = 0;
+	int sum = 0, p;
+
+	for (s = 0; s < nsyms; s++) {
+		if (!count[s]) {
+			norm[s] = 0;
+			continue;
+		}
+		p = ((uint64_t)count[s] * size + total / 2) / total;
+		norm[s] = MAX(p, 1);
+		sum += norm[s];
+		if (count[s] > count[largest])
+			largest = s;
+	}
+
+	/* Rounding errors are taken from or given to the most probable symbols. */
+	if (sum < size)
+		norm[largest] += size - sum;
+	while (sum > size) {
+		largest = 0;
+		for (s = 1; s < nsyms; s++)
+			if (norm[s] > norm[largest])
+				largest = s;
+		norm[largest]--;
+		sum--;
+	}
+}
+
+static size_t fse_write_ncount(uint8_t *dst, size_t cap, const int16_t *norm,
+			       unsigned int nsyms, unsigned int log)
+{
+	int remaining = (1 << log) + 1, threshold = 1 << log, max, count;
+	unsigned int nbits = log + 1, s = 0, start;
+	bool previous0 = false;
+	struct bitw w;
+
+	bw_init(&w, dst, cap);
+	bw_add(&w, log - FSE_MIN_LOG, 4);
+
+	while (s < nsyms && remaining > 1) {
+		if (previous0) {
+			start = s;
+			while (!norm[s])
+				s++;
+			while (s >= start + 3) {
+				bw_add(&w, 3, 2);
+				start += 3;
+			}
+			bw_add(&w, s - start, 2);
+		}
+
+		count = norm[s++];
+		max = 2 * threshold - 1 - remaining;
+		remaining -= count < 0 ? -count : count;
+		count++;
+		if (count >= threshold)
+			count += max;
+		bw_add(&w, count, nbits - (count < max));
+		previous0 = count == 1;
+		while (remaining < threshold) {
+			nbits--;
+			threshold >>= 1;
+		}
+	}
+
+	return bw_flush(&w, dst);
+}
+
+/* Huffman code lengths limited to HUF_MAX_BITS. Needs at least two symbols. */
+static unsigned int huf_lengths(const uint32_t *count, unsigned int nsyms, uint8_t *len)
+{
+	uint32_t weight[2 * HUF_SYMBOLS], scaled[HUF_SYMBOLS];
+	uint16_t order[HUF_SYMBOLS], parent[2 * HUF_SYMBOLS];
+	uint8_t depth[2 * HUF_SYMBOLS];
+	unsigned int n, i, j, leaf, node, next, pick[2], max_len, k;
+
+	for (i = 0; i < nsyms; i++)
+		scaled[i] = count[i];
+
+	for (;;) {
+		/* Leaves sorted by weight, stable so equal weights keep their order. */
+		n = 0;
+		for (i = 0; i < nsyms; i++) {
+			if (!scaled[i])
+				continue;
+			for (j = n; j > 0 && scaled[order[j - 1]] > scaled[i]; j--)
+				order[j] = order[j - 1];
+			order[j] = i;
+			n++;
+		}
+		for (i = 0; i < n; i++)
+			weight[i] = scaled[order[i]];
+
+		/* Two queues: remaining leaves and the internal nodes built so far. */
+		leaf = 0;
+		node = n;
+		for (next = n; next < 2 * n - 1; next++) {
+			for (k = 0; k < 2; k++) {
+				if (leaf < n && (node >= next || weight[leaf] <= weight[node]))
+					pick[k] = leaf++;
+				else
+					pick[k] = node++;
+			}
+			weight[next] = weight[pick[0]] + weight[pick[1]];
+			parent[pick[0]] = next;
+			parent[pick[1]] = next;
+		}
+
+		depth[2 * n - 2] = 0;
+		max_len = 0;
+		for (i = 2 * n - 2; i-- > 0;) {
+			depth[i] = depth[parent[i]] + 1;
+			if (i < n)
+				max_len = MAX(max_len, (unsigned int)depth[i]);
+		}
+
+		if (max_len <= HUF_MAX_BITS)
+			break;
+
+		/* Too deep, flatten the distribution and try again. */
+		for (i = 0; i < nsyms; i++)
+			if (scaled[i])
+				scaled[i] = (scaled[i] + 1) / 2;
+	}
+
+	memset(len, 0, nsyms);
+	for (i = 0; i < n; i++)
+		len[order[i]] = depth[i];
+
+	return max_len;
+}
+
+/* Weights for all but the last symbol, FSE compressed or stored directly. */
+static size_t huf_write_weights(uint8_t *dst, size_t cap, const uint8_t *weights,
+				unsigned int nw, unsigned int max_bits)
+{
+	uint32_t count[HUF_MAX_BITS + 1] = { 0 };
+	int16_t norm[HUF_MAX_BITS + 1];
+	struct fse_ctable ct;
+	struct fse_cstate c1, c2;
+	struct bitw w;
+	unsigned int i, log, distinct = 0;
+	size_t n, stream, best = 0;
+
+	for (i = 0; i < nw; i++)
+		if (!count[weights[i]]++)
+			distinct++;
+
+	if (nw >= 2 && distinct >= 2) {
+		log = fse_table_log(nw, max_bits, HUF_WEIGHT_MAX_LOG);
+		fse_normalize(norm, count, max_bits + 1, nw, log);
+		n = fse_write_ncount(dst + 1, cap - 1, norm, max_bits + 1, log);
+		if (n) {
+			fse_build_ctable(&ct, norm, max_bits + 1, log);
+			bw_init(&w, dst + 1 + n, cap - 1 - n);
+			i = nw;
+			if (nw & 1) {
+				fse_cinit(&c1, &ct, weights[--i]);
+				fse_cinit(&c2, &ct, weights[--i]);
+				fse_encode(&w, &c1, weights[--i]);
+			} else {
+				fse_cinit(&c2, &ct, weights[--i]);
+				fse_cinit(&c1, &ct, weights[--i]);
+			}
+			while (i) {
+				fse_encode(&w, &c2, weights[--i]);
+				fse_encode(&w, &c1, weights[--i]);
+			}
+			fse_cflush(&w, &c2);
+			fse_cflush(&w, &c1);
+			stream = bw_close(&w, dst + 1 + n);
+			if (stream && n + stream < 128)
+				best = n + stream;
+		}
+	}
+
+	if (nw <= 128 && (!best || DIV_ROUND_UP(nw, 2) <= best)) {
+		if (1 + DIV_ROUND_UP(nw, 2) > cap)
+			return 0;
+		dst[0] = 127 + nw;
+		memset(dst + 1, 0, DIV_ROUND_UP(nw, 2));
+		for (i = 0; i < nw; i++)
+			dst[1 + i / 2] |= weights[i] << (i & 1 ? 0 : 4);
+		return 1 + DIV_ROUND_UP(nw, 2);
+	}
+
+	if (!best)
+		return 0;
+	dst[0] = best;
+	return 1 + best;
+}
+
+static size_t huf_write_stream(uint8_t *dst, size_t cap, const uint8_t *lits, size_t n,
+			       const uint16_t *code, const uint8_t *len)
+{
+	struct bitw w;
+
+	bw_init(&w, dst, cap);
+	while (n--)
+		bw_add(&w, code[lits[n]], len[lits[n]]);
+
+	return bw_close(&w, dst);
+}
+
+/* Returns the size of the literals section, 0 if it doesn't fit. */
+static size_t write_literals(uint8_t *dst, size_t cap, const uint8_t *lits, size_t n)
+{
+	uint32_t count[HUF_SYMBOLS] = { 0 };
+	uint8_t len[HUF_SYMBOLS], weights[HUF_SYMBOLS];
+	uint16_t code[HUF_SYMBOLS], rank[HUF_MAX_BITS + 2] = { 0 };
+	unsigned int i, nsyms = 0, distinct = 0, max_bits, hdr, bits, w, streams;
+	size_t tree, comp, per_stream, s, pos, total;
+	uint64_t v;
+	uint8_t *p, *jump;
+
+	for (s = 0; s < n; s++)
+		if (!count[lits[s]]++)
+			distinct++;
+	for (i = 0; i < HUF_SYMBOLS; i++)
+		if (count[i])
+			nsyms = i + 1;
+
+	if (distinct == 1 && n > 1) {
+		hdr = n < 32 ? 1 : n < 4096 ? 2 : 3;
+		if (hdr + 1 > cap)
+			return 0;
+		write_le(dst, LIT_RLE | (hdr == 1 ? n << 3 : (hdr * 2 - 3) << 2 | n << 4), hdr);
+		dst[hdr] = lits[0];
+		return hdr + 1;
+	}
+
+	/* Huffman coding only pays off above a few dozen literals. */
+	if (n >= 64) {
+		max_bits = huf_lengths(count, nsyms, len);
+
+		/* Canonical codes, handed out from the longest code (lowest weight) up. */
+		for (i = 0; i < nsyms; i++) {
+			weights[i] = len[i] ? max_bits + 1 - len[i] : 0;
+			rank[weights[i]]++;
+		}
+		for (w = 1, pos = 0; w <= max_bits; w++) {
+			s = rank[w];
+			rank[w] = pos;
+			pos += s << (w - 1);
+		}
+		for (i = 0; i < nsyms; i++) {
+			if (!weights[i])
+				continue;
+			code[i] = rank[weights[i]] >> (weights[i] - 1);
+			rank[weights[i]] += 1 << (weights[i] - 1);
+		}
+
+		streams = n < 256 ? 1 : 4;
+		hdr = streams == 1 ? 3 : n < 1024 ? 3 : n < 16384 ? 4 : 5;
+		p = dst + hdr;
+		if (cap <= hdr + 6)
+			return 0;
+
+		tree = huf_write_weights(p, cap - hdr, weights, nsyms - 1, max_bits);
+		if (!tree)
+			goto raw;
+		p += tree;
+
+		if (streams == 1) {
+			comp = huf_write_stream(p, dst + cap - p, lits, n, code, len);
+			if (!comp)
+				goto raw;
+			p += comp;
+		} else {
+			if (dst + cap - p < 6)
+				goto raw;
+			jump = p;
+			per_stream = DIV_ROUND_UP(n, 4);
+			pos = 0;
+			p += 6;
+			for (i = 0; i < 4; i++) {
+				s = MIN(per_stream, n - pos);
+				comp = huf_write_stream(p, dst + cap - p, lits + pos, s, code, len);
+				if (!comp || (i < 3 && comp > UINT16_MAX))
+					goto raw;
+				if (i < 3)
+					write_le(jump + i * 2, comp, 2);
+				p += comp;
+				pos += s;
+			}
+		}
+
+		comp = p - dst - hdr;
+		total = p - dst;
+		bits = hdr == 3 ? 10 : hdr == 4 ? 14 : 18;
+		if (comp < (1U << bits) && total < n + (n < 32 ? 1 : n < 4096 ? 2 : 3)) {
+			v = LIT_COMPRESSED | (uint64_t)(streams == 1 ? 0 : hdr - 2) << 2 |
+			    (uint64_t)n << 4 | (uint64_t)comp << (4 + bits);
+			write_le(dst, v, hdr);
+			return total;
+		}
+	}
+
+raw:
+	hdr = n < 32 ? 1 : n < 4096 ? 2 : 3;
+	if (hdr + n > cap)
+		return 0;
+	write_le(dst, LIT_RAW | (hdr == 1 ? n << 3 : (hdr * 2 - 3) << 2 | n << 4), hdr);
+	memcpy(dst + hdr, lits, n);
+	return hdr + n;
+}
+
+static unsigned int ll_code(uint32_t litlen)
+{
+	unsigned int c;
+
+	if (litlen >= 64)
+		return highbit32(litlen) + 19;
+	for (c = LL_CODES - 1; ll_base[c] > litlen; c--)
+		;
+	return c;
+}
+
+static unsigned int ml_code(uint32_t matchlen)
+{
+	unsigned int c;
+
+	if (matchlen - 3 >= 128)
+		return highbit32(matchlen - 3) + 36;
+	for (c = ML_CODES - 1; ml_base[c] > matchlen; c--)
+		;
+	return c;
+}
+
+/* Picks the cheapest way to code one of the sequence symbol streams. */
+static size_t seq_table(struct fse_ctable *ct, unsigned int *mode, const uint8_t *codes,
+			size_t nseq, const int16_t *def, unsigned int def_syms,
+			unsigned int def_log, unsigned int max_log, uint8_t *dst, size_t cap)
+{
+	uint32_t count[ML_CODES] = { 0 };
+	int16_t norm[ML_CODES];
+	unsigned int s, nsyms = 0, distinct = 0, log;
+	uint64_t cost, best = UINT64_MAX;
+	size_t i, n;
+
+	for (i = 0; i < nseq; i++)
+		if (!count[codes[i]]++)
+			distinct++;
+	for (s = 0; s < ML_CODES; s++)
+		if (count[s])
+			nsyms = s + 1;
+
+	if (distinct == 1 && nseq > 2) {
+		if (!cap)
+			return SIZE_MAX;
+		*mode = MODE_RLE;
+		dst[0] = codes[0];
+		fse_build_ctable_rle(ct, codes[0]);
+		return 1;
+	}
+
+	/* Costs in 1/256 bits */
+	if (nsyms <= def_syms) {
+		cost = 0;
+		for (s = 0; s < nsyms; s++)
+			if (count[s])
+				cost += count[s] * ((def_log << 8) - log2_q8(ABS(def[s])));
+		best = cost;
+		*mode = MODE_PREDEFINED;
+	}
+
+	if (nseq >= 2 && distinct >= 2) {
+		log = fse_table_log(nseq, nsyms - 1, max_log);
+		fse_normalize(norm, count, nsyms, nseq, log);
+		n = fse_write_ncount(dst, cap, norm, nsyms, log);
+		if (n) {
+			cost = n * 8 * 256;
+			for (s = 0; s < nsyms; s++)
+				if (count[s])
+					cost += count[s] * ((log << 8) - log2_q8(norm[s]));
+			if (cost < best) {
+				*mode = MODE_FSE;
+				fse_build_ctable(ct, norm, nsyms, log);
+				return n;
+			}
+		}
+	}
+
+	if (best == UINT64_MAX)
+		return SIZE_MAX;
+	fse_build_ctable(ct, def, def_syms, def_log);
+	return 0;
+}
+
+static size_t write_sequences(uint8_t *dst, size_t cap, const struct zstd_seq *seqs,
+			      size_t nseq)
+{
+	struct fse_ctable ll_ct, of_ct, ml_ct;
+	struct fse_cstate ll, of, ml;
+	unsigned int ll_mode, of_mode, ml_mode;
+	uint8_t *llc, *ofc, *mlc, *p = dst;
+	struct bitw w;
+	size_t i, n, ret = 0;
+
+	if (cap < 4)
+		return 0;
+	if (nseq < 128) {
+		*p++ = nseq;
+	} else if (nseq < 0x7f00) {
+		*p++ = (nseq >> 8) + 128;
+		*p++ = nseq;
+	} else {
+		*p++ = 255;
+		write_le(p, nseq - 0x7f00, 2);
+		p += 2;
+	}
+	if (!nseq)
+		return p - dst;
+
+	llc = malloc(nseq * 3);
+	if (!llc)
+		return 0;
+	ofc = llc + nseq;
+	mlc = ofc + nseq;
+	for (i = 0; i < nseq; i++) {
+		llc[i] = ll_code(seqs[i].litlen);
+		ofc[i] = highbit32(seqs[i].offval);
+		mlc[i] = ml_code(seqs[i].matchlen);
+	}
+
+	/* Symbol compression modes, the table descriptions follow in LL, OF, ML order. */
+	p++;
+	n = seq_table(&ll_ct, &ll_mode, llc, nseq, ll_default, ARRAY_SIZE(ll_default), 6,
+		      LL_MAX_LOG, p, dst + cap - p);
+	if (n == SIZE_MAX)
+		goto out;
+	p += n;
+	n = seq_table(&of_ct, &of_mode, ofc, nseq, of_default, ARRAY_SIZE(of_default), 5,
+		      OF_MAX_LOG, p, dst + cap - p);
+	if (n == SIZE_MAX)
+		goto out;
+	p += n;
+	n = seq_table(&ml_ct, &ml_mode, mlc, nseq, ml_default, ARRAY_SIZE(ml_default), 6,
+		      ML_MAX_LOG, p, dst + cap - p);
+	if (n == SIZE_MAX)
+		goto out;
+	p += n;
+	dst[nseq < 128 ? 1 : nseq < 0x7f00 ? 2 : 3] = ll_mode << 6 | of_mode << 4 |
+						      ml_mode << 2;
+
+	/* Sequences are coded last to first, so the decoder sees them in order. */
+	bw_init(&w, p, dst + cap - p);
+	i = nseq - 1;
+	fse_cinit(&ml, &ml_ct, mlc[i]);
+	fse_cinit(&of, &of_ct, ofc[i]);
+	fse_cinit(&ll, &ll_ct, llc[i]);
+	bw_add(&w, seqs[i].litlen - ll_base[llc[i]], ll_bits[llc[i]]);
+	bw_add(&w, seqs[i].matchlen - ml_base[mlc[i]], ml_bits[mlc[i]]);
+	bw_add(&w, seqs[i].offval, ofc[i]);
+	while (i--) {
+		fse_encode(&w, &of, ofc[i]);
+		fse_encode(&w, &ml, mlc[i]);
+		fse_encode(&w, &ll, llc[i]);
+		bw_add(&w, seqs[i].litlen - ll_base[llc[i]], ll_bits[llc[i]]);
+		bw_add(&w, seqs[i].matchlen - ml_base[mlc[i]], ml_bits[mlc[i]]);
+		bw_add(&w, seqs[i].offval, ofc[i]);
+	}
+	fse_cflush(&w, &ml);
+	fse_cflush(&w, &of);
+	fse_cflush(&w, &ll);
+	n = bw_close(&w, p);
+	if (n)
+		ret = p + n - dst;
+
+out:
+	free(llc);
+	return ret;
+}
+
+static uint32_t hash4(const uint8_t *p)
+{
+	return (read32(p) * 2654435761U) >> (32 - HASH_LOG);
+}
+
+static void insert_until(struct zstd_enc *e, size_t pos)
+{
+	uint32_t h;
+
+	for (; e->inserted < pos && e->inserted + MIN_MATCH <= e->size; e->inserted++) {
+		h = hash4(e->src + e->inserted);
+		e->chain[e->inserted] = e->head[h];
+		e->head[h] = e->inserted;
+	}
+}
+
+static size_t match_len(const uint8_t *a, const uint8_t *b, size_t max)
+{
+	size_t n = 0;
+
+	while (n < max && a[n] == b[n])
+		n++;
+	return n;
+}
+
+/* A rough cost model: 4 points per matched byte, minus the bits for the offset code. */
+static int match_gain(size_t len, uint32_t offval)
+{
+	return (int)len * 4 - (int)highbit32(offval);
+}
+
+/* Finds the best match at |pos|, returns its length and sets the offset value. */
+static size_t find_match(struct zstd_enc *e, size_t pos, size_t end, size_t litlen,
+			 uint32_t *offval)
+{
+	const uint8_t *const ip = e->src + pos;
+	const size_t max = end - pos;
+	size_t len, best = 0;
+	int32_t cur;
+	unsigned int depth = CHAIN_DEPTH, i;
+	uint32_t off;
+
+	if (max < MIN_MATCH)
+		return 0;
+
+	/* Repeat offsets, shifted by one if there are no literals before the match. */
+	for (i = 0; i < 3; i++) {
+		off = !litlen ? (i == 2 ? e->rep[0] - 1 : e->rep[i + 1]) : e->rep[i];
+		if (!off || off > pos)
+			continue;
+		len = match_len(ip, ip - off, max);
+		if (len >= MIN_MATCH && (!best || match_gain(len, i + 1) > match_gain(best, *offval))) {
+			best = len;
+			*offval = i + 1;
+		}
+	}
+
+	insert_until(e, pos);
+	for (cur = e->head[hash4(ip)]; cur >= 0 && depth--; cur = e->chain[cur]) {
+		if (best >= max || ip[best] != e->src[cur + best])
+			continue;
+		len = match_len(ip, e->src + cur, max);
+		if (len < MIN_MATCH || (len == MIN_MATCH && pos - cur > 64 * KiB))
+			continue;
+		if (!best || match_gain(len, pos - cur + 3) > match_gain(best, *offval)) {
+			best = len;
+			*offval = pos - cur + 3;
+			if (len >= NICE_MATCH)
+				break;
+		}
+	}
+
+	return best;
+}
+
+/* Updates the repeat offsets like the decoder does and returns the match offset. */
+static void update_rep(uint32_t *rep, uint32_t offval, uint32_t litlen)
+{
+	uint32_t offset;
+	unsigned int idx;
+
+	if (offval > 3) {
+		rep[2] = rep[1];
+		rep[1] = rep[0];
+		rep[0] = offval - 3;
+		return;
+	}
+
+	idx = offval - 1 + !litlen;
+	if (!idx)
+		return;
+	offset = idx == 3 ? rep[0] - 1 : rep[idx];
+	if (idx != 1)
+		rep[2] = rep[1];
+	rep[1] = rep[0];
+	rep[0] = offset;
+}
+
+static void parse_block(struct zstd_enc *e, size_t start, size_t end)
+{
+	size_t pos = start, anchor = start, len, len2, step;
+	uint32_t offval = 0, offval2 = 0;
+	struct zstd_seq *seq;
+
+	e->nseq = 0;
+	e->nlits = 0;
+
+	while (pos + MIN_MATCH <= end) {
+		len = find_match(e, pos, end, pos - anchor, &offval);
+		if (!len) {
+			pos++;
+			continue;
+		}
+
+		/* Lazy evaluation: maybe a literal now buys a better match. */
+		for (step = 1; step <= 2 && pos + 1 + MIN_MATCH <= end; step++) {
+			len2 = find_match(e, pos + 1, end, pos + 1 - anchor, &offval2);
+			if (!len2 || match_gain(len2, offval2) <=
+				     match_gain(len, offval) + (step == 1 ? 4 : 7))
+				break;
+			pos++;
+			len = len2;
+			offval = offval2;
+		}
+
+		memcpy(e->lits + e->nlits, e->src + anchor, pos - anchor);
+		e->nlits += pos - anchor;
+		seq = &e->seqs[e->nseq++];
+		seq->litlen = pos - anchor;
+		seq->matchlen = len;
+		seq->offval = offval;
+		update_rep(e->rep, offval, seq->litlen);
+
+		pos += len;
+		anchor = pos;
+	}
+
+	memcpy(e->lits + e->nlits, e->src + anchor, end - anchor);
+	e->nlits += end - anchor;
+}
+
+static size_t write_block(struct zstd_enc *e, size_t start, size_t end, bool last,
+			  uint8_t *dst, size_t cap)
+{
+	const size_t size = end - start;
+	uint32_t rep[3];
+	size_t n, lit, i;
+
+	if (cap < 3 + size)
+		return 0;
+
+	for (i = 1; i < size && e->src[start + i] == e->src[start]; i++)
+		;
+	if (size > 1 && i == size) {
+		write_le(dst, last | BLOCK_RLE << 1 | size << 3, 3);
+		dst[3] = e->src[start];
+		insert_until(e, end);
+		return 4;
+	}
+
+	memcpy(rep, e->rep, sizeof(rep));
+	parse_block(e, start, end);
+
+	/* Anything that doesn't come out smaller is stored raw. */
+	lit = write_literals(dst + 3, size, e->lits, e->nlits);
+	n = lit ? write_sequences(dst + 3 + lit, size - lit, e->seqs, e->nseq) : 0;
+	if (n && lit + n < size) {
+		write_le(dst, last | BLOCK_COMPRESSED << 1 | (lit + n) << 3, 3);
+		return 3 + lit + n;
+	}
+
+	/* The decoder doesn't see the sequences of a raw block. */
+	memcpy(e->rep, rep, sizeof(rep));
+	write_le(dst, last | BLOCK_RAW << 1 | size << 3, 3);
+	memcpy(dst + 3, e->src + start, size);
+	return 3 + size;
+}
+
+int do_zstd_compress(char *in, int in_len, char *out, int *out_len)
+{
+	struct zstd_enc e = {
+		.src = (const uint8_t *)in,
+		.size = in_len,
+		.rep = { 1, 4, 8 },
+	};
+	const size_t cap = in_len + 3 * (in_len / ZSTD_BLOCK_SIZE + 1) + 18;
+	uint8_t *buf, *p;
+	size_t start, end, n;
+	int ret = -1;
+
+	buf = malloc(cap);
+	e.head = malloc(sizeof(*e.head) << HASH_LOG);
+	e.chain = malloc(sizeof(*e.chain) * MAX(in_len, 1));
+	e.seqs = malloc(sizeof(*e.seqs) * (ZSTD_BLOCK_SIZE / MIN_MATCH));
+	e.lits = malloc(ZSTD_BLOCK_SIZE);
+	if (!buf || !e.head || !e.chain || !e.seqs || !e.lits) {
+		ERROR("zstd: Out of memory.\n");
+		goto out;
+	}
+	memset(e.head, 0xff, sizeof(*e.head) << HASH_LOG);
+
+	/* Single segment frame: the window is the whole content, whose size follows. */
+	p = buf;
+	write_le(p, ZSTD_MAGIC, 4);
+	p += 4;
+	if (in_len < 256) {
+		*p++ = 0x20;
+		*p++ = in_len;
+	} else if (in_len < 65536 + 256) {
+		*p++ = 1 << 6 | 0x20;
+		write_le(p, in_len - 256, 2);
+		p += 2;
+	} else {
+		*p++ = 2 << 6 | 0x20;
+		write_le(p, in_len, 4);
+		p += 4;
+	}
+
+	start = 0;
+	do {
+		end = MIN(start + ZSTD_BLOCK_SIZE, (size_t)in_len);
+		n = write_block(&e, start, end, end == (size_t)in_len, p, buf + cap - p);
+		if (!n) {
+			ERROR("zstd: Output buffer too small.\n");
+			goto out;
+		}
+		p += n;
+		start = end;
+	} while (start < (size_t)in_len);
+
+	/* Callers only provide as much room as the input needs, like for LZ4. */
+	if (p - buf >= in_len)
+		goto out;
+	memcpy(out, buf, p - buf);
+	*out_len = p - buf;
+	ret = 0;
+
+out:
+	free(buf);
+	free(e.head);
+	free(e.chain);
+	free(e.seqs);
+	free(e.lits);
+	return ret;
+}
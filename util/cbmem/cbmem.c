@@ -18,10 +18,20 @@
 #include <libgen.h>
 #include <assert.h>
 #include <regex.h>
+#include <elf.h>
 #include <commonlib/bsd/cbmem_id.h>
+#include <commonlib/bsd/compression.h>
+#include <commonlib/bsd/fmap_index.h>
 #include <commonlib/bsd/ipchksum.h>
 #include <commonlib/bsd/tpm_log_defs.h>
+#include <commonlib/cbfs_trace_serialized.h>
+#include <commonlib/console_archive_serialized.h>
+#include <commonlib/console_binlog.h>
+#include <commonlib/coverage_serialized.h>
+#include <commonlib/device_timing_serialized.h>
+#include <commonlib/mem_usage_serialized.h>
 #include <commonlib/loglevel.h>
+#include <commonlib/profile_serialized.h>
 #include <commonlib/timestamp_serialized.h>
 #include <commonlib/tpm_log_serialized.h>
 #include <commonlib/coreboot_tables.h>
@@ -58,9 +68,28 @@ static int verbose = 0;
 #define debug(x...) if(verbose) printf(x)
 
 /* File handle used to access /dev/mem */
-static int mem_fd;
+static int mem_fd = -1;
 static struct mapping lbtable_mapping;
 
+/*
+ * Memory that is mapped or read in once, so that further mappings of parts of it are just
+ * pointers into it. With /dev/mem, this is all of CBMEM. With the kernel's coreboot driver,
+ * it is the contents of each CBMEM entry, which are read from sysfs when first used.
+ */
+struct memory_window {
+	unsigned long long phys;
+	size_t size;
+	void *data;
+	bool mapped;		/* data is a mapping of /dev/mem */
+	char *sysfs_mem;	/* file to read data from, for sysfs entries */
+};
+
+#define SYSFS_COREBOOT_DEVICES "/sys/bus/coreboot/devices"
+
+static struct memory_window *windows;
+static size_t num_windows;
+static struct mapping cbmem_mapping;
+
 /* TSC frequency from the LB_TAG_TSC_INFO record. 0 if not present. */
 static uint32_t tsc_freq_khz = 0;
 
@@ -97,6 +126,60 @@ static void *mapping_virt(const struct mapping *mapping)
 	return v + mapping->offset;
 }
 
+static bool load_window(struct memory_window *w)
+{
+	ssize_t bytes;
+	size_t done = 0;
+	int fd;
+
+	if (w->data)
+		return true;
+	if (!w->sysfs_mem)
+		return false;
+
+	fd = open(w->sysfs_mem, O_RDONLY);
+	if (fd < 0) {
+		debug("Failed to open %s: %s\n", w->sysfs_mem, strerror(errno));
+		return false;
+	}
+	w->data = malloc(w->size ? w->size : 1);
+	if (!w->data)
+		die("Failed to allocate memory");
+	while (done < w->size && (bytes = read(fd, (char *)w->data + done, w->size - done)) > 0)
+		done += bytes;
+	close(fd);
+
+	if (done != w->size) {
+		debug("Short read of %s: %zu of %zu bytes\n", w->sysfs_mem, done, w->size);
+		free(w->data);
+		w->data = NULL;
+		return false;
+	}
+	return true;
+}
+
+/* Fills in mapping to point into a window if one covers the requested memory. */
+static bool map_from_window(struct mapping *mapping, unsigned long long phys, size_t sz)
+{
+	for (size_t i = 0; i < num_windows; i++) {
+		struct memory_window *w = &windows[i];
+
+		if (phys < w->phys || sz > w->size || phys - w->phys > w->size - sz)
+			continue;
+		if (!load_window(w))
+			return false;
+
+		mapping->virt = (char *)w->data + (phys - w->phys);
+		mapping->offset = 0;
+		/* Nothing to unmap, the window stays until the end. */
+		mapping->virt_size = 0;
+		mapping->phys = phys;
+		mapping->size = sz;
+		return true;
+	}
+	return false;
+}
+
 /* Returns virtual address on success, NULL on error. mapping is filled in. */
 static void *map_memory_with_prot(struct mapping *mapping,
 				  unsigned long long phys, size_t sz, int prot)
@@ -104,6 +187,9 @@ static void *map_memory_with_prot(struct mapping *mapping,
 	void *v;
 	unsigned long long page_size;
 
+	if (prot == PROT_READ && map_from_window(mapping, phys, sz))
+		return mapping_virt(mapping);
+
 	page_size = system_page_size();
 
 	mapping->virt = NULL;
@@ -153,7 +239,8 @@ static int unmap_memory(struct mapping *mapping)
 	if (mapping->virt == NULL)
 		return -1;
 
-	munmap(mapping->virt, mapping->virt_size);
+	if (mapping->virt_size)
+		munmap(mapping->virt, mapping->virt_size);
 	mapping->virt = NULL;
 	mapping->offset = 0;
 	mapping->virt_size = 0;
@@ -550,12 +637,22 @@ static uint64_t timestamp_get(uint64_t table_tick_freq_mhz)
 static const char *timestamp_name(uint32_t id)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(timestamp_ids); i++) {
-		if (timestamp_ids[i].id == id)
+		if (timestamp_ids[i].id == TIMESTAMP_ID(id))
 			return timestamp_ids[i].name;
 	}
 	return "<unknown>";
 }
 
+/* Like timestamp_name(), but with the CPU of timestamps that were recorded per CPU. */
+static const char *timestamp_name_cpu(uint32_t id, char *buf, size_t size)
+{
+	if (!TIMESTAMP_CPU(id))
+		return timestamp_name(id);
+
+	snprintf(buf, size, "%s (CPU %u)", timestamp_name(id), TIMESTAMP_CPU(id) - 1);
+	return buf;
+}
+
 static uint32_t timestamp_enum_name_to_id(const char *name)
 {
 	for (size_t i = 0; i < ARRAY_SIZE(timestamp_ids); i++) {
@@ -569,14 +666,15 @@ static uint64_t timestamp_print_parseable_entry(uint32_t id, uint64_t stamp,
 						uint64_t prev_stamp)
 {
 	const char *name;
+	char buf[64];
 	uint64_t step_time;
 
-	name = timestamp_name(id);
+	name = timestamp_name_cpu(id, buf, sizeof(buf));
 
 	step_time = arch_convert_raw_ts_entry(stamp - prev_stamp);
 
 	/* ID<tab>absolute time<tab>relative time<tab>description */
-	printf("%d\t", id);
+	printf("%u\t", id);
 	printf("%llu\t", (long long)arch_convert_raw_ts_entry(stamp));
 	printf("%llu\t", (long long)step_time);
 	printf("%s\n", name);
@@ -587,11 +685,12 @@ static uint64_t timestamp_print_parseable_entry(uint32_t id, uint64_t stamp,
 static uint64_t timestamp_print_entry(uint32_t id, uint64_t stamp, uint64_t prev_stamp)
 {
 	const char *name;
+	char buf[64];
 	uint64_t step_time;
 
-	name = timestamp_name(id);
+	name = timestamp_name_cpu(id, buf, sizeof(buf));
 
-	printf("%4d:", id);
+	printf("%4d:", TIMESTAMP_ID(id));
 	printf("%-50s", name);
 	print_norm(arch_convert_raw_ts_entry(stamp));
 	step_time = arch_convert_raw_ts_entry(stamp - prev_stamp);
@@ -624,7 +723,7 @@ static int find_matching_end(struct timestamp_table *sorted_tst_p, uint32_t star
 	uint32_t possible_match = 0;
 
 	for (uint32_t i = 0; i < ARRAY_SIZE(timestamp_ids); ++i) {
-		if (timestamp_ids[i].id == id) {
+		if (timestamp_ids[i].id == TIMESTAMP_ID(id)) {
 			possible_match = timestamp_ids[i].id_end;
 			break;
 		}
@@ -634,6 +733,9 @@ static int find_matching_end(struct timestamp_table *sorted_tst_p, uint32_t star
 	if (!possible_match)
 		return -1;
 
+	/* The end has to be from the same CPU. */
+	possible_match |= id & ~TIMESTAMP_ID_MASK;
+
 	for (uint32_t i = start + 1; i < end; i++)
 		if (sorted_tst_p->entries[i].entry_id == possible_match)
 			return i;
@@ -644,7 +746,7 @@ static int find_matching_end(struct timestamp_table *sorted_tst_p, uint32_t star
 static const char *get_timestamp_name(const uint32_t id)
 {
 	for (uint32_t i = 0; i < ARRAY_SIZE(timestamp_ids); i++)
-		if (timestamp_ids[i].id == id)
+		if (timestamp_ids[i].id == TIMESTAMP_ID(id))
 			return timestamp_ids[i].enum_name;
 
 	return "UNKNOWN";
@@ -674,52 +776,84 @@ enum timestamps_print_type {
 	TIMESTAMPS_PRINT_NORMAL,
 	TIMESTAMPS_PRINT_MACHINE_READABLE,
 	TIMESTAMPS_PRINT_STACKED,
+	TIMESTAMPS_PRINT_JSON,
+	TIMESTAMPS_PRINT_ANALYSIS,
 };
 
-/* dump the timestamp table */
-static void dump_timestamps(enum timestamps_print_type output_type)
+/* Number of CBMEM_ID_TIMESTAMPx tables a chain can have */
+#define MAX_TIMESTAMPx 256
+
+/*
+ * Returns a sorted copy of the timestamp table with an entry for the base time
+ * added, or NULL if there is none. If there are negative timestamps, base_time
+ * is set so that the first one is 0.
+ */
+static struct timestamp_table *read_timestamps(void)
 {
 	const struct timestamp_table *tst_p;
-	struct timestamp_table *sorted_tst_p;
+	struct timestamp_table *sorted_tst_p = NULL;
+	struct timestamp_entry last;
+	uint64_t addr;
+	uint32_t num_entries = 0, num;
 	size_t size;
-	uint64_t prev_stamp = 0;
-	uint64_t total_time = 0;
 	struct mapping timestamp_mapping;
+	int tables;
 
 	if (timestamps.tag != LB_TAG_TIMESTAMPS) {
 		fprintf(stderr, "No timestamps found in coreboot table.\n");
-		return;
+		return NULL;
 	}
 
-	size = sizeof(*tst_p);
-	tst_p = map_memory(&timestamp_mapping, timestamps.cbmem_addr, size);
-	if (!tst_p)
-		die("Unable to map timestamp header\n");
-
-	timestamp_set_tick_freq(tst_p->tick_freq_mhz);
-
-	if (output_type == TIMESTAMPS_PRINT_NORMAL)
-		printf("%d entries total:\n\n", tst_p->num_entries);
-	size += tst_p->num_entries * sizeof(tst_p->entries[0]);
-
-	unmap_memory(&timestamp_mapping);
-
-	tst_p = map_memory(&timestamp_mapping, timestamps.cbmem_addr, size);
-	if (!tst_p)
-		die("Unable to map full timestamp table\n");
+	/* A full table may continue in another one, follow the chain. */
+	addr = timestamps.cbmem_addr;
+	for (tables = 0; addr && tables <= MAX_TIMESTAMPx; tables++) {
+		size = sizeof(*tst_p);
+		tst_p = map_memory(&timestamp_mapping, addr, size);
+		if (!tst_p)
+			die("Unable to map timestamp header\n");
+
+		if (!sorted_tst_p)
+			timestamp_set_tick_freq(tst_p->tick_freq_mhz);
+
+		num = tst_p->num_entries;
+		size += num * sizeof(tst_p->entries[0]);
+
+		unmap_memory(&timestamp_mapping);
+
+		tst_p = map_memory(&timestamp_mapping, addr, size);
+		if (!tst_p)
+			die("Unable to map full timestamp table\n");
+
+		/* Leave room for the base time entry below. */
+		sorted_tst_p = realloc(sorted_tst_p, sizeof(*sorted_tst_p) +
+				       (num_entries + num + 1) * sizeof(struct timestamp_entry));
+		if (!sorted_tst_p)
+			die("Failed to allocate memory");
+		if (!num_entries)
+			aligned_memcpy(sorted_tst_p, tst_p, sizeof(*tst_p));
+		aligned_memcpy(&sorted_tst_p->entries[num_entries], tst_p->entries,
+			       num * sizeof(tst_p->entries[0]));
+		num_entries += num;
+
+		addr = 0;
+		if (num && num == tst_p->max_entries) {
+			aligned_memcpy(&last, &tst_p->entries[num - 1], sizeof(last));
+			if (last.entry_id == TIMESTAMP_TABLE_CONTINUED) {
+				addr = last.entry_stamp;
+				num_entries--;
+			}
+		}
 
-	sorted_tst_p = malloc(size + sizeof(struct timestamp_entry));
-	if (!sorted_tst_p)
-		die("Failed to allocate memory");
-	aligned_memcpy(sorted_tst_p, tst_p, size);
+		unmap_memory(&timestamp_mapping);
+	}
 
 	/*
 	 * Insert a timestamp to represent the base time (start of coreboot),
 	 * in case we have to rebase for negative timestamps below.
 	 */
-	sorted_tst_p->entries[tst_p->num_entries].entry_id = 0;
-	sorted_tst_p->entries[tst_p->num_entries].entry_stamp = 0;
-	sorted_tst_p->num_entries += 1;
+	sorted_tst_p->entries[num_entries].entry_id = 0;
+	sorted_tst_p->entries[num_entries].entry_stamp = 0;
+	sorted_tst_p->num_entries = num_entries + 1;
 
 	qsort(&sorted_tst_p->entries[0], sorted_tst_p->num_entries,
 	      sizeof(struct timestamp_entry), compare_timestamp_entries);
@@ -728,12 +862,27 @@ static void dump_timestamps(enum timestamps_print_type output_type)
 	 * If there are negative timestamp entries, rebase all of the
 	 * timestamps to the lowest one in the list.
 	 */
-	if (sorted_tst_p->entries[0].entry_stamp < 0) {
+	if (sorted_tst_p->entries[0].entry_stamp < 0)
 		sorted_tst_p->base_time = -sorted_tst_p->entries[0].entry_stamp;
-		prev_stamp = 0;
-	} else {
-		prev_stamp = tst_p->base_time;
-	}
+
+	return sorted_tst_p;
+}
+
+/* dump the timestamp table */
+static void dump_timestamps(enum timestamps_print_type output_type)
+{
+	struct timestamp_table *sorted_tst_p = read_timestamps();
+	uint64_t prev_stamp = 0;
+	uint64_t total_time = 0;
+
+	if (!sorted_tst_p)
+		return;
+
+	if (output_type == TIMESTAMPS_PRINT_NORMAL)
+		printf("%d entries total:\n\n", sorted_tst_p->num_entries - 1);
+
+	if (sorted_tst_p->entries[0].entry_stamp >= 0)
+		prev_stamp = sorted_tst_p->base_time;
 
 	struct ts_range_stack range_stack[20];
 	range_stack[0].end = sorted_tst_p->num_entries;
@@ -788,10 +937,436 @@ static void dump_timestamps(enum timestamps_print_type output_type)
 		printf("\n");
 	}
 
-	unmap_memory(&timestamp_mapping);
 	free(sorted_tst_p);
 }
 
+/*
+ * Boot timeline analysis. The timestamps are split into stages at the stage
+ * start timestamps below, and every timestamp that has a matching end in
+ * timestamp_ids[] forms a range (e.g. TS_INITRAM_START -> TS_INITRAM_END).
+ * Ranges that are not nested in another range make up the critical path of
+ * their stage; whatever is left over is reported as "(other)".
+ */
+struct ts_sample {
+	uint32_t id;
+	uint64_t us;
+};
+
+struct ts_span {
+	char name[64];
+	const char *stage;
+	uint64_t start;
+	uint64_t duration;
+	bool nested;
+};
+
+struct ts_timeline {
+	struct ts_span *stages;
+	size_t num_stages;
+	struct ts_span *ranges;
+	size_t num_ranges;
+	uint64_t total;
+};
+
+static const struct {
+	uint32_t id;
+	const char *name;
+} ts_stages[] = {
+	{ TS_BOOTBLOCK_START, "bootblock" },
+	{ TS_ROMSTAGE_START, "romstage" },
+	{ TS_POSTCAR_START, "postcar" },
+	{ TS_RAMSTAGE_START, "ramstage" },
+	{ TS_SELFBOOT_JUMP, "payload" },
+	{ TS_ACPI_WAKE_JUMP, "resume" },
+	{ TS_KERNEL_START, "kernel" },
+};
+
+/* Minimal increase in microseconds for a span to count as a regression. */
+#define TS_REGRESSION_MIN_US	500
+
+static const char *ts_stage_name(uint32_t id)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(ts_stages); i++)
+		if (ts_stages[i].id == id)
+			return ts_stages[i].name;
+	return NULL;
+}
+
+static uint32_t ts_range_end(uint32_t id)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(timestamp_ids); i++)
+		if (timestamp_ids[i].id == id)
+			return timestamp_ids[i].id_end;
+	return 0;
+}
+
+static void ts_range_name(char *buf, size_t size, uint32_t id)
+{
+	const char *name = get_timestamp_name(id);
+	size_t len = strlen(name);
+
+	/* TS_INITRAM_START -> TS_INITRAM */
+	if (len > 6 && !strcmp(name + len - 6, "_START"))
+		len -= 6;
+	snprintf(buf, size, "%.*s", (int)len, name);
+}
+
+static struct ts_span *ts_add_span(struct ts_span **spans, size_t *num)
+{
+	struct ts_span *span;
+
+	*spans = realloc(*spans, (*num + 1) * sizeof(**spans));
+	if (!*spans)
+		die("Failed to allocate memory");
+	span = &(*spans)[(*num)++];
+	memset(span, 0, sizeof(*span));
+	return span;
+}
+
+static void ts_build_timeline(const struct ts_sample *samples, size_t num,
+			      struct ts_timeline *tl)
+{
+	const char *stage = "early";
+	struct ts_span *cur = NULL;
+
+	memset(tl, 0, sizeof(*tl));
+	if (!num)
+		return;
+
+	tl->total = samples[num - 1].us - samples[0].us;
+
+	for (size_t i = 0; i < num; i++) {
+		const char *name = ts_stage_name(samples[i].id);
+
+		if (name || !cur) {
+			if (cur)
+				cur->duration = samples[i].us - cur->start;
+			if (name)
+				stage = name;
+			cur = ts_add_span(&tl->stages, &tl->num_stages);
+			snprintf(cur->name, sizeof(cur->name), "%s", stage);
+			cur->stage = stage;
+			cur->start = samples[i].us;
+		}
+
+		const uint32_t end = ts_range_end(samples[i].id);
+		if (!end || name)
+			continue;
+
+		for (size_t j = i + 1; j < num; j++) {
+			if (samples[j].id != end)
+				continue;
+			struct ts_span *r = ts_add_span(&tl->ranges, &tl->num_ranges);
+			ts_range_name(r->name, sizeof(r->name), samples[i].id);
+			r->stage = stage;
+			r->start = samples[i].us;
+			r->duration = samples[j].us - samples[i].us;
+			break;
+		}
+	}
+	cur->duration = samples[num - 1].us - cur->start;
+
+	for (size_t i = 0; i < tl->num_ranges; i++) {
+		struct ts_span *r = &tl->ranges[i];
+		for (size_t j = 0; j < tl->num_ranges && !r->nested; j++) {
+			const struct ts_span *o = &tl->ranges[j];
+			if (j == i || o->duration < r->duration)
+				continue;
+			/* Equal ranges: only the later one is nested. */
+			if (o->duration == r->duration && o->start == r->start && j > i)
+				continue;
+			r->nested = o->start <= r->start &&
+				    r->start + r->duration <= o->start + o->duration;
+		}
+	}
+}
+
+static void ts_free_timeline(struct ts_timeline *tl)
+{
+	free(tl->stages);
+	free(tl->ranges);
+}
+
+static struct ts_sample *ts_samples_from_table(const struct timestamp_table *tst, size_t *num)
+{
+	struct ts_sample *samples = calloc(tst->num_entries, sizeof(*samples));
+
+	if (!samples)
+		die("Failed to allocate memory");
+	for (uint32_t i = 0; i < tst->num_entries; i++) {
+		samples[i].id = tst->entries[i].entry_id;
+		samples[i].us = arch_convert_raw_ts_entry(tst->entries[i].entry_stamp +
+							  tst->base_time);
+	}
+	*num = tst->num_entries;
+	return samples;
+}
+
+/* Reads a baseline in the format printed by --parseable-timestamps. */
+static struct ts_sample *ts_samples_from_file(const char *path, size_t *num)
+{
+	struct ts_sample *samples = NULL;
+	unsigned long long us;
+	unsigned int id;
+	char line[256];
+	FILE *f = fopen(path, "r");
+
+	if (!f) {
+		fprintf(stderr, "Could not open baseline %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+
+	*num = 0;
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%u\t%llu", &id, &us) != 2)
+			continue;
+		samples = realloc(samples, (*num + 1) * sizeof(*samples));
+		if (!samples)
+			die("Failed to allocate memory");
+		samples[*num].id = id;
+		samples[*num].us = us;
+		(*num)++;
+	}
+	fclose(f);
+
+	if (!*num) {
+		fprintf(stderr, "No timestamps found in baseline %s\n", path);
+		exit(1);
+	}
+	return samples;
+}
+
+static void json_print_string(const char *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < 0x20)
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+static void ts_print_json(const struct ts_sample *samples, size_t num, const struct ts_timeline *tl)
+{
+	printf("{\n  \"total_us\": %llu,\n  \"timestamps\": [", (unsigned long long)tl->total);
+	for (size_t i = 0; i < num; i++) {
+		printf("%s\n    { \"id\": %u, \"name\": ", i ? "," : "", samples[i].id);
+		json_print_string(get_timestamp_name(samples[i].id));
+		printf(", \"description\": ");
+		json_print_string(timestamp_name(samples[i].id));
+		printf(", \"time_us\": %llu, \"delta_us\": %llu }", (unsigned long long)samples[i].us,
+		       (unsigned long long)(i ? samples[i].us - samples[i - 1].us : 0));
+	}
+	printf("\n  ],\n  \"stages\": [");
+	for (size_t i = 0; i < tl->num_stages; i++) {
+		printf("%s\n    { \"name\": ", i ? "," : "");
+		json_print_string(tl->stages[i].name);
+		printf(", \"start_us\": %llu, \"duration_us\": %llu }",
+		       (unsigned long long)tl->stages[i].start,
+		       (unsigned long long)tl->stages[i].duration);
+	}
+	printf("\n  ],\n  \"ranges\": [");
+	for (size_t i = 0; i < tl->num_ranges; i++) {
+		printf("%s\n    { \"name\": ", i ? "," : "");
+		json_print_string(tl->ranges[i].name);
+		printf(", \"stage\": ");
+		json_print_string(tl->ranges[i].stage);
+		printf(", \"start_us\": %llu, \"duration_us\": %llu, \"nested\": %s }",
+		       (unsigned long long)tl->ranges[i].start,
+		       (unsigned long long)tl->ranges[i].duration,
+		       tl->ranges[i].nested ? "true" : "false");
+	}
+	printf("\n  ]\n}\n");
+}
+
+static void ts_print_duration(uint64_t us)
+{
+	printf("%10llu.%03llu ms", (unsigned long long)(us / 1000),
+	       (unsigned long long)(us % 1000));
+}
+
+/* Sum of the durations of all ranges called |name| in |stage|. */
+static uint64_t ts_range_total(const struct ts_timeline *tl, const char *stage, const char *name,
+			       bool top_level_only, bool *found)
+{
+	uint64_t total = 0;
+
+	*found = false;
+	for (size_t i = 0; i < tl->num_ranges; i++) {
+		const struct ts_span *r = &tl->ranges[i];
+		if (strcmp(r->stage, stage) || strcmp(r->name, name))
+			continue;
+		if (top_level_only && r->nested)
+			continue;
+		total += r->duration;
+		*found = true;
+	}
+	return total;
+}
+
+static bool ts_seen_before(const struct ts_span *spans, size_t idx)
+{
+	for (size_t i = 0; i < idx; i++)
+		if (!strcmp(spans[i].stage, spans[idx].stage) &&
+		    !strcmp(spans[i].name, spans[idx].name))
+			return true;
+	return false;
+}
+
+static void ts_print_critical_path(const struct ts_timeline *tl)
+{
+	printf("Boot timeline, total ");
+	ts_print_duration(tl->total);
+	printf(":\n\n");
+
+	for (size_t s = 0; s < tl->num_stages; s++) {
+		const struct ts_span *stage = &tl->stages[s];
+		uint64_t accounted = 0;
+		bool found;
+
+		/* A stage can be entered twice, e.g. romstage after a vboot reset. */
+		if (ts_seen_before(tl->stages, s))
+			continue;
+
+		uint64_t duration = 0;
+		for (size_t i = s; i < tl->num_stages; i++)
+			if (!strcmp(tl->stages[i].name, stage->name))
+				duration += tl->stages[i].duration;
+
+		printf("%-40s", stage->name);
+		ts_print_duration(duration);
+		printf(" %5.1f%%\n", tl->total ? 100.0 * duration / tl->total : 0.0);
+
+		for (size_t i = 0; i < tl->num_ranges; i++) {
+			const struct ts_span *r = &tl->ranges[i];
+			if (r->nested || strcmp(r->stage, stage->name) || ts_seen_before(tl->ranges, i))
+				continue;
+			const uint64_t t = ts_range_total(tl, r->stage, r->name, true, &found);
+			accounted += t;
+			printf("  %-38s", r->name);
+			ts_print_duration(t);
+			printf(" %5.1f%%\n", duration ? 100.0 * t / duration : 0.0);
+		}
+		if (accounted && accounted < duration) {
+			printf("  %-38s", "(other)");
+			ts_print_duration(duration - accounted);
+			printf(" %5.1f%%\n", 100.0 * (duration - accounted) / duration);
+		}
+	}
+}
+
+static uint64_t ts_stage_total(const struct ts_timeline *tl, const char *name, bool *found)
+{
+	uint64_t total = 0;
+
+	*found = false;
+	for (size_t i = 0; i < tl->num_stages; i++) {
+		if (strcmp(tl->stages[i].name, name))
+			continue;
+		total += tl->stages[i].duration;
+		*found = true;
+	}
+	return total;
+}
+
+static bool ts_compare_span(const char *name, uint64_t base, uint64_t cur,
+			    unsigned int threshold)
+{
+	const bool regression = cur > base + TS_REGRESSION_MIN_US &&
+				(cur - base) * 100 > (uint64_t)base * threshold;
+
+	printf("%-40s", name);
+	ts_print_duration(base);
+	printf(" ->");
+	ts_print_duration(cur);
+	if (base)
+		printf(" %+7.1f%%", 100.0 * ((double)cur - base) / base);
+	else if (cur)
+		printf("      new");
+	printf("%s\n", regression ? "  REGRESSION" : "");
+
+	return regression;
+}
+
+/* Returns the number of stages and ranges that regressed over |threshold| percent. */
+static int ts_compare_baseline(const struct ts_timeline *tl, const struct ts_timeline *base,
+			       unsigned int threshold)
+{
+	int regressions = 0;
+	char name[sizeof(tl->ranges[0].name) + 32];
+	bool found;
+
+	printf("\nComparison with baseline (threshold %u%%):\n\n", threshold);
+	regressions += ts_compare_span("total", base->total, tl->total, threshold);
+
+	for (size_t s = 0; s < tl->num_stages; s++) {
+		const char *stage = tl->stages[s].name;
+		bool cur_found;
+
+		if (ts_seen_before(tl->stages, s))
+			continue;
+
+		const uint64_t b = ts_stage_total(base, stage, &found);
+		const uint64_t c = ts_stage_total(tl, stage, &cur_found);
+		regressions += ts_compare_span(stage, found ? b : 0, c, threshold);
+
+		for (size_t i = 0; i < tl->num_ranges; i++) {
+			const struct ts_span *r = &tl->ranges[i];
+			if (strcmp(r->stage, stage) || ts_seen_before(tl->ranges, i))
+				continue;
+			const uint64_t rb = ts_range_total(base, stage, r->name, false, &found);
+			const uint64_t rc = ts_range_total(tl, stage, r->name, false, &cur_found);
+			snprintf(name, sizeof(name), "  %s", r->name);
+			regressions += ts_compare_span(name, found ? rb : 0, rc, threshold);
+		}
+	}
+
+	printf("\n%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+	return regressions;
+}
+
+/* Returns non-zero if a regression against the baseline was found. */
+static int analyze_timestamps(enum timestamps_print_type output_type, const char *baseline,
+			      unsigned int threshold)
+{
+	struct timestamp_table *sorted_tst_p = read_timestamps();
+	struct ts_sample *samples;
+	struct ts_timeline tl;
+	size_t num;
+	int regressions = 0;
+
+	if (!sorted_tst_p)
+		return 0;
+
+	samples = ts_samples_from_table(sorted_tst_p, &num);
+	free(sorted_tst_p);
+	ts_build_timeline(samples, num, &tl);
+
+	if (output_type == TIMESTAMPS_PRINT_JSON) {
+		ts_print_json(samples, num, &tl);
+	} else {
+		ts_print_critical_path(&tl);
+		if (baseline) {
+			struct ts_timeline base;
+			size_t base_num;
+			struct ts_sample *base_samples = ts_samples_from_file(baseline, &base_num);
+
+			ts_build_timeline(base_samples, base_num, &base);
+			regressions = ts_compare_baseline(&tl, &base, threshold);
+			ts_free_timeline(&base);
+			free(base_samples);
+		}
+	}
+
+	ts_free_timeline(&tl);
+	free(samples);
+	return regressions != 0;
+}
+
 /* add a timestamp entry */
 static void timestamp_add_now(uint32_t timestamp_id)
 {
@@ -1133,40 +1708,402 @@ static int parse_loglevel(char *arg, int *print_unknown_logs)
 	return BIOS_NEVER;
 }
 
-/* dump the cbmem console */
-static void dump_console(enum console_print_type type, int max_loglevel, int print_unknown_logs)
+/* The .text sections of the stages, for CONSOLE_CBMEM_BINARY_LOG records. */
+static struct {
+	char *data;
+	size_t size;
+} console_strings[BINLOG_STAGE_MAX + 1];
+
+static void load_console_strings(const char *path)
 {
-	const struct cbmem_console *console_p;
-	char *console_c;
-	size_t size, cursor, previous;
-	struct mapping console_mapping;
+	unsigned int stage, size;
+	char line[64];
+	FILE *f;
 
-	if (console.tag != LB_TAG_CBMEM_CONSOLE) {
-		fprintf(stderr, "No console found in coreboot table.\n");
-		return;
+	f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		exit(1);
 	}
 
-	size = sizeof(*console_p);
-	console_p = map_memory(&console_mapping, console.cbmem_addr, size);
-	if (!console_p)
-		die("Unable to map console object.\n");
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, BINLOG_STRTAB_HEADER, &stage, &size) != 2 ||
+		    stage > BINLOG_STAGE_MAX || console_strings[stage].data)
+			die("Not a console string table.\n");
+
+		/* One more byte so a format string always ends. */
+		console_strings[stage].data = calloc(1, size + 1);
+		if (!console_strings[stage].data)
+			die("Not enough memory for the console strings.\n");
+		if (fread(console_strings[stage].data, 1, size, f) != size)
+			die("Console string table is truncated.\n");
+		console_strings[stage].size = size;
+	}
 
-	cursor = console_p->cursor & CBMC_CURSOR_MASK;
-	if (!(console_p->cursor & CBMC_OVERFLOW) && cursor < console_p->size)
-		size = cursor;
-	else
-		size = console_p->size;
-	unmap_memory(&console_mapping);
+	fclose(f);
+}
 
-	console_c = malloc(size + 1);
-	if (!console_c) {
-		fprintf(stderr, "Not enough memory for console.\n");
-		exit(1);
+struct binlog_args {
+	const uint8_t *p;
+	const uint8_t *end;
+};
+
+static bool binlog_get_num(struct binlog_args *a, uint64_t *num)
+{
+	*num = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (a->p >= a->end)
+			return false;
+		*num |= (uint64_t)(*a->p & 0x7f) << shift;
+		if (!(*a->p++ & 0x80))
+			return true;
 	}
-	console_c[size] = '\0';
+	return false;
+}
 
-	console_p = map_memory(&console_mapping, console.cbmem_addr,
-		size + sizeof(*console_p));
+static bool binlog_get_int(struct binlog_args *a, int *val)
+{
+	uint64_t num;
+
+	if (!binlog_get_num(a, &num))
+		return false;
+	*val = (int)num;
+	return true;
+}
+
+/* Prints fmt with the arguments of a record the way vtxprintf() would. */
+static bool binlog_format(FILE *out, const char *fmt, struct binlog_args *a)
+{
+	char spec[32];
+	int width, precision;
+	bool left;
+	size_t n;
+	uint64_t num, len;
+
+	for (; *fmt; ++fmt) {
+		if (*fmt != '%') {
+			fputc(*fmt, out);
+			continue;
+		}
+
+		n = 0;
+		spec[n++] = '%';
+		left = false;
+		while (*++fmt && strchr("-+ #0", *fmt)) {
+			if (*fmt == '-')
+				left = true;
+			spec[n++] = *fmt;
+		}
+
+		width = -1;
+		if (isdigit(*fmt)) {
+			width = strtol(fmt, (char **)&fmt, 10);
+		} else if (*fmt == '*') {
+			++fmt;
+			if (!binlog_get_int(a, &width))
+				return false;
+			if (width < 0) {
+				width = -width;
+				left = true;
+				spec[n++] = '-';
+			}
+		}
+
+		precision = -1;
+		if (*fmt == '.') {
+			++fmt;
+			if (isdigit(*fmt)) {
+				precision = strtol(fmt, (char **)&fmt, 10);
+			} else if (*fmt == '*') {
+				++fmt;
+				if (!binlog_get_int(a, &precision))
+					return false;
+			}
+			if (precision < 0)
+				precision = 0;
+		}
+
+		/* The numbers are stored with 64 bits, whatever their size was. */
+		while (*fmt && strchr("hlLzj", *fmt))
+			++fmt;
+
+		switch (*fmt) {
+		case 'c':
+			if (!binlog_get_num(a, &num))
+				return false;
+			fprintf(out, left ? "%-*c" : "%*c", width, (int)num);
+			continue;
+		case 's':
+			if (!binlog_get_num(a, &len) || len > (size_t)(a->end - a->p))
+				return false;
+			fprintf(out, left ? "%-*.*s" : "%*.*s", width, (int)len, a->p);
+			a->p += len;
+			continue;
+		case 'p':
+			if (!binlog_get_num(a, &num))
+				return false;
+			if (width == -1 && precision == -1)
+				precision = 8;
+			fprintf(out, "0x%.*" PRIx64, precision, num);
+			continue;
+		case '%':
+			fputc('%', out);
+			continue;
+		case 'd':
+		case 'i':
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			break;
+		case '\0':
+			fputc('%', out);
+			return a->p == a->end;
+		default:
+			fprintf(out, "%%%c", *fmt);
+			continue;
+		}
+
+		if (!binlog_get_num(a, &num))
+			return false;
+		if (width >= 0)
+			n += snprintf(spec + n, sizeof(spec) - n, "%d", width);
+		if (precision >= 0)
+			n += snprintf(spec + n, sizeof(spec) - n, ".%d", precision);
+		snprintf(spec + n, sizeof(spec) - n, "ll%c", *fmt);
+		if (*fmt == 'd' || *fmt == 'i')
+			fprintf(out, spec, (long long)num);
+		else
+			fprintf(out, spec, (unsigned long long)num);
+	}
+
+	return a->p == a->end;
+}
+
+/*
+ * Decodes the record at buf into text, with a level marker at the start of
+ * every line. Returns the size of the record, 0 if it isn't one.
+ */
+static size_t decode_binlog_record(FILE *out, const uint8_t *buf, size_t size)
+{
+	unsigned int level, stage;
+	uint32_t offset;
+	size_t args_size;
+	struct binlog_args a;
+	char *text = NULL;
+	size_t text_size = 0;
+	FILE *line;
+
+	if (size < BINLOG_RECORD_HEADER_SIZE || buf[0] != BINLOG_MARKER)
+		return 0;
+
+	level = buf[1];
+	stage = buf[2];
+	offset = buf[3] | buf[4] << 8 | buf[5] << 16 | (uint32_t)buf[6] << 24;
+	args_size = buf[7] | buf[8] << 8;
+	if (stage == 0 || stage > BINLOG_STAGE_MAX ||
+	    args_size > size - BINLOG_RECORD_HEADER_SIZE)
+		return 0;
+
+	a.p = buf + BINLOG_RECORD_HEADER_SIZE;
+	a.end = a.p + args_size;
+
+	if (!console_strings[stage].data) {
+		if (level <= BIOS_LOG_PREFIX_MAX_LEVEL)
+			fputc(BIOS_LOG_LEVEL_TO_MARKER(level), out);
+		fprintf(out, "<binary log record, stage %u, format 0x%x, use -s>\n",
+			stage, offset);
+		return BINLOG_RECORD_HEADER_SIZE + args_size;
+	}
+
+	if (offset >= console_strings[stage].size)
+		return 0;
+
+	line = open_memstream(&text, &text_size);
+	if (!line)
+		die("Not enough memory for console.\n");
+	if (!binlog_format(line, console_strings[stage].data + offset, &a)) {
+		fclose(line);
+		free(text);
+		return 0;
+	}
+	fclose(line);
+
+	for (size_t i = 0; i < text_size; i++) {
+		if ((i == 0 || text[i - 1] == '\n') && level <= BIOS_LOG_PREFIX_MAX_LEVEL)
+			fputc(BIOS_LOG_LEVEL_TO_MARKER(level), out);
+		fputc(text[i], out);
+	}
+	free(text);
+
+	return BINLOG_RECORD_HEADER_SIZE + args_size;
+}
+
+/* Replaces the binary log records in the console with their text. */
+static char *decode_binlog(char *console_c, size_t *size)
+{
+	char *text = NULL;
+	size_t text_size = 0, cursor, n;
+	FILE *out;
+
+	if (!memchr(console_c, BINLOG_MARKER, *size))
+		return console_c;
+
+	out = open_memstream(&text, &text_size);
+	if (!out)
+		die("Not enough memory for console.\n");
+
+	for (cursor = 0; cursor < *size; cursor += n) {
+		n = decode_binlog_record(out, (uint8_t *)console_c + cursor, *size - cursor);
+		if (!n) {
+			fputc(console_c[cursor], out);
+			n = 1;
+		}
+	}
+	fclose(out);
+
+	free(console_c);
+	*size = text_size;
+	return text;
+}
+
+/* Decompresses one LZ4 block, by wrapping it into a frame for ulz4fn(). */
+static size_t decompress_lz4_block(const void *block, size_t block_size, void *dst,
+				   size_t dst_size)
+{
+	const uint8_t header[] = { 0x04, 0x22, 0x4d, 0x18, 0x60, 0x40, 0x00 };
+	uint8_t *frame = calloc(1, sizeof(header) + 4 + block_size + 4);
+	size_t ret;
+
+	if (!frame)
+		die("Not enough memory for console.\n");
+
+	memcpy(frame, header, sizeof(header));
+	frame[7] = block_size;
+	frame[8] = block_size >> 8;
+	frame[9] = block_size >> 16;
+	frame[10] = block_size >> 24;
+	memcpy(frame + 11, block, block_size);
+
+	ret = ulz4fn(frame, sizeof(header) + 4 + block_size + 4, dst, dst_size);
+	free(frame);
+	return ret;
+}
+
+/*
+ * Puts the pages of CBMEM_ID_CONSOLE_ARCHIVE in front of the console, which is
+ * size bytes at console_c starting with the oldest. cursor and console_size
+ * are those of the console in CBMEM.
+ */
+static char *prepend_console_archive(char *console_c, size_t *size, bool overflowed,
+				     size_t cursor, size_t console_size)
+{
+	const struct console_archive *a;
+	const struct console_archive_segment *seg;
+	struct mapping archive_mapping;
+	uint64_t start;
+	size_t area_size, text_size = 0, skip = 0;
+	uint32_t offset, block_size;
+	char *text = NULL, *page;
+	FILE *out;
+
+	if (find_cbmem_entry(CBMEM_ID_CONSOLE_ARCHIVE, &start, &area_size) ||
+	    area_size < sizeof(*a))
+		return console_c;
+
+	a = map_memory(&archive_mapping, start, area_size);
+	if (!a)
+		die("Unable to map console archive.\n");
+
+	if (a->magic != CONSOLE_ARCHIVE_MAGIC || a->size > area_size - sizeof(*a) ||
+	    !a->page_size || !a->segments) {
+		unmap_memory(&archive_mapping);
+		return console_c;
+	}
+
+	page = malloc(a->page_size);
+	out = open_memstream(&text, &text_size);
+	if (!page || !out)
+		die("Not enough memory for console.\n");
+
+	if (a->dropped)
+		fprintf(out, "\n*** %u bytes of older console output dropped ***\n",
+			a->dropped);
+
+	offset = a->head;
+	for (uint32_t i = 0; i < a->segments; i++) {
+		if (offset + sizeof(*seg) > a->size ||
+		    !((const struct console_archive_segment *)&a->data[offset])->text_size)
+			offset = 0;
+		seg = (const void *)&a->data[offset];
+		block_size = seg->block_size & ~CONSOLE_ARCHIVE_STORED;
+
+		if (seg->text_size > a->page_size || offset + sizeof(*seg) + block_size > a->size) {
+			fprintf(out, "\n*** console archive is corrupt ***\n");
+			break;
+		}
+
+		if (seg->block_size & CONSOLE_ARCHIVE_STORED) {
+			fwrite(seg + 1, 1, MIN(block_size, seg->text_size), out);
+		} else if (decompress_lz4_block(seg + 1, block_size, page, a->page_size) ==
+			   seg->text_size) {
+			fwrite(page, 1, seg->text_size, out);
+		} else {
+			fprintf(out, "\n*** console archive page is corrupt ***\n");
+		}
+
+		offset += (sizeof(*seg) + block_size + 3) & ~3;
+	}
+
+	/* The newest archived page is also at the start of the console. */
+	if (overflowed)
+		skip = MIN((cursor / a->page_size + 1) * a->page_size, console_size) - cursor;
+	if (skip < *size)
+		fwrite(console_c + skip, 1, *size - skip, out);
+
+	fclose(out);
+	free(page);
+	free(console_c);
+	unmap_memory(&archive_mapping);
+
+	*size = text_size;
+	return text;
+}
+
+/* dump the cbmem console */
+static void dump_console(enum console_print_type type, int max_loglevel, int print_unknown_logs)
+{
+	const struct cbmem_console *console_p;
+	char *console_c;
+	size_t size, cursor, previous;
+	struct mapping console_mapping;
+
+	if (console.tag != LB_TAG_CBMEM_CONSOLE) {
+		fprintf(stderr, "No console found in coreboot table.\n");
+		return;
+	}
+
+	size = sizeof(*console_p);
+	console_p = map_memory(&console_mapping, console.cbmem_addr, size);
+	if (!console_p)
+		die("Unable to map console object.\n");
+
+	cursor = console_p->cursor & CBMC_CURSOR_MASK;
+	if (!(console_p->cursor & CBMC_OVERFLOW) && cursor < console_p->size)
+		size = cursor;
+	else
+		size = console_p->size;
+	unmap_memory(&console_mapping);
+
+	console_c = malloc(size + 1);
+	if (!console_c) {
+		fprintf(stderr, "Not enough memory for console.\n");
+		exit(1);
+	}
+	console_c[size] = '\0';
+
+	console_p = map_memory(&console_mapping, console.cbmem_addr,
+		size + sizeof(*console_p));
 
 	if (!console_p)
 		die("Unable to map full console object.\n");
@@ -1185,6 +2122,10 @@ static void dump_console(enum console_print_type type, int max_loglevel, int pri
 		aligned_memcpy(console_c, console_p->body, size);
 	}
 
+	console_c = prepend_console_archive(console_c, &size, console_p->cursor & CBMC_OVERFLOW,
+					    cursor, console_p->size);
+	console_c = decode_binlog(console_c, &size);
+
 	/* Slight memory corruption may occur between reboots and give us a few
 	   unprintable characters like '\0'. Replace them with '?' on output. */
 	for (cursor = 0; cursor < size; cursor++)
@@ -1386,6 +2327,12 @@ static void cbmem_print_entry(int n, uint32_t id, uint64_t base, uint64_t size)
 				(id - CBMEM_ID_STAGEx_META));
 			name = stage_x;
 		}
+		if (id >= CBMEM_ID_TIMESTAMPx &&
+			id < CBMEM_ID_TIMESTAMPx + MAX_TIMESTAMPx) {
+			snprintf(stage_x, sizeof(stage_x), "TIME STAMP%d",
+				(id - CBMEM_ID_TIMESTAMPx + 1));
+			name = stage_x;
+		}
 		if (id >= CBMEM_ID_STAGEx_CACHE &&
 			id < CBMEM_ID_STAGEx_CACHE + MAX_STAGEx) {
 			snprintf(stage_x, sizeof(stage_x), "STAGE%d $  ",
@@ -1436,16 +2383,6 @@ static void dump_cbmem_toc(void)
 	}
 }
 
-#define COVERAGE_MAGIC 0x584d4153
-struct file {
-	uint32_t magic;
-	uint32_t next;
-	uint32_t filename;
-	uint32_t data;
-	int offset;
-	int len;
-};
-
 static int mkpath(char *path, mode_t mode)
 {
 	assert (path && *path);
@@ -1463,14 +2400,175 @@ static int mkpath(char *path, mode_t mode)
 	return 0;
 }
 
+/* .gcda format of GCC 4.7, the version that coreboot's libgcov implements */
+#define GCOV_DATA_MAGIC			0x67636461
+#define GCOV_TAG_FUNCTION		0x01000000
+#define GCOV_TAG_FUNCTION_LENGTH	3
+#define GCOV_TAG_FOR_COUNTER(ctr)	(0x01a10000 + ((uint32_t)(ctr) << 17))
+#define GCOV_TAG_PROGRAM_SUMMARY	0xa3000000
+#define GCOV_TAG_SUMMARY_LENGTH		9
+#define GCOV_COUNTERS			8
+
+struct coverage_reader {
+	const uint32_t *words;
+	size_t pos;
+	size_t num;
+};
+
+static uint32_t coverage_read(struct coverage_reader *r)
+{
+	if (r->pos >= r->num)
+		die("Coverage data is truncated.\n");
+	return r->words[r->pos++];
+}
+
+static void coverage_skip(struct coverage_reader *r, size_t words)
+{
+	if (words > r->num - r->pos)
+		die("Coverage data is truncated.\n");
+	r->pos += words;
+}
+
+/* Same as crc32_unsigned() in libgcov */
+static uint32_t gcov_crc32(uint32_t crc32, uint32_t value)
+{
+	unsigned int i;
+
+	for (i = 32; i--; value <<= 1) {
+		const uint32_t feedback = (value ^ crc32) & 0x80000000 ? 0x04c11db7 : 0;
+
+		crc32 <<= 1;
+		crc32 ^= feedback;
+	}
+
+	return crc32;
+}
+
+struct coverage_summary {
+	uint32_t checksum;
+	uint32_t num;
+	uint64_t sum_all;
+	uint64_t run_max;
+};
+
+/*
+ * Walk one object and add it to the program summary. If f is not NULL, write its
+ * functions to the .gcda file as well.
+ */
+static void coverage_walk_object(struct coverage_reader *r, const struct coverage_object *obj,
+				 struct coverage_summary *summary, FILE *f)
+{
+	uint32_t f_ix, t_ix, i;
+
+	summary->checksum = gcov_crc32(summary->checksum, obj->stamp);
+	summary->checksum = gcov_crc32(summary->checksum, obj->n_functions);
+
+	for (f_ix = 0; f_ix < obj->n_functions; f_ix++) {
+		struct coverage_function fn = { .present = coverage_read(r) };
+		uint32_t header[5];
+
+		if (!fn.present) {
+			summary->checksum = gcov_crc32(summary->checksum, 0);
+			summary->checksum = gcov_crc32(summary->checksum, 0);
+			header[0] = GCOV_TAG_FUNCTION;
+			header[1] = 0;
+			if (f && fwrite(header, sizeof(uint32_t), 2, f) != 2)
+				die("Could not write coverage data.\n");
+			continue;
+		}
+
+		fn.ident = coverage_read(r);
+		fn.lineno_checksum = coverage_read(r);
+		fn.cfg_checksum = coverage_read(r);
+		summary->checksum = gcov_crc32(summary->checksum, fn.cfg_checksum);
+		summary->checksum = gcov_crc32(summary->checksum, fn.lineno_checksum);
+
+		header[0] = GCOV_TAG_FUNCTION;
+		header[1] = GCOV_TAG_FUNCTION_LENGTH;
+		header[2] = fn.ident;
+		header[3] = fn.lineno_checksum;
+		header[4] = fn.cfg_checksum;
+		if (f && fwrite(header, sizeof(uint32_t), 5, f) != 5)
+			die("Could not write coverage data.\n");
+
+		for (t_ix = 0; t_ix < GCOV_COUNTERS; t_ix++) {
+			const uint32_t *values;
+			uint32_t num;
+			bool zero;
+
+			if (!(obj->ctr_mask & (1U << t_ix)))
+				continue;
+
+			num = coverage_read(r);
+			zero = num & COVERAGE_CTR_ZERO;
+			num &= ~COVERAGE_CTR_ZERO;
+			values = &r->words[r->pos];
+			if (!zero)
+				coverage_skip(r, num * 2);
+
+			/* Only the arc counters are summable. */
+			if (t_ix == 0) {
+				summary->checksum = gcov_crc32(summary->checksum, num);
+				summary->num += num;
+				for (i = 0; !zero && i < num; i++) {
+					const uint64_t v = values[2 * i] |
+							   (uint64_t)values[2 * i + 1] << 32;
+
+					summary->sum_all += v;
+					summary->run_max = MAX(summary->run_max, v);
+				}
+			}
+
+			if (!f)
+				continue;
+			header[0] = GCOV_TAG_FOR_COUNTER(t_ix);
+			header[1] = num * 2;
+			if (fwrite(header, sizeof(uint32_t), 2, f) != 2)
+				die("Could not write coverage data.\n");
+			for (i = 0; i < num * 2; i++) {
+				const uint32_t v = zero ? 0 : values[i];
+
+				if (fwrite(&v, sizeof(v), 1, f) != 1)
+					die("Could not write coverage data.\n");
+			}
+		}
+	}
+}
+
+static const struct coverage_object *coverage_next_object(struct coverage_reader *r,
+							   const char **filename)
+{
+	const struct coverage_object *obj;
+	size_t start = r->pos;
+
+	coverage_skip(r, sizeof(*obj) / sizeof(uint32_t));
+	obj = (const struct coverage_object *)&r->words[start];
+	if (obj->size % sizeof(uint32_t) || obj->size / sizeof(uint32_t) > r->num - start ||
+	    obj->filename_size % sizeof(uint32_t) || !obj->filename_size)
+		die("Coverage data is corrupted.\n");
+
+	*filename = (const char *)&r->words[r->pos];
+	coverage_skip(r, obj->filename_size / sizeof(uint32_t));
+	if (!memchr(*filename, '\0', obj->filename_size))
+		die("Coverage data is corrupted.\n");
+
+	/* Let the reader only see this object. */
+	r->num = start + obj->size / sizeof(uint32_t);
+	return obj;
+}
+
 static void dump_coverage(void)
 {
 	uint64_t start;
 	size_t size;
+	const struct coverage_header *header;
 	const void *coverage;
+	struct coverage_summary summary = { 0 };
+	struct coverage_reader all, r;
 	struct mapping coverage_mapping;
-	unsigned long phys_offset;
-#define phys_to_virt(x) ((void *)(unsigned long)(x) + phys_offset)
+	const struct coverage_object *obj;
+	const char *name;
+	uint32_t i;
 
 	if (find_cbmem_entry(CBMEM_ID_COVERAGE, &start, &size)) {
 		fprintf(stderr, "No coverage information found\n");
@@ -1481,17 +2579,46 @@ static void dump_coverage(void)
 	coverage = map_memory(&coverage_mapping, start, size);
 	if (!coverage)
 		die("Unable to map coverage area.\n");
-	phys_offset = (unsigned long)coverage - (unsigned long)start;
+	header = coverage;
+
+	if (size < sizeof(*header) || header->magic != COVERAGE_MAGIC ||
+	    header->version != COVERAGE_VERSION || header->size > size ||
+	    header->size % sizeof(uint32_t)) {
+		fprintf(stderr, "Unknown coverage data format\n");
+		unmap_memory(&coverage_mapping);
+		return;
+	}
+
+	all.words = coverage;
+	all.pos = sizeof(*header) / sizeof(uint32_t);
+	all.num = header->size / sizeof(uint32_t);
+
+	/* The program summary in each file covers all objects. */
+	r = all;
+	for (i = 0; i < header->num_objects; i++) {
+		struct coverage_reader obj_r = r;
+
+		obj = coverage_next_object(&obj_r, &name);
+		coverage_walk_object(&obj_r, obj, &summary, NULL);
+		r.pos = obj_r.num;
+	}
 
 	printf("Dumping coverage data...\n");
 
-	struct file *file = (struct file *)coverage;
-	while (file && file->magic == COVERAGE_MAGIC) {
+	r = all;
+	for (i = 0; i < header->num_objects; i++) {
+		struct coverage_summary unused = { 0 };
+		struct coverage_reader obj_r = r;
+		uint32_t file_header[3 + 2 + GCOV_TAG_SUMMARY_LENGTH];
+		const uint32_t end = 0;
 		FILE *f;
 		char *filename;
 
-		debug(" -> %s\n", (char *)phys_to_virt(file->filename));
-		filename = strdup((char *)phys_to_virt(file->filename));
+		obj = coverage_next_object(&obj_r, &name);
+		r.pos = obj_r.num;
+
+		debug(" -> %s\n", name);
+		filename = strdup(name);
 		if (mkpath(filename, 0755) == -1) {
 			perror("Directory for coverage data could "
 				"not be created");
@@ -1503,21 +2630,440 @@ static void dump_coverage(void)
 				filename, strerror(errno));
 			exit(1);
 		}
-		if (fwrite((void *)phys_to_virt(file->data),
-						file->len, 1, f) != 1) {
-			printf("Could not write to %s: %s\n",
-				filename, strerror(errno));
-			exit(1);
-		}
-		fclose(f);
+
+		file_header[0] = GCOV_DATA_MAGIC;
+		file_header[1] = obj->gcov_version;
+		file_header[2] = obj->stamp;
+		file_header[3] = GCOV_TAG_PROGRAM_SUMMARY;
+		file_header[4] = GCOV_TAG_SUMMARY_LENGTH;
+		file_header[5] = summary.checksum;
+		file_header[6] = summary.num;
+		file_header[7] = 1;	/* runs */
+		file_header[8] = summary.sum_all;
+		file_header[9] = summary.sum_all >> 32;
+		file_header[10] = summary.run_max;
+		file_header[11] = summary.run_max >> 32;
+		/* sum_max, which is the same as run_max for a single run */
+		file_header[12] = summary.run_max;
+		file_header[13] = summary.run_max >> 32;
+		if (fwrite(file_header, sizeof(file_header), 1, f) != 1)
+			die("Could not write coverage data.\n");
+
+		coverage_walk_object(&obj_r, obj, &unused, f);
+
+		if (fwrite(&end, sizeof(end), 1, f) != 1 || fclose(f))
+			die("Could not write coverage data.\n");
 		free(filename);
+	}
+	unmap_memory(&coverage_mapping);
+}
+
+struct profile_symbol {
+	uint64_t addr;
+	uint64_t size;
+	const char *name;
+};
+
+static struct profile_symbol *profile_syms;
+static size_t profile_num_syms;
+static uint64_t profile_elf_base;
+
+static int compare_profile_symbols(const void *a, const void *b)
+{
+	const struct profile_symbol *sa = a, *sb = b;
 
-		if (file->next)
-			file = (struct file *)phys_to_virt(file->next);
+	if (sa->addr < sb->addr)
+		return -1;
+	return sa->addr > sb->addr;
+}
+
+/* Collect function symbols (and the _program base) from the ELF symbol table. */
+#define DEFINE_LOAD_ELF_SYMBOLS(bits)							\
+static int load_elf##bits##_symbols(const uint8_t *buf, size_t size)			\
+{											\
+	const Elf##bits##_Ehdr *ehdr = (const void *)buf;				\
+	const Elf##bits##_Shdr *shdr;							\
+											\
+	if (ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(*shdr) > size)		\
+		return -1;								\
+	shdr = (const void *)(buf + ehdr->e_shoff);					\
+											\
+	for (size_t i = 0; i < ehdr->e_shnum; i++) {					\
+		const Elf##bits##_Shdr *strtab;						\
+		const Elf##bits##_Sym *sym;						\
+		size_t count;								\
+											\
+		if (shdr[i].sh_type != SHT_SYMTAB || shdr[i].sh_link >= ehdr->e_shnum)	\
+			continue;							\
+		strtab = &shdr[shdr[i].sh_link];					\
+		if (shdr[i].sh_offset + shdr[i].sh_size > size ||			\
+		    strtab->sh_offset + strtab->sh_size > size)				\
+			return -1;							\
+											\
+		sym = (const void *)(buf + shdr[i].sh_offset);				\
+		count = shdr[i].sh_size / sizeof(*sym);					\
+		profile_syms = calloc(count, sizeof(*profile_syms));			\
+		if (!profile_syms)							\
+			die("Out of memory.\n");					\
+											\
+		for (size_t j = 0; j < count; j++) {					\
+			const char *name;						\
+											\
+			if (sym[j].st_name >= strtab->sh_size)				\
+				continue;						\
+			name = (const char *)buf + strtab->sh_offset + sym[j].st_name;	\
+			if (!strcmp(name, "_program"))					\
+				profile_elf_base = sym[j].st_value;			\
+			if (ELF##bits##_ST_TYPE(sym[j].st_info) != STT_FUNC ||		\
+			    sym[j].st_shndx == SHN_UNDEF)				\
+				continue;						\
+			profile_syms[profile_num_syms].addr = sym[j].st_value;		\
+			profile_syms[profile_num_syms].size = sym[j].st_size;		\
+			profile_syms[profile_num_syms].name = name;			\
+			profile_num_syms++;						\
+		}									\
+		return 0;								\
+	}										\
+											\
+	return -1;									\
+}
+
+DEFINE_LOAD_ELF_SYMBOLS(32)
+DEFINE_LOAD_ELF_SYMBOLS(64)
+
+static void load_profile_symbols(const char *path)
+{
+	struct stat st;
+	uint8_t *buf;
+	FILE *f;
+	int ret;
+
+	f = fopen(path, "rb");
+	if (!f || fstat(fileno(f), &st)) {
+		fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+
+	/* The symbol names point into this buffer, so it is kept until exit. */
+	buf = malloc(st.st_size);
+	if (!buf)
+		die("Out of memory.\n");
+	if (fread(buf, st.st_size, 1, f) != 1) {
+		fprintf(stderr, "Could not read %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+	fclose(f);
+
+	if ((size_t)st.st_size < sizeof(Elf32_Ehdr) || memcmp(buf, ELFMAG, SELFMAG) ||
+	    buf[EI_DATA] != ELFDATA2LSB)
+		ret = -1;
+	else if (buf[EI_CLASS] == ELFCLASS32)
+		ret = load_elf32_symbols(buf, st.st_size);
+	else if (buf[EI_CLASS] == ELFCLASS64 && (size_t)st.st_size >= sizeof(Elf64_Ehdr))
+		ret = load_elf64_symbols(buf, st.st_size);
+	else
+		ret = -1;
+
+	if (ret) {
+		fprintf(stderr, "%s is not a little-endian ELF file with symbols.\n", path);
+		exit(1);
+	}
+
+	qsort(profile_syms, profile_num_syms, sizeof(*profile_syms), compare_profile_symbols);
+	debug("Loaded %zu symbols, _program at 0x%" PRIx64 "\n", profile_num_syms,
+	      profile_elf_base);
+}
+
+static int profile_symbolize(char *buf, size_t len, uint64_t pc, uint64_t text_base)
+{
+	const uint64_t addr = pc - text_base + profile_elf_base;
+	size_t lo = 0, hi = profile_num_syms;
+
+	/* Find the last symbol starting at or below addr. */
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (profile_syms[mid].addr <= addr)
+			lo = mid + 1;
 		else
-			file = NULL;
+			hi = mid;
 	}
-	unmap_memory(&coverage_mapping);
+
+	if (lo && (!profile_syms[lo - 1].size ||
+		   addr < profile_syms[lo - 1].addr + profile_syms[lo - 1].size))
+		return snprintf(buf, len, "%s", profile_syms[lo - 1].name);
+
+	return snprintf(buf, len, "0x%" PRIx64, pc);
+}
+
+struct folded_stack {
+	char *frames;
+	uint64_t weight;
+};
+
+static int compare_folded_stacks(const void *a, const void *b)
+{
+	return strcmp(((const struct folded_stack *)a)->frames,
+		      ((const struct folded_stack *)b)->frames);
+}
+
+static void dump_profile(const char *elf_path)
+{
+	const struct profile_table *table;
+	struct folded_stack *stacks;
+	struct mapping profile_mapping;
+	uint64_t start;
+	size_t size, count;
+
+	if (find_cbmem_entry(CBMEM_ID_PROFILE, &start, &size) || size < sizeof(*table)) {
+		fprintf(stderr, "No profiler samples found\n");
+		return;
+	}
+
+	if (elf_path)
+		load_profile_symbols(elf_path);
+
+	table = map_memory(&profile_mapping, start, size);
+	if (!table)
+		die("Unable to map profiler samples.\n");
+
+	count = MIN(table->num_entries, (size - sizeof(*table)) / sizeof(table->samples[0]));
+	debug("%zu samples at %u Hz, %u dropped\n", count, table->sample_hz, table->dropped);
+
+	stacks = calloc(count, sizeof(*stacks));
+	if (!stacks)
+		die("Out of memory.\n");
+
+	/* Flame graph tools expect the outermost frame first. */
+	for (size_t i = 0; i < count; i++) {
+		const struct profile_sample *sample = &table->samples[i];
+		const uint32_t depth = MIN(sample->depth, PROFILE_MAX_DEPTH);
+		char buf[PROFILE_MAX_DEPTH * 128];
+		size_t len = 0;
+
+		for (uint32_t d = depth; d-- > 0 && len < sizeof(buf);) {
+			/* Return addresses point behind the call, look up the call itself. */
+			const uint64_t pc = sample->pc[d] - (d ? 1 : 0);
+
+			if (len)
+				buf[len++] = ';';
+			if (elf_path)
+				len += profile_symbolize(buf + len, sizeof(buf) - len, pc,
+							 table->text_base);
+			else
+				len += snprintf(buf + len, sizeof(buf) - len, "0x%" PRIx64, pc);
+		}
+		buf[MIN(len, sizeof(buf) - 1)] = '\0';
+
+		stacks[i].frames = strdup(buf);
+		stacks[i].weight = sample->weight;
+	}
+
+	unmap_memory(&profile_mapping);
+
+	qsort(stacks, count, sizeof(*stacks), compare_folded_stacks);
+	for (size_t i = 0; i < count; i++) {
+		uint64_t weight = stacks[i].weight;
+
+		while (i + 1 < count && !strcmp(stacks[i].frames, stacks[i + 1].frames))
+			weight += stacks[++i].weight;
+		printf("%s %" PRIu64 "\n", stacks[i].frames, weight);
+	}
+
+	for (size_t i = 0; i < count; i++)
+		free(stacks[i].frames);
+	free(stacks);
+}
+
+static void dump_cbfs_trace(void)
+{
+	const struct cbfs_access_trace *trace;
+	struct mapping trace_mapping;
+	uint64_t start;
+	size_t size, count;
+
+	if (find_cbmem_entry(CBMEM_ID_CBFS_TRACE, &start, &size) || size < sizeof(*trace)) {
+		fprintf(stderr, "No CBFS access trace found\n");
+		return;
+	}
+
+	trace = map_memory(&trace_mapping, start, size);
+	if (!trace)
+		die("Unable to map CBFS access trace.\n");
+
+	count = MIN(trace->num_entries, (size - sizeof(*trace)) / sizeof(trace->records[0]));
+	printf("# %zu CBFS accesses, %u dropped\n", count, trace->dropped);
+
+	for (size_t i = 0; i < count; i++) {
+		const struct cbfs_access_record *rec = &trace->records[i];
+
+		printf("%.*s\t%u\t%.*s\n", (int)sizeof(rec->stage), rec->stage, rec->size,
+		       (int)sizeof(rec->name), rec->name);
+	}
+
+	unmap_memory(&trace_mapping);
+}
+
+static void print_fmap_area(const struct fmap_area *area)
+{
+	printf("%-32.*s\t0x%08x\t0x%08x\n", FMAP_STRLEN, (const char *)area->name,
+	       le32toh(area->offset), le32toh(area->size));
+}
+
+static int dump_fmap(const char *area_name)
+{
+	const struct fmap_area *area;
+	const struct fmap *fmap;
+	struct mapping fmap_mapping;
+	uint64_t start;
+	size_t size;
+	int ret = 0;
+
+	if (find_cbmem_entry(CBMEM_ID_FMAP, &start, &size) || size < sizeof(*fmap)) {
+		fprintf(stderr, "No FMAP found in CBMEM\n");
+		return 1;
+	}
+
+	fmap = map_memory(&fmap_mapping, start, size);
+	if (!fmap)
+		die("Unable to map FMAP.\n");
+
+	if (memcmp(fmap->signature, FMAP_SIGNATURE, sizeof(fmap->signature)) ||
+	    sizeof(*fmap) + le16toh(fmap->nareas) * sizeof(fmap->areas[0]) > size)
+		die("FMAP in CBMEM is corrupted.\n");
+
+	if (area_name) {
+		if (fmap_index_find(fmap, size, area_name, &area) == CB_SUCCESS) {
+			print_fmap_area(area);
+			goto out;
+		}
+		/* Older coreboot versions don't add the index, look for the area by hand. */
+		for (size_t i = 0; i < le16toh(fmap->nareas); i++) {
+			if (!strncmp((const char *)fmap->areas[i].name, area_name, FMAP_STRLEN)) {
+				print_fmap_area(&fmap->areas[i]);
+				goto out;
+			}
+		}
+		fprintf(stderr, "FMAP area %s not found\n", area_name);
+		ret = 1;
+		goto out;
+	}
+
+	printf("# FMAP %.*s base 0x%" PRIx64 " size 0x%x, %u areas\n", FMAP_STRLEN,
+	       (const char *)fmap->name, le64toh(fmap->base), le32toh(fmap->size),
+	       le16toh(fmap->nareas));
+	for (size_t i = 0; i < le16toh(fmap->nareas); i++)
+		print_fmap_area(&fmap->areas[i]);
+
+out:
+	unmap_memory(&fmap_mapping);
+	return ret;
+}
+
+static int compare_dev_timing(const void *a, const void *b)
+{
+	const struct dev_timing_record *ra = a, *rb = b;
+
+	if (ra->usecs != rb->usecs)
+		return ra->usecs < rb->usecs ? 1 : -1;
+	return 0;
+}
+
+static void dump_device_timing(void)
+{
+	static const char *const op_names[DEV_TIMING_OP_COUNT] = {
+		[DEV_TIMING_SCAN_BUS] = "scan_bus",
+		[DEV_TIMING_READ_RESOURCES] = "read_resources",
+		[DEV_TIMING_SET_RESOURCES] = "set_resources",
+		[DEV_TIMING_ENABLE_RESOURCES] = "enable_resources",
+		[DEV_TIMING_INIT] = "init",
+		[DEV_TIMING_FINAL] = "final",
+		[DEV_TIMING_RESUME] = "resume",
+	};
+	uint64_t op_totals[DEV_TIMING_OP_COUNT] = { 0 };
+	const struct dev_timing_table *table;
+	struct dev_timing_record *records;
+	struct mapping timing_mapping;
+	uint64_t start;
+	size_t size, count;
+
+	if (find_cbmem_entry(CBMEM_ID_DEV_TIMING, &start, &size) || size < sizeof(*table)) {
+		fprintf(stderr, "No device timing table found\n");
+		return;
+	}
+
+	table = map_memory(&timing_mapping, start, size);
+	if (!table)
+		die("Unable to map device timing table.\n");
+
+	count = MIN(table->num_entries, (size - sizeof(*table)) / sizeof(table->records[0]));
+	records = malloc(count * sizeof(*records));
+	if (!records && count)
+		die("Failed to allocate memory");
+	memcpy(records, table->records, count * sizeof(*records));
+	printf("# %zu device operations, %u dropped\n", count, table->dropped);
+	unmap_memory(&timing_mapping);
+
+	qsort(records, count, sizeof(*records), compare_dev_timing);
+
+	for (size_t i = 0; i < count; i++) {
+		const struct dev_timing_record *rec = &records[i];
+		const char *op = rec->op < DEV_TIMING_OP_COUNT ? op_names[rec->op] : "unknown";
+
+		if (rec->op < DEV_TIMING_OP_COUNT)
+			op_totals[rec->op] += rec->usecs;
+		printf("%10u us  %-16s  %.*s\n", rec->usecs, op, (int)sizeof(rec->path),
+		       rec->path);
+	}
+
+	printf("\n# total per operation\n");
+	for (size_t i = 0; i < DEV_TIMING_OP_COUNT; i++)
+		printf("%10llu us  %s\n", (unsigned long long)op_totals[i], op_names[i]);
+
+	free(records);
+}
+
+static void print_usage_pair(uint32_t peak, uint32_t size)
+{
+	if (!size) {
+		printf("  %24s", "-");
+		return;
+	}
+	printf("  %9u/%-9u %3u%%", peak, size, (unsigned int)((uint64_t)peak * 100 / size));
+}
+
+static void dump_mem_usage(void)
+{
+	const struct mem_usage_table *table;
+	struct mapping usage_mapping;
+	uint64_t start;
+	size_t size, count;
+
+	if (find_cbmem_entry(CBMEM_ID_MEM_USAGE, &start, &size) || size < sizeof(*table)) {
+		fprintf(stderr, "No memory usage table found\n");
+		return;
+	}
+
+	table = map_memory(&usage_mapping, start, size);
+	if (!table)
+		die("Unable to map memory usage table.\n");
+
+	count = MIN(table->num_entries, ARRAY_SIZE(table->records));
+	printf("%-16s  %24s  %24s  %24s  %24s  %24s\n", "stage", "heap", "cbfs_cache",
+	       "stack", "thread stack", "CAR (static)");
+
+	for (size_t i = 0; i < count; i++) {
+		const struct mem_usage_record *rec = &table->records[i];
+
+		printf("%-16.*s", (int)sizeof(rec->stage), rec->stage);
+		print_usage_pair(rec->heap_peak, rec->heap_size);
+		print_usage_pair(rec->cbfs_cache_peak, rec->cbfs_cache_size);
+		print_usage_pair(rec->stack_peak, rec->stack_size);
+		print_usage_pair(rec->thread_stack_peak, rec->thread_stack_size);
+		print_usage_pair(rec->car_used, rec->car_size);
+		printf("\n");
+	}
+
+	unmap_memory(&usage_mapping);
 }
 
 static void print_version(void)
@@ -1536,11 +3082,12 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTLxVvh?]\n", name);
+	printf("usage: %s [-cCltTLxFPVvh?]\n", name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
 	     "   -1 | --oneboot:                   print cbmem console for last boot only\n"
 	     "   -2 | --2ndtolast:                 print cbmem console for the boot that came before the last one only\n"
+	     "   -s | --strings FILE:              decode binary console records with FILE (console_strings.bin from the build)\n"
 	     "   -B | --loglevel:                  maximum loglevel to print; prefix `+` (e.g. -B +INFO) to also print lines that have no level\n"
 	     "   -C | --coverage:                  dump coverage information\n"
 	     "   -l | --list:                      print cbmem table of contents\n"
@@ -1549,8 +3096,17 @@ static void print_usage(const char *name, int exit_code)
 	     "   -t | --timestamps:                print timestamp information\n"
 	     "   -T | --parseable-timestamps:      print parseable timestamps\n"
 	     "   -S | --stacked-timestamps:        print stacked timestamps (e.g. for flame graph tools)\n"
+	     "   -j | --json-timestamps:           print timestamps, stages and ranges as JSON\n"
+	     "   -A | --analyze-timestamps[=BASE]: print the per-stage critical path, compare with BASE (output of -T)\n"
+	     "        --regression-threshold=PCT:  with -A=BASE, flag spans that are PCT%% slower (default 10)\n"
 	     "   -a | --add-timestamp ID:          append timestamp with ID\n"
 	     "   -L | --tcpa-log                   print TPM log\n"
+	     "   -F | --flamegraph[=ELF]:          print profiler samples as folded stacks, symbolized with ELF (e.g. ramstage.debug)\n"
+	     "   -P | --cbfs-trace:                print the CBFS access trace (input for cbfstool add-prefetch-hints)\n"
+	     "   -d | --device-timing:             print the time each device operation took, slowest first\n"
+	     "   -M | --mem-usage:                 print the peak heap, cbfs_cache, stack and CAR usage of each stage\n"
+	     "   -D | --driver:                    read CBMEM through the kernel's coreboot driver in sysfs instead of /dev/mem\n"
+	     "   -f | --fmap[=AREA]:               print the flash layout (or only AREA) without reading the flash\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1673,6 +3229,187 @@ static char *dt_find_compat(const char *parent, const char *compat,
 }
 #endif /* defined(__arm__) || defined(__aarch64__) */
 
+/* Finds the coreboot table in /dev/mem. Returns 0 on success, 1 on error. */
+static int parse_devmem_cbtable(void)
+{
+#if defined(__arm__) || defined(__aarch64__)
+	int addr_cells, size_cells;
+	char *coreboot_node = dt_find_compat("/proc/device-tree", "coreboot",
+					     &addr_cells, &size_cells);
+
+	if (!coreboot_node) {
+		fprintf(stderr, "Could not find 'coreboot' compatible node!\n");
+		return 1;
+	}
+
+	if (addr_cells < 0) {
+		fprintf(stderr, "Warning: no #address-cells node in tree!\n");
+		addr_cells = 1;
+	}
+
+	int nlen = strlen(coreboot_node);
+	char *reg = alloca(nlen + sizeof("/reg"));
+
+	strcpy(reg, coreboot_node);
+	strcpy(reg + nlen, "/reg");
+	free(coreboot_node);
+
+	int fd = open(reg, O_RDONLY);
+	if (fd < 0) {
+		perror(reg);
+		return 1;
+	}
+
+	int i;
+	size_t size_to_read = addr_cells * 4 + size_cells * 4;
+	u8 *dtbuffer = alloca(size_to_read);
+	if (read(fd, dtbuffer, size_to_read) < 0) {
+		perror(reg);
+		return 1;
+	}
+	close(fd);
+
+	/* No variable-length byte swap function anywhere in C... how sad. */
+	u64 baseaddr = 0;
+	for (i = 0; i < addr_cells * 4; i++) {
+		baseaddr <<= 8;
+		baseaddr |= *dtbuffer;
+		dtbuffer++;
+	}
+	u64 cb_table_size = 0;
+	for (i = 0; i < size_cells * 4; i++) {
+		cb_table_size <<= 8;
+		cb_table_size |= *dtbuffer;
+		dtbuffer++;
+	}
+
+	parse_cbtable(baseaddr, cb_table_size);
+	return 0;
+#else
+	unsigned long long possible_base_addresses[] = { 0, 0xf0000 };
+
+	/* Find and parse coreboot table */
+	for (size_t j = 0; j < ARRAY_SIZE(possible_base_addresses); j++) {
+		if (!parse_cbtable(possible_base_addresses[j], 0))
+			break;
+	}
+	return 0;
+#endif
+}
+
+/* Maps all of CBMEM once. The entries are mapped one by one if that fails. */
+static void map_cbmem_window(void)
+{
+	struct memory_window *w;
+
+	if (!cbmem.size || !map_memory(&cbmem_mapping, cbmem.start, cbmem.size))
+		return;
+
+	windows = realloc(windows, (num_windows + 1) * sizeof(*windows));
+	if (!windows)
+		die("Failed to allocate memory");
+	w = &windows[num_windows++];
+	memset(w, 0, sizeof(*w));
+	w->phys = cbmem.start;
+	w->size = cbmem.size;
+	w->data = mapping_virt(&cbmem_mapping);
+	w->mapped = true;
+}
+
+static int read_sysfs_number(const char *dir, const char *attr, unsigned long long *val)
+{
+	char path[PATH_MAX], buf[32];
+	char *end;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+	f = fopen(path, "r");
+	if (!f)
+		return -1;
+	if (!fgets(buf, sizeof(buf), f)) {
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+
+	*val = strtoull(buf, &end, 0);
+	return end == buf ? -1 : 0;
+}
+
+/*
+ * Adds a window for each CBMEM entry the kernel's coreboot driver exposes in sysfs.
+ * Returns the number of entries.
+ */
+static size_t find_sysfs_cbmem_entries(void)
+{
+	struct dirent *de;
+	DIR *dir;
+
+	dir = opendir(SYSFS_COREBOOT_DEVICES);
+	if (!dir)
+		return 0;
+
+	while ((de = readdir(dir))) {
+		char path[PATH_MAX];
+		unsigned long long address, size;
+		unsigned int id;
+		struct memory_window *w;
+
+		if (sscanf(de->d_name, "cbmem-%8x", &id) != 1)
+			continue;
+		snprintf(path, sizeof(path), SYSFS_COREBOOT_DEVICES "/%s", de->d_name);
+		if (read_sysfs_number(path, "address", &address) ||
+		    read_sysfs_number(path, "size", &size))
+			continue;
+
+		windows = realloc(windows, (num_windows + 1) * sizeof(*windows));
+		if (!windows)
+			die("Failed to allocate memory");
+		w = &windows[num_windows++];
+		memset(w, 0, sizeof(*w));
+		w->phys = address;
+		w->size = size;
+		strncat(path, "/mem", sizeof(path) - strlen(path) - 1);
+		w->sysfs_mem = strdup(path);
+		if (!w->sysfs_mem)
+			die("Failed to allocate memory");
+		debug("CBMEM entry %08x at 0x%llx, %llu bytes in sysfs\n", id, address, size);
+	}
+	closedir(dir);
+
+	return num_windows;
+}
+
+/* The coreboot table is a CBMEM entry of its own. Returns 0 on success, 1 on error. */
+static int parse_sysfs_cbtable(void)
+{
+	char path[PATH_MAX];
+	unsigned long long address, size;
+
+	snprintf(path, sizeof(path), SYSFS_COREBOOT_DEVICES "/cbmem-%08x", CBMEM_ID_CBTABLE);
+	if (read_sysfs_number(path, "address", &address) ||
+	    read_sysfs_number(path, "size", &size)) {
+		fprintf(stderr, "No coreboot table in %s\n", SYSFS_COREBOOT_DEVICES);
+		return 1;
+	}
+
+	parse_cbtable(address, size);
+	return 0;
+}
+
+static void free_windows(void)
+{
+	for (size_t i = 0; i < num_windows; i++) {
+		if (!windows[i].mapped)
+			free(windows[i].data);
+		free(windows[i].sysfs_mem);
+	}
+	free(windows);
+	windows = NULL;
+	num_windows = 0;
+	unmap_memory(&cbmem_mapping);
+}
+
 int main(int argc, char** argv)
 {
 	int print_defaults = 1;
@@ -1682,12 +3419,23 @@ int main(int argc, char** argv)
 	int print_hexdump = 0;
 	int print_rawdump = 0;
 	int print_tcpa_log = 0;
+	int print_profile = 0;
+	int print_cbfs_trace = 0;
+	int print_device_timing = 0;
+	int print_mem_usage = 0;
+	int print_fmap = 0;
+	const char *fmap_area = NULL;
+	const char *profile_elf = NULL;
 	enum timestamps_print_type timestamp_type = TIMESTAMPS_PRINT_NONE;
 	enum console_print_type console_type = CONSOLE_PRINT_FULL;
 	unsigned int rawdump_id = 0;
 	int max_loglevel = BIOS_NEVER;
 	int print_unknown_logs = 1;
 	uint32_t timestamp_id = 0;
+	const char *timestamp_baseline = NULL;
+	unsigned int regression_threshold = 10;
+	bool use_sysfs = false;
+	int ret = 0;
 
 	int opt, option_index = 0;
 	static struct option long_options[] = {
@@ -1695,21 +3443,31 @@ int main(int argc, char** argv)
 		{"oneboot", 0, 0, '1'},
 		{"2ndtolast", 0, 0, '2'},
 		{"loglevel", required_argument, 0, 'B'},
+		{"strings", required_argument, 0, 's'},
 		{"coverage", 0, 0, 'C'},
 		{"list", 0, 0, 'l'},
 		{"tcpa-log", 0, 0, 'L'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
 		{"stacked-timestamps", 0, 0, 'S'},
+		{"json-timestamps", 0, 0, 'j'},
+		{"analyze-timestamps", optional_argument, 0, 'A'},
+		{"regression-threshold", required_argument, 0, 'R'},
 		{"add-timestamp", required_argument, 0, 'a'},
 		{"hexdump", 0, 0, 'x'},
+		{"flamegraph", optional_argument, 0, 'F'},
 		{"rawdump", required_argument, 0, 'r'},
+		{"cbfs-trace", 0, 0, 'P'},
+		{"device-timing", 0, 0, 'd'},
+		{"mem-usage", 0, 0, 'M'},
+		{"fmap", optional_argument, 0, 'f'},
+		{"driver", 0, 0, 'D'},
 		{"verbose", 0, 0, 'V'},
 		{"version", 0, 0, 'v'},
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "c12B:CltTSa:LxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "c12B:s:CltTSjA::a:LxF::PdMf::DVvh?r:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
@@ -1729,6 +3487,9 @@ int main(int argc, char** argv)
 		case 'B':
 			max_loglevel = parse_loglevel(optarg, &print_unknown_logs);
 			break;
+		case 's':
+			load_console_strings(optarg);
+			break;
 		case 'C':
 			print_coverage = 1;
 			print_defaults = 0;
@@ -1745,6 +3506,28 @@ int main(int argc, char** argv)
 			print_hexdump = 1;
 			print_defaults = 0;
 			break;
+		case 'F':
+			print_profile = 1;
+			print_defaults = 0;
+			profile_elf = optarg;
+			break;
+		case 'P':
+			print_cbfs_trace = 1;
+			print_defaults = 0;
+			break;
+		case 'd':
+			print_device_timing = 1;
+			print_defaults = 0;
+			break;
+		case 'M':
+			print_mem_usage = 1;
+			print_defaults = 0;
+			break;
+		case 'f':
+			print_fmap = 1;
+			fmap_area = optarg;
+			print_defaults = 0;
+			break;
 		case 'r':
 			print_rawdump = 1;
 			print_defaults = 0;
@@ -1762,6 +3545,18 @@ int main(int argc, char** argv)
 			timestamp_type = TIMESTAMPS_PRINT_STACKED;
 			print_defaults = 0;
 			break;
+		case 'j':
+			timestamp_type = TIMESTAMPS_PRINT_JSON;
+			print_defaults = 0;
+			break;
+		case 'A':
+			timestamp_type = TIMESTAMPS_PRINT_ANALYSIS;
+			timestamp_baseline = optarg;
+			print_defaults = 0;
+			break;
+		case 'R':
+			regression_threshold = strtoul(optarg, NULL, 0);
+			break;
 		case 'a':
 			print_defaults = 0;
 			timestamp_id = timestamp_enum_name_to_id(optarg);
@@ -1769,6 +3564,9 @@ int main(int argc, char** argv)
 			if (timestamp_id == 0)
 				timestamp_id = strtoul(optarg, NULL, 0);
 			break;
+		case 'D':
+			use_sysfs = true;
+			break;
 		case 'V':
 			verbose = 1;
 			break;
@@ -1791,74 +3589,36 @@ int main(int argc, char** argv)
 		print_usage(argv[0], 1);
 	}
 
-	mem_fd = open("/dev/mem", timestamp_id ? O_RDWR : O_RDONLY, 0);
-	if (mem_fd < 0) {
-		fprintf(stderr, "Failed to gain memory access: %s\n",
-			strerror(errno));
+	if (use_sysfs && timestamp_id) {
+		fprintf(stderr, "Adding a timestamp needs /dev/mem.\n");
 		return 1;
 	}
 
-#if defined(__arm__) || defined(__aarch64__)
-	int addr_cells, size_cells;
-	char *coreboot_node = dt_find_compat("/proc/device-tree", "coreboot",
-					     &addr_cells, &size_cells);
-
-	if (!coreboot_node) {
-		fprintf(stderr, "Could not find 'coreboot' compatible node!\n");
-		return 1;
-	}
-
-	if (addr_cells < 0) {
-		fprintf(stderr, "Warning: no #address-cells node in tree!\n");
-		addr_cells = 1;
-	}
-
-	int nlen = strlen(coreboot_node);
-	char *reg = alloca(nlen + sizeof("/reg"));
-
-	strcpy(reg, coreboot_node);
-	strcpy(reg + nlen, "/reg");
-	free(coreboot_node);
-
-	int fd = open(reg, O_RDONLY);
-	if (fd < 0) {
-		perror(reg);
-		return 1;
-	}
-
-	int i;
-	size_t size_to_read = addr_cells * 4 + size_cells * 4;
-	u8 *dtbuffer = alloca(size_to_read);
-	if (read(fd, dtbuffer, size_to_read) < 0) {
-		perror(reg);
+	if (!use_sysfs) {
+		mem_fd = open("/dev/mem", timestamp_id ? O_RDWR : O_RDONLY, 0);
+		if (mem_fd < 0 && !timestamp_id && find_sysfs_cbmem_entries()) {
+			debug("No /dev/mem access (%s), using %s.\n", strerror(errno),
+			      SYSFS_COREBOOT_DEVICES);
+			use_sysfs = true;
+		} else if (mem_fd < 0) {
+			fprintf(stderr, "Failed to gain memory access: %s\n",
+				strerror(errno));
+			return 1;
+		}
+	} else if (!find_sysfs_cbmem_entries()) {
+		fprintf(stderr, "No CBMEM entries in %s, is the driver loaded?\n",
+			SYSFS_COREBOOT_DEVICES);
 		return 1;
 	}
-	close(fd);
-
-	/* No variable-length byte swap function anywhere in C... how sad. */
-	u64 baseaddr = 0;
-	for (i = 0; i < addr_cells * 4; i++) {
-		baseaddr <<= 8;
-		baseaddr |= *dtbuffer;
-		dtbuffer++;
-	}
-	u64 cb_table_size = 0;
-	for (i = 0; i < size_cells * 4; i++) {
-		cb_table_size <<= 8;
-		cb_table_size |= *dtbuffer;
-		dtbuffer++;
-	}
 
-	parse_cbtable(baseaddr, cb_table_size);
-#else
-	unsigned long long possible_base_addresses[] = { 0, 0xf0000 };
-
-	/* Find and parse coreboot table */
-	for (size_t j = 0; j < ARRAY_SIZE(possible_base_addresses); j++) {
-		if (!parse_cbtable(possible_base_addresses[j], 0))
-			break;
+	if (use_sysfs) {
+		if (parse_sysfs_cbtable())
+			return 1;
+	} else {
+		if (parse_devmem_cbtable())
+			return 1;
+		map_cbmem_window();
 	}
-#endif
 
 	if (mapping_virt(&lbtable_mapping) == NULL)
 		die("Table not found.\n");
@@ -1884,14 +3644,33 @@ int main(int argc, char** argv)
 	if (print_defaults)
 		timestamp_type = TIMESTAMPS_PRINT_NORMAL;
 
-	if (timestamp_type != TIMESTAMPS_PRINT_NONE)
+	if (timestamp_type == TIMESTAMPS_PRINT_JSON || timestamp_type == TIMESTAMPS_PRINT_ANALYSIS)
+		ret = analyze_timestamps(timestamp_type, timestamp_baseline, regression_threshold);
+	else if (timestamp_type != TIMESTAMPS_PRINT_NONE)
 		dump_timestamps(timestamp_type);
 
 	if (print_tcpa_log)
 		dump_tpm_log();
 
+	if (print_profile)
+		dump_profile(profile_elf);
+
+	if (print_cbfs_trace)
+		dump_cbfs_trace();
+
+	if (print_device_timing)
+		dump_device_timing();
+
+	if (print_mem_usage)
+		dump_mem_usage();
+
+	if (print_fmap && dump_fmap(fmap_area))
+		ret = 1;
+
 	unmap_memory(&lbtable_mapping);
+	free_windows();
 
-	close(mem_fd);
-	return 0;
+	if (mem_fd >= 0)
+		close(mem_fd);
+	return ret;
 }
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <getopt.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <commonlib/helpers.h>
@@ -1243,14 +1244,19 @@ static void write_image(const char *filename, char *image, int size)
 	int new_fd;
 	printf("Writing new image to %s\n", filename);
 
-	// Now write out new image
-	new_fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+	/*
+	 * Now write out new image. The input image may be mapped from the same
+	 * file, so don't truncate it before the new contents are written.
+	 */
+	new_fd = open(filename, O_WRONLY | O_CREAT | O_BINARY, 0644);
 	if (new_fd < 0) {
 		perror("Error while trying to open file");
 		exit(EXIT_FAILURE);
 	}
 	if (write(new_fd, image, size) != size)
 		perror("Error while writing");
+	if (ftruncate(new_fd, size))
+		perror("Error while truncating");
 	close(new_fd);
 }
 
@@ -2554,15 +2560,27 @@ int main(int argc, char *argv[])
 
 	printf("File %s is %d bytes\n", filename, size);
 
-	char *image = malloc(size);
-	if (!image) {
-		printf("Out of memory.\n");
-		exit(EXIT_FAILURE);
-	}
+	/*
+	 * Map the image instead of reading it, most modes only touch the
+	 * descriptor. The mapping is private, changes only reach a file
+	 * through write_image().
+	 */
+	bool image_mapped = false;
+	char *image = size > 0 ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+				      bios_fd, 0) : MAP_FAILED;
+	if (image != MAP_FAILED) {
+		image_mapped = true;
+	} else {
+		image = malloc(size);
+		if (!image) {
+			printf("Out of memory.\n");
+			exit(EXIT_FAILURE);
+		}
 
-	if (read(bios_fd, image, size) != size) {
-		perror("Could not read file");
-		exit(EXIT_FAILURE);
+		if (read(bios_fd, image, size) != size) {
+			perror("Could not read file");
+			exit(EXIT_FAILURE);
+		}
 	}
 
 	close(bios_fd);
@@ -2645,7 +2663,10 @@ int main(int argc, char *argv[])
 	}
 
 	free(new_filename);
-	free(image);
+	if (image_mapped)
+		munmap(image, size);
+	else
+		free(image);
 
 	return 0;
 }
@@ -41,6 +41,8 @@ static void op_show_cmos_hex_dump(void);
 static void op_show_cmos_dumpfile(void);
 static void op_write_cmos_layout_bin(void);
 static void op_write_cmos_layout_header(void);
+static void op_cmos_batch(void);
+static void batch_read_param(const cmos_entry_t * e);
 static int list_one_param(const char name[], int show_name);
 static int list_all_params(void);
 static void list_param_enums(const char name[]);
@@ -67,7 +69,8 @@ static const op_fn_t op_fns[] = { op_show_version,
 	op_show_cmos_hex_dump,
 	op_show_cmos_dumpfile,
 	op_write_cmos_layout_bin,
-	op_write_cmos_layout_header
+	op_write_cmos_layout_header,
+	op_cmos_batch
 };
 
 static void op_write_cmos_layout_bin(void)
@@ -331,6 +334,73 @@ static void op_cmos_set_params_file(void)
 	fclose(f);
 }
 
+/* state of the batch operation, for batch_read_param() */
+static int batch_show_name;
+static int batch_reads;
+static int batch_read_errors;
+
+/****************************************************************************
+ * op_cmos_batch
+ *
+ * [-n] -s BATCH_FILE
+ *
+ * Show and set any number of parameters according to BATCH_FILE, or to
+ * standard input if BATCH_FILE is "-".  A line with just a parameter name
+ * shows the parameter, a line with NAME = VALUE sets it.  Parameters are
+ * shown with the values from before the batch.  The writes are done only if
+ * the whole file was processed without errors, and the checksum is updated
+ * once for all of them.
+ ****************************************************************************/
+static void op_cmos_batch(void)
+{
+	cmos_write_t *list;
+	FILE *f;
+
+	if (!strcmp(nvramtool_op.param, "-"))
+		f = stdin;
+	else if ((f = fopen(nvramtool_op.param, "r")) == NULL) {
+		fprintf(stderr, "%s: Can not open file %s for reading: %s\n",
+			prog_name, nvramtool_op.param, strerror(errno));
+		exit(1);
+	}
+
+	get_cmos_layout();
+	batch_show_name =
+	    !nvramtool_op_modifiers[NVRAMTOOL_MOD_SHOW_VALUE_ONLY].found;
+	list = process_batch_file(f, batch_read_param);
+
+	if (f != stdin)
+		fclose(f);
+
+	if (batch_reads)
+		cmos_checksum_verify();
+
+	if (batch_read_errors)
+		exit(1);
+
+	if (list != NULL)
+		do_cmos_writes(list);
+}
+
+/****************************************************************************
+ * batch_read_param
+ *
+ * Show the parameter of CMOS entry 'e' for op_cmos_batch().
+ ****************************************************************************/
+static void batch_read_param(const cmos_entry_t * e)
+{
+	if (e->config == CMOS_ENTRY_RESERVED) {
+		fprintf(stderr, "%s: Parameter %s is reserved.\n", prog_name,
+			e->name);
+		exit(1);
+	}
+
+	batch_reads++;
+
+	if (list_cmos_entry(e, batch_show_name))
+		batch_read_errors++;
+}
+
 /****************************************************************************
  * op_cmos_checksum
  *
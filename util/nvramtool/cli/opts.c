@@ -13,7 +13,7 @@ static void register_op_modifier(nvramtool_op_modifier_t mod, char mod_param[]);
 static void resolve_op_modifiers(void);
 static void sanity_check_args(void);
 
-static const char getopt_string[] = "-ab:B:c::C:dD:e:hH:iL:l::np:r:tvw:xX:y:Y";
+static const char getopt_string[] = "-ab:B:c::C:dD:e:hH:iL:l::np:r:s:tvw:xX:y:Y";
 
 /****************************************************************************
  * parse_nvramtool_args
@@ -94,6 +94,10 @@ void parse_nvramtool_args(int argc, char *argv[])
 			register_op(&op_found,
 				    NVRAMTOOL_OP_CMOS_SET_PARAMS_FILE, optarg);
 			break;
+		case 's':
+			register_op(&op_found, NVRAMTOOL_OP_CMOS_BATCH,
+				    optarg);
+			break;
 		case 'r':
 			register_op(&op_found, NVRAMTOOL_OP_CMOS_SHOW_ONE_PARAM,
 				    optarg);
@@ -232,6 +236,7 @@ static void resolve_op_modifiers(void)
 static void sanity_check_args(void)
 {
 	if ((nvramtool_op_modifiers[NVRAMTOOL_MOD_SHOW_VALUE_ONLY].found) &&
-	    (nvramtool_op.op != NVRAMTOOL_OP_CMOS_SHOW_ONE_PARAM))
+	    (nvramtool_op.op != NVRAMTOOL_OP_CMOS_SHOW_ONE_PARAM) &&
+	    (nvramtool_op.op != NVRAMTOOL_OP_CMOS_BATCH))
 		usage(stderr);
 }
@@ -22,7 +22,8 @@ typedef enum { NVRAMTOOL_OP_SHOW_VERSION = 0,
 	NVRAMTOOL_OP_SHOW_CMOS_HEX_DUMP,
 	NVRAMTOOL_OP_SHOW_CMOS_DUMPFILE,
 	NVRAMTOOL_OP_WRITE_BINARY_FILE,
-	NVRAMTOOL_OP_WRITE_HEADER_FILE
+	NVRAMTOOL_OP_WRITE_HEADER_FILE,
+	NVRAMTOOL_OP_CMOS_BATCH
 } nvramtool_op_t;
 
 typedef struct {
@@ -66,6 +66,9 @@ void usage(FILE * outfile)
 		"       -p INPUT_FILE:  Set parameters according to INPUT_FILE.\n"
 		"       -i:             Same as -p but file contents taken from "
 		"standard input.\n"
+		"       [-n] -s FILE:   Show and set parameters according to "
+		"FILE, - for standard\n"
+		"                       input.  If -n is given, show values only.\n"
 		"       -c [VALUE]:     Show CMOS checksum or set checksum to "
 		"VALUE.\n"
 		"       -l [ARG]:       Show coreboot table info for ARG, or "
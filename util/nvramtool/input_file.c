@@ -37,6 +37,15 @@ const char assignment_regex[] =
     /* followed by optional whitespace */
     "[[:space:]]*$";
 
+/* matches a line that names a parameter to be read */
+static const char read_regex[] =
+    /* optional whitespace */
+    "^[[:space:]]*"
+    /* followed by a coreboot parameter name */
+    "([^[:space:]=]+)"
+    /* followed by optional whitespace */
+    "[[:space:]]*$";
+
 static int line_num;
 
 /****************************************************************************
@@ -47,13 +56,27 @@ static int line_num;
  * exit with an error message if there is a problem.
  ****************************************************************************/
 cmos_write_t *process_input_file(FILE * f)
+{
+	return process_batch_file(f, NULL);
+}
+
+/****************************************************************************
+ * process_batch_file
+ *
+ * Same as process_input_file(), but a line may also consist of just a
+ * parameter name.  For each such line, 'read_fn' is called with the CMOS
+ * entry of the parameter right away, so reads see the values from before
+ * any of the writes in the file are done.  If 'read_fn' is NULL, such lines
+ * are syntax errors.
+ ****************************************************************************/
+cmos_write_t *process_batch_file(FILE * f, cmos_read_fn_t read_fn)
 {
 	static const int LINE_BUF_SIZE = 256;
 	static const size_t N_MATCHES = 4;
 	char line[LINE_BUF_SIZE];
 	const char *name, *value;
 	cmos_write_t *list, *item, **p;
-	regex_t blank_or_comment, assignment;
+	regex_t blank_or_comment, assignment, read;
 	regmatch_t match[N_MATCHES];
 	const cmos_entry_t *e;
 
@@ -62,12 +85,30 @@ cmos_write_t *process_input_file(FILE * f)
 
 	compile_reg_expr(REG_EXTENDED | REG_NEWLINE, blank_or_comment_regex, &blank_or_comment);
 	compile_reg_expr(REG_EXTENDED | REG_NEWLINE, assignment_regex, &assignment);
+	compile_reg_expr(REG_EXTENDED | REG_NEWLINE, read_regex, &read);
 
 	/* each iteration processes one line from input file */
 	for (line_num = 1; get_input_file_line(f, line, LINE_BUF_SIZE) == OK; line_num++) {	/* skip comments and blank lines */
 		if (!regexec(&blank_or_comment, line, 0, NULL, 0))
 			continue;
 
+		if (read_fn != NULL && !regexec(&read, line, N_MATCHES, match, 0)) {
+			line[match[1].rm_eo] = '\0';
+			name = &line[match[1].rm_so];
+
+			if (is_checksum_name(name)
+			    || (e = find_cmos_entry(name)) == NULL) {
+				fprintf(stderr,
+					"%s: Error on line %d of input file: CMOS "
+					"parameter %s not found.\n", prog_name,
+					line_num, name);
+				exit(1);
+			}
+
+			read_fn(e);
+			continue;
+		}
+
 		/* Is this a valid assignment line?  If not, then it's a syntax
 		 * error.
 		 */
@@ -116,6 +157,7 @@ cmos_write_t *process_input_file(FILE * f)
 
 	regfree(&blank_or_comment);
 	regfree(&assignment);
+	regfree(&read);
 	return list;
 }
 
@@ -21,7 +21,11 @@ struct cmos_write_t {
 	cmos_write_t *next;
 };
 
+/* Called for each parameter that a batch file reads. */
+typedef void (*cmos_read_fn_t) (const cmos_entry_t * e);
+
 cmos_write_t *process_input_file(FILE * f);
+cmos_write_t *process_batch_file(FILE * f, cmos_read_fn_t read_fn);
 void do_cmos_writes(cmos_write_t * list);
 
 extern const char assignment_regex[];
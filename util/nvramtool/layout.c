@@ -23,6 +23,8 @@ static int areas_overlap(unsigned area_0_start, unsigned area_0_length,
 			 unsigned area_1_start, unsigned area_1_length);
 static int entries_overlap(const cmos_entry_t * p, const cmos_entry_t * q);
 static const cmos_enum_item_t *find_first_cmos_enum_id(unsigned config_id);
+static void build_cmos_entry_index(void);
+static void build_cmos_enum_index(void);
 
 const char checksum_param_name[] = "check_sum";
 
@@ -64,6 +66,17 @@ static cmos_entry_item_t *cmos_entry_list = NULL;
  */
 static cmos_enum_item_t *cmos_enum_list = NULL;
 
+/* Indexes for binary searches in the lists above.  They are built on first
+ * lookup and dropped whenever an entry or enum is added.  The entry index is
+ * sorted by name and then by 'bit', so the first match for a name is the one
+ * at the lowest address, as it is in 'cmos_entry_list'.  The enum index holds
+ * all enums in list order.
+ */
+static const cmos_entry_item_t **cmos_entry_index = NULL;
+static size_t cmos_entry_index_size = 0;
+static const cmos_enum_item_t **cmos_enum_index = NULL;
+static size_t cmos_enum_index_size = 0;
+
 static cmos_layout_get_fn_t cmos_layout_get_fn = default_cmos_layout_get_fn;
 
 /****************************************************************************
@@ -154,6 +167,9 @@ int add_cmos_entry(const cmos_entry_t * e, const cmos_entry_t ** conflict)
 
 	new_entry->item = *e;
 
+	free(cmos_entry_index);
+	cmos_entry_index = NULL;
+
 	if (cmos_entry_list == NULL) {
 		new_entry->next = NULL;
 		cmos_entry_list = new_entry;
@@ -205,14 +221,26 @@ int add_cmos_entry(const cmos_entry_t * e, const cmos_entry_t ** conflict)
  ****************************************************************************/
 const cmos_entry_t *find_cmos_entry(const char name[])
 {
-	cmos_entry_item_t *item;
+	size_t lo, hi, mid;
 
-	for (item = cmos_entry_list; item != NULL; item = item->next) {
-		if (!strcmp(item->item.name, name))
-			return &item->item;
+	if (cmos_entry_index == NULL)
+		build_cmos_entry_index();
+
+	/* find the first index entry whose name is not less than 'name' */
+	for (lo = 0, hi = cmos_entry_index_size; lo < hi;) {
+		mid = lo + (hi - lo) / 2;
+
+		if (strcmp(cmos_entry_index[mid]->item.name, name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
 
-	return NULL;
+	if ((lo == cmos_entry_index_size) ||
+	    strcmp(cmos_entry_index[lo]->item.name, name))
+		return NULL;
+
+	return &cmos_entry_index[lo]->item;
 }
 
 /****************************************************************************
@@ -256,6 +284,9 @@ int add_cmos_enum(const cmos_enum_t * e)
 
 	new_enum->item = *e;
 
+	free(cmos_enum_index);
+	cmos_enum_index = NULL;
+
 	if (cmos_enum_list == NULL) {
 		new_enum->next = NULL;
 		cmos_enum_list = new_enum;
@@ -503,12 +534,90 @@ static int areas_overlap(unsigned area_0_start, unsigned area_0_length,
  ****************************************************************************/
 static const cmos_enum_item_t *find_first_cmos_enum_id(unsigned config_id)
 {
-	cmos_enum_item_t *item;
+	size_t lo, hi, mid;
+
+	if (cmos_enum_index == NULL)
+		build_cmos_enum_index();
+
+	/* find the first enum whose 'config_id' is not less than 'config_id' */
+	for (lo = 0, hi = cmos_enum_index_size; lo < hi;) {
+		mid = lo + (hi - lo) / 2;
+
+		if (cmos_enum_index[mid]->item.config_id < config_id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return ((lo == cmos_enum_index_size) ||
+		(cmos_enum_index[lo]->item.config_id > config_id)) ?
+	    NULL : cmos_enum_index[lo];
+}
+
+/****************************************************************************
+ * compare_cmos_entry_items
+ *
+ * qsort() comparison function for the entry index: order by name, then by
+ * 'bit'.
+ ****************************************************************************/
+static int compare_cmos_entry_items(const void *a, const void *b)
+{
+	const cmos_entry_item_t *p = *(const cmos_entry_item_t * const *)a;
+	const cmos_entry_item_t *q = *(const cmos_entry_item_t * const *)b;
+	int result;
+
+	if ((result = strcmp(p->item.name, q->item.name)) != 0)
+		return result;
+
+	return (p->item.bit > q->item.bit) - (p->item.bit < q->item.bit);
+}
+
+/****************************************************************************
+ * build_cmos_entry_index
+ *
+ * Build the index of CMOS entries that find_cmos_entry() searches.
+ ****************************************************************************/
+static void build_cmos_entry_index(void)
+{
+	const cmos_entry_item_t *item;
+	size_t i;
+
+	for (i = 0, item = cmos_entry_list; item != NULL; item = item->next)
+		i++;
+
+	/* allocate at least one slot so an empty index is not NULL */
+	if ((cmos_entry_index = malloc((i + 1) * sizeof(*cmos_entry_index))) == NULL)
+		out_of_memory();
+
+	cmos_entry_index_size = i;
+
+	for (i = 0, item = cmos_entry_list; item != NULL; item = item->next)
+		cmos_entry_index[i++] = item;
+
+	qsort(cmos_entry_index, cmos_entry_index_size,
+	      sizeof(*cmos_entry_index), compare_cmos_entry_items);
+}
+
+/****************************************************************************
+ * build_cmos_enum_index
+ *
+ * Build the index of CMOS enums that find_first_cmos_enum_id() searches.
+ * The enum list is already sorted by 'config_id', so no sorting is needed.
+ ****************************************************************************/
+static void build_cmos_enum_index(void)
+{
+	const cmos_enum_item_t *item;
+	size_t i;
+
+	for (i = 0, item = cmos_enum_list; item != NULL; item = item->next)
+		i++;
+
+	/* allocate at least one slot so an empty index is not NULL */
+	if ((cmos_enum_index = malloc((i + 1) * sizeof(*cmos_enum_index))) == NULL)
+		out_of_memory();
 
-	for (item = cmos_enum_list;
-	     (item != NULL) && (item->item.config_id < config_id);
-	     item = item->next) ;
+	cmos_enum_index_size = i;
 
-	return ((item == NULL) || (item->item.config_id > config_id)) ?
-	    NULL : item;
+	for (i = 0, item = cmos_enum_list; item != NULL; item = item->next)
+		cmos_enum_index[i++] = item;
 }
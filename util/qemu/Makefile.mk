@@ -18,6 +18,14 @@
 # QEMU_CFG_ARGS		gathers config file related arguments,
 #			can be used to override a default config (QEMU_CFG-y)
 #
+# The `qemu-boot-time` target boots the image without a display, reads the
+# CBMEM timestamps once coreboot is done and compares the time spent in each
+# stage against a baseline. It fails if a stage got slower than allowed:
+# QEMU_BOOT_TIME_BASELINE	baseline JSON file
+#				(default: util/qemu/boot-time/<mainboard>.json)
+# QEMU_BOOT_TIME_ARGS		additional arguments for boot-time.py,
+#				e.g. --tolerance 10
+#
 # Examples:
 #
 #   $ # Run coreboot's default config with additional command line args
@@ -25,6 +33,9 @@
 #
 #   $ # Force QEMU's built-in config
 #   $ make qemu QEMU_CFG_ARGS=
+#
+#   $ # Record a new boot time baseline
+#   $ make qemu-boot-time QEMU_BOOT_TIME_ARGS=--update
 
 QEMU-$(CONFIG_BOARD_EMULATION_QEMU_AARCH64)	?= qemu-system-aarch64 \
 	-M virt,secure=on,virtualization=on -cpu cortex-a53 -m 1G
@@ -40,6 +51,11 @@ QEMU-$(CONFIG_BOARD_EMULATION_QEMU_X86_I440FX)	?= qemu-system-x86_64 -M pc
 QEMU-$(CONFIG_BOARD_EMULATION_QEMU_X86_Q35)	?= qemu-system-x86_64 -M q35
 QEMU_CFG-$(CONFIG_BOARD_EMULATION_QEMU_X86_Q35)	?= util/qemu/q35-base.cfg
 
+# Where guest RAM starts, the timestamp table is searched for from there.
+QEMU_RAM_BASE-$(CONFIG_BOARD_EMULATION_QEMU_AARCH64)	:= 0x40000000
+QEMU_RAM_BASE-$(CONFIG_BOARD_EMULATION_QEMU_RISCV_RV64)	:= 0x80000000
+QEMU_RAM_BASE-$(CONFIG_BOARD_EMULATION_QEMU_RISCV_RV32)	:= 0x80000000
+
 ifneq ($(QEMU-y),)
 
 QEMU_ARGS ?= -serial stdio
@@ -52,6 +68,15 @@ QEMU_CFG_ARGS ?= \
 qemu: $(obj)/coreboot.rom
 	$(QEMU-y) $(QEMU_CFG_ARGS) $(QEMU_ARGS) -bios $<
 
-.PHONY: qemu
+QEMU_BOOT_TIME_BASELINE ?= util/qemu/boot-time/$(subst /,_,$(MAINBOARDDIR)).json
+QEMU_BOOT_TIME_ARGS ?=
+
+qemu-boot-time: $(obj)/coreboot.rom
+	mkdir -p $(dir $(QEMU_BOOT_TIME_BASELINE))
+	util/qemu/boot-time.py --baseline $(QEMU_BOOT_TIME_BASELINE) \
+		--ram-base $(or $(QEMU_RAM_BASE-y),0) --output $(obj)/boot-time.json \
+		$(QEMU_BOOT_TIME_ARGS) -- $(QEMU-y) $(QEMU_CFG_ARGS) -bios $<
+
+.PHONY: qemu qemu-boot-time
 
 endif
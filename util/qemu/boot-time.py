@@ -0,0 +1,320 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+# Boot a coreboot image in QEMU without a display, read the CBMEM timestamp
+# table out of guest memory once coreboot is done, and compare the time spent
+# in each stage against a baseline.
+#
+# QEMU runs with -icount, so guest time follows the number of executed
+# instructions instead of the speed of the host. That makes the timestamps of
+# two runs of the same image nearly identical, and changes in them mean that
+# coreboot does more or less work.
+
+import argparse
+import json
+import os
+import re
+import select
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+LB_TAG_FORWARD = 0x11
+LB_TAG_TIMESTAMPS = 0x16
+TIMESTAMP_TABLE_CONTINUED = 0xffffffff
+MAX_TIMESTAMP_TABLES = 256
+# Timestamps recorded per CPU have the CPU index plus one in the upper half of the ID.
+TIMESTAMP_CPU_SHIFT = 16
+
+# Console messages after which coreboot adds no more timestamps.
+END_MARKERS = [
+    b'Jumping to boot code',
+    b'Payload not loaded',
+    b'Booting payload',
+]
+
+# Stages and payload loading, each reaching to the next one that was recorded.
+STAGES = [
+    ('bootblock', 'TS_BOOTBLOCK_START'),
+    ('verstage', 'TS_VBOOT_START'),
+    ('romstage', 'TS_ROMSTAGE_START'),
+    ('postcar', 'TS_POSTCAR_START'),
+    ('ramstage', 'TS_RAMSTAGE_START'),
+    ('payload load', 'TS_LOAD_PAYLOAD'),
+]
+STAGES_END = 'TS_SELFBOOT_JUMP'
+
+
+def parseargs():
+    parser = argparse.ArgumentParser(
+        description='Measure coreboot boot time in QEMU and compare it '
+                    'against a baseline',
+        epilog='Everything after "--" is the QEMU command line, including '
+               'the coreboot image.')
+    parser.add_argument('--baseline', help='baseline JSON file')
+    parser.add_argument('--update', action='store_true',
+                        help='write the results to the baseline file')
+    parser.add_argument('--output', help='write the results to this JSON file')
+    parser.add_argument('--ram-base', default='0', type=lambda x: int(x, 0),
+                        help='guest physical address of RAM (default: 0)')
+    parser.add_argument('--tolerance', default=5.0, type=float,
+                        help='allowed slowdown per stage in percent (default: 5)')
+    parser.add_argument('--min-delta', default=100, type=int,
+                        help='ignore slowdowns of less than this many '
+                             'microseconds (default: 100)')
+    parser.add_argument('--timeout', default=300, type=int,
+                        help='seconds to wait for coreboot to finish '
+                             '(default: 300)')
+    parser.add_argument('--header', default=os.path.join(
+                        os.path.dirname(os.path.abspath(__file__)), '..', '..', 'src',
+                        'commonlib', 'include', 'commonlib', 'timestamp_serialized.h'),
+                        help='timestamp_serialized.h for timestamp names')
+    parser.add_argument('qemu', nargs=argparse.REMAINDER,
+                        help='QEMU command line')
+    args = parser.parse_args()
+
+    if args.qemu and args.qemu[0] == '--':
+        args.qemu = args.qemu[1:]
+    if not args.qemu:
+        parser.error('no QEMU command line given')
+    if args.update and not args.baseline:
+        parser.error('--update needs --baseline')
+    return args
+
+
+def read_timestamp_ids(header):
+    """Returns maps of the timestamp enum names to IDs and of IDs to descriptions."""
+    with open(header) as f:
+        text = f.read()
+    ids = {name: int(value) for name, value in
+           re.findall(r'^\s*(TS_\w+)\s*=\s*(\d+),', text, re.MULTILINE)}
+    names = {ids[name]: desc for name, desc in
+             re.findall(r'TS_NAME_DEF\((TS_\w+),\s*\w+,\s*"([^"]*)"\)', text)
+             if name in ids}
+    return ids, names
+
+
+def ram_size(qemu):
+    """Returns the guest RAM size in bytes from the -m argument, QEMU's default is 128M."""
+    size = '128M'
+    for i, arg in enumerate(qemu[:-1]):
+        if arg == '-m':
+            size = qemu[i + 1].split(',')[0]
+            size = size[5:] if size.startswith('size=') else size
+    units = {'K': 1 << 10, 'M': 1 << 20, 'G': 1 << 30, 'T': 1 << 40}
+    if size[-1].upper() in units:
+        return int(size[:-1]) * units[size[-1].upper()]
+    # A plain number is in MiB.
+    return int(size) << 20
+
+
+class Monitor:
+    """Minimal client for the QEMU human monitor on a UNIX socket."""
+
+    def __init__(self, path, timeout):
+        deadline = time.monotonic() + timeout
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        while True:
+            try:
+                self.sock.connect(path)
+                break
+            except (FileNotFoundError, ConnectionRefusedError):
+                if time.monotonic() > deadline:
+                    raise
+                time.sleep(0.1)
+        self.read_prompt()
+
+    def read_prompt(self):
+        data = b''
+        while not data.endswith(b'(qemu) '):
+            ready, _, _ = select.select([self.sock], [], [], 60)
+            if not ready:
+                raise TimeoutError('QEMU monitor does not respond')
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise ConnectionError('QEMU monitor closed')
+            data += chunk
+        return data
+
+    def command(self, cmd):
+        self.sock.sendall(cmd.encode() + b'\n')
+        return self.read_prompt()
+
+    def quit(self):
+        self.sock.sendall(b'quit\n')
+        self.sock.close()
+
+
+def wait_for_end(log, qemu_proc, timeout):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        if qemu_proc.poll() is not None:
+            raise RuntimeError('QEMU exited before coreboot was done')
+        try:
+            with open(log, 'rb') as f:
+                console = f.read()
+        except FileNotFoundError:
+            console = b''
+        if any(marker in console for marker in END_MARKERS):
+            return
+        time.sleep(0.2)
+    raise TimeoutError('coreboot did not finish within %d seconds' % timeout)
+
+
+def find_lb_table(mem, ram_base):
+    """Returns the address of the timestamp table the coreboot table refers to."""
+    pos = mem.find(b'LBIO')
+    while pos >= 0:
+        if pos % 16 == 0 and pos + 24 <= len(mem):
+            header_bytes, _, table_bytes, _, entries = struct.unpack_from('<5I', mem, pos + 4)
+            if header_bytes == 24 and pos + 24 + table_bytes <= len(mem):
+                rec = pos + 24
+                for _ in range(entries):
+                    tag, size = struct.unpack_from('<2I', mem, rec)
+                    if size < 8 or rec + size > pos + 24 + table_bytes:
+                        break
+                    if tag == LB_TAG_TIMESTAMPS:
+                        return struct.unpack_from('<Q', mem, rec + 8)[0]
+                    if tag == LB_TAG_FORWARD:
+                        forward = struct.unpack_from('<Q', mem, rec + 8)[0] - ram_base
+                        if 0 <= forward < len(mem) and mem[forward:forward + 4] == b'LBIO':
+                            table = find_lb_table(mem[forward:], 0)
+                            if table is not None:
+                                return table
+                    rec += size
+        pos = mem.find(b'LBIO', pos + 1)
+    return None
+
+
+def read_timestamps(mem, offset, ram_base):
+    _, _, tick_freq_mhz, _ = struct.unpack_from('<QHHI', mem, offset)
+    entries = []
+    # A full table may continue in another one, whose address is in its last entry.
+    for _ in range(MAX_TIMESTAMP_TABLES + 1):
+        _, max_entries, _, num_entries = struct.unpack_from('<QHHI', mem, offset)
+        if num_entries > max_entries:
+            raise ValueError('broken timestamp table')
+        table = [struct.unpack_from('<Iq', mem, offset + 16 + 12 * i) for i in range(num_entries)]
+        if not (table and num_entries == max_entries and table[-1][0] == TIMESTAMP_TABLE_CONTINUED):
+            entries += table
+            break
+        entries += table[:-1]
+        offset = table[-1][1] - ram_base
+        if not 0 <= offset < len(mem) - 16:
+            raise ValueError('broken timestamp table chain')
+    # Stamps are relative to base_time, convert them to microseconds.
+    div = tick_freq_mhz if tick_freq_mhz else 1
+    return tick_freq_mhz, sorted(((ts_id, stamp / div) for ts_id, stamp in entries),
+                                 key=lambda e: e[1])
+
+
+def timestamp_name(names, ts_id):
+    name = names.get(ts_id & ((1 << TIMESTAMP_CPU_SHIFT) - 1), 'unknown')
+    cpu = ts_id >> TIMESTAMP_CPU_SHIFT
+    return '%s (CPU %d)' % (name, cpu - 1) if cpu else name
+
+
+def stage_times(timestamps, ids):
+    first = {}
+    for ts_id, us in timestamps:
+        first.setdefault(ts_id, us)
+
+    starts = [(stage, first[ids[name]]) for stage, name in STAGES
+              if name in ids and ids[name] in first]
+    end = first.get(ids.get(STAGES_END), timestamps[-1][1] if timestamps else 0)
+    stages = {}
+    for i, (stage, start) in enumerate(starts):
+        stop = starts[i + 1][1] if i + 1 < len(starts) else end
+        stages[stage] = round(stop - start, 1)
+    stages['total'] = round(end, 1)
+    return stages
+
+
+def boot(qemu, ram_base, timeout):
+    with tempfile.TemporaryDirectory(prefix='coreboot-boot-time-') as tmp:
+        log = os.path.join(tmp, 'console.log')
+        sock = os.path.join(tmp, 'monitor.sock')
+        dump = os.path.join(tmp, 'memory.bin')
+        cmd = qemu + ['-display', 'none', '-serial', 'file:' + log,
+                      '-monitor', 'unix:%s,server=on,wait=off' % sock,
+                      '-icount', 'shift=0,sleep=off']
+        proc = subprocess.Popen(cmd, stdin=subprocess.DEVNULL)
+        try:
+            monitor = Monitor(sock, 30)
+            wait_for_end(log, proc, timeout)
+            monitor.command('stop')
+            monitor.command('pmemsave %#x %#x "%s"' % (ram_base, ram_size(qemu), dump))
+            monitor.quit()
+            proc.wait(30)
+            with open(dump, 'rb') as f:
+                return f.read()
+        finally:
+            if proc.poll() is None:
+                proc.kill()
+
+
+def compare(results, baseline, tolerance, min_delta):
+    """Prints the stages with their baseline times and returns the regressed ones."""
+    regressions = []
+    print('%-14s %12s %12s %8s' % ('stage', 'baseline us', 'current us', 'change'))
+    for stage, us in results['stages'].items():
+        base = baseline.get('stages', {}).get(stage)
+        if base is None:
+            print('%-14s %12s %12.1f %8s' % (stage, '-', us, 'new'))
+            continue
+        change = (us - base) * 100 / base if base else 0
+        regressed = us - base > min_delta and change > tolerance
+        print('%-14s %12.1f %12.1f %+7.1f%%%s' % (stage, base, us, change,
+                                                  '  REGRESSION' if regressed else ''))
+        if regressed:
+            regressions.append(stage)
+    return regressions
+
+
+def main():
+    args = parseargs()
+    ids, names = read_timestamp_ids(args.header)
+
+    mem = boot(args.qemu, args.ram_base, args.timeout)
+    table = find_lb_table(mem, args.ram_base)
+    if table is not None:
+        table -= args.ram_base
+    if table is None or not 0 <= table < len(mem) - 16:
+        sys.exit('No timestamp table found in guest memory')
+    tick_freq_mhz, timestamps = read_timestamps(mem, table, args.ram_base)
+
+    results = {
+        'tick_freq_mhz': tick_freq_mhz,
+        'stages': stage_times(timestamps, ids),
+        'timestamps': [{'id': ts_id, 'name': timestamp_name(names, ts_id), 'us': round(us, 1)}
+                       for ts_id, us in timestamps],
+    }
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(results, f, indent=2)
+            f.write('\n')
+
+    if args.update:
+        with open(args.baseline, 'w') as f:
+            json.dump(results, f, indent=2)
+            f.write('\n')
+        print('Baseline %s updated' % args.baseline)
+
+    baseline = {}
+    if args.baseline and os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    elif args.baseline:
+        print('No baseline %s, use --update to create it' % args.baseline)
+
+    regressions = compare(results, baseline, args.tolerance, args.min_delta)
+    if regressions:
+        sys.exit('Boot time regressed in: ' + ', '.join(regressions))
+
+
+if __name__ == '__main__':
+    main()
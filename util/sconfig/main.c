@@ -1348,6 +1348,55 @@ static void walk_device_tree(FILE *fil, FILE *head, struct device *ptr,
 	}
 }
 
+/*
+ * PCI devices on the bus of the first domain in the device list, which is what
+ * pci_root_bus() returns at runtime, indexed by devfn.
+ */
+static struct device *pci_root_domain;
+static struct device *pci_root_devices[256];
+
+static void collect_pci_root_devices(FILE *fil, FILE *head, struct device *ptr,
+				     struct device *next)
+{
+	unsigned int devfn;
+
+	if (!pci_root_domain && ptr->bustype == DOMAIN)
+		pci_root_domain = ptr;
+
+	if (!pci_root_domain || ptr->bustype != PCI || ptr->parent->dev != pci_root_domain)
+		return;
+
+	devfn = ((ptr->path_a & 0x1f) << 3) | (ptr->path_b & 0x7);
+	/* Lookups return the first match in the sibling list. */
+	if (!pci_root_devices[devfn])
+		pci_root_devices[devfn] = ptr;
+}
+
+static void emit_pci_root_devfn_table(FILE *fil)
+{
+	unsigned int devfn, max_devfn = 0;
+
+	walk_device_tree(NULL, NULL, &base_root_dev, collect_pci_root_devices);
+
+	for (devfn = 0; devfn < ARRAY_SIZE(pci_root_devices); devfn++) {
+		if (pci_root_devices[devfn])
+			max_devfn = devfn;
+	}
+
+	fprintf(fil, "#if !DEVTREE_EARLY\n");
+	fprintf(fil, "DEVTREE_CONST struct device *const pci_root_devfn_table[] = {\n");
+	for (devfn = 0; devfn <= max_devfn; devfn++) {
+		if (pci_root_devices[devfn])
+			fprintf(fil, "\t[0x%02x] = &%s,\n", devfn, pci_root_devices[devfn]->name);
+	}
+	if (!pci_root_devices[0] && max_devfn == 0)
+		fprintf(fil, "\t[0x00] = NULL,\n");
+	fprintf(fil, "};\n");
+	fprintf(fil, "const size_t pci_root_devfn_table_size =\n");
+	fprintf(fil, "\tsizeof(pci_root_devfn_table) / sizeof(pci_root_devfn_table[0]);\n");
+	fprintf(fil, "#endif\n");
+}
+
 static void emit_chip_headers(FILE *fil, struct chip *chip)
 {
 	struct chip *tmp = chip;
@@ -1911,6 +1960,8 @@ static void generate_outputc(FILE *f, const char *static_header)
 	emit_chip_configs(f);
 	fprintf(f, "\n/* pass 1 */\n");
 	walk_device_tree(f, NULL, &base_root_dev, pass1);
+	fprintf(f, "\n/* PCI root bus devices by devfn */\n");
+	emit_pci_root_devfn_table(f);
 }
 
 static void generate_outputd(FILE *gen, FILE *dev)
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-only
+
+# Encode the ACPI objects for a WiFi SAR file in the "$SAR" format at build
+# time, so ramstage only has to copy them into the SSDT. The output matches
+# what src/drivers/wifi/generic/acpi.c generates from the same file: the WRDS,
+# EWRD, WGDS, PPAG, WTAS and WBEM names, prefixed with struct sar_aml_header
+# from src/include/sar.h. That header also carries the DSM and BSAR profiles,
+# which ramstage still turns into _DSM and BRDS itself.
+
+import argparse
+import struct
+import sys
+
+SAR_STR_PREFIX = b'$SAR'
+SAR_FILE_REVISION = 1
+SAR_AML_MARKER = b'$SAA'
+SAR_AML_VERSION = 1
+SAR_AML_HAS_DSM = 1 << 0
+SAR_AML_HAS_BSAR = 1 << 1
+
+MAX_PROFILE_COUNT = 7
+MAX_SAR_REVISION = 2
+MAX_DSAR_SET_COUNT = 3
+MAX_GEO_OFFSET_REVISION = 3
+MAX_ANT_GAINS_REVISION = 2
+MAX_DENYLIST_ENTRY = 16
+WBEM_REVISION = 0
+
+DOMAIN_TYPE_WIFI = 0x7
+
+NAME_OP = 0x08
+BYTE_PREFIX = 0x0a
+WORD_PREFIX = 0x0b
+DWORD_PREFIX = 0x0c
+PACKAGE_OP = 0x12
+
+# Sizes of the fixed parts of the profiles in the SAR file
+SAR_PROFILE_SIZE = 4
+GEO_PROFILE_SIZE = 3
+GAIN_PROFILE_SIZE = 4
+AVG_PROFILE_SIZE = 3 + 2 * MAX_DENYLIST_ENTRY
+DSM_PROFILE_SIZE = 9 * 4
+BSAR_PROFILE_SIZE = 9
+WBEM_PROFILE_SIZE = 5
+
+
+def warn(msg):
+    print('sar-aml: ' + msg, file=sys.stderr)
+
+
+def pkglength(length):
+    """PkgLength for |length| bytes that follow it, as acpigen_write_len() encodes it."""
+    if length + 1 <= 0x3f:
+        return bytes([length + 1])
+    if length + 2 <= 0xfff:
+        length += 2
+        return bytes([0x40 | (length & 0xf), length >> 4 & 0xff])
+    if length + 3 <= 0xfffff:
+        length += 3
+        return bytes([0x80 | (length & 0xf), length >> 4 & 0xff, length >> 12 & 0xff])
+    raise ValueError('package too large')
+
+
+def byte(value):
+    return bytes([BYTE_PREFIX, value & 0xff])
+
+
+def word(value):
+    return bytes([WORD_PREFIX]) + struct.pack('<H', value & 0xffff)
+
+
+def dword(value):
+    return bytes([DWORD_PREFIX]) + struct.pack('<I', value & 0xffffffff)
+
+
+def package(elements):
+    body = bytes([len(elements)]) + b''.join(elements)
+    return bytes([PACKAGE_OP]) + pkglength(len(body)) + body
+
+
+def name(name_str, revision, elements):
+    """Name (NAME, Package () { Revision, Package () { elements } })"""
+    return (bytes([NAME_OP]) + name_str.encode() +
+            package([dword(revision), package(elements)]))
+
+
+def emit_wrds(sar):
+    revision, _, chains, subbands = sar[:SAR_PROFILE_SIZE]
+    if revision > MAX_SAR_REVISION:
+        warn('Invalid SAR table revision: %d' % revision)
+        return b''
+    table = sar[SAR_PROFILE_SIZE:SAR_PROFILE_SIZE + chains * subbands]
+    return name('WRDS', revision, [dword(DOMAIN_TYPE_WIFI), dword(1)] +
+                [byte(b) for b in table])
+
+
+def emit_ewrd(sar):
+    revision, dsar_set_count, chains, subbands = sar[:SAR_PROFILE_SIZE]
+    if revision > MAX_SAR_REVISION:
+        warn('Invalid SAR table revision: %d' % revision)
+        return b''
+    if dsar_set_count == 0:
+        warn('DSAR set count is 0')
+        return b''
+    if dsar_set_count > MAX_DSAR_SET_COUNT:
+        raise ValueError('DSAR set count %d is too large' % dsar_set_count)
+    table_size = chains * subbands
+    sets = sar[SAR_PROFILE_SIZE + table_size:
+               SAR_PROFILE_SIZE + table_size * (1 + dsar_set_count)]
+    # The WiFi driver always expects 3 DSAR sets.
+    sets += bytes(table_size * (MAX_DSAR_SET_COUNT - dsar_set_count))
+    return name('EWRD', revision, [dword(DOMAIN_TYPE_WIFI), dword(1),
+                                   dword(dsar_set_count)] + [byte(b) for b in sets])
+
+
+def emit_wgds(wgds):
+    revision, chains, bands = wgds[:GEO_PROFILE_SIZE]
+    if revision > MAX_GEO_OFFSET_REVISION:
+        warn('Invalid WGDS revision: %d' % revision)
+        return b''
+    table = wgds[GEO_PROFILE_SIZE:GEO_PROFILE_SIZE + chains * bands]
+    return name('WGDS', revision, [dword(DOMAIN_TYPE_WIFI)] + [byte(b) for b in table])
+
+
+def emit_ppag(ppag):
+    revision, mode, chains, bands = ppag[:GAIN_PROFILE_SIZE]
+    if revision > MAX_ANT_GAINS_REVISION:
+        warn('Invalid PPAG revision: %d' % revision)
+        return b''
+    table = ppag[GAIN_PROFILE_SIZE:GAIN_PROFILE_SIZE + chains * bands]
+    return name('PPAG', revision, [dword(DOMAIN_TYPE_WIFI), dword(mode)] +
+                [byte(b) for b in table])
+
+
+def emit_wtas(wtas):
+    revision, selection, list_size = wtas[:3]
+    deny_list = struct.unpack_from('<%dH' % MAX_DENYLIST_ENTRY, wtas, 3)
+    return name('WTAS', revision, [dword(DOMAIN_TYPE_WIFI), byte(selection), byte(list_size)] +
+                [word(entry) for entry in deny_list])
+
+
+def emit_wbem(wbem):
+    revision, enablement = struct.unpack_from('<BI', wbem)
+    if revision != WBEM_REVISION:
+        warn('Unsupported WBEM table revision: %d' % revision)
+        return b''
+    return name('WBEM', revision, [dword(DOMAIN_TYPE_WIFI), dword(enablement)])
+
+
+def profile_size(index, profile):
+    """Size of a profile in the SAR file, like the *_table_size() functions of sar.c."""
+    if index == 0:
+        _, dsar_set_count, chains, subbands = profile[:SAR_PROFILE_SIZE]
+        return SAR_PROFILE_SIZE + (1 + dsar_set_count) * chains * subbands
+    if index == 1:
+        _, chains, bands = profile[:GEO_PROFILE_SIZE]
+        return GEO_PROFILE_SIZE + chains * bands
+    if index == 2:
+        _, _, chains, bands = profile[:GAIN_PROFILE_SIZE]
+        return GAIN_PROFILE_SIZE + chains * bands
+    return [AVG_PROFILE_SIZE, DSM_PROFILE_SIZE, BSAR_PROFILE_SIZE, WBEM_PROFILE_SIZE][index - 3]
+
+
+def parse(data):
+    """Returns the profiles of a SAR file, None for the ones it does not have."""
+    if not data.startswith(SAR_STR_PREFIX):
+        raise ValueError('not in the "$SAR" format, legacy SAR files are not supported')
+    header_size = len(SAR_STR_PREFIX) + 1 + 2 * MAX_PROFILE_COUNT
+    if len(data) < header_size:
+        raise ValueError('invalid SAR format')
+    if data[len(SAR_STR_PREFIX)] != SAR_FILE_REVISION:
+        raise ValueError('invalid SAR file version: %d' % data[len(SAR_STR_PREFIX)])
+
+    offsets = struct.unpack_from('<%dH' % MAX_PROFILE_COUNT, data, len(SAR_STR_PREFIX) + 1)
+    profiles = []
+    expected_size = header_size
+    for i, offset in enumerate(offsets):
+        if offset > len(data):
+            raise ValueError('offset is outside the file size')
+        if not offset:
+            profiles.append(None)
+            continue
+        profile = data[offset:]
+        size = profile_size(i, profile)
+        profiles.append(profile[:size])
+        expected_size += size
+
+    if len(data) != expected_size:
+        raise ValueError('invalid SAR size, expected: %d, obtained: %d' %
+                         (expected_size, len(data)))
+    return profiles
+
+
+def encode(profiles):
+    sar, wgds, ppag, wtas, dsm, bsar, wbem = profiles
+    aml = b''
+    if sar:
+        aml += emit_wrds(sar) + emit_ewrd(sar)
+    if wgds:
+        aml += emit_wgds(wgds)
+    if ppag:
+        aml += emit_ppag(ppag)
+    if wtas:
+        aml += emit_wtas(wtas)
+    if wbem:
+        aml += emit_wbem(wbem)
+
+    if len(aml) > 0xffff:
+        raise ValueError('encoded SAR tables are too large')
+
+    flags = (SAR_AML_HAS_DSM if dsm else 0) | (SAR_AML_HAS_BSAR if bsar else 0)
+    header = (SAR_AML_MARKER + struct.pack('<BBH', SAR_AML_VERSION, flags, len(aml)) +
+              (dsm or bytes(DSM_PROFILE_SIZE)) + (bsar or bytes(BSAR_PROFILE_SIZE)))
+    return header + aml
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Pre-encode the ACPI objects of a WiFi SAR file')
+    parser.add_argument('input', help='SAR file in the "$SAR" format')
+    parser.add_argument('output', help='pre-encoded file for CBFS')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        data = f.read()
+    try:
+        out = encode(parse(data))
+    except (ValueError, struct.error) as e:
+        sys.exit('sar-aml: %s: %s' % (args.input, e))
+
+    with open(args.output, 'wb') as f:
+        f.write(out)
+
+
+if __name__ == '__main__':
+    main()